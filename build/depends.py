@@ -705,6 +705,20 @@ class FpClassify(Dependence):
                 env['CCFLAGS'].remove('-ffast-math')
         return env.Object('src/util/fpclassify.cpp')
 
+class SampleUtilKernels(Dependence):
+
+    # The SampleUtil kernels for instruction sets beyond the baseline of
+    # the build. They are selected at runtime depending on the CPU.
+    def sources(self, build):
+        objects = []
+        for source, flag in [('src/util/sample_avx2.cpp', '-mavx2'),
+                             ('src/util/sample_avx512.cpp', '-mavx512f')]:
+            env = build.env.Clone()
+            if build.toolchain_is_gnu and build.architecture_is_x86:
+                env.Append(CCFLAGS=flag)
+            objects.append(env.Object(source))
+        return objects
+
 class PortAudioRingBuffer(Dependence):
     def configure(self, build, conf):
         build.env.Append(CPPPATH='#lib/portaudio')
@@ -752,6 +766,8 @@ class MixxxCore(Feature):
                    "src/control/controlpotmeter.cpp",
                    "src/control/controlproxy.cpp",
                    "src/control/controlpushbutton.cpp",
+                   "src/control/controlregistry.cpp",
+                   "src/control/controlsnapshot.cpp",
                    "src/control/controlttrotary.cpp",
                    "src/control/controlencoder.cpp",
 
@@ -844,6 +860,7 @@ class MixxxCore(Feature):
 
                    "src/engine/engineworker.cpp",
                    "src/engine/engineworkerscheduler.cpp",
+                   "src/engine/engineparallelexecutor.cpp",
                    "src/engine/enginebuffer.cpp",
                    "src/engine/bufferscalers/enginebufferscale.cpp",
                    "src/engine/bufferscalers/enginebufferscalelinear.cpp",
@@ -870,8 +887,9 @@ class MixxxCore(Feature):
                    "src/engine/sidechain/enginesidechain.cpp",
                    "src/engine/sidechain/networkoutputstreamworker.cpp",
                    "src/engine/sidechain/networkinputstreamworker.cpp",
+                   "src/engine/sidechain/sidechainringbuffer.cpp",
                    "src/engine/enginexfader.cpp",
-                   "src/engine/channelmixer_autogen.cpp",
+                   "src/engine/channelmixer.cpp",
                    "src/engine/positionscratchcontroller.cpp",
                    "src/engine/controls/bpmcontrol.cpp",
                    "src/engine/controls/clockcontrol.cpp",
@@ -885,10 +903,13 @@ class MixxxCore(Feature):
                    "src/engine/enginetalkoverducking.cpp",
                    "src/engine/cachingreader/cachingreader.cpp",
                    "src/engine/cachingreader/cachingreaderchunk.cpp",
+                   "src/engine/cachingreader/cachingreaderchunkpool.cpp",
+                   "src/engine/cachingreader/cachingreaderdecodedtrack.cpp",
                    "src/engine/cachingreader/cachingreaderworker.cpp",
 
                    "src/analyzer/trackanalysisscheduler.cpp",
                    "src/analyzer/analyzerthread.cpp",
+                   "src/analyzer/analyzerpipeline.cpp",
                    "src/analyzer/analyzerwaveform.cpp",
                    "src/analyzer/analyzergain.cpp",
                    "src/analyzer/analyzerbeats.cpp",
@@ -944,6 +965,7 @@ class MixxxCore(Feature):
                    "src/errordialoghandler.cpp",
 
                    "src/sources/audiosource.cpp",
+                   "src/sources/audiosourcepcmcache.cpp",
                    "src/sources/audiosourcestereoproxy.cpp",
                    "src/sources/metadatasourcetaglib.cpp",
                    "src/sources/soundsource.cpp",
@@ -1035,10 +1057,12 @@ class MixxxCore(Feature):
                    "src/library/basesqltablemodel.cpp",
                    "src/library/basetrackcache.cpp",
                    "src/library/basetracktablemodel.cpp",
+                   "src/library/columnartrackindex.cpp",
                    "src/library/columncache.cpp",
                    "src/library/librarytablemodel.cpp",
                    "src/library/searchquery.cpp",
                    "src/library/searchqueryparser.cpp",
+                   "src/library/selectqueryexecutor.cpp",
                    "src/library/analysislibrarytablemodel.cpp",
                    "src/library/missingtablemodel.cpp",
                    "src/library/hiddentablemodel.cpp",
@@ -1112,6 +1136,7 @@ class MixxxCore(Feature):
                    "src/library/sidebarmodel.cpp",
                    "src/library/library.cpp",
 
+                   "src/library/scanner/directorywatcher.cpp",
                    "src/library/scanner/libraryscanner.cpp",
                    "src/library/scanner/libraryscannerdlg.cpp",
                    "src/library/scanner/scannertask.cpp",
@@ -1122,6 +1147,7 @@ class MixxxCore(Feature):
                    "src/library/dao/trackdao.cpp",
                    "src/library/dao/playlistdao.cpp",
                    "src/library/dao/libraryhashdao.cpp",
+                   "src/library/dao/searchindexdao.cpp",
                    "src/library/dao/settingsdao.cpp",
                    "src/library/dao/analysisdao.cpp",
                    "src/library/dao/autodjcratesdao.cpp",
@@ -1279,6 +1305,7 @@ class MixxxCore(Feature):
                    "src/encoder/encoderflacsettings.cpp",
                    "src/encoder/encodermp3.cpp",
                    "src/encoder/encodermp3settings.cpp",
+                   "src/encoder/encodershared.cpp",
                    "src/encoder/encodersndfileflac.cpp",
                    "src/encoder/encodervorbis.cpp",
                    "src/encoder/encodervorbissettings.cpp",
@@ -1322,6 +1349,7 @@ class MixxxCore(Feature):
                    "src/util/db/fwdsqlquery.cpp",
                    "src/util/db/fwdsqlqueryselectresult.cpp",
                    "src/util/db/sqllikewildcardescaper.cpp",
+                   "src/util/db/sqlquerycache.cpp",
                    "src/util/db/sqlqueryfinisher.cpp",
                    "src/util/db/sqlstringformatter.cpp",
                    "src/util/db/sqltransaction.cpp",
@@ -1329,6 +1357,7 @@ class MixxxCore(Feature):
                    "src/util/sample.cpp",
                    "src/util/samplebuffer.cpp",
                    "src/util/readaheadsamplebuffer.cpp",
+                   "src/util/realtimecheck.cpp",
                    "src/util/rotary.cpp",
                    "src/util/logger.cpp",
                    "src/util/logging.cpp",
@@ -1632,7 +1661,7 @@ class MixxxCore(Feature):
         return [SoundTouch, ReplayGain, Ebur128Mit, PortAudio, PortMIDI, Qt, TestHeaders,
                 FidLib, SndFile, FLAC, OggVorbis, OpenGL, TagLib, ProtoBuf,
                 Chromaprint, RubberBand, SecurityFramework, CoreServices, IOKit,
-                Reverb, FpClassify, PortAudioRingBuffer, LAME,
+                Reverb, FpClassify, SampleUtilKernels, PortAudioRingBuffer, LAME,
                 QueenMaryDsp, Kaitai, MP3GuessEnc, RigtorpSPSCQueue]
 
     def post_dependency_check_configure(self, build, conf):
@@ -474,6 +474,8 @@ class MixxxBuild(object):
         vars.Add('sysroot', 'Specify a custom sysroot', '')
         vars.Add('debug_assertions_fatal',
                  'Whether debug assertions are fatal.', False)
+        vars.Add('rt_audit',
+                 'Report operations within the audio callback that are not real-time safe at shutdown (Linux only).', False)
 
         for feature_class in self.available_features:
             # Instantiate the feature
@@ -0,0 +1,144 @@
+#include "analyzer/analyzerpipeline.h"
+
+#include <algorithm>
+
+#include "util/assert.h"
+
+AnalyzerPipeline::AnalyzerPipeline(
+        SINT samplesPerChunk,
+        int chunkCount)
+        : m_chunkSlices(chunkCount),
+          m_publishedChunks(0),
+          m_busyWorkers(0),
+          m_aborted(false),
+          m_stopping(false) {
+    DEBUG_ASSERT(chunkCount > 0);
+    m_chunks.reserve(chunkCount);
+    for (int i = 0; i < chunkCount; ++i) {
+        m_chunks.emplace_back(samplesPerChunk);
+    }
+}
+
+AnalyzerPipeline::~AnalyzerPipeline() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_aborted = true;
+        m_stopping = true;
+    }
+    m_chunkPublished.notify_all();
+    for (auto&& worker : m_workers) {
+        worker.join();
+    }
+}
+
+int AnalyzerPipeline::start(std::vector<AnalyzerWithState>* pAnalyzers) {
+    DEBUG_ASSERT(pAnalyzers);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // The previous track must have been drained or aborted
+    DEBUG_ASSERT(m_busyWorkers == 0);
+    DEBUG_ASSERT(m_aborted ||
+            std::all_of(m_processedChunks.begin(),
+                    m_processedChunks.end(),
+                    [this](quint64 processedChunks) {
+                        return processedChunks == m_publishedChunks;
+                    }));
+    m_analyzers.clear();
+    for (auto&& analyzer : *pAnalyzers) {
+        // Inactive analyzers would not process any samples anyway
+        if (analyzer.isActive()) {
+            m_analyzers.push_back(&analyzer);
+        }
+    }
+    m_publishedChunks = 0;
+    m_processedChunks.assign(m_analyzers.size(), 0);
+    m_aborted = false;
+    // Additional workers block on the mutex until the lock is released
+    while (m_workers.size() < m_analyzers.size()) {
+        m_workers.emplace_back(
+                &AnalyzerPipeline::processChunks,
+                this,
+                static_cast<int>(m_workers.size()));
+    }
+    return static_cast<int>(m_analyzers.size());
+}
+
+mixxx::SampleBuffer& AnalyzerPipeline::acquireChunk() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    const quint64 chunkCount = m_chunks.size();
+    m_chunkProcessed.wait(lock, [this, chunkCount] {
+        // The slowest worker determines which chunks are still in use
+        const quint64 minProcessedChunks = m_processedChunks.empty() ?
+                m_publishedChunks :
+                *std::min_element(m_processedChunks.begin(), m_processedChunks.end());
+        return m_aborted || (m_publishedChunks - minProcessedChunks < chunkCount);
+    });
+    return m_chunks[m_publishedChunks % chunkCount];
+}
+
+void AnalyzerPipeline::publishChunk(
+        mixxx::SampleBuffer::ReadableSlice readableSlice) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const auto chunkIndex = m_publishedChunks % m_chunks.size();
+        // The decoded data must reside in the acquired chunk buffer
+        DEBUG_ASSERT(readableSlice.empty() ||
+                (readableSlice.data() >= m_chunks[chunkIndex].data() &&
+                        readableSlice.data(readableSlice.length()) <=
+                                m_chunks[chunkIndex].data(m_chunks[chunkIndex].size())));
+        m_chunkSlices[chunkIndex] = readableSlice;
+        ++m_publishedChunks;
+    }
+    m_chunkPublished.notify_all();
+}
+
+void AnalyzerPipeline::drain() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_chunkProcessed.wait(lock, [this] {
+        if (m_aborted) {
+            return m_busyWorkers == 0;
+        }
+        return std::all_of(m_processedChunks.begin(),
+                m_processedChunks.end(),
+                [this](quint64 processedChunks) {
+                    return processedChunks == m_publishedChunks;
+                });
+    });
+}
+
+void AnalyzerPipeline::abort() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    // Idle workers keep waiting, busy workers finish their current
+    // chunk and don't pick up another one
+    m_aborted = true;
+    m_chunkProcessed.wait(lock, [this] {
+        return m_busyWorkers == 0;
+    });
+}
+
+void AnalyzerPipeline::processChunks(int workerIndex) {
+    const quint64 chunkCount = m_chunks.size();
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_chunkPublished.wait(lock, [this, workerIndex] {
+            return m_stopping || hasPendingChunk(workerIndex);
+        });
+        if (m_stopping) {
+            return;
+        }
+        AnalyzerWithState* pAnalyzer = m_analyzers[workerIndex];
+        const auto chunkSlice =
+                m_chunkSlices[m_processedChunks[workerIndex] % chunkCount];
+        ++m_busyWorkers;
+        lock.unlock();
+        // Neither the analyzer nor the chunk are modified by the decoding
+        // thread until the chunk has been processed by all analyzers
+        if (!chunkSlice.empty()) {
+            pAnalyzer->processSamples(chunkSlice.data(), chunkSlice.length());
+        }
+        lock.lock();
+        --m_busyWorkers;
+        ++m_processedChunks[workerIndex];
+        // Only the decoding thread waits for processed chunks
+        m_chunkProcessed.notify_one();
+    }
+}
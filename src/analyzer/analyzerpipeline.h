@@ -0,0 +1,95 @@
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "analyzer/analyzer.h"
+#include "util/samplebuffer.h"
+
+/// Processes chunks of decoded audio data concurrently by multiple
+/// analyzers, each running on its own worker thread.
+///
+/// The decoding thread writes into a bounded ring of chunk buffers that
+/// are shared read-only by all analyzers. Each analyzer consumes the
+/// chunks in order with its own read cursor. A chunk buffer is reused
+/// only after all analyzers have processed it, i.e. the decoding thread
+/// blocks if the slowest analyzer falls behind by more than the capacity
+/// of the ring (backpressure).
+///
+/// The worker threads are created on demand and reused for all
+/// subsequent tracks until the pipeline is destroyed. Each track is
+/// processed by calling start(), followed by acquireChunk() and
+/// publishChunk() for every decoded chunk, and finally either drain()
+/// or abort(). All functions must be invoked by the same decoding thread.
+class AnalyzerPipeline final {
+  public:
+    static constexpr int kDefaultChunkCount = 16;
+
+    explicit AnalyzerPipeline(
+            SINT samplesPerChunk,
+            int chunkCount = kDefaultChunkCount);
+    /// Aborts processing and stops all worker threads
+    ~AnalyzerPipeline();
+
+    /// Returns the number of worker threads that have been created
+    /// so far
+    int workerCount() const {
+        return static_cast<int>(m_workers.size());
+    }
+
+    /// Starts processing the next track by all active analyzers and
+    /// returns their number.
+    ///
+    /// The analyzers must have been initialized before and must not be
+    /// accessed by the decoding thread until drain() or abort() returns.
+    int start(std::vector<AnalyzerWithState>* pAnalyzers);
+
+    /// Blocks until the next chunk buffer is available for writing.
+    /// Acquiring the buffer again without publishing it returns the
+    /// same buffer.
+    mixxx::SampleBuffer& acquireChunk();
+
+    /// Publishes the decoded audio data in the previously acquired
+    /// chunk buffer to all analyzers.
+    void publishChunk(mixxx::SampleBuffer::ReadableSlice readableSlice);
+
+    /// Blocks until all published chunks have been processed by all
+    /// analyzers of the current track.
+    void drain();
+
+    /// Discards all pending chunks of the current track and blocks
+    /// until none of the analyzers is accessed by a worker thread.
+    void abort();
+
+  private:
+    void processChunks(int workerIndex);
+
+    // Guarded by m_mutex
+    bool hasPendingChunk(int workerIndex) const {
+        return !m_aborted &&
+                workerIndex < static_cast<int>(m_analyzers.size()) &&
+                m_processedChunks[workerIndex] < m_publishedChunks;
+    }
+
+    std::vector<mixxx::SampleBuffer> m_chunks;
+    // The readable part of each chunk buffer
+    std::vector<mixxx::SampleBuffer::ReadableSlice> m_chunkSlices;
+
+    std::mutex m_mutex;
+    // Signals published chunks or stopping to the workers
+    std::condition_variable m_chunkPublished;
+    // Signals processed chunks to the decoding thread
+    std::condition_variable m_chunkProcessed;
+    // Guarded by m_mutex
+    std::vector<AnalyzerWithState*> m_analyzers;
+    quint64 m_publishedChunks;
+    std::vector<quint64> m_processedChunks;
+    int m_busyWorkers;
+    bool m_aborted;
+    bool m_stopping;
+
+    // Only accessed by the decoding thread
+    std::vector<std::thread> m_workers;
+};
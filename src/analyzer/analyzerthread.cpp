@@ -6,6 +6,7 @@
 #include "analyzer/analyzerebur128.h"
 #include "analyzer/analyzergain.h"
 #include "analyzer/analyzerkey.h"
+#include "analyzer/analyzerpipeline.h"
 #include "analyzer/analyzersilence.h"
 #include "analyzer/analyzerwaveform.h"
 #include "analyzer/constants.h"
@@ -120,6 +121,12 @@ void AnalyzerThread::doRun() {
     DEBUG_ASSERT(!m_analyzers.empty());
     kLogger.debug() << "Activated" << m_analyzers.size() << "analyzers";
 
+    // The worker threads of the pipeline are reused for all tracks
+    if (m_modeFlags & AnalyzerModeFlags::Pipelined) {
+        m_pPipeline = std::make_unique<AnalyzerPipeline>(
+                mixxx::kAnalysisSamplesPerChunk);
+    }
+
     m_lastBusyProgressEmittedTimer.start();
 
     mixxx::AudioSource::OpenParams openParams;
@@ -181,6 +188,8 @@ void AnalyzerThread::doRun() {
     DEBUG_ASSERT(!m_currentTrack);
     DEBUG_ASSERT(isStopping());
 
+    // Stop the worker threads before the analyzers are destroyed
+    m_pPipeline.reset();
     m_analyzers.clear();
 
     kLogger.debug() << "Exiting worker thread";
@@ -230,6 +239,14 @@ AnalyzerThread::AnalysisResult AnalyzerThread::analyzeAudioSource(
             audioSourceProxy.getSignalInfo().getChannelCount() ==
             mixxx::kAnalysisChannels);
 
+    // In pipelined mode the analyzers process the decoded chunks
+    // concurrently on their own threads.
+    AnalyzerPipeline* pPipeline = nullptr;
+    if (m_pPipeline && m_pPipeline->start(&m_analyzers) >= 2) {
+        // Nothing to gain from a separate thread for a single analyzer
+        pPipeline = m_pPipeline.get();
+    }
+
     // Analysis starts now
     emitBusyProgress(kAnalyzerProgressNone);
 
@@ -237,6 +254,9 @@ AnalyzerThread::AnalysisResult AnalyzerThread::analyzeAudioSource(
     while (!remainingFrameRange.empty()) {
         sleepWhileSuspended();
         if (isStopping()) {
+            if (pPipeline) {
+                pPipeline->abort();
+            }
             return AnalysisResult::Cancelled;
         }
 
@@ -248,12 +268,16 @@ AnalyzerThread::AnalysisResult AnalyzerThread::analyzeAudioSource(
                         math_min(mixxx::kAnalysisFramesPerChunk, remainingFrameRange.length()));
         DEBUG_ASSERT(!chunkFrameRange.empty());
 
-        // Request the next chunk of audio data
+        // Request the next chunk of audio data. In pipelined mode this
+        // blocks while the slowest analyzer is still busy with all
+        // buffered chunks.
+        mixxx::SampleBuffer& sampleBuffer =
+                pPipeline ? pPipeline->acquireChunk() : m_sampleBuffer;
         const auto readableSampleFrames =
                 audioSourceProxy.readSampleFrames(
                         mixxx::WritableSampleFrames(
                                 chunkFrameRange,
-                                mixxx::SampleBuffer::WritableSlice(m_sampleBuffer)));
+                                mixxx::SampleBuffer::WritableSlice(sampleBuffer)));
         // The returned range fits into the requested range
         DEBUG_ASSERT(readableSampleFrames.frameIndexRange() <= chunkFrameRange);
 
@@ -292,15 +316,22 @@ AnalyzerThread::AnalysisResult AnalyzerThread::analyzeAudioSource(
 
         sleepWhileSuspended();
         if (isStopping()) {
+            if (pPipeline) {
+                pPipeline->abort();
+            }
             return AnalysisResult::Cancelled;
         }
 
         // 2nd: step: Analyze chunk of decoded audio data
         if (!readableSampleFrames.frameIndexRange().empty()) {
-            for (auto&& analyzer : m_analyzers) {
-                analyzer.processSamples(
-                        readableSampleFrames.readableData(),
-                        readableSampleFrames.readableLength());
+            if (pPipeline) {
+                pPipeline->publishChunk(readableSampleFrames.readableSlice());
+            } else {
+                for (auto&& analyzer : m_analyzers) {
+                    analyzer.processSamples(
+                            readableSampleFrames.readableData(),
+                            readableSampleFrames.readableLength());
+                }
             }
         }
 
@@ -325,6 +356,11 @@ AnalyzerThread::AnalysisResult AnalyzerThread::analyzeAudioSource(
         }
     }
 
+    if (pPipeline) {
+        // Wait until all analyzers have caught up with the decoder
+        pPipeline->drain();
+    }
+
     return AnalysisResult::Finished;
 }
 
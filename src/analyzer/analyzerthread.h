@@ -5,6 +5,7 @@
 #include "rigtorp/SPSCQueue.h"
 
 #include "analyzer/analyzer.h"
+#include "analyzer/analyzerpipeline.h"
 #include "analyzer/analyzerprogress.h"
 #include "preferences/usersettings.h"
 #include "sources/audiosource.h"
@@ -20,6 +21,11 @@ enum AnalyzerModeFlags {
     WithBeats = 0x01,
     WithWaveform = 0x02,
     All = WithBeats | WithWaveform,
+    // Process the chunks of a single track concurrently by all analyzers,
+    // each on its own thread, while decoding the next chunks. Reduces the
+    // time until the results of a single track become available to the
+    // duration of the slowest analyzer.
+    Pipelined = 0x04,
 };
 
 enum class AnalyzerThreadState {
@@ -115,6 +121,9 @@ class AnalyzerThread : public WorkerThread {
 
     std::vector<AnalyzerWithState> m_analyzers;
 
+    // Only used in pipelined mode
+    std::unique_ptr<AnalyzerPipeline> m_pPipeline;
+
     mixxx::SampleBuffer m_sampleBuffer;
 
     TrackPointer m_currentTrack;
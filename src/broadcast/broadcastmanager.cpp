@@ -140,7 +140,7 @@ void BroadcastManager::slotProfileRemoved(BroadcastProfilePtr profile) {
 void BroadcastManager::slotProfilesChanged() {
     QVector<NetworkOutputStreamWorkerPtr> workers = m_pNetworkStream->outputWorkers();
     for(NetworkOutputStreamWorkerPtr pWorker : workers) {
-        ShoutConnectionPtr connection = qSharedPointerCast<ShoutConnection>(pWorker);
+        ShoutConnectionPtr connection = qSharedPointerDynamicCast<ShoutConnection>(pWorker);
         if (connection) {
             BroadcastProfilePtr profile = connection->profile();
             if (profile->connectionStatus() == BroadcastProfile::STATUS_FAILURE
@@ -160,7 +160,8 @@ bool BroadcastManager::addConnection(BroadcastProfilePtr profile) {
         return false;
     }
 
-    ShoutConnectionPtr connection(new ShoutConnection(profile, m_pConfig));
+    ShoutConnectionPtr connection(
+            new ShoutConnection(profile, m_pConfig, m_pNetworkStream));
     m_pNetworkStream->addOutputWorker(connection);
 
     connect(profile.data(),
@@ -199,7 +200,7 @@ bool BroadcastManager::removeConnection(BroadcastProfilePtr profile) {
 ShoutConnectionPtr BroadcastManager::findConnectionForProfile(BroadcastProfilePtr profile) {
     QVector<NetworkOutputStreamWorkerPtr> workers = m_pNetworkStream->outputWorkers();
     for(NetworkOutputStreamWorkerPtr pWorker : workers) {
-        ShoutConnectionPtr connection = qSharedPointerCast<ShoutConnection>(pWorker);
+        ShoutConnectionPtr connection = qSharedPointerDynamicCast<ShoutConnection>(pWorker);
         if (connection.isNull())
             continue;
 
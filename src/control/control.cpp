@@ -1,21 +1,14 @@
 #include "control/control.h"
 
 #include "control/controlobject.h"
+#include "control/controlsnapshot.h"
 #include "util/stat.h"
 
 //static
 UserSettingsPointer ControlDoublePrivate::s_pUserConfig;
 
 //static
-QHash<ConfigKey, QWeakPointer<ControlDoublePrivate>> ControlDoublePrivate::s_qCOHash
-        GUARDED_BY(ControlDoublePrivate::s_qCOHashMutex);
-
-//static
-QHash<ConfigKey, ConfigKey> ControlDoublePrivate::s_qCOAliasHash
-        GUARDED_BY(ControlDoublePrivate::s_qCOHashMutex);
-
-//static
-MMutex ControlDoublePrivate::s_qCOHashMutex;
+ControlRegistry ControlDoublePrivate::s_registry;
 
 ControlDoublePrivate::ControlDoublePrivate(
         ConfigKey key,
@@ -32,7 +25,8 @@ ControlDoublePrivate::ControlDoublePrivate(
           m_trackType(Stat::UNSPECIFIED),
           m_trackFlags(Stat::COUNT | Stat::SUM | Stat::AVERAGE |
                   Stat::SAMPLE_VARIANCE | Stat::MIN | Stat::MAX),
-          m_confirmRequired(false) {
+          m_confirmRequired(false),
+          m_bSnapshotted(false) {
     initialize(defaultValue);
 }
 
@@ -59,11 +53,6 @@ void ControlDoublePrivate::initialize(double defaultValue) {
 }
 
 ControlDoublePrivate::~ControlDoublePrivate() {
-    s_qCOHashMutex.lock();
-    //qDebug() << "ControlDoublePrivate::s_qCOHash.remove(" << m_key.group << "," << m_key.item << ")";
-    s_qCOHash.remove(m_key);
-    s_qCOHashMutex.unlock();
-
     if (m_bPersistInConfiguration) {
         UserSettingsPointer pConfig = ControlDoublePrivate::s_pUserConfig;
         if (pConfig != NULL) {
@@ -74,22 +63,9 @@ ControlDoublePrivate::~ControlDoublePrivate() {
 
 // static
 void ControlDoublePrivate::insertAlias(const ConfigKey& alias, const ConfigKey& key) {
-    MMutexLocker locker(&s_qCOHashMutex);
-
-    auto it = s_qCOHash.constFind(key);
-    if (it == s_qCOHash.constEnd()) {
-        qWarning() << "WARNING: ControlDoublePrivate::insertAlias called for null control" << key;
-        return;
-    }
-
-    QSharedPointer<ControlDoublePrivate> pControl = it.value();
-    if (pControl.isNull()) {
-        qWarning() << "WARNING: ControlDoublePrivate::insertAlias called for expired control" << key;
-        return;
+    if (!s_registry.insertAlias(alias, key)) {
+        qWarning() << "WARNING: ControlDoublePrivate::insertAlias called for null or expired control" << key;
     }
-
-    s_qCOAliasHash.insert(key, alias);
-    s_qCOHash.insert(alias, pControl);
 }
 
 // static
@@ -107,40 +83,36 @@ QSharedPointer<ControlDoublePrivate> ControlDoublePrivate::getControl(
         return nullptr;
     }
 
-    // Scope for MMutexLocker.
-    {
-        const MMutexLocker locker(&s_qCOHashMutex);
-        const auto it = s_qCOHash.find(key);
-        if (it != s_qCOHash.end()) {
-            auto pControl = it.value().lock();
-            if (pControl) {
-                // Control object already exists
-                VERIFY_OR_DEBUG_ASSERT(!pCreatorCO) {
-                    qWarning()
-                            << "ControlObject"
-                            << key.group << key.item
-                            << "already created";
-                    return nullptr;
-                }
-                return pControl;
-            } else {
-                // The weak pointer has become invalid and can be cleaned up
-                s_qCOHash.erase(it);
-            }
+    auto pControl = s_registry.lookup(key);
+    if (pControl) {
+        // Control object already exists
+        VERIFY_OR_DEBUG_ASSERT(!pCreatorCO) {
+            qWarning()
+                    << "ControlObject"
+                    << key.group << key.item
+                    << "already created";
+            return nullptr;
         }
+        return pControl;
     }
 
     if (pCreatorCO) {
-        auto pControl = QSharedPointer<ControlDoublePrivate>(
+        pControl = QSharedPointer<ControlDoublePrivate>(
                 new ControlDoublePrivate(key,
                         pCreatorCO,
                         bIgnoreNops,
                         bTrack,
                         bPersist,
                         defaultValue));
-        const MMutexLocker locker(&s_qCOHashMutex);
-        //qDebug() << "ControlDoublePrivate::s_qCOHash.insert(" << key.group << "," << key.item << ")";
-        s_qCOHash.insert(key, pControl);
+        //qDebug() << "ControlDoublePrivate::s_registry.insert(" << key.group << "," << key.item << ")";
+        auto pRegisteredControl = s_registry.insert(key, pControl);
+        VERIFY_OR_DEBUG_ASSERT(pRegisteredControl == pControl) {
+            qWarning()
+                    << "ControlObject"
+                    << key.group << key.item
+                    << "already created";
+            return nullptr;
+        }
         return pControl;
     }
 
@@ -154,34 +126,12 @@ QSharedPointer<ControlDoublePrivate> ControlDoublePrivate::getControl(
 
 // static
 QList<QSharedPointer<ControlDoublePrivate>> ControlDoublePrivate::getAllInstances() {
-    QList<QSharedPointer<ControlDoublePrivate>> result;
-    MMutexLocker locker(&s_qCOHashMutex);
-    result.reserve(s_qCOHash.size());
-    for (auto it = s_qCOHash.begin(); it != s_qCOHash.end(); ++it) {
-        auto pControl = it.value().lock();
-        if (pControl) {
-            result.append(std::move(pControl));
-        } else {
-            // The weak pointer has become invalid and can be cleaned up
-            s_qCOHash.erase(it);
-        }
-    }
-    return result;
+    return s_registry.getAll();
 }
 
 // static
 QList<QSharedPointer<ControlDoublePrivate>> ControlDoublePrivate::takeAllInstances() {
-    QList<QSharedPointer<ControlDoublePrivate>> result;
-    MMutexLocker locker(&s_qCOHashMutex);
-    result.reserve(s_qCOHash.size());
-    for (auto it = s_qCOHash.begin(); it != s_qCOHash.end(); ++it) {
-        auto pControl = it.value().lock();
-        if (pControl) {
-            result.append(std::move(pControl));
-        }
-    }
-    s_qCOHash.clear();
-    return result;
+    return s_registry.takeAll();
 }
 
 void ControlDoublePrivate::deleteCreatorCO() {
@@ -218,6 +168,9 @@ void ControlDoublePrivate::setInner(double value, QObject* pSender) {
         return;
     }
     m_value.setValue(value);
+    if (m_bSnapshotted.load(std::memory_order_relaxed)) {
+        ControlSnapshot::publishChange();
+    }
     emit valueChanged(value, pSender);
 
     if (m_bTrack) {
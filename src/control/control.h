@@ -6,10 +6,12 @@
 #include <QSharedPointer>
 #include <QString>
 
+#include <atomic>
+
 #include "control/controlbehavior.h"
+#include "control/controlregistry.h"
 #include "control/controlvalue.h"
 #include "preferences/usersettings.h"
-#include "util/mutex.h"
 
 class ControlObject;
 
@@ -42,7 +44,7 @@ class ControlDoublePrivate : public QObject {
 
     // Gets the ControlDoublePrivate matching the given ConfigKey. If pCreatorCO
     // is non-NULL, allocates a new ControlDoublePrivate for the ConfigKey if
-    // one does not exist.
+    // one does not exist. Looking up existing controls is lock-free.
     static QSharedPointer<ControlDoublePrivate> getControl(
             const ConfigKey& key,
             ControlFlags flags = ControlFlag::None,
@@ -58,8 +60,7 @@ class ControlDoublePrivate : public QObject {
     static QList<QSharedPointer<ControlDoublePrivate>> takeAllInstances();
 
     static QHash<ConfigKey, ConfigKey> getControlAliases() {
-        // Implicitly shared classes can safely be copied across threads
-        return s_qCOAliasHash;
+        return s_registry.aliases();
     }
 
     const QString& name() const {
@@ -110,6 +111,12 @@ class ControlDoublePrivate : public QObject {
         return m_bIgnoreNops;
     }
 
+    // Invoked once when the control is added to a ControlSnapshot. All
+    // following value changes are published to the snapshots.
+    void enableSnapshots() {
+        m_bSnapshotted.store(true, std::memory_order_release);
+    }
+
     void setDefaultValue(double dValue) {
         m_defaultValue.setValue(dValue);
     }
@@ -187,6 +194,9 @@ class ControlDoublePrivate : public QObject {
     int m_trackFlags;
     bool m_confirmRequired;
 
+    // Whether the control is part of any ControlSnapshot.
+    std::atomic<bool> m_bSnapshotted;
+
     // User-visible, i18n name for what the control is.
     QString m_name;
 
@@ -208,13 +218,7 @@ class ControlDoublePrivate : public QObject {
     // configuration object would be arduous.
     static UserSettingsPointer s_pUserConfig;
 
-    // Hash of ControlDoublePrivate instantiations.
-    static QHash<ConfigKey, QWeakPointer<ControlDoublePrivate>> s_qCOHash;
-
-    // Hash of aliases between ConfigKeys. Solely used for looking up the first
-    // alias associated with a key.
-    static QHash<ConfigKey, ConfigKey> s_qCOAliasHash;
-
-    // Mutex guarding access to s_qCOHash and s_qCOAliasHash.
-    static MMutex s_qCOHashMutex;
+    // All ControlDoublePrivate instantiations and the aliases between
+    // their ConfigKeys.
+    static ControlRegistry s_registry;
 };
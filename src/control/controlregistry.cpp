@@ -0,0 +1,222 @@
+#include "control/controlregistry.h"
+
+#include "control/control.h"
+#include "util/assert.h"
+
+namespace {
+
+// Sufficient for a typical configuration with 4 decks and a few samplers
+constexpr int kInitialCapacity = 8192;
+
+} // anonymous namespace
+
+ControlRegistry::Table::Table(int capacity)
+        : mask(capacity - 1),
+          size(0),
+          slots(new std::atomic<Registration*>[capacity]) {
+    // The capacity must be a power of 2
+    DEBUG_ASSERT((capacity & mask) == 0);
+    for (int i = 0; i < capacity; ++i) {
+        slots[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+ControlRegistry::ControlRegistry()
+        : m_pTable(new Table(kInitialCapacity)),
+          m_readers(0) {
+}
+
+ControlRegistry::~ControlRegistry() {
+    Table* pTable = m_pTable.load();
+    for (uint i = 0; i <= pTable->mask; ++i) {
+        delete pTable->slots[i].load(std::memory_order_relaxed);
+    }
+    delete pTable;
+    MMutexLocker locker(&m_mutex);
+    for (Registration* pRegistration : m_retiredRegistrations) {
+        delete pRegistration;
+    }
+    for (Table* pRetiredTable : m_retiredTables) {
+        delete pRetiredTable;
+    }
+}
+
+QSharedPointer<ControlDoublePrivate> ControlRegistry::lookup(
+        const ConfigKey& key) const {
+    const uint hash = qHash(key);
+    QSharedPointer<ControlDoublePrivate> pControl;
+    // Prevents that the table and the registration are deleted while
+    // being accessed. All accesses are sequentially consistent, otherwise
+    // reclaim() might miss a lookup that is just starting.
+    m_readers.fetch_add(1);
+    const Table* pTable = m_pTable.load();
+    for (uint index = hash & pTable->mask;; index = (index + 1) & pTable->mask) {
+        const Registration* pRegistration = pTable->slots[index].load();
+        if (!pRegistration) {
+            break;
+        }
+        if (pRegistration->hash == hash && pRegistration->key == key) {
+            pControl = pRegistration->pControl.toStrongRef();
+            break;
+        }
+    }
+    m_readers.fetch_sub(1);
+    return pControl;
+}
+
+QSharedPointer<ControlDoublePrivate> ControlRegistry::insert(
+        const ConfigKey& key,
+        const QSharedPointer<ControlDoublePrivate>& pControl) {
+    const uint hash = qHash(key);
+    MMutexLocker locker(&m_mutex);
+    const Registration* pRegistration =
+            findSlot(*m_pTable.load(), key, hash).load(std::memory_order_relaxed);
+    if (pRegistration) {
+        auto pExistingControl = pRegistration->pControl.toStrongRef();
+        if (pExistingControl) {
+            // Another thread has created the same control concurrently
+            return pExistingControl;
+        }
+    }
+    publish(key, hash, pControl);
+    reclaim();
+    return pControl;
+}
+
+bool ControlRegistry::insertAlias(const ConfigKey& alias, const ConfigKey& key) {
+    MMutexLocker locker(&m_mutex);
+    const Registration* pRegistration =
+            findSlot(*m_pTable.load(), key, qHash(key)).load(std::memory_order_relaxed);
+    if (!pRegistration) {
+        return false;
+    }
+    auto pControl = pRegistration->pControl.toStrongRef();
+    if (!pControl) {
+        return false;
+    }
+    m_aliases.insert(key, alias);
+    publish(alias, qHash(alias), pControl);
+    reclaim();
+    return true;
+}
+
+QHash<ConfigKey, ConfigKey> ControlRegistry::aliases() const {
+    MMutexLocker locker(&m_mutex);
+    return m_aliases;
+}
+
+QList<QSharedPointer<ControlDoublePrivate>> ControlRegistry::getAll() const {
+    QList<QSharedPointer<ControlDoublePrivate>> result;
+    MMutexLocker locker(&m_mutex);
+    const Table* pTable = m_pTable.load();
+    result.reserve(pTable->size);
+    for (uint i = 0; i <= pTable->mask; ++i) {
+        const Registration* pRegistration =
+                pTable->slots[i].load(std::memory_order_relaxed);
+        if (!pRegistration) {
+            continue;
+        }
+        auto pControl = pRegistration->pControl.toStrongRef();
+        if (pControl) {
+            result.append(std::move(pControl));
+        }
+    }
+    return result;
+}
+
+QList<QSharedPointer<ControlDoublePrivate>> ControlRegistry::takeAll() {
+    QList<QSharedPointer<ControlDoublePrivate>> result;
+    MMutexLocker locker(&m_mutex);
+    const Table* pTable = m_pTable.load();
+    result.reserve(pTable->size);
+    for (uint i = 0; i <= pTable->mask; ++i) {
+        const Registration* pRegistration =
+                pTable->slots[i].load(std::memory_order_relaxed);
+        if (!pRegistration) {
+            continue;
+        }
+        auto pControl = pRegistration->pControl.toStrongRef();
+        if (pControl) {
+            result.append(std::move(pControl));
+            // The key stays interned
+            publish(pRegistration->key, pRegistration->hash, nullptr);
+        }
+    }
+    reclaim();
+    return result;
+}
+
+// static
+std::atomic<ControlRegistry::Registration*>& ControlRegistry::findSlot(
+        const Table& table, const ConfigKey& key, uint hash) {
+    for (uint index = hash & table.mask;; index = (index + 1) & table.mask) {
+        const Registration* pRegistration =
+                table.slots[index].load(std::memory_order_relaxed);
+        if (!pRegistration ||
+                (pRegistration->hash == hash && pRegistration->key == key)) {
+            return table.slots[index];
+        }
+    }
+}
+
+void ControlRegistry::publish(const ConfigKey& key,
+        uint hash,
+        const QSharedPointer<ControlDoublePrivate>& pControl) {
+    Table* pTable = m_pTable.load(std::memory_order_relaxed);
+    std::atomic<Registration*>* pSlot = &findSlot(*pTable, key, hash);
+    Registration* pPreviousRegistration = pSlot->load(std::memory_order_relaxed);
+    if (!pPreviousRegistration) {
+        // Keep the load factor below 1/2 for short probe sequences
+        if (static_cast<uint>(pTable->size + 1) * 2 > pTable->mask + 1) {
+            grow();
+            pTable = m_pTable.load(std::memory_order_relaxed);
+            pSlot = &findSlot(*pTable, key, hash);
+        }
+        ++pTable->size;
+    }
+    pSlot->store(new Registration(key, hash, pControl));
+    if (pPreviousRegistration) {
+        retire(pPreviousRegistration);
+    }
+}
+
+void ControlRegistry::grow() {
+    Table* pTable = m_pTable.load(std::memory_order_relaxed);
+    auto* pGrownTable = new Table(static_cast<int>(pTable->mask + 1) * 2);
+    for (uint i = 0; i <= pTable->mask; ++i) {
+        Registration* pRegistration =
+                pTable->slots[i].load(std::memory_order_relaxed);
+        if (pRegistration) {
+            findSlot(*pGrownTable, pRegistration->key, pRegistration->hash)
+                    .store(pRegistration, std::memory_order_relaxed);
+        }
+    }
+    pGrownTable->size = pTable->size;
+    // The registrations are now owned by the grown table
+    m_pTable.store(pGrownTable);
+    retire(pTable);
+}
+
+void ControlRegistry::retire(Registration* pRegistration) {
+    m_retiredRegistrations.push_back(pRegistration);
+}
+
+void ControlRegistry::retire(Table* pTable) {
+    m_retiredTables.push_back(pTable);
+}
+
+void ControlRegistry::reclaim() {
+    // Lookups that started before the objects have been retired might
+    // still access them. Lookups that start afterwards will not find them.
+    if (m_readers.load() > 0) {
+        return;
+    }
+    for (Registration* pRegistration : m_retiredRegistrations) {
+        delete pRegistration;
+    }
+    m_retiredRegistrations.clear();
+    for (Table* pTable : m_retiredTables) {
+        delete pTable;
+    }
+    m_retiredTables.clear();
+}
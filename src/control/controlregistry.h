@@ -0,0 +1,107 @@
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QSharedPointer>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "preferences/configobject.h"
+#include "util/mutex.h"
+
+class ControlDoublePrivate;
+
+/// The registry of all ControlDoublePrivate instances by ConfigKey.
+///
+/// Skins create thousands of ControlProxy objects while loading and
+/// controller scripts resolve controls by their group and item at runtime.
+/// Each distinct key is interned once into a registration that is never
+/// removed. If the control is deleted the registration keeps the key and
+/// its weak pointer expires. Later controls for the same key reuse the slot.
+///
+/// Lookups are lock-free: The registrations are kept in an open addressing
+/// hash table and both the table and the registrations are immutable once
+/// published. Only inserting controls, i.e. creating a new ControlObject,
+/// acquires a mutex. Replaced tables and registrations are retired and
+/// deleted as soon as no lookup is in progress.
+class ControlRegistry {
+  public:
+    ControlRegistry();
+    ~ControlRegistry();
+
+    /// Returns the control for the key or null if it does not exist or
+    /// has already been deleted. Lock-free, may be invoked from any thread.
+    QSharedPointer<ControlDoublePrivate> lookup(const ConfigKey& key) const;
+
+    /// Registers the control for the key unless another control for the
+    /// same key exists. Returns the registered control.
+    QSharedPointer<ControlDoublePrivate> insert(
+            const ConfigKey& key,
+            const QSharedPointer<ControlDoublePrivate>& pControl);
+
+    /// Adds a ConfigKey for 'alias' to the control for 'key'. Returns false
+    /// if the 'key' control does not exist.
+    bool insertAlias(const ConfigKey& alias, const ConfigKey& key);
+
+    QHash<ConfigKey, ConfigKey> aliases() const;
+
+    /// Returns all controls that have not been deleted yet.
+    QList<QSharedPointer<ControlDoublePrivate>> getAll() const;
+    /// Unregisters all controls and returns them.
+    QList<QSharedPointer<ControlDoublePrivate>> takeAll();
+
+  private:
+    struct Registration {
+        Registration(const ConfigKey& key,
+                uint hash,
+                const QSharedPointer<ControlDoublePrivate>& pControl)
+                : key(key),
+                  hash(hash),
+                  pControl(pControl) {
+        }
+
+        const ConfigKey key;
+        const uint hash;
+        const QWeakPointer<ControlDoublePrivate> pControl;
+    };
+
+    struct Table {
+        explicit Table(int capacity);
+
+        const uint mask;
+        // Only accessed while holding the mutex
+        int size;
+        // Null terminates the probe sequence
+        std::unique_ptr<std::atomic<Registration*>[]> slots;
+    };
+
+    // Returns the slot of the key or the empty slot that terminates its
+    // probe sequence
+    static std::atomic<Registration*>& findSlot(
+            const Table& table, const ConfigKey& key, uint hash);
+
+    // Stores the registration for the key, replacing and retiring the
+    // previous one for the same key. Requires the mutex.
+    void publish(const ConfigKey& key,
+            uint hash,
+            const QSharedPointer<ControlDoublePrivate>& pControl);
+    void grow();
+
+    void retire(Registration* pRegistration);
+    void retire(Table* pTable);
+    // Deletes all retired objects unless a lookup is in progress
+    void reclaim();
+
+    std::atomic<Table*> m_pTable;
+    // The number of lookups in progress
+    mutable std::atomic<int> m_readers;
+
+    // Guards all following members and serializes all modifications
+    mutable MMutex m_mutex;
+    std::vector<Registration*> m_retiredRegistrations GUARDED_BY(m_mutex);
+    std::vector<Table*> m_retiredTables GUARDED_BY(m_mutex);
+    // Solely used for looking up the first alias associated with a key.
+    QHash<ConfigKey, ConfigKey> m_aliases GUARDED_BY(m_mutex);
+};
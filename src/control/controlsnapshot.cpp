@@ -0,0 +1,33 @@
+#include "control/controlsnapshot.h"
+
+#include "control/control.h"
+
+// static
+std::atomic<quint32> ControlSnapshot::s_epoch(0);
+
+ControlSnapshot::ControlSnapshot()
+        : m_values(),
+          m_size(0),
+          m_epoch(s_epoch.load(std::memory_order_acquire)) {
+}
+
+ControlSnapshot::Index ControlSnapshot::addControl(const ConfigKey& key) {
+    QSharedPointer<ControlDoublePrivate> pControl =
+            ControlDoublePrivate::getControl(key);
+    VERIFY_OR_DEBUG_ASSERT(pControl && m_size < kMaxControls) {
+        return -1;
+    }
+    const Index index = m_size++;
+    // Enable publishing before reading the initial value to not miss
+    // any change in between
+    pControl->enableSnapshots();
+    m_values[index] = pControl->get();
+    m_controls[index] = std::move(pControl);
+    return index;
+}
+
+void ControlSnapshot::copyValues() {
+    for (Index index = 0; index < m_size; ++index) {
+        m_values[index] = m_controls[index]->get();
+    }
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <QSharedPointer>
+
+#include <atomic>
+
+#include "preferences/configobject.h"
+#include "util/assert.h"
+
+class ControlDoublePrivate;
+
+/// A contiguous, cache-line-aligned copy of the values of a fixed set of
+/// controls, e.g. those that an engine channel reads while processing a
+/// buffer.
+///
+/// Reading a control through ControlObject or ControlProxy dereferences its
+/// ControlDoublePrivate somewhere on the heap. The engine reads dozens of
+/// controls per channel and callback. Instead refresh() is invoked once at
+/// the start of the callback and all following reads access the contiguous
+/// snapshot. The values stay consistent during the whole callback, i.e.
+/// changes from other threads take effect in the next callback.
+///
+/// Controls that are part of any snapshot increment a single global epoch
+/// whenever their value changes. refresh() only copies the values if the
+/// epoch has changed, i.e. usually it only loads one atomic variable.
+///
+/// Only add controls that are not modified by the engine itself after
+/// refresh(), otherwise the engine would read a stale value until the
+/// next callback.
+class ControlSnapshot {
+  public:
+    typedef int Index;
+
+    static constexpr int kCacheLineSize = 64;
+    // 4 cache lines
+    static constexpr int kMaxControls = 32;
+
+    ControlSnapshot();
+
+    /// Adds the control and returns the index of its value. Not thread-safe,
+    /// must be invoked before the engine starts processing.
+    Index addControl(const ConfigKey& key);
+
+    int size() const {
+        return m_size;
+    }
+
+    /// Updates the values if any control of any snapshot has changed since
+    /// the last refresh. Real-time safe.
+    void refresh() {
+        const quint32 epoch = s_epoch.load(std::memory_order_acquire);
+        if (epoch != m_epoch) {
+            m_epoch = epoch;
+            copyValues();
+        }
+    }
+
+    double get(Index index) const {
+        VERIFY_OR_DEBUG_ASSERT(index >= 0 && index < m_size) {
+            return 0.0;
+        }
+        return m_values[index];
+    }
+
+    bool toBool(Index index) const {
+        return get(index) > 0.0;
+    }
+
+    /// Invoked by ControlDoublePrivate after the value of a control that
+    /// is part of any snapshot has changed.
+    static void publishChange() {
+        s_epoch.fetch_add(1, std::memory_order_release);
+    }
+
+  private:
+    void copyValues();
+
+    alignas(kCacheLineSize) double m_values[kMaxControls];
+    int m_size;
+    quint32 m_epoch;
+
+    // Only accessed by refresh() if any value has changed
+    QSharedPointer<ControlDoublePrivate> m_controls[kMaxControls];
+
+    static std::atomic<quint32> s_epoch;
+};
@@ -172,6 +172,7 @@ void ControllerEngine::gracefulShutdown() {
     m_scriptWrappedFunctionCache.clear();
 
     // Free all the ControlObjectScripts
+    m_controlCallSites.fill(ControlCallSite());
     {
         auto it = m_controlCache.begin();
         while (it != m_controlCache.end()) {
@@ -533,6 +534,18 @@ void ControllerEngine::errorDialogButton(
 }
 
 ControlObjectScript* ControllerEngine::getControlObjectScript(const QString& group, const QString& name) {
+    const quintptr groupAddress = reinterpret_cast<quintptr>(group.constData());
+    const quintptr nameAddress = reinterpret_cast<quintptr>(name.constData());
+    ControlCallSite& callSite = m_controlCallSites[
+            ((groupAddress >> 4) ^ (nameAddress >> 3)) % kControlCallSiteCacheSize];
+    if (callSite.pControl &&
+            callSite.group.constData() == group.constData() &&
+            callSite.group.size() == group.size() &&
+            callSite.name.constData() == name.constData() &&
+            callSite.name.size() == name.size()) {
+        return callSite.pControl;
+    }
+
     ConfigKey key = ConfigKey(group, name);
     ControlObjectScript* coScript = m_controlCache.value(key, nullptr);
     if (coScript == nullptr) {
@@ -542,9 +555,12 @@ ControlObjectScript* ControllerEngine::getControlObjectScript(const QString& gro
             m_controlCache.insert(key, coScript);
         } else {
             delete coScript;
-            coScript = nullptr;
+            return nullptr;
         }
     }
+    callSite.group = group;
+    callSite.name = name;
+    callSite.pControl = coScript;
     return coScript;
 }
 
@@ -7,6 +7,8 @@
 #include <QTimerEvent>
 #include <QtScript>
 
+#include <array>
+
 #include "controllers/controllerpreset.h"
 #include "controllers/softtakeover.h"
 #include "preferences/usersettings.h"
@@ -138,6 +140,8 @@ class ControllerEngine : public QObject {
     bool m_bDisplayingExceptionDialog;
     QJSEngine* m_pScriptEngine;
 
+    /// Resolves the control, creating a ControlObjectScript on first use.
+    /// Invoked for each engine.getValue()/setValue() etc. call of a script.
     ControlObjectScript* getControlObjectScript(const QString& group, const QString& name);
 
     // Scratching functions & variables
@@ -153,6 +157,19 @@ class ControllerEngine : public QObject {
     QJSValue m_shutdownFunction;
     QList<QString> m_scriptFunctionPrefixes;
     QHash<ConfigKey, ControlObjectScript*> m_controlCache;
+    /// The strings that are passed by a script call site with literal
+    /// arguments, e.g. engine.getValue("[Master]", "crossfader"), share
+    /// their data on every call. The resolved control is cached by the
+    /// addresses of this data, which avoids hashing and comparing both
+    /// strings. The cached strings are referenced to keep their data alive,
+    /// i.e. the addresses cannot be reused for other strings.
+    struct ControlCallSite {
+        QString group;
+        QString name;
+        ControlObjectScript* pControl = nullptr;
+    };
+    static constexpr int kControlCallSiteCacheSize = 256;
+    std::array<ControlCallSite, kControlCallSiteCacheSize> m_controlCallSites;
     struct TimerInfo {
         QJSValue callback;
         bool oneShot;
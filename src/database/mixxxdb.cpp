@@ -29,6 +29,29 @@ const QString kUserName = QStringLiteral("mixxx");
 
 const QString kPassword = QStringLiteral("mixxx");
 
+const QString kConfigGroup = QStringLiteral("[Library]");
+
+// Readers in the GUI thread must not block behind writes of the
+// library scanner or the analysis. In WAL mode a commit doesn't
+// require to sync the database file and NORMAL is still safe.
+mixxx::DbConnection::SqliteProfile sqliteProfile(
+        const UserSettingsPointer& pConfig) {
+    mixxx::DbConnection::SqliteProfile profile;
+    profile.journalMode = pConfig->getValue(
+            ConfigKey(kConfigGroup, "SqliteJournalMode"), "WAL");
+    profile.synchronous = pConfig->getValue(
+            ConfigKey(kConfigGroup, "SqliteSynchronous"), "NORMAL");
+    profile.tempStore = pConfig->getValue(
+            ConfigKey(kConfigGroup, "SqliteTempStore"), "MEMORY");
+    profile.mmapSize = static_cast<qint64>(pConfig->getValue<int>(
+                               ConfigKey(kConfigGroup, "SqliteMmapSizeMiB"), 256)) *
+            1024 * 1024;
+    // Negative values are in KiB
+    profile.cacheSize = -pConfig->getValue<int>(
+            ConfigKey(kConfigGroup, "SqliteCacheSizeKiB"), 16 * 1024);
+    return profile;
+}
+
 // The connection parameters for the main Mixxx DB
 mixxx::DbConnection::Params dbConnectionParams(
         const UserSettingsPointer& pConfig,
@@ -57,6 +80,7 @@ mixxx::DbConnection::Params dbConnectionParams(
     }
     params.userName = kUserName;
     params.password = kPassword;
+    params.sqliteProfile = sqliteProfile(pConfig);
     return params;
 }
 
@@ -0,0 +1,332 @@
+#include "encoder/encodershared.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QtEndian>
+
+#include <deque>
+
+#include "encoder/encodercallback.h"
+#include "engine/sidechain/enginenetworkstream.h"
+#include "engine/sidechain/networkoutputstreamworker.h"
+#include "util/assert.h"
+#include "util/counter.h"
+#include "util/logger.h"
+#include "util/math.h"
+
+namespace {
+
+const mixxx::Logger kLogger("EncoderShared");
+
+// Encoded packets are kept until they have been passed to all
+// instances. An instance that is stalled, e.g. while reconnecting,
+// misses the oldest packets when falling behind by more than this
+// number of packets.
+constexpr std::size_t kMaxPendingPackets = 4096;
+
+QString streamKey(const EncoderSettings& settings, int samplerate) {
+    return QString("%1/%2/%3/%4/%5")
+            .arg(settings.getFormat())
+            .arg(settings.getQuality())
+            .arg(settings.getCompression())
+            .arg(static_cast<int>(settings.getChannelMode()))
+            .arg(samplerate);
+}
+
+// Ogg streams start with header pages with a granule position of 0
+bool isOggHeaderPage(const QByteArray& packet) {
+    constexpr int kGranulePosOffset = 6;
+    constexpr int kMinPageSize = 27;
+    if (packet.size() < kMinPageSize || !packet.startsWith("OggS")) {
+        return false;
+    }
+    return qFromLittleEndian<qint64>(packet.constData() + kGranulePosOffset) == 0;
+}
+
+} // anonymous namespace
+
+// Receives the master mix from the EngineNetworkStream like a broadcast
+// connection, but is only drained by the encoding stream
+class EncoderShared::Tap : public NetworkOutputStreamWorker {
+  public:
+    void process(const CSAMPLE* pBuffer, const int iBufferSize) override {
+        Q_UNUSED(pBuffer);
+        Q_UNUSED(iBufferSize);
+    }
+    void shutdown() override {
+    }
+
+    void setOutputFifo(QSharedPointer<FIFO<CSAMPLE>> pOutputFifo) override {
+        m_pOutputFifo = std::move(pOutputFifo);
+    }
+    QSharedPointer<FIFO<CSAMPLE>> getOutputFifo() override {
+        return m_pOutputFifo;
+    }
+
+    // The tap exists only while at least one connection is streaming
+    bool threadWaiting() override {
+        return true;
+    }
+
+  private:
+    QSharedPointer<FIFO<CSAMPLE>> m_pOutputFifo;
+};
+
+class EncoderShared::Stream : public EncoderCallback {
+  public:
+    Stream(const QString& key,
+            const EncoderSettingsPointer& pSettings,
+            QSharedPointer<EngineNetworkStream> pNetworkStream)
+            : m_key(key),
+              m_pNetworkStream(std::move(pNetworkStream)),
+              m_pTap(new Tap),
+              m_pEncoder(EncoderFactory::getFactory().createEncoder(pSettings, this)),
+              m_firstPacket(0),
+              m_headersComplete(false) {
+    }
+    ~Stream() override {
+        if (m_pTap->getOutputFifo()) {
+            m_pNetworkStream->removeOutputWorker(m_pTap);
+        }
+        // The encoder might write the remaining packets while
+        // being destroyed
+        m_pEncoder.reset();
+    }
+
+    // All streams that are in use, indexed by their key
+    static QMutex s_streamsMutex;
+    static QHash<QString, std::weak_ptr<Stream>> s_streams;
+
+    // Starts feeding the tap with the master mix
+    bool attachTap() {
+        m_pNetworkStream->addOutputWorker(m_pTap);
+        // No FIFO is assigned if all slots are in use
+        return !m_pTap->getOutputFifo().isNull();
+    }
+
+    // Encodes all samples that the tap has received so far
+    void encodePendingSamples() {
+        QSharedPointer<FIFO<CSAMPLE>> pFifo = m_pTap->getOutputFifo();
+        const int readAvailable = pFifo->readAvailable();
+        if (readAvailable <= 0) {
+            return;
+        }
+        CSAMPLE* dataPtr1;
+        ring_buffer_size_t size1;
+        CSAMPLE* dataPtr2;
+        ring_buffer_size_t size2;
+        (void)pFifo->aquireReadRegions(readAvailable,
+                &dataPtr1, &size1, &dataPtr2, &size2);
+        m_pEncoder->encodeBuffer(dataPtr1, size1);
+        if (size2 > 0) {
+            m_pEncoder->encodeBuffer(dataPtr2, size2);
+        }
+        pFifo->releaseReadRegions(readAvailable);
+    }
+
+    void write(const unsigned char* header, const unsigned char* body,
+            int headerLen, int bodyLen) override {
+        QByteArray packet;
+        packet.reserve(headerLen + bodyLen);
+        if (headerLen > 0) {
+            packet.append(reinterpret_cast<const char*>(header), headerLen);
+        }
+        packet.append(reinterpret_cast<const char*>(body), bodyLen);
+        if (!m_headersComplete) {
+            if (isOggHeaderPage(packet)) {
+                m_headers.append(packet);
+            } else {
+                m_headersComplete = true;
+            }
+        }
+        m_packets.push_back(std::move(packet));
+        if (m_packets.size() > kMaxPendingPackets) {
+            m_packets.pop_front();
+            ++m_firstPacket;
+        }
+    }
+    // Drops all packets that have been passed to all instances
+    void releasePackets() {
+        qint64 nextPacket = m_firstPacket + static_cast<qint64>(m_packets.size());
+        for (const auto instanceNextPacket : qAsConst(m_nextPackets)) {
+            nextPacket = math_min(nextPacket, instanceNextPacket);
+        }
+        while (m_firstPacket < nextPacket) {
+            m_packets.pop_front();
+            ++m_firstPacket;
+        }
+    }
+
+    // Not used for streaming
+    int tell() override {
+        return -1;
+    }
+    void seek(int pos) override {
+        Q_UNUSED(pos);
+    }
+    int filelen() override {
+        return 0;
+    }
+
+    const QString m_key;
+    const QSharedPointer<EngineNetworkStream> m_pNetworkStream;
+    const QSharedPointer<Tap> m_pTap;
+
+    // Protects all members below and serializes reading from the tap
+    QMutex m_mutex;
+    EncoderPointer m_pEncoder;
+    // The sequence number of m_packets.front()
+    qint64 m_firstPacket;
+    std::deque<QByteArray> m_packets;
+    QList<QByteArray> m_headers;
+    bool m_headersComplete;
+    // The sequence number of the next packet for each instance
+    QHash<const EncoderShared*, qint64> m_nextPackets;
+};
+
+QMutex EncoderShared::Stream::s_streamsMutex;
+QHash<QString, std::weak_ptr<EncoderShared::Stream>> EncoderShared::Stream::s_streams;
+
+// static
+EncoderPointer EncoderShared::create(
+        EncoderSettingsPointer pSettings,
+        EncoderCallback* pCallback,
+        QSharedPointer<EngineNetworkStream> pNetworkStream) {
+    return std::make_shared<EncoderShared>(
+            std::move(pSettings), pCallback, std::move(pNetworkStream));
+}
+
+// static
+int EncoderShared::streamCount() {
+    QMutexLocker locker(&Stream::s_streamsMutex);
+    return Stream::s_streams.size();
+}
+
+EncoderShared::EncoderShared(
+        EncoderSettingsPointer pSettings,
+        EncoderCallback* pCallback,
+        QSharedPointer<EngineNetworkStream> pNetworkStream)
+        : m_pSettings(std::move(pSettings)),
+          m_pCallback(pCallback),
+          m_pNetworkStream(std::move(pNetworkStream)),
+          m_nextPacket(0) {
+    DEBUG_ASSERT(m_pSettings);
+    DEBUG_ASSERT(m_pCallback);
+    DEBUG_ASSERT(m_pNetworkStream);
+}
+
+EncoderShared::~EncoderShared() {
+    if (!m_pStream) {
+        return;
+    }
+    {
+        QMutexLocker streamLocker(&m_pStream->m_mutex);
+        m_pStream->m_nextPackets.remove(this);
+        m_pStream->releasePackets();
+    }
+    // Unregister the stream before it is destroyed
+    QMutexLocker locker(&Stream::s_streamsMutex);
+    if (m_pStream.use_count() == 1) {
+        Stream::s_streams.remove(m_pStream->m_key);
+    }
+    m_pStream.reset();
+}
+
+int EncoderShared::initEncoder(int samplerate, QString errorMessage) {
+    DEBUG_ASSERT(!m_pStream);
+    const QString key = streamKey(*m_pSettings, samplerate);
+    QMutexLocker locker(&Stream::s_streamsMutex);
+    m_pStream = Stream::s_streams.value(key).lock();
+    if (m_pStream) {
+        kLogger.debug()
+                << "Sharing encoder"
+                << key;
+        Counter("EncoderShared shared streams")++;
+    } else {
+        auto pStream = std::make_shared<Stream>(key, m_pSettings, m_pNetworkStream);
+        const int result = pStream->m_pEncoder->initEncoder(samplerate, errorMessage);
+        if (result < 0) {
+            return result;
+        }
+        if (!pStream->attachTap()) {
+            kLogger.warning()
+                    << "No output slot left for encoder"
+                    << key;
+            return -1;
+        }
+        kLogger.debug()
+                << "Created encoder"
+                << key;
+        Stream::s_streams.insert(key, pStream);
+        m_pStream = std::move(pStream);
+    }
+    locker.unlock();
+
+    // Start at the current position of the stream
+    QMutexLocker streamLocker(&m_pStream->m_mutex);
+    m_nextPacket = m_pStream->m_firstPacket +
+            static_cast<qint64>(m_pStream->m_packets.size());
+    m_pendingHeaders = m_pStream->m_headers;
+    m_pStream->m_nextPackets.insert(this, m_nextPacket);
+    return 0;
+}
+
+void EncoderShared::encodeBuffer(const CSAMPLE* samples, const int size) {
+    // The samples of the connection are subject to its own drift
+    // compensation and buffer handling. The stream is fed by its tap.
+    Q_UNUSED(samples);
+    Q_UNUSED(size);
+    VERIFY_OR_DEBUG_ASSERT(m_pStream) {
+        return;
+    }
+    QList<QByteArray> packets;
+    packets.swap(m_pendingHeaders);
+    {
+        QMutexLocker locker(&m_pStream->m_mutex);
+        m_pStream->encodePendingSamples();
+
+        if (m_nextPacket < m_pStream->m_firstPacket) {
+            kLogger.warning()
+                    << "Skipping"
+                    << m_pStream->m_firstPacket - m_nextPacket
+                    << "encoded packets";
+            m_nextPacket = m_pStream->m_firstPacket;
+        }
+        for (auto i = m_pStream->m_packets.begin() +
+                     (m_nextPacket - m_pStream->m_firstPacket);
+                i != m_pStream->m_packets.end();
+                ++i) {
+            packets.append(*i);
+        }
+        m_nextPacket = m_pStream->m_firstPacket +
+                static_cast<qint64>(m_pStream->m_packets.size());
+        m_pStream->m_nextPackets.insert(this, m_nextPacket);
+        m_pStream->releasePackets();
+    }
+    // The callback might block, e.g. while sending the data over the
+    // network. No locks must be held.
+    EncoderCallback* const pCallback = m_pCallback;
+    for (const auto& packet : qAsConst(packets)) {
+        pCallback->write(
+                nullptr,
+                reinterpret_cast<const unsigned char*>(packet.constData()),
+                0,
+                packet.size());
+    }
+}
+
+void EncoderShared::updateMetaData(const QString& artist, const QString& title, const QString& album) {
+    Q_UNUSED(artist);
+    Q_UNUSED(title);
+    Q_UNUSED(album);
+}
+
+void EncoderShared::flush() {
+}
+
+void EncoderShared::setEncoderSettings(const EncoderSettings& settings) {
+    Q_UNUSED(settings);
+    // The settings are passed on construction and can't be changed
+    DEBUG_ASSERT(!"Not supported");
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <QByteArray>
+#include <QList>
+#include <QSharedPointer>
+#include <QString>
+
+#include <memory>
+
+#include "encoder/encoder.h"
+
+class EngineNetworkStream;
+
+/// Encoder that shares a single encoding stream with all other
+/// instances for the same encoder settings and sample rate.
+///
+/// All broadcast connections that stream the master mix in the same
+/// format and quality use the same encoding stream. The stream is fed
+/// from a single tap, i.e. an output worker of the EngineNetworkStream
+/// with its own FIFO. The connections only decide when the encoded data
+/// is sent, but not what is encoded: Each sample that enters the tap
+/// is encoded exactly once, independent of the drift compensation,
+/// underflows and overflows of the individual connections. The encoded
+/// data is passed to the callbacks of all instances.
+///
+/// Ogg streams start with header pages. They are replayed to instances
+/// that have been created after the headers have been encoded.
+class EncoderShared : public Encoder {
+  public:
+    /// Creates an encoder that is not shared yet. Sharing starts with
+    /// initEncoder().
+    static EncoderPointer create(
+            EncoderSettingsPointer pSettings,
+            EncoderCallback* pCallback,
+            QSharedPointer<EngineNetworkStream> pNetworkStream);
+
+    EncoderShared(
+            EncoderSettingsPointer pSettings,
+            EncoderCallback* pCallback,
+            QSharedPointer<EngineNetworkStream> pNetworkStream);
+    ~EncoderShared() override;
+
+    /// Looks up the encoding stream for the settings and sample rate
+    /// or creates and initializes a new one together with its tap.
+    int initEncoder(int samplerate, QString errorMessage) override;
+    /// Encodes all samples that are pending in the tap of the stream.
+    /// Passes all encoded data that has not been passed before to the
+    /// callback of this instance. The samples of the caller are ignored,
+    /// they only pace the invocations.
+    void encodeBuffer(const CSAMPLE* samples, const int size) override;
+    /// Not supported. Metadata is sent per connection out-of-band.
+    void updateMetaData(const QString& artist, const QString& title, const QString& album) override;
+    /// The shared stream is flushed when the last instance is destroyed
+    void flush() override;
+    void setEncoderSettings(const EncoderSettings& settings) override;
+
+    /// The number of encoding streams that are currently in use
+    static int streamCount();
+
+  private:
+    class Stream;
+    class Tap;
+
+    EncoderSettingsPointer m_pSettings;
+    EncoderCallback* const m_pCallback;
+    const QSharedPointer<EngineNetworkStream> m_pNetworkStream;
+
+    std::shared_ptr<Stream> m_pStream;
+    // The sequence number of the next packet of the stream that
+    // needs to be passed to the callback
+    qint64 m_nextPacket;
+    // Ogg header pages of the stream that need to be passed to the
+    // callback before any other packet
+    QList<QByteArray> m_pendingHeaders;
+};
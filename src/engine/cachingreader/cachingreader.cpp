@@ -21,61 +21,49 @@ mixxx::Logger kLogger("CachingReader");
 // TODO() Do we suffer cache misses if we use an audio buffer of above 23 ms?
 const SINT kDefaultHintFrames = 1024;
 
-// With CachingReaderChunk::kFrames = 8192 each chunk consumes
-// 8192 frames * 2 channels/frame * 4-bytes per sample = 65 kB.
-//
-//     80 chunks ->  5120 KB =  5 MB
-//
-// Each deck (including sample decks) will use their own CachingReader.
-// Consequently the total memory required for all allocated chunks depends
-// on the number of decks. The amount of memory reserved for a single
-// CachingReader must be multiplied by the number of decks to calculate
-// the total amount!
-//
-// NOTE(uklotzde, 2019-09-05): Reduce this number to just few chunks
-// (kNumberOfCachedChunksInMemory = 1, 2, 3, ...) for testing purposes
-// to verify that the MRU/LRU cache works as expected. Even though
-// massive drop outs are expected to occur Mixxx should run reliably!
-const SINT kNumberOfCachedChunksInMemory = 80;
+// The maximum number of in-flight read requests to the worker
+const SINT kMaxChunkReadRequests = 20;
+
+// The worker sends a single status update per loaded or unloaded track.
+// The engine callback consumes them much faster than tracks are loaded.
+const SINT kMaxTrackStatusUpdates = 12;
 
 } // anonymous namespace
 
 CachingReader::CachingReader(QString group,
         UserSettingsPointer config)
         : m_pConfig(config),
-          // Limit the number of in-flight requests to the worker. This should
-          // prevent to overload the worker when it is not able to fetch those
-          // requests from the FIFO timely. Otherwise outdated requests pile up
-          // in the FIFO and it would take a long time to process them, just to
-          // discard the results that most likely have already become obsolete.
-          // TODO(XXX): Ideally the request FIFO would be implemented as a ring
-          // buffer, where new requests replace old requests when full. Those
-          // old requests need to be returned immediately to the CachingReader
-          // that must take ownership and free them!!!
-          m_chunkReadRequestFIFO(kNumberOfCachedChunksInMemory / 4),
-          // The capacity of the back channel must be equal to the number of
-          // allocated chunks, because the worker use writeBlocking(). Otherwise
-          // the worker could get stuck in a hot loop!!!
-          m_readerStatusUpdateFIFO(kNumberOfCachedChunksInMemory),
+          m_pChunkPool(CachingReaderChunkPool::instance(config)),
+          m_activity(Activity::Idle),
+          // Limit the number of in-flight requests to the worker. The worker
+          // fetches all requests from the FIFO before processing them ordered
+          // by priority and discards outdated requests that have not been
+          // hinted recently. Requests that did not fit into the FIFO will be
+          // submitted again with the next hints.
+          m_chunkReadRequestFIFO(kMaxChunkReadRequests),
+          // The capacity of the back channel must cover all updates that
+          // might be in flight, because the worker uses writeBlocking().
+          // Otherwise the worker could get stuck in a hot loop!!! Each
+          // in-flight read request returns a single update.
+          m_readerStatusUpdateFIFO(kMaxChunkReadRequests + kMaxTrackStatusUpdates),
+          // Writing never fails, because the worker never hands out more
+          // decoded tracks than it can get back
+          m_decodedTrackReleaseFIFO(CachingReaderWorker::kMaxDecodedTracks),
+          m_readPendingChunkCount(0),
           m_state(STATE_IDLE),
           m_mruCachingReaderChunk(nullptr),
           m_lruCachingReaderChunk(nullptr),
-          m_sampleBuffer(CachingReaderChunk::kSamples * kNumberOfCachedChunksInMemory),
-          m_worker(group, &m_chunkReadRequestFIFO, &m_readerStatusUpdateFIFO) {
-    m_allocatedCachingReaderChunks.reserve(kNumberOfCachedChunksInMemory);
-    // Divide up the allocated raw memory buffer into total_chunks
-    // chunks. Initialize each chunk to hold nothing and add it to the free
-    // list.
-    for (SINT i = 0; i < kNumberOfCachedChunksInMemory; ++i) {
-        CachingReaderChunkForOwner* c =
-                new CachingReaderChunkForOwner(
-                        mixxx::SampleBuffer::WritableSlice(
-                                m_sampleBuffer,
-                                CachingReaderChunk::kSamples * i,
-                                CachingReaderChunk::kSamples));
-        m_chunks.push_back(c);
-        m_freeChunks.push_back(c);
-    }
+          m_pDecodedTrack(nullptr),
+          m_hintEpoch(0),
+          m_worker(group,
+                  &m_chunkReadRequestFIFO,
+                  &m_readerStatusUpdateFIFO,
+                  &m_decodedTrackReleaseFIFO,
+                  &m_hintEpoch) {
+    m_pChunkPool->addReader();
+    // A reader never holds more chunks than available in the pool
+    m_chunks.reserve(m_pChunkPool->chunkCount());
+    m_allocatedCachingReaderChunks.reserve(m_pChunkPool->chunkCount());
 
     // Forward signals from worker
     connect(&m_worker, &CachingReaderWorker::trackLoading,
@@ -87,13 +75,44 @@ CachingReader::CachingReader(QString group,
     connect(&m_worker, &CachingReaderWorker::trackLoadFailed,
             this, &CachingReader::trackLoadFailed,
             Qt::DirectConnection);
-
-    m_worker.start(QThread::HighPriority);
 }
 
 CachingReader::~CachingReader() {
-    m_worker.quitWait();
-    qDeleteAll(m_chunks);
+    m_worker.stop();
+    // The worker has stopped and all chunks are returned to the pool,
+    // including those with pending read requests
+    for (const auto& pChunk : qAsConst(m_chunks)) {
+        if (pChunk->getState() == CachingReaderChunkForOwner::READ_PENDING) {
+            pChunk->takeFromWorker();
+        }
+        pChunk->removeFromList(
+                &m_mruCachingReaderChunk,
+                &m_lruCachingReaderChunk);
+        pChunk->free();
+        pChunk->setOwnerSlot(-1);
+        m_pChunkPool->releaseChunk(pChunk);
+    }
+    m_pChunkPool->removeReader(m_activity);
+}
+
+void CachingReader::releaseDecodedTrack() {
+    if (!m_pDecodedTrack) {
+        return;
+    }
+    // The memory must not be freed in the engine callback
+    VERIFY_OR_DEBUG_ASSERT(m_decodedTrackReleaseFIFO.write(&m_pDecodedTrack, 1) == 1) {
+        kLogger.warning() << "Failed to release decoded track";
+    }
+    m_pDecodedTrack = nullptr;
+    m_worker.workReady();
+}
+
+void CachingReader::setActivity(Activity activity) {
+    if (m_activity == activity) {
+        return;
+    }
+    m_pChunkPool->changeActivity(m_activity, activity);
+    m_activity = activity;
 }
 
 void CachingReader::freeChunkFromList(CachingReaderChunkForOwner* pChunk) {
@@ -101,7 +120,17 @@ void CachingReader::freeChunkFromList(CachingReaderChunkForOwner* pChunk) {
             &m_mruCachingReaderChunk,
             &m_lruCachingReaderChunk);
     pChunk->free();
-    m_freeChunks.push_back(pChunk);
+    // The order of the chunks doesn't matter and removing the last
+    // item does not reallocate the QVector
+    const int slot = pChunk->getOwnerSlot();
+    DEBUG_ASSERT(slot >= 0 && slot < m_chunks.size());
+    DEBUG_ASSERT(m_chunks[slot] == pChunk);
+    CachingReaderChunkForOwner* pLastChunk = m_chunks.last();
+    m_chunks[slot] = pLastChunk;
+    pLastChunk->setOwnerSlot(slot);
+    m_chunks.removeLast();
+    pChunk->setOwnerSlot(-1);
+    m_pChunkPool->releaseChunk(pChunk);
 }
 
 void CachingReader::freeChunk(CachingReaderChunkForOwner* pChunk) {
@@ -118,16 +147,17 @@ void CachingReader::freeChunk(CachingReaderChunkForOwner* pChunk) {
 }
 
 void CachingReader::freeAllChunks() {
-    for (const auto& pChunk: qAsConst(m_chunks)) {
+    // Iterate backwards, because freeing a chunk moves the last chunk
+    for (int i = m_chunks.size() - 1; i >= 0; --i) {
+        const auto pChunk = m_chunks[i];
         // We will receive CHUNK_READ_INVALID for all pending chunk reads
         // which should free the chunks individually.
         if (pChunk->getState() == CachingReaderChunkForOwner::READ_PENDING) {
             continue;
         }
 
-        if (pChunk->getState() != CachingReaderChunkForOwner::FREE) {
-            freeChunkFromList(pChunk);
-        }
+        DEBUG_ASSERT(pChunk->getState() != CachingReaderChunkForOwner::FREE);
+        freeChunkFromList(pChunk);
     }
     DEBUG_ASSERT(!m_mruCachingReaderChunk);
     DEBUG_ASSERT(!m_lruCachingReaderChunk);
@@ -135,12 +165,23 @@ void CachingReader::freeAllChunks() {
     m_allocatedCachingReaderChunks.clear();
 }
 
+void CachingReader::freeExcessChunks() {
+    const SINT quota = m_pChunkPool->quota(m_activity);
+    while (m_chunks.size() > quota && m_lruCachingReaderChunk) {
+        freeChunk(m_lruCachingReaderChunk);
+    }
+}
+
 CachingReaderChunkForOwner* CachingReader::allocateChunk(SINT chunkIndex) {
-    if (m_freeChunks.empty()) {
+    if (m_chunks.size() >= m_pChunkPool->quota(m_activity)) {
         return nullptr;
     }
-    CachingReaderChunkForOwner* pChunk = m_freeChunks.front();
-    m_freeChunks.pop_front();
+    CachingReaderChunkForOwner* pChunk = m_pChunkPool->tryAcquireChunk();
+    if (!pChunk) {
+        return nullptr;
+    }
+    pChunk->setOwnerSlot(m_chunks.size());
+    m_chunks.append(pChunk);
 
     pChunk->init(chunkIndex);
 
@@ -227,6 +268,8 @@ void CachingReader::process() {
         auto pChunk = update.takeFromWorker();
         if (pChunk) {
             // Result of a read request (with a chunk)
+            DEBUG_ASSERT(m_readPendingChunkCount > 0);
+            --m_readPendingChunkCount;
             DEBUG_ASSERT(atomicLoadRelaxed(m_state) != STATE_IDLE);
             DEBUG_ASSERT(
                     update.status == CHUNK_READ_SUCCESS ||
@@ -273,9 +316,12 @@ void CachingReader::process() {
                 }
                 // Reset the readable frame index range
                 m_readableFrameIndexRange = update.readableFrameIndexRange();
+                releaseDecodedTrack();
+                m_pDecodedTrack = update.decodedTrack();
                 m_state.storeRelease(STATE_TRACK_LOADED);
             } else {
                 DEBUG_ASSERT(update.status == TRACK_UNLOADED);
+                releaseDecodedTrack();
                 // This message could be processed later when a new
                 // track is already loading! In this case the TRACK_LOADED will
                 // be the very next status update.
@@ -419,8 +465,28 @@ CachingReader::ReadResult CachingReader::read(SINT startSample, SINT numSamples,
                 }
 
                 mixxx::IndexRange bufferedFrameIndexRange;
-                const CachingReaderChunkForOwner* const pChunk = lookupChunkAndFreshen(chunkIndex);
-                if (pChunk && (pChunk->getState() == CachingReaderChunkForOwner::READY)) {
+                const CachingReaderChunkForOwner* const pChunk =
+                        m_pDecodedTrack ? nullptr : lookupChunkAndFreshen(chunkIndex);
+                if (m_pDecodedTrack) {
+                    // Read directly from the decoded track without any chunks,
+                    // but limited to the current chunk index for consistency.
+                    const auto chunkFrameIndexRange = intersect(
+                            remainingFrameIndexRange,
+                            mixxx::IndexRange::forward(
+                                    chunkIndex * CachingReaderChunk::kFrames,
+                                    CachingReaderChunk::kFrames));
+                    if (reverse) {
+                        bufferedFrameIndexRange =
+                                m_pDecodedTrack->readBufferedSampleFramesReverse(
+                                        &buffer[samplesRemaining],
+                                        chunkFrameIndexRange);
+                    } else {
+                        bufferedFrameIndexRange =
+                                m_pDecodedTrack->readBufferedSampleFrames(
+                                        buffer,
+                                        chunkFrameIndexRange);
+                    }
+                } else if (pChunk && (pChunk->getState() == CachingReaderChunkForOwner::READY)) {
                     if (reverse) {
                         bufferedFrameIndexRange =
                                 pChunk->readBufferedSampleFramesReverse(
@@ -510,79 +576,123 @@ void CachingReader::hintAndMaybeWake(const HintVector& hintList) {
         return;
     }
 
+    // The quota might have been reduced since the last invocation,
+    // either by changing the activity of this or any other reader.
+    freeExcessChunks();
+
+    if (m_pDecodedTrack) {
+        // The whole track is already available in memory
+        return;
+    }
+
+    const quint32 hintEpoch = m_hintEpoch.fetchAndAddRelease(1) + 1;
+
     // For every chunk that the hints indicated, check if it is in the cache. If
     // any are not, then wake.
     bool shouldWake = false;
 
+    // Chunks that are needed imminently are allocated and requested first.
+    // Otherwise prefetch requests (i.e. for cue points) could occupy the
+    // limited capacity of the request FIFO or evict chunks around the
+    // play position.
     for (const auto& hint: hintList) {
-        SINT hintFrame = hint.frame;
-        SINT hintFrameCount = hint.frameCount;
-
-        // Handle some special length values
-        if (hintFrameCount == Hint::kFrameCountForward) {
-        	hintFrameCount = kDefaultHintFrames;
-        } else if (hintFrameCount == Hint::kFrameCountBackward) {
-        	hintFrame -= kDefaultHintFrames;
-        	hintFrameCount = kDefaultHintFrames;
-            if (hintFrame < 0) {
-            	hintFrameCount += hintFrame;
-                hintFrame = 0;
-            }
+        if (hint.priority < Hint::kPriorityPrefetch) {
+            shouldWake |= hintChunks(hint, hintEpoch);
         }
-
-        VERIFY_OR_DEBUG_ASSERT(hintFrameCount > 0) {
-            kLogger.warning() << "ERROR: Negative hint length. Ignoring.";
-            continue;
+    }
+    for (const auto& hint: hintList) {
+        if (hint.priority >= Hint::kPriorityPrefetch) {
+            shouldWake |= hintChunks(hint, hintEpoch);
         }
+    }
 
-        const auto readableFrameIndexRange = intersect(
-                m_readableFrameIndexRange,
-                mixxx::IndexRange::forward(hintFrame, hintFrameCount));
-        if (readableFrameIndexRange.empty()) {
-            continue;
+    // If there are chunks to be read, wake up.
+    if (shouldWake) {
+        m_worker.workReady();
+    }
+}
+
+bool CachingReader::hintChunks(const Hint& hint, quint32 hintEpoch) {
+    SINT hintFrame = hint.frame;
+    SINT hintFrameCount = hint.frameCount;
+
+    // Handle some special length values
+    if (hintFrameCount == Hint::kFrameCountForward) {
+        hintFrameCount = kDefaultHintFrames;
+    } else if (hintFrameCount == Hint::kFrameCountBackward) {
+        hintFrame -= kDefaultHintFrames;
+        hintFrameCount = kDefaultHintFrames;
+        if (hintFrame < 0) {
+            hintFrameCount += hintFrame;
+            hintFrame = 0;
         }
+    }
+
+    VERIFY_OR_DEBUG_ASSERT(hintFrameCount > 0) {
+        kLogger.warning() << "ERROR: Negative hint length. Ignoring.";
+        return false;
+    }
 
-        const int firstChunkIndex = CachingReaderChunk::indexForFrame(readableFrameIndexRange.start());
-        const int lastChunkIndex = CachingReaderChunk::indexForFrame(readableFrameIndexRange.end() - 1);
-        for (int chunkIndex = firstChunkIndex; chunkIndex <= lastChunkIndex; ++chunkIndex) {
-            CachingReaderChunkForOwner* pChunk = lookupChunk(chunkIndex);
+    const auto readableFrameIndexRange = intersect(
+            m_readableFrameIndexRange,
+            mixxx::IndexRange::forward(hintFrame, hintFrameCount));
+    if (readableFrameIndexRange.empty()) {
+        return false;
+    }
+
+    bool shouldWake = false;
+    const int firstChunkIndex = CachingReaderChunk::indexForFrame(readableFrameIndexRange.start());
+    const int lastChunkIndex = CachingReaderChunk::indexForFrame(readableFrameIndexRange.end() - 1);
+    for (int chunkIndex = firstChunkIndex; chunkIndex <= lastChunkIndex; ++chunkIndex) {
+        CachingReaderChunkForOwner* pChunk = lookupChunk(chunkIndex);
+        if (!pChunk) {
+            shouldWake = true;
+            if (m_readPendingChunkCount >= kMaxChunkReadRequests) {
+                // The chunk will be requested again with the next hints
+                // after the worker has returned some chunks
+                continue;
+            }
+            pChunk = allocateChunkExpireLRU(chunkIndex);
             if (!pChunk) {
-                shouldWake = true;
-                pChunk = allocateChunkExpireLRU(chunkIndex);
-                if (!pChunk) {
-                    kLogger.warning()
-                            << "Failed to allocate chunk"
-                            << chunkIndex
-                            << "for read request";
-                    continue;
-                }
-                // Do not insert the allocated chunk into the MRU/LRU list,
-                // because it will be handed over to the worker immediately
-                CachingReaderChunkReadRequest request;
-                request.giveToWorker(pChunk);
-                if (kLogger.traceEnabled()) {
-                    kLogger.trace()
-                            << "Requesting read of chunk"
-                            << request.chunk;
-                }
-                if (m_chunkReadRequestFIFO.write(&request, 1) != 1) {
-                    kLogger.warning()
-                            << "Failed to submit read request for chunk"
-                            << chunkIndex;
-                    // Revoke the chunk from the worker and free it
-                    pChunk->takeFromWorker();
-                    freeChunk(pChunk);
-                }
-            } else if (pChunk->getState() == CachingReaderChunkForOwner::READY) {
-                // This will cause the chunk to be 'freshened' in the cache. The
-                // chunk will be moved to the end of the LRU list.
-                freshenChunk(pChunk);
+                kLogger.warning()
+                        << "Failed to allocate chunk"
+                        << chunkIndex
+                        << "for read request";
+                continue;
+            }
+            pChunk->hint(hint.priority, hintEpoch);
+            // Do not insert the allocated chunk into the MRU/LRU list,
+            // because it will be handed over to the worker immediately
+            CachingReaderChunkReadRequest request;
+            request.giveToWorker(pChunk);
+            if (kLogger.traceEnabled()) {
+                kLogger.trace()
+                        << "Requesting read of chunk"
+                        << request.chunk
+                        << "with priority"
+                        << hint.priority;
             }
+            if (m_chunkReadRequestFIFO.write(&request, 1) != 1) {
+                kLogger.warning()
+                        << "Failed to submit read request for chunk"
+                        << chunkIndex;
+                // Revoke the chunk from the worker and free it
+                pChunk->takeFromWorker();
+                freeChunk(pChunk);
+            } else {
+                ++m_readPendingChunkCount;
+            }
+        } else if (pChunk->getState() == CachingReaderChunkForOwner::READY) {
+            // This will cause the chunk to be 'freshened' in the cache. The
+            // chunk will be moved to the end of the LRU list.
+            freshenChunk(pChunk);
+        } else {
+            DEBUG_ASSERT(pChunk->getState() == CachingReaderChunkForOwner::READ_PENDING);
+            // Prevent that the pending read request becomes stale and
+            // promote it if the chunk is needed more urgently now, e.g.
+            // after jumping to a hot cue that is still being prefetched.
+            pChunk->hint(hint.priority, hintEpoch);
         }
     }
-
-    // If there are chunks to be read, wake up.
-    if (shouldWake) {
-        m_worker.workReady();
-    }
+    return shouldWake;
 }
@@ -8,8 +8,9 @@
 #include <QList>
 #include <QVarLengthArray>
 #include <QVector>
-#include <list>
+#include <memory>
 
+#include "engine/cachingreader/cachingreaderchunkpool.h"
 #include "engine/cachingreader/cachingreaderworker.h"
 #include "engine/engineworker.h"
 #include "preferences/usersettings.h"
@@ -26,13 +27,16 @@ typedef struct Hint {
     // If a range of frames should be present, use frameCount to indicate that the
     // range (frame, frame + frameCount) should be present in memory.
     SINT frameCount;
-    // Currently unused -- but in the future could be used to prioritize certain
-    // hints over others. A priority of 1 is the highest priority and should be
-    // used for samples that will be read imminently. Hints for samples that
-    // have the potential to be read (i.e. a cue point) should be issued with
-    // priority >10.
+    // Used to prioritize certain hints over others. A priority of 1 is the
+    // highest priority and should be used for samples that will be read
+    // imminently. Hints for samples that have the potential to be read
+    // (i.e. a cue point) should be issued with priority >= 10
+    // (kPriorityPrefetch). Those are only read in the background after
+    // all chunks with a higher priority are available.
     int priority;
 
+    static constexpr int kPriorityPrefetch = 10;
+
     // for the default frame count in forward direction
     static constexpr SINT kFrameCountForward = 0;
     static constexpr SINT kFrameCountBackward = -1;
@@ -55,10 +59,14 @@ typedef QVarLengthArray<Hint, 512> HintVector;
 
 // CachingReader provides a layer on top of a SoundSource for reading samples
 // from a file. Since we cannot do file I/O in the audio callback thread
-// CachingReader and CachingReaderWorker (a worker thread) work in concert to
-// read and decode relevant sections of a track in a background thread. The
+// CachingReader and CachingReaderWorker (run by the EngineWorkerScheduler) work
+// in concert to read and decode relevant sections of a track in a background
+// thread. The
 // decoded chunks are kept in a cache by CachingReader with a
-// least-recently-used (LRU) eviction policy. CachingReader exposes a method for
+// least-recently-used (LRU) eviction policy. The memory for the chunks is
+// borrowed from a CachingReaderChunkPool that is shared by all readers. The
+// number of chunks a reader may hold depends on its activity (see
+// setActivity). CachingReader exposes a method for
 // indicating which chunks should be kept fresh in the cache (see
 // hintAndMaybeWake). For example, the chunks around the playhead, the hotcue
 // positions, and loop points are all portions of the track that the user is
@@ -111,6 +119,21 @@ class CachingReader : public QObject {
         m_worker.setScheduler(pScheduler);
     }
 
+    typedef CachingReaderChunkPool::Activity Activity;
+
+    // Tracks that are not longer than the given duration are decoded as a
+    // whole and kept in memory while loaded. Identical files that are
+    // loaded by multiple readers share the decoded data. Takes effect
+    // when loading the next track.
+    void setWholeTrackCacheMaxDuration(mixxx::Duration maxDuration) {
+        m_worker.setWholeTrackCacheMaxDuration(maxDuration);
+    }
+
+    // Adjusts the share of the global chunk pool for this reader. Excess
+    // chunks are returned to the pool with the next call of process().
+    // Must only be called from the engine callback.
+    void setActivity(Activity activity);
+
   signals:
     // Emitted once a new track is loaded and ready to be read from.
     void trackLoading();
@@ -120,10 +143,19 @@ class CachingReader : public QObject {
   private:
     const UserSettingsPointer m_pConfig;
 
+    // The global pool that all chunks are borrowed from
+    const std::shared_ptr<CachingReaderChunkPool> m_pChunkPool;
+    Activity m_activity;
+
     // Thread-safe FIFOs for communication between the engine callback and
     // reader thread.
     FIFO<CachingReaderChunkReadRequest> m_chunkReadRequestFIFO;
     FIFO<ReaderStatusUpdate> m_readerStatusUpdateFIFO;
+    FIFO<const CachingReaderDecodedTrack*> m_decodedTrackReleaseFIFO;
+
+    // The number of chunks that have been given to the worker for reading.
+    // The worker returns each of them with a status update.
+    SINT m_readPendingChunkCount;
 
     // Looks for the provided chunk number in the index of in-memory chunks and
     // returns it if it is present. If not, returns nullptr. If it is present then
@@ -137,19 +169,32 @@ class CachingReader : public QObject {
     // Moves the provided chunk to the MRU position.
     void freshenChunk(CachingReaderChunkForOwner* pChunk);
 
-    // Returns a CachingReaderChunk to the free list
+    // Returns a CachingReaderChunk to the pool
     void freeChunk(CachingReaderChunkForOwner* pChunk);
     void freeChunkFromList(CachingReaderChunkForOwner* pChunk);
 
-    // Returns all allocated chunks to the free list
+    // Returns all allocated chunks to the pool
     void freeAllChunks();
 
-    // Gets a chunk from the free list. Returns nullptr if none available.
+    // Returns the decoded track to the worker
+    void releaseDecodedTrack();
+
+    // Returns the least recently used chunks to the pool until the
+    // quota for the current activity is no longer exceeded.
+    void freeExcessChunks();
+
+    // Gets a chunk from the pool. Returns nullptr if none available or
+    // if the quota of this reader has been exhausted.
     CachingReaderChunkForOwner* allocateChunk(SINT chunkIndex);
 
-    // Gets a chunk from the free list, frees the LRU CachingReaderChunk if none available.
+    // Gets a chunk from the pool, frees the LRU CachingReaderChunk if none available.
     CachingReaderChunkForOwner* allocateChunkExpireLRU(SINT chunkIndex);
 
+    // Requests all chunks of a single hint that are not available yet
+    // and freshens those that are. Returns true if the worker needs to
+    // be woken up.
+    bool hintChunks(const Hint& hint, quint32 hintEpoch);
+
     enum State {
         STATE_IDLE,
         STATE_TRACK_LOADING,
@@ -158,13 +203,11 @@ class CachingReader : public QObject {
     };
     QAtomicInt m_state;
 
-    // Keeps track of all CachingReaderChunks we've allocated.
+    // Keeps track of all CachingReaderChunks we've borrowed from the pool.
+    // The capacity is reserved upfront to avoid allocations in the engine
+    // callback.
     QVector<CachingReaderChunkForOwner*> m_chunks;
 
-    // List of free chunks. Linked list so that we have constant time insertions
-    // and deletions. Iteration is not necessary.
-    std::list<CachingReaderChunkForOwner*> m_freeChunks;
-
     // Keeps track of what CachingReaderChunks we've allocated and indexes them based on what
     // chunk number they are allocated to.
     QHash<int, CachingReaderChunkForOwner*> m_allocatedCachingReaderChunks;
@@ -173,11 +216,17 @@ class CachingReader : public QObject {
     CachingReaderChunkForOwner* m_mruCachingReaderChunk;
     CachingReaderChunkForOwner* m_lruCachingReaderChunk;
 
-    // The raw memory buffer which is divided up into chunks.
-    mixxx::SampleBuffer m_sampleBuffer;
-
     // The readable frame index range as reported by the worker.
     mixxx::IndexRange m_readableFrameIndexRange;
 
+    // The whole decoded track if available. Owned by the worker until
+    // released by the reader. No chunks are needed while it is available.
+    const CachingReaderDecodedTrack* m_pDecodedTrack;
+
+    // Incremented on every invocation of hintAndMaybeWake(). The worker
+    // discards read requests for chunks that have not been hinted
+    // recently.
+    QAtomicInteger<quint32> m_hintEpoch;
+
     CachingReaderWorker m_worker;
 };
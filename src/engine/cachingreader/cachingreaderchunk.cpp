@@ -2,6 +2,8 @@
 
 #include <QtDebug>
 
+#include <limits>
+
 #include "sources/audiosourcestereoproxy.h"
 #include "engine/engine.h"
 #include "util/math.h"
@@ -15,6 +17,9 @@ mixxx::Logger kLogger("CachingReaderChunk");
 
 const SINT kInvalidChunkIndex = -1;
 
+// Lower than any priority of an actual hint
+const int kNoHintPriority = std::numeric_limits<int>::max();
+
 } // anonymous namespace
 
 // One chunk should contain 1/2 - 1/4th of a second of audio.
@@ -33,6 +38,8 @@ const SINT CachingReaderChunk::kSamples =
 CachingReaderChunk::CachingReaderChunk(
         mixxx::SampleBuffer::WritableSlice sampleBuffer)
         : m_index(kInvalidChunkIndex),
+          m_hintPriority(kNoHintPriority),
+          m_hintEpoch(0),
           m_sampleBuffer(std::move(sampleBuffer)) {
     DEBUG_ASSERT(m_sampleBuffer.length() == kSamples);
 }
@@ -40,6 +47,7 @@ CachingReaderChunk::CachingReaderChunk(
 void CachingReaderChunk::init(SINT index) {
     DEBUG_ASSERT(m_index == kInvalidChunkIndex || index == kInvalidChunkIndex);
     m_index = index;
+    setHint(kNoHintPriority, 0);
     m_bufferedSampleFrames.frameIndexRange() = mixxx::IndexRange();
 }
 
@@ -123,6 +131,7 @@ CachingReaderChunkForOwner::CachingReaderChunkForOwner(
         mixxx::SampleBuffer::WritableSlice sampleBuffer)
         : CachingReaderChunk(std::move(sampleBuffer)),
           m_state(FREE),
+          m_ownerSlot(-1),
           m_pPrev(nullptr),
           m_pNext(nullptr) {
 }
@@ -1,7 +1,11 @@
 #ifndef ENGINE_CACHINGREADERCHUNK_H
 #define ENGINE_CACHINGREADERCHUNK_H
 
+#include <QAtomicInteger>
+
 #include "sources/audiosource.h"
+#include "util/compatibility.h"
+#include "util/math.h"
 
 // A Chunk is a memory-resident section of audio that has been cached.
 // Each chunk holds a fixed number kFrames of frames with samples for
@@ -10,7 +14,9 @@
 // The class is not thread-safe although it is shared between CachingReader
 // and CachingReaderWorker! A lock-free FIFO ensures that only a single
 // thread has exclusive access on each chunk. This abstract base class
-// is available for both the worker thread and the cache.
+// is available for both the worker thread and the cache. The only
+// exception are the hint priority and hint epoch that are updated by
+// the cache while a read request for the chunk is pending.
 //
 // This is the common (abstract) base class for both the cache (as the owner)
 // and the worker.
@@ -64,6 +70,17 @@ public:
             CSAMPLE* reverseSampleBuffer,
             const mixxx::IndexRange& frameIndexRange) const;
 
+    // The (highest) priority of the hints that requested this chunk.
+    // Lower values mean higher priority, see Hint::priority.
+    int getHintPriority() const {
+        return atomicLoadRelaxed(m_hintPriority);
+    }
+    // The epoch of the most recent hint that requested this chunk.
+    // Used by the worker to detect stale read requests.
+    quint32 getHintEpoch() const {
+        return atomicLoadRelaxed(m_hintEpoch);
+    }
+
 protected:
     explicit CachingReaderChunk(
             mixxx::SampleBuffer::WritableSlice sampleBuffer);
@@ -71,6 +88,11 @@ protected:
 
     void init(SINT index);
 
+    void setHint(int priority, quint32 epoch) {
+        atomicStoreRelaxed(m_hintPriority, priority);
+        atomicStoreRelaxed(m_hintEpoch, epoch);
+    }
+
 private:
     SINT frameIndexOffset() const {
         return m_index * kFrames;
@@ -78,6 +100,10 @@ private:
 
     SINT m_index;
 
+    // Might be modified by the owner while the worker is in control
+    QAtomicInteger<int> m_hintPriority;
+    QAtomicInteger<quint32> m_hintEpoch;
+
     // The worker thread will fill the sample buffer and
     // set the corresponding frame index range.
     mixxx::SampleBuffer::WritableSlice m_sampleBuffer;
@@ -96,6 +122,13 @@ public:
     void init(SINT index);
     void free();
 
+    // Updates the hint priority and epoch. The priority is only raised
+    // and never lowered until the chunk has been read. This is safe while
+    // the worker is in control.
+    void hint(int priority, quint32 epoch) {
+        setHint(math_min(priority, getHintPriority()), epoch);
+    }
+
     enum State {
         FREE,
         READY,
@@ -136,8 +169,18 @@ public:
             CachingReaderChunkForOwner** ppHead,
             CachingReaderChunkForOwner** ppTail);
 
+    // The position in the owner's array of borrowed chunks for
+    // removing the chunk in constant time, -1 if not borrowed.
+    int getOwnerSlot() const {
+        return m_ownerSlot;
+    }
+    void setOwnerSlot(int ownerSlot) {
+        m_ownerSlot = ownerSlot;
+    }
+
 private:
     State m_state;
+    int m_ownerSlot;
 
     CachingReaderChunkForOwner* m_pPrev; // previous item in double-linked list
     CachingReaderChunkForOwner* m_pNext; // next item in double-linked list
@@ -0,0 +1,175 @@
+#include "engine/cachingreader/cachingreaderchunkpool.h"
+
+#include <mutex>
+
+#include "util/logger.h"
+#include "util/math.h"
+
+namespace {
+
+mixxx::Logger kLogger("CachingReaderChunkPool");
+
+const ConfigKey kMemoryBudgetConfigKey("[Master]", "CachingReaderMemoryMB");
+
+// With CachingReaderChunk::kFrames = 8192 each chunk consumes
+// 8192 frames * 2 channels/frame * 4-bytes per sample = 64 KiB.
+//
+//     64 MiB -> 1024 chunks
+//
+// This is shared by all decks, samplers and preview decks. The previous
+// fixed amount of 80 chunks (5 MiB) per reader resulted in 45 MiB for the
+// default configuration with 4 decks, 4 samplers and 1 preview deck.
+const int kDefaultMemoryBudgetMB = 64;
+const int kMinMemoryBudgetMB = 8;
+
+// Each reader is guaranteed to get at least this number of chunks,
+// even if idle. This is enough for the chunks around the play
+// position and the main cue. A reader still works reliably with
+// this few chunks, only with more drop outs when seeking.
+const SINT kMinChunksPerReader = 4;
+
+std::mutex s_instanceMutex;
+std::weak_ptr<CachingReaderChunkPool> s_instance;
+
+} // anonymous namespace
+
+class CachingReaderChunkPool::PooledChunk : public CachingReaderChunkForOwner {
+  public:
+    PooledChunk(
+            mixxx::SampleBuffer::WritableSlice sampleBuffer,
+            SINT poolIndex)
+            : CachingReaderChunkForOwner(std::move(sampleBuffer)),
+              m_poolIndex(poolIndex) {
+    }
+    ~PooledChunk() override = default;
+
+    SINT poolIndex() const {
+        return m_poolIndex;
+    }
+
+  private:
+    const SINT m_poolIndex;
+};
+
+// static
+std::shared_ptr<CachingReaderChunkPool> CachingReaderChunkPool::instance(
+        const UserSettingsPointer& pConfig) {
+    std::lock_guard<std::mutex> lock(s_instanceMutex);
+    auto pInstance = s_instance.lock();
+    if (!pInstance) {
+        int memoryBudgetMB = kDefaultMemoryBudgetMB;
+        if (pConfig) {
+            memoryBudgetMB = math_max(kMinMemoryBudgetMB,
+                    pConfig->getValue(kMemoryBudgetConfigKey, kDefaultMemoryBudgetMB));
+        }
+        const SINT chunkBytes = CachingReaderChunk::kSamples * sizeof(CSAMPLE);
+        const SINT chunkCount = (SINT(memoryBudgetMB) << 20) / chunkBytes;
+        kLogger.info()
+                << "Allocating"
+                << chunkCount
+                << "chunks with"
+                << memoryBudgetMB
+                << "MiB";
+        pInstance = std::make_shared<CachingReaderChunkPool>(chunkCount);
+        s_instance = pInstance;
+    }
+    return pInstance;
+}
+
+CachingReaderChunkPool::CachingReaderChunkPool(SINT chunkCount)
+        : m_sampleBuffer(CachingReaderChunk::kSamples * chunkCount),
+          m_chunkInUse(std::make_unique<std::atomic<bool>[]>(chunkCount)),
+          m_nextChunk(0),
+          m_readerCount(0),
+          m_totalWeight(0) {
+    DEBUG_ASSERT(chunkCount > 0);
+    // Divide up the allocated raw memory buffer into chunkCount
+    // chunks. Initialize each chunk to hold nothing.
+    m_chunks.reserve(chunkCount);
+    for (SINT i = 0; i < chunkCount; ++i) {
+        m_chunks.push_back(std::make_unique<PooledChunk>(
+                mixxx::SampleBuffer::WritableSlice(
+                        m_sampleBuffer,
+                        CachingReaderChunk::kSamples * i,
+                        CachingReaderChunk::kSamples),
+                i));
+        m_chunkInUse[i].store(false, std::memory_order_relaxed);
+    }
+}
+
+CachingReaderChunkPool::~CachingReaderChunkPool() {
+    DEBUG_ASSERT(m_readerCount.load() == 0);
+}
+
+CachingReaderChunkForOwner* CachingReaderChunkPool::tryAcquireChunk() {
+    const SINT chunkCount = this->chunkCount();
+    const SINT firstChunk = m_nextChunk.load(std::memory_order_relaxed);
+    for (SINT i = 0; i < chunkCount; ++i) {
+        const SINT chunk = (firstChunk + i) % chunkCount;
+        // Test before test-and-set to avoid writing into cache lines
+        // of chunks that are in use
+        if (m_chunkInUse[chunk].load(std::memory_order_relaxed)) {
+            continue;
+        }
+        if (!m_chunkInUse[chunk].exchange(true, std::memory_order_acquire)) {
+            m_nextChunk.store((chunk + 1) % chunkCount, std::memory_order_relaxed);
+            return m_chunks[chunk].get();
+        }
+    }
+    return nullptr;
+}
+
+void CachingReaderChunkPool::releaseChunk(CachingReaderChunkForOwner* pChunk) {
+    DEBUG_ASSERT(pChunk);
+    DEBUG_ASSERT(pChunk->getState() == CachingReaderChunkForOwner::FREE);
+    DEBUG_ASSERT(dynamic_cast<PooledChunk*>(pChunk));
+    const SINT chunk = static_cast<PooledChunk*>(pChunk)->poolIndex();
+    DEBUG_ASSERT(m_chunks[chunk].get() == pChunk);
+    DEBUG_ASSERT(m_chunkInUse[chunk].load());
+    m_chunkInUse[chunk].store(false, std::memory_order_release);
+}
+
+// static
+int CachingReaderChunkPool::weight(Activity activity) {
+    // Scratching and looping around the play position need more
+    // chunks than linear playback, because the chunks that have
+    // been read recently will be read again soon.
+    switch (activity) {
+    case Activity::Idle:
+        return 1;
+    case Activity::Playing:
+        return 8;
+    case Activity::Scratching:
+        return 16;
+    }
+    DEBUG_ASSERT(!"unreachable");
+    return 1;
+}
+
+void CachingReaderChunkPool::addReader() {
+    m_readerCount.fetch_add(1);
+    m_totalWeight.fetch_add(weight(Activity::Idle));
+}
+
+void CachingReaderChunkPool::removeReader(Activity activity) {
+    m_totalWeight.fetch_sub(weight(activity));
+    m_readerCount.fetch_sub(1);
+}
+
+void CachingReaderChunkPool::changeActivity(
+        Activity oldActivity, Activity newActivity) {
+    m_totalWeight.fetch_add(weight(newActivity) - weight(oldActivity));
+}
+
+SINT CachingReaderChunkPool::quota(Activity activity) const {
+    const SINT readerCount = m_readerCount.load(std::memory_order_relaxed);
+    const int totalWeight = m_totalWeight.load(std::memory_order_relaxed);
+    const SINT reservedChunks = readerCount * kMinChunksPerReader;
+    if (totalWeight <= 0 || reservedChunks >= chunkCount()) {
+        return kMinChunksPerReader;
+    }
+    // The remaining chunks are distributed proportionally to the
+    // weights of all readers
+    return kMinChunksPerReader +
+            (chunkCount() - reservedChunks) * weight(activity) / totalWeight;
+}
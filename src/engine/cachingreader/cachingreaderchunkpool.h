@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "engine/cachingreader/cachingreaderchunk.h"
+#include "preferences/usersettings.h"
+#include "util/samplebuffer.h"
+
+// A global pool of chunks that is shared by all CachingReaders. The total
+// amount of memory is limited by a configurable budget. Each reader borrows
+// chunks from the pool up to a quota that depends on its current activity,
+// i.e. playing or scratching decks get a larger share than idle samplers.
+//
+// Acquiring and releasing chunks is lock-free and might be invoked from
+// multiple engine threads concurrently.
+class CachingReaderChunkPool final {
+  public:
+    // The relative share of the budget that a reader is entitled to
+    enum class Activity {
+        Idle,
+        Playing,
+        Scratching,
+    };
+
+    // Returns the pool that is shared by all readers and creates it
+    // on first use. The pool is destroyed after the last reader has
+    // released its reference.
+    static std::shared_ptr<CachingReaderChunkPool> instance(
+            const UserSettingsPointer& pConfig);
+
+    explicit CachingReaderChunkPool(SINT chunkCount);
+    ~CachingReaderChunkPool();
+
+    SINT chunkCount() const {
+        return static_cast<SINT>(m_chunks.size());
+    }
+
+    // Returns nullptr if all chunks are in use. RT-safe.
+    CachingReaderChunkForOwner* tryAcquireChunk();
+    // Returns a free'd chunk to the pool. RT-safe.
+    void releaseChunk(CachingReaderChunkForOwner* pChunk);
+
+    // Registration of readers. The initial activity is Idle.
+    void addReader();
+    void removeReader(Activity activity);
+    void changeActivity(Activity oldActivity, Activity newActivity);
+
+    // The maximum number of chunks that a reader with the given activity
+    // should hold. A reader might temporarily exceed its quota after the
+    // activity of other readers has changed. RT-safe.
+    SINT quota(Activity activity) const;
+
+  private:
+    class PooledChunk;
+
+    static int weight(Activity activity);
+
+    mixxx::SampleBuffer m_sampleBuffer;
+    std::vector<std::unique_ptr<PooledChunk>> m_chunks;
+    // One flag per chunk
+    std::unique_ptr<std::atomic<bool>[]> m_chunkInUse;
+    // Start index for the next search of a free chunk
+    std::atomic<SINT> m_nextChunk;
+
+    std::atomic<int> m_readerCount;
+    std::atomic<int> m_totalWeight;
+};
@@ -0,0 +1,191 @@
+#include "engine/cachingreader/cachingreaderdecodedtrack.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+
+#include "engine/cachingreader/cachingreaderchunk.h"
+#include "sources/audiosourcestereoproxy.h"
+#include "util/logger.h"
+#include "util/sample.h"
+
+namespace {
+
+mixxx::Logger kLogger("CachingReaderDecodedTrack");
+
+// All decoded tracks that are currently in use by any reader,
+// indexed by their location
+QMutex s_decodedTracksMutex;
+QHash<QString, std::weak_ptr<const CachingReaderDecodedTrack>> s_decodedTracks;
+
+// Returns the shared instance if it covers all frames of the audio
+// source. The caller must hold s_decodedTracksMutex.
+std::shared_ptr<const CachingReaderDecodedTrack> lookup(
+        const QString& location,
+        const mixxx::AudioSourcePointer& pAudioSource) {
+    auto pDecodedTrack = s_decodedTracks.value(location).lock();
+    if (pDecodedTrack &&
+            pDecodedTrack->frameIndexRange() <= pAudioSource->frameIndexRange()) {
+        return pDecodedTrack;
+    }
+    return nullptr;
+}
+
+} // anonymous namespace
+
+// static
+std::shared_ptr<const CachingReaderDecodedTrack> CachingReaderDecodedTrack::lookupOrDecode(
+        const TrackPointer& pTrack,
+        const mixxx::AudioSourcePointer& pAudioSource,
+        mixxx::SampleBuffer::WritableSlice tempReadBuffer) {
+    DEBUG_ASSERT(pTrack);
+    DEBUG_ASSERT(pAudioSource);
+    const QString location = pTrack->getLocation();
+    {
+        QMutexLocker locked(&s_decodedTracksMutex);
+        auto pDecodedTrack = lookup(location, pAudioSource);
+        if (pDecodedTrack) {
+            if (kLogger.debugEnabled()) {
+                kLogger.debug()
+                        << "Sharing decoded track"
+                        << location;
+            }
+            return pDecodedTrack;
+        }
+    }
+    // Decode without holding the lock. Other workers are free to
+    // load different tracks in the meantime.
+    auto pDecodedTrack = std::shared_ptr<const CachingReaderDecodedTrack>(
+            new CachingReaderDecodedTrack(pAudioSource, std::move(tempReadBuffer)));
+    if (pDecodedTrack->frameIndexRange().empty()) {
+        kLogger.warning()
+                << "Failed to decode track"
+                << location;
+        return nullptr;
+    }
+    QMutexLocker locked(&s_decodedTracksMutex);
+    // Another worker might have decoded the same file concurrently,
+    // only a single instance is shared
+    auto pSharedDecodedTrack = lookup(location, pAudioSource);
+    if (pSharedDecodedTrack) {
+        return pSharedDecodedTrack;
+    }
+    // Purge all expired entries while we are at it
+    auto i = s_decodedTracks.begin();
+    while (i != s_decodedTracks.end()) {
+        if (i.value().expired()) {
+            i = s_decodedTracks.erase(i);
+        } else {
+            ++i;
+        }
+    }
+    s_decodedTracks.insert(location, pDecodedTrack);
+    return pDecodedTrack;
+}
+
+CachingReaderDecodedTrack::CachingReaderDecodedTrack(
+        const mixxx::AudioSourcePointer& pAudioSource,
+        mixxx::SampleBuffer::WritableSlice tempReadBuffer)
+        : m_sampleBuffer(CachingReaderChunk::frames2samples(
+                  pAudioSource->frameLength())),
+          m_frameIndexRange(mixxx::IndexRange::forward(
+                  pAudioSource->frameIndexMin(), 0)) {
+    const SINT maxReadFrames =
+            pAudioSource->getSignalInfo().samples2frames(
+                    tempReadBuffer.length());
+    DEBUG_ASSERT(maxReadFrames > 0);
+    mixxx::AudioSourceStereoProxy audioSourceProxy(
+            pAudioSource,
+            std::move(tempReadBuffer));
+    DEBUG_ASSERT(
+            audioSourceProxy.getSignalInfo().getChannelCount() ==
+            CachingReaderChunk::kChannels);
+    // The decoded sample frames are stored contiguously. Decoding
+    // stops at the first gap, i.e. if fewer frames than requested
+    // are available.
+    while (m_frameIndexRange.end() < pAudioSource->frameIndexMax()) {
+        const auto writableFrameIndexRange =
+                mixxx::IndexRange::forward(
+                        m_frameIndexRange.end(),
+                        math_min(maxReadFrames,
+                                pAudioSource->frameIndexMax() - m_frameIndexRange.end()));
+        CSAMPLE* const pWritableData =
+                m_sampleBuffer.data(CachingReaderChunk::frames2samples(
+                        m_frameIndexRange.length()));
+        const auto readableSampleFrames =
+                audioSourceProxy.readSampleFrames(
+                        mixxx::WritableSampleFrames(
+                                writableFrameIndexRange,
+                                mixxx::SampleBuffer::WritableSlice(
+                                        pWritableData,
+                                        CachingReaderChunk::frames2samples(
+                                                writableFrameIndexRange.length()))));
+        const auto readableFrameIndexRange =
+                readableSampleFrames.frameIndexRange();
+        if (readableFrameIndexRange.empty() ||
+                readableFrameIndexRange.start() != writableFrameIndexRange.start()) {
+            break;
+        }
+        if (readableSampleFrames.readableData() != pWritableData) {
+            SampleUtil::copy(
+                    pWritableData,
+                    readableSampleFrames.readableData(),
+                    readableSampleFrames.readableLength());
+        }
+        m_frameIndexRange.growBack(readableFrameIndexRange.length());
+        if (readableFrameIndexRange != writableFrameIndexRange) {
+            break;
+        }
+    }
+    if (m_frameIndexRange.end() < pAudioSource->frameIndexMax()) {
+        kLogger.warning()
+                << "Failed to decode sample frames"
+                << mixxx::IndexRange::between(
+                           m_frameIndexRange.end(),
+                           pAudioSource->frameIndexMax());
+    }
+}
+
+mixxx::IndexRange CachingReaderDecodedTrack::readBufferedSampleFrames(
+        CSAMPLE* sampleBuffer,
+        const mixxx::IndexRange& frameIndexRange) const {
+    const auto copyableFrameIndexRange =
+            intersect(frameIndexRange, m_frameIndexRange);
+    if (!copyableFrameIndexRange.empty()) {
+        const SINT dstSampleOffset =
+                CachingReaderChunk::frames2samples(
+                        copyableFrameIndexRange.start() - frameIndexRange.start());
+        const SINT srcSampleOffset =
+                CachingReaderChunk::frames2samples(
+                        copyableFrameIndexRange.start() - m_frameIndexRange.start());
+        const SINT sampleCount =
+                CachingReaderChunk::frames2samples(copyableFrameIndexRange.length());
+        SampleUtil::copy(
+                sampleBuffer + dstSampleOffset,
+                m_sampleBuffer.data(srcSampleOffset),
+                sampleCount);
+    }
+    return copyableFrameIndexRange;
+}
+
+mixxx::IndexRange CachingReaderDecodedTrack::readBufferedSampleFramesReverse(
+        CSAMPLE* reverseSampleBuffer,
+        const mixxx::IndexRange& frameIndexRange) const {
+    const auto copyableFrameIndexRange =
+            intersect(frameIndexRange, m_frameIndexRange);
+    if (!copyableFrameIndexRange.empty()) {
+        const SINT dstSampleOffset =
+                CachingReaderChunk::frames2samples(
+                        copyableFrameIndexRange.start() - frameIndexRange.start());
+        const SINT srcSampleOffset =
+                CachingReaderChunk::frames2samples(
+                        copyableFrameIndexRange.start() - m_frameIndexRange.start());
+        const SINT sampleCount =
+                CachingReaderChunk::frames2samples(copyableFrameIndexRange.length());
+        SampleUtil::copyReverse(
+                reverseSampleBuffer - dstSampleOffset - sampleCount,
+                m_sampleBuffer.data(srcSampleOffset),
+                sampleCount);
+    }
+    return copyableFrameIndexRange;
+}
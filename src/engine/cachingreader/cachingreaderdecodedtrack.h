@@ -0,0 +1,53 @@
+#pragma once
+
+#include <memory>
+
+#include "sources/audiosource.h"
+#include "track/track.h"
+#include "util/samplebuffer.h"
+
+// The decoded stereo sample data of a whole track that is kept in memory.
+// Used by CachingReader for short samples instead of reading chunks on
+// demand.
+//
+// Instances are immutable after decoding and shared read-only between
+// all readers that have loaded the same file, e.g. the same one-shot
+// sample in multiple sampler decks.
+class CachingReaderDecodedTrack final {
+  public:
+    // Returns the shared instance for the track's file if it has already
+    // been decoded by any other reader. Otherwise all available sample
+    // frames are decoded from the audio source. Must not be called from
+    // the engine callback!
+    static std::shared_ptr<const CachingReaderDecodedTrack> lookupOrDecode(
+            const TrackPointer& pTrack,
+            const mixxx::AudioSourcePointer& pAudioSource,
+            mixxx::SampleBuffer::WritableSlice tempReadBuffer);
+
+    CachingReaderDecodedTrack(
+            const CachingReaderDecodedTrack&) = delete;
+    CachingReaderDecodedTrack(
+            CachingReaderDecodedTrack&&) = delete;
+
+    // The decoded frames, might be shorter than the range offered by the
+    // audio source if decoding failed
+    const mixxx::IndexRange& frameIndexRange() const {
+        return m_frameIndexRange;
+    }
+
+    // Same semantics as the corresponding functions of CachingReaderChunk
+    mixxx::IndexRange readBufferedSampleFrames(
+            CSAMPLE* sampleBuffer,
+            const mixxx::IndexRange& frameIndexRange) const;
+    mixxx::IndexRange readBufferedSampleFramesReverse(
+            CSAMPLE* reverseSampleBuffer,
+            const mixxx::IndexRange& frameIndexRange) const;
+
+  private:
+    CachingReaderDecodedTrack(
+            const mixxx::AudioSourcePointer& pAudioSource,
+            mixxx::SampleBuffer::WritableSlice tempReadBuffer);
+
+    mixxx::SampleBuffer m_sampleBuffer;
+    mixxx::IndexRange m_frameIndexRange;
+};
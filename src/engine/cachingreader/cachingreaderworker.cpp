@@ -2,6 +2,8 @@
 #include <QFileInfo>
 #include <QMutexLocker>
 
+#include <algorithm>
+
 #include "control/controlobject.h"
 
 #include "engine/cachingreader/cachingreaderworker.h"
@@ -15,18 +17,103 @@ namespace {
 
 mixxx::Logger kLogger("CachingReaderWorker");
 
+// Read requests for chunks that have not been hinted during this
+// number of subsequent engine callbacks are considered as stale
+// and will be discarded without reading. This typically happens
+// after seeking while the requests for the previous play position
+// are still pending.
+const quint32 kMaxHintEpochAge = 32;
+
 } // anonymous namespace
 
 CachingReaderWorker::CachingReaderWorker(
         QString group,
         FIFO<CachingReaderChunkReadRequest>* pChunkReadRequestFIFO,
-        FIFO<ReaderStatusUpdate>* pReaderStatusFIFO)
+        FIFO<ReaderStatusUpdate>* pReaderStatusFIFO,
+        FIFO<const CachingReaderDecodedTrack*>* pDecodedTrackReleaseFIFO,
+        const QAtomicInteger<quint32>* pHintEpoch)
         : m_group(group),
           m_tag(QString("CachingReaderWorker %1").arg(m_group)),
           m_pChunkReadRequestFIFO(pChunkReadRequestFIFO),
           m_pReaderStatusFIFO(pReaderStatusFIFO),
-          m_newTrackAvailable(false),
-          m_stop(0) {
+          m_pDecodedTrackReleaseFIFO(pDecodedTrackReleaseFIFO),
+          m_wholeTrackCacheMaxMillis(0),
+          m_pHintEpoch(pHintEpoch),
+          m_newTrackAvailable(false) {
+    DEBUG_ASSERT(m_pHintEpoch);
+}
+
+void CachingReaderWorker::setWholeTrackCacheMaxDuration(
+        mixxx::Duration maxDuration) {
+    m_wholeTrackCacheMaxMillis.storeRelease(
+            static_cast<int>(maxDuration.toIntegerMillis()));
+}
+
+void CachingReaderWorker::releaseDecodedTracks() {
+    const CachingReaderDecodedTrack* pDecodedTrack;
+    while (m_pDecodedTrackReleaseFIFO->read(&pDecodedTrack, 1) == 1) {
+        const auto i = std::find_if(
+                m_decodedTracks.begin(),
+                m_decodedTracks.end(),
+                [pDecodedTrack](const std::shared_ptr<const CachingReaderDecodedTrack>& pTrack) {
+                    return pTrack.get() == pDecodedTrack;
+                });
+        VERIFY_OR_DEBUG_ASSERT(i != m_decodedTracks.end()) {
+            continue;
+        }
+        // Might free the memory if the track is not shared
+        m_decodedTracks.erase(i);
+    }
+}
+
+void CachingReaderWorker::discardReadRequest(
+        const CachingReaderChunkReadRequest& request) {
+    const auto update = ReaderStatusUpdate::readDiscarded(request.chunk);
+    m_pReaderStatusFIFO->writeBlocking(&update, 1);
+}
+
+bool CachingReaderWorker::takeNextReadRequest(
+        CachingReaderChunkReadRequest* pRequest) {
+    CachingReaderChunkReadRequest request;
+    while (m_pChunkReadRequestFIFO->read(&request, 1) == 1) {
+        m_pendingReadRequests.push_back(request);
+    }
+
+    // Discard stale requests that have not been hinted recently
+    const quint32 hintEpoch = atomicLoadAcquire(*m_pHintEpoch);
+    const auto staleBegin = std::stable_partition(
+            m_pendingReadRequests.begin(),
+            m_pendingReadRequests.end(),
+            [hintEpoch](const CachingReaderChunkReadRequest& request) {
+                // Unsigned arithmetic handles the wrap around
+                return hintEpoch - request.chunk->getHintEpoch() <= kMaxHintEpochAge;
+            });
+    for (auto i = staleBegin; i != m_pendingReadRequests.end(); ++i) {
+        if (kLogger.traceEnabled()) {
+            kLogger.trace()
+                    << m_group
+                    << "Discarding stale read request for chunk"
+                    << i->chunk->getIndex();
+        }
+        discardReadRequest(*i);
+    }
+    m_pendingReadRequests.erase(staleBegin, m_pendingReadRequests.end());
+
+    // Take the request with the highest priority. Requests with the
+    // same priority are processed in the order they have been issued.
+    const auto next = std::min_element(
+            m_pendingReadRequests.begin(),
+            m_pendingReadRequests.end(),
+            [](const CachingReaderChunkReadRequest& lhs,
+                    const CachingReaderChunkReadRequest& rhs) {
+                return lhs.chunk->getHintPriority() < rhs.chunk->getHintPriority();
+            });
+    if (next == m_pendingReadRequests.end()) {
+        return false;
+    }
+    *pRequest = *next;
+    m_pendingReadRequests.erase(next);
+    return true;
 }
 
 ReaderStatusUpdate CachingReaderWorker::processReadRequest(
@@ -84,41 +171,43 @@ void CachingReaderWorker::newTrack(TrackPointer pTrack) {
     workReady();
 }
 
-void CachingReaderWorker::run() {
-    unsigned static id = 0; //the id of this thread, for debugging purposes
-    QThread::currentThread()->setObjectName(QString("CachingReaderWorker %1").arg(++id));
-
-    Event::start(m_tag);
-    while (!atomicLoadAcquire(m_stop)) {
-        // Request is initialized by reading from FIFO
-        CachingReaderChunkReadRequest request;
-        if (m_newTrackAvailable) {
-            TrackPointer pLoadTrack;
-            { // locking scope
-                QMutexLocker locker(&m_newTrackMutex);
-                pLoadTrack = m_pNewTrack;
-                m_pNewTrack.reset();
-                m_newTrackAvailable = false;
-            } // implicitly unlocks the mutex
-            loadTrack(pLoadTrack);
-        } else if (m_pChunkReadRequestFIFO->read(&request, 1) == 1) {
-            // Read the requested chunk and send the result
-            const ReaderStatusUpdate update(processReadRequest(request));
-            m_pReaderStatusFIFO->writeBlocking(&update, 1);
-        } else {
-            Event::end(m_tag);
-            m_semaRun.acquire();
-            Event::start(m_tag);
-        }
+bool CachingReaderWorker::processWork() {
+    releaseDecodedTracks();
+    // Request is initialized by reading from FIFO
+    CachingReaderChunkReadRequest request;
+    if (m_newTrackAvailable.load() && isBackgroundWorkAllowed()) {
+        Event::start(m_tag);
+        TrackPointer pLoadTrack;
+        { // locking scope
+            QMutexLocker locker(&m_newTrackMutex);
+            pLoadTrack = m_pNewTrack;
+            m_pNewTrack.reset();
+            m_newTrackAvailable = false;
+        } // implicitly unlocks the mutex
+        loadTrack(pLoadTrack);
+        Event::end(m_tag);
+        return true;
+    } else if (takeNextReadRequest(&request)) {
+        Event::start(m_tag);
+        // Read the requested chunk and send the result
+        const ReaderStatusUpdate update(processReadRequest(request));
+        m_pReaderStatusFIFO->writeBlocking(&update, 1);
+        Event::end(m_tag);
+        return true;
     }
+    // A pending track is loaded by a background thread of the scheduler
+    return m_newTrackAvailable.load();
 }
 
 void CachingReaderWorker::loadTrack(const TrackPointer& pTrack) {
     // Discard all pending read requests
+    for (const auto& request : m_pendingReadRequests) {
+        discardReadRequest(request);
+    }
+    m_pendingReadRequests.clear();
     CachingReaderChunkReadRequest request;
     while (m_pChunkReadRequestFIFO->read(&request, 1) == 1) {
-        const auto update = ReaderStatusUpdate::readDiscarded(request.chunk);
-        m_pReaderStatusFIFO->writeBlocking(&update, 1);
+        discardReadRequest(request);
     }
 
     // Unload the track
@@ -186,23 +275,47 @@ void CachingReaderWorker::loadTrack(const TrackPointer& pTrack) {
         mixxx::SampleBuffer(tempReadBufferSize).swap(m_tempReadBuffer);
     }
 
-    const auto update =
-            ReaderStatusUpdate::trackLoaded(
-                    m_pAudioSource->frameIndexRange());
-    m_pReaderStatusFIFO->writeBlocking(&update, 1);
+    const auto sampleRate = m_pAudioSource->getSignalInfo().getSampleRate();
+
+    // Short tracks are decoded as a whole to avoid any further
+    // reading and decoding after loading the track. The reader must
+    // always be able to release all decoded tracks it has received.
+    std::shared_ptr<const CachingReaderDecodedTrack> pDecodedTrack;
+    const int wholeTrackCacheMaxMillis =
+            atomicLoadAcquire(m_wholeTrackCacheMaxMillis);
+    if (wholeTrackCacheMaxMillis > 0 &&
+            m_pAudioSource->getDuration() * 1000 <= wholeTrackCacheMaxMillis &&
+            static_cast<int>(m_decodedTracks.size()) < kMaxDecodedTracks) {
+        pDecodedTrack = CachingReaderDecodedTrack::lookupOrDecode(
+                pTrack,
+                m_pAudioSource,
+                mixxx::SampleBuffer::WritableSlice(m_tempReadBuffer));
+    }
+
+    SINT sampleCount;
+    if (pDecodedTrack) {
+        sampleCount = CachingReaderChunk::frames2samples(
+                pDecodedTrack->frameIndexRange().length());
+        // The audio source is not needed anymore
+        m_pAudioSource.reset(); // Close open file handles
+        m_decodedTracks.push_back(pDecodedTrack);
+        const auto update =
+                ReaderStatusUpdate::trackLoaded(
+                        pDecodedTrack->frameIndexRange(),
+                        pDecodedTrack.get());
+        m_pReaderStatusFIFO->writeBlocking(&update, 1);
+    } else {
+        sampleCount = CachingReaderChunk::frames2samples(
+                m_pAudioSource->frameLength());
+        const auto update =
+                ReaderStatusUpdate::trackLoaded(
+                        m_pAudioSource->frameIndexRange());
+        m_pReaderStatusFIFO->writeBlocking(&update, 1);
+    }
 
     // Emit that the track is loaded.
-    const SINT sampleCount =
-            CachingReaderChunk::frames2samples(
-                    m_pAudioSource->frameLength());
     emit trackLoaded(
             pTrack,
-            m_pAudioSource->getSignalInfo().getSampleRate(),
+            sampleRate,
             sampleCount);
 }
-
-void CachingReaderWorker::quitWait() {
-    m_stop = 1;
-    m_semaRun.release();
-    wait();
-}
@@ -6,8 +6,11 @@
 #include <QSemaphore>
 #include <QThread>
 #include <QString>
+#include <atomic>
+#include <vector>
 
 #include "engine/cachingreader/cachingreaderchunk.h"
+#include "engine/cachingreader/cachingreaderdecodedtrack.h"
 #include "track/track.h"
 #include "engine/engineworker.h"
 #include "sources/audiosource.h"
@@ -40,6 +43,7 @@ typedef struct ReaderStatusUpdate {
     CachingReaderChunk* chunk;
     SINT readableFrameIndexRangeStart;
     SINT readableFrameIndexRangeEnd;
+    const CachingReaderDecodedTrack* pDecodedTrack;
 
   public:
     ReaderStatus status;
@@ -52,6 +56,7 @@ typedef struct ReaderStatusUpdate {
         chunk = chunkArg;
         readableFrameIndexRangeStart = readableFrameIndexRangeArg.start();
         readableFrameIndexRangeEnd = readableFrameIndexRangeArg.end();
+        pDecodedTrack = nullptr;
     }
 
     static ReaderStatusUpdate readDiscarded(
@@ -61,11 +66,15 @@ typedef struct ReaderStatusUpdate {
         return update;
     }
 
+    // The decoded track is optional. If present the reader must return
+    // it to the worker when it is no longer needed.
     static ReaderStatusUpdate trackLoaded(
-            const mixxx::IndexRange& readableFrameIndexRange) {
+            const mixxx::IndexRange& readableFrameIndexRange,
+            const CachingReaderDecodedTrack* pDecodedTrack = nullptr) {
         DEBUG_ASSERT(!readableFrameIndexRange.empty());
         ReaderStatusUpdate update;
         update.init(TRACK_LOADED, nullptr, readableFrameIndexRange);
+        update.pDecodedTrack = pDecodedTrack;
         return update;
     }
 
@@ -86,6 +95,10 @@ typedef struct ReaderStatusUpdate {
         return pChunk;
     }
 
+    const CachingReaderDecodedTrack* decodedTrack() const {
+        return pDecodedTrack;
+    }
+
     mixxx::IndexRange readableFrameIndexRange() const {
         return mixxx::IndexRange::between(
                 readableFrameIndexRangeStart,
@@ -100,17 +113,33 @@ class CachingReaderWorker : public EngineWorker {
     // Construct a CachingReader with the given group.
     CachingReaderWorker(QString group,
             FIFO<CachingReaderChunkReadRequest>* pChunkReadRequestFIFO,
-            FIFO<ReaderStatusUpdate>* pReaderStatusFIFO);
+            FIFO<ReaderStatusUpdate>* pReaderStatusFIFO,
+            FIFO<const CachingReaderDecodedTrack*>* pDecodedTrackReleaseFIFO,
+            const QAtomicInteger<quint32>* pHintEpoch);
     ~CachingReaderWorker() override = default;
 
+    // The maximum number of decoded tracks that have been passed to the
+    // reader and not released yet. The release FIFO must be able to hold
+    // all of them.
+    static constexpr int kMaxDecodedTracks = 16;
+
     // Request to load a new track. wake() must be called afterwards.
     void newTrack(TrackPointer pTrack);
 
     // Run upkeep operations like loading tracks and reading from file. Run by a
     // thread pool via the EngineWorkerScheduler.
-    void run() override;
+    bool processWork() override;
 
-    void quitWait();
+    // Loading a track might decode the whole track
+    bool hasBackgroundWork() const override {
+        return m_newTrackAvailable.load();
+    }
+
+    // Tracks that are not longer than the given duration are decoded
+    // as a whole when loaded instead of reading chunks on demand. A
+    // duration of 0 disables this mode. Takes effect when loading the
+    // next track.
+    void setWholeTrackCacheMaxDuration(mixxx::Duration maxDuration);
 
   signals:
     // Emitted once a new track is loaded and ready to be read from.
@@ -126,11 +155,39 @@ class CachingReaderWorker : public EngineWorker {
     // reader thread.
     FIFO<CachingReaderChunkReadRequest>* m_pChunkReadRequestFIFO;
     FIFO<ReaderStatusUpdate>* m_pReaderStatusFIFO;
+    // Decoded tracks that are no longer used by the reader
+    FIFO<const CachingReaderDecodedTrack*>* m_pDecodedTrackReleaseFIFO;
+
+    // Decoded tracks that have been passed to the reader. They are only
+    // released by the worker to avoid deallocation in the engine callback.
+    std::vector<std::shared_ptr<const CachingReaderDecodedTrack>> m_decodedTracks;
+    QAtomicInt m_wholeTrackCacheMaxMillis;
+
+    // Drops all decoded tracks that have been returned by the reader
+    void releaseDecodedTracks();
+
+    // The current hint epoch of the CachingReader, i.e. the number of
+    // hintAndMaybeWake() invocations.
+    const QAtomicInteger<quint32>* m_pHintEpoch;
+
+    // Read requests that have been fetched from the FIFO, but have not
+    // been processed yet. Only accessed by the worker thread.
+    std::vector<CachingReaderChunkReadRequest> m_pendingReadRequests;
+
+    // Moves all read requests from the FIFO into m_pendingReadRequests,
+    // discards stale requests and takes the request with the highest
+    // priority. Returns false if no request is pending.
+    bool takeNextReadRequest(CachingReaderChunkReadRequest* pRequest);
+
+    // Returns the chunk of a read request to the CachingReader without
+    // reading any data.
+    void discardReadRequest(const CachingReaderChunkReadRequest& request);
 
     // Queue of Tracks to load, and the corresponding lock. Must acquire the
     // lock to touch.
     QMutex m_newTrackMutex;
-    bool m_newTrackAvailable;
+    // Also read without the lock for scheduling
+    std::atomic<bool> m_newTrackAvailable;
     TrackPointer m_pNewTrack;
 
     // Internal method to load a track. Emits trackLoaded when finished.
@@ -145,8 +202,6 @@ class CachingReaderWorker : public EngineWorker {
     // Temporary buffer for reading samples from all channels
     // before conversion to a stereo signal.
     mixxx::SampleBuffer m_tempReadBuffer;
-
-    QAtomicInt m_stop;
 };
 
 
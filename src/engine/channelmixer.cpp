@@ -0,0 +1,119 @@
+#include "engine/channelmixer.h"
+
+#include <array>
+
+#include "util/sample.h"
+#include "util/timer.h"
+
+namespace {
+
+// Calculates the new gain of the channel and returns the old one via
+// pOldGain. A pending fade out is consumed by this call.
+inline CSAMPLE_GAIN updateGainCache(
+        const EngineMaster::GainCalculator& gainCalculator,
+        EngineMaster::ChannelInfo* pChannelInfo,
+        QVarLengthArray<EngineMaster::GainCache, kPreallocatedChannels>* channelGainCache,
+        CSAMPLE_GAIN* pOldGain) {
+    EngineMaster::GainCache& gainCache = (*channelGainCache)[pChannelInfo->m_index];
+    *pOldGain = gainCache.m_gain;
+    CSAMPLE_GAIN newGain;
+    if (gainCache.m_fadeout) {
+        newGain = 0;
+        gainCache.m_fadeout = false;
+    } else {
+        newGain = gainCalculator.getGain(pChannelInfo);
+    }
+    gainCache.m_gain = newGain;
+    return newGain;
+}
+
+} // anonymous namespace
+
+// static
+void ChannelMixer::applyEffectsAndMixChannels(
+        const EngineMaster::GainCalculator& gainCalculator,
+        QVarLengthArray<EngineMaster::ChannelInfo*, kPreallocatedChannels>* activeChannels,
+        QVarLengthArray<EngineMaster::GainCache, kPreallocatedChannels>* channelGainCache,
+        CSAMPLE* pOutput, const ChannelHandle& outputHandle,
+        unsigned int iBufferSize,
+        unsigned int iSampleRate,
+        EngineEffectsManager* pEngineEffectsManager) {
+    // Signal flow overview:
+    // 1. Clear pOutput buffer
+    // 2. Calculate gains for each channel
+    // 3. Pass each channel's calculated gain and input buffer to pEngineEffectsManager, which then:
+    //     A) Copies each channel input buffer to a temporary buffer
+    //     B) Applies gain to the temporary buffer
+    //     C) Processes effects on the temporary buffer
+    //     D) Mixes the temporary buffer into pOutput
+    // The original channel input buffers are not modified.
+    //ScopedTimer t("EngineMaster::applyEffectsAndMixChannels");
+    SampleUtil::clear(pOutput, iBufferSize);
+    for (EngineMaster::ChannelInfo* pChannelInfo : *activeChannels) {
+        CSAMPLE_GAIN oldGain;
+        const CSAMPLE_GAIN newGain = updateGainCache(
+                gainCalculator, pChannelInfo, channelGainCache, &oldGain);
+        pEngineEffectsManager->processPostFaderAndMix(
+                pChannelInfo->m_handle,
+                outputHandle,
+                pChannelInfo->m_pBuffer,
+                pOutput,
+                iBufferSize,
+                iSampleRate,
+                pChannelInfo->m_features,
+                oldGain,
+                newGain);
+    }
+}
+
+// static
+void ChannelMixer::applyEffectsInPlaceAndMixChannels(
+        const EngineMaster::GainCalculator& gainCalculator,
+        QVarLengthArray<EngineMaster::ChannelInfo*, kPreallocatedChannels>* activeChannels,
+        QVarLengthArray<EngineMaster::GainCache, kPreallocatedChannels>* channelGainCache,
+        CSAMPLE* pOutput, const ChannelHandle& outputHandle,
+        unsigned int iBufferSize,
+        unsigned int iSampleRate,
+        EngineEffectsManager* pEngineEffectsManager) {
+    // Signal flow overview:
+    // 1. Calculate gains for each channel
+    // 2. Pass each channel's calculated gain and input buffer to pEngineEffectsManager, which then:
+    //    A) Applies the calculated gain to the channel buffer, modifying the original input buffer
+    //    B) Applies effects to the buffer, modifying the original input buffer
+    // 3. Mix the channel buffers together to make pOutput, overwriting the pOutput buffer from the last engine callback
+    //ScopedTimer t("EngineMaster::applyEffectsInPlaceAndMixChannels");
+
+    // The array has a fixed size and never allocates memory in the
+    // callback. Buffers of the unlikely channels that exceed it are
+    // added separately after mixing.
+    std::array<const CSAMPLE*, kPreallocatedChannels> channelBuffers;
+    int channelBufferCount = 0;
+    for (EngineMaster::ChannelInfo* pChannelInfo : *activeChannels) {
+        CSAMPLE_GAIN oldGain;
+        const CSAMPLE_GAIN newGain = updateGainCache(
+                gainCalculator, pChannelInfo, channelGainCache, &oldGain);
+        CSAMPLE* pBuffer = pChannelInfo->m_pBuffer;
+        pEngineEffectsManager->processPostFaderInPlace(
+                pChannelInfo->m_handle,
+                outputHandle,
+                pBuffer,
+                iBufferSize,
+                iSampleRate,
+                pChannelInfo->m_features,
+                oldGain,
+                newGain);
+        if (channelBufferCount < static_cast<int>(channelBuffers.size())) {
+            channelBuffers[channelBufferCount++] = pBuffer;
+        }
+    }
+
+    // Mix the effected channel buffers together to replace the old pOutput
+    // from the last engine callback
+    SampleUtil::mixBuffers(pOutput,
+            channelBuffers.data(),
+            channelBufferCount,
+            iBufferSize);
+    for (int i = channelBufferCount; i < activeChannels->size(); ++i) {
+        SampleUtil::add(pOutput, (*activeChannels)[i]->m_pBuffer, iBufferSize);
+    }
+}
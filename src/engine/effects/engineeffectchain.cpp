@@ -79,10 +79,11 @@ bool EngineEffectChain::updateParameters(const EffectsRequest& message) {
     m_mixMode = message.SetEffectChainParameters.mix_mode;
     m_dMix = message.SetEffectChainParameters.mix;
 
-    if (m_enableState != EffectEnableState::Disabled && !message.SetEffectParameters.enabled) {
-        m_enableState = EffectEnableState::Disabling;
-    } else if (m_enableState == EffectEnableState::Disabled && message.SetEffectParameters.enabled) {
-        m_enableState = EffectEnableState::Enabling;
+    const EffectEnableState enableState = m_enableState.load();
+    if (enableState != EffectEnableState::Disabled && !message.SetEffectParameters.enabled) {
+        m_enableState.store(EffectEnableState::Disabling);
+    } else if (enableState == EffectEnableState::Disabled && message.SetEffectParameters.enabled) {
+        m_enableState.store(EffectEnableState::Enabling);
     }
     return true;
 }
@@ -226,6 +227,32 @@ EngineEffectChain::ChannelStatus& EngineEffectChain::getChannelStatus(
     return status;
 }
 
+// static
+bool EngineEffectChain::enabledForAnyOutputChannel(
+        const ChannelHandleMap<ChannelStatus>& outputMap) {
+    for (const auto& outputChannelStatus : outputMap) {
+        if (outputChannelStatus.enableState != EffectEnableState::Disabled) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool EngineEffectChain::sharedWithOtherInputChannel(
+        const ChannelHandle& inputHandle) const {
+    if (!enabledForAnyOutputChannel(m_chainStatusForChannelMatrix.at(inputHandle))) {
+        return false;
+    }
+    int iHandle = 0;
+    for (const auto& outputMap : m_chainStatusForChannelMatrix) {
+        if (iHandle++ != inputHandle.handle() &&
+                enabledForAnyOutputChannel(outputMap)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 bool EngineEffectChain::process(const ChannelHandle& inputHandle,
                                 const ChannelHandle& outputHandle,
                                 CSAMPLE* pIn, CSAMPLE* pOut,
@@ -247,8 +274,9 @@ bool EngineEffectChain::process(const ChannelHandle& inputHandle,
     // enabling/disabing signals from the chain's enable switch override
     // the channel's state.
     if (effectiveChainEnableState != EffectEnableState::Disabled) {
-        if (m_enableState != EffectEnableState::Enabled) {
-            effectiveChainEnableState = m_enableState;
+        const EffectEnableState enableState = m_enableState.load();
+        if (enableState != EffectEnableState::Enabled) {
+            effectiveChainEnableState = enableState;
         }
     }
 
@@ -342,10 +370,12 @@ bool EngineEffectChain::process(const ChannelHandle& inputHandle,
         chainOnChannelEnableState = EffectEnableState::Enabled;
     }
 
-    if (m_enableState == EffectEnableState::Disabling) {
-        m_enableState = EffectEnableState::Disabled;
-    } else if (m_enableState == EffectEnableState::Enabling) {
-        m_enableState = EffectEnableState::Enabled;
+    EffectEnableState expectedEnableState = EffectEnableState::Disabling;
+    if (!m_enableState.compare_exchange_strong(
+                expectedEnableState, EffectEnableState::Disabled)) {
+        expectedEnableState = EffectEnableState::Enabling;
+        m_enableState.compare_exchange_strong(
+                expectedEnableState, EffectEnableState::Enabled);
     }
 
     return processingOccured;
@@ -3,6 +3,8 @@
 #include <QString>
 #include <QList>
 
+#include <atomic>
+
 #include "util/class.h"
 #include "util/types.h"
 #include "util/samplebuffer.h"
@@ -38,6 +40,11 @@ class EngineEffectChain : public EffectsRequestHandler {
 
     bool enabledForChannel(const ChannelHandle& handle) const;
 
+    // Checks if the chain is enabled for the input channel and for at
+    // least one other input channel. Then the input channels must not be
+    // processed concurrently, because they share the intermediate buffers.
+    bool sharedWithOtherInputChannel(const ChannelHandle& inputHandle) const;
+
     void deleteStatesForInputChannel(const ChannelHandle* channel);
 
   private:
@@ -54,6 +61,9 @@ class EngineEffectChain : public EffectsRequestHandler {
         return QString("EngineEffectChain(%1)").arg(m_id);
     }
 
+    static bool enabledForAnyOutputChannel(
+            const ChannelHandleMap<ChannelStatus>& outputMap);
+
     bool updateParameters(const EffectsRequest& message);
     bool addEffect(EngineEffect* pEffect, int iIndex);
     bool removeEffect(EngineEffect* pEffect, int iIndex);
@@ -67,7 +77,10 @@ class EngineEffectChain : public EffectsRequestHandler {
                                     const ChannelHandle& outputHandle);
 
     QString m_id;
-    EffectEnableState m_enableState;
+    // Pre-fader chains that are only enabled for a single input channel are
+    // processed concurrently with other chains, each of them might complete
+    // the transition.
+    std::atomic<EffectEnableState> m_enableState;
     EffectChainMixMode m_mixMode;
     CSAMPLE m_dMix;
     QList<EngineEffect*> m_effects;
@@ -94,6 +94,16 @@ bool EngineEffectRack::process(const ChannelHandle& inputHandle,
     return processingOccured;
 }
 
+bool EngineEffectRack::sharesChainsWithOtherInputChannel(
+        const ChannelHandle& inputHandle) const {
+    for (EngineEffectChain* pChain : m_chains) {
+        if (pChain != nullptr && pChain->sharedWithOtherInputChannel(inputHandle)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 bool EngineEffectRack::addEffectChain(EngineEffectChain* pChain, int iIndex) {
     if (iIndex < 0) {
         if (kEffectDebugOutput) {
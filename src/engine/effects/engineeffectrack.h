@@ -27,6 +27,10 @@ class EngineEffectRack : public EffectsRequestHandler {
                  const unsigned int sampleRate,
                  const GroupFeatureState& groupFeatures);
 
+    // Checks if any chain is shared between the input channel and
+    // another input channel
+    bool sharesChainsWithOtherInputChannel(const ChannelHandle& inputHandle) const;
+
     int number() const {
         return m_iRackNumber;
     }
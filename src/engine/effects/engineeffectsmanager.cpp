@@ -136,6 +136,20 @@ void EngineEffectsManager::processPreFaderInPlace(const ChannelHandle& inputHand
                  numSamples, sampleRate, featureState);
 }
 
+bool EngineEffectsManager::sharesPreFaderEffectChains(
+        const ChannelHandle& inputHandle) const {
+    const auto it = m_racksByStage.constFind(SignalProcessingStage::Prefader);
+    if (it == m_racksByStage.constEnd()) {
+        return false;
+    }
+    for (EngineEffectRack* pRack : it.value()) {
+        if (pRack != nullptr && pRack->sharesChainsWithOtherInputChannel(inputHandle)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 void EngineEffectsManager::processPostFaderInPlace(
     const ChannelHandle& inputHandle,
     const ChannelHandle& outputHandle,
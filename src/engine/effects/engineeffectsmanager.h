@@ -35,6 +35,11 @@ class EngineEffectsManager : public EffectsRequestHandler {
         const unsigned int numSamples,
         const unsigned int sampleRate);
 
+    // Checks if a pre-fader effect chain that is enabled for the input
+    // channel is also enabled for another input channel. Those input
+    // channels must not be processed concurrently.
+    bool sharesPreFaderEffectChains(const ChannelHandle& inputHandle) const;
+
     void processPostFaderInPlace(
         const ChannelHandle& inputHandle,
         const ChannelHandle& outputHandle,
@@ -88,6 +88,7 @@ EngineBuffer::EngineBuffer(const QString& group,
           m_iSeekPhaseQueued(0),
           m_iEnableSyncQueued(SYNC_REQUEST_NONE),
           m_iSyncModeQueued(SYNC_INVALID),
+          m_bSyncRequestsDeferred(false),
           m_iTrackLoading(0),
           m_bPlayAfterLoading(false),
           m_iSampleRate(0),
@@ -161,8 +162,6 @@ EngineBuffer::EngineBuffer(const QString& group,
     m_pRepeat = new ControlPushButton(ConfigKey(m_group, "repeat"));
     m_pRepeat->setButtonMode(ControlPushButton::TOGGLE);
 
-    m_pSampleRate = new ControlProxy("[Master]", "samplerate", this);
-
     m_pKeylockEngine = new ControlProxy("[Master]", "keylock_engine", this);
     m_pKeylockEngine->connectValueChanged(this, &EngineBuffer::slotKeylockEngineChanged,
                                           Qt::DirectConnection);
@@ -218,9 +217,6 @@ EngineBuffer::EngineBuffer(const QString& group,
     pMixingEngine->getEngineSync()->addSyncableDeck(m_pSyncControl);
     addControl(m_pSyncControl);
 
-    m_fwdButton = ControlObject::getControl(ConfigKey(group, "fwd"));
-    m_backButton = ControlObject::getControl(ConfigKey(group, "back"));
-
     m_pKeyControl = new KeyControl(group, pConfig);
     addControl(m_pKeyControl);
 
@@ -254,6 +250,20 @@ EngineBuffer::EngineBuffer(const QString& group,
     m_pPassthroughEnabled->connectValueChanged(this, &EngineBuffer::slotPassthroughChanged,
                                                Qt::DirectConnection);
 
+    // Controls that are read but never modified while processing
+    m_sampleRateSnapshotIndex = m_controlSnapshot.addControl(
+            ConfigKey("[Master]", "samplerate"));
+    m_quantizeSnapshotIndex = m_controlSnapshot.addControl(
+            ConfigKey(group, "quantize"));
+    m_repeatSnapshotIndex = m_controlSnapshot.addControl(
+            ConfigKey(group, "repeat"));
+    m_fwdSnapshotIndex = m_controlSnapshot.addControl(
+            ConfigKey(group, "fwd"));
+    m_backSnapshotIndex = m_controlSnapshot.addControl(
+            ConfigKey(group, "back"));
+    m_slipSnapshotIndex = m_controlSnapshot.addControl(
+            ConfigKey(group, "slip_enabled"));
+
 #ifdef __SCALER_DEBUG__
     df.setFileName("mixxx-debug.csv");
     df.open(QIODevice::WriteOnly | QIODevice::Text);
@@ -286,7 +296,6 @@ EngineBuffer::~EngineBuffer() {
 
     delete m_pSlipButton;
     delete m_pRepeat;
-    delete m_pSampleRate;
 
     delete m_pTrackLoaded;
     delete m_pTrackSamples;
@@ -419,6 +428,12 @@ void EngineBuffer::requestSyncMode(SyncMode mode) {
     }
 }
 
+bool EngineBuffer::isSyncInvolved() const {
+    return m_pSyncControl->getSyncMode() != SYNC_NONE ||
+            atomicLoadRelaxed(m_iEnableSyncQueued) != SYNC_REQUEST_NONE ||
+            atomicLoadRelaxed(m_iSyncModeQueued) != SYNC_INVALID;
+}
+
 void EngineBuffer::requestClonePosition(EngineChannel* pChannel) {
     atomicStoreRelaxed(m_pChannelToCloneFrom, pChannel);
 }
@@ -860,7 +875,8 @@ void EngineBuffer::processTrackLocked(
     // we need to sync phase or we'll be totally out of whack and the sync
     // adjuster will kick in and push the track back in to sync with the
     // master.
-    if (m_scratching_old && !is_scratching && m_pQuantize->toBool()
+    if (m_scratching_old && !is_scratching &&
+            m_controlSnapshot.toBool(m_quantizeSnapshotIndex)
             && m_pSyncControl->getSyncMode() == SYNC_FOLLOWER && !paused) {
         // TODO() The resulting seek is processed in the following callback
         // That is to late
@@ -996,18 +1012,30 @@ void EngineBuffer::processTrackLocked(
 
     m_scratching_old = is_scratching;
 
+    // Scratching and playing decks get a larger share of the memory for
+    // cached chunks than idle decks and samplers.
+    if (is_scratching) {
+        m_pReader->setActivity(CachingReader::Activity::Scratching);
+    } else if (speed != 0) {
+        m_pReader->setActivity(CachingReader::Activity::Playing);
+    } else {
+        m_pReader->setActivity(CachingReader::Activity::Idle);
+    }
+
     // Handle repeat mode
     at_start = m_filepos_play <= 0;
     at_end = m_filepos_play >= m_trackSamplesOld;
 
-    bool repeat_enabled = m_pRepeat->toBool();
+    bool repeat_enabled = m_controlSnapshot.toBool(m_repeatSnapshotIndex);
 
     bool end_of_track = //(at_start && backwards) ||
             (at_end && !backwards);
 
     // If playbutton is pressed, check if we are at start or end of track
-    if ((m_playButton->toBool() || (m_fwdButton->toBool() || m_backButton->toBool()))
-            && end_of_track) {
+    if ((m_playButton->toBool() ||
+                (m_controlSnapshot.toBool(m_fwdSnapshotIndex) ||
+                        m_controlSnapshot.toBool(m_backSnapshotIndex))) &&
+            end_of_track) {
         if (repeat_enabled) {
             double fractionalPos = at_start ? 1.0 : 0;
             doSeekFractional(fractionalPos, SEEK_STANDARD);
@@ -1037,7 +1065,10 @@ void EngineBuffer::process(CSAMPLE* pOutput, const int iBufferSize) {
     // - Set last sample value (m_fLastSampleValue) so that rampOut works? Other
     //   miscellaneous upkeep issues.
 
-    m_iSampleRate = static_cast<int>(m_pSampleRate->get());
+    // All following reads of the snapshot return the same values during
+    // this callback
+    m_controlSnapshot.refresh();
+    m_iSampleRate = static_cast<int>(m_controlSnapshot.get(m_sampleRateSnapshotIndex));
 
     // If the sample rate has changed, force Rubberband to reset so that
     // it doesn't reallocate when the user engages keylock during playback.
@@ -1074,6 +1105,7 @@ void EngineBuffer::process(CSAMPLE* pOutput, const int iBufferSize) {
         m_rate_old = 0;
         m_speed_old = 0;
         m_scratching_old = false;
+        m_pReader->setActivity(CachingReader::Activity::Idle);
     }
 
 #ifdef __SCALER_DEBUG__
@@ -1094,7 +1126,7 @@ void EngineBuffer::process(CSAMPLE* pOutput, const int iBufferSize) {
 
 void EngineBuffer::processSlip(int iBufferSize) {
     // Do a single read from m_bSlipEnabled so we don't run in to race conditions.
-    bool enabled = m_pSlipButton->toBool();
+    bool enabled = m_controlSnapshot.toBool(m_slipSnapshotIndex);
     if (enabled != m_bSlipEnabledProcessing) {
         m_bSlipEnabledProcessing = enabled;
         if (enabled) {
@@ -1116,6 +1148,11 @@ void EngineBuffer::processSlip(int iBufferSize) {
 }
 
 void EngineBuffer::processSyncRequests() {
+    if (m_bSyncRequestsDeferred) {
+        // Requests that have been queued after the deck has been
+        // scheduled for concurrent processing
+        return;
+    }
     SyncRequestQueued enable_request =
             static_cast<SyncRequestQueued>(
                     m_iEnableSyncQueued.fetchAndStoreRelease(SYNC_REQUEST_NONE));
@@ -1177,7 +1214,7 @@ void EngineBuffer::processSeek(bool paused) {
             position = m_filepos_play;
             break;
         case SEEK_STANDARD:
-            if (m_pQuantize->toBool()) {
+            if (m_controlSnapshot.toBool(m_quantizeSnapshotIndex)) {
                 seekType |= SEEK_PHASE;
             }
             // new position was already set above
@@ -1272,7 +1309,7 @@ void EngineBuffer::updateIndicators(double speed, int iBufferSize) {
 
     // Update indicators that are only updated after every
     // sampleRate/kiUpdateRate samples processed.  (e.g. playposSlider)
-    if (m_iSamplesSinceLastIndicatorUpdate > (kSamplesPerFrame * m_pSampleRate->get() / kiPlaypositionUpdateRate)) {
+    if (m_iSamplesSinceLastIndicatorUpdate > (kSamplesPerFrame * m_iSampleRate / kiPlaypositionUpdateRate)) {
         m_playposSlider->set(fFractionalPlaypos);
         m_pCueControl->updateIndicators();
     }
@@ -1331,6 +1368,10 @@ void EngineBuffer::bindWorkers(EngineWorkerScheduler* pWorkerScheduler) {
     m_pReader->setScheduler(pWorkerScheduler);
 }
 
+void EngineBuffer::setWholeTrackCacheMaxDuration(mixxx::Duration maxDuration) {
+    m_pReader->setWholeTrackCacheMaxDuration(maxDuration);
+}
+
 bool EngineBuffer::isTrackLoaded() {
     if (m_pCurrentTrack) {
         return true;
@@ -24,6 +24,7 @@
 
 #include "engine/cachingreader/cachingreader.h"
 #include "preferences/usersettings.h"
+#include "control/controlsnapshot.h"
 #include "control/controlvalue.h"
 #include "engine/engineobject.h"
 #include "engine/sync/syncable.h"
@@ -116,6 +117,10 @@ class EngineBuffer : public EngineObject {
 
     void bindWorkers(EngineWorkerScheduler* pWorkerScheduler);
 
+    // Tracks that are not longer than the given duration are decoded and
+    // kept in memory as a whole while loaded (see CachingReader).
+    void setWholeTrackCacheMaxDuration(mixxx::Duration maxDuration);
+
     // Return the current rate (not thread-safe)
     double getSpeed();
     bool getScratching();
@@ -133,6 +138,16 @@ class EngineBuffer : public EngineObject {
     void requestSyncMode(SyncMode mode);
     void requestClonePosition(EngineChannel* pChannel);
 
+    // Returns true if processing this deck might notify EngineSync, which
+    // in turn updates all synchronized decks. Such decks must not be
+    // processed concurrently with other decks.
+    bool isSyncInvolved() const;
+    // While deferred, queued sync requests are kept for the next callback.
+    // Set for decks that are processed concurrently with other decks.
+    void setSyncRequestsDeferred(bool deferred) {
+        m_bSyncRequestsDeferred = deferred;
+    }
+
     // The process methods all run in the audio callback.
     void process(CSAMPLE* pOut, const int iBufferSize);
     void processSlip(int iBufferSize);
@@ -341,14 +356,11 @@ class EngineBuffer : public EngineObject {
     ControlPushButton* m_stopStartButton;
     ControlPushButton* m_stopButton;
 
-    ControlObject* m_fwdButton;
-    ControlObject* m_backButton;
     ControlPushButton* m_pSlipButton;
 
     ControlObject* m_pQuantize;
     ControlObject* m_pMasterRate;
     ControlPotmeter* m_playposSlider;
-    ControlProxy* m_pSampleRate;
     ControlProxy* m_pKeylockEngine;
     ControlPushButton* m_pKeylock;
 
@@ -363,6 +375,16 @@ class EngineBuffer : public EngineObject {
     // Whether or not to repeat the track when at the end
     ControlPushButton* m_pRepeat;
 
+    // Contiguous copy of the controls that are only read while processing,
+    // refreshed once at the start of each callback
+    ControlSnapshot m_controlSnapshot;
+    ControlSnapshot::Index m_sampleRateSnapshotIndex;
+    ControlSnapshot::Index m_quantizeSnapshotIndex;
+    ControlSnapshot::Index m_repeatSnapshotIndex;
+    ControlSnapshot::Index m_fwdSnapshotIndex;
+    ControlSnapshot::Index m_backSnapshotIndex;
+    ControlSnapshot::Index m_slipSnapshotIndex;
+
     // Fwd and back controls, start and end of track control
     ControlPushButton* m_startButton;
     ControlPushButton* m_endButton;
@@ -396,6 +418,8 @@ class EngineBuffer : public EngineObject {
     QAtomicInt m_iSeekPhaseQueued;
     QAtomicInt m_iEnableSyncQueued;
     QAtomicInt m_iSyncModeQueued;
+    // Only accessed while processing
+    bool m_bSyncRequestsDeferred;
     ControlValueAtomic<double> m_queuedSeekPosition;
     QAtomicPointer<EngineChannel> m_pChannelToCloneFrom;
 
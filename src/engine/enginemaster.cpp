@@ -25,10 +25,20 @@
 #include "engine/sync/enginesync.h"
 #include "mixer/playermanager.h"
 #include "util/defs.h"
+#include "util/realtimecheck.h"
 #include "util/sample.h"
 #include "util/timer.h"
 #include "util/trace.h"
 
+namespace {
+
+// The minimum number of channels that are not involved in master sync
+// for processing them concurrently. Waking up the helper threads takes
+// a few microseconds.
+constexpr int kMinParallelChannels = 3;
+
+} // anonymous namespace
+
 EngineMaster::EngineMaster(
         UserSettingsPointer pConfig,
         const QString& group,
@@ -37,6 +47,7 @@ EngineMaster::EngineMaster(
         bool bEnableSidechain)
         : m_pChannelHandleFactory(pChannelHandleFactory),
           m_pEngineEffectsManager(pEffectsManager ? pEffectsManager->getEngineEffectsManager() : NULL),
+          m_channelProcessingTask(this),
           m_masterGainOld(0.0),
           m_boothGainOld(0.0),
           m_headphoneMasterGainOld(0.0),
@@ -64,8 +75,10 @@ EngineMaster::EngineMaster(
     m_bBusOutputConnected[EngineChannel::CENTER] = false;
     m_bBusOutputConnected[EngineChannel::RIGHT] = false;
     m_bExternalRecordBroadcastInputConnected = false;
-    m_pWorkerScheduler = new EngineWorkerScheduler(this);
+    m_pWorkerScheduler = new EngineWorkerScheduler();
     m_pWorkerScheduler->start(QThread::HighPriority);
+    m_pChannelExecutor = new EngineParallelExecutor();
+    m_pChannelExecutor->start();
 
     // Master sample rate
     m_pMasterSampleRate = new ControlObject(ConfigKey(group, "samplerate"), true, true);
@@ -131,6 +144,11 @@ EngineMaster::EngineMaster(
     m_pHeadSplitEnabled->setButtonMode(ControlPushButton::TOGGLE);
     m_pHeadSplitEnabled->set(0.0);
 
+    // Process channels concurrently on multiple CPU cores
+    m_pParallelChannels = new ControlPushButton(ConfigKey(group, "parallel_channels"));
+    m_pParallelChannels->setButtonMode(ControlPushButton::TOGGLE);
+    m_pParallelChannels->set(1.0);
+
     m_pTalkoverDucking = new EngineTalkoverDucking(pConfig, group);
 
     // Allocate buffers
@@ -201,6 +219,7 @@ EngineMaster::~EngineMaster() {
     delete m_pBalance;
     delete m_pHeadMix;
     delete m_pHeadSplitEnabled;
+    delete m_pParallelChannels;
     delete m_pMasterGain;
     delete m_pBoothGain;
     delete m_pHeadGain;
@@ -242,8 +261,6 @@ EngineMaster::~EngineMaster() {
         SampleUtil::free(m_pOutputBusBuffers[o]);
     }
 
-    delete m_pWorkerScheduler;
-
     for (int i = 0; i < m_channels.size(); ++i) {
         ChannelInfo* pChannelInfo = m_channels[i];
         SampleUtil::free(pChannelInfo->m_pBuffer);
@@ -252,6 +269,10 @@ EngineMaster::~EngineMaster() {
         delete pChannelInfo->m_pMuteControl;
         delete pChannelInfo;
     }
+
+    // All workers of the channels must have been stopped
+    delete m_pWorkerScheduler;
+    delete m_pChannelExecutor;
 }
 
 const CSAMPLE* EngineMaster::getMasterBuffer() const {
@@ -353,18 +374,43 @@ void EngineMaster::processChannels(int iBufferSize) {
         }
     }
 
-    // Now that the list is built and ordered, do the processing.
-    for (int i = activeChannelsStartIndex;
-             i < m_activeChannels.size(); ++i) {
+    // Now that the list is built and ordered, do the processing. The
+    // master sync channel must be processed before all other channels,
+    // because they pick up its tempo and beat distance.
+    if (activeChannelsStartIndex == 0) {
+        processChannel(m_activeChannels[0], iBufferSize);
+    }
+    // Decks that are involved in master sync notify EngineSync, e.g. when
+    // stopping at the end of the track, which then updates all synchronized
+    // decks. Channels that share a pre-fader effect chain also share its
+    // intermediate buffers. Both are processed one after another. All other
+    // channels only update their own state and could be processed
+    // concurrently.
+    m_parallelChannels.clear();
+    for (int i = 1; i < m_activeChannels.size(); ++i) {
         ChannelInfo* pChannelInfo = m_activeChannels[i];
-        EngineChannel* pChannel = pChannelInfo->m_pChannel;
-        pChannel->process(pChannelInfo->m_pBuffer, iBufferSize);
-
-        // Collect metadata for effects
-        if (m_pEngineEffectsManager) {
-            GroupFeatureState features;
-            pChannel->collectFeatures(&features);
-            pChannelInfo->m_features = features;
+        EngineBuffer* pBuffer = pChannelInfo->m_pChannel->getEngineBuffer();
+        if ((pBuffer && pBuffer->isSyncInvolved()) ||
+                (m_pEngineEffectsManager &&
+                        m_pEngineEffectsManager->sharesPreFaderEffectChains(
+                                pChannelInfo->m_handle))) {
+            processChannel(pChannelInfo, iBufferSize);
+        } else {
+            m_parallelChannels.append(pChannelInfo);
+        }
+    }
+    if (m_parallelChannels.size() >= kMinParallelChannels &&
+            m_pParallelChannels->toBool()) {
+        // Sync requests that arrive from now on wait for the next callback
+        setSyncRequestsDeferred(true);
+        m_channelProcessingTask.prepare(iBufferSize);
+        m_pChannelExecutor->execute(&m_channelProcessingTask, m_parallelChannels.size());
+        setSyncRequestsDeferred(false);
+    } else {
+        // Waking up the helper threads is not worth it for only a few
+        // channels
+        for (ChannelInfo* pChannelInfo : m_parallelChannels) {
+            processChannel(pChannelInfo, iBufferSize);
         }
     }
 
@@ -382,12 +428,43 @@ void EngineMaster::processChannels(int iBufferSize) {
     }
 }
 
+void EngineMaster::processChannel(ChannelInfo* pChannelInfo, int iBufferSize) {
+    EngineChannel* pChannel = pChannelInfo->m_pChannel;
+    pChannel->process(pChannelInfo->m_pBuffer, iBufferSize);
+
+    // Collect metadata for effects
+    if (m_pEngineEffectsManager) {
+        GroupFeatureState features;
+        pChannel->collectFeatures(&features);
+        pChannelInfo->m_features = features;
+    }
+}
+
+void EngineMaster::setSyncRequestsDeferred(bool deferred) {
+    for (ChannelInfo* pChannelInfo : m_parallelChannels) {
+        EngineBuffer* pBuffer = pChannelInfo->m_pChannel->getEngineBuffer();
+        if (pBuffer) {
+            pBuffer->setSyncRequestsDeferred(deferred);
+        }
+    }
+}
+
+void EngineMaster::ChannelProcessingTask::run(int index) {
+    // Also invoked on the helper threads of the channel executor
+    mixxx::ScopedRealtimeSection realtimeSection;
+    m_pEngineMaster->processChannel(
+            m_pEngineMaster->m_parallelChannels[index],
+            m_iBufferSize);
+}
+
 void EngineMaster::process(const int iBufferSize) {
     static bool haveSetName = false;
     if (!haveSetName) {
         QThread::currentThread()->setObjectName("Engine");
         haveSetName = true;
     }
+    // Already entered by the sound device, but not by the tests
+    mixxx::ScopedRealtimeSection realtimeSection;
     //Trace t("EngineMaster::process");
 
     bool masterEnabled = m_pMasterEnabled->get();
@@ -809,6 +886,7 @@ void EngineMaster::addChannel(EngineChannel* pChannel) {
     // callback. QVarLengthArray does nothing if reserve is called with a size
     // smaller than its pre-allocation.
     m_activeChannels.reserve(m_channels.size());
+    m_parallelChannels.reserve(m_channels.size());
     m_activeBusChannels[EngineChannel::LEFT].reserve(m_channels.size());
     m_activeBusChannels[EngineChannel::CENTER].reserve(m_channels.size());
     m_activeBusChannels[EngineChannel::RIGHT].reserve(m_channels.size());
@@ -27,6 +27,7 @@
 #include "engine/engineobject.h"
 #include "engine/channels/enginechannel.h"
 #include "engine/channelhandle.h"
+#include "engine/engineparallelexecutor.h"
 #include "soundio/soundmanager.h"
 #include "soundio/soundmanagerutil.h"
 #include "recording/recordingmanager.h"
@@ -270,6 +271,30 @@ class EngineMaster : public QObject, public AudioSource {
     // respective output.
     void processChannels(int iBufferSize);
 
+    // Processes a single channel and collects its metadata for effects.
+    void processChannel(ChannelInfo* pChannelInfo, int iBufferSize);
+    // Defers the sync requests of all channels in m_parallelChannels
+    void setSyncRequestsDeferred(bool deferred);
+
+    // Processes the channels in m_parallelChannels concurrently.
+    class ChannelProcessingTask : public EngineParallelExecutor::Task {
+      public:
+        explicit ChannelProcessingTask(EngineMaster* pEngineMaster)
+                : m_pEngineMaster(pEngineMaster),
+                  m_iBufferSize(0) {
+        }
+
+        void prepare(int iBufferSize) {
+            m_iBufferSize = iBufferSize;
+        }
+
+        void run(int index) override;
+
+      private:
+        EngineMaster* const m_pEngineMaster;
+        int m_iBufferSize;
+    };
+
     ChannelHandleFactoryPointer m_pChannelHandleFactory;
     void applyMasterEffects();
     void processHeadphones(const double masterMixGainInHeadphones);
@@ -288,6 +313,8 @@ class EngineMaster : public QObject, public AudioSource {
 
     // Pre-allocated buffers for performing channel mixing in the callback.
     QVarLengthArray<ChannelInfo*, kPreallocatedChannels> m_activeChannels;
+    // The active channels that are not involved in master sync
+    QVarLengthArray<ChannelInfo*, kPreallocatedChannels> m_parallelChannels;
     QVarLengthArray<ChannelInfo*, kPreallocatedChannels> m_activeBusChannels[3];
     QVarLengthArray<ChannelInfo*, kPreallocatedChannels> m_activeHeadphoneChannels;
     QVarLengthArray<ChannelInfo*, kPreallocatedChannels> m_activeTalkoverChannels;
@@ -304,6 +331,8 @@ class EngineMaster : public QObject, public AudioSource {
     CSAMPLE* m_pSidechainMix;
 
     EngineWorkerScheduler* m_pWorkerScheduler;
+    EngineParallelExecutor* m_pChannelExecutor;
+    ChannelProcessingTask m_channelProcessingTask;
     EngineSync* m_pMasterSync;
 
     ControlObject* m_pMasterGain;
@@ -333,6 +362,7 @@ class EngineMaster : public QObject, public AudioSource {
     ControlPotmeter* m_pXFaderCalibration;
     ControlPushButton* m_pXFaderReverse;
     ControlPushButton* m_pHeadSplitEnabled;
+    ControlPushButton* m_pParallelChannels;
     ControlObject* m_pKeylockEngine;
 
     PflGainCalculator m_headphoneGain;
@@ -0,0 +1,205 @@
+#include "engine/engineparallelexecutor.h"
+
+#include <QtDebug>
+
+#include <thread>
+
+#include "util/assert.h"
+#include "util/math.h"
+
+#ifdef Q_OS_LINUX
+#include <sched.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Even with 4 decks on keylock and a few samplers a handful of cores
+// is sufficient. More threads would only steal cores from the GUI and
+// the engine workers.
+constexpr int kMaxDefaultHelperThreadCount = 3;
+
+constexpr int kUnitCountShift = 32;
+constexpr quint64 kUnitIndexMask = (quint64(1) << kUnitCountShift) - 1;
+
+// Units are short, usually a few 10 us. A few thousand iterations
+// cover most of the time until the last helper thread has finished.
+constexpr int kMaxSpinCount = 4096;
+
+// Hints the CPU that we are busy waiting
+inline void spinPause() {
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_IX86)
+    _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+} // anonymous namespace
+
+class EngineParallelExecutorThread : public QThread {
+  public:
+    EngineParallelExecutorThread(EngineParallelExecutor* pExecutor, int index)
+            : m_schedulingEpoch(0),
+              m_pExecutor(pExecutor),
+              m_index(index) {
+        setObjectName(QString("EngineChannels %1").arg(index + 1));
+    }
+
+    int index() const {
+        return m_index;
+    }
+
+    // Only accessed by this thread
+    int m_schedulingEpoch;
+
+  protected:
+    void run() override {
+        m_pExecutor->runThread(this);
+    }
+
+  private:
+    EngineParallelExecutor* const m_pExecutor;
+    const int m_index;
+};
+
+EngineParallelExecutor::EngineParallelExecutor(int helperThreadCount)
+        : m_units(0),
+          m_pTask(nullptr),
+          m_pendingUnits(0),
+          m_bQuit(false),
+#ifdef Q_OS_LINUX
+          m_hasCallingThread(false),
+          m_callingThread(),
+#endif
+          m_schedulingEpoch(0),
+          m_schedulingPolicy(0),
+          m_schedulingPriority(0) {
+    DEBUG_ASSERT(helperThreadCount >= 0);
+    m_threads.reserve(helperThreadCount);
+    for (int i = 0; i < helperThreadCount; ++i) {
+        m_threads.push_back(std::make_unique<EngineParallelExecutorThread>(this, i));
+    }
+}
+
+EngineParallelExecutor::~EngineParallelExecutor() {
+    m_bQuit.store(true);
+    if (helperThreadCount() > 0) {
+        m_wakeup.post(helperThreadCount());
+    }
+    for (const auto& pThread : m_threads) {
+        pThread->wait();
+    }
+}
+
+// static
+int EngineParallelExecutor::defaultHelperThreadCount() {
+    return math_clamp(QThread::idealThreadCount() - 1, 0, kMaxDefaultHelperThreadCount);
+}
+
+void EngineParallelExecutor::start() {
+    for (const auto& pThread : m_threads) {
+        // The real-time priority of the calling thread is adopted later
+        pThread->start(QThread::TimeCriticalPriority);
+    }
+}
+
+void EngineParallelExecutor::execute(Task* pTask, int count) {
+    DEBUG_ASSERT(pTask);
+    DEBUG_ASSERT(count >= 0);
+    if (m_threads.empty() || count <= 1) {
+        for (int index = 0; index < count; ++index) {
+            pTask->run(index);
+        }
+        return;
+    }
+    adoptSchedulingOfCallingThread();
+
+    // All units of the previous execution have been claimed and finished,
+    // no helper thread accesses the task anymore.
+    m_pTask = pTask;
+    m_pendingUnits.store(count, std::memory_order_relaxed);
+    m_units.store(quint64(count) << kUnitCountShift, std::memory_order_release);
+    m_wakeup.post(math_min(count - 1, helperThreadCount()));
+
+    while (runNextUnit()) {
+    }
+    // Wait until the helper threads have finished the units they have
+    // already claimed. Sleeping in a system call would block the engine
+    // callback, so we spin instead. After a while we offer the CPU to
+    // other threads, which never blocks.
+    int spinCount = 0;
+    while (m_pendingUnits.load(std::memory_order_acquire) != 0) {
+        if (spinCount < kMaxSpinCount) {
+            ++spinCount;
+            spinPause();
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+bool EngineParallelExecutor::runNextUnit() {
+    quint64 units = m_units.load(std::memory_order_acquire);
+    for (;;) {
+        const quint64 count = units >> kUnitCountShift;
+        const quint64 index = units & kUnitIndexMask;
+        if (index >= count) {
+            return false;
+        }
+        if (m_units.compare_exchange_weak(units,
+                    units + 1,
+                    std::memory_order_acq_rel,
+                    std::memory_order_acquire)) {
+            m_pTask->run(static_cast<int>(index));
+            m_pendingUnits.fetch_sub(1, std::memory_order_release);
+            return true;
+        }
+    }
+}
+
+void EngineParallelExecutor::runThread(EngineParallelExecutorThread* pThread) {
+    while (!m_bQuit.load()) {
+        // Wait for the next execute() call
+        m_wakeup.wait();
+#ifdef Q_OS_LINUX
+        const int schedulingEpoch = m_schedulingEpoch.load(std::memory_order_acquire);
+        if (pThread->m_schedulingEpoch != schedulingEpoch) {
+            pThread->m_schedulingEpoch = schedulingEpoch;
+            sched_param param = {};
+            param.sched_priority = m_schedulingPriority.load(std::memory_order_relaxed);
+            // Fails without the permission for real-time scheduling
+            pthread_setschedparam(pthread_self(),
+                    m_schedulingPolicy.load(std::memory_order_relaxed),
+                    &param);
+        }
+#else
+        Q_UNUSED(pThread);
+#endif
+        while (runNextUnit()) {
+        }
+    }
+}
+
+void EngineParallelExecutor::adoptSchedulingOfCallingThread() {
+#ifdef Q_OS_LINUX
+    // The audio callback thread changes when the sound devices are restarted
+    const pthread_t callingThread = pthread_self();
+    if (m_hasCallingThread && pthread_equal(m_callingThread, callingThread)) {
+        return;
+    }
+    m_hasCallingThread = true;
+    m_callingThread = callingThread;
+    int policy;
+    sched_param param;
+    if (pthread_getschedparam(callingThread, &policy, &param) != 0) {
+        return;
+    }
+    m_schedulingPolicy.store(policy, std::memory_order_relaxed);
+    m_schedulingPriority.store(param.sched_priority, std::memory_order_relaxed);
+    m_schedulingEpoch.fetch_add(1, std::memory_order_release);
+#endif
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <QThread>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#ifdef Q_OS_LINUX
+#include <pthread.h>
+#endif
+
+#include "engine/engineworkerscheduler.h"
+
+class EngineParallelExecutorThread;
+
+// Distributes independent units of work of the engine callback, e.g. the
+// processing of all channels, onto a fixed pool of helper threads.
+//
+// The calling thread participates in the work and returns when all units
+// have been finished. Idle helper threads sleep until they are woken by the
+// next execution, which requires only a non-blocking system call. Units are
+// claimed through a single atomic variable, i.e. neither the engine callback
+// nor the helper threads need to acquire a mutex. If helper threads are
+// still running units when the calling thread runs out of work, it spins
+// until they have finished without entering a blocking system call. The
+// wait is bounded by the units that have already been claimed.
+//
+// The helper threads adopt the real-time scheduling policy and priority of
+// the calling thread. They are not pinned to CPUs, the scheduler is free
+// to place them next to the calling thread.
+class EngineParallelExecutor {
+  public:
+    class Task {
+      public:
+        virtual ~Task() = default;
+
+        // Invoked concurrently for different indices
+        virtual void run(int index) = 0;
+    };
+
+    explicit EngineParallelExecutor(
+            int helperThreadCount = defaultHelperThreadCount());
+    ~EngineParallelExecutor();
+
+    // The default number of helper threads depends on the number of CPU
+    // cores. One core is reserved for the calling thread.
+    static int defaultHelperThreadCount();
+
+    int helperThreadCount() const {
+        return static_cast<int>(m_threads.size());
+    }
+
+    // Starts all helper threads
+    void start();
+
+    // Invokes pTask->run() for all indices in [0, count) and waits until
+    // all invocations have returned. Real-time safe. Must not be invoked
+    // concurrently.
+    void execute(Task* pTask, int count);
+
+  private:
+    friend class EngineParallelExecutorThread;
+
+    // Claims and runs the next unit of work. Returns false if all units
+    // have already been claimed.
+    bool runNextUnit();
+
+    void runThread(EngineParallelExecutorThread* pThread);
+
+    void adoptSchedulingOfCallingThread();
+
+    // The number of units in the upper and the index of the next
+    // unclaimed unit in the lower 32 bits. Both are updated together
+    // to prevent that a late helper thread claims a unit of the next
+    // execution for the current task.
+    std::atomic<quint64> m_units;
+    // Only modified by the calling thread while no units are claimable
+    Task* m_pTask;
+    // The number of claimed or unclaimed units that are not finished yet
+    std::atomic<int> m_pendingUnits;
+
+    std::vector<std::unique_ptr<EngineParallelExecutorThread>> m_threads;
+    EngineWorkerWakeup m_wakeup;
+    std::atomic<bool> m_bQuit;
+
+#ifdef Q_OS_LINUX
+    // Only accessed by the calling thread
+    bool m_hasCallingThread;
+    pthread_t m_callingThread;
+#endif
+    // Incremented whenever the scheduling of the calling thread changed
+    std::atomic<int> m_schedulingEpoch;
+    std::atomic<int> m_schedulingPolicy;
+    std::atomic<int> m_schedulingPriority;
+};
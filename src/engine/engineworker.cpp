@@ -1,18 +1,20 @@
 // engineworker.cpp
 // Created 6/2/2010 by RJ Ryan (rryan@mit.edu)
 
+#include <QThread>
+
 #include "engine/engineworker.h"
 #include "engine/engineworkerscheduler.h"
+#include "util/assert.h"
 
 EngineWorker::EngineWorker()
-    : m_pScheduler(nullptr) {
-    m_notReady.test_and_set();
+    : m_pScheduler(nullptr),
+      m_state(IDLE),
+      m_backgroundWorkAllowed(true) {
 }
 
 EngineWorker::~EngineWorker() {
-}
-
-void EngineWorker::run() {
+    DEBUG_ASSERT(m_state.load() == STOPPED || m_pScheduler == nullptr);
 }
 
 void EngineWorker::setScheduler(EngineWorkerScheduler* pScheduler) {
@@ -22,15 +24,63 @@ void EngineWorker::setScheduler(EngineWorkerScheduler* pScheduler) {
 }
 
 void EngineWorker::workReady() {
-    m_notReady.clear();
-    VERIFY_OR_DEBUG_ASSERT(m_pScheduler) {
-        return;     
+    int state = m_state.load(std::memory_order_relaxed);
+    while (true) {
+        switch (state) {
+        case IDLE:
+            if (m_state.compare_exchange_weak(state, READY,
+                        std::memory_order_release, std::memory_order_relaxed)) {
+                VERIFY_OR_DEBUG_ASSERT(m_pScheduler) {
+                    return;
+                }
+                m_pScheduler->workerReady();
+                return;
+            }
+            break;
+        case RUNNING:
+            // The thread that is running the worker will schedule it again
+            if (m_state.compare_exchange_weak(state, RUNNING_READY,
+                        std::memory_order_release, std::memory_order_relaxed)) {
+                return;
+            }
+            break;
+        default:
+            // Already scheduled or stopped
+            return;
+        }
     }
-    m_pScheduler->workerReady();
 }
 
-void EngineWorker::wakeIfReady() {
-    if (!m_notReady.test_and_set()) {
-        m_semaRun.release();
+void EngineWorker::stop() {
+    int state = m_state.load(std::memory_order_acquire);
+    while (state != STOPPED) {
+        if (state == RUNNING || state == RUNNING_READY) {
+            // Only happens when unloading a deck. Waiting for the
+            // current unit of work to finish is acceptable.
+            QThread::yieldCurrentThread();
+            state = m_state.load(std::memory_order_acquire);
+            continue;
+        }
+        m_state.compare_exchange_weak(state, STOPPED,
+                std::memory_order_acq_rel, std::memory_order_acquire);
+    }
+    if (m_pScheduler) {
+        m_pScheduler->removeWorker(this);
+    }
+}
+
+bool EngineWorker::tryClaim() {
+    int expected = READY;
+    return m_state.compare_exchange_strong(expected, RUNNING,
+            std::memory_order_acquire, std::memory_order_relaxed);
+}
+
+void EngineWorker::unclaim(bool workPending) {
+    int expected = RUNNING;
+    if (workPending ||
+            !m_state.compare_exchange_strong(expected, IDLE,
+                    std::memory_order_release, std::memory_order_relaxed)) {
+        // Either RUNNING or RUNNING_READY, stop() waits for this transition
+        m_state.store(READY, std::memory_order_release);
     }
 }
@@ -6,34 +6,82 @@
 
 #include <atomic>
 #include <QObject>
-#include <QSemaphore>
-#include <QThread>
 
 // EngineWorker is an interface for running background processing work when the
 // audio callback is not active. While the audio callback is active, an
-// EngineWorker can emit its workReady signal, and an EngineWorkerManager will
+// EngineWorker can call workReady(), and the EngineWorkerScheduler will
 // schedule it for running after the audio callback has completed.
+//
+// Workers don't own a thread. They are run by the small pool of threads
+// of the EngineWorkerScheduler, i.e. many workers share a few threads.
+// A worker is never run by more than one thread at a time.
 
 class EngineWorkerScheduler;
 
-class EngineWorker : public QThread {
+class EngineWorker : public QObject {
     Q_OBJECT
   public:
     EngineWorker();
-    virtual ~EngineWorker();
+    ~EngineWorker() override;
 
-    virtual void run();
+    // Performs a single unit of pending work, e.g. reading a single chunk.
+    // Returns false if no work was pending. Otherwise the worker is
+    // scheduled again until all work is done. Long-running work should
+    // be split into multiple units to share the threads with other workers.
+    virtual bool processWork() = 0;
+
+    // Returns true if the next unit of work is long-running, e.g. loading
+    // and decoding a track. Such work is only run by the background
+    // threads of the scheduler to not delay the short units of other
+    // workers, e.g. reading chunks for playing decks. Could be invoked
+    // from any thread.
+    virtual bool hasBackgroundWork() const {
+        return false;
+    }
 
     void setScheduler(EngineWorkerScheduler* pScheduler);
+
+    // Lock-free and real-time safe. Could be invoked from any thread.
     void workReady();
-    void wakeIfReady();
+
+    // Waits until the worker has finished running and unregisters it
+    // from the scheduler. The worker will not be run again afterwards.
+    // Must be invoked before destruction.
+    void stop();
 
   protected:
-    QSemaphore m_semaRun;
+    // Only valid within processWork(). Background work that is not
+    // allowed must stay pending, i.e. processWork() needs to return true.
+    bool isBackgroundWorkAllowed() const {
+        return m_backgroundWorkAllowed;
+    }
 
   private:
+    friend class EngineWorkerScheduler;
+
+    enum State {
+        IDLE,
+        READY,
+        RUNNING,
+        // New work became ready while running
+        RUNNING_READY,
+        STOPPED,
+    };
+
+    // Invoked by the scheduler to get exclusive access for running the
+    // worker. Fails if the worker is not ready.
+    bool tryClaim();
+    // Invoked by the scheduler after running the worker
+    void unclaim(bool workPending);
+
+    bool isReady() const {
+        return m_state.load(std::memory_order_relaxed) == READY;
+    }
+
     EngineWorkerScheduler* m_pScheduler;
-    std::atomic_flag m_notReady;
+    std::atomic<int> m_state;
+    // Only accessed by the thread that has claimed the worker
+    bool m_backgroundWorkAllowed;
 };
 
 #endif /* ENGINEWORKER_H */
@@ -3,59 +3,314 @@
 
 #include <QtDebug>
 
+#include <algorithm>
+
 #include "engine/engineworker.h"
 #include "engine/engineworkerscheduler.h"
-#include "util/event.h"
+#include "util/assert.h"
+#include "util/counter.h"
+#include "util/math.h"
+
+#ifdef Q_OS_LINUX
+#include <errno.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Reading and decoding is mostly I/O bound. A few threads are
+// sufficient for all decks and samplers.
+constexpr int kMaxDefaultThreadCount = 4;
+
+// Loading multiple samplers at once should neither delay the reads of
+// playing decks nor take forever
+constexpr int kMaxDefaultBackgroundThreadCount = 2;
+
+} // anonymous namespace
+
+class EngineWorkerThread : public QThread {
+  public:
+    EngineWorkerThread(EngineWorkerScheduler* pScheduler, int index, bool background)
+            : m_pScheduler(pScheduler),
+              m_index(index),
+              m_background(background),
+              m_nextSlot(index),
+              m_scanEpoch(0) {
+        setObjectName(QString(background ? "EngineWorker background %1" : "EngineWorker %1")
+                              .arg(index + 1));
+    }
+
+    int index() const {
+        return m_index;
+    }
+
+    bool isBackground() const {
+        return m_background;
+    }
+
+    // Only accessed by this thread. Workers are claimed round-robin
+    // starting at this slot.
+    int m_nextSlot;
+
+    // Odd while this thread is scanning the registry. Workers are only
+    // removed from the registry after all concurrent scans have finished.
+    std::atomic<quint64> m_scanEpoch;
+
+  protected:
+    void run() override {
+        m_pScheduler->runThread(this);
+    }
+
+  private:
+    EngineWorkerScheduler* const m_pScheduler;
+    const int m_index;
+    const bool m_background;
+};
+
+#ifdef Q_OS_LINUX
+EngineWorkerWakeup::EngineWorkerWakeup()
+        : m_fd(eventfd(0, EFD_SEMAPHORE | EFD_CLOEXEC)) {
+    VERIFY_OR_DEBUG_ASSERT(m_fd >= 0) {
+        qWarning() << "EngineWorkerWakeup: Failed to create eventfd,"
+                   << "falling back to QSemaphore";
+    }
+}
+
+EngineWorkerWakeup::~EngineWorkerWakeup() {
+    if (m_fd >= 0) {
+        close(m_fd);
+    }
+}
+
+void EngineWorkerWakeup::post(int count) {
+    DEBUG_ASSERT(count > 0);
+    if (m_fd < 0) {
+        m_semaphore.release(count);
+        return;
+    }
+    const uint64_t value = count;
+    // Never blocks unless the counter overflows
+    if (write(m_fd, &value, sizeof(value)) != sizeof(value)) {
+        // No logging in the real-time thread. A lost wakeup
+        // is recovered by the next post.
+    }
+}
 
-EngineWorkerScheduler::EngineWorkerScheduler(QObject* pParent)
-        : m_bWakeScheduler(false),
+void EngineWorkerWakeup::wait() {
+    if (m_fd < 0) {
+        m_semaphore.acquire();
+        return;
+    }
+    uint64_t value;
+    // Decrements the counter by 1 in semaphore mode
+    while (read(m_fd, &value, sizeof(value)) != sizeof(value)) {
+        if (errno != EINTR) {
+            qWarning() << "EngineWorkerWakeup: Failed to read eventfd" << errno;
+            return;
+        }
+    }
+}
+#else
+EngineWorkerWakeup::EngineWorkerWakeup() {
+}
+
+EngineWorkerWakeup::~EngineWorkerWakeup() {
+}
+
+void EngineWorkerWakeup::post(int count) {
+    DEBUG_ASSERT(count > 0);
+    m_semaphore.release(count);
+}
+
+void EngineWorkerWakeup::wait() {
+    m_semaphore.acquire();
+}
+#endif
+
+EngineWorkerScheduler::EngineWorkerScheduler(
+        int threadCount, int backgroundThreadCount)
+        : m_workerSlotCount(0),
+          m_readyCount(0),
+          m_reservedThreadCount(threadCount),
           m_bQuit(false) {
-    Q_UNUSED(pParent);
+    DEBUG_ASSERT(threadCount > 0);
+    DEBUG_ASSERT(backgroundThreadCount >= 0);
+    for (auto& worker : m_workers) {
+        worker.store(nullptr, std::memory_order_relaxed);
+    }
+    m_threads.reserve(threadCount + backgroundThreadCount);
+    for (int i = 0; i < threadCount; ++i) {
+        m_threads.push_back(std::make_unique<EngineWorkerThread>(this, i, false));
+    }
+    for (int i = 0; i < backgroundThreadCount; ++i) {
+        m_threads.push_back(std::make_unique<EngineWorkerThread>(this, i, true));
+    }
 }
 
 EngineWorkerScheduler::~EngineWorkerScheduler() {
-    m_bQuit = true;
-    m_waitCondition.wakeAll();
-    wait();
+    m_bQuit.store(true);
+    m_wakeup.post(m_reservedThreadCount);
+    if (backgroundThreadCount() > 0) {
+        m_backgroundWakeup.post(backgroundThreadCount());
+    }
+    for (const auto& pThread : m_threads) {
+        pThread->wait();
+    }
+    DEBUG_ASSERT(std::none_of(
+            std::begin(m_workers),
+            std::end(m_workers),
+            [](const std::atomic<EngineWorker*>& worker) {
+                return worker.load() != nullptr;
+            }));
 }
 
-void EngineWorkerScheduler::workerReady() {
-    m_bWakeScheduler = true;
+// static
+int EngineWorkerScheduler::defaultThreadCount() {
+    return math_clamp(QThread::idealThreadCount(), 1, kMaxDefaultThreadCount);
+}
+
+// static
+int EngineWorkerScheduler::defaultBackgroundThreadCount() {
+    return math_clamp(QThread::idealThreadCount() / 2, 1, kMaxDefaultBackgroundThreadCount);
+}
+
+void EngineWorkerScheduler::start(QThread::Priority priority) {
+    for (const auto& pThread : m_threads) {
+        if (pThread->isBackground()) {
+            pThread->start(QThread::LowPriority);
+        } else {
+            pThread->start(priority);
+        }
+    }
 }
 
 void EngineWorkerScheduler::addWorker(EngineWorker* pWorker) {
     DEBUG_ASSERT(pWorker);
-    QMutexLocker locker(&m_mutex);
-    m_workers.push_back(pWorker);
+    for (int slot = 0; slot < MAX_ENGINE_WORKERS; ++slot) {
+        EngineWorker* pExpected = nullptr;
+        if (m_workers[slot].compare_exchange_strong(pExpected, pWorker)) {
+            int slotCount = m_workerSlotCount.load();
+            while (slotCount <= slot &&
+                    !m_workerSlotCount.compare_exchange_weak(slotCount, slot + 1)) {
+            }
+            if (pWorker->isReady()) {
+                // workReady() has been invoked before
+                workerReady();
+            }
+            return;
+        }
+    }
+    // The worker will never run
+    DEBUG_ASSERT(!"Too many engine workers");
+    qWarning() << "EngineWorkerScheduler: Too many engine workers,"
+               << "the maximum is" << MAX_ENGINE_WORKERS;
+}
+
+void EngineWorkerScheduler::removeWorker(EngineWorker* pWorker) {
+    DEBUG_ASSERT(pWorker);
+    const int slotCount = m_workerSlotCount.load();
+    for (int slot = 0; slot < slotCount; ++slot) {
+        EngineWorker* pExpected = pWorker;
+        if (m_workers[slot].compare_exchange_strong(pExpected, nullptr)) {
+            break;
+        }
+    }
+    // Wait until all threads that might have seen the worker while
+    // scanning the registry have finished their scan
+    for (const auto& pThread : m_threads) {
+        const quint64 scanEpoch = pThread->m_scanEpoch.load();
+        if (scanEpoch % 2 == 0) {
+            continue;
+        }
+        while (pThread->m_scanEpoch.load() == scanEpoch) {
+            QThread::yieldCurrentThread();
+        }
+    }
+}
+
+void EngineWorkerScheduler::workerReady() {
+    m_readyCount.fetch_add(1, std::memory_order_release);
 }
 
 void EngineWorkerScheduler::runWorkers() {
-    // Wake the scheduler if we have written a worker-ready message to the
-    // scheduler. There is no race condition in accessing this boolean because
-    // both workerReady and runWorkers are called from the callback thread.
-    if (m_bWakeScheduler) {
-        m_bWakeScheduler = false;
-        m_waitCondition.wakeAll();
-    }
-}
-
-void EngineWorkerScheduler::run() {
-    static const QString tag("EngineWorkerScheduler");
-    while (!m_bQuit) {
-        Event::start(tag);
-        {
-            QMutexLocker lock(&m_mutex);
-            for(const auto& pWorker: m_workers) {
-                pWorker->wakeIfReady();
+    // Wake up as many threads as needed for all ready workers. Posting
+    // the eventfd is a non-blocking system call. In contrast to waking
+    // a condition variable no mutex needs to be locked that could be
+    // held by a thread with a lower priority.
+    const int readyCount = m_readyCount.exchange(0, std::memory_order_acquire);
+    if (readyCount > 0) {
+        // The ready workers might have either kind of work
+        m_wakeup.post(math_min(readyCount, m_reservedThreadCount));
+        if (backgroundThreadCount() > 0) {
+            m_backgroundWakeup.post(math_min(readyCount, backgroundThreadCount()));
+        }
+    }
+}
+
+EngineWorker* EngineWorkerScheduler::claimWorker(EngineWorkerThread* pThread) {
+    pThread->m_scanEpoch.fetch_add(1); // odd: scanning
+    EngineWorker* pClaimedWorker = nullptr;
+    const int slotCount = m_workerSlotCount.load();
+    // Background work is run by the reserved threads only if there are
+    // no background threads
+    const bool backgroundWorkAllowed =
+            pThread->isBackground() || backgroundThreadCount() == 0;
+    // The 1st pass only considers workers in the thread's own share of
+    // slots, the 2nd pass steals workers from the other threads. The
+    // background threads don't own any slots.
+    for (int pass = 0; pass < 2 && !pClaimedWorker; ++pass) {
+        for (int i = 0; i < slotCount; ++i) {
+            const int slot = (pThread->m_nextSlot + i) % slotCount;
+            const bool ownSlot = !pThread->isBackground() &&
+                    slot % m_reservedThreadCount == pThread->index();
+            if (ownSlot != (pass == 0)) {
+                continue;
+            }
+            EngineWorker* pWorker = m_workers[slot].load();
+            if (pWorker && pWorker->isReady() &&
+                    (backgroundWorkAllowed || !pWorker->hasBackgroundWork()) &&
+                    pWorker->tryClaim()) {
+                pClaimedWorker = pWorker;
+                // Continue after this slot next time to not starve
+                // other workers
+                pThread->m_nextSlot = slot + 1;
+                if (pass > 0) {
+                    Counter("EngineWorkerScheduler stolen workers")++;
+                }
+                break;
             }
         }
-        Event::end(tag);
-        {
-            QMutexLocker lock(&m_mutex);
-            if (!m_bQuit) {
-                // Wait for next runWorkers() call
-                m_waitCondition.wait(&m_mutex); // unlock mutex and wait
+    }
+    pThread->m_scanEpoch.fetch_add(1); // even: finished
+    return pClaimedWorker;
+}
+
+void EngineWorkerScheduler::runThread(EngineWorkerThread* pThread) {
+    while (!m_bQuit.load()) {
+        EngineWorker* pWorker = claimWorker(pThread);
+        if (!pWorker) {
+            // Wait for the next runWorkers() call
+            if (pThread->isBackground()) {
+                m_backgroundWakeup.wait();
+            } else {
+                m_wakeup.wait();
             }
+            continue;
+        }
+        const bool backgroundWorkAllowed =
+                pThread->isBackground() || backgroundThreadCount() == 0;
+        pWorker->m_backgroundWorkAllowed = backgroundWorkAllowed;
+        // Stopping the claimed worker is delayed until unclaimed
+        const bool workPending = pWorker->processWork();
+        // The worker must not be accessed after being unclaimed
+        const bool backgroundWorkPending =
+                !backgroundWorkAllowed && workPending && pWorker->hasBackgroundWork();
+        pWorker->unclaim(workPending);
+        if (backgroundWorkPending) {
+            // The background work became available while this thread was
+            // running the worker
+            m_backgroundWakeup.post(1);
         }
     }
 }
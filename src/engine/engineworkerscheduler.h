@@ -1,41 +1,109 @@
 #ifndef ENGINEWORKERSCHEDULER_H
 #define ENGINEWORKERSCHEDULER_H
 
-#include <QMutex>
-#include <QThreadPool>
-#include <QWaitCondition>
+#include <QSemaphore>
+#include <QThread>
 
-#include "util/fifo.h"
+#include <atomic>
+#include <memory>
+#include <vector>
 
-// The max engine workers that can be expected to run within a callback
-// (e.g. the max that we will schedule). Must be a power of 2.
-#define MAX_ENGINE_WORKERS 32
+// The max engine workers that can be registered at the same time, i.e.
+// the capacity of the lock-free worker registry. Each deck, sampler, and
+// preview deck owns a single worker.
+#define MAX_ENGINE_WORKERS 256
 
 class EngineWorker;
+class EngineWorkerThread;
 
-class EngineWorkerScheduler : public QThread {
-    Q_OBJECT
+// Counting semaphore that could be posted from the real-time thread
+// without acquiring any lock. On Linux an eventfd is used, posting is a
+// single non-blocking write(). Other platforms fall back to QSemaphore.
+class EngineWorkerWakeup {
   public:
-    EngineWorkerScheduler(QObject* pParent=NULL);
-    virtual ~EngineWorkerScheduler();
+    EngineWorkerWakeup();
+    ~EngineWorkerWakeup();
 
+    void post(int count);
+    void wait();
+
+  private:
+#ifdef Q_OS_LINUX
+    int m_fd;
+#endif
+    QSemaphore m_semaphore;
+};
+
+// Runs all EngineWorkers on a small pool of threads. Workers that are
+// ready are run after the audio callback has completed.
+//
+// Long-running background work, e.g. loading a track, is only run by a
+// few additional background threads with a lower priority. The other
+// threads are reserved for the short units of work that the decks need
+// for playing, e.g. reading chunks.
+//
+// Workers are registered in a fixed-size lock-free registry. Each thread
+// of the pool prefers the workers in its own share of the registry and
+// steals ready workers from the other threads when running out of work.
+// Neither the engine callback nor the threads of the pool need to
+// acquire a mutex.
+class EngineWorkerScheduler {
+  public:
+    explicit EngineWorkerScheduler(
+            int threadCount = defaultThreadCount(),
+            int backgroundThreadCount = defaultBackgroundThreadCount());
+    ~EngineWorkerScheduler();
+
+    // The default number of threads depends on the number of CPU cores.
+    static int defaultThreadCount();
+    static int defaultBackgroundThreadCount();
+
+    // The number of all threads, including the background threads
+    int threadCount() const {
+        return static_cast<int>(m_threads.size());
+    }
+    int backgroundThreadCount() const {
+        return threadCount() - m_reservedThreadCount;
+    }
+
+    // Starts all threads of the pool. The background threads are
+    // started with a lower priority.
+    void start(QThread::Priority priority = QThread::InheritPriority);
+
+    // Lock-free. Must not be invoked concurrently with removeWorker()
+    // for the same worker.
     void addWorker(EngineWorker* pWorker);
+    // Waits until no thread of the pool accesses the worker anymore
+    void removeWorker(EngineWorker* pWorker);
+
+    // Invoked at the end of the engine callback. Real-time safe.
     void runWorkers();
+    // Invoked by workers that became ready. Lock-free.
     void workerReady();
 
-  protected:
-    void run();
-
   private:
-    // Indicates whether workerReady has been called since the last time
-    // runWorkers was run. This should only be touched from the engine callback.
-    bool m_bWakeScheduler;
+    friend class EngineWorkerThread;
+
+    // Claims a ready worker for the given thread or returns nullptr.
+    EngineWorker* claimWorker(EngineWorkerThread* pThread);
+
+    void runThread(EngineWorkerThread* pThread);
+
+    std::atomic<EngineWorker*> m_workers[MAX_ENGINE_WORKERS];
+    // Upper bound of all occupied slots in m_workers
+    std::atomic<int> m_workerSlotCount;
 
-    std::vector<EngineWorker*> m_workers;
+    // The number of workers that became ready since the last
+    // invocation of runWorkers()
+    std::atomic<int> m_readyCount;
 
-    QWaitCondition m_waitCondition;
-    QMutex m_mutex;
-    volatile bool m_bQuit;
+    // The first threads in m_threads are reserved for short units of
+    // work, followed by the background threads
+    const int m_reservedThreadCount;
+    std::vector<std::unique_ptr<EngineWorkerThread>> m_threads;
+    EngineWorkerWakeup m_wakeup;
+    EngineWorkerWakeup m_backgroundWakeup;
+    std::atomic<bool> m_bQuit;
 };
 
 #endif /* ENGINEWORKERSCHEDULER_H */
@@ -5,6 +5,10 @@
 #include <cstdio>
 #include <fidlib.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include "engine/engineobject.h"
 #include "util/sample.h"
 
@@ -14,6 +18,116 @@
 // You may also use the app fiview for analysis
 #define IIR_ANALYSIS 0
 
+// Both channels of a stereo frame in double precision. The filters
+// process the left and right channel in lockstep in the 2 lanes of
+// a SIMD register if available. The operations are the same as for
+// scalar doubles, i.e. the results are identical for both channels.
+//
+// Single precision would allow 4 lanes, but it is not sufficient
+// for the high order filters with low corner frequencies, whose
+// poles are close to the unit circle.
+class IIRStereoSample {
+  public:
+    IIRStereoSample() = default;
+#ifdef __SSE2__
+    IIRStereoSample(double left, double right)
+            : m_value(_mm_set_pd(right, left)) {
+    }
+
+    static IIRStereoSample load(const CSAMPLE* pFrame) {
+        return IIRStereoSample(pFrame[0], pFrame[1]);
+    }
+    void store(CSAMPLE* pFrame) const {
+        _mm_storel_pi(reinterpret_cast<__m64*>(pFrame),
+                _mm_cvtpd_ps(m_value));
+    }
+
+    double left() const {
+        return _mm_cvtsd_f64(m_value);
+    }
+    double right() const {
+        return _mm_cvtsd_f64(_mm_unpackhi_pd(m_value, m_value));
+    }
+
+    IIRStereoSample operator+(IIRStereoSample rhs) const {
+        return IIRStereoSample(_mm_add_pd(m_value, rhs.m_value));
+    }
+    IIRStereoSample operator-(IIRStereoSample rhs) const {
+        return IIRStereoSample(_mm_sub_pd(m_value, rhs.m_value));
+    }
+    IIRStereoSample operator-() const {
+        // Flip the sign bits like a scalar negation
+        return IIRStereoSample(_mm_xor_pd(m_value, _mm_set1_pd(-0.0)));
+    }
+    IIRStereoSample operator*(double rhs) const {
+        return IIRStereoSample(_mm_mul_pd(m_value, _mm_set1_pd(rhs)));
+    }
+    IIRStereoSample operator*(IIRStereoSample rhs) const {
+        return IIRStereoSample(_mm_mul_pd(m_value, rhs.m_value));
+    }
+
+  private:
+    explicit IIRStereoSample(__m128d value)
+            : m_value(value) {
+    }
+
+    __m128d m_value;
+#else
+    IIRStereoSample(double left, double right)
+            : m_left(left),
+              m_right(right) {
+    }
+
+    static IIRStereoSample load(const CSAMPLE* pFrame) {
+        return IIRStereoSample(pFrame[0], pFrame[1]);
+    }
+    void store(CSAMPLE* pFrame) const {
+        pFrame[0] = static_cast<CSAMPLE>(m_left);
+        pFrame[1] = static_cast<CSAMPLE>(m_right);
+    }
+
+    double left() const {
+        return m_left;
+    }
+    double right() const {
+        return m_right;
+    }
+
+    IIRStereoSample operator+(IIRStereoSample rhs) const {
+        return IIRStereoSample(m_left + rhs.m_left, m_right + rhs.m_right);
+    }
+    IIRStereoSample operator-(IIRStereoSample rhs) const {
+        return IIRStereoSample(m_left - rhs.m_left, m_right - rhs.m_right);
+    }
+    IIRStereoSample operator-() const {
+        return IIRStereoSample(-m_left, -m_right);
+    }
+    IIRStereoSample operator*(double rhs) const {
+        return IIRStereoSample(m_left * rhs, m_right * rhs);
+    }
+    IIRStereoSample operator*(IIRStereoSample rhs) const {
+        return IIRStereoSample(m_left * rhs.m_left, m_right * rhs.m_right);
+    }
+
+  private:
+    double m_left;
+    double m_right;
+#endif
+
+  public:
+    IIRStereoSample& operator+=(IIRStereoSample rhs) {
+        return *this = *this + rhs;
+    }
+    IIRStereoSample& operator-=(IIRStereoSample rhs) {
+        return *this = *this - rhs;
+    }
+};
+
+inline IIRStereoSample operator*(double lhs, IIRStereoSample rhs) {
+    // Multiplication is commutative, even for IEEE 754
+    return rhs * lhs;
+}
+
 enum IIRPass {
     IIR_LP,
     IIR_BP,
@@ -82,11 +196,9 @@ class EngineFilterIIR : public EngineFilterIIRBase {
 
     void initBuffers() {
         // Copy the current buffers into the old buffers
-        memcpy(m_oldBuf1, m_buf1, sizeof(m_buf1));
-        memcpy(m_oldBuf2, m_buf2, sizeof(m_buf2));
+        memcpy(m_oldBuf, m_buf, sizeof(m_buf));
         // Set the current buffers to 0
-        memset(m_buf1, 0, sizeof(m_buf1));
-        memset(m_buf2, 0, sizeof(m_buf2));
+        memset(m_buf, 0, sizeof(m_buf));
         m_doRamping = true;
     }
 
@@ -205,8 +317,8 @@ class EngineFilterIIR : public EngineFilterIIRBase {
                          const int iBufferSize) {
         if (!m_doRamping) {
             for (int i = 0; i < iBufferSize; i += 2) {
-                pOutput[i] = processSample(m_coef, m_buf1, pIn[i]);
-                pOutput[i+1] = processSample(m_coef, m_buf2, pIn[i + 1]);
+                processSample(m_coef, m_buf,
+                        IIRStereoSample::load(&pIn[i])).store(&pOutput[i]);
             }
         } else {
             double cross_mix = 0.0;
@@ -223,32 +335,25 @@ class EngineFilterIIR : public EngineFilterIIRBase {
                 // of the new filter but it turns out that this produces
                 // a gain drop due to the filter delay which is more
                 // conspicuous than the settling noise.
-                double old1;
-                double old2;
+                const IIRStereoSample in = IIRStereoSample::load(&pIn[i]);
+                IIRStereoSample old;
                 if (!m_doStart) {
                     // Process old filter, but only if we do not do a fresh start
-                    old1 = processSample(m_oldCoef, m_oldBuf1, pIn[i]);
-                    old2 = processSample(m_oldCoef, m_oldBuf2, pIn[i + 1]);
+                    old = processSample(m_oldCoef, m_oldBuf, in);
                 } else {
                     if (m_startFromDry) {
-                        old1 = pIn[i];
-                        old2 = pIn[i + 1];
+                        old = in;
                     } else {
-                        old1 = 0;
-                        old2 = 0;
+                        old = IIRStereoSample(0, 0);
                     }
                 }
-                double new1 = processSample(m_coef, m_buf1, pIn[i]);
-                double new2 = processSample(m_coef, m_buf2, pIn[i + 1]);
+                const IIRStereoSample new_ = processSample(m_coef, m_buf, in);
 
                 if (i < iBufferSize / 2) {
-                    pOutput[i] = old1;
-                    pOutput[i + 1] = old2;
+                    old.store(&pOutput[i]);
                 } else {
-                    pOutput[i] = new1 * cross_mix +
-                                 old1 * (1.0 - cross_mix);
-                    pOutput[i + 1] = new2  * cross_mix +
-                                     old2 * (1.0 - cross_mix);
+                    (new_ * cross_mix + old * (1.0 - cross_mix))
+                            .store(&pOutput[i]);
                     cross_mix += cross_inc;
                 }
             }
@@ -258,11 +363,14 @@ class EngineFilterIIR : public EngineFilterIIRBase {
     }
 
   protected:
-    inline double processSample(double* coef, double* buf, double val);
+    // Processes a single sample of either a single channel (double)
+    // or of both stereo channels at once (IIRStereoSample)
+    template<typename T>
+    static inline T processSample(const double* coef, T* buf, T val);
+
     inline void pauseFilterInner() {
         // Set the current buffers to 0
-        memset(m_buf1, 0, sizeof(m_buf1));
-        memset(m_buf2, 0, sizeof(m_buf2));
+        memset(m_buf, 0, sizeof(m_buf));
         m_doRamping = true;
         m_doStart = true;
     }
@@ -271,15 +379,10 @@ class EngineFilterIIR : public EngineFilterIIRBase {
     // Old coefficients needed for ramping
     double m_oldCoef[SIZE + 1];
 
-    // Channel 1 state
-    double m_buf1[SIZE];
-    // Old channel 1 buffer needed for ramping
-    double m_oldBuf1[SIZE];
-
-    // Channel 2 state
-    double m_buf2[SIZE];
-    // Old channel 2 buffer needed for ramping
-    double m_oldBuf2[SIZE];
+    // Stereo channel state
+    IIRStereoSample m_buf[SIZE];
+    // Old stereo channel buffer needed for ramping
+    IIRStereoSample m_oldBuf[SIZE];
 
     // Flag set to true if ramping needs to be done
     bool m_doRamping;
@@ -290,10 +393,11 @@ class EngineFilterIIR : public EngineFilterIIRBase {
 };
 
 template<>
-inline double EngineFilterIIR<2, IIR_LP>::processSample(double* coef,
-                                                        double* buf,
-                                                        double val) {
-    double tmp, fir, iir;
+template<typename T>
+inline T EngineFilterIIR<2, IIR_LP>::processSample(const double* coef,
+        T* buf,
+        T val) {
+    T tmp, fir, iir;
     tmp = buf[0]; buf[0] = buf[1];
     iir = val * coef[0];
     iir -= coef[1] * tmp; fir = tmp;
@@ -304,10 +408,11 @@ inline double EngineFilterIIR<2, IIR_LP>::processSample(double* coef,
 }
 
 template<>
-inline double EngineFilterIIR<2, IIR_BP>::processSample(double* coef,
-                                                        double* buf,
-                                                        double val) {
-    double tmp, fir, iir;
+template<typename T>
+inline T EngineFilterIIR<2, IIR_BP>::processSample(const double* coef,
+        T* buf,
+        T val) {
+    T tmp, fir, iir;
     tmp = buf[0]; buf[0] = buf[1];
     iir = val * coef[0];
     iir -= coef[1] * tmp; fir = -tmp;
@@ -318,10 +423,11 @@ inline double EngineFilterIIR<2, IIR_BP>::processSample(double* coef,
 }
 
 template<>
-inline double EngineFilterIIR<2, IIR_HP>::processSample(double* coef,
-                                                        double* buf,
-                                                        double val) {
-    double tmp, fir, iir;
+template<typename T>
+inline T EngineFilterIIR<2, IIR_HP>::processSample(const double* coef,
+        T* buf,
+        T val) {
+    T tmp, fir, iir;
     tmp = buf[0]; buf[0] = buf[1];
     iir = val * coef[0];
     iir -= coef[1] * tmp; fir = tmp;
@@ -332,10 +438,11 @@ inline double EngineFilterIIR<2, IIR_HP>::processSample(double* coef,
 }
 
 template<>
-inline double EngineFilterIIR<4, IIR_LP>::processSample(double* coef,
-                                                        double* buf,
-                                                        double val) {
-    double tmp, fir, iir;
+template<typename T>
+inline T EngineFilterIIR<4, IIR_LP>::processSample(const double* coef,
+        T* buf,
+        T val) {
+    T tmp, fir, iir;
     tmp = buf[0]; buf[0] = buf[1]; buf[1] = buf[2]; buf[2] = buf[3];
     iir = val * coef[0];
     iir -= coef[1] * tmp; fir = tmp;
@@ -351,10 +458,11 @@ inline double EngineFilterIIR<4, IIR_LP>::processSample(double* coef,
 }
 
 template<>
-inline double EngineFilterIIR<8, IIR_BP>::processSample(double* coef,
-                                                        double* buf,
-                                                        double val) {
-    double tmp, fir, iir;
+template<typename T>
+inline T EngineFilterIIR<8, IIR_BP>::processSample(const double* coef,
+        T* buf,
+        T val) {
+    T tmp, fir, iir;
     tmp = buf[0]; buf[0] = buf[1]; buf[1] = buf[2]; buf[2] = buf[3];
     buf[3] = buf[4]; buf[4] = buf[5]; buf[5] = buf[6]; buf[6] = buf[7];
     iir = val * coef[0];
@@ -381,10 +489,11 @@ inline double EngineFilterIIR<8, IIR_BP>::processSample(double* coef,
 }
 
 template<>
-inline double EngineFilterIIR<4, IIR_HP>::processSample(double* coef,
-                                                        double* buf,
-                                                        double val) {
-    double tmp, fir, iir;
+template<typename T>
+inline T EngineFilterIIR<4, IIR_HP>::processSample(const double* coef,
+        T* buf,
+        T val) {
+    T tmp, fir, iir;
     tmp = buf[0]; buf[0] = buf[1]; buf[1] = buf[2]; buf[2] = buf[3];
     iir= val * coef[0];
     iir -= coef[1] * tmp; fir = tmp;
@@ -400,10 +509,11 @@ inline double EngineFilterIIR<4, IIR_HP>::processSample(double* coef,
 }
 
 template<>
-inline double EngineFilterIIR<8, IIR_LP>::processSample(double* coef,
-                                                        double* buf,
-                                                        double val) {
-    double tmp, fir, iir;
+template<typename T>
+inline T EngineFilterIIR<8, IIR_LP>::processSample(const double* coef,
+        T* buf,
+        T val) {
+    T tmp, fir, iir;
     tmp = buf[0]; buf[0] = buf[1]; buf[1] = buf[2]; buf[2] = buf[3];
     buf[3] = buf[4]; buf[4] = buf[5]; buf[5] = buf[6]; buf[6] = buf[7];
     iir = val * coef[0];
@@ -430,10 +540,11 @@ inline double EngineFilterIIR<8, IIR_LP>::processSample(double* coef,
 }
 
 template<>
-inline double EngineFilterIIR<16, IIR_BP>::processSample(double* coef,
-                                                         double* buf,
-                                                         double val) {
-    double tmp, fir, iir;
+template<typename T>
+inline T EngineFilterIIR<16, IIR_BP>::processSample(const double* coef,
+        T* buf,
+        T val) {
+    T tmp, fir, iir;
     tmp = buf[0]; buf[0] = buf[1]; buf[1] = buf[2]; buf[2] = buf[3];
     buf[3] = buf[4]; buf[4] = buf[5]; buf[5] = buf[6]; buf[6] = buf[7];
     buf[7] = buf[8]; buf[8] = buf[9]; buf[9] = buf[10]; buf[10] = buf[11];
@@ -482,10 +593,11 @@ inline double EngineFilterIIR<16, IIR_BP>::processSample(double* coef,
 }
 
 template<>
-inline double EngineFilterIIR<8, IIR_HP>::processSample(double* coef,
-                                                        double* buf,
-                                                        double val) {
-    double tmp, fir, iir;
+template<typename T>
+inline T EngineFilterIIR<8, IIR_HP>::processSample(const double* coef,
+        T* buf,
+        T val) {
+    T tmp, fir, iir;
     tmp = buf[0]; buf[0] = buf[1]; buf[1] = buf[2]; buf[2] = buf[3];
     buf[3] = buf[4]; buf[4] = buf[5]; buf[5] = buf[6]; buf[6] = buf[7];
     iir = val * coef[0];
@@ -513,10 +625,11 @@ inline double EngineFilterIIR<8, IIR_HP>::processSample(double* coef,
 
 // IIR_LP and IIR_HP use the same processSample routine
 template<>
-inline double EngineFilterIIR<5, IIR_BP>::processSample(double* coef,
-                                                        double* buf,
-                                                        double val) {
-    double tmp, fir, iir;
+template<typename T>
+inline T EngineFilterIIR<5, IIR_BP>::processSample(const double* coef,
+        T* buf,
+        T val) {
+    T tmp, fir, iir;
     tmp = buf[0]; buf[0] = buf[1];
     iir = val * coef[0];
     iir -= coef[1] * tmp; fir = coef[2] * tmp;
@@ -527,10 +640,11 @@ inline double EngineFilterIIR<5, IIR_BP>::processSample(double* coef,
 }
 
 template<>
-inline double EngineFilterIIR<4, IIR_LPMO>::processSample(double* coef,
-                                                        double* buf,
-                                                        double val) {
-   double tmp, fir, iir;
+template<typename T>
+inline T EngineFilterIIR<4, IIR_LPMO>::processSample(const double* coef,
+        T* buf,
+        T val) {
+   T tmp, fir, iir;
    tmp= buf[0]; buf[0] = buf[1]; buf[1] = buf[2]; buf[2] = buf[3];
    iir= val * coef[0];
    iir -= coef[1]*tmp; fir= tmp;
@@ -553,10 +667,11 @@ inline double EngineFilterIIR<4, IIR_LPMO>::processSample(double* coef,
 
 
 template<>
-inline double EngineFilterIIR<4, IIR_HPMO>::processSample(double* coef,
-                                                        double* buf,
-                                                        double val) {
-   double tmp, fir, iir;
+template<typename T>
+inline T EngineFilterIIR<4, IIR_HPMO>::processSample(const double* coef,
+        T* buf,
+        T val) {
+   T tmp, fir, iir;
    tmp= buf[0]; buf[0] = buf[1]; buf[1] = buf[2]; buf[2] = buf[3];
    iir= val * coef[0];
    iir -= coef[1]*tmp; fir= -tmp;
@@ -578,10 +693,11 @@ inline double EngineFilterIIR<4, IIR_HPMO>::processSample(double* coef,
 }
 
 template<>
-inline double EngineFilterIIR<2, IIR_LP2>::processSample(double* coef,
-                                                        double* buf,
-                                                        double val) {
-    double tmp, fir, iir;
+template<typename T>
+inline T EngineFilterIIR<2, IIR_LP2>::processSample(const double* coef,
+        T* buf,
+        T val) {
+    T tmp, fir, iir;
     tmp = buf[0];
     iir = val * coef[0];
     iir -= coef[1] * tmp; fir = tmp;
@@ -599,10 +715,11 @@ inline double EngineFilterIIR<2, IIR_LP2>::processSample(double* coef,
 
 
 template<>
-inline double EngineFilterIIR<2, IIR_HP2>::processSample(double* coef,
-                                                        double* buf,
-                                                        double val) {
-    double tmp, fir, iir;
+template<typename T>
+inline T EngineFilterIIR<2, IIR_HP2>::processSample(const double* coef,
+        T* buf,
+        T val) {
+    T tmp, fir, iir;
     tmp = buf[0];
     iir = val * -coef[0]; // swap gain to be in phase with LP2
     iir -= coef[1] * tmp; fir = -tmp;
@@ -12,9 +12,15 @@
 
 static const int kNumChannels = 2;
 
+// Entries are only added on direction changes, loops, and seeks and are
+// consumed a few callbacks later. Even scratching never comes close.
+static const unsigned int kReadAheadLogCapacity = 1024;
+
 ReadAheadManager::ReadAheadManager()
         : m_pLoopingControl(NULL),
           m_pRateControl(NULL),
+          // One slot is always kept empty
+          m_readAheadLog(kReadAheadLogCapacity + 1),
           m_currentPosition(0),
           m_pReader(NULL),
           m_pCrossFadeBuffer(SampleUtil::alloc(MAX_BUFFER_LEN)),
@@ -26,6 +32,8 @@ ReadAheadManager::ReadAheadManager(CachingReader* pReader,
                                    LoopingControl* pLoopingControl)
         : m_pLoopingControl(pLoopingControl),
           m_pRateControl(NULL),
+          // One slot is always kept empty
+          m_readAheadLog(kReadAheadLogCapacity + 1),
           m_currentPosition(0),
           m_pReader(pReader),
           m_pCrossFadeBuffer(SampleUtil::alloc(MAX_BUFFER_LEN)),
@@ -223,13 +231,18 @@ void ReadAheadManager::addReadLogEntry(double virtualPlaypositionStart,
                                        double virtualPlaypositionEndNonInclusive) {
     ReadLogEntry newEntry(virtualPlaypositionStart,
                           virtualPlaypositionEndNonInclusive);
-    if (m_readAheadLog.size() > 0) {
+    if (!m_readAheadLog.isEmpty()) {
         ReadLogEntry& last = m_readAheadLog.back();
         if (last.merge(newEntry)) {
             return;
         }
     }
-    m_readAheadLog.push_back(newEntry);
+    if (m_readAheadLog.isFull()) {
+        // Should never happen. The play position only becomes inaccurate
+        // if the dropped entry has not been consumed yet.
+        m_readAheadLog.skip(1);
+    }
+    m_readAheadLog.write(&newEntry, 1);
 }
 
 // Not thread-save, call from engine thread only
@@ -240,7 +253,7 @@ double ReadAheadManager::getFilePlaypositionFromLog(
         return currentFilePlayposition;
     }
 
-    if (m_readAheadLog.size() == 0) {
+    if (m_readAheadLog.isEmpty()) {
         // No log entries to read from.
         qDebug() << this << "No read ahead log entries to read from. Case not currently handled.";
         // TODO(rryan) log through a stats pipe eventually
@@ -249,7 +262,7 @@ double ReadAheadManager::getFilePlaypositionFromLog(
 
     double filePlayposition = 0;
     bool shouldNotifySeek = false;
-    while (m_readAheadLog.size() > 0 && numConsumedSamples > 0) {
+    while (!m_readAheadLog.isEmpty() && numConsumedSamples > 0) {
         ReadLogEntry& entry = m_readAheadLog.front();
 
         // Notify EngineControls that we have taken a seek.
@@ -267,7 +280,7 @@ double ReadAheadManager::getFilePlaypositionFromLog(
 
         if (entry.length() == 0) {
             // This entry is empty now.
-            m_readAheadLog.pop_front();
+            m_readAheadLog.skip(1);
         }
         shouldNotifySeek = true;
     }
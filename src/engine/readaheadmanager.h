@@ -5,9 +5,9 @@
 
 #include <QList>
 #include <QPair>
-#include <list>
 
 #include "engine/cachingreader/cachingreader.h"
+#include "util/circularbuffer.h"
 #include "util/math.h"
 #include "util/types.h"
 
@@ -65,6 +65,11 @@ class ReadAheadManager {
         double virtualPlaypositionStart;
         double virtualPlaypositionEndNonInclusive;
 
+        ReadLogEntry()
+                : virtualPlaypositionStart(0),
+                  virtualPlaypositionEndNonInclusive(0) {
+        }
+
         ReadLogEntry(double virtualPlaypositionStart,
                      double virtualPlaypositionEndNonInclusive) {
             this->virtualPlaypositionStart = virtualPlaypositionStart;
@@ -116,7 +121,9 @@ class ReadAheadManager {
 
     LoopingControl* m_pLoopingControl;
     RateControl* m_pRateControl;
-    std::list<ReadLogEntry> m_readAheadLog;
+    /// Preallocated, because the log is modified in the engine callback.
+    /// The oldest entries are dropped if the log overflows.
+    CircularBuffer<ReadLogEntry> m_readAheadLog;
     double m_currentPosition;
     CachingReader* m_pReader;
     CSAMPLE* m_pCrossFadeBuffer;
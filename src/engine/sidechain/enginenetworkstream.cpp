@@ -44,7 +44,8 @@ EngineNetworkStream::EngineNetworkStream(int numOutputChannels,
       m_inputStreamStartTimeUs(-1),
       m_inputStreamFramesWritten(0),
       m_inputStreamFramesRead(0),
-      m_outputWorkers(BROADCAST_MAX_CONNECTIONS) {
+      // Each connection might use a separate tap for its shared encoder
+      m_outputWorkers(2 * BROADCAST_MAX_CONNECTIONS) {
     if (numInputChannels) {
         m_pInputFifo = new FIFO<CSAMPLE>(numInputChannels * kBufferFrames);
     }
@@ -178,6 +179,7 @@ qint64 EngineNetworkStream::getNetworkTimeUs() {
 }
 
 void EngineNetworkStream::addOutputWorker(NetworkOutputStreamWorkerPtr pWorker) {
+    QMutexLocker locker(&m_outputWorkersMutex);
     if (nextOutputSlotAvailable() < 0) {
         kLogger.warning() << "addWorker: can't add worker:"
                           << "no free slot left in internal list";
@@ -200,6 +202,7 @@ void EngineNetworkStream::addOutputWorker(NetworkOutputStreamWorkerPtr pWorker)
 }
 
 void EngineNetworkStream::removeOutputWorker(NetworkOutputStreamWorkerPtr pWorker) {
+    QMutexLocker locker(&m_outputWorkersMutex);
     int index = m_outputWorkers.indexOf(pWorker);
     if(index > -1) {
         m_outputWorkers[index].clear();
@@ -3,6 +3,7 @@
 
 #include <engine/sidechain/networkoutputstreamworker.h>
 #include <engine/sidechain/networkinputstreamworker.h>
+#include <QMutex>
 #include <QVector>
 
 #include "util/types.h"
@@ -61,6 +62,10 @@ class EngineNetworkStream {
     // the workers are then performed on thread-safe QSharedPointers and not
     // onto the thread-unsafe QVector
     QVector<NetworkOutputStreamWorkerPtr> m_outputWorkers;
+    // Serializes adding and removing workers. Besides the connections
+    // that are managed by the GUI thread the taps of the shared encoders
+    // are added and removed by the connection threads.
+    QMutex m_outputWorkersMutex;
 };
 
 #endif /* ENGINENETWORKSTREAM_H_ */
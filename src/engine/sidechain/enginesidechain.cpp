@@ -15,43 +15,99 @@
 ***************************************************************************/
 
 // This class provides a way to do audio processing that does not need
-// to be executed in real-time. For example, broadcast encoding
-// and recording encoding can be done here. This class uses double-buffering
-// to increase the amount of time the CPU has to do whatever work needs to
-// be done, and that work is executed in a separate thread. (Threading
-// allows the next buffer to be filled while processing a buffer that's is
-// already full.)
+// to be executed in real-time. For example, recording encoding can be
+// done here. Each worker is executed in a separate thread and reads
+// the samples from a shared ring buffer. (Threading allows the next
+// buffer to be filled while processing a buffer that's already full,
+// and prevents that a slow worker delays the other workers.)
 
 #include "engine/sidechain/enginesidechain.h"
 
 #include <QtDebug>
 #include <QMutexLocker>
+#include <QThread>
 
 #include "engine/sidechain/sidechainworker.h"
 #include "engine/engine.h"
 #include "util/counter.h"
 #include "util/event.h"
 #include "util/sample.h"
+#include "util/stat.h"
 #include "util/timer.h"
 #include "util/trace.h"
 
 #define SIDECHAIN_BUFFER_SIZE 65536
 
+namespace {
+
+// Wake up the workers after this number of samples has been written.
+// Leaves enough headroom before samples are overwritten.
+constexpr int kWakeupSamples = SIDECHAIN_BUFFER_SIZE / 8;
+
+// Samples that have been written since the last wakeup are processed
+// after this timeout at the latest.
+constexpr unsigned long kMaxWaitMillis = 100;
+
+} // anonymous namespace
+
+class EngineSideChain::WorkerThread : public QThread {
+  public:
+    WorkerThread(EngineSideChain* pSideChain,
+            SideChainWorker* pWorker,
+            int index)
+            : m_pSideChain(pSideChain),
+              m_pWorker(pWorker),
+              m_reader(&pSideChain->m_sampleBuffer),
+              m_pWorkBuffer(SampleUtil::alloc(SIDECHAIN_BUFFER_SIZE)),
+              m_lagTag(QString("EngineSideChain worker %1 lag").arg(index)),
+              m_overflowTag(QString("EngineSideChain worker %1 overflow").arg(index)) {
+        setObjectName(QString("EngineSideChain %1").arg(index));
+    }
+    ~WorkerThread() override {
+        SampleUtil::free(m_pWorkBuffer);
+    }
+
+    SideChainWorker* worker() const {
+        return m_pWorker;
+    }
+    SideChainRingBuffer::Reader* reader() {
+        return &m_reader;
+    }
+    const SideChainRingBuffer::Reader& reader() const {
+        return m_reader;
+    }
+    CSAMPLE* workBuffer() const {
+        return m_pWorkBuffer;
+    }
+    const QString& lagTag() const {
+        return m_lagTag;
+    }
+    const QString& overflowTag() const {
+        return m_overflowTag;
+    }
+
+  protected:
+    void run() override {
+        m_pSideChain->runWorker(this);
+    }
+
+  private:
+    EngineSideChain* const m_pSideChain;
+    SideChainWorker* const m_pWorker;
+    SideChainRingBuffer::Reader m_reader;
+    CSAMPLE* const m_pWorkBuffer;
+    const QString m_lagTag;
+    const QString m_overflowTag;
+};
+
 EngineSideChain::EngineSideChain(
         UserSettingsPointer pConfig,
         CSAMPLE* sidechainMix)
         : m_pConfig(pConfig),
           m_bStopThread(false),
-          m_sampleFifo(SIDECHAIN_BUFFER_SIZE),
-          m_pWorkBuffer(SampleUtil::alloc(SIDECHAIN_BUFFER_SIZE)),
-          m_pSidechainMix(sidechainMix) {
-    // We use HighPriority to prevent starvation by lower-priority processes (Qt
-    // main thread, analysis, etc.). This used to be LowPriority but that is not
-    // a suitable choice since we do semi-realtime tasks
-    // in the sidechain thread. To get reliable timing, it's important
-    // that this work be prioritized over the GUI and non-realtime tasks. See
-    // discussion on Bug #1270583 and Bug #1194543.
-    start(QThread::HighPriority);
+          m_sampleBuffer(SIDECHAIN_BUFFER_SIZE),
+          m_pSidechainMix(sidechainMix),
+          m_samplesSinceWakeup(0) {
 }
 
 EngineSideChain::~EngineSideChain() {
@@ -60,23 +116,46 @@ EngineSideChain::~EngineSideChain() {
     m_waitForSamples.wakeAll();
     m_waitLock.unlock();
 
-    // Wait until the thread has finished.
-    wait();
-
     MMutexLocker locker(&m_workerLock);
-    while (!m_workers.empty()) {
-        SideChainWorker* pWorker = m_workers.takeLast();
+    // Wait until all threads have finished.
+    for (WorkerThread* pThread : qAsConst(m_workerThreads)) {
+        pThread->wait();
+    }
+    while (!m_workerThreads.empty()) {
+        WorkerThread* pThread = m_workerThreads.takeLast();
+        SideChainWorker* pWorker = pThread->worker();
         pWorker->shutdown();
         delete pWorker;
+        delete pThread;
     }
     locker.unlock();
-
-    SampleUtil::free(m_pWorkBuffer);
 }
 
 void EngineSideChain::addSideChainWorker(SideChainWorker* pWorker) {
     MMutexLocker locker(&m_workerLock);
-    m_workers.append(pWorker);
+    auto* pThread = new WorkerThread(this, pWorker, m_workerThreads.size() + 1);
+    m_workerThreads.append(pThread);
+    // We use HighPriority to prevent starvation by lower-priority processes (Qt
+    // main thread, analysis, etc.). This used to be LowPriority but that is not
+    // a suitable choice since we do semi-realtime tasks
+    // in the sidechain thread. To get reliable timing, it's important
+    // that this work be prioritized over the GUI and non-realtime tasks. See
+    // discussion on Bug #1270583 and Bug #1194543.
+    pThread->start(QThread::HighPriority);
+}
+
+EngineSideChain::WorkerStats EngineSideChain::getWorkerStats(
+        const SideChainWorker* pWorker) const {
+    MMutexLocker locker(&m_workerLock);
+    WorkerStats stats;
+    for (const WorkerThread* pThread : m_workerThreads) {
+        if (pThread->worker() == pWorker) {
+            stats.lagSamples = pThread->reader().lag();
+            stats.overflowSamples = pThread->reader().overflowCount();
+            break;
+        }
+    }
+    return stats;
 }
 
 void EngineSideChain::receiveBuffer(AudioInput input,
@@ -96,48 +175,49 @@ void EngineSideChain::writeSamples(const CSAMPLE* pBuffer, int iFrames) {
     // TODO: remove assumption of stereo buffer
     const int kChannels = 2;
     const int iSamples = iFrames * kChannels;
-    int samples_written = m_sampleFifo.write(pBuffer, iSamples);
+    // Never fails. Workers that are too slow detect and count
+    // the samples they have missed.
+    m_sampleBuffer.write(pBuffer, iSamples);
 
-    if (samples_written != iSamples) {
-        Counter("EngineSideChain::writeSamples buffer overrun").increment();
-    }
-
-    if (m_sampleFifo.writeAvailable() < SIDECHAIN_BUFFER_SIZE / 5) {
+    m_samplesSinceWakeup += iSamples;
+    if (m_samplesSinceWakeup >= kWakeupSamples) {
+        m_samplesSinceWakeup = 0;
         // Signal to the sidechain that samples are available.
         Trace wakeup("EngineSideChain::writeSamples wake up");
         m_waitForSamples.wakeAll();
     }
 }
 
-void EngineSideChain::run() {
-    // the id of this thread, for debugging purposes //XXX copypasta (should
-    // factor this out somehow), -kousu 2/2009
-    unsigned static id = 0;
-    QThread::currentThread()->setObjectName(QString("EngineSideChain %1").arg(++id));
-    static const QString tag("EngineSideChain");
+void EngineSideChain::runWorker(WorkerThread* pThread) {
+    const QString tag = pThread->objectName();
+    SideChainRingBuffer::Reader* pReader = pThread->reader();
     Event::start(tag);
     while (!m_bStopThread) {
         // Sleep until samples are available.
         m_waitLock.lock();
-
-        Event::end(tag);
-        m_waitForSamples.wait(&m_waitLock);
+        if (!m_bStopThread && pReader->lag() < kWakeupSamples) {
+            Event::end(tag);
+            m_waitForSamples.wait(&m_waitLock, kMaxWaitMillis);
+            Event::start(tag);
+        }
         m_waitLock.unlock();
-        Event::start(tag);
 
+        const qint64 overflowCount = pReader->overflowCount();
         int samples_read;
-        while ((samples_read = m_sampleFifo.read(m_pWorkBuffer,
-                                                 SIDECHAIN_BUFFER_SIZE))) {
+        while ((samples_read = pReader->read(pThread->workBuffer(),
+                                             SIDECHAIN_BUFFER_SIZE))) {
             Trace process("EngineSideChain::process");
-            MMutexLocker locker(&m_workerLock);
-            foreach (SideChainWorker* pWorker, m_workers) {
-                pWorker->process(m_pWorkBuffer, samples_read);
-            }
+            pThread->worker()->process(pThread->workBuffer(), samples_read);
         }
-
-        // Check to see if we're supposed to exit/stop this thread.
-        if (m_bStopThread) {
-            return;
+        Stat::track(pThread->lagTag(),
+                Stat::UNSPECIFIED,
+                Stat::experimentFlags(
+                        Stat::COUNT | Stat::AVERAGE | Stat::MIN | Stat::MAX),
+                pReader->lag());
+        const qint64 overflowSamples = pReader->overflowCount() - overflowCount;
+        if (overflowSamples > 0) {
+            Counter(pThread->overflowTag()).increment(static_cast<int>(overflowSamples));
         }
     }
+    Event::end(tag);
 }
@@ -17,20 +17,22 @@
 #ifndef ENGINESIDECHAIN_H
 #define ENGINESIDECHAIN_H
 
-#include <QThread>
 #include <QMutex>
 #include <QWaitCondition>
 #include <QList>
 
 #include "preferences/usersettings.h"
+#include "engine/sidechain/sidechainringbuffer.h"
 #include "engine/sidechain/sidechainworker.h"
 #include "soundio/soundmanagerutil.h"
-#include "util/fifo.h"
 #include "util/mutex.h"
 #include "util/types.h"
 
-class EngineSideChain : public QThread, public AudioDestination {
-    Q_OBJECT
+// Distributes the sidechain mix to all SideChainWorkers, e.g. for
+// recording. Each worker runs on its own thread and reads from a
+// shared ring buffer with its own cursor. A slow worker only loses
+// samples itself and neither delays nor affects any other worker.
+class EngineSideChain : public AudioDestination {
   public:
     EngineSideChain(UserSettingsPointer pConfig, CSAMPLE* sidechainMix);
     ~EngineSideChain() override;
@@ -46,30 +48,47 @@ class EngineSideChain : public QThread, public AudioDestination {
                        const CSAMPLE* pBuffer,
                        unsigned int iFrames) override;
 
-    // Thread-safe, blocking.
+    // Thread-safe, blocking. Starts a new thread for the worker. The
+    // worker receives all samples that are written afterwards.
     void addSideChainWorker(SideChainWorker* pWorker);
 
+    struct WorkerStats {
+        // Samples that have been written but not processed yet
+        qint64 lagSamples = 0;
+        // Samples that have been lost, because the worker was too slow
+        qint64 overflowSamples = 0;
+    };
+
+    // Thread-safe. These statistics are also published as stats
+    // (Developer Tools > Stats).
+    WorkerStats getWorkerStats(const SideChainWorker* pWorker) const;
+
     static const int SIDECHAIN_BUFFER_SIZE = 65536;
 
   private:
-    void run() override;
+    class WorkerThread;
+
+    void runWorker(WorkerThread* pThread);
 
     UserSettingsPointer m_pConfig;
-    // Indicates that the thread should exit.
+    // Indicates that the threads should exit.
     volatile bool m_bStopThread;
 
-    FIFO<CSAMPLE> m_sampleFifo;
-    CSAMPLE* m_pWorkBuffer;
+    SideChainRingBuffer m_sampleBuffer;
     CSAMPLE* m_pSidechainMix;
 
+    // Samples written since the worker threads have been woken up.
+    // Only accessed by the writer.
+    int m_samplesSinceWakeup;
+
     // Provides thread safety around the wait condition below.
     QMutex m_waitLock;
     // Allows sleeping until we have samples to process.
     QWaitCondition m_waitForSamples;
 
     // Sidechain workers registered with EngineSideChain.
-    MMutex m_workerLock;
-    QList<SideChainWorker*> m_workers GUARDED_BY(m_workerLock);
+    mutable MMutex m_workerLock;
+    QList<WorkerThread*> m_workerThreads GUARDED_BY(m_workerLock);
 };
 
 #endif
@@ -22,6 +22,7 @@
 #include "control/controlpushbutton.h"
 #include "encoder/encoder.h"
 #include "encoder/encoderbroadcastsettings.h"
+#include "encoder/encodershared.h"
 #ifdef __OPUS__
 #include "encoder/encoderopus.h"
 #endif
@@ -46,7 +47,8 @@ const mixxx::Logger kLogger("ShoutConnection");
 }
 
 ShoutConnection::ShoutConnection(BroadcastProfilePtr profile,
-        UserSettingsPointer pConfig)
+        UserSettingsPointer pConfig,
+        QSharedPointer<EngineNetworkStream> pNetworkStream)
         : m_pTextCodec(nullptr),
           m_pMetaData(),
           m_pShout(nullptr),
@@ -56,6 +58,7 @@ ShoutConnection::ShoutConnection(BroadcastProfilePtr profile,
           m_iShoutFailures(0),
           m_pConfig(pConfig),
           m_pProfile(profile),
+          m_pNetworkStream(pNetworkStream),
           m_encoder(nullptr),
           m_pMasterSamplerate(new ControlProxy("[Master]", "samplerate", this)),
           m_pBroadcastEnabled(new ControlProxy(BROADCAST_PREF_KEY, "enabled", this)),
@@ -436,11 +439,11 @@ void ShoutConnection::updateFromPreferences() {
         return;
     }
 
-    // Initialize m_encoder
+    // Initialize m_encoder. Connections with identical encoder settings
+    // share the encoded stream and samples are only encoded once.
     EncoderSettingsPointer pBroadcastSettings =
             std::make_shared<EncoderBroadcastSettings>(m_pProfile);
-    m_encoder = EncoderFactory::getFactory().createEncoder(
-                    pBroadcastSettings, this);
+    m_encoder = EncoderShared::create(pBroadcastSettings, this, m_pNetworkStream);
 
     QString errorMsg;
     if(m_encoder->initEncoder(iMasterSamplerate, errorMsg) < 0) {
@@ -710,7 +713,9 @@ void ShoutConnection::process(const CSAMPLE* pBuffer, const int iBufferSize) {
     // If we are connected, encode the samples.
     if (iBufferSize > 0 && m_encoder) {
         setFunctionCode(6);
-        m_encoder->encodeBuffer(pBuffer, iBufferSize);
+        // write() might reset m_encoder when reconnecting
+        const EncoderPointer pEncoder = m_encoder;
+        pEncoder->encodeBuffer(pBuffer, iBufferSize);
         // the encoded frames are received by the write() callback.
     }
 
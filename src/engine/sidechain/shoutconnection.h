@@ -32,11 +32,15 @@ typedef struct shout shout_t;
 struct _util_dict;
 typedef struct _util_dict shout_metadata_t;
 
+class EngineNetworkStream;
+
 class ShoutConnection
         : public QThread, public EncoderCallback, public NetworkOutputStreamWorker {
     Q_OBJECT
   public:
-    ShoutConnection(BroadcastProfilePtr profile, UserSettingsPointer pConfig);
+    ShoutConnection(BroadcastProfilePtr profile,
+            UserSettingsPointer pConfig,
+            QSharedPointer<EngineNetworkStream> pNetworkStream);
     ~ShoutConnection() override;
 
     // This is called by the Engine implementation for each sample. Encode and
@@ -127,6 +131,8 @@ class ShoutConnection
     long m_iShoutFailures;
     UserSettingsPointer m_pConfig;
     BroadcastProfilePtr m_pProfile;
+    // Feeds the encoder that is shared with other connections
+    QSharedPointer<EngineNetworkStream> m_pNetworkStream;
     EncoderPointer m_encoder;
     ControlProxy* m_pMasterSamplerate;
     ControlProxy* m_pBroadcastEnabled;
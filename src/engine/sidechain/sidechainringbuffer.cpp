@@ -0,0 +1,82 @@
+#include "engine/sidechain/sidechainringbuffer.h"
+
+#include "util/assert.h"
+#include "util/math.h"
+#include "util/sample.h"
+
+SideChainRingBuffer::SideChainRingBuffer(int capacity)
+        : m_capacity(roundUpToPowerOf2(capacity)),
+          m_pData(SampleUtil::alloc(m_capacity)),
+          m_writeEnd(0),
+          m_writePos(0) {
+    DEBUG_ASSERT(m_capacity > 0);
+    SampleUtil::clear(m_pData, m_capacity);
+}
+
+SideChainRingBuffer::~SideChainRingBuffer() {
+    SampleUtil::free(m_pData);
+}
+
+void SideChainRingBuffer::write(const CSAMPLE* pSamples, int count) {
+    VERIFY_OR_DEBUG_ASSERT(count <= m_capacity) {
+        // Only the most recent samples fit into the buffer
+        pSamples += count - m_capacity;
+        count = m_capacity;
+    }
+    const qint64 writePos = m_writePos.load(std::memory_order_relaxed);
+    // Announce the region that is about to be overwritten before
+    // modifying any samples. Readers check m_writeEnd after copying
+    // samples to detect if they have been overwritten in the meantime.
+    m_writeEnd.store(writePos + count, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    const int offset = static_cast<int>(writePos & (m_capacity - 1));
+    const int count1 = math_min(count, m_capacity - offset);
+    SampleUtil::copy(m_pData + offset, pSamples, count1);
+    if (count1 < count) {
+        SampleUtil::copy(m_pData, pSamples + count1, count - count1);
+    }
+    m_writePos.store(writePos + count, std::memory_order_release);
+}
+
+SideChainRingBuffer::Reader::Reader(const SideChainRingBuffer* pRingBuffer)
+        : m_pRingBuffer(pRingBuffer),
+          m_readPos(pRingBuffer->writePosition()),
+          m_overflowCount(0) {
+}
+
+void SideChainRingBuffer::Reader::skipOverwritten(qint64 writeEnd) {
+    const qint64 readPos = m_readPos.load(std::memory_order_relaxed);
+    const qint64 minReadPos = writeEnd - m_pRingBuffer->m_capacity;
+    if (readPos < minReadPos) {
+        m_overflowCount.fetch_add(minReadPos - readPos, std::memory_order_relaxed);
+        m_readPos.store(minReadPos, std::memory_order_relaxed);
+    }
+}
+
+int SideChainRingBuffer::Reader::read(CSAMPLE* pBuffer, int maxCount) {
+    const int capacity = m_pRingBuffer->m_capacity;
+    while (true) {
+        const qint64 writePos = m_pRingBuffer->m_writePos.load(std::memory_order_acquire);
+        skipOverwritten(m_pRingBuffer->m_writeEnd.load(std::memory_order_relaxed));
+        const qint64 readPos = m_readPos.load(std::memory_order_relaxed);
+        const int count = static_cast<int>(math_min<qint64>(writePos - readPos, maxCount));
+        if (count <= 0) {
+            return 0;
+        }
+        const int offset = static_cast<int>(readPos & (capacity - 1));
+        const int count1 = math_min(count, capacity - offset);
+        SampleUtil::copy(pBuffer, m_pRingBuffer->m_pData + offset, count1);
+        if (count1 < count) {
+            SampleUtil::copy(pBuffer + count1, m_pRingBuffer->m_pData, count - count1);
+        }
+        // Validate that the writer has not started to overwrite any of
+        // the copied samples. Otherwise discard them and retry.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const qint64 writeEnd = m_pRingBuffer->m_writeEnd.load(std::memory_order_relaxed);
+        if (writeEnd - capacity <= readPos) {
+            m_readPos.store(readPos + count, std::memory_order_relaxed);
+            return count;
+        }
+        skipOverwritten(writeEnd);
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <QtGlobal>
+
+#include <atomic>
+
+#include "util/types.h"
+
+/// Single-producer, multi-consumer ring buffer for samples that are
+/// processed by all SideChainWorkers.
+///
+/// The writer never waits for any reader and overwrites the oldest
+/// samples instead. Each reader has its own cursor. A reader that
+/// falls behind by more than the capacity skips the overwritten
+/// samples and counts them as overflow, without affecting the writer
+/// or any other reader.
+class SideChainRingBuffer final {
+  public:
+    /// The capacity is rounded up to the next power of 2
+    explicit SideChainRingBuffer(int capacity);
+    ~SideChainRingBuffer();
+
+    int capacity() const {
+        return m_capacity;
+    }
+
+    /// Wait-free, but not thread-safe. Must only be invoked from a
+    /// single writer thread.
+    void write(const CSAMPLE* pSamples, int count);
+
+    /// The total number of samples written so far
+    qint64 writePosition() const {
+        return m_writePos.load(std::memory_order_acquire);
+    }
+
+    class Reader final {
+      public:
+        /// Starts reading at the current write position
+        explicit Reader(const SideChainRingBuffer* pRingBuffer);
+
+        /// Not thread-safe. Must only be invoked from a single reader
+        /// thread. Returns the number of samples that have been copied
+        /// into the buffer.
+        int read(CSAMPLE* pBuffer, int maxCount);
+
+        /// The number of samples that are available for reading.
+        /// Thread-safe.
+        qint64 lag() const {
+            return m_pRingBuffer->writePosition() -
+                    m_readPos.load(std::memory_order_relaxed);
+        }
+
+        /// The number of samples that have been overwritten before
+        /// they could be read. Thread-safe.
+        qint64 overflowCount() const {
+            return m_overflowCount.load(std::memory_order_relaxed);
+        }
+
+      private:
+        // Skips all samples that are (or are about to be) overwritten
+        void skipOverwritten(qint64 writeEnd);
+
+        const SideChainRingBuffer* const m_pRingBuffer;
+        std::atomic<qint64> m_readPos;
+        std::atomic<qint64> m_overflowCount;
+    };
+
+  private:
+    const int m_capacity;
+    CSAMPLE* const m_pData;
+
+    // The end of the pending write operation. Samples before
+    // m_writeEnd - m_capacity might be overwritten concurrently.
+    std::atomic<qint64> m_writeEnd;
+    // The end of all samples that have been written completely
+    std::atomic<qint64> m_writePos;
+};
@@ -47,10 +47,14 @@ BaseSqlTableModel::BaseSqlTableModel(
           m_pTrackCollectionManager(pTrackCollectionManager),
           m_database(pTrackCollectionManager->internalCollection()->database()),
           m_bInitialized(false),
-          m_currentSearch(kEmptyString) {
+          m_currentSearch(kEmptyString),
+          m_bSelectQueryRowsReplaced(false),
+          m_bSelectQueryIndexed(false),
+          m_bSelectQueryFailed(false) {
 }
 
 BaseSqlTableModel::~BaseSqlTableModel() {
+    cancelSelectQuery();
 }
 
 void BaseSqlTableModel::initHeaderProperties() {
@@ -136,10 +140,121 @@ void BaseSqlTableModel::replaceRows(
     }
 }
 
+void BaseSqlTableModel::appendRows(
+        QVector<RowInfo>&& rows) {
+    if (rows.isEmpty()) {
+        return;
+    }
+    const int firstRow = m_rowInfo.size();
+    beginInsertRows(QModelIndex(), firstRow, firstRow + rows.size() - 1);
+    m_rowInfo.reserve(firstRow + rows.size());
+    for (const auto& rowInfo : qAsConst(rows)) {
+        m_trackIdToRows[rowInfo.trackId].push_back(m_rowInfo.size());
+        m_rowInfo.push_back(rowInfo);
+    }
+    endInsertRows();
+}
+
+void BaseSqlTableModel::updateRows(
+        QVector<RowInfo>&& rows,
+        TrackId2Rows&& trackIdToRows) {
+    bool isPermutation =
+            rows.size() == m_rowInfo.size() &&
+            trackIdToRows.size() == m_trackIdToRows.size();
+    for (auto i = trackIdToRows.constBegin();
+            isPermutation && i != trackIdToRows.constEnd();
+            ++i) {
+        isPermutation = m_trackIdToRows.value(i.key()).size() == i.value().size();
+    }
+    if (!isPermutation || rows.isEmpty()) {
+        replaceRows(std::move(rows), std::move(trackIdToRows));
+        return;
+    }
+
+    emit layoutAboutToBeChanged();
+    // Move persistent indices, e.g. of selected rows, along with their
+    // rows. Multiple rows of the same track keep their relative order.
+    const QModelIndexList oldIndices = persistentIndexList();
+    QModelIndexList newIndices;
+    newIndices.reserve(oldIndices.size());
+    for (const auto& oldIndex : oldIndices) {
+        const TrackId trackId = m_rowInfo[oldIndex.row()].trackId;
+        const int occurrence = m_trackIdToRows.value(trackId).indexOf(oldIndex.row());
+        const QVector<int> newRows = trackIdToRows.value(trackId);
+        if (occurrence >= 0 && occurrence < newRows.size()) {
+            newIndices.append(index(newRows[occurrence], oldIndex.column()));
+        } else {
+            newIndices.append(QModelIndex());
+        }
+    }
+    m_rowInfo = rows;
+    m_trackIdToRows = trackIdToRows;
+    changePersistentIndexList(oldIndices, newIndices);
+    emit layoutChanged();
+}
+
+BaseSqlTableModel::TrackId2Rows BaseSqlTableModel::sortRows(
+        QVector<RowInfo>* pRowInfos) const {
+    QVector<RowInfo>& rowInfos = *pRowInfos;
+    if (m_trackSource) {
+        // Re-sort the track IDs since filterAndSort can change their order or mark
+        // them for removal (by setting their row to -1).
+        for (auto& rowInfo : rowInfos) {
+            // If the sort is not a track column then we will sort only to
+            // separate removed tracks (order == -1) from present tracks (order ==
+            // 0). Otherwise we sort by the order that filterAndSort returned to us.
+            if (m_trackSourceOrderBy.isEmpty()) {
+                rowInfo.order = m_trackSortOrder.contains(rowInfo.trackId) ? 0 : -1;
+            } else {
+                rowInfo.order = m_trackSortOrder.value(rowInfo.trackId, -1);
+            }
+        }
+    }
+
+    // RowInfo::operator< sorts by the order field, except -1 is placed at the
+    // end so we can easily slice off rows that are no longer present. Stable
+    // sort is necessary because the tracks may be in pre-sorted order so we
+    // should not disturb that if we are only removing tracks.
+    std::stable_sort(rowInfos.begin(), rowInfos.end());
+
+    TrackId2Rows trackIdToRows;
+    // We expect almost all rows to be valid and that only a few tracks
+    // are contained multiple times in rowInfos (e.g. in history playlists)
+    trackIdToRows.reserve(rowInfos.size());
+    for (int i = 0; i < rowInfos.size(); ++i) {
+        const RowInfo& rowInfo = rowInfos[i];
+
+        if (rowInfo.order == -1) {
+            // We've reached the end of valid rows. Resize rowInfo to cut off
+            // this and all further elements.
+            rowInfos.resize(i);
+            break;
+        }
+        trackIdToRows[rowInfo.trackId].push_back(i);
+    }
+    // The number of unique tracks cannot be greater than the
+    // number of total rows returned by the query
+    DEBUG_ASSERT(trackIdToRows.size() <= rowInfos.size());
+    return trackIdToRows;
+}
+
+// static
+BaseSqlTableModel::TrackId2Rows BaseSqlTableModel::indexRows(
+        const QVector<RowInfo>& rowInfos) {
+    TrackId2Rows trackIdToRows;
+    trackIdToRows.reserve(rowInfos.size());
+    for (int i = 0; i < rowInfos.size(); ++i) {
+        trackIdToRows[rowInfos[i].trackId].push_back(i);
+    }
+    return trackIdToRows;
+}
+
 void BaseSqlTableModel::select() {
     if (!m_bInitialized) {
         return;
     }
+    // A synchronous select supersedes any pending asynchronous select
+    cancelSelectQuery();
     // We should be able to detect when a select() would be a no-op. The DAO's
     // do not currently broadcast signals for when common things happen. In the
     // future, we can turn this check on and avoid a lot of needless
@@ -232,45 +347,9 @@ void BaseSqlTableModel::select() {
                 m_sortColumns,
                 m_tableColumns.size() - 1, // exclude the 1st column with the id
                 &m_trackSortOrder);
-
-        // Re-sort the track IDs since filterAndSort can change their order or mark
-        // them for removal (by setting their row to -1).
-        for (auto& rowInfo : rowInfos) {
-            // If the sort is not a track column then we will sort only to
-            // separate removed tracks (order == -1) from present tracks (order ==
-            // 0). Otherwise we sort by the order that filterAndSort returned to us.
-            if (m_trackSourceOrderBy.isEmpty()) {
-                rowInfo.order = m_trackSortOrder.contains(rowInfo.trackId) ? 0 : -1;
-            } else {
-                rowInfo.order = m_trackSortOrder.value(rowInfo.trackId, -1);
-            }
-        }
     }
 
-    // RowInfo::operator< sorts by the order field, except -1 is placed at the
-    // end so we can easily slice off rows that are no longer present. Stable
-    // sort is necessary because the tracks may be in pre-sorted order so we
-    // should not disturb that if we are only removing tracks.
-    std::stable_sort(rowInfos.begin(), rowInfos.end());
-
-    TrackId2Rows trackIdToRows;
-    // We expect almost all rows to be valid and that only a few tracks
-    // are contained multiple times in rowInfos (e.g. in history playlists)
-    trackIdToRows.reserve(rowInfos.size());
-    for (int i = 0; i < rowInfos.size(); ++i) {
-        const RowInfo& rowInfo = rowInfos[i];
-
-        if (rowInfo.order == -1) {
-            // We've reached the end of valid rows. Resize rowInfo to cut off
-            // this and all further elements.
-            rowInfos.resize(i);
-            break;
-        }
-        trackIdToRows[rowInfo.trackId].push_back(i);
-    }
-    // The number of unique tracks cannot be greater than the
-    // number of total rows returned by the query
-    DEBUG_ASSERT(trackIdToRows.size() <= rowInfos.size());
+    TrackId2Rows trackIdToRows = sortRows(&rowInfos);
 
     // We're done! Issue the update signals and replace the master maps.
     replaceRows(
@@ -283,6 +362,217 @@ void BaseSqlTableModel::select() {
              << m_rowInfo.size();
 }
 
+void BaseSqlTableModel::selectAsync(bool incremental) {
+    if (!m_bInitialized) {
+        return;
+    }
+    cancelSelectQuery();
+
+    SelectQueryExecutor* pExecutor =
+            m_pTrackCollectionManager->selectQueryExecutor();
+    bool isTempTable = false;
+    SelectQuery::Params params;
+    params.tempViews = tempViews(&isTempTable);
+    // Temporary tables are only accessible through the GUI connection
+    if (!pExecutor || isTempTable || m_bSelectQueryFailed) {
+        select();
+        return;
+    }
+
+    params.tableQuery = QString("SELECT %1 FROM %2 %3")
+                                .arg(m_tableColumns.join(","), m_tableName, m_tableOrderBy);
+    const bool indexed = m_trackSource &&
+            m_trackSource->canFilterAndSortIndex(
+                    m_currentSearch,
+                    m_trackSourceOrderBy,
+                    m_sortColumns,
+                    m_tableColumns.size() - 1); // exclude the 1st column with the id
+    if (indexed) {
+        // The search and the sort order are evaluated in memory after
+        // all rows have been received. Only the extra filter is an SQL
+        // expression that is evaluated by the database.
+        if (!m_currentSearchFilter.isEmpty()) {
+            params.trackSourceQuery = m_trackSource->filterAndSortQuery(
+                    QString("SELECT %1 FROM %2").arg(m_idColumn, m_tableName),
+                    QString(),
+                    m_currentSearchFilter,
+                    QString());
+            params.trackSourceOrdered = false;
+        }
+        params.incremental = false;
+    } else if (m_trackSource) {
+        params.trackSourceQuery = m_trackSource->filterAndSortQuery(
+                QString("SELECT %1 FROM %2").arg(m_idColumn, m_tableName),
+                m_currentSearch,
+                m_currentSearchFilter,
+                m_trackSourceOrderBy);
+        params.trackSourceOrdered = !m_trackSourceOrderBy.isEmpty();
+        params.incremental = incremental;
+    } else {
+        params.incremental = incremental;
+    }
+
+    if (sDebug) {
+        qDebug() << this << "selectAsync() submitting:"
+                 << params.tableQuery << params.trackSourceQuery;
+    }
+
+    m_pSelectQuery = std::make_shared<SelectQuery>(std::move(params));
+    m_bSelectQueryRowsReplaced = false;
+    m_bSelectQueryIndexed = indexed;
+    m_selectQueryTimer.start();
+    connect(pExecutor,
+            &SelectQueryExecutor::resultReady,
+            this,
+            &BaseSqlTableModel::slotSelectQueryResult,
+            static_cast<Qt::ConnectionType>(
+                    Qt::QueuedConnection | Qt::UniqueConnection));
+    pExecutor->submit(m_pSelectQuery);
+}
+
+void BaseSqlTableModel::cancelSelectQuery() {
+    if (m_pSelectQuery) {
+        m_pSelectQuery->cancel();
+        m_pSelectQuery.reset();
+    }
+}
+
+QList<QPair<QString, QString>> BaseSqlTableModel::tempViews(
+        bool* pIsTempTable) const {
+    QList<QPair<QString, QString>> tempViews;
+    QSqlQuery query(m_database);
+    if (!query.exec(
+                "SELECT type,name,sql FROM sqlite_temp_master "
+                "WHERE type IN ('table','view')")) {
+        LOG_FAILED_QUERY(query);
+        return tempViews;
+    }
+    while (query.next()) {
+        const QString name = query.value(1).toString();
+        if (query.value(0).toString() == "table") {
+            if (name == m_tableName) {
+                *pIsTempTable = true;
+            }
+            continue;
+        }
+        tempViews.append(qMakePair(name, query.value(2).toString()));
+    }
+    return tempViews;
+}
+
+bool BaseSqlTableModel::filterAndSortDirtyTracks(
+        const SelectQueryResult& result,
+        QVector<RowInfo>* pRowInfos) {
+    QSet<TrackId> trackIds;
+    trackIds.reserve(result.tableRows.size());
+    for (const auto& row : result.tableRows) {
+        trackIds.insert(row.trackId);
+    }
+    if (!m_trackSource->filterAndSortDirtyTracks(trackIds,
+                m_currentSearch,
+                m_currentSearchFilter,
+                m_sortColumns,
+                m_tableColumns.size() - 1, // exclude the 1st column with the id
+                result.trackOrder,
+                &m_trackSortOrder)) {
+        return false;
+    }
+    pRowInfos->clear();
+    pRowInfos->reserve(result.tableRows.size());
+    for (const auto& row : result.tableRows) {
+        RowInfo rowInfo;
+        rowInfo.trackId = row.trackId;
+        rowInfo.order = pRowInfos->size();
+        rowInfo.metadata = row.metadata;
+        pRowInfos->push_back(rowInfo);
+    }
+    return true;
+}
+
+void BaseSqlTableModel::slotSelectQueryResult(SelectQueryResult result) {
+    if (!m_pSelectQuery || result.pQuery != m_pSelectQuery) {
+        // Superseded or selected by a different model
+        return;
+    }
+
+    if (result.failed) {
+        qWarning() << this
+                   << "Failed to select" << m_tableName
+                   << "asynchronously, falling back to synchronous select";
+        m_bSelectQueryFailed = true;
+        select();
+        return;
+    }
+
+    const bool incremental = m_pSelectQuery->params().incremental;
+    const int firstRow = m_bSelectQueryRowsReplaced ? m_rowInfo.size() : 0;
+    QVector<RowInfo> rowInfos;
+    rowInfos.reserve(result.rows.size());
+    for (const auto& row : qAsConst(result.rows)) {
+        RowInfo rowInfo;
+        rowInfo.trackId = row.trackId;
+        rowInfo.order = firstRow + rowInfos.size();
+        rowInfo.metadata = row.metadata;
+        rowInfos.push_back(rowInfo);
+    }
+
+    if (incremental) {
+        if (m_bSelectQueryRowsReplaced) {
+            appendRows(std::move(rowInfos));
+        } else {
+            // Keep the previous rows until the first rows arrive
+            TrackId2Rows trackIdToRows = indexRows(rowInfos);
+            replaceRows(
+                    std::move(rowInfos),
+                    std::move(trackIdToRows));
+            m_bSelectQueryRowsReplaced = true;
+            qDebug() << this << "selectAsync() received first rows after"
+                     << m_selectQueryTimer.elapsed().debugMillisWithUnit();
+        }
+    }
+
+    if (!result.finished) {
+        return;
+    }
+
+    if (m_bSelectQueryIndexed) {
+        // Includes all modified tracks that have not been saved yet
+        QSet<TrackId> trackIds;
+        trackIds.reserve(rowInfos.size());
+        for (const auto& rowInfo : qAsConst(rowInfos)) {
+            trackIds.insert(rowInfo.trackId);
+        }
+        m_trackSource->filterAndSort(trackIds,
+                m_currentSearch,
+                QString(), // the extra filter has already been applied
+                m_trackSourceOrderBy,
+                m_sortColumns,
+                m_tableColumns.size() - 1, // exclude the 1st column with the id
+                &m_trackSortOrder);
+        TrackId2Rows trackIdToRows = sortRows(&rowInfos);
+        updateRows(
+                std::move(rowInfos),
+                std::move(trackIdToRows));
+    } else if (m_trackSource && filterAndSortDirtyTracks(result, &rowInfos)) {
+        // The track source might contain modified tracks that have not
+        // been saved yet and need to be filtered and sorted again
+        TrackId2Rows trackIdToRows = sortRows(&rowInfos);
+        updateRows(
+                std::move(rowInfos),
+                std::move(trackIdToRows));
+    } else if (!incremental) {
+        TrackId2Rows trackIdToRows = indexRows(rowInfos);
+        updateRows(
+                std::move(rowInfos),
+                std::move(trackIdToRows));
+    }
+
+    qDebug() << this << "selectAsync() took"
+             << m_selectQueryTimer.elapsed().debugMillisWithUnit()
+             << m_rowInfo.size();
+    m_pSelectQuery.reset();
+}
+
 void BaseSqlTableModel::setTable(const QString& tableName,
         const QString& idColumn,
         const QStringList& tableColumns,
@@ -290,6 +580,8 @@ void BaseSqlTableModel::setTable(const QString& tableName,
     if (sDebug) {
         qDebug() << this << "setTable" << tableName << tableColumns << idColumn;
     }
+    cancelSelectQuery();
+    m_bSelectQueryFailed = false;
     m_tableName = tableName;
     m_idColumn = idColumn;
     m_tableColumns = tableColumns;
@@ -361,7 +653,8 @@ void BaseSqlTableModel::search(const QString& searchText, const QString& extraFi
         qDebug() << this << "search" << searchText;
     }
     setSearch(searchText, extraFilter);
-    select();
+    // Searching while typing should not block the GUI
+    selectAsync(true);
 }
 
 void BaseSqlTableModel::setSort(int column, Qt::SortOrder order) {
@@ -506,7 +799,8 @@ void BaseSqlTableModel::sort(int column, Qt::SortOrder order) {
         qDebug() << this << "sort()" << column << order;
     }
     setSort(column, order);
-    select();
+    // The rows are only reordered and the selection is preserved
+    selectAsync(false);
 }
 
 int BaseSqlTableModel::rowCount(const QModelIndex& parent) const {
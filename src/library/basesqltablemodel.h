@@ -7,7 +7,9 @@
 #include "library/dao/trackdao.h"
 #include "library/basetracktablemodel.h"
 #include "library/columncache.h"
+#include "library/selectqueryexecutor.h"
 #include "util/class.h"
+#include "util/performancetimer.h"
 
 class TrackCollectionManager;
 
@@ -63,6 +65,19 @@ class BaseSqlTableModel : public BaseTrackTableModel {
 
     void select() override;
 
+    // Executes the query on a background thread. The current rows remain
+    // visible until the first rows of the new result arrive. If the track
+    // source can filter and sort its in-memory index, only the rows of
+    // the table are selected in the background and always replaced at once. Incremental
+    // selects deliver the rows in batches, otherwise all rows are
+    // replaced at once which preserves the selection if only the order
+    // of the rows changes. Pending selects are superseded by any following
+    // select.
+    void selectAsync(bool incremental);
+    bool hasPendingSelect() const {
+        return static_cast<bool>(m_pSelectQuery);
+    }
+
     ///////////////////////////////////////////////////////////////////////////
     // Inherited from BaseTrackTableModel
     ///////////////////////////////////////////////////////////////////////////
@@ -108,6 +123,8 @@ class BaseSqlTableModel : public BaseTrackTableModel {
 
     void slotRefreshCoverRows(QList<int> rows);
 
+    void slotSelectQueryResult(SelectQueryResult result);
+
   private:
     BaseCoverArtDelegate* doCreateCoverArtDelegate(
             QTableView* pTableView) const final;
@@ -142,6 +159,27 @@ class BaseSqlTableModel : public BaseTrackTableModel {
     void replaceRows(
             QVector<RowInfo>&& rows,
             TrackId2Rows&& trackIdToRows);
+    void appendRows(
+            QVector<RowInfo>&& rows);
+    // Replaces the rows like replaceRows() or only changes the layout
+    // if the new rows are a permutation of the current rows
+    void updateRows(
+            QVector<RowInfo>&& rows,
+            TrackId2Rows&& trackIdToRows);
+
+    // Sorts the rows by m_trackSortOrder and removes all rows that
+    // are not contained
+    TrackId2Rows sortRows(
+            QVector<RowInfo>* pRowInfos) const;
+    static TrackId2Rows indexRows(
+            const QVector<RowInfo>& rowInfos);
+
+    void cancelSelectQuery();
+    QList<QPair<QString, QString>> tempViews(
+            bool* pIsTempTable) const;
+    bool filterAndSortDirtyTracks(
+            const SelectQueryResult& result,
+            QVector<RowInfo>* pRowInfos);
 
     QVector<RowInfo> m_rowInfo;
 
@@ -158,5 +196,17 @@ class BaseSqlTableModel : public BaseTrackTableModel {
     QVector<QHash<int, QVariant> > m_headerInfo;
     QString m_trackSourceOrderBy;
 
+    SelectQueryPointer m_pSelectQuery;
+    // Set when the previous rows have been replaced by the first
+    // rows of the pending incremental select
+    bool m_bSelectQueryRowsReplaced;
+    // Set if the rows of the pending select are filtered and sorted
+    // with the in-memory index of the track source
+    bool m_bSelectQueryIndexed;
+    // Set if the table cannot be selected asynchronously, e.g. if it
+    // depends on temporary tables of the GUI database connection
+    bool m_bSelectQueryFailed;
+    PerformanceTimer m_selectQueryTimer;
+
     DISALLOW_COPY_AND_ASSIGN(BaseSqlTableModel);
 };
@@ -30,6 +30,7 @@ BaseTrackCache::BaseTrackCache(TrackCollection* pTrackCollection,
           m_pQueryParser(new SearchQueryParser(pTrackCollection)),
           m_bIndexBuilt(false),
           m_bIsCaching(isCaching),
+          m_trackIndex(columns),
           m_database(pTrackCollection->database()) {
     m_searchColumns << "artist"
                     << "album"
@@ -93,7 +94,7 @@ void BaseTrackCache::slotTracksRemoved(QSet<TrackId> trackIds) {
         qDebug() << this << "slotTracksRemoved" << trackIds.size();
     }
     for (const auto& trackId : qAsConst(trackIds)) {
-        m_trackInfo.remove(trackId);
+        m_trackIndex.removeRow(trackId);
         m_dirtyTracks.remove(trackId);
     }
 }
@@ -115,7 +116,7 @@ void BaseTrackCache::slotTrackClean(TrackId trackId) {
 }
 
 bool BaseTrackCache::isCached(TrackId trackId) const {
-    return m_trackInfo.contains(trackId);
+    return m_trackIndex.contains(trackId);
 }
 
 void BaseTrackCache::ensureCached(TrackId trackId) {
@@ -130,6 +131,10 @@ void BaseTrackCache::setSearchColumns(const QStringList& columns) {
     m_searchColumns = columns;
 }
 
+void BaseTrackCache::setSearchIndex(const SearchIndexDAO* pSearchIndex) {
+    m_pQueryParser->setSearchIndex(pSearchIndex);
+}
+
 const TrackPointer& BaseTrackCache::getRecentTrack(TrackId trackId) const {
     DEBUG_ASSERT(m_bIsCaching);
     // Only refresh the recently used track if the identifiers
@@ -139,7 +144,7 @@ const TrackPointer& BaseTrackCache::getRecentTrack(TrackId trackId) const {
     if (m_recentTrackId != trackId) {
         if (trackId.isValid()) {
             TrackPointer trackPtr =
-                    GlobalTrackCacheLocker().lookupTrackById(trackId);
+                    GlobalTrackCache::lookupCachedTrackById(trackId);
             replaceRecentTrack(
                     std::move(trackId),
                     std::move(trackPtr));
@@ -220,13 +225,13 @@ bool BaseTrackCache::updateTrackInIndex(
 
     TrackId trackId = pTrack->getId();
     if (trackId.isValid()) {
-        // m_trackInfo[id] will insert a QVector<QVariant> into the
-        // m_trackInfo HashTable with the key "id"
-        QVector<QVariant>& record = m_trackInfo[trackId];
-        // preallocate memory for all columns at once
-        record.resize(numColumns);
+        const int row = m_trackIndex.insertRow(trackId);
         for (int i = 0; i < numColumns; ++i) {
-            getTrackValueForColumn(pTrack, i, record[i]);
+            // Columns that are not available from the track
+            // keep their current value
+            QVariant value = m_trackIndex.value(row, i);
+            getTrackValueForColumn(pTrack, i, value);
+            m_trackIndex.setValue(row, i, value);
         }
         if (m_bIsCaching) {
             replaceRecentTrack(std::move(trackId), std::move(pTrack));
@@ -267,21 +272,17 @@ bool BaseTrackCache::updateIndexWithQuery(const QString& queryString) {
 
     while (query.next()) {
         TrackId trackId(query.value(idColumn));
-
-        //m_trackInfo[id] will insert a QVector<QVariant> into the
-        //m_trackInfo HashTable with the key "id"
-        QVector<QVariant>& record = m_trackInfo[trackId];
-        record.resize(numColumns);
+        const int row = m_trackIndex.insertRow(trackId);
 
         for (int i = 0; i < numColumns; ++i) {
             if (fieldIndex(ColumnCache::COLUMN_LIBRARYTABLE_NATIVELOCATION) == i) {
                 // Database stores all locations with Qt separators: "/"
                 // Here we want to cache the display string with native separators.
                 QString location = query.value(i).toString();
-                record[i] = QDir::toNativeSeparators(location);
+                m_trackIndex.setValue(row, i, QDir::toNativeSeparators(location));
             }
             else {
-                record[i] = query.value(i);
+                m_trackIndex.setValue(row, i, query.value(i));
             }
         }
     }
@@ -305,7 +306,7 @@ void BaseTrackCache::buildIndex() {
     // TODO(rryan) for very large tables, it probably makes more sense to NOT
     // clear the table, and keep track of what IDs we see, then delete the ones
     // we don't see.
-    m_trackInfo.clear();
+    m_trackIndex.clear();
 
     if (!updateIndexWithQuery(queryString)) {
         qDebug() << "buildIndex failed!";
@@ -447,15 +448,62 @@ QVariant BaseTrackCache::data(TrackId trackId, int column) const {
     // metadata. Currently the upper-levels will not delegate row-specific
     // columns to this method, but there should still be a check here I think.
     if (!result.isValid()) {
-        auto it = m_trackInfo.constFind(trackId);
-        if (it != m_trackInfo.constEnd()) {
-            const QVector<QVariant>& fields = it.value();
-            result = fields.value(column, result);
+        const int row = m_trackIndex.row(trackId);
+        if (row >= 0) {
+            result = m_trackIndex.value(row, column);
         }
     }
     return result;
 }
 
+std::unique_ptr<QueryNode> BaseTrackCache::parseFilterQuery(
+        const QString& searchQuery,
+        const QString& extraFilter,
+        const QString& trackIdFilter) const {
+    QStringList queryFragments;
+    if (!extraFilter.isNull() && extraFilter != "") {
+        queryFragments << QString("(%1)").arg(extraFilter);
+    }
+    if (!trackIdFilter.isEmpty()) {
+        queryFragments << QString("%1 in (%2)")
+                .arg(m_idColumn, trackIdFilter);
+    }
+
+    return m_pQueryParser->parseQuery(
+            searchQuery,
+            m_searchColumns,
+            queryFragments.join(" AND "));
+}
+
+QString BaseTrackCache::filterAndSortQueryString(
+        const QueryNode& query,
+        const QString& orderByClause) const {
+    QString filter = query.toSql();
+    if (!filter.isEmpty()) {
+        filter.prepend("WHERE ");
+    }
+
+    return QString("SELECT %1 FROM %2 %3 %4")
+            .arg(m_idColumn, m_tableName, filter, orderByClause);
+}
+
+QString BaseTrackCache::filterAndSortQuery(
+        const QString& trackIdSubquery,
+        const QString& searchQuery,
+        const QString& extraFilter,
+        const QString& orderByClause) {
+    if (!m_bIndexBuilt) {
+        buildIndex();
+    }
+
+    const std::unique_ptr<QueryNode> pQuery =
+            parseFilterQuery(
+                    searchQuery,
+                    extraFilter,
+                    trackIdSubquery);
+    return filterAndSortQueryString(*pQuery, orderByClause);
+}
+
 void BaseTrackCache::filterAndSort(const QSet<TrackId>& trackIds,
                                    const QString& searchQuery,
                                    const QString& extraFilter,
@@ -472,39 +520,211 @@ void BaseTrackCache::filterAndSort(const QSet<TrackId>& trackIds,
         buildIndex();
     }
 
-    QStringList idStrings;
     // TODO(rryan) consider making this the data passed in and a separate
     // QVector for output
     QSet<TrackId> dirtyTracks;
-    for (const auto& trackId: trackIds) {
-        idStrings << trackId.toString();
-        if (m_dirtyTracks.contains(trackId)) {
+    for (const auto& trackId : qAsConst(m_dirtyTracks)) {
+        if (trackIds.contains(trackId)) {
             dirtyTracks.insert(trackId);
         }
     }
 
-    QStringList queryFragments;
-    if (!extraFilter.isNull() && extraFilter != "") {
-        queryFragments << QString("(%1)").arg(extraFilter);
+    std::unique_ptr<QueryNode> pQuery =
+            filterAndSortIndex(
+                    trackIds,
+                    searchQuery,
+                    extraFilter,
+                    orderByClause,
+                    sortColumns,
+                    columnOffset);
+    if (pQuery) {
+        trackToIndex->clear();
+        trackToIndex->reserve(m_trackOrder.size());
+        for (int i = 0; i < m_trackOrder.size(); ++i) {
+            trackToIndex->insert(m_trackOrder[i], i);
+        }
+    } else {
+        pQuery = filterAndSortSql(
+                trackIds,
+                searchQuery,
+                extraFilter,
+                orderByClause,
+                trackToIndex);
+    }
+
+    sortDirtyTracks(
+            dirtyTracks,
+            *pQuery,
+            searchQuery,
+            sortColumns,
+            columnOffset,
+            trackToIndex);
+}
+
+bool BaseTrackCache::indexSortKeys(
+        const QString& orderByClause,
+        const QList<SortColumn>& sortColumns,
+        const int columnOffset,
+        QVector<ColumnarTrackIndex::SortKey>* pSortKeys) const {
+    // The random order of the preview column is only supported by
+    // the SQL query
+    if (orderByClause.contains("RANDOM()", Qt::CaseInsensitive)) {
+        return false;
     }
-    if (idStrings.size() > 0) {
-        queryFragments << QString("%1 in (%2)")
-                .arg(m_idColumn, idStrings.join(","));
+
+    // Sort by the same columns as the ORDER BY clause that has been
+    // generated by BaseSqlTableModel::setSort()
+    pSortKeys->clear();
+    if (!orderByClause.isEmpty()) {
+        for (const auto& sc : sortColumns) {
+            int column;
+            if (sc.m_column <= columnOffset) {
+                // Columns of the table are ignored except for the id
+                if (sc.m_column != 0) {
+                    continue;
+                }
+                column = 0;
+            } else {
+                column = sc.m_column - columnOffset;
+            }
+            if (column >= columnCount()) {
+                return false;
+            }
+            auto sortMode = ColumnarTrackIndex::SortMode::Collation;
+            if (column == fieldIndex(ColumnCache::COLUMN_LIBRARYTABLE_TRACKNUMBER)) {
+                sortMode = ColumnarTrackIndex::SortMode::Numeric;
+            } else if (column == fieldIndex(ColumnCache::COLUMN_LIBRARYTABLE_KEY)) {
+                sortMode = ColumnarTrackIndex::SortMode::Key;
+            }
+            pSortKeys->append(ColumnarTrackIndex::SortKey{column, sortMode, sc.m_order});
+        }
     }
+    return true;
+}
 
+bool BaseTrackCache::canFilterAndSortIndex(
+        const QString& searchQuery,
+        const QString& orderByClause,
+        const QList<SortColumn>& sortColumns,
+        const int columnOffset) {
+    if (!m_bIndexBuilt) {
+        buildIndex();
+    }
+    QVector<ColumnarTrackIndex::SortKey> sortKeys;
+    if (!indexSortKeys(orderByClause, sortColumns, columnOffset, &sortKeys)) {
+        return false;
+    }
     const std::unique_ptr<QueryNode> pQuery =
-            m_pQueryParser->parseQuery(
+            parseFilterQuery(
                     searchQuery,
-                    m_searchColumns,
-                    queryFragments.join(" AND "));
+                    QString(),
+                    QString());
+    return pQuery->bindIndex(m_trackIndex);
+}
 
-    QString filter = pQuery->toSql();
-    if (!filter.isEmpty()) {
-        filter.prepend("WHERE ");
+std::unique_ptr<QueryNode> BaseTrackCache::filterAndSortIndex(
+        const QSet<TrackId>& trackIds,
+        const QString& searchQuery,
+        const QString& extraFilter,
+        const QString& orderByClause,
+        const QList<SortColumn>& sortColumns,
+        const int columnOffset) {
+    PerformanceTimer timer;
+    timer.start();
+
+    QVector<ColumnarTrackIndex::SortKey> sortKeys;
+    if (!indexSortKeys(orderByClause, sortColumns, columnOffset, &sortKeys)) {
+        return nullptr;
     }
 
-    QString queryString = QString("SELECT %1 FROM %2 %3 %4")
-            .arg(m_idColumn, m_tableName, filter, orderByClause);
+    // Tracks that are not indexed are only found by the SQL query
+    std::vector<char> selectedRows;
+    if (trackIds.size() != m_trackIndex.rowCount()) {
+        selectedRows.resize(m_trackIndex.rowCount(), 0);
+    }
+    for (const auto& trackId : trackIds) {
+        const int row = m_trackIndex.row(trackId);
+        if (row < 0) {
+            if (sDebug) {
+                qDebug() << this << "Track" << trackId << "is not indexed";
+            }
+            return nullptr;
+        }
+        if (!selectedRows.empty()) {
+            selectedRows[row] = 1;
+        }
+    }
+
+    // The extra filter is an arbitrary SQL expression
+    ColumnarTrackIndex::RowFilter extraFilterRows;
+    if (!extraFilter.isEmpty()) {
+        QSqlQuery query(m_database);
+        query.setForwardOnly(true);
+        query.prepare(QString("SELECT %1 FROM %2 WHERE %3")
+                              .arg(m_idColumn, m_tableName, extraFilter));
+        if (!query.exec()) {
+            LOG_FAILED_QUERY(query);
+            return nullptr;
+        }
+        std::vector<TrackId> extraFilterTrackIds;
+        while (query.next()) {
+            extraFilterTrackIds.push_back(TrackId(query.value(0)));
+        }
+        extraFilterRows = m_trackIndex.filterTracks(extraFilterTrackIds);
+    }
+
+    std::unique_ptr<QueryNode> pQuery =
+            parseFilterQuery(
+                    searchQuery,
+                    QString(),
+                    QString());
+    if (!pQuery->bindIndex(m_trackIndex)) {
+        return nullptr;
+    }
+
+    const std::vector<int>& sortedRows = m_trackIndex.sortedRows(
+            sortKeys, m_columnCache.keyNotation());
+    const bool hasExtraFilter = !extraFilter.isEmpty();
+    const QueryNode& query = *pQuery;
+    const std::vector<int> rows = m_trackIndex.selectRows(
+            sortedRows,
+            [&selectedRows, hasExtraFilter, &extraFilterRows, &query](int row) {
+                return (selectedRows.empty() || selectedRows[row]) &&
+                        (!hasExtraFilter || extraFilterRows.contains(row)) &&
+                        query.matchIndex(row);
+            });
+
+    m_trackOrder.resize(0); // keeps allocated memory
+    m_trackOrder.reserve(static_cast<int>(rows.size()));
+    for (int row : rows) {
+        m_trackOrder.append(m_trackIndex.trackId(row));
+    }
+
+    if (sDebug) {
+        qDebug() << this << "filterAndSortIndex took"
+                 << timer.elapsed().debugMillisWithUnit();
+    }
+    return pQuery;
+}
+
+std::unique_ptr<QueryNode> BaseTrackCache::filterAndSortSql(
+        const QSet<TrackId>& trackIds,
+        const QString& searchQuery,
+        const QString& extraFilter,
+        const QString& orderByClause,
+        QHash<TrackId, int>* trackToIndex) {
+    QStringList idStrings;
+    for (const auto& trackId: trackIds) {
+        idStrings << trackId.toString();
+    }
+
+    std::unique_ptr<QueryNode> pQuery =
+            parseFilterQuery(
+                    searchQuery,
+                    extraFilter,
+                    idStrings.join(","));
+
+    QString queryString = filterAndSortQueryString(*pQuery, orderByClause);
 
     if (sDebug) {
         qDebug() << this << "select() executing:" << queryString;
@@ -539,7 +759,62 @@ void BaseTrackCache::filterAndSort(const QSet<TrackId>& trackIds,
         (*trackToIndex)[trackId] = m_trackOrder.size();
         m_trackOrder.append(trackId);
     }
+    return pQuery;
+}
+
+bool BaseTrackCache::filterAndSortDirtyTracks(
+        const QSet<TrackId>& trackIds,
+        const QString& searchQuery,
+        const QString& extraFilter,
+        const QList<SortColumn>& sortColumns,
+        const int columnOffset,
+        const QVector<TrackId>& trackOrder,
+        QHash<TrackId, int>* trackToIndex) {
+    if (!m_bIsCaching) {
+        return false;
+    }
+    QSet<TrackId> dirtyTracks;
+    for (const auto& trackId : qAsConst(m_dirtyTracks)) {
+        if (trackIds.contains(trackId)) {
+            dirtyTracks.insert(trackId);
+        }
+    }
+    if (dirtyTracks.isEmpty()) {
+        return false;
+    }
+
+    // The track ids have already been filtered by the database and
+    // the corresponding condition is not needed for matching tracks.
+    const std::unique_ptr<QueryNode> pQuery =
+            parseFilterQuery(
+                    searchQuery,
+                    extraFilter,
+                    QString());
 
+    m_trackOrder = trackOrder;
+    trackToIndex->clear();
+    trackToIndex->reserve(m_trackOrder.size());
+    for (int i = 0; i < m_trackOrder.size(); ++i) {
+        (*trackToIndex)[m_trackOrder[i]] = i;
+    }
+
+    sortDirtyTracks(
+            dirtyTracks,
+            *pQuery,
+            searchQuery,
+            sortColumns,
+            columnOffset,
+            trackToIndex);
+    return true;
+}
+
+void BaseTrackCache::sortDirtyTracks(
+        const QSet<TrackId>& dirtyTracks,
+        const QueryNode& query,
+        const QString& searchQuery,
+        const QList<SortColumn>& sortColumns,
+        const int columnOffset,
+        QHash<TrackId, int>* trackToIndex) {
     // At this point, the original set of tracks have been divided into two
     // pieces: those that should be in the result set and those that should
     // not. Unfortunately, due to TrackDAO caching, there may be tracks in
@@ -565,7 +840,7 @@ void BaseTrackCache::filterAndSort(const QSet<TrackId>& trackIds,
         // The track should be in the result set if the search is empty or the
         // track matches the search.
         bool shouldBeInResultSet = searchQuery.isEmpty() ||
-                pQuery->match(pTrack);
+                query.match(pTrack);
 
         // If the track is in this result set.
         bool isInResultSet = trackToIndex->contains(trackId);
@@ -645,7 +920,7 @@ int BaseTrackCache::findSortInsertionPoint(TrackPointer pTrack,
 
         // This should not happen, but it's a recoverable error so we should
         // only log it.
-        if (!m_trackInfo.contains(otherTrackId)) {
+        if (!m_trackIndex.contains(otherTrackId)) {
             qDebug() << "WARNING: track" << otherTrackId << "was not in index";
             //updateTrackInIndex(otherTrackId);
         }
@@ -11,11 +11,14 @@
 
 #include <memory>
 
+#include "library/columnartrackindex.h"
 #include "library/columncache.h"
 #include "track/track.h"
 #include "util/class.h"
 #include "util/string.h"
 
+class QueryNode;
+class SearchIndexDAO;
 class SearchQueryParser;
 class TrackCollection;
 
@@ -66,10 +69,40 @@ class BaseTrackCache : public QObject {
                                const QList<SortColumn>& sortColumns,
                                const int columnOffset,
                                QHash<TrackId, int>* trackToIndex);
+    // Returns the query that is executed by filterAndSort() for all tracks
+    // that are selected by an SQL subquery instead of a set of track ids.
+    // The query doesn't depend on the state of this cache and could be
+    // executed asynchronously on a different database connection.
+    QString filterAndSortQuery(const QString& trackIdSubquery,
+                               const QString& searchQuery,
+                               const QString& extraFilter,
+                               const QString& orderByClause);
+    // Returns true if filterAndSort() evaluates the search query and the
+    // sort order with the in-memory index instead of querying the database.
+    // Tracks that have not been indexed yet are still selected by SQL.
+    bool canFilterAndSortIndex(const QString& searchQuery,
+                               const QString& orderByClause,
+                               const QList<SortColumn>& sortColumns,
+                               const int columnOffset);
+    // Corrects the track order that has been returned by the query from
+    // filterAndSortQuery() for modified tracks that have not been saved
+    // yet like filterAndSort() does. Returns false and leaves trackToIndex
+    // untouched if none of the given tracks is dirty.
+    bool filterAndSortDirtyTracks(const QSet<TrackId>& trackIds,
+                                  const QString& searchQuery,
+                                  const QString& extraFilter,
+                                  const QList<SortColumn>& sortColumns,
+                                  const int columnOffset,
+                                  const QVector<TrackId>& trackOrder,
+                                  QHash<TrackId, int>* trackToIndex);
     virtual bool isCached(TrackId trackId) const;
     virtual void ensureCached(TrackId trackId);
     virtual void ensureCached(QSet<TrackId> trackIds);
     virtual void setSearchColumns(const QStringList& columns);
+    // Searches the text columns with the full-text index of the library
+    // if available. Only valid if the ids of this track source are the
+    // ids of the library. Disabled by passing nullptr.
+    void setSearchIndex(const SearchIndexDAO* pSearchIndex);
 
   signals:
     void tracksChanged(QSet<TrackId> trackIds);
@@ -95,6 +128,44 @@ class BaseTrackCache : public QObject {
     void getTrackValueForColumn(TrackPointer pTrack, int column,
                                 QVariant& trackValue) const;
 
+    std::unique_ptr<QueryNode> parseFilterQuery(
+            const QString& searchQuery,
+            const QString& extraFilter,
+            const QString& trackIdFilter) const;
+    QString filterAndSortQueryString(
+            const QueryNode& query,
+            const QString& orderByClause) const;
+    // Maps the sort columns onto the columns of the index. Returns false
+    // if the sort order cannot be evaluated in memory.
+    bool indexSortKeys(const QString& orderByClause,
+                       const QList<SortColumn>& sortColumns,
+                       const int columnOffset,
+                       QVector<ColumnarTrackIndex::SortKey>* pSortKeys) const;
+    // Filters and sorts the tracks in memory and stores the result in
+    // m_trackOrder. Returns the parsed query or nullptr if the query or
+    // the sort order cannot be evaluated in memory.
+    std::unique_ptr<QueryNode> filterAndSortIndex(
+            const QSet<TrackId>& trackIds,
+            const QString& searchQuery,
+            const QString& extraFilter,
+            const QString& orderByClause,
+            const QList<SortColumn>& sortColumns,
+            const int columnOffset);
+    // Filters and sorts the tracks with an SQL query like
+    // filterAndSortIndex().
+    std::unique_ptr<QueryNode> filterAndSortSql(
+            const QSet<TrackId>& trackIds,
+            const QString& searchQuery,
+            const QString& extraFilter,
+            const QString& orderByClause,
+            QHash<TrackId, int>* trackToIndex);
+    void sortDirtyTracks(const QSet<TrackId>& dirtyTracks,
+                         const QueryNode& query,
+                         const QString& searchQuery,
+                         const QList<SortColumn>& sortColumns,
+                         const int columnOffset,
+                         QHash<TrackId, int>* trackToIndex);
+
     int findSortInsertionPoint(TrackPointer pTrack,
                                const QList<SortColumn>& sortColumns,
                                const int columnOffset,
@@ -141,7 +212,7 @@ class BaseTrackCache : public QObject {
 
     bool m_bIndexBuilt;
     bool m_bIsCaching;
-    QHash<TrackId, QVector<QVariant> > m_trackInfo;
+    ColumnarTrackIndex m_trackIndex;
     QSqlDatabase m_database;
     ControlProxy* m_pKeyNotationCP;
 
@@ -0,0 +1,741 @@
+#include "library/columnartrackindex.h"
+
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThread>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <limits>
+
+#include "util/assert.h"
+#include "util/db/dbconnection.h"
+#include "util/fpclassify.h"
+#include "util/math.h"
+
+namespace {
+
+// Splitting the work into smaller tasks doesn't pay off
+constexpr int kMinItemsPerTask = 16384;
+
+constexpr double kNullSortValue = -std::numeric_limits<double>::infinity();
+
+struct Range {
+    int begin;
+    int end;
+    std::vector<int> rows;
+};
+
+QVector<Range> splitIntoRanges(int count) {
+    const int taskCount = math_max(1,
+            math_min(QThread::idealThreadCount(), count / kMinItemsPerTask));
+    QVector<Range> ranges;
+    ranges.reserve(taskCount);
+    for (int i = 0; i < taskCount; ++i) {
+        ranges.append(Range{
+                static_cast<int>(static_cast<qint64>(count) * i / taskCount),
+                static_cast<int>(static_cast<qint64>(count) * (i + 1) / taskCount),
+                {}});
+    }
+    return ranges;
+}
+
+// The global thread pool is shared with long-running tasks, e.g. the
+// analysis of tracks, that would delay searching
+QThreadPool* indexThreadPool() {
+    static QThreadPool s_threadPool;
+    return &s_threadPool;
+}
+
+template<typename Function>
+class RangeTask : public QRunnable {
+  public:
+    RangeTask(Range* pRange, const Function& function, QSemaphore* pFinished)
+            : m_pRange(pRange),
+              m_function(function),
+              m_pFinished(pFinished) {
+    }
+
+    void run() override {
+        m_function(*m_pRange);
+        m_pFinished->release();
+    }
+
+  private:
+    Range* const m_pRange;
+    const Function& m_function;
+    QSemaphore* const m_pFinished;
+};
+
+// Invokes the function for all ranges on a dedicated thread pool
+// and waits until all of them have been processed
+template<typename Function>
+void mapRanges(QVector<Range>* pRanges, Function function) {
+    if (pRanges->size() <= 1) {
+        for (auto& range : *pRanges) {
+            function(range);
+        }
+        return;
+    }
+    QSemaphore finished;
+    for (int i = 1; i < pRanges->size(); ++i) {
+        indexThreadPool()->start(
+                new RangeTask<Function>(&(*pRanges)[i], function, &finished));
+    }
+    // The calling thread processes the first range itself
+    function((*pRanges)[0]);
+    finished.acquire(pRanges->size() - 1);
+}
+
+// Like a cast in SQL the longest numeric prefix is used for strings
+// that are not numbers, e.g. "1/12" for track numbers
+double textToNumber(const QString& text) {
+    bool ok = false;
+    const double number = text.toDouble(&ok);
+    if (ok) {
+        return number;
+    }
+    const QString trimmed = text.trimmed();
+    int end = 0;
+    if (end < trimmed.size() && (trimmed[end] == '-' || trimmed[end] == '+')) {
+        ++end;
+    }
+    while (end < trimmed.size() && (trimmed[end].isDigit() || trimmed[end] == '.')) {
+        ++end;
+    }
+    return trimmed.leftRef(end).toDouble();
+}
+
+double keyToSortValue(const QString& text, KeyUtils::KeyNotation keyNotation) {
+    return KeyUtils::keyToCircleOfFifthsOrder(
+            KeyUtils::guessKeyFromText(text), keyNotation);
+}
+
+double sanitizeSortValue(double value) {
+    if (isnan(value)) {
+        return kNullSortValue;
+    }
+    return value;
+}
+
+} // anonymous namespace
+
+ColumnarTrackIndex::ColumnarTrackIndex(const QStringList& columnNames)
+        : m_columns(columnNames.size()),
+          m_generation(0),
+          m_sortedGeneration(0),
+          m_sortedKeyNotation(KeyUtils::KeyNotation::Invalid) {
+    for (int i = 0; i < columnNames.size(); ++i) {
+        m_columnIndexByName.insert(columnNames[i], i);
+    }
+    clear();
+}
+
+void ColumnarTrackIndex::clear() {
+    for (auto& column : m_columns) {
+        column = Column();
+        // The null value of text columns
+        column.strings.append(QString());
+    }
+    m_trackIds.clear();
+    m_rowByTrackId.clear();
+    m_sortedRows.clear();
+    ++m_generation;
+}
+
+int ColumnarTrackIndex::insertRow(TrackId trackId) {
+    const auto i = m_rowByTrackId.constFind(trackId);
+    if (i != m_rowByTrackId.constEnd()) {
+        return i.value();
+    }
+    const int row = rowCount();
+    m_trackIds.push_back(trackId);
+    m_rowByTrackId.insert(trackId, row);
+    for (auto& column : m_columns) {
+        switch (column.type) {
+        case ColumnType::Empty:
+            break;
+        case ColumnType::Integer:
+            column.integers.push_back(0);
+            column.nulls.push_back(true);
+            break;
+        case ColumnType::Real:
+            column.reals.push_back(0.0);
+            column.nulls.push_back(true);
+            break;
+        case ColumnType::Text:
+            column.valueIds.push_back(0);
+            break;
+        case ColumnType::Variant:
+            column.variants.push_back(QVariant(column.nullType));
+            break;
+        }
+    }
+    ++m_generation;
+    return row;
+}
+
+void ColumnarTrackIndex::removeRow(TrackId trackId) {
+    const auto i = m_rowByTrackId.find(trackId);
+    if (i == m_rowByTrackId.end()) {
+        return;
+    }
+    const int row = i.value();
+    m_rowByTrackId.erase(i);
+    const int lastRow = rowCount() - 1;
+    if (row != lastRow) {
+        // Move the last row into the gap
+        for (auto& column : m_columns) {
+            copyValue(&column, lastRow, row);
+        }
+        m_trackIds[row] = m_trackIds[lastRow];
+        m_rowByTrackId.insert(m_trackIds[row], row);
+    }
+    for (auto& column : m_columns) {
+        popBackValue(&column);
+    }
+    m_trackIds.pop_back();
+    ++m_generation;
+}
+
+void ColumnarTrackIndex::copyValue(Column* pColumn, int fromRow, int toRow) {
+    switch (pColumn->type) {
+    case ColumnType::Empty:
+        break;
+    case ColumnType::Integer:
+        pColumn->integers[toRow] = pColumn->integers[fromRow];
+        pColumn->nulls[toRow] = pColumn->nulls[fromRow];
+        break;
+    case ColumnType::Real:
+        pColumn->reals[toRow] = pColumn->reals[fromRow];
+        pColumn->nulls[toRow] = pColumn->nulls[fromRow];
+        break;
+    case ColumnType::Text:
+        pColumn->valueIds[toRow] = pColumn->valueIds[fromRow];
+        break;
+    case ColumnType::Variant:
+        pColumn->variants[toRow] = pColumn->variants[fromRow];
+        break;
+    }
+}
+
+void ColumnarTrackIndex::popBackValue(Column* pColumn) {
+    switch (pColumn->type) {
+    case ColumnType::Empty:
+        break;
+    case ColumnType::Integer:
+        pColumn->integers.pop_back();
+        pColumn->nulls.pop_back();
+        break;
+    case ColumnType::Real:
+        pColumn->reals.pop_back();
+        pColumn->nulls.pop_back();
+        break;
+    case ColumnType::Text:
+        pColumn->valueIds.pop_back();
+        break;
+    case ColumnType::Variant:
+        pColumn->variants.pop_back();
+        break;
+    }
+}
+
+QVariant ColumnarTrackIndex::value(int row, int column) const {
+    VERIFY_OR_DEBUG_ASSERT(row >= 0 && row < rowCount()) {
+        return QVariant();
+    }
+    if (column < 0 || column >= columnCount()) {
+        return QVariant();
+    }
+    const Column& col = m_columns[column];
+    switch (col.type) {
+    case ColumnType::Empty:
+        return QVariant(col.nullType);
+    case ColumnType::Integer:
+        if (col.nulls[row]) {
+            return QVariant(col.nullType);
+        }
+        switch (col.valueType) {
+        case QVariant::Bool:
+            return QVariant(col.integers[row] != 0);
+        case QVariant::Int:
+            return QVariant(static_cast<int>(col.integers[row]));
+        default:
+            return QVariant(col.integers[row]);
+        }
+    case ColumnType::Real:
+        if (col.nulls[row]) {
+            return QVariant(col.nullType);
+        }
+        return QVariant(col.reals[row]);
+    case ColumnType::Text: {
+        const quint32 valueId = col.valueIds[row];
+        if (valueId == 0) {
+            return QVariant(col.nullType);
+        }
+        return QVariant(col.strings[valueId]);
+    }
+    case ColumnType::Variant:
+        return col.variants[row];
+    }
+    DEBUG_ASSERT(!"unreachable");
+    return QVariant();
+}
+
+void ColumnarTrackIndex::setValue(int row, int column, const QVariant& value) {
+    VERIFY_OR_DEBUG_ASSERT(row >= 0 && row < rowCount()) {
+        return;
+    }
+    VERIFY_OR_DEBUG_ASSERT(column >= 0 && column < columnCount()) {
+        return;
+    }
+    Column& col = m_columns[column];
+    ++m_generation;
+
+    if (value.isNull()) {
+        col.nullType = value.type();
+        switch (col.type) {
+        case ColumnType::Empty:
+            break;
+        case ColumnType::Integer:
+        case ColumnType::Real:
+            col.nulls[row] = true;
+            break;
+        case ColumnType::Text:
+            col.valueIds[row] = 0;
+            break;
+        case ColumnType::Variant:
+            col.variants[row] = value;
+            break;
+        }
+        return;
+    }
+
+    ColumnType valueType;
+    switch (value.type()) {
+    case QVariant::Bool:
+    case QVariant::Int:
+    case QVariant::UInt:
+    case QVariant::LongLong:
+    case QVariant::ULongLong:
+        valueType = ColumnType::Integer;
+        break;
+    case QVariant::Double:
+        valueType = ColumnType::Real;
+        break;
+    case QVariant::String:
+        valueType = ColumnType::Text;
+        break;
+    default:
+        valueType = ColumnType::Variant;
+    }
+
+    if (col.type == ColumnType::Empty) {
+        convertColumn(&col, valueType);
+        col.valueType = value.type();
+    } else if (col.type != valueType) {
+        if (col.type == ColumnType::Integer && valueType == ColumnType::Real) {
+            convertColumn(&col, ColumnType::Real);
+        } else if (!(col.type == ColumnType::Real && valueType == ColumnType::Integer)) {
+            // Integers are stored as real numbers in a column with
+            // real numbers. All other combinations are stored as is.
+            convertColumn(&col, ColumnType::Variant);
+        }
+    }
+
+    switch (col.type) {
+    case ColumnType::Empty:
+        DEBUG_ASSERT(!"unreachable");
+        break;
+    case ColumnType::Integer:
+        col.integers[row] = value.toLongLong();
+        col.nulls[row] = false;
+        break;
+    case ColumnType::Real:
+        col.reals[row] = value.toDouble();
+        col.nulls[row] = false;
+        break;
+    case ColumnType::Text:
+        col.valueIds[row] = internString(&col, value.toString());
+        break;
+    case ColumnType::Variant:
+        col.variants[row] = value;
+        break;
+    }
+}
+
+void ColumnarTrackIndex::convertColumn(Column* pColumn, ColumnType type) {
+    DEBUG_ASSERT(pColumn->type != type);
+    const auto rows = m_trackIds.size();
+    switch (type) {
+    case ColumnType::Empty:
+        DEBUG_ASSERT(!"unreachable");
+        return;
+    case ColumnType::Integer:
+        DEBUG_ASSERT(pColumn->type == ColumnType::Empty);
+        pColumn->integers.assign(rows, 0);
+        pColumn->nulls.assign(rows, true);
+        break;
+    case ColumnType::Real:
+        DEBUG_ASSERT(pColumn->type == ColumnType::Empty ||
+                pColumn->type == ColumnType::Integer);
+        pColumn->reals.assign(rows, 0.0);
+        for (size_t row = 0; row < pColumn->integers.size(); ++row) {
+            pColumn->reals[row] = static_cast<double>(pColumn->integers[row]);
+        }
+        pColumn->integers = std::vector<qint64>();
+        pColumn->nulls.resize(rows, true);
+        break;
+    case ColumnType::Text:
+        DEBUG_ASSERT(pColumn->type == ColumnType::Empty);
+        pColumn->valueIds.assign(rows, 0);
+        break;
+    case ColumnType::Variant: {
+        std::vector<QVariant> variants;
+        variants.reserve(rows);
+        for (size_t row = 0; row < rows; ++row) {
+            variants.push_back(value(static_cast<int>(row),
+                    static_cast<int>(pColumn - m_columns.data())));
+        }
+        const QVariant::Type nullType = pColumn->nullType;
+        *pColumn = Column();
+        pColumn->strings.append(QString());
+        pColumn->nullType = nullType;
+        pColumn->variants = std::move(variants);
+        break;
+    }
+    }
+    pColumn->type = type;
+}
+
+quint32 ColumnarTrackIndex::internString(Column* pColumn, const QString& string) {
+    const auto i = pColumn->stringIds.constFind(string);
+    if (i != pColumn->stringIds.constEnd()) {
+        return i.value();
+    }
+    // Strings that are no longer referenced are only released
+    // when clearing the index
+    const auto valueId = static_cast<quint32>(pColumn->strings.size());
+    pColumn->strings.append(string);
+    pColumn->stringIds.insert(string, valueId);
+    return valueId;
+}
+
+const QVector<QString>& ColumnarTrackIndex::latinLowStrings(
+        const Column& column) const {
+    const int begin = column.latinLowStrings.size();
+    const int end = column.strings.size();
+    if (begin < end) {
+        column.latinLowStrings.resize(end);
+        // Obtain the pointers before accessing them concurrently
+        const QString* pStrings = column.strings.constData();
+        QString* pLatinLowStrings = column.latinLowStrings.data();
+        QVector<Range> ranges = splitIntoRanges(end - begin);
+        mapRanges(&ranges, [=](Range& range) {
+            for (int i = begin + range.begin; i < begin + range.end; ++i) {
+                QString string = pStrings[i];
+                mixxx::DbConnection::makeStringLatinLow(&string);
+                pLatinLowStrings[i] = std::move(string);
+            }
+        });
+    }
+    return column.latinLowStrings;
+}
+
+ColumnarTrackIndex::RowFilter ColumnarTrackIndex::filterStrings(
+        int column,
+        bool latinLow,
+        bool matchNull,
+        const std::function<bool(const QString&)>& predicate) const {
+    VERIFY_OR_DEBUG_ASSERT(column >= 0 && column < columnCount()) {
+        return RowFilter(std::vector<char>(rowCount(), 0), nullptr);
+    }
+    const Column& col = m_columns[column];
+    if (col.type == ColumnType::Text) {
+        const QVector<QString>& strings =
+                latinLow ? latinLowStrings(col) : col.strings;
+        std::vector<char> matches(strings.size(), 0);
+        matches[0] = matchNull;
+        QVector<Range> ranges = splitIntoRanges(strings.size() - 1);
+        mapRanges(&ranges, [&strings, &matches, &predicate](Range& range) {
+            for (int i = range.begin + 1; i < range.end + 1; ++i) {
+                matches[i] = predicate(strings[i]);
+            }
+        });
+        return RowFilter(std::move(matches), &col.valueIds);
+    }
+
+    // Evaluated once per row
+    std::vector<char> matches(rowCount(), 0);
+    for (int row = 0; row < rowCount(); ++row) {
+        const QVariant rowValue = value(row, column);
+        if (rowValue.isNull()) {
+            matches[row] = matchNull;
+            continue;
+        }
+        if (!rowValue.canConvert(QMetaType::QString)) {
+            continue;
+        }
+        QString string = rowValue.toString();
+        if (latinLow) {
+            mixxx::DbConnection::makeStringLatinLow(&string);
+        }
+        matches[row] = predicate(string);
+    }
+    return RowFilter(std::move(matches), nullptr);
+}
+
+ColumnarTrackIndex::RowFilter ColumnarTrackIndex::filterNumbers(
+        int column,
+        bool matchNull,
+        const std::function<bool(double)>& predicate) const {
+    VERIFY_OR_DEBUG_ASSERT(column >= 0 && column < columnCount()) {
+        return RowFilter(std::vector<char>(rowCount(), 0), nullptr);
+    }
+    const Column& col = m_columns[column];
+    switch (col.type) {
+    case ColumnType::Text: {
+        std::vector<char> matches(col.strings.size(), 0);
+        matches[0] = matchNull;
+        for (int i = 1; i < col.strings.size(); ++i) {
+            matches[i] = predicate(textToNumber(col.strings[i]));
+        }
+        return RowFilter(std::move(matches), &col.valueIds);
+    }
+    case ColumnType::Integer:
+    case ColumnType::Real: {
+        std::vector<char> matches(rowCount(), 0);
+        QVector<Range> ranges = splitIntoRanges(rowCount());
+        mapRanges(&ranges, [&col, &matches, matchNull, &predicate](Range& range) {
+            for (int row = range.begin; row < range.end; ++row) {
+                if (col.nulls[row]) {
+                    matches[row] = matchNull;
+                } else if (col.type == ColumnType::Integer) {
+                    matches[row] = predicate(static_cast<double>(col.integers[row]));
+                } else {
+                    matches[row] = predicate(col.reals[row]);
+                }
+            }
+        });
+        return RowFilter(std::move(matches), nullptr);
+    }
+    default: {
+        std::vector<char> matches(rowCount(), 0);
+        for (int row = 0; row < rowCount(); ++row) {
+            const QVariant rowValue = value(row, column);
+            if (rowValue.isNull()) {
+                matches[row] = matchNull;
+            } else if (rowValue.canConvert(QMetaType::Double)) {
+                matches[row] = predicate(rowValue.toDouble());
+            }
+        }
+        return RowFilter(std::move(matches), nullptr);
+    }
+    }
+}
+
+ColumnarTrackIndex::RowFilter ColumnarTrackIndex::filterTracks(
+        const std::vector<TrackId>& trackIds) const {
+    std::vector<char> matches(rowCount(), 0);
+    for (const auto& trackId : trackIds) {
+        const int trackRow = row(trackId);
+        if (trackRow >= 0) {
+            matches[trackRow] = 1;
+        }
+    }
+    return RowFilter(std::move(matches), nullptr);
+}
+
+const std::vector<double>& ColumnarTrackIndex::collationRanks(
+        const Column& column) const {
+    DEBUG_ASSERT(column.type == ColumnType::Text);
+    if (column.collationRanks.size() == static_cast<size_t>(column.strings.size())) {
+        return column.collationRanks;
+    }
+    // Sort keys are compared much faster than strings
+    std::vector<QCollatorSortKey> sortKeys;
+    sortKeys.reserve(column.strings.size());
+    for (const auto& string : column.strings) {
+        sortKeys.push_back(m_collator.sortKey(string));
+    }
+    std::vector<quint32> valueIds(column.strings.size() - 1);
+    for (size_t i = 0; i < valueIds.size(); ++i) {
+        valueIds[i] = static_cast<quint32>(i + 1);
+    }
+    std::sort(valueIds.begin(), valueIds.end(), [&sortKeys](quint32 lhs, quint32 rhs) {
+        return sortKeys[lhs].compare(sortKeys[rhs]) < 0;
+    });
+    column.collationRanks.resize(column.strings.size());
+    column.collationRanks[0] = kNullSortValue;
+    double rank = 0;
+    for (size_t i = 0; i < valueIds.size(); ++i) {
+        // Strings that are equal for the collator get the same rank
+        if (i > 0 && sortKeys[valueIds[i - 1]].compare(sortKeys[valueIds[i]]) != 0) {
+            ++rank;
+        }
+        column.collationRanks[valueIds[i]] = rank;
+    }
+    return column.collationRanks;
+}
+
+std::vector<double> ColumnarTrackIndex::sortValues(
+        const SortKey& sortKey,
+        KeyUtils::KeyNotation keyNotation) const {
+    const Column& col = m_columns[sortKey.column];
+    const int rows = rowCount();
+    std::vector<double> values(rows, kNullSortValue);
+    switch (col.type) {
+    case ColumnType::Empty:
+        break;
+    case ColumnType::Integer:
+    case ColumnType::Real:
+        for (int row = 0; row < rows; ++row) {
+            if (!col.nulls[row]) {
+                values[row] = col.type == ColumnType::Integer
+                        ? static_cast<double>(col.integers[row])
+                        : sanitizeSortValue(col.reals[row]);
+            }
+        }
+        break;
+    case ColumnType::Text: {
+        // Sort values of the distinct strings
+        std::vector<double> stringValues;
+        switch (sortKey.mode) {
+        case SortMode::Collation:
+            stringValues = collationRanks(col);
+            break;
+        case SortMode::Numeric:
+            stringValues.resize(col.strings.size());
+            for (int i = 1; i < col.strings.size(); ++i) {
+                stringValues[i] = sanitizeSortValue(textToNumber(col.strings[i]));
+            }
+            break;
+        case SortMode::Key:
+            stringValues.resize(col.strings.size());
+            for (int i = 1; i < col.strings.size(); ++i) {
+                stringValues[i] = keyToSortValue(col.strings[i], keyNotation);
+            }
+            break;
+        }
+        stringValues[0] = kNullSortValue;
+        for (int row = 0; row < rows; ++row) {
+            values[row] = stringValues[col.valueIds[row]];
+        }
+        break;
+    }
+    case ColumnType::Variant:
+        if (sortKey.mode == SortMode::Collation) {
+            // Rare and slow: Compare the string representations
+            std::vector<int> sorted;
+            sorted.reserve(rows);
+            for (int row = 0; row < rows; ++row) {
+                if (!col.variants[row].isNull()) {
+                    sorted.push_back(row);
+                }
+            }
+            std::sort(sorted.begin(), sorted.end(), [this, &col](int lhs, int rhs) {
+                return m_collator.compare(
+                               col.variants[lhs].toString(),
+                               col.variants[rhs].toString()) < 0;
+            });
+            double rank = 0;
+            for (size_t i = 0; i < sorted.size(); ++i) {
+                if (i > 0 &&
+                        m_collator.compare(
+                                col.variants[sorted[i - 1]].toString(),
+                                col.variants[sorted[i]].toString()) != 0) {
+                    ++rank;
+                }
+                values[sorted[i]] = rank;
+            }
+        } else {
+            for (int row = 0; row < rows; ++row) {
+                const QVariant& variant = col.variants[row];
+                if (variant.isNull()) {
+                    continue;
+                }
+                if (sortKey.mode == SortMode::Key) {
+                    values[row] = keyToSortValue(variant.toString(), keyNotation);
+                } else {
+                    values[row] = sanitizeSortValue(textToNumber(variant.toString()));
+                }
+            }
+        }
+        break;
+    }
+    return values;
+}
+
+const std::vector<int>& ColumnarTrackIndex::sortedRows(
+        const QVector<SortKey>& sortKeys,
+        KeyUtils::KeyNotation keyNotation) const {
+    if (m_sortedGeneration == m_generation &&
+            m_sortedKeys == sortKeys &&
+            m_sortedKeyNotation == keyNotation &&
+            m_sortedRows.size() == m_trackIds.size()) {
+        return m_sortedRows;
+    }
+
+    std::vector<std::vector<double>> values;
+    values.reserve(sortKeys.size());
+    for (const auto& sortKey : sortKeys) {
+        VERIFY_OR_DEBUG_ASSERT(sortKey.column >= 0 && sortKey.column < columnCount()) {
+            values.emplace_back(rowCount(), kNullSortValue);
+            continue;
+        }
+        values.push_back(sortValues(sortKey, keyNotation));
+    }
+
+    m_sortedRows.resize(m_trackIds.size());
+    for (int row = 0; row < rowCount(); ++row) {
+        m_sortedRows[row] = row;
+    }
+    std::sort(m_sortedRows.begin(),
+            m_sortedRows.end(),
+            [this, &sortKeys, &values](int lhs, int rhs) {
+                for (int i = 0; i < sortKeys.size(); ++i) {
+                    const double lhsValue = values[i][lhs];
+                    const double rhsValue = values[i][rhs];
+                    if (lhsValue != rhsValue) {
+                        if (sortKeys[i].order == Qt::AscendingOrder) {
+                            return lhsValue < rhsValue;
+                        } else {
+                            return lhsValue > rhsValue;
+                        }
+                    }
+                }
+                // Deterministic order for equal values
+                return m_trackIds[lhs] < m_trackIds[rhs];
+            });
+
+    m_sortedGeneration = m_generation;
+    m_sortedKeys = sortKeys;
+    m_sortedKeyNotation = keyNotation;
+    return m_sortedRows;
+}
+
+std::vector<int> ColumnarTrackIndex::selectRows(
+        const std::vector<int>& rows,
+        const std::function<bool(int)>& predicate) const {
+    QVector<Range> ranges = splitIntoRanges(static_cast<int>(rows.size()));
+    mapRanges(&ranges, [&rows, &predicate](Range& range) {
+        for (int i = range.begin; i < range.end; ++i) {
+            if (predicate(rows[i])) {
+                range.rows.push_back(rows[i]);
+            }
+        }
+    });
+    if (ranges.size() == 1) {
+        return std::move(ranges.first().rows);
+    }
+    std::vector<int> selectedRows;
+    size_t size = 0;
+    for (const auto& range : qAsConst(ranges)) {
+        size += range.rows.size();
+    }
+    selectedRows.reserve(size);
+    for (const auto& range : qAsConst(ranges)) {
+        selectedRows.insert(selectedRows.end(), range.rows.begin(), range.rows.end());
+    }
+    return selectedRows;
+}
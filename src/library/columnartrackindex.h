@@ -0,0 +1,207 @@
+#pragma once
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+#include <QVector>
+
+#include <functional>
+#include <vector>
+
+#include "track/keyutils.h"
+#include "track/trackid.h"
+#include "util/string.h"
+
+/// Column-oriented in-memory storage for the values of BaseTrackCache.
+///
+/// Instead of a QVariant per cell the values are stored in typed arrays
+/// per column: Integers and real numbers as 64-bit values and strings as
+/// 32-bit ids into a pool with the distinct strings of the column. Filters
+/// on string columns are evaluated once per distinct string instead of
+/// once per row and the collation order of the distinct strings is cached
+/// for sorting.
+///
+/// The rows of the index are numbered consecutively. Removing a row moves
+/// the last row into its place. All modifications must be done on the
+/// same thread that evaluates filters and sorts the rows.
+class ColumnarTrackIndex final {
+  public:
+    /// The rows that match a condition on a single column. Only valid
+    /// until the index is modified. Could be evaluated concurrently.
+    class RowFilter {
+      public:
+        RowFilter() = default;
+
+        bool contains(int row) const {
+            if (m_pValueIds) {
+                return m_matches[(*m_pValueIds)[row]] != 0;
+            } else {
+                return m_matches[row] != 0;
+            }
+        }
+
+      private:
+        friend class ColumnarTrackIndex;
+
+        RowFilter(std::vector<char> matches, const std::vector<quint32>* pValueIds)
+                : m_matches(std::move(matches)),
+                  m_pValueIds(pValueIds) {
+        }
+
+        // Indexed either by the id of the value or by the row. A byte
+        // instead of a bit per entry allows to populate it concurrently.
+        std::vector<char> m_matches;
+        const std::vector<quint32>* m_pValueIds = nullptr;
+    };
+
+    enum class SortMode {
+        // Strings with StringCollator, numbers by value
+        Collation,
+        // Strings are converted into numbers
+        Numeric,
+        // Key names in the order of the circle of fifths
+        Key,
+    };
+
+    struct SortKey {
+        int column;
+        SortMode mode;
+        Qt::SortOrder order;
+
+        bool operator==(const SortKey& other) const {
+            return column == other.column &&
+                    mode == other.mode &&
+                    order == other.order;
+        }
+    };
+
+    explicit ColumnarTrackIndex(const QStringList& columnNames);
+
+    int columnCount() const {
+        return static_cast<int>(m_columns.size());
+    }
+    /// Returns -1 if the index has no column with this name
+    int columnIndex(const QString& columnName) const {
+        return m_columnIndexByName.value(columnName, -1);
+    }
+
+    int rowCount() const {
+        return static_cast<int>(m_trackIds.size());
+    }
+    bool contains(TrackId trackId) const {
+        return m_rowByTrackId.contains(trackId);
+    }
+    /// Returns -1 if the track is not indexed
+    int row(TrackId trackId) const {
+        return m_rowByTrackId.value(trackId, -1);
+    }
+    TrackId trackId(int row) const {
+        return m_trackIds[row];
+    }
+
+    void clear();
+
+    /// Returns the row of an indexed track or appends a new row with
+    /// all values set to null.
+    int insertRow(TrackId trackId);
+    void removeRow(TrackId trackId);
+
+    QVariant value(int row, int column) const;
+    void setValue(int row, int column, const QVariant& value);
+
+    /// Selects all rows of a column with a string value that matches
+    /// the predicate. Optionally the strings are converted with
+    /// DbConnection::makeStringLatinLow() before matching, i.e. like
+    /// for LIKE expressions.
+    RowFilter filterStrings(
+            int column,
+            bool latinLow,
+            bool matchNull,
+            const std::function<bool(const QString&)>& predicate) const;
+    /// Selects all rows of a column with a numeric value that matches
+    /// the predicate. Strings are converted into numbers.
+    RowFilter filterNumbers(
+            int column,
+            bool matchNull,
+            const std::function<bool(double)>& predicate) const;
+    /// Selects all rows of the given tracks
+    RowFilter filterTracks(
+            const std::vector<TrackId>& trackIds) const;
+
+    /// All rows sorted by the given columns or by track id if the values
+    /// are equal. The order is cached until the index is modified.
+    const std::vector<int>& sortedRows(
+            const QVector<SortKey>& sortKeys,
+            KeyUtils::KeyNotation keyNotation) const;
+
+    /// Selects all rows that match the predicate from the given rows and
+    /// preserves their order. The predicate is invoked concurrently for
+    /// many rows.
+    std::vector<int> selectRows(
+            const std::vector<int>& rows,
+            const std::function<bool(int)>& predicate) const;
+
+  private:
+    enum class ColumnType {
+        // Only null values
+        Empty,
+        Integer,
+        Real,
+        Text,
+        // Fallback for other types or mixed types that cannot be converted
+        Variant,
+    };
+
+    struct Column {
+        ColumnType type = ColumnType::Empty;
+        // The type of the original non-null values, e.g. Int or Bool
+        // for integers
+        QVariant::Type valueType = QVariant::Invalid;
+        // The type of the original null values, e.g. String for NULL
+        // values from the database
+        QVariant::Type nullType = QVariant::Invalid;
+
+        // Integer and Real
+        std::vector<qint64> integers;
+        std::vector<double> reals;
+        std::vector<bool> nulls;
+
+        // Text: Id 0 is reserved for null values
+        std::vector<quint32> valueIds;
+        QVector<QString> strings;
+        QHash<QString, quint32> stringIds;
+        // Populated on demand
+        mutable QVector<QString> latinLowStrings;
+        mutable std::vector<double> collationRanks;
+
+        // Variant
+        std::vector<QVariant> variants;
+    };
+
+    void convertColumn(Column* pColumn, ColumnType type);
+    quint32 internString(Column* pColumn, const QString& string);
+    void copyValue(Column* pColumn, int fromRow, int toRow);
+    void popBackValue(Column* pColumn);
+
+    const QVector<QString>& latinLowStrings(const Column& column) const;
+    const std::vector<double>& collationRanks(const Column& column) const;
+    std::vector<double> sortValues(
+            const SortKey& sortKey,
+            KeyUtils::KeyNotation keyNotation) const;
+
+    QHash<QString, int> m_columnIndexByName;
+    std::vector<Column> m_columns;
+    std::vector<TrackId> m_trackIds;
+    QHash<TrackId, int> m_rowByTrackId;
+
+    const StringCollator m_collator;
+
+    // Incremented on each modification to invalidate cached results
+    quint64 m_generation;
+
+    mutable quint64 m_sortedGeneration;
+    mutable QVector<SortKey> m_sortedKeys;
+    mutable KeyUtils::KeyNotation m_sortedKeyNotation;
+    mutable std::vector<int> m_sortedRows;
+};
@@ -7,6 +7,11 @@
 
 #include "libraryhashdao.h"
 #include "library/queryutil.h"
+#include "util/db/sqllikewildcardescaper.h"
+#include "util/db/sqllikewildcards.h"
+#include "util/db/sqlquerycache.h"
+#include "util/db/sqlqueryfinisher.h"
+#include "util/db/sqlstringformatter.h"
 
 namespace {
 
@@ -41,9 +46,11 @@ mixxx::cache_key_t LibraryHashDAO::getDirectoryHash(const QString& dirPath) {
     //qDebug() << "LibraryHashDAO::getDirectoryHash" << QThread::currentThread() << m_database.connectionName();
     mixxx::cache_key_t hash = mixxx::invalidCacheKey();
 
-    QSqlQuery query(m_database);
-    query.prepare("SELECT hash FROM LibraryHashes "
-                  "WHERE directory_path=:directory_path");
+    // Executed for every directory while scanning
+    QSqlQuery query = SqlQueryCache::prepare(m_database,
+            "SELECT hash FROM LibraryHashes "
+            "WHERE directory_path=:directory_path");
+    SqlQueryFinisher queryFinisher(query);
     query.bindValue(":directory_path", dirPath);
 
     if (!query.exec()) {
@@ -62,9 +69,10 @@ mixxx::cache_key_t LibraryHashDAO::getDirectoryHash(const QString& dirPath) {
 
 void LibraryHashDAO::saveDirectoryHash(const QString& dirPath, mixxx::cache_key_t hash) {
     //qDebug() << "LibraryHashDAO::saveDirectoryHash" << QThread::currentThread() << m_database.connectionName();
-    QSqlQuery query(m_database);
-    query.prepare("INSERT INTO LibraryHashes (directory_path, hash, directory_deleted) "
-                    "VALUES (:directory_path, :hash, :directory_deleted)");
+    QSqlQuery query = SqlQueryCache::prepare(m_database,
+            "INSERT INTO LibraryHashes (directory_path, hash, directory_deleted) "
+            "VALUES (:directory_path, :hash, :directory_deleted)");
+    SqlQueryFinisher queryFinisher(query);
     query.bindValue(":directory_path", dirPath);
     query.bindValue(":hash", dbHash(hash));
     query.bindValue(":directory_deleted", 0);
@@ -79,13 +87,14 @@ void LibraryHashDAO::updateDirectoryHash(const QString& dirPath,
                                          mixxx::cache_key_t newHash,
                                          int dir_deleted) {
     //qDebug() << "LibraryHashDAO::updateDirectoryHash" << QThread::currentThread() << m_database.connectionName();
-    QSqlQuery query(m_database);
     // By definition if we have calculated a new hash for a directory then it
     // exists and no longer needs verification.
-    query.prepare("UPDATE LibraryHashes "
+    QSqlQuery query = SqlQueryCache::prepare(m_database,
+            "UPDATE LibraryHashes "
             "SET hash=:hash, directory_deleted=:directory_deleted, "
             "needs_verification=0 "
             "WHERE directory_path=:directory_path");
+    SqlQueryFinisher queryFinisher(query);
     query.bindValue(":hash", dbHash(newHash));
     query.bindValue(":directory_deleted", dir_deleted);
     query.bindValue(":directory_path", dirPath);
@@ -145,6 +154,39 @@ void LibraryHashDAO::invalidateAllDirectories() {
     }
 }
 
+void LibraryHashDAO::invalidateDirectories(const QStringList& dirPaths) {
+    QSqlQuery query(m_database);
+    query.prepare(
+            QString("UPDATE LibraryHashes "
+                    "SET needs_verification=1 "
+                    "WHERE directory_path IN (%1)")
+                    .arg(SqlStringFormatter::formatList(m_database, dirPaths)));
+    if (!query.exec()) {
+        LOG_FAILED_QUERY(query)
+                << "Couldn't mark directories as needing verification.";
+    }
+}
+
+void LibraryHashDAO::invalidateDirectoryTree(const QString& dirPath) {
+    // The trailing slash prevents matching sibling directories
+    const QString likeClause =
+            SqlLikeWildcardEscaper::apply(dirPath + "/", kSqlLikeMatchAll) +
+            kSqlLikeMatchAll;
+    QSqlQuery query(m_database);
+    query.prepare(
+            QString("UPDATE LibraryHashes "
+                    "SET needs_verification=1 "
+                    "WHERE directory_path=:directory_path "
+                    "OR directory_path LIKE :like_clause ESCAPE '%1'")
+                    .arg(kSqlLikeMatchAll));
+    query.bindValue(":directory_path", dirPath);
+    query.bindValue(":like_clause", likeClause);
+    if (!query.exec()) {
+        LOG_FAILED_QUERY(query)
+                << "Couldn't mark directory tree as needing verification.";
+    }
+}
+
 void LibraryHashDAO::markUnverifiedDirectoriesAsDeleted() {
     //qDebug() << "LibraryHashDAO::markUnverifiedDirectoriesAsDeleted"
     //<< QThread::currentThread() << m_database.connectionName();
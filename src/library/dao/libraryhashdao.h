@@ -24,6 +24,9 @@ class LibraryHashDAO : public DAO {
                              int dir_deleted);
     void markAsExisting(const QString& dirPath);
     void invalidateAllDirectories();
+    void invalidateDirectories(const QStringList& dirPaths);
+    // Invalidates the directory and all of its subdirectories
+    void invalidateDirectoryTree(const QString& dirPath);
     void markUnverifiedDirectoriesAsDeleted();
     void removeDeletedDirectoryHashes();
     void updateDirectoryStatuses(const QStringList& dirPaths,
@@ -0,0 +1,359 @@
+#include "library/dao/searchindexdao.h"
+
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QSqlRecord>
+
+#include "library/dao/trackschema.h"
+#include "library/queryutil.h"
+#include "util/db/dbconnection.h"
+#include "util/db/sqllikewildcards.h"
+#include "util/db/sqltransaction.h"
+#include "util/logger.h"
+
+namespace {
+
+const mixxx::Logger kLogger("SearchIndexDAO");
+
+// The trigram tokenizer cannot match shorter substrings
+constexpr int kMinMatchLength = 3;
+
+// The ids of the tracks that need to be reindexed
+const QString kChangesTableName = QStringLiteral("library_search_changes");
+
+const QStringList kTriggerNames = {
+        QStringLiteral("library_search_insert"),
+        QStringLiteral("library_search_update"),
+        QStringLiteral("library_search_delete"),
+        QStringLiteral("library_search_relocate"),
+};
+
+QString formatTrackIdList(const QList<TrackId>& trackIds) {
+    QStringList idList;
+    idList.reserve(trackIds.size());
+    for (const auto& trackId : trackIds) {
+        idList.append(trackId.toString());
+    }
+    return idList.join(",");
+}
+
+} // anonymous namespace
+
+const QString SearchIndexDAO::kTableName = QStringLiteral("library_search");
+
+const QStringList SearchIndexDAO::kColumns = {
+        LIBRARYTABLE_ARTIST,
+        LIBRARYTABLE_ALBUMARTIST,
+        LIBRARYTABLE_ALBUM,
+        LIBRARYTABLE_TITLE,
+        LIBRARYTABLE_GENRE,
+        LIBRARYTABLE_COMPOSER,
+        LIBRARYTABLE_GROUPING,
+        LIBRARYTABLE_COMMENT,
+        TRACKLOCATIONSTABLE_LOCATION,
+};
+
+SearchIndexDAO::SearchIndexDAO()
+        : m_availability(Availability::Unknown),
+          m_synchronized(false) {
+}
+
+void SearchIndexDAO::initialize(const QSqlDatabase& database) {
+    m_database = database;
+    m_availability = Availability::Unknown;
+    m_synchronized = false;
+}
+
+bool SearchIndexDAO::createIndex() {
+    SqlTransaction transaction(m_database);
+    bool reindexAllTracks = false;
+    if (!isAvailable()) {
+        QSqlQuery query(m_database);
+        query.prepare(QString(
+                "CREATE VIRTUAL TABLE %1 USING fts5(%2, "
+                "tokenize=\"trigram case_sensitive 1\")")
+                              .arg(kTableName, kColumns.join(",")));
+        if (!query.exec()) {
+            // Not an error, only the SQLite library is outdated
+            kLogger.info()
+                    << "Full-text search is not supported by SQLite:"
+                    << query.lastError().text();
+            m_availability = Availability::Unavailable;
+            return false;
+        }
+        m_availability = Availability::Available;
+        kLogger.info() << "Creating the search index";
+        reindexAllTracks = true;
+    }
+
+    // The triggers are dropped together with the library table,
+    // e.g. if a version without the index has recreated it
+    QSqlQuery query(m_database);
+    query.prepare(QString(
+            "SELECT COUNT(*) FROM sqlite_master "
+            "WHERE type='trigger' AND name IN ('%1')")
+                          .arg(kTriggerNames.join("','")));
+    if (!query.exec() || !query.next()) {
+        LOG_FAILED_QUERY(query);
+        // The created index is discarded when rolling back
+        m_availability = Availability::Unknown;
+        return false;
+    }
+    if (query.value(0).toInt() < kTriggerNames.size()) {
+        if (!reindexAllTracks) {
+            kLogger.info() << "The search index has not been maintained";
+            reindexAllTracks = true;
+        }
+        if (!createTriggers()) {
+            m_availability = Availability::Unknown;
+            return false;
+        }
+    }
+
+    if (reindexAllTracks) {
+        // Stale entries of purged tracks are removed when reindexing
+        // them. Deleting all entries at once would block the startup.
+        query.prepare(QString(
+                "INSERT OR IGNORE INTO %1 (id) "
+                "SELECT id FROM library UNION SELECT rowid FROM %2")
+                              .arg(kChangesTableName, kTableName));
+        if (!query.exec()) {
+            LOG_FAILED_QUERY(query);
+            m_availability = Availability::Unknown;
+            return false;
+        }
+    }
+    if (!transaction.commit()) {
+        m_availability = Availability::Unknown;
+        return false;
+    }
+    m_synchronized = false;
+    return true;
+}
+
+bool SearchIndexDAO::isAvailable() const {
+    if (m_availability == Availability::Unknown) {
+        QSqlQuery query(m_database);
+        query.prepare(
+                "SELECT 1 FROM sqlite_master "
+                "WHERE type='table' AND name=:name");
+        query.bindValue(":name", kTableName);
+        if (!query.exec()) {
+            LOG_FAILED_QUERY(query);
+            return false;
+        }
+        m_availability = query.next() ? Availability::Available : Availability::Unavailable;
+    }
+    return m_availability == Availability::Available;
+}
+
+bool SearchIndexDAO::isSynchronized() const {
+    if (!m_synchronized && isAvailable()) {
+        QSqlQuery query(m_database);
+        query.prepare(QString("SELECT EXISTS(SELECT 1 FROM %1)")
+                              .arg(kChangesTableName));
+        if (!query.exec() || !query.next()) {
+            LOG_FAILED_QUERY(query);
+            return false;
+        }
+        m_synchronized = !query.value(0).toBool();
+    }
+    return m_synchronized;
+}
+
+bool SearchIndexDAO::synchronizeIndex(int maxTrackCount) {
+    DEBUG_ASSERT(maxTrackCount > 0);
+    if (!isAvailable()) {
+        return false;
+    }
+    if (isSynchronized()) {
+        return true;
+    }
+
+    SqlTransaction transaction(m_database);
+    QSqlQuery query(m_database);
+    query.prepare(QString("SELECT id FROM %1 LIMIT :limit")
+                          .arg(kChangesTableName));
+    query.bindValue(":limit", maxTrackCount);
+    if (!query.exec()) {
+        LOG_FAILED_QUERY(query);
+        return false;
+    }
+    QList<TrackId> trackIds;
+    while (query.next()) {
+        trackIds.append(TrackId(query.value(0)));
+    }
+    if (!reindexTracks(trackIds)) {
+        return false;
+    }
+    return transaction.commit();
+}
+
+//static
+bool SearchIndexDAO::canMatch(
+        const QStringList& columns,
+        const QString& latinLowArgument) {
+    if (columns.isEmpty()) {
+        return false;
+    }
+    for (const auto& column : columns) {
+        if (!kColumns.contains(column)) {
+            return false;
+        }
+    }
+    if (latinLowArgument.contains(kSqlLikeMatchAll) ||
+            latinLowArgument.contains(kSqlLikeMatchOne)) {
+        return false;
+    }
+    return latinLowArgument.toUcs4().size() >= kMinMatchLength;
+}
+
+//static
+QString SearchIndexDAO::formatMatchQuery(
+        const QStringList& columns,
+        const QString& latinLowArgument) {
+    DEBUG_ASSERT(canMatch(columns, latinLowArgument));
+    // A quoted string is matched as a sequence of trigrams,
+    // i.e. as a substring
+    QString phrase = latinLowArgument;
+    phrase.replace('"', QStringLiteral("\"\""));
+    return QString("{%1} : \"%2\"").arg(columns.join(" "), phrase);
+}
+
+void SearchIndexDAO::updateTracks(const QList<TrackId>& trackIds) const {
+    if (trackIds.isEmpty() || !isAvailable()) {
+        return;
+    }
+    reindexTracks(trackIds);
+}
+
+void SearchIndexDAO::removeTracks(const QList<TrackId>& trackIds) const {
+    if (trackIds.isEmpty() || !isAvailable()) {
+        return;
+    }
+    deleteTracks(formatTrackIdList(trackIds));
+}
+
+bool SearchIndexDAO::reindexTracks(const QList<TrackId>& trackIds) const {
+    if (trackIds.isEmpty()) {
+        return true;
+    }
+    const QString trackIdList = formatTrackIdList(trackIds);
+    if (!deleteTracks(trackIdList)) {
+        return false;
+    }
+    // Tracks that have been purged in the meantime are not found
+    return insertTracks(QString("library.id IN (%1)").arg(trackIdList));
+}
+
+bool SearchIndexDAO::deleteTracks(const QString& trackIdList) const {
+    QSqlQuery query(m_database);
+    query.prepare(QString("DELETE FROM %1 WHERE rowid IN (%2)")
+                          .arg(kTableName, trackIdList));
+    if (!query.exec()) {
+        LOG_FAILED_QUERY(query);
+        return false;
+    }
+    // The triggers have recorded the modifications of the tracks
+    // that are now reindexed within the same transaction
+    query.prepare(QString("DELETE FROM %1 WHERE id IN (%2)")
+                          .arg(kChangesTableName, trackIdList));
+    if (!query.exec()) {
+        LOG_FAILED_QUERY(query);
+        return false;
+    }
+    return true;
+}
+
+bool SearchIndexDAO::createTriggers() const {
+    QStringList statements;
+    statements.append(QString(
+            "CREATE TABLE IF NOT EXISTS %1 (id INTEGER PRIMARY KEY)")
+                              .arg(kChangesTableName));
+    // Only plain SQL that every version is able to execute
+    statements.append(QString(
+            "CREATE TRIGGER IF NOT EXISTS %1 AFTER INSERT ON library "
+            "BEGIN INSERT OR IGNORE INTO %2 (id) VALUES (NEW.id); END")
+                              .arg(kTriggerNames[0], kChangesTableName));
+    // The location column of the library references the track location
+    statements.append(QString(
+            "CREATE TRIGGER IF NOT EXISTS %1 AFTER UPDATE OF %2 ON library "
+            "BEGIN INSERT OR IGNORE INTO %3 (id) VALUES (NEW.id); END")
+                              .arg(kTriggerNames[1],
+                                      kColumns.join(","),
+                                      kChangesTableName));
+    statements.append(QString(
+            "CREATE TRIGGER IF NOT EXISTS %1 AFTER DELETE ON library "
+            "BEGIN INSERT OR IGNORE INTO %2 (id) VALUES (OLD.id); END")
+                              .arg(kTriggerNames[2], kChangesTableName));
+    statements.append(QString(
+            "CREATE TRIGGER IF NOT EXISTS %1 AFTER UPDATE OF %2 ON track_locations "
+            "BEGIN INSERT OR IGNORE INTO %3 (id) "
+            "SELECT id FROM library WHERE %4=NEW.id; END")
+                              .arg(kTriggerNames[3],
+                                      TRACKLOCATIONSTABLE_LOCATION,
+                                      kChangesTableName,
+                                      LIBRARYTABLE_LOCATION));
+    DEBUG_ASSERT(statements.size() == kTriggerNames.size() + 1);
+    QSqlQuery query(m_database);
+    for (const auto& statement : qAsConst(statements)) {
+        if (!query.exec(statement)) {
+            LOG_FAILED_QUERY(query);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SearchIndexDAO::insertTracks(const QString& libraryFilter) const {
+    QStringList selectColumns;
+    QStringList placeholders;
+    for (const auto& column : kColumns) {
+        if (column == TRACKLOCATIONSTABLE_LOCATION) {
+            selectColumns.append(QStringLiteral("track_locations.") + column);
+        } else {
+            selectColumns.append(QStringLiteral("library.") + column);
+        }
+        placeholders.append(QChar(':') + column);
+    }
+
+    QSqlQuery selectQuery(m_database);
+    // Avoid caching the results of all tracks when rebuilding the index
+    selectQuery.setForwardOnly(true);
+    selectQuery.prepare(QString(
+            "SELECT library.id,%1 FROM library "
+            "INNER JOIN track_locations ON library.location=track_locations.id%2")
+                                .arg(selectColumns.join(","),
+                                        libraryFilter.isEmpty()
+                                                ? QString()
+                                                : QStringLiteral(" WHERE ") + libraryFilter));
+    if (!selectQuery.exec()) {
+        LOG_FAILED_QUERY(selectQuery);
+        return false;
+    }
+
+    QSqlQuery insertQuery(m_database);
+    insertQuery.prepare(QString(
+            "INSERT INTO %1 (rowid,%2) VALUES (:id,%3)")
+                                .arg(kTableName,
+                                        kColumns.join(","),
+                                        placeholders.join(",")));
+    while (selectQuery.next()) {
+        insertQuery.bindValue(":id", selectQuery.value(0));
+        for (int i = 0; i < kColumns.size(); ++i) {
+            const QVariant value = selectQuery.value(i + 1);
+            if (value.isNull()) {
+                insertQuery.bindValue(placeholders[i], QVariant(QVariant::String));
+                continue;
+            }
+            QString text = value.toString();
+            mixxx::DbConnection::makeStringLatinLow(&text);
+            insertQuery.bindValue(placeholders[i], text);
+        }
+        if (!insertQuery.exec()) {
+            LOG_FAILED_QUERY(insertQuery);
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <QList>
+#include <QSqlDatabase>
+#include <QString>
+#include <QStringList>
+
+#include "library/dao/dao.h"
+#include "track/trackid.h"
+
+/// Full-text index for searching the text columns of the library.
+///
+/// The index is an SQLite FTS5 table with the trigram tokenizer that
+/// finds substrings like the LIKE operator without scanning all rows.
+/// All values are converted with DbConnection::makeStringLatinLow()
+/// before indexing them. Matching is case- and accent-insensitive like
+/// our custom like() function.
+///
+/// The index is only available if SQLite has been built with FTS5 and
+/// supports the trigram tokenizer (3.34.0 or newer). Otherwise all
+/// searches use the LIKE operator. For this reason the index is not part
+/// of the database schema but created on startup. TrackDAO keeps it in
+/// sync when adding, updating, relocating or purging tracks.
+///
+/// Versions without the index might modify the library in between.
+/// Plain SQL triggers that every SQLite version can execute record the
+/// ids of all inserted, modified or deleted tracks in a separate table.
+/// The tracks reindexed by TrackDAO are removed from this table within
+/// the same transaction. All remaining tracks are reindexed in small
+/// batches by synchronizeIndex() after startup. Searches don't use the
+/// index until it is synchronized.
+class SearchIndexDAO : public DAO {
+  public:
+    static const QString kTableName;
+    /// The indexed columns of the library and track_locations tables
+    static const QStringList kColumns;
+
+    SearchIndexDAO();
+    ~SearchIndexDAO() override = default;
+
+    void initialize(const QSqlDatabase& database) override;
+
+    /// Creates the index if it doesn't exist yet. Only schedules the
+    /// tracks that need to be (re-)indexed without indexing them.
+    /// Returns false if the index is not available.
+    bool createIndex();
+
+    /// The index exists and is maintained when modifying tracks.
+    bool isAvailable() const;
+    /// The index is available and contains all tracks of the library,
+    /// i.e. it can be used for searching.
+    bool isSynchronized() const;
+
+    /// Reindexes up to maxTrackCount of the tracks that have been modified
+    /// while the index was not maintained. Returns false on failure.
+    bool synchronizeIndex(int maxTrackCount);
+
+    /// Substrings with less than 3 characters and LIKE wildcards
+    /// cannot be matched by the index.
+    static bool canMatch(
+            const QStringList& columns,
+            const QString& latinLowArgument);
+    /// Formats an FTS5 query that matches the argument as a substring
+    /// of any of the columns.
+    static QString formatMatchQuery(
+            const QStringList& columns,
+            const QString& latinLowArgument);
+
+    /// Reindexes the tracks after inserting or updating them in the
+    /// library. Must be invoked within the same transaction.
+    void updateTracks(const QList<TrackId>& trackIds) const;
+    void removeTracks(const QList<TrackId>& trackIds) const;
+
+  private:
+    enum class Availability {
+        Unknown,
+        Available,
+        Unavailable,
+    };
+
+    bool createTriggers() const;
+    bool reindexTracks(const QList<TrackId>& trackIds) const;
+    bool deleteTracks(const QString& trackIdList) const;
+    bool insertTracks(const QString& libraryFilter) const;
+
+    QSqlDatabase m_database;
+    // Checked on demand for connections that don't create the index
+    mutable Availability m_availability;
+    // Only cached once synchronized, afterwards all modifications
+    // are reindexed immediately
+    mutable bool m_synchronized;
+};
@@ -15,6 +15,7 @@
 #include "library/dao/cuedao.h"
 #include "library/dao/libraryhashdao.h"
 #include "library/dao/playlistdao.h"
+#include "library/dao/searchindexdao.h"
 #include "library/dao/trackschema.h"
 #include "library/queryutil.h"
 #include "library/trackset/crate/cratestorage.h"
@@ -31,6 +32,8 @@
 #include "util/datetime.h"
 #include "util/db/sqllikewildcardescaper.h"
 #include "util/db/sqllikewildcards.h"
+#include "util/db/sqlquerycache.h"
+#include "util/db/sqlqueryfinisher.h"
 #include "util/db/sqlstringformatter.h"
 #include "util/db/sqltransaction.h"
 #include "util/file.h"
@@ -63,11 +66,13 @@ TrackDAO::TrackDAO(CueDAO& cueDao,
                    PlaylistDAO& playlistDao,
                    AnalysisDao& analysisDao,
                    LibraryHashDAO& libraryHashDao,
+                   SearchIndexDAO& searchIndexDao,
                    UserSettingsPointer pConfig)
         : m_cueDao(cueDao),
           m_playlistDao(playlistDao),
           m_analysisDao(analysisDao),
           m_libraryHashDao(libraryHashDao),
+          m_searchIndexDao(searchIndexDao),
           m_pConfig(pConfig),
           m_trackLocationIdColumn(UndefinedRecordIndex),
           m_queryLibraryIdColumn(UndefinedRecordIndex),
@@ -121,11 +126,11 @@ TrackId TrackDAO::getTrackIdByLocation(const QString& location) const {
         return TrackId();
     }
 
-    QSqlQuery query(m_database);
-    query.prepare(
+    QSqlQuery query = SqlQueryCache::prepare(m_database,
             "SELECT library.id FROM library "
             "INNER JOIN track_locations ON library.location = track_locations.id "
             "WHERE track_locations.location=:location");
+    SqlQueryFinisher queryFinisher(query);
     query.bindValue(":location", location);
     VERIFY_OR_DEBUG_ASSERT(query.exec()) {
         LOG_FAILED_QUERY(query);
@@ -317,6 +322,8 @@ void TrackDAO::slotDatabaseTracksRelocated(QList<RelocatedTrack> relocatedTracks
     }
     DEBUG_ASSERT(removedTrackIds.size() <= changedTrackIds.size());
     DEBUG_ASSERT(!removedTrackIds.intersects(changedTrackIds));
+    m_searchIndexDao.removeTracks(removedTrackIds.values());
+    m_searchIndexDao.updateTracks(changedTrackIds.values());
     if (!removedTrackIds.isEmpty()) {
         emit tracksRemoved(removedTrackIds);
     }
@@ -461,6 +468,8 @@ void TrackDAO::addTracksFinish(bool rollback) {
             m_pTransaction->rollback();
             m_tracksAddedSet.clear();
         } else {
+            // Index all new tracks at once
+            m_searchIndexDao.updateTracks(m_tracksAddedSet.values());
             m_pTransaction->commit();
         }
     }
@@ -763,7 +772,10 @@ TrackId TrackDAO::addTracksAddTrack(const TrackPointer& pTrack, bool unremove) {
     return trackId;
 }
 
-TrackPointer TrackDAO::addTracksAddFile(const TrackFile& trackFile, bool unremove) {
+TrackPointer TrackDAO::addTracksAddFile(
+        const TrackFile& trackFile,
+        bool unremove,
+        const ParsedTrackMetadata* pParsedMetadata) {
     // Check that track is a supported extension.
     // TODO(uklotzde): The following check can be skipped if
     // the track is already in the library. A refactoring is
@@ -796,7 +808,11 @@ TrackPointer TrackDAO::addTracksAddFile(const TrackFile& trackFile, bool unremov
 
     // Initially (re-)import the metadata for the newly created track
     // from the file.
-    SoundSourceProxy(pTrack).updateTrackFromSource();
+    if (pParsedMetadata) {
+        SoundSourceProxy(pTrack).updateTrackFromParsedMetadata(*pParsedMetadata);
+    } else {
+        SoundSourceProxy(pTrack).updateTrackFromSource();
+    }
     if (!pTrack->isMetadataSynchronized()) {
         qWarning() << "TrackDAO::addTracksAddFile:"
                 << "Failed to parse track metadata from file"
@@ -975,6 +991,7 @@ bool TrackDAO::onPurgingTracks(
             return false;
         }
     }
+    m_searchIndexDao.removeTracks(trackIds);
     {
         // invalidate the hash in LibraryHash,
         // in case the file was not deleted to detect it on a rescan
@@ -1247,8 +1264,9 @@ TrackPointer TrackDAO::getTrackById(TrackId trackId) const {
         return TrackPointer();
     }
 
-    // The GlobalTrackCache is only locked while executing the following line.
-    TrackPointer pTrack = GlobalTrackCacheLocker().lookupTrackById(trackId);
+    // Only a single shard of the GlobalTrackCache is locked while
+    // executing the following line.
+    TrackPointer pTrack = GlobalTrackCache::lookupCachedTrackById(trackId);
     if (pTrack) {
         return pTrack;
     }
@@ -1258,7 +1276,6 @@ TrackPointer TrackDAO::getTrackById(TrackId trackId) const {
     // will be locked again after the query has been executed (see below)
     // and potential race conditions will be resolved.
     ScopedTimer t("TrackDAO::getTrackById");
-    QSqlQuery query(m_database);
 
     ColumnPopulator columns[] = {
             // Location must be first.
@@ -1332,10 +1349,14 @@ TrackPointer TrackDAO::getTrackById(TrackId trackId) const {
         columnsStr.append(columns[i].name);
     }
 
-    query.prepare(QString(
-            "SELECT %1 FROM Library "
-            "INNER JOIN track_locations ON library.location = track_locations.id "
-            "WHERE library.id = %2").arg(columnsStr, trackId.toString()));
+    // The statement is prepared only once and then reused for all tracks
+    QSqlQuery query = SqlQueryCache::prepare(m_database,
+            QString("SELECT %1 FROM Library "
+                    "INNER JOIN track_locations ON library.location = track_locations.id "
+                    "WHERE library.id=:id")
+                    .arg(columnsStr));
+    SqlQueryFinisher queryFinisher(query);
+    query.bindValue(":id", trackId.toVariant());
 
     VERIFY_OR_DEBUG_ASSERT(query.exec()) {
         LOG_FAILED_QUERY(query)
@@ -1348,6 +1369,9 @@ TrackPointer TrackDAO::getTrackById(TrackId trackId) const {
     }
 
     QSqlRecord queryRecord = query.record();
+    // Loading the cues and the track's metadata below might need
+    // to execute the same statement again
+    queryFinisher.finish();
     int recordCount = queryRecord.count();
     VERIFY_OR_DEBUG_ASSERT(recordCount == columnsCount) {
         recordCount = math_min(recordCount, columnsCount);
@@ -1457,8 +1481,7 @@ TrackId TrackDAO::getTrackIdByRef(
         return trackRef.getId();
     }
     {
-        GlobalTrackCacheLocker cacheLocker;
-        const auto pTrack = cacheLocker.lookupTrackByRef(trackRef);
+        const auto pTrack = GlobalTrackCache::lookupCachedTrackByRef(trackRef);
         if (pTrack) {
             return pTrack->getId();
         }
@@ -1472,8 +1495,7 @@ TrackPointer TrackDAO::getTrackByRef(
         return TrackPointer();
     }
     {
-        GlobalTrackCacheLocker cacheLocker;
-        auto pTrack = cacheLocker.lookupTrackByRef(trackRef);
+        auto pTrack = GlobalTrackCache::lookupCachedTrackByRef(trackRef);
         if (pTrack) {
             return pTrack;
         }
@@ -1503,10 +1525,8 @@ bool TrackDAO::updateTrack(Track* pTrack) const {
     // PerformanceTimer time;
     // time.start();
 
-    QSqlQuery query(m_database);
-
     // Update everything but "location", since that's what we identify the track by.
-    query.prepare(
+    QSqlQuery query = SqlQueryCache::prepare(m_database,
             "UPDATE library SET "
             "artist=:artist,"
             "title=:title,"
@@ -1551,6 +1571,7 @@ bool TrackDAO::updateTrack(Track* pTrack) const {
             "coverart_digest=:coverart_digest,"
             "coverart_hash=:coverart_hash "
             "WHERE id=:track_id");
+    SqlQueryFinisher queryFinisher(query);
 
     query.bindValue(":track_id", trackId.toVariant());
 
@@ -1569,6 +1590,8 @@ bool TrackDAO::updateTrack(Track* pTrack) const {
         return false;
     }
 
+    m_searchIndexDao.updateTracks({trackId});
+
     //qDebug() << "Update track took : " << time.elapsed().formatMillisWithUnit() << "Now updating cues";
     //time.start();
     m_analysisDao.saveTrackAnalyses(
@@ -1601,6 +1624,41 @@ void TrackDAO::invalidateTrackLocationsInLibrary() const {
     }
 }
 
+void TrackDAO::invalidateTrackLocationsInDirectories(
+        const QStringList& directories) const {
+    QSqlQuery query(m_database);
+    query.prepare(
+            QString("UPDATE track_locations "
+                    "SET needs_verification=1 "
+                    "WHERE directory IN (%1)")
+                    .arg(SqlStringFormatter::formatList(m_database, directories)));
+    VERIFY_OR_DEBUG_ASSERT(query.exec()) {
+        LOG_FAILED_QUERY(query)
+                << "Couldn't mark tracks in" << directories.size()
+                << "directories as needing verification.";
+    }
+}
+
+void TrackDAO::invalidateTrackLocationsInDirectoryTree(const QString& dirPath) const {
+    // dir needs to end in a slash otherwise we might match other
+    // directories.
+    const QString likeClause =
+            SqlLikeWildcardEscaper::apply(dirPath + "/", kSqlLikeMatchAll) +
+            kSqlLikeMatchAll;
+    QSqlQuery query(m_database);
+    query.prepare(
+            QString("UPDATE track_locations "
+                    "SET needs_verification=1 "
+                    "WHERE location LIKE :like_clause ESCAPE '%1'")
+                    .arg(kSqlLikeMatchAll));
+    query.bindValue(":like_clause", likeClause);
+    VERIFY_OR_DEBUG_ASSERT(query.exec()) {
+        LOG_FAILED_QUERY(query)
+                << "Couldn't mark tracks in" << dirPath
+                << "as needing verification.";
+    }
+}
+
 void TrackDAO::markTrackLocationsAsVerified(const QStringList& locations) const {
     //qDebug() << "TrackDAO::markTrackLocationsAsVerified" << QThread::currentThread() << m_database.connectionName();
 
@@ -20,6 +20,8 @@ class PlaylistDAO;
 class AnalysisDao;
 class CueDAO;
 class LibraryHashDAO;
+class SearchIndexDAO;
+struct ParsedTrackMetadata;
 
 class TrackDAO : public QObject, public virtual DAO, public virtual GlobalTrackCacheRelocator {
     Q_OBJECT
@@ -39,6 +41,7 @@ class TrackDAO : public QObject, public virtual DAO, public virtual GlobalTrackC
             PlaylistDAO& playlistDao,
             AnalysisDao& analysisDao,
             LibraryHashDAO& libraryHashDao,
+            SearchIndexDAO& searchIndexDao,
             UserSettingsPointer pConfig);
     ~TrackDAO() override;
 
@@ -115,9 +118,12 @@ class TrackDAO : public QObject, public virtual DAO, public virtual GlobalTrackC
     TrackId addTracksAddTrack(
             const TrackPointer& pTrack,
             bool unremove);
+    // The metadata of new files might have been parsed in advance
+    // by a worker thread.
     TrackPointer addTracksAddFile(
             const TrackFile& trackFile,
-            bool unremove);
+            bool unremove,
+            const ParsedTrackMetadata* pParsedMetadata = nullptr);
     void addTracksFinish(bool rollback = false);
 
     bool updateTrack(Track* pTrack) const;
@@ -143,6 +149,8 @@ class TrackDAO : public QObject, public virtual DAO, public virtual GlobalTrackC
     void markTrackLocationsAsVerified(const QStringList& locations) const;
     void markTracksInDirectoriesAsVerified(const QStringList& directories) const;
     void invalidateTrackLocationsInLibrary() const;
+    void invalidateTrackLocationsInDirectories(const QStringList& directories) const;
+    void invalidateTrackLocationsInDirectoryTree(const QString& dirPath) const;
     void markUnverifiedTracksAsDeleted();
 
     bool verifyRemainingTracks(
@@ -163,6 +171,7 @@ class TrackDAO : public QObject, public virtual DAO, public virtual GlobalTrackC
     PlaylistDAO& m_playlistDao;
     AnalysisDao& m_analysisDao;
     LibraryHashDAO& m_libraryHashDao;
+    SearchIndexDAO& m_searchIndexDao;
 
     UserSettingsPointer m_pConfig;
 
@@ -28,6 +28,10 @@ TrackExportDlg::TrackExportDlg(QWidget *parent,
             &TrackExportWorker::progress,
             this,
             &TrackExportDlg::slotProgress);
+    connect(m_worker,
+            &TrackExportWorker::transferProgress,
+            this,
+            &TrackExportDlg::slotTransferProgress);
     connect(m_worker,
             &TrackExportWorker::askOverwriteMode,
             this,
@@ -52,16 +56,36 @@ void TrackExportDlg::showEvent(QShowEvent* event) {
 
 void TrackExportDlg::slotProgress(QString filename, int progress, int count) {
     if (progress == count) {
-        statusLabel->setText(tr("Export finished"));
+        m_statusFilename = tr("Export finished");
+        updateStatus();
         finish();
     } else {
-        statusLabel->setText(tr("Exporting %1").arg(filename));
+        m_statusFilename = tr("Exporting %1").arg(filename);
+        updateStatus();
     }
     exportProgress->setMinimum(0);
     exportProgress->setMaximum(count);
     exportProgress->setValue(progress);
 }
 
+void TrackExportDlg::slotTransferProgress(
+        qint64 bytesCopied, qint64 bytesTotal, qint64 bytesPerSecond) {
+    const double kBytesPerMB = 1024.0 * 1024.0;
+    m_statusTransfer = tr("%1 of %2 MB copied (%3 MB/s)")
+                               .arg(QString::number(bytesCopied / kBytesPerMB, 'f', 1),
+                                       QString::number(bytesTotal / kBytesPerMB, 'f', 1),
+                                       QString::number(bytesPerSecond / kBytesPerMB, 'f', 1));
+    updateStatus();
+}
+
+void TrackExportDlg::updateStatus() {
+    if (m_statusTransfer.isEmpty()) {
+        statusLabel->setText(m_statusFilename);
+    } else {
+        statusLabel->setText(m_statusFilename + QChar('\n') + m_statusTransfer);
+    }
+}
+
 void TrackExportDlg::slotAskOverwriteMode(
         QString filename,
         std::promise<TrackExportWorker::OverwriteAnswer>* promise) {
@@ -31,6 +31,7 @@ class TrackExportDlg : public QDialog, public Ui::DlgTrackExport {
 
   public slots:
     void slotProgress(QString filename, int progress, int count);
+    void slotTransferProgress(qint64 bytesCopied, qint64 bytesTotal, qint64 bytesPerSecond);
     void slotAskOverwriteMode(
             QString filename,
             std::promise<TrackExportWorker::OverwriteAnswer>* promise);
@@ -47,9 +48,13 @@ class TrackExportDlg : public QDialog, public Ui::DlgTrackExport {
     // Makes sure the exporter thread has exited.
     void finish();
 
+    void updateStatus();
+
     UserSettingsPointer m_pConfig;
     QList<TrackPointer> m_tracks;
     TrackExportWorker* m_worker;
+    QString m_statusFilename;
+    QString m_statusTransfer;
 };
 
 #endif  // DLGTRACKEXPORT_H
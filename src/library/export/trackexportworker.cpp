@@ -1,11 +1,128 @@
 #include "library/export/trackexportworker.h"
 
+#include <QCryptographicHash>
 #include <QFileInfo>
 #include <QMessageBox>
 #include <QDebug>
+#include <QThreadPool>
+#include <QtConcurrentRun>
+
+#ifdef __LINUX__
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 27))
+#define MIXXX_HAVE_COPY_FILE_RANGE
+#endif
+#endif
+
+#include "util/compatibility.h"
+#include "util/performancetimer.h"
 
 namespace {
 
+constexpr QCryptographicHash::Algorithm kChecksumAlgorithm = QCryptographicHash::Sha256;
+
+// Large buffers reduce the number of system calls. Also the granularity
+// for aborting a copy operation.
+constexpr qint64 kCopyChunkSize = 4 * 1024 * 1024;
+
+constexpr unsigned long kTransferProgressIntervalMillis = 250;
+
+enum class CopyResult {
+    Done,
+    Unsupported,
+    Failed,
+};
+
+#ifdef MIXXX_HAVE_COPY_FILE_RANGE
+// Copies the data within the kernel, which also allows server-side copies
+// on network file systems and reflinks.
+CopyResult copyFileRange(int sourceFd,
+        int destFd,
+        qint64 size,
+        const QAtomicInt& stop,
+        QAtomicInteger<qint64>* pBytesCopied,
+        QString* pErrorString) {
+    qint64 copied = 0;
+    while (copied < size) {
+        if (atomicLoadAcquire(stop)) {
+            return CopyResult::Failed;
+        }
+        const ssize_t length = copy_file_range(sourceFd,
+                nullptr,
+                destFd,
+                nullptr,
+                static_cast<size_t>(std::min(size - copied, kCopyChunkSize)),
+                0);
+        if (length < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (copied == 0 &&
+                    (errno == EXDEV || errno == ENOSYS || errno == EOPNOTSUPP ||
+                            errno == EINVAL || errno == EBADF)) {
+                return CopyResult::Unsupported;
+            }
+            *pErrorString = QString::fromLocal8Bit(strerror(errno));
+            return CopyResult::Failed;
+        }
+        if (length == 0) {
+            if (copied == 0) {
+                // Some file systems silently don't copy anything
+                return CopyResult::Unsupported;
+            }
+            // The source file has been truncated, detected by the checksum
+            break;
+        }
+        copied += length;
+        pBytesCopied->fetchAndAddRelaxed(length);
+    }
+    return CopyResult::Done;
+}
+#endif
+
+CopyResult copyStream(QFile* pSource,
+        QFile* pDest,
+        QCryptographicHash* pSourceHash,
+        const QAtomicInt& stop,
+        QAtomicInteger<qint64>* pBytesCopied,
+        QString* pErrorString) {
+    QByteArray buffer(static_cast<int>(kCopyChunkSize), Qt::Uninitialized);
+    for (;;) {
+        if (atomicLoadAcquire(stop)) {
+            return CopyResult::Failed;
+        }
+        const qint64 length = pSource->read(buffer.data(), buffer.size());
+        if (length < 0) {
+            *pErrorString = pSource->errorString();
+            return CopyResult::Failed;
+        }
+        if (length == 0) {
+            return CopyResult::Done;
+        }
+        pSourceHash->addData(buffer.constData(), static_cast<int>(length));
+        if (pDest->write(buffer.constData(), length) != length) {
+            *pErrorString = pDest->errorString();
+            return CopyResult::Failed;
+        }
+        pBytesCopied->fetchAndAddRelaxed(length);
+    }
+}
+
+bool hashFile(const QString& path, QCryptographicHash* pHash, QString* pErrorString) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly) || !pHash->addData(&file)) {
+        *pErrorString = file.errorString();
+        return false;
+    }
+    return true;
+}
+
 QString rewriteFilename(const QFileInfo& fileinfo, int index) {
     // We don't have total control over the inputs, so definitely
     // don't use .arg().arg().arg().
@@ -70,30 +187,90 @@ QMap<QString, TrackFile> createCopylist(const QList<TrackPointer>& tracks) {
 }  // namespace
 
 void TrackExportWorker::run() {
+    const QMap<QString, TrackFile> copy_list = createCopylist(m_tracks);
+    const int count = copy_list.size();
+
+    // The questions about existing files must be answered before copying
+    // files concurrently.
+    QList<ExportJob> jobs;
+    qint64 bytesTotal = 0;
     int i = 0;
-    QMap<QString, TrackFile> copy_list = createCopylist(m_tracks);
+    QString filename;
     for (auto it = copy_list.constBegin(); it != copy_list.constEnd(); ++it) {
-        // We emit progress twice per loop, which may seem excessive, but it
-        // guarantees that we emit a sane progress before we start and after
-        // we end.  In between, each filename will get its own visible tick
-        // on the bar, which looks really nice.
-        emit progress(it->fileName(), i, copy_list.size());
-        copyFile((*it).asFileInfo(), it.key());
+        ExportJob job;
+        const bool copy = prepareJob((*it).asFileInfo(), it.key(), &job);
         if (atomicLoadAcquire(m_bStop)) {
             emit canceled();
             return;
         }
-        ++i;
-        emit progress(it->fileName(), i, copy_list.size());
+        if (copy) {
+            bytesTotal += job.size;
+            jobs.append(job);
+        } else {
+            ++i;
+            filename = it->fileName();
+        }
     }
+    // Skipped files are already done.  This also emits a sane progress
+    // before we start, even for an empty list.
+    emit progress(filename, i, count);
+
+    m_bytesCopied = 0;
+    PerformanceTimer timer;
+    timer.start();
+    QThreadPool pool;
+    pool.setMaxThreadCount(m_maxConcurrentCopies);
+    for (const auto& job : jobs) {
+        QtConcurrent::run(&pool, [this, job] { exportFile(job); });
+    }
+
+    int pending = jobs.size();
+    while (pending > 0) {
+        QStringList finishedFileNames;
+        {
+            QMutexLocker locker(&m_mutex);
+            if (m_finishedFileNames.isEmpty() && !atomicLoadAcquire(m_bStop)) {
+                m_jobFinished.wait(&m_mutex, kTransferProgressIntervalMillis);
+            }
+            finishedFileNames.swap(m_finishedFileNames);
+        }
+        if (atomicLoadAcquire(m_bStop)) {
+            // Wait until all aborted copy operations have cleaned up
+            pool.waitForDone();
+            emit canceled();
+            return;
+        }
+        const qint64 bytesCopied = atomicLoadAcquire(m_bytesCopied);
+        const double elapsedSeconds = timer.elapsed().toDoubleSeconds();
+        const qint64 bytesPerSecond = elapsedSeconds > 0
+                ? static_cast<qint64>(bytesCopied / elapsedSeconds)
+                : 0;
+        emit transferProgress(bytesCopied, bytesTotal, bytesPerSecond);
+        // Each filename will get its own visible tick on the bar
+        for (const auto& finishedFileName : qAsConst(finishedFileNames)) {
+            ++i;
+            --pending;
+            emit progress(finishedFileName, i, count);
+        }
+    }
+    qDebug() << "Exported" << jobs.size() << "files with"
+             << atomicLoadAcquire(m_bytesCopied) << "bytes in"
+             << timer.elapsed().debugMillisWithUnit();
 }
 
-void TrackExportWorker::copyFile(const QFileInfo& source_fileinfo,
-                                 const QString& dest_filename) {
+bool TrackExportWorker::prepareJob(const QFileInfo& source_fileinfo,
+        const QString& dest_filename,
+        ExportJob* pJob) {
     QString sourceFilename = source_fileinfo.canonicalFilePath();
     const QString dest_path = QDir(m_destDir).filePath(dest_filename);
     QFileInfo dest_fileinfo(dest_path);
 
+    pJob->sourcePath = sourceFilename;
+    pJob->destPath = dest_path;
+    pJob->fileName = source_fileinfo.fileName();
+    pJob->size = source_fileinfo.size();
+    pJob->overwrite = false;
+
     if (dest_fileinfo.exists()) {
         switch (m_overwriteMode) {
         // Give the user the option to overwrite existing files in the destination.
@@ -102,47 +279,138 @@ void TrackExportWorker::copyFile(const QFileInfo& source_fileinfo,
             case OverwriteAnswer::SKIP:
             case OverwriteAnswer::SKIP_ALL:
                 qDebug() << "skipping" << sourceFilename;
-                return;
+                return false;
             case OverwriteAnswer::OVERWRITE:
             case OverwriteAnswer::OVERWRITE_ALL:
                 break;
             case OverwriteAnswer::CANCEL:
-                m_errorMessage = tr("Export process was canceled");
-                stop();
-                return;
+                abortExport(tr("Export process was canceled"));
+                return false;
             }
             break;
         case OverwriteMode::SKIP_ALL:
             qDebug() << "skipping" << sourceFilename;
-            return;
+            return false;
         case OverwriteMode::OVERWRITE_ALL:;
         }
+        pJob->overwrite = true;
+    }
+    return true;
+}
+
+void TrackExportWorker::exportFile(const ExportJob& job) {
+    if (atomicLoadAcquire(m_bStop)) {
+        return;
+    }
 
+    if (job.overwrite) {
         // Remove the existing file in preparation for overwriting.
-        QFile dest_file(dest_path);
-        qDebug() << "Removing existing file" << dest_path;
+        QFile dest_file(job.destPath);
+        qDebug() << "Removing existing file" << job.destPath;
         if (!dest_file.remove()) {
             const QString error_message = tr(
                     "Error removing file %1: %2. Stopping.").arg(
-                    dest_path, dest_file.errorString());
+                    job.destPath, dest_file.errorString());
             qWarning() << error_message;
-            m_errorMessage = error_message;
-            stop();
+            abortExport(error_message);
             return;
         }
     }
 
-    qDebug() << "Copying" << sourceFilename << "to" << dest_path;
-    QFile source_file(sourceFilename);
-    if (!source_file.copy(dest_path)) {
+    qDebug() << "Copying" << job.sourcePath << "to" << job.destPath;
+    QString errorString;
+    if (!copyFileContents(job, &errorString)) {
+        // Never leave an incomplete file behind
+        QFile::remove(job.destPath);
+        if (errorString.isEmpty()) {
+            // Stopped
+            return;
+        }
         const QString error_message = tr(
                 "Error exporting track %1 to %2: %3. Stopping.").arg(
-                sourceFilename, dest_path, source_file.errorString());
+                job.sourcePath, job.destPath, errorString);
         qWarning() << error_message;
-        m_errorMessage = error_message;
-        stop();
+        abortExport(error_message);
         return;
     }
+    // Preserve the permissions like QFile::copy(). Not supported by
+    // all file systems of portable devices, which is not an error.
+    if (!QFile::setPermissions(job.destPath, QFile::permissions(job.sourcePath))) {
+        qWarning() << "Failed to copy the permissions of" << job.sourcePath
+                   << "to" << job.destPath;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    m_finishedFileNames.append(job.fileName);
+    m_jobFinished.wakeAll();
+}
+
+bool TrackExportWorker::copyFileContents(const ExportJob& job, QString* pErrorString) {
+    QFile source_file(job.sourcePath);
+    if (!source_file.open(QIODevice::ReadOnly)) {
+        *pErrorString = source_file.errorString();
+        return false;
+    }
+    QFile dest_file(job.destPath);
+    if (!dest_file.open(QIODevice::WriteOnly)) {
+        *pErrorString = dest_file.errorString();
+        return false;
+    }
+
+    QCryptographicHash sourceHash(kChecksumAlgorithm);
+    bool sourceHashed = false;
+    CopyResult result = CopyResult::Unsupported;
+#ifdef __LINUX__
+    const int sourceFd = source_file.handle();
+    const int destFd = dest_file.handle();
+#ifdef FICLONE
+    if (ioctl(destFd, FICLONE, sourceFd) == 0) {
+        // The cloned extents are shared with the source file and no data
+        // has been written that could be verified.
+        m_bytesCopied.fetchAndAddRelaxed(job.size);
+        return true;
+    }
+#endif
+#ifdef MIXXX_HAVE_COPY_FILE_RANGE
+    result = copyFileRange(sourceFd, destFd, job.size, m_bStop, &m_bytesCopied, pErrorString);
+#endif
+#endif
+    if (result == CopyResult::Unsupported) {
+        // Copying between different file systems is not supported by older
+        // kernels or on other platforms
+        result = copyStream(&source_file, &dest_file, &sourceHash, m_bStop, &m_bytesCopied, pErrorString);
+        sourceHashed = true;
+    }
+    if (result != CopyResult::Done) {
+        return false;
+    }
+
+    // Read back the copy from the device instead of the page cache
+    if (!dest_file.flush()) {
+        *pErrorString = dest_file.errorString();
+        return false;
+    }
+#ifdef __LINUX__
+    if (fdatasync(destFd) != 0) {
+        *pErrorString = QString::fromLocal8Bit(strerror(errno));
+        return false;
+    }
+    posix_fadvise(destFd, 0, 0, POSIX_FADV_DONTNEED);
+#endif
+    dest_file.close();
+
+    if (!sourceHashed && !hashFile(job.sourcePath, &sourceHash, pErrorString)) {
+        return false;
+    }
+    QCryptographicHash destHash(kChecksumAlgorithm);
+    if (!hashFile(job.destPath, &destHash, pErrorString)) {
+        return false;
+    }
+    if (sourceHash.result() != destHash.result()) {
+        *pErrorString = tr("Checksum mismatch");
+        return false;
+    }
+    return true;
 }
 
 TrackExportWorker::OverwriteAnswer TrackExportWorker::makeOverwriteRequest(
@@ -166,8 +434,7 @@ TrackExportWorker::OverwriteAnswer TrackExportWorker::makeOverwriteRequest(
 
     if (!mode_future.valid()) {
         qWarning() << "TrackExportWorker::makeOverwriteRequest invalid answer from future";
-        m_errorMessage = tr("Error exporting tracks");
-        stop();
+        abortExport(tr("Error exporting tracks"));
         return OverwriteAnswer::CANCEL;
     }
 
@@ -181,8 +448,7 @@ TrackExportWorker::OverwriteAnswer TrackExportWorker::makeOverwriteRequest(
         break;
     case OverwriteAnswer::CANCEL:
         // Handle cancellation as a result of the question.
-        m_errorMessage = tr("Export process was canceled");
-        stop();
+        abortExport(tr("Export process was canceled"));
         break;
     default:;
     }
@@ -190,7 +456,19 @@ TrackExportWorker::OverwriteAnswer TrackExportWorker::makeOverwriteRequest(
     return answer;
 }
 
+void TrackExportWorker::abortExport(const QString& errorMessage) {
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_errorMessage.isEmpty()) {
+            m_errorMessage = errorMessage;
+        }
+    }
+    stop();
+}
+
 void TrackExportWorker::stop() {
-    // We'll wait for the current file to finish copying, then stop.
+    // Copy operations in progress check this flag between chunks.
     m_bStop = true;
+    QMutexLocker locker(&m_mutex);
+    m_jobFinished.wakeAll();
 }
@@ -1,18 +1,22 @@
 #ifndef TRACKEXPORTWORKER_H
 #define TRACKEXPORTWORKER_H
 
+#include <QMutex>
 #include <QObject>
 #include <QScopedPointer>
 #include <QString>
+#include <QStringList>
 #include <QThread>
+#include <QWaitCondition>
 #include <future>
 
 #include "track/track.h"
 
 // A QThread class for copying a list of files to a single destination directory.
-// Currently does not preserve subdirectory relationships.  This class performs
-// all copies in a blocking style within its own thread.  May be canceled from
-// another thread.
+// Currently does not preserve subdirectory relationships.  All questions about
+// existing files are asked upfront within its own thread, then the files are
+// copied concurrently by a bounded number of threads.  The checksum of each
+// copy is verified.  May be canceled from another thread.
 class TrackExportWorker : public QThread {
     Q_OBJECT
   public:
@@ -32,10 +36,20 @@ class TrackExportWorker : public QThread {
         CANCEL = -1,
     };
 
+    // All files are exported into the same directory, i.e. onto the same
+    // device.  Too many concurrent writers would only cause seeking on
+    // rotating disks and cheap USB sticks.
+    static constexpr int kDefaultMaxConcurrentCopies = 4;
+
     // Constructor does not validate the destination directory.  Calling classes
     // should do that.
-    TrackExportWorker(QString destDir, QList<TrackPointer> tracks)
-            : m_destDir(destDir), m_tracks(tracks) { }
+    TrackExportWorker(QString destDir,
+            QList<TrackPointer> tracks,
+            int maxConcurrentCopies = kDefaultMaxConcurrentCopies)
+            : m_destDir(destDir),
+              m_tracks(tracks),
+              m_maxConcurrentCopies(maxConcurrentCopies) {
+    }
     virtual ~TrackExportWorker() { };
 
     // exports ALL the tracks.  Thread joins on success or failure.
@@ -44,10 +58,12 @@ class TrackExportWorker : public QThread {
     // Calling classes can call errorMessage after a failure for a user-friendly
     // message about what happened.
     QString errorMessage() const {
+        QMutexLocker locker(&m_mutex);
         return m_errorMessage;
     }
 
-    // Cancels the export after the current copy operation.
+    // Cancels the export.  Copy operations that are in progress are aborted
+    // and their incomplete files are removed.
     // May be called from another thread.
     void stop();
 
@@ -61,27 +77,58 @@ class TrackExportWorker : public QThread {
             QString filename,
             std::promise<TrackExportWorker::OverwriteAnswer>* promise);
     void progress(QString filename, int progress, int count);
+    // Emitted periodically while copying files.
+    void transferProgress(qint64 bytesCopied, qint64 bytesTotal, qint64 bytesPerSecond);
     void canceled();
 
   private:
-    // Copies the file at source_fileinfo to the destination directory with the
-    // name given by dest_filename (not a full path).  If the destination file
-    // exists, will emit an overwrite request signal to ask how to proceed.
+    struct ExportJob {
+        QString sourcePath;
+        QString destPath;
+        QString fileName;
+        qint64 size = 0;
+        bool overwrite = false;
+    };
+
+    // Checks if the file at source_fileinfo needs to be exported to the
+    // destination directory with the name given by dest_filename (not a full
+    // path).  If the destination file exists, will emit an overwrite request
+    // signal to ask how to proceed.  Returns false if the file should be
+    // skipped or if the export has been canceled.
+    bool prepareJob(const QFileInfo& source_fileinfo,
+            const QString& dest_filename,
+            ExportJob* pJob);
+
+    // Copies a single file, invoked concurrently from multiple threads.
     // On unrecoverable error, sets the error message and stops the export
     // process entirely.
-    void copyFile(const QFileInfo& source_fileinfo,
-                  const QString& dest_filename);
+    void exportFile(const ExportJob& job);
+
+    // Copies the contents of the file and verifies the checksum of the copy.
+    // Returns false and leaves the error string empty if the export has been
+    // stopped.
+    bool copyFileContents(const ExportJob& job, QString* pErrorString);
 
     // Emit a signal requesting overwrite mode, and block until we get an
     // answer.  Updates m_overwriteMode appropriately.
     OverwriteAnswer makeOverwriteRequest(QString filename);
 
+    // Keeps the first error message and stops the export.
+    void abortExport(const QString& errorMessage);
+
     QAtomicInt m_bStop = false;
-    QString m_errorMessage;
+    QAtomicInteger<qint64> m_bytesCopied = 0;
 
     OverwriteMode m_overwriteMode = OverwriteMode::ASK;
     const QString m_destDir;
     const QList<TrackPointer> m_tracks;
+    const int m_maxConcurrentCopies;
+
+    // Guards all following members
+    mutable QMutex m_mutex;
+    QWaitCondition m_jobFinished;
+    QStringList m_finishedFileNames;
+    QString m_errorMessage;
 };
 
 #endif  // TRACKEXPORTWORKER_H
@@ -0,0 +1,299 @@
+#include "library/scanner/directorywatcher.h"
+
+#include <QFile>
+#include <QMutexLocker>
+#include <QSocketNotifier>
+#include <QUuid>
+
+#ifdef __LINUX__
+#include <errno.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <sys/vfs.h>
+#include <unistd.h>
+#endif
+
+#include "util/assert.h"
+#include "util/logger.h"
+
+namespace {
+
+const mixxx::Logger kLogger("DirectoryWatcher");
+
+#ifdef __LINUX__
+// Only structural changes affect the hash of a directory
+constexpr uint32_t kWatchMask = IN_CREATE | IN_DELETE | IN_MOVED_FROM |
+        IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+
+// The magic numbers of file systems that are shared with other hosts
+// or implemented in user space, see statfs(2)
+constexpr quint32 kUnwatchableFileSystemTypes[] = {
+        0x6969,     // NFS
+        0x517B,     // SMB
+        0xFF534D42, // CIFS
+        0xFE534D42, // SMB2
+        0x65735546, // FUSE
+        0x564C,     // NCP
+        0x73757245, // CODA
+        0x5346414F, // AFS
+        0x00C36400, // CEPH
+        0x01021997, // 9P
+        0x01161970, // GFS2
+        0x7461636F, // OCFS2
+};
+#endif
+
+QStringList sortedDirPaths(QStringList dirPaths) {
+    for (auto& dirPath : dirPaths) {
+        while (dirPath.size() > 1 && dirPath.endsWith(QChar('/'))) {
+            dirPath.chop(1);
+        }
+    }
+    dirPaths.sort();
+    return dirPaths;
+}
+
+} // anonymous namespace
+
+DirectoryWatcher::DirectoryWatcher(QObject* parent)
+        : QObject(parent),
+          m_sessionId(QUuid::createUuid().toString()),
+          m_checkpoint(0),
+          m_fd(-1),
+          m_pNotifier(nullptr),
+          m_complete(false) {
+#ifdef __LINUX__
+    m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_fd < 0) {
+        kLogger.warning()
+                << "Failed to initialize inotify:"
+                << strerror(errno);
+        return;
+    }
+    m_pNotifier = new QSocketNotifier(m_fd, QSocketNotifier::Read, this);
+    connect(m_pNotifier,
+            &QSocketNotifier::activated,
+            this,
+            &DirectoryWatcher::slotReadEvents);
+#endif
+}
+
+DirectoryWatcher::~DirectoryWatcher() {
+#ifdef __LINUX__
+    if (m_fd >= 0) {
+        // Closing the descriptor removes all watches
+        delete m_pNotifier;
+        close(m_fd);
+    }
+#endif
+}
+
+//static
+bool DirectoryWatcher::isSupported() {
+#ifdef __LINUX__
+    return true;
+#else
+    return false;
+#endif
+}
+
+//static
+bool DirectoryWatcher::isWatchable(const QString& dirPath) {
+#ifdef __LINUX__
+    struct statfs fileSystem;
+    if (statfs(QFile::encodeName(dirPath).constData(), &fileSystem) != 0) {
+        kLogger.warning()
+                << "Failed to determine the file system of"
+                << dirPath
+                << strerror(errno);
+        return false;
+    }
+    const auto fileSystemType = static_cast<quint32>(fileSystem.f_type);
+    for (const auto unwatchableFileSystemType : kUnwatchableFileSystemTypes) {
+        if (fileSystemType == unwatchableFileSystemType) {
+            return false;
+        }
+    }
+    return true;
+#else
+    Q_UNUSED(dirPath);
+    return false;
+#endif
+}
+
+void DirectoryWatcher::reset(const QStringList& rootDirPaths) {
+    QMutexLocker locker(&m_mutex);
+#ifdef __LINUX__
+    if (m_fd >= 0) {
+        for (auto it = m_dirPathsByWatch.constBegin();
+                it != m_dirPathsByWatch.constEnd();
+                ++it) {
+            inotify_rm_watch(m_fd, it.key());
+        }
+        // Discard all events of the removed watches
+        readEvents();
+    }
+#endif
+    m_dirPathsByWatch.clear();
+    m_watchesByDirPath.clear();
+    m_changedDirPaths.clear();
+    m_removedDirPaths.clear();
+    m_rootDirPaths = sortedDirPaths(rootDirPaths);
+    m_complete = m_fd >= 0;
+    ++m_checkpoint;
+}
+
+void DirectoryWatcher::watchDirectory(const QString& dirPath) {
+#ifdef __LINUX__
+    QMutexLocker locker(&m_mutex);
+    if (!m_complete || m_watchesByDirPath.contains(dirPath)) {
+        return;
+    }
+    const int watch = inotify_add_watch(
+            m_fd, QFile::encodeName(dirPath).constData(), kWatchMask);
+    if (watch < 0) {
+        if (errno == ENOENT) {
+            // Already deleted, the parent directory has been modified
+            return;
+        }
+        // The limit is configured in /proc/sys/fs/inotify/max_user_watches
+        setIncomplete(QStringLiteral("Failed to watch directory %1: %2")
+                              .arg(dirPath, strerror(errno)));
+        return;
+    }
+    // Hard links or bind mounts might refer to the same directory
+    const auto oldDirPath = m_dirPathsByWatch.value(watch);
+    if (!oldDirPath.isEmpty()) {
+        m_watchesByDirPath.remove(oldDirPath);
+    }
+    m_dirPathsByWatch.insert(watch, dirPath);
+    m_watchesByDirPath.insert(dirPath, watch);
+#else
+    Q_UNUSED(dirPath);
+#endif
+}
+
+bool DirectoryWatcher::isComplete(const QStringList& rootDirPaths) const {
+    QMutexLocker locker(&m_mutex);
+    return m_complete && m_rootDirPaths == sortedDirPaths(rootDirPaths);
+}
+
+QString DirectoryWatcher::journalCursor() const {
+    QMutexLocker locker(&m_mutex);
+    return QStringLiteral("%1:%2").arg(m_sessionId, QString::number(m_checkpoint));
+}
+
+void DirectoryWatcher::takeChanges(
+        QSet<QString>* pChangedDirPaths,
+        QSet<QString>* pRemovedDirPaths) {
+    DEBUG_ASSERT(pChangedDirPaths);
+    DEBUG_ASSERT(pRemovedDirPaths);
+    QMutexLocker locker(&m_mutex);
+    // Don't miss any events that have not been delivered yet
+    readEvents();
+    *pChangedDirPaths = std::move(m_changedDirPaths);
+    *pRemovedDirPaths = std::move(m_removedDirPaths);
+    m_changedDirPaths.clear();
+    m_removedDirPaths.clear();
+    ++m_checkpoint;
+}
+
+void DirectoryWatcher::slotReadEvents() {
+    QMutexLocker locker(&m_mutex);
+    readEvents();
+}
+
+void DirectoryWatcher::readEvents() {
+#ifdef __LINUX__
+    alignas(struct inotify_event) char buffer[4096];
+    for (;;) {
+        const ssize_t length = read(m_fd, buffer, sizeof(buffer));
+        if (length <= 0) {
+            // EAGAIN if no more events are available
+            return;
+        }
+        for (const char* ptr = buffer; ptr < buffer + length;) {
+            const auto* pEvent = reinterpret_cast<const struct inotify_event*>(ptr);
+            ptr += sizeof(struct inotify_event) + pEvent->len;
+
+            if (pEvent->mask & IN_Q_OVERFLOW) {
+                setIncomplete(QStringLiteral("Event queue overflow"));
+                continue;
+            }
+            const QString dirPath = m_dirPathsByWatch.value(pEvent->wd);
+            if (dirPath.isEmpty()) {
+                // Pending event of a removed watch
+                continue;
+            }
+            if (pEvent->mask & IN_IGNORED) {
+                removeWatch(pEvent->wd);
+                continue;
+            }
+            if (pEvent->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_UNMOUNT)) {
+                if (m_rootDirPaths.contains(dirPath)) {
+                    setIncomplete(QStringLiteral("Library directory %1 has been removed")
+                                          .arg(dirPath));
+                }
+                // Otherwise the parent directory has been modified
+                continue;
+            }
+            if (!m_complete) {
+                // All changes will be discarded anyway
+                continue;
+            }
+            addChangedDirectory(dirPath);
+            if ((pEvent->mask & IN_ISDIR) &&
+                    (pEvent->mask & (IN_DELETE | IN_MOVED_FROM))) {
+                addRemovedDirectory(
+                        dirPath + QChar('/') + QFile::decodeName(pEvent->name));
+            }
+        }
+    }
+#endif
+}
+
+void DirectoryWatcher::addChangedDirectory(const QString& dirPath) {
+    m_changedDirPaths.insert(dirPath);
+}
+
+void DirectoryWatcher::addRemovedDirectory(const QString& dirPath) {
+    // The watches of a renamed directory tree would continue to report
+    // changes with the old paths
+    unwatchDirectoryTree(dirPath);
+    m_removedDirPaths.insert(dirPath);
+}
+
+void DirectoryWatcher::unwatchDirectoryTree(const QString& dirPath) {
+    const QString dirPathPrefix = dirPath + QChar('/');
+    QList<int> watches;
+    for (auto it = m_watchesByDirPath.constBegin();
+            it != m_watchesByDirPath.constEnd();
+            ++it) {
+        if (it.key() == dirPath || it.key().startsWith(dirPathPrefix)) {
+            watches.append(it.value());
+        }
+    }
+    for (const int watch : watches) {
+#ifdef __LINUX__
+        inotify_rm_watch(m_fd, watch);
+#endif
+        removeWatch(watch);
+    }
+}
+
+void DirectoryWatcher::removeWatch(int watch) {
+    const auto dirPath = m_dirPathsByWatch.take(watch);
+    if (!dirPath.isEmpty()) {
+        m_watchesByDirPath.remove(dirPath);
+    }
+}
+
+void DirectoryWatcher::setIncomplete(const QString& reason) {
+    if (!m_complete) {
+        return;
+    }
+    kLogger.info()
+            << reason
+            << "- the next rescan will scan all directories";
+    m_complete = false;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+class QSocketNotifier;
+
+/// Watches the directories of the music library for structural changes,
+/// i.e. files and subdirectories that are created, deleted, or renamed.
+///
+/// The changes are collected until the next rescan picks them up with
+/// takeChanges(). This allows the scanner to only revisit the affected
+/// directories instead of walking the whole directory tree. Modifications
+/// of the contents of existing files are ignored like during a regular
+/// rescan.
+///
+/// Only implemented on Linux with inotify. Changes on network and FUSE
+/// file systems that have been made by other hosts are not reported by
+/// the kernel! Directories on these file systems must be scanned
+/// completely, see isWatchable().
+///
+/// The position in the stream of changes is identified by a journal cursor
+/// that is stored in the settings after each successful rescan. The cursor
+/// includes a random session id. Persisted cursors of a previous session
+/// never match, i.e. after a restart all changes that happened in the
+/// meantime are unknown and the library needs to be rescanned completely.
+class DirectoryWatcher : public QObject {
+    Q_OBJECT
+  public:
+    explicit DirectoryWatcher(QObject* parent = nullptr);
+    ~DirectoryWatcher() override;
+
+    static bool isSupported();
+
+    /// Returns false if the directory is located on a file system that
+    /// might be modified without notifying the kernel, e.g. NFS, SMB/CIFS,
+    /// or FUSE mounts.
+    static bool isWatchable(const QString& dirPath);
+
+    /// Removes all watches and discards all pending changes before
+    /// the library is scanned completely. Starts a new checkpoint.
+    void reset(const QStringList& rootDirPaths);
+
+    /// Starts watching a directory before it is listed by the scanner.
+    /// Files that are created while the directory is scanned are then
+    /// reported as changes and picked up by the next rescan.
+    ///
+    /// Thread-safe, invoked by the tasks of the scanner.
+    void watchDirectory(const QString& dirPath);
+
+    /// Returns false if changes might have been missed, e.g. if the
+    /// kernel queue overflowed, if the watch limit has been exceeded,
+    /// or if the library directories differ from the watched ones.
+    bool isComplete(const QStringList& rootDirPaths) const;
+
+    /// Identifies the last checkpoint, i.e. all changes up to the
+    /// most recent invocation of either reset() or takeChanges().
+    QString journalCursor() const;
+
+    /// Returns all changes since the last checkpoint and starts a
+    /// new checkpoint.
+    ///
+    /// Directories that contain created, deleted, or renamed files or
+    /// subdirectories need to be rescanned non-recursively. Removed
+    /// directory trees need to be rescanned recursively if they have
+    /// been created again.
+    void takeChanges(
+            QSet<QString>* pChangedDirPaths,
+            QSet<QString>* pRemovedDirPaths);
+
+  private slots:
+    void slotReadEvents();
+
+  private:
+    // All following functions require the mutex
+    void readEvents();
+    void addChangedDirectory(const QString& dirPath);
+    void addRemovedDirectory(const QString& dirPath);
+    void unwatchDirectoryTree(const QString& dirPath);
+    void removeWatch(int watch);
+    void setIncomplete(const QString& reason);
+
+    const QString m_sessionId;
+    quint64 m_checkpoint;
+
+    int m_fd;
+    QSocketNotifier* m_pNotifier;
+
+    // Guards all following members
+    mutable QMutex m_mutex;
+    QStringList m_rootDirPaths;
+    QHash<int, QString> m_dirPathsByWatch;
+    QHash<QString, int> m_watchesByDirPath;
+    bool m_complete;
+
+    QSet<QString> m_changedDirPaths;
+    QSet<QString> m_removedDirPaths;
+};
@@ -1,6 +1,8 @@
 #include "library/scanner/importfilestask.h"
 
+#include "library/coverartutils.h"
 #include "library/scanner/libraryscanner.h"
+#include "track/globaltrackcache.h"
 #include "track/trackfile.h"
 #include "util/timer.h"
 
@@ -23,6 +25,9 @@ ImportFilesTask::ImportFilesTask(LibraryScanner* pScanner,
 
 void ImportFilesTask::run() {
     ScopedTimer timer("ImportFilesTask::run");
+    // All files are located in the same directory
+    CoverInfoGuesser coverInfoGuesser;
+    QList<NewTrackFile> newTrackFiles;
     for (const QFileInfo& fileInfo: m_filesToImport) {
         // If a flag was raised telling us to cancel the library scan then stop.
         if (m_scannerGlobal->shouldCancel()) {
@@ -30,7 +35,8 @@ void ImportFilesTask::run() {
             return;
         }
 
-        const QString trackLocation(TrackFile(fileInfo).location());
+        const TrackFile trackFile(fileInfo);
+        const QString trackLocation(trackFile.location());
         //qDebug() << "ImportFilesTask::run" << trackLocation;
 
         // If the file does not exist in the database then add it. If it
@@ -50,10 +56,44 @@ void ImportFilesTask::run() {
             }
             qDebug() << "Importing track" << trackLocation;
 
-            emit addNewTrack(trackLocation);
+            NewTrackFile newTrackFile;
+            newTrackFile.location = trackLocation;
+            // Parsing the file tags is the most expensive part of adding
+            // a new track and done here concurrently. Files that are
+            // already referenced by a track object must not be parsed
+            // without locking the cache and are parsed again when
+            // adding them.
+            if (!GlobalTrackCache::lookupCachedTrackByRef(
+                        TrackRef::fromFileInfo(trackFile))) {
+                newTrackFile.parsedMetadata =
+                        SoundSourceProxy::parseNewTrackMetadata(
+                                trackFile, &coverInfoGuesser);
+            }
+            newTrackFiles.append(std::move(newTrackFile));
+            if (newTrackFiles.size() >= ScannerGlobal::kNewTrackBatchSize &&
+                    !flushNewTrackFiles(&newTrackFiles)) {
+                setSuccess(false);
+                return;
+            }
         }
     }
+    if (!flushNewTrackFiles(&newTrackFiles)) {
+        setSuccess(false);
+        return;
+    }
     // Insert or update the hash in the database.
     emit directoryHashedAndScanned(m_dirPath, !m_prevHashExists, m_newHash);
     setSuccess(true);
 }
+
+bool ImportFilesTask::flushNewTrackFiles(QList<NewTrackFile>* pNewTrackFiles) {
+    if (pNewTrackFiles->isEmpty()) {
+        return true;
+    }
+    if (!m_scannerGlobal->acquirePendingNewTrackBatch()) {
+        return false;
+    }
+    emit addNewTracks(*pNewTrackFiles);
+    pNewTrackFiles->clear();
+    return true;
+}
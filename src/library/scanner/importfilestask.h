@@ -23,6 +23,10 @@ class ImportFilesTask : public ScannerTask {
     virtual void run();
 
   private:
+    // Hands over the parsed files to the LibraryScanner thread. Returns
+    // false if the scan has been cancelled.
+    bool flushNewTrackFiles(QList<NewTrackFile>* pNewTrackFiles);
+
     const QString m_dirPath;
     const bool m_prevHashExists;
     const mixxx::cache_key_t m_newHash;
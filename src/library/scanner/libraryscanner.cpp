@@ -1,6 +1,7 @@
 #include "library/scanner/libraryscanner.h"
 
 #include "sources/soundsourceproxy.h"
+#include "library/scanner/importfilestask.h"
 #include "library/scanner/recursivescandirectorytask.h"
 #include "library/scanner/libraryscannerdlg.h"
 #include "library/scanner/scannertask.h"
@@ -23,6 +24,9 @@ const int kScannerThreadPoolSize = 1;
 
 mixxx::Logger kLogger("LibraryScanner");
 
+// Identifies the changes that have been applied by the last scan
+const ConfigKey kJournalCursorConfigKey("[Library]", "ScanJournalCursor");
+
 QAtomicInt s_instanceCounter(0);
 
 // Returns the number of affected rows or -1 on error
@@ -36,27 +40,46 @@ int execCleanupQuery(FwdSqlQuery& query) {
     return query.numRowsAffected();
 }
 
+// Checks if the directory is one of the root directories or
+// any of their subdirectories
+template<typename Container>
+bool isInDirectoryTree(const QString& dirPath, const Container& rootDirPaths) {
+    for (const auto& rootDirPath : rootDirPaths) {
+        if (dirPath == rootDirPath ||
+                dirPath.startsWith(rootDirPath + QChar('/'))) {
+            return true;
+        }
+    }
+    return false;
+}
+
 } // anonymous namespace
 
 LibraryScanner::LibraryScanner(
         mixxx::DbConnectionPoolPtr pDbConnectionPool,
         const UserSettingsPointer& pConfig)
         : m_pDbConnectionPool(std::move(pDbConnectionPool)),
+          m_pConfig(pConfig),
           m_analysisDao(pConfig),
           m_trackDao(m_cueDao, m_playlistDao,
                   m_analysisDao, m_libraryHashDao,
-                  pConfig),
+                  m_searchIndexDao, pConfig),
           m_stateSema(1), // only one transaction is possible at a time
-          m_state(IDLE) {
+          m_state(IDLE),
+          m_fullScanRequested(0) {
     // Move LibraryScanner to its own thread so that our signals/slots will
     // queue to our event loop.
     moveToThread(this);
     m_pool.moveToThread(this);
+    m_importPool.moveToThread(this);
 
     const int instanceId = s_instanceCounter.fetchAndAddAcquire(1) + 1;
     setObjectName(QString("LibraryScanner %1").arg(instanceId));
 
     m_pool.setMaxThreadCount(kScannerThreadPoolSize);
+    m_importPool.setMaxThreadCount(QThread::idealThreadCount());
+
+    qRegisterMetaType<QList<NewTrackFile>>("QList<NewTrackFile>");
 
     // Listen to signals from our public methods (invoked by other threads) and
     // connect them to our slots to run the command on the scanner thread.
@@ -145,11 +168,18 @@ void LibraryScanner::run() {
         m_playlistDao.initialize(dbConnection);
         m_analysisDao.initialize(dbConnection);
         m_directoryDao.initialize(dbConnection);
+        m_searchIndexDao.initialize(dbConnection);
+
+        if (DirectoryWatcher::isSupported()) {
+            m_pDirectoryWatcher = std::make_unique<DirectoryWatcher>();
+        }
 
         // Start the event loop.
         kLogger.debug() << "Event loop starting";
         exec();
         kLogger.debug() << "Event loop stopped";
+
+        m_pDirectoryWatcher.reset();
     }
     kLogger.debug() << "Exiting thread";
 }
@@ -184,16 +214,43 @@ void LibraryScanner::slotStartScan() {
 
     emit scanStarted();
 
-    // First, we're going to mark all the directories that we've previously
-    // hashed as needing verification. As we search through the directory tree
-    // when we rescan, we'll mark any directory that does still exist as
-    // verified.
-    m_libraryHashDao.invalidateAllDirectories();
-
-    // Mark all the tracks in the library as needing verification of their
-    // existence. (ie. we want to check they're still on your hard drive where
-    // we think they are)
-    m_trackDao.invalidateTrackLocationsInLibrary();
+    QSet<QString> changedDirPaths;
+    QSet<QString> removedDirPaths;
+    const bool fullScan = m_fullScanRequested.fetchAndStoreAcquire(0) != 0;
+    const bool incremental = takeDirectoryChanges(
+            fullScan, &changedDirPaths, &removedDirPaths);
+    if (incremental) {
+        kLogger.info()
+                << "Rescanning"
+                << changedDirPaths.size()
+                << "changed and"
+                << removedDirPaths.size()
+                << "removed directories";
+        // Only the affected directories and tracks need to be verified.
+        // All others remain verified from the previous scan.
+        const QStringList changedDirPathList = changedDirPaths.values();
+        m_libraryHashDao.invalidateDirectories(changedDirPathList);
+        m_trackDao.invalidateTrackLocationsInDirectories(changedDirPathList);
+        for (const auto& dirPath : removedDirPaths) {
+            m_libraryHashDao.invalidateDirectoryTree(dirPath);
+            m_trackDao.invalidateTrackLocationsInDirectoryTree(dirPath);
+        }
+        for (const auto& dirPath : qAsConst(m_unwatchableRootDirs)) {
+            m_libraryHashDao.invalidateDirectoryTree(dirPath);
+            m_trackDao.invalidateTrackLocationsInDirectoryTree(dirPath);
+        }
+    } else {
+        // First, we're going to mark all the directories that we've previously
+        // hashed as needing verification. As we search through the directory tree
+        // when we rescan, we'll mark any directory that does still exist as
+        // verified.
+        m_libraryHashDao.invalidateAllDirectories();
+
+        // Mark all the tracks in the library as needing verification of their
+        // existence. (ie. we want to check they're still on your hard drive where
+        // we think they are)
+        m_trackDao.invalidateTrackLocationsInLibrary();
+    }
 
     kLogger.debug() << "Recursively scanning library.";
 
@@ -215,7 +272,15 @@ void LibraryScanner::slotStartScan() {
             this,
             &LibraryScanner::slotFinishHashedScan);
 
-    foreach (const QString& dirPath, m_libraryRootDirs) {
+    if (incremental) {
+        queueChangedDirectories(changedDirPaths, removedDirPaths);
+    }
+
+    // Only the unwatchable directories are scanned completely
+    // when scanning incrementally
+    const QStringList& recursiveRootDirs =
+            incremental ? m_unwatchableRootDirs : m_libraryRootDirs;
+    foreach (const QString& dirPath, recursiveRootDirs) {
         // Acquire a security bookmark for this directory if we are in a
         // sandbox. For speed we avoid opening security bookmarks when recursive
         // scanning so that relies on having an open bookmark for the containing
@@ -225,12 +290,109 @@ void LibraryScanner::slotStartScan() {
             queueTask(new RecursiveScanDirectoryTask(this, m_scannerGlobal,
                                                      dir.dir(),
                                                      dir.token(),
-                                                     false));
+                                                     false,
+                                                     true));
         }
     }
     pWatcher->taskDone();
 }
 
+bool LibraryScanner::takeDirectoryChanges(
+        bool fullScan,
+        QSet<QString>* pChangedDirPaths,
+        QSet<QString>* pRemovedDirPaths) {
+    m_pendingJournalCursor.clear();
+    m_unwatchableRootDirs.clear();
+    if (!m_pDirectoryWatcher) {
+        return false;
+    }
+    // Changes on network file systems that have been made by other
+    // hosts are not reported
+    for (const auto& dirPath : qAsConst(m_libraryRootDirs)) {
+        if (!DirectoryWatcher::isWatchable(dirPath)) {
+            kLogger.info()
+                    << "Changes in"
+                    << dirPath
+                    << "are not reported by the file system";
+            m_unwatchableRootDirs.append(dirPath);
+        }
+    }
+    if (fullScan) {
+        // All directories are watched again while scanning them
+        m_pDirectoryWatcher->reset(m_libraryRootDirs);
+        m_pendingJournalCursor = m_pDirectoryWatcher->journalCursor();
+        return false;
+    }
+    // All changes up to the persisted cursor have been applied by the
+    // last scan that finished cleanly. The cursor of a previous session
+    // never matches.
+    const bool upToDate =
+            m_pDirectoryWatcher->isComplete(m_libraryRootDirs) &&
+            m_pConfig->getValueString(kJournalCursorConfigKey) ==
+                    m_pDirectoryWatcher->journalCursor();
+    if (upToDate) {
+        m_pDirectoryWatcher->takeChanges(pChangedDirPaths, pRemovedDirPaths);
+    } else {
+        // All directories are watched again while scanning them
+        m_pDirectoryWatcher->reset(m_libraryRootDirs);
+    }
+    m_pendingJournalCursor = m_pDirectoryWatcher->journalCursor();
+    return upToDate;
+}
+
+void LibraryScanner::queueChangedDirectories(
+        const QSet<QString>& changedDirPaths,
+        const QSet<QString>& removedDirPaths) {
+    // Security bookmarks are only opened for the library directories,
+    // see slotStartScan()
+    QList<MDir> rootDirs;
+    for (const auto& dirPath : m_libraryRootDirs) {
+        rootDirs.append(MDir(dirPath));
+    }
+    const auto securityToken = [&rootDirs](const QString& dirPath) {
+        for (auto& rootDir : rootDirs) {
+            const QString rootDirPath = rootDir.dir().path();
+            if (dirPath == rootDirPath ||
+                    dirPath.startsWith(rootDirPath + QChar('/'))) {
+                return rootDir.token();
+            }
+        }
+        return SecurityTokenPointer();
+    };
+
+    // Removed directories might have been created again or replaced
+    // by another directory with the same name. The unwatchable
+    // directories are scanned completely afterwards and must not
+    // be marked as scanned before.
+    for (const auto& dirPath : removedDirPaths) {
+        const QDir dir(dirPath);
+        if (!dir.exists() ||
+                isInDirectoryTree(dirPath, m_unwatchableRootDirs) ||
+                m_scannerGlobal->testAndMarkDirectoryScanned(dir)) {
+            continue;
+        }
+        queueTask(new RecursiveScanDirectoryTask(this, m_scannerGlobal,
+                dir,
+                securityToken(dirPath),
+                false,
+                true));
+    }
+    for (const auto& dirPath : changedDirPaths) {
+        const QDir dir(dirPath);
+        if (!dir.exists() ||
+                isInDirectoryTree(dirPath, removedDirPaths) ||
+                isInDirectoryTree(dirPath, m_unwatchableRootDirs) ||
+                m_scannerGlobal->testAndMarkDirectoryScanned(dir)) {
+            continue;
+        }
+        queueTask(new RecursiveScanDirectoryTask(this, m_scannerGlobal,
+                dir,
+                securityToken(dirPath),
+                false,
+                false));
+    }
+}
+
 // is called when all tasks of the first stage are done (threads are finished)
 void LibraryScanner::slotFinishHashedScan() {
     kLogger.debug() << "slotFinishHashedScan";
@@ -266,6 +428,7 @@ void LibraryScanner::slotFinishHashedScan() {
         queueTask(new RecursiveScanDirectoryTask(this, m_scannerGlobal,
                                                  dirInfo.dir(),
                                                  dirInfo.token(),
+                                                 true,
                                                  true));
     }
     pWatcher->taskDone();
@@ -383,21 +546,27 @@ void LibraryScanner::slotFinishUnhashedScan() {
 
     if (!m_scannerGlobal->shouldCancel() && bScanFinishedCleanly) {
         kLogger.debug() << "Scan finished cleanly";
+        if (!m_pendingJournalCursor.isEmpty()) {
+            m_pConfig->setValue(kJournalCursorConfigKey, m_pendingJournalCursor);
+        }
     } else {
         kLogger.debug() << "Scan cancelled";
     }
 
     // TODO(XXX) doesn't take into account verifyRemainingTracks.
+    const mixxx::Duration elapsed = m_scannerGlobal->timerElapsed();
+    const int numNewTracks = m_scannerGlobal->addedTracks().size();
     qDebug("Scan took: %s. "
            "%d unchanged directories. "
            "%d changed/added directories. "
            "%d tracks verified from changed/added directories. "
-           "%d new tracks.",
-           m_scannerGlobal->timerElapsed().formatNanosWithUnit().toLocal8Bit().constData(),
+           "%d new tracks (%.1f files/s).",
+           elapsed.formatNanosWithUnit().toLocal8Bit().constData(),
            m_scannerGlobal->verifiedDirectories().size(),
            m_scannerGlobal->numScannedDirectories(),
            m_scannerGlobal->verifiedTracks().size(),
-           m_scannerGlobal->addedTracks().size());
+           numNewTracks,
+           elapsed.toDoubleSeconds() > 0 ? numNewTracks / elapsed.toDoubleSeconds() : 0.0);
 
     m_scannerGlobal.clear();
     changeScannerState(FINISHED);
@@ -406,8 +575,9 @@ void LibraryScanner::slotFinishUnhashedScan() {
     emit scanFinished();
 }
 
-void LibraryScanner::scan() {
+void LibraryScanner::scan(ScanMode mode) {
     if (changeScannerState(STARTING)) {
+        m_fullScanRequested.storeRelease(mode == ScanMode::Full ? 1 : 0);
         emit startScan();
     }
 }
@@ -450,6 +620,20 @@ void LibraryScanner::cancel() {
     // have pointers to the LibraryScanner and can cause a segfault if they run
     // after the LibraryScanner has been destroyed.
     m_pool.waitForDone();
+    m_importPool.waitForDone();
+}
+
+void LibraryScanner::watchDirectory(const QString& dirPath) {
+    // The watcher is created before and destroyed after running any
+    // tasks in the scanner thread
+    if (!m_pDirectoryWatcher) {
+        return;
+    }
+    // Not modified while the tasks are running
+    if (isInDirectoryTree(dirPath, m_unwatchableRootDirs)) {
+        return;
+    }
+    m_pDirectoryWatcher->watchDirectory(dirPath);
 }
 
 void LibraryScanner::queueTask(ScannerTask* pTask) {
@@ -476,9 +660,9 @@ void LibraryScanner::queueTask(ScannerTask* pTask) {
             this,
             &LibraryScanner::slotTrackExists);
     connect(pTask,
-            &ScannerTask::addNewTrack,
+            &ScannerTask::addNewTracks,
             this,
-            &LibraryScanner::slotAddNewTrack);
+            &LibraryScanner::slotAddNewTracks);
 
     // Progress signals.
     // Pass directly to the main thread
@@ -491,7 +675,11 @@ void LibraryScanner::queueTask(ScannerTask* pTask) {
             this,
             &LibraryScanner::progressHashing);
 
-    m_pool.start(pTask);
+    if (qobject_cast<ImportFilesTask*>(pTask)) {
+        m_importPool.start(pTask);
+    } else {
+        m_pool.start(pTask);
+    }
 }
 
 void LibraryScanner::slotDirectoryHashedAndScanned(const QString& directoryPath,
@@ -531,11 +719,23 @@ void LibraryScanner::slotTrackExists(const QString& trackPath) {
     }
 }
 
-void LibraryScanner::slotAddNewTrack(const QString& trackPath) {
-    //kLogger.debug() << "slotAddNewTrack" << trackPath;
-    ScopedTimer timer("LibraryScanner::addNewTrack");
+void LibraryScanner::slotAddNewTracks(const QList<NewTrackFile>& newTrackFiles) {
+    ScopedTimer timer("LibraryScanner::slotAddNewTracks");
+    for (const auto& newTrackFile : newTrackFiles) {
+        addNewTrack(newTrackFile);
+    }
+    // Allow the worker threads to parse more files
+    if (m_scannerGlobal) {
+        m_scannerGlobal->releasePendingNewTrackBatch();
+    }
+}
+
+void LibraryScanner::addNewTrack(const NewTrackFile& newTrackFile) {
+    const QString& trackPath = newTrackFile.location;
+    //kLogger.debug() << "addNewTrack" << trackPath;
     // For statistics tracking and to detect moved tracks
-    TrackPointer pTrack(m_trackDao.addTracksAddFile(trackPath, false));
+    TrackPointer pTrack(m_trackDao.addTracksAddFile(
+            trackPath, false, &newTrackFile.parsedMetadata));
     if (pTrack) {
         DEBUG_ASSERT(!pTrack->isDirty());
         // The track's actual location might differ from the
@@ -7,20 +7,24 @@
 #include <QStringList>
 #include <QSemaphore>
 #include <QScopedPointer>
+#include <memory>
 
 #include "library/dao/cuedao.h"
 #include "library/dao/libraryhashdao.h"
 #include "library/dao/directorydao.h"
 #include "library/dao/playlistdao.h"
+#include "library/dao/searchindexdao.h"
 #include "library/dao/trackdao.h"
 #include "library/dao/analysisdao.h"
+#include "library/scanner/directorywatcher.h"
 #include "library/scanner/scannerglobal.h"
+#include "library/scanner/scannertask.h"
+#include "preferences/usersettings.h"
 #include "track/track.h"
 #include "util/db/dbconnectionpool.h"
 
 #include <gtest/gtest.h>
 
-class ScannerTask;
 class LibraryScannerDlg;
 
 class LibraryScanner : public QThread {
@@ -32,10 +36,18 @@ class LibraryScanner : public QThread {
             const UserSettingsPointer& pConfig);
     ~LibraryScanner() override;
 
+    enum class ScanMode {
+        // Only rescans the directories that have changed since the
+        // last scan if these changes are known
+        Incremental,
+        // Rescans all directories, e.g. if requested by the user
+        Full,
+    };
+
   public slots:
     // Call from any thread to start a scan. Does nothing if a scan is already
     // in progress.
-    void scan();
+    void scan(ScanMode mode = ScanMode::Incremental);
 
     // Call from any thread to cancel the scan.
     void slotCancel();
@@ -57,6 +69,10 @@ class LibraryScanner : public QThread {
   protected:
     void run() override;
 
+    // Reports all subsequent changes of the directory to the next
+    // rescan. Invoked by the tasks before listing a directory.
+    void watchDirectory(const QString& dirPath);
+
   public slots:
     void queueTask(ScannerTask* pTask);
 
@@ -70,7 +86,7 @@ class LibraryScanner : public QThread {
                                    bool newDirectory, mixxx::cache_key_t hash);
     void slotDirectoryUnchanged(const QString& directoryPath);
     void slotTrackExists(const QString& trackPath);
-    void slotAddNewTrack(const QString& trackPath);
+    void slotAddNewTracks(const QList<NewTrackFile>& newTrackFiles);
 
   private:
     enum ScannerState {
@@ -96,10 +112,28 @@ class LibraryScanner : public QThread {
 
     void cleanUpScan();
 
+    // Returns true if only the directories that have changed since
+    // the last scan and the unwatchable library directories need to
+    // be rescanned
+    bool takeDirectoryChanges(
+            bool fullScan,
+            QSet<QString>* pChangedDirPaths,
+            QSet<QString>* pRemovedDirPaths);
+    void queueChangedDirectories(
+            const QSet<QString>& changedDirPaths,
+            const QSet<QString>& removedDirPaths);
+
+    void addNewTrack(const NewTrackFile& newTrackFile);
+
     mixxx::DbConnectionPoolPtr m_pDbConnectionPool;
+    UserSettingsPointer m_pConfig;
 
-    // The pool of threads used for worker tasks.
+    // The pool of threads used for worker tasks. Directories are
+    // scanned sequentially while the files of changed directories
+    // are parsed concurrently. All database access happens in the
+    // LibraryScanner thread.
     QThreadPool m_pool;
+    QThreadPool m_importPool;
 
     // The library scanner thread's DAOs.
     LibraryHashDAO m_libraryHashDao;
@@ -107,6 +141,7 @@ class LibraryScanner : public QThread {
     PlaylistDAO m_playlistDao;
     DirectoryDAO m_directoryDao;
     AnalysisDao m_analysisDao;
+    SearchIndexDAO m_searchIndexDao;
     TrackDAO m_trackDao;
 
     // Global scanner state for scan currently in progress.
@@ -121,6 +156,16 @@ class LibraryScanner : public QThread {
 
     QStringList m_libraryRootDirs;
     QScopedPointer<LibraryScannerDlg> m_pProgressDlg;
+
+    // Lives in the LibraryScanner thread. Only available on Linux.
+    std::unique_ptr<DirectoryWatcher> m_pDirectoryWatcher;
+    // Stored after the current scan has finished cleanly
+    QString m_pendingJournalCursor;
+    // Library directories on file systems that don't report all
+    // changes. Always scanned completely.
+    QStringList m_unwatchableRootDirs;
+    // Set by scan() from any thread until the scan starts
+    QAtomicInt m_fullScanRequested;
 };
 
 #endif // MIXXX_LIBRARYSCANNER_H
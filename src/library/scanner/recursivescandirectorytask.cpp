@@ -9,11 +9,13 @@
 
 RecursiveScanDirectoryTask::RecursiveScanDirectoryTask(
         LibraryScanner* pScanner, const ScannerGlobalPointer scannerGlobal,
-        const QDir& dir, SecurityTokenPointer pToken, bool scanUnhashed)
+        const QDir& dir, SecurityTokenPointer pToken, bool scanUnhashed,
+        bool recursive)
         : ScannerTask(pScanner, scannerGlobal),
           m_dir(dir),
           m_pToken(pToken),
-          m_scanUnhashed(scanUnhashed) {
+          m_scanUnhashed(scanUnhashed),
+          m_recursive(recursive) {
 }
 
 void RecursiveScanDirectoryTask::run() {
@@ -32,6 +34,9 @@ void RecursiveScanDirectoryTask::run() {
     // Filter from the QDir so we have to set it first. If the QDir has not done
     // any FS operations yet then this should be lightweight.
     m_dir.setFilter(QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot);
+    // Files that are created while listing the directory or afterwards
+    // are reported as changes and picked up by the next rescan
+    m_pScanner->watchDirectory(m_dir.path());
     QDirIterator it(m_dir);
 
     QString currentFile;
@@ -106,13 +111,20 @@ void RecursiveScanDirectoryTask::run() {
 
     // Process all of the sub-directories.
     foreach (const QDir& nextDir, dirsToScan) {
+        if (!m_recursive &&
+                mixxx::isValidCacheKey(
+                        m_scannerGlobal->directoryHashInDatabase(nextDir.path()))) {
+            // Unchanged subdirectories are still verified
+            continue;
+        }
         // Atomically test and mark the directory as scanned to avoid
         // that the same directory is scanned multiple times by different
         // tasks.
         if (!m_scannerGlobal->testAndMarkDirectoryScanned(nextDir)) {
             m_pScanner->queueTask(
                     new RecursiveScanDirectoryTask(m_pScanner, m_scannerGlobal,
-                                                   nextDir, m_pToken, m_scanUnhashed));
+                                                   nextDir, m_pToken, m_scanUnhashed,
+                                                   true));
         }
     }
     setSuccess(true);
@@ -10,6 +10,10 @@
 /// performing a hash of the directory's file list, and those hashes are stored
 /// in the database. Successful if the scan completed without being
 /// cancelled. False if the scan was cancelled part-way through.
+///
+/// A non-recursive scan only descends into new subdirectories without
+/// a hash. It is used for rescanning directories that have been reported
+/// as changed by DirectoryWatcher.
 class RecursiveScanDirectoryTask : public ScannerTask {
     Q_OBJECT
   public:
@@ -18,7 +22,8 @@ class RecursiveScanDirectoryTask : public ScannerTask {
                                const ScannerGlobalPointer scannerGlobal,
                                const QDir& dir,
                                SecurityTokenPointer pToken,
-                               bool scanUnhashed);
+                               bool scanUnhashed,
+                               bool recursive);
     virtual ~RecursiveScanDirectoryTask() {}
 
     virtual void run();
@@ -27,4 +32,5 @@ class RecursiveScanDirectoryTask : public ScannerTask {
     QDir m_dir;
     SecurityTokenPointer m_pToken;
     bool m_scanUnhashed;
+    bool m_recursive;
 };
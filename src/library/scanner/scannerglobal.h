@@ -7,6 +7,7 @@
 #include <QStringList>
 #include <QMutex>
 #include <QMutexLocker>
+#include <QSemaphore>
 #include <QSharedPointer>
 
 #include "util/cache.h"
@@ -50,9 +51,14 @@ class ScannerGlobal {
               // Unless marked un-clean, we assume it will finish cleanly.
               m_scanFinishedCleanly(true),
               m_shouldCancel(false),
+              m_pendingNewTrackBatches(kMaxPendingNewTrackBatches),
               m_numScannedDirectories(0) {
     }
 
+    // The number of new files that are parsed before handing them
+    // over to the LibraryScanner thread for adding them to the database.
+    static constexpr int kNewTrackBatchSize = 32;
+
     TaskWatcher& getTaskWatcher() {
         return m_watcher;
     }
@@ -64,7 +70,7 @@ class ScannerGlobal {
 
     // Returns the directory hash if it exists or -1 if it doesn't.
     inline mixxx::cache_key_t directoryHashInDatabase(const QString& directoryPath) const {
-        return m_directoryHashes.value(directoryPath, -1);
+        return m_directoryHashes.value(directoryPath, mixxx::invalidCacheKey());
     }
 
     inline bool directoryBlacklisted(const QString& directoryPath) const {
@@ -126,6 +132,22 @@ class ScannerGlobal {
         m_shouldCancel = true;
     }
 
+    // Blocks the calling worker thread until the LibraryScanner thread
+    // has caught up with adding the new tracks that have already been
+    // parsed. Returns false if the scan has been cancelled while waiting.
+    bool acquirePendingNewTrackBatch() {
+        while (!m_pendingNewTrackBatches.tryAcquire(1, kCancelPollIntervalMillis)) {
+            if (shouldCancel()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void releasePendingNewTrackBatch() {
+        m_pendingNewTrackBatches.release();
+    }
+
     inline bool scanFinishedCleanly() const {
         return m_scanFinishedCleanly;
     }
@@ -175,6 +197,11 @@ class ScannerGlobal {
 
 
   private:
+    // Bounds the memory for parsed metadata if parsing files is faster
+    // than adding them to the database.
+    static constexpr int kMaxPendingNewTrackBatches = 64;
+    static constexpr int kCancelPollIntervalMillis = 100;
+
     TaskWatcher m_watcher;
 
     QSet<QString> m_trackLocations;
@@ -215,6 +242,8 @@ class ScannerGlobal {
     volatile bool m_scanFinishedCleanly;
     volatile bool m_shouldCancel;
 
+    QSemaphore m_pendingNewTrackBatches;
+
     // Stats tracking.
     PerformanceTimer m_timer;
     int m_numScannedDirectories;
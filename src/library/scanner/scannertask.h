@@ -6,9 +6,16 @@
 
 #include "track/track.h"
 #include "library/scanner/scannerglobal.h"
+#include "sources/soundsourceproxy.h"
 
 class LibraryScanner;
 
+// A new file and its metadata that has been parsed by a worker thread
+struct NewTrackFile {
+    QString location;
+    ParsedTrackMetadata parsedMetadata;
+};
+
 class ScannerTask : public QObject, public QRunnable {
     Q_OBJECT
   public:
@@ -25,7 +32,7 @@ class ScannerTask : public QObject, public QRunnable {
                                    bool newDirectory, mixxx::cache_key_t hash);
     void directoryUnchanged(const QString& directoryPath);
     void trackExists(const QString& filePath);
-    void addNewTrack(const QString& filePath);
+    void addNewTracks(const QList<NewTrackFile>& newTrackFiles);
 
     // Feedback to GUI
     void progressLoading(const QString& fileName);
@@ -2,6 +2,7 @@
 
 #include <QtDebug>
 
+#include "library/dao/searchindexdao.h"
 #include "library/dao/trackschema.h"
 #include "library/queryutil.h"
 #include "library/trackset/crate/crateschema.h"
@@ -75,6 +76,21 @@ QString QueryNode::concatSqlClauses(
     }
 }
 
+bool GroupNode::bindIndexNodes(const ColumnarTrackIndex& index) {
+    m_indexNodes.clear();
+    for (const auto& pNode : m_nodes) {
+        // Nodes without an SQL condition are omitted by toSql()
+        if (pNode->toSql().isEmpty()) {
+            continue;
+        }
+        if (!pNode->bindIndex(index)) {
+            return false;
+        }
+        m_indexNodes.push_back(pNode.get());
+    }
+    return true;
+}
+
 bool AndNode::match(const TrackPointer& pTrack) const {
     for (const auto& pNode: m_nodes) {
         if (!pNode->match(pTrack)) {
@@ -98,6 +114,19 @@ QString AndNode::toSql() const {
     return concatSqlClauses(queryFragments, "AND");
 }
 
+bool AndNode::bindIndex(const ColumnarTrackIndex& index) {
+    return bindIndexNodes(index);
+}
+
+bool AndNode::matchIndex(int row) const {
+    for (const auto* pNode : m_indexNodes) {
+        if (!pNode->matchIndex(row)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 bool OrNode::match(const TrackPointer& pTrack) const {
     // An empty OR node would always evaluate to false
     // which is inconsistent with the generated SQL query!
@@ -127,6 +156,24 @@ QString OrNode::toSql() const {
     return concatSqlClauses(queryFragments, "OR");
 }
 
+bool OrNode::bindIndex(const ColumnarTrackIndex& index) {
+    return bindIndexNodes(index);
+}
+
+bool OrNode::matchIndex(int row) const {
+    // Without any condition the generated SQL query is empty
+    // and matches everything
+    if (m_indexNodes.empty()) {
+        return true;
+    }
+    for (const auto* pNode : m_indexNodes) {
+        if (pNode->matchIndex(row)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 bool NotNode::match(const TrackPointer& pTrack) const {
     return !m_pNode->match(pTrack);
 }
@@ -143,6 +190,14 @@ QString NotNode::toSql() const {
     }
 }
 
+bool NotNode::bindIndex(const ColumnarTrackIndex& index) {
+    return m_pNode->bindIndex(index);
+}
+
+bool NotNode::matchIndex(int row) const {
+    return !m_pNode->matchIndex(row);
+}
+
 TextFilterNode::TextFilterNode(const QSqlDatabase& database,
                const QStringList& sqlColumns,
                const QString& argument)
@@ -187,6 +242,50 @@ QString TextFilterNode::toSql() const {
     return concatSqlClauses(searchClauses, "OR");
 }
 
+FullTextFilterNode::FullTextFilterNode(const QSqlDatabase& database,
+        const QStringList& sqlColumns,
+        const QString& argument)
+        : TextFilterNode(database, sqlColumns, argument) {
+    DEBUG_ASSERT(SearchIndexDAO::canMatch(m_sqlColumns, m_argument));
+}
+
+QString FullTextFilterNode::toSql() const {
+    FieldEscaper escaper(m_database);
+    return QString("%1 IN (SELECT rowid FROM %2 WHERE %2 MATCH %3)")
+            .arg(LIBRARYTABLE_ID,
+                    SearchIndexDAO::kTableName,
+                    escaper.escapeString(SearchIndexDAO::formatMatchQuery(
+                            m_sqlColumns, m_argument)));
+}
+
+bool TextFilterNode::bindIndex(const ColumnarTrackIndex& index) {
+    m_indexFilters.clear();
+    for (const auto& sqlColumn : m_sqlColumns) {
+        const int column = index.columnIndex(sqlColumn);
+        if (column < 0) {
+            return false;
+        }
+        const QString& argument = m_argument;
+        m_indexFilters.push_back(index.filterStrings(
+                column,
+                true,
+                false,
+                [&argument](const QString& value) {
+                    return value.contains(argument);
+                }));
+    }
+    return true;
+}
+
+bool TextFilterNode::matchIndex(int row) const {
+    for (const auto& indexFilter : m_indexFilters) {
+        if (indexFilter.contains(row)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 bool NullOrEmptyTextFilterNode::match(const TrackPointer& pTrack) const {
     if (!m_sqlColumns.isEmpty()) {
         // only use the major column
@@ -207,6 +306,29 @@ QString NullOrEmptyTextFilterNode::toSql() const {
     return QString();
 }
 
+bool NullOrEmptyTextFilterNode::bindIndex(const ColumnarTrackIndex& index) {
+    if (m_sqlColumns.isEmpty()) {
+        return true;
+    }
+    // only use the major column
+    const int column = index.columnIndex(m_sqlColumns.first());
+    if (column < 0) {
+        return false;
+    }
+    m_indexFilter = index.filterStrings(
+            column,
+            false,
+            true,
+            [](const QString& value) {
+                return value.isEmpty();
+            });
+    return true;
+}
+
+bool NullOrEmptyTextFilterNode::matchIndex(int row) const {
+    return m_indexFilter.contains(row);
+}
+
 CrateFilterNode::CrateFilterNode(const CrateStorage* pCrateStorage,
                                  const QString& crateNameLike)
     : m_pCrateStorage(pCrateStorage),
@@ -214,7 +336,7 @@ CrateFilterNode::CrateFilterNode(const CrateStorage* pCrateStorage,
       m_matchInitialized(false) {
 }
 
-bool CrateFilterNode::match(const TrackPointer& pTrack) const {
+const std::vector<TrackId>& CrateFilterNode::matchingTrackIds() const {
     if (!m_matchInitialized) {
         CrateTrackSelectResult crateTracks(
              m_pCrateStorage->selectTracksSortedByCrateNameLike(m_crateNameLike));
@@ -225,8 +347,12 @@ bool CrateFilterNode::match(const TrackPointer& pTrack) const {
 
         m_matchInitialized = true;
     }
+    return m_matchingTrackIds;
+}
 
-    return std::binary_search(m_matchingTrackIds.begin(), m_matchingTrackIds.end(), pTrack->getId());
+bool CrateFilterNode::match(const TrackPointer& pTrack) const {
+    const auto& trackIds = matchingTrackIds();
+    return std::binary_search(trackIds.begin(), trackIds.end(), pTrack->getId());
 }
 
 QString CrateFilterNode::toSql() const {
@@ -234,13 +360,22 @@ QString CrateFilterNode::toSql() const {
             m_pCrateStorage->formatQueryForTrackIdsByCrateNameLike(m_crateNameLike));
 }
 
+bool CrateFilterNode::bindIndex(const ColumnarTrackIndex& index) {
+    m_indexFilter = index.filterTracks(matchingTrackIds());
+    return true;
+}
+
+bool CrateFilterNode::matchIndex(int row) const {
+    return m_indexFilter.contains(row);
+}
+
 
 NoCrateFilterNode::NoCrateFilterNode(const CrateStorage* pCrateStorage)
     : m_pCrateStorage(pCrateStorage),
       m_matchInitialized(false) {
 }
 
-bool NoCrateFilterNode::match(const TrackPointer& pTrack) const {
+const std::vector<TrackId>& NoCrateFilterNode::matchingTrackIds() const {
     if (!m_matchInitialized) {
         TrackSelectResult tracks(
                 m_pCrateStorage->selectAllTracksSorted());
@@ -251,8 +386,13 @@ bool NoCrateFilterNode::match(const TrackPointer& pTrack) const {
 
         m_matchInitialized = true;
     }
+    return m_matchingTrackIds;
+}
 
-    return !std::binary_search(m_matchingTrackIds.begin(), m_matchingTrackIds.end(), pTrack->getId());
+bool NoCrateFilterNode::match(const TrackPointer& pTrack) const {
+    // The ids of all tracks that are contained in any crate
+    const auto& trackIds = matchingTrackIds();
+    return !std::binary_search(trackIds.begin(), trackIds.end(), pTrack->getId());
 }
 
 QString NoCrateFilterNode::toSql() const {
@@ -261,6 +401,15 @@ QString NoCrateFilterNode::toSql() const {
             CrateStorage::formatQueryForTrackIdsWithCrate());
 }
 
+bool NoCrateFilterNode::bindIndex(const ColumnarTrackIndex& index) {
+    m_indexFilter = index.filterTracks(matchingTrackIds());
+    return true;
+}
+
+bool NoCrateFilterNode::matchIndex(int row) const {
+    return !m_indexFilter.contains(row);
+}
+
 NumericFilterNode::NumericFilterNode(const QStringList& sqlColumns)
         : m_sqlColumns(sqlColumns),
           m_bOperatorQuery(false),
@@ -324,19 +473,22 @@ bool NumericFilterNode::match(const TrackPointer& pTrack) const {
             continue;
         }
 
-        double dValue = value.toDouble();
-        if (m_bOperatorQuery) {
-            if ((m_operator == "=" && dValue == m_dOperatorArgument) ||
+        if (matchValue(value.toDouble())) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool NumericFilterNode::matchValue(double dValue) const {
+    if (m_bOperatorQuery) {
+        return (m_operator == "=" && dValue == m_dOperatorArgument) ||
                 (m_operator == "<" && dValue < m_dOperatorArgument) ||
                 (m_operator == ">" && dValue > m_dOperatorArgument) ||
                 (m_operator == "<=" && dValue <= m_dOperatorArgument) ||
-                (m_operator == ">=" && dValue >= m_dOperatorArgument)) {
-                return true;
-            }
-        } else if (m_bRangeQuery && dValue >= m_dRangeLow &&
-                   dValue <= m_dRangeHigh) {
-            return true;
-        }
+                (m_operator == ">=" && dValue >= m_dOperatorArgument);
+    } else if (m_bRangeQuery) {
+        return dValue >= m_dRangeLow && dValue <= m_dRangeHigh;
     }
     return false;
 }
@@ -375,6 +527,42 @@ QString NumericFilterNode::toSql() const {
     return QString();
 }
 
+bool NumericFilterNode::bindIndex(const ColumnarTrackIndex& index) {
+    m_indexFilters.clear();
+    for (const auto& sqlColumn : m_sqlColumns) {
+        const int column = index.columnIndex(sqlColumn);
+        if (column < 0) {
+            return false;
+        }
+        if (m_bNullQuery) {
+            m_indexFilters.push_back(index.filterNumbers(
+                    column,
+                    true,
+                    [](double) {
+                        return false;
+                    }));
+            // only use the major column
+            break;
+        }
+        m_indexFilters.push_back(index.filterNumbers(
+                column,
+                false,
+                [this](double value) {
+                    return matchValue(value);
+                }));
+    }
+    return true;
+}
+
+bool NumericFilterNode::matchIndex(int row) const {
+    for (const auto& indexFilter : m_indexFilters) {
+        if (indexFilter.contains(row)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 NullNumericFilterNode::NullNumericFilterNode(const QStringList& sqlColumns)
         : m_sqlColumns(sqlColumns) {
 }
@@ -398,6 +586,28 @@ QString NullNumericFilterNode::toSql() const {
     return QString();
 }
 
+bool NullNumericFilterNode::bindIndex(const ColumnarTrackIndex& index) {
+    if (m_sqlColumns.isEmpty()) {
+        return true;
+    }
+    // only use the major column
+    const int column = index.columnIndex(m_sqlColumns.first());
+    if (column < 0) {
+        return false;
+    }
+    m_indexFilter = index.filterNumbers(
+            column,
+            true,
+            [](double) {
+                return false;
+            });
+    return true;
+}
+
+bool NullNumericFilterNode::matchIndex(int row) const {
+    return m_indexFilter.contains(row);
+}
+
 
 DurationFilterNode::DurationFilterNode(
         const QStringList& sqlColumns, const QString& argument)
@@ -457,3 +667,24 @@ QString KeyFilterNode::toSql() const {
     }
     return concatSqlClauses(searchClauses, "OR");
 }
+
+bool KeyFilterNode::bindIndex(const ColumnarTrackIndex& index) {
+    const int column = index.columnIndex(LIBRARYTABLE_KEY_ID);
+    if (column < 0) {
+        return false;
+    }
+    const auto& matchKeys = m_matchKeys;
+    m_indexFilter = index.filterNumbers(
+            column,
+            false,
+            [&matchKeys](double value) {
+                return matchKeys.contains(
+                        static_cast<mixxx::track::io::key::ChromaticKey>(
+                                static_cast<int>(value)));
+            });
+    return true;
+}
+
+bool KeyFilterNode::matchIndex(int row) const {
+    return m_indexFilter.contains(row);
+}
@@ -9,6 +9,7 @@
 #include <utility>
 #include <vector>
 
+#include "library/columnartrackindex.h"
 #include "library/trackset/crate/cratestorage.h"
 #include "proto/keys.pb.h"
 #include "track/track.h"
@@ -27,6 +28,20 @@ class QueryNode {
     virtual bool match(const TrackPointer& pTrack) const = 0;
     virtual QString toSql() const = 0;
 
+    // Prepares the evaluation of the node on the in-memory index of
+    // BaseTrackCache. Returns false if the node cannot be evaluated in
+    // memory, e.g. an arbitrary SQL expression. After binding the node
+    // matchIndex() selects the same rows as the SQL query from toSql()
+    // and it may be invoked concurrently.
+    virtual bool bindIndex(const ColumnarTrackIndex& index) {
+        Q_UNUSED(index);
+        return false;
+    }
+    virtual bool matchIndex(int row) const {
+        Q_UNUSED(row);
+        return false;
+    }
+
   protected:
     QueryNode() {}
 
@@ -41,22 +56,31 @@ class GroupNode : public QueryNode {
     }
 
   protected:
+    // Binds all nodes that contribute a condition to the SQL query.
+    // Only those are evaluated by matchIndex().
+    bool bindIndexNodes(const ColumnarTrackIndex& index);
+
     // NOTE(uklotzde): std::vector is more suitable (efficiency)
     // than a QList for a private member. And QList from Qt 4
     // does not support std::unique_ptr yet.
     std::vector<std::unique_ptr<QueryNode>> m_nodes;
+    std::vector<const QueryNode*> m_indexNodes;
 };
 
 class OrNode : public GroupNode {
   public:
     bool match(const TrackPointer& pTrack) const override;
     QString toSql() const override;
+    bool bindIndex(const ColumnarTrackIndex& index) override;
+    bool matchIndex(int row) const override;
 };
 
 class AndNode : public GroupNode {
   public:
     bool match(const TrackPointer& pTrack) const override;
     QString toSql() const override;
+    bool bindIndex(const ColumnarTrackIndex& index) override;
+    bool matchIndex(int row) const override;
 };
 
 class NotNode : public QueryNode {
@@ -68,6 +92,8 @@ class NotNode : public QueryNode {
 
     bool match(const TrackPointer& pTrack) const override;
     QString toSql() const override;
+    bool bindIndex(const ColumnarTrackIndex& index) override;
+    bool matchIndex(int row) const override;
 
   private:
     std::unique_ptr<QueryNode> m_pNode;
@@ -81,11 +107,30 @@ class TextFilterNode : public QueryNode {
 
     bool match(const TrackPointer& pTrack) const override;
     QString toSql() const override;
+    bool bindIndex(const ColumnarTrackIndex& index) override;
+    bool matchIndex(int row) const override;
 
-  private:
+  protected:
     QSqlDatabase m_database;
     QStringList m_sqlColumns;
+    // Converted with DbConnection::makeStringLatinLow()
     QString m_argument;
+
+  private:
+    std::vector<ColumnarTrackIndex::RowFilter> m_indexFilters;
+};
+
+// Matches like TextFilterNode, but the SQL query looks up the tracks
+// in the full-text index of the library (see SearchIndexDAO) instead
+// of comparing all rows with the LIKE operator. Only valid for queries
+// on the library and if SearchIndexDAO::canMatch() is true.
+class FullTextFilterNode : public TextFilterNode {
+  public:
+    FullTextFilterNode(const QSqlDatabase& database,
+                       const QStringList& sqlColumns,
+                       const QString& argument);
+
+    QString toSql() const override;
 };
 
 class NullOrEmptyTextFilterNode : public QueryNode {
@@ -98,10 +143,13 @@ class NullOrEmptyTextFilterNode : public QueryNode {
 
     bool match(const TrackPointer& pTrack) const override;
     QString toSql() const override;
+    bool bindIndex(const ColumnarTrackIndex& index) override;
+    bool matchIndex(int row) const override;
 
   private:
     QSqlDatabase m_database;
     QStringList m_sqlColumns;
+    ColumnarTrackIndex::RowFilter m_indexFilter;
 };
 
 
@@ -112,12 +160,17 @@ class CrateFilterNode : public QueryNode {
 
     bool match(const TrackPointer& pTrack) const override;
     QString toSql() const override;
+    bool bindIndex(const ColumnarTrackIndex& index) override;
+    bool matchIndex(int row) const override;
 
   private:
+    const std::vector<TrackId>& matchingTrackIds() const;
+
     const CrateStorage* m_pCrateStorage;
     QString m_crateNameLike;
     mutable bool m_matchInitialized;
     mutable std::vector<TrackId> m_matchingTrackIds;
+    ColumnarTrackIndex::RowFilter m_indexFilter;
 };
 
 class NoCrateFilterNode : public QueryNode {
@@ -126,12 +179,17 @@ class NoCrateFilterNode : public QueryNode {
 
     bool match(const TrackPointer& pTrack) const override;
     QString toSql() const override;
+    bool bindIndex(const ColumnarTrackIndex& index) override;
+    bool matchIndex(int row) const override;
 
   private:
+    const std::vector<TrackId>& matchingTrackIds() const;
+
     const CrateStorage* m_pCrateStorage;
     QString m_crateNameLike;
     mutable bool m_matchInitialized;
     mutable std::vector<TrackId> m_matchingTrackIds;
+    ColumnarTrackIndex::RowFilter m_indexFilter;
 };
 
 class NumericFilterNode : public QueryNode {
@@ -140,6 +198,8 @@ class NumericFilterNode : public QueryNode {
 
     bool match(const TrackPointer& pTrack) const override;
     QString toSql() const override;
+    bool bindIndex(const ColumnarTrackIndex& index) override;
+    bool matchIndex(int row) const override;
 
   protected:
     // Single argument constructor for that does not call init()
@@ -154,6 +214,8 @@ class NumericFilterNode : public QueryNode {
   private:
     virtual double parse(const QString& arg, bool *ok);
 
+    bool matchValue(double value) const;
+
     QStringList m_sqlColumns;
     bool m_bOperatorQuery;
     bool m_bNullQuery;
@@ -162,6 +224,7 @@ class NumericFilterNode : public QueryNode {
     bool m_bRangeQuery;
     double m_dRangeLow;
     double m_dRangeHigh;
+    std::vector<ColumnarTrackIndex::RowFilter> m_indexFilters;
 };
 
 class NullNumericFilterNode : public QueryNode {
@@ -170,8 +233,11 @@ class NullNumericFilterNode : public QueryNode {
 
     bool match(const TrackPointer& pTrack) const override;
     QString toSql() const override;
+    bool bindIndex(const ColumnarTrackIndex& index) override;
+    bool matchIndex(int row) const override;
 
     QStringList m_sqlColumns;
+    ColumnarTrackIndex::RowFilter m_indexFilter;
 };
 
 class DurationFilterNode : public NumericFilterNode {
@@ -188,9 +254,12 @@ class KeyFilterNode : public QueryNode {
 
     bool match(const TrackPointer& pTrack) const override;
     QString toSql() const override;
+    bool bindIndex(const ColumnarTrackIndex& index) override;
+    bool matchIndex(int row) const override;
 
   private:
     QList<mixxx::track::io::key::ChromaticKey> m_matchKeys;
+    ColumnarTrackIndex::RowFilter m_indexFilter;
 };
 
 class SqlNode : public QueryNode {
@@ -1,14 +1,16 @@
 #include "library/searchqueryparser.h"
 
-#include "util/compatibility.h"
-
+#include "library/dao/searchindexdao.h"
 #include "track/keyutils.h"
+#include "util/compatibility.h"
+#include "util/db/dbconnection.h"
 
 const char* kNegatePrefix = "-";
 const char* kFuzzyPrefix = "~";
 
 SearchQueryParser::SearchQueryParser(TrackCollection* pTrackCollection)
-    : m_pTrackCollection(pTrackCollection) {
+    : m_pTrackCollection(pTrackCollection),
+      m_pSearchIndex(nullptr) {
     m_textFilters << "artist"
                   << "album_artist"
                   << "album"
@@ -115,6 +117,21 @@ QString SearchQueryParser::getTextArgument(QString argument,
     return argument;
 }
 
+std::unique_ptr<QueryNode> SearchQueryParser::makeTextFilterNode(
+        const QStringList& sqlColumns,
+        const QString& argument) const {
+    if (m_pSearchIndex && m_pSearchIndex->isSynchronized()) {
+        QString latinLowArgument = argument;
+        mixxx::DbConnection::makeStringLatinLow(&latinLowArgument);
+        if (SearchIndexDAO::canMatch(sqlColumns, latinLowArgument)) {
+            return std::make_unique<FullTextFilterNode>(
+                    m_pTrackCollection->database(), sqlColumns, argument);
+        }
+    }
+    return std::make_unique<TextFilterNode>(
+            m_pTrackCollection->database(), sqlColumns, argument);
+}
+
 void SearchQueryParser::parseTokens(QStringList tokens,
                                     QStringList searchColumns,
                                     AndNode* pQuery) const {
@@ -162,8 +179,7 @@ void SearchQueryParser::parseTokens(QStringList tokens,
                     pNode = std::make_unique<CrateFilterNode>(
                             &m_pTrackCollection->crates(), argument);
                 } else {
-                    pNode = std::make_unique<TextFilterNode>(
-                            m_pTrackCollection->database(),
+                    pNode = makeTextFilterNode(
                             m_fieldToSqlColumns[field], argument);
                 }
             }
@@ -229,13 +245,11 @@ void SearchQueryParser::parseTokens(QStringList tokens,
 
                     gNode->addNode(std::make_unique<CrateFilterNode>(
                                     &m_pTrackCollection->crates(), argument));
-                    gNode->addNode(std::make_unique<TextFilterNode>(
-                                    m_pTrackCollection->database(), queryColumns, argument));
+                    gNode->addNode(makeTextFilterNode(queryColumns, argument));
 
                     pNode = std::move(gNode);
                 } else {
-                    pNode = std::make_unique<TextFilterNode>(
-                             m_pTrackCollection->database(), queryColumns, argument);
+                    pNode = makeTextFilterNode(queryColumns, argument);
                 }
             }
         }
@@ -10,6 +10,8 @@
 #include "track/track.h"
 #include "util/class.h"
 
+class SearchIndexDAO;
+
 class SearchQueryParser {
   public:
     explicit SearchQueryParser(TrackCollection* pTrackCollection);
@@ -21,6 +23,11 @@ class SearchQueryParser {
             const QStringList& searchColumns,
             const QString& extraFilter) const;
 
+    // Text filters use the full-text index once it is synchronized. The index must
+    // outlive the parser or be reset to nullptr.
+    void setSearchIndex(const SearchIndexDAO* pSearchIndex) {
+        m_pSearchIndex = pSearchIndex;
+    }
 
   private:
     void parseTokens(QStringList tokens,
@@ -30,7 +37,12 @@ class SearchQueryParser {
     QString getTextArgument(QString argument,
                             QStringList* tokens) const;
 
+    std::unique_ptr<QueryNode> makeTextFilterNode(
+            const QStringList& sqlColumns,
+            const QString& argument) const;
+
     TrackCollection* m_pTrackCollection;
+    const SearchIndexDAO* m_pSearchIndex;
     QStringList m_textFilters;
     QStringList m_numericFilters;
     QStringList m_specialFilters;
@@ -0,0 +1,281 @@
+#include "library/selectqueryexecutor.h"
+
+#include <QMutexLocker>
+#include <QRegularExpression>
+#include <QSet>
+#include <QSqlQuery>
+#include <QSqlRecord>
+
+#include <mutex>
+
+#include "library/queryutil.h"
+#include "util/assert.h"
+#include "util/db/dbconnectionpooled.h"
+#include "util/db/dbconnectionpooler.h"
+#include "util/logger.h"
+#include "util/math.h"
+#include "util/performancetimer.h"
+
+namespace {
+
+const mixxx::Logger kLogger("SelectQueryExecutor");
+
+// The definition of a temporary view in sqlite_temp_master doesn't
+// contain the TEMP keyword.
+const QRegularExpression kCreateViewRegex(
+        QStringLiteral("^CREATE\\s+(?:TEMP\\s+|TEMPORARY\\s+)?VIEW\\s+"),
+        QRegularExpression::CaseInsensitiveOption);
+
+const QString kCreateTempView = QStringLiteral("CREATE TEMP VIEW ");
+
+std::once_flag registerMetaTypesOnceFlag;
+
+void registerMetaTypesOnce() {
+    qRegisterMetaType<SelectQueryResult>();
+}
+
+} // anonymous namespace
+
+SelectQueryExecutor::SelectQueryExecutor(
+        mixxx::DbConnectionPoolPtr pDbConnectionPool)
+        : m_pDbConnectionPool(std::move(pDbConnectionPool)),
+          m_stop(false) {
+    std::call_once(registerMetaTypesOnceFlag, registerMetaTypesOnce);
+}
+
+SelectQueryExecutor::~SelectQueryExecutor() {
+    stop();
+}
+
+void SelectQueryExecutor::submit(SelectQueryPointer pQuery) {
+    DEBUG_ASSERT(pQuery);
+    QMutexLocker locked(&m_mutex);
+    if (m_stop) {
+        return;
+    }
+    // Drop all superseded queries that are still pending
+    auto i = m_queries.begin();
+    while (i != m_queries.end()) {
+        if ((*i)->isCancelled()) {
+            i = m_queries.erase(i);
+        } else {
+            ++i;
+        }
+    }
+    m_queries.enqueue(std::move(pQuery));
+    if (!isRunning()) {
+        kLogger.debug() << "Starting thread";
+        start(QThread::LowPriority);
+    }
+    m_queryAvailable.wakeOne();
+}
+
+void SelectQueryExecutor::stop() {
+    {
+        QMutexLocker locked(&m_mutex);
+        m_stop = true;
+        for (const auto& pQuery : qAsConst(m_queries)) {
+            pQuery->cancel();
+        }
+        m_queries.clear();
+        m_queryAvailable.wakeAll();
+    }
+    wait();
+}
+
+SelectQueryPointer SelectQueryExecutor::awaitQuery() {
+    QMutexLocker locked(&m_mutex);
+    while (!m_stop && m_queries.isEmpty()) {
+        m_queryAvailable.wait(&m_mutex);
+    }
+    if (m_stop) {
+        return nullptr;
+    }
+    return m_queries.dequeue();
+}
+
+void SelectQueryExecutor::run() {
+    kLogger.debug() << "Entering thread";
+
+    // The thread-local database connection must not be closed
+    // before returning from this function.
+    const mixxx::DbConnectionPooler dbConnectionPooler(m_pDbConnectionPool);
+    const QSqlDatabase database = mixxx::DbConnectionPooled(m_pDbConnectionPool);
+    if (!database.isOpen()) {
+        kLogger.warning()
+                << "Failed to open database connection";
+    }
+
+    while (const auto pQuery = awaitQuery()) {
+        if (pQuery->isCancelled()) {
+            continue;
+        }
+        if (!database.isOpen()) {
+            // The models will fall back to synchronous queries
+            SelectQueryResult result;
+            result.pQuery = pQuery;
+            result.failed = true;
+            emit resultReady(std::move(result));
+            continue;
+        }
+        createTempViews(database, pQuery->params().tempViews);
+        execute(database, pQuery);
+    }
+
+    m_tempViews.clear();
+    kLogger.debug() << "Exiting thread";
+}
+
+void SelectQueryExecutor::createTempViews(
+        const QSqlDatabase& database,
+        const QList<QPair<QString, QString>>& tempViews) {
+    for (const auto& tempView : tempViews) {
+        const QString& name = tempView.first;
+        const QString& definition = tempView.second;
+        const auto i = m_tempViews.constFind(name);
+        if (i != m_tempViews.constEnd()) {
+            if (i.value() == definition) {
+                continue;
+            }
+            // The view has been replaced on the GUI connection
+            QSqlQuery query(database);
+            if (!query.exec(QStringLiteral("DROP VIEW IF EXISTS temp.%1").arg(name))) {
+                LOG_FAILED_QUERY(query);
+                continue;
+            }
+            m_tempViews.remove(name);
+        }
+        QString createTempView = definition;
+        createTempView.replace(kCreateViewRegex, kCreateTempView);
+        // SQLite doesn't verify the tables that are referenced by a view
+        // until it is used. Views that depend on temporary tables will
+        // cause the queries to fail.
+        QSqlQuery query(database);
+        if (!query.exec(createTempView)) {
+            LOG_FAILED_QUERY(query);
+            continue;
+        }
+        m_tempViews.insert(name, definition);
+    }
+}
+
+void SelectQueryExecutor::execute(
+        const QSqlDatabase& database,
+        const SelectQueryPointer& pQuery) {
+    const SelectQuery::Params& params = pQuery->params();
+    PerformanceTimer timer;
+    timer.start();
+
+    int batchSize = params.incremental ? kFirstBatchSize : -1;
+    SelectQueryResult result;
+    result.pQuery = pQuery;
+    const auto appendRow = [&](const SelectQueryRow& row) {
+        result.rows.append(row);
+        if (batchSize > 0 && result.rows.size() >= batchSize) {
+            emit resultReady(result);
+            result.rows.clear();
+            batchSize = math_min(batchSize * 2, kMaxBatchSize);
+        }
+    };
+    const auto fail = [&](const QSqlQuery& query) {
+        LOG_FAILED_QUERY(query);
+        result.rows.clear();
+        result.failed = true;
+        emit resultReady(result);
+    };
+
+    QSqlQuery tableQuery(database);
+    // Rows are only read once
+    tableQuery.setForwardOnly(true);
+    if (!tableQuery.prepare(params.tableQuery) || !tableQuery.exec()) {
+        fail(tableQuery);
+        return;
+    }
+    const bool hasTrackSource = !params.trackSourceQuery.isEmpty();
+    QVector<SelectQueryRow> tableRows;
+    while (tableQuery.next()) {
+        if (pQuery->isCancelled()) {
+            return;
+        }
+        const QSqlRecord sqlRecord = tableQuery.record();
+        SelectQueryRow row;
+        // The first column always contains the id
+        row.trackId = TrackId(sqlRecord.value(0));
+        row.metadata.reserve(sqlRecord.count());
+        for (int i = 0; i < sqlRecord.count(); ++i) {
+            row.metadata.push_back(sqlRecord.value(i));
+        }
+        if (hasTrackSource) {
+            tableRows.append(std::move(row));
+        } else {
+            // The table defines the order and rows can be delivered
+            // immediately
+            appendRow(row);
+        }
+    }
+
+    if (hasTrackSource) {
+        QSqlQuery trackSourceQuery(database);
+        trackSourceQuery.setForwardOnly(true);
+        if (!trackSourceQuery.prepare(params.trackSourceQuery) ||
+                !trackSourceQuery.exec()) {
+            fail(trackSourceQuery);
+            return;
+        }
+        QVector<TrackId> trackOrder;
+        while (trackSourceQuery.next()) {
+            if (pQuery->isCancelled()) {
+                return;
+            }
+            trackOrder.append(TrackId(trackSourceQuery.value(0)));
+        }
+
+        if (params.trackSourceOrdered) {
+            // Tracks that are contained multiple times, e.g. in history
+            // playlists, keep the original order of their rows
+            QHash<TrackId, QVector<int>> trackIdToRows;
+            trackIdToRows.reserve(tableRows.size());
+            for (int i = 0; i < tableRows.size(); ++i) {
+                trackIdToRows[tableRows[i].trackId].append(i);
+            }
+            for (const auto& trackId : qAsConst(trackOrder)) {
+                if (pQuery->isCancelled()) {
+                    return;
+                }
+                const auto rows = trackIdToRows.value(trackId);
+                for (int row : rows) {
+                    appendRow(tableRows[row]);
+                }
+            }
+        } else {
+            // The track source only filters the rows of the table
+            QSet<TrackId> trackIds;
+            trackIds.reserve(trackOrder.size());
+            for (const auto& trackId : qAsConst(trackOrder)) {
+                trackIds.insert(trackId);
+            }
+            for (const auto& row : qAsConst(tableRows)) {
+                if (pQuery->isCancelled()) {
+                    return;
+                }
+                if (trackIds.contains(row.trackId)) {
+                    appendRow(row);
+                }
+            }
+        }
+        result.tableRows = std::move(tableRows);
+        result.trackOrder = std::move(trackOrder);
+    }
+
+    if (pQuery->isCancelled()) {
+        return;
+    }
+    result.finished = true;
+    emit resultReady(std::move(result));
+
+    if (kLogger.debugEnabled()) {
+        kLogger.debug()
+                << "Executing query took"
+                << timer.elapsed().debugMillisWithUnit();
+    }
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QMetaType>
+#include <QMutex>
+#include <QPair>
+#include <QQueue>
+#include <QSqlDatabase>
+#include <QString>
+#include <QThread>
+#include <QVariant>
+#include <QVector>
+#include <QWaitCondition>
+
+#include <atomic>
+#include <memory>
+
+#include "track/trackid.h"
+#include "util/db/dbconnectionpool.h"
+
+/// The queries of BaseSqlTableModel::select() that are executed
+/// asynchronously by SelectQueryExecutor.
+class SelectQuery final {
+  public:
+    struct Params {
+        /// Selects the track id and all other columns of the table.
+        /// The rows are ordered by the table if no track source is
+        /// available or if the track source query is unordered.
+        QString tableQuery;
+        /// Selects the ids of all tracks that match the current search,
+        /// usually in sort order. Empty if there is no track source.
+        QString trackSourceQuery;
+        bool trackSourceOrdered = false;
+        /// Names and definitions of all temporary views of the GUI
+        /// database connection. Temporary views are private to a
+        /// connection and need to be created again before executing
+        /// the queries on a different connection.
+        QList<QPair<QString, QString>> tempViews;
+        /// Deliver the rows in multiple batches instead of all at once
+        bool incremental = false;
+    };
+
+    explicit SelectQuery(Params params)
+            : m_params(std::move(params)),
+              m_cancelled(false) {
+    }
+
+    const Params& params() const {
+        return m_params;
+    }
+
+    /// Superseded queries are cancelled by the model. Cancelled queries
+    /// are skipped or aborted as soon as possible and no further results
+    /// are delivered. Thread-safe.
+    void cancel() {
+        m_cancelled.store(true);
+    }
+    bool isCancelled() const {
+        return m_cancelled.load();
+    }
+
+  private:
+    const Params m_params;
+    std::atomic<bool> m_cancelled;
+};
+
+typedef std::shared_ptr<SelectQuery> SelectQueryPointer;
+
+struct SelectQueryRow {
+    TrackId trackId;
+    QVector<QVariant> metadata;
+};
+
+struct SelectQueryResult {
+    SelectQueryPointer pQuery;
+
+    /// Rows in their final order that follow the rows of all
+    /// previous results of the same query
+    QVector<SelectQueryRow> rows;
+
+    /// The last result of a query is either finished or failed
+    bool finished = false;
+    bool failed = false;
+
+    /// Only available for the finished result of a query with a track
+    /// source: All rows of the table in their original order and the
+    /// ids of all tracks that matched in sort order. Needed to correct
+    /// the result for modified tracks that have not been saved yet.
+    QVector<SelectQueryRow> tableRows;
+    QVector<TrackId> trackOrder;
+};
+
+Q_DECLARE_METATYPE(SelectQueryResult);
+
+/// Executes the queries of BaseSqlTableModel::select() one after another
+/// on a separate thread with its own database connection from the pool
+/// to keep the GUI responsive while searching or sorting large libraries.
+class SelectQueryExecutor : public QThread {
+    Q_OBJECT
+  public:
+    explicit SelectQueryExecutor(
+            mixxx::DbConnectionPoolPtr pDbConnectionPool);
+    ~SelectQueryExecutor() override;
+
+    /// The number of rows of the first batch that is delivered for
+    /// incremental queries. Following batches grow exponentially.
+    static constexpr int kFirstBatchSize = 256;
+    static constexpr int kMaxBatchSize = 16384;
+
+    /// Enqueues the query for execution. The thread is started
+    /// on demand.
+    void submit(SelectQueryPointer pQuery);
+
+    /// Cancels all pending queries and waits until the thread
+    /// has finished.
+    void stop();
+
+  signals:
+    /// Emitted from the worker thread and delivered to the receivers
+    /// through a queued connection.
+    void resultReady(SelectQueryResult result);
+
+  protected:
+    void run() override;
+
+  private:
+    SelectQueryPointer awaitQuery();
+
+    void createTempViews(
+            const QSqlDatabase& database,
+            const QList<QPair<QString, QString>>& tempViews);
+    void execute(
+            const QSqlDatabase& database,
+            const SelectQueryPointer& pQuery);
+
+    const mixxx::DbConnectionPoolPtr m_pDbConnectionPool;
+
+    QMutex m_mutex;
+    QWaitCondition m_queryAvailable;
+    QQueue<SelectQueryPointer> m_queries;
+    bool m_stop;
+
+    // Temporary views that have been created on the connection of the
+    // worker thread. Only accessed by the worker thread.
+    QHash<QString, QString> m_tempViews;
+};
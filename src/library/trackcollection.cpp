@@ -1,4 +1,5 @@
 #include <QApplication>
+#include <QTimer>
 
 #include "library/trackcollection.h"
 
@@ -13,6 +14,10 @@ namespace {
 
 mixxx::Logger kLogger("TrackCollection");
 
+// Each batch is reindexed within a single transaction on the
+// GUI thread
+constexpr int kSearchIndexBatchSize = 500;
+
 } // anonymous namespace
 
 TrackCollection::TrackCollection(
@@ -21,7 +26,8 @@ TrackCollection::TrackCollection(
         : QObject(parent),
           m_analysisDao(pConfig),
           m_trackDao(m_cueDao, m_playlistDao,
-                     m_analysisDao, m_libraryHashDao, pConfig) {
+                     m_analysisDao, m_libraryHashDao,
+                     m_searchIndexDao, pConfig) {
     // Forward signals from TrackDAO
     connect(&m_trackDao,
             &TrackDAO::trackClean,
@@ -81,7 +87,34 @@ void TrackCollection::connectDatabase(QSqlDatabase database) {
     m_directoryDao.initialize(database);
     m_analysisDao.initialize(database);
     m_libraryHashDao.initialize(database);
+    m_searchIndexDao.initialize(database);
     m_crates.connectDatabase(database);
+
+    // Searches fall back to the LIKE operator until the index
+    // has been synchronized after startup
+    if (m_searchIndexDao.createIndex() && !m_searchIndexDao.isSynchronized()) {
+        kLogger.info() << "Synchronizing the search index";
+        QTimer::singleShot(0, this, &TrackCollection::synchronizeSearchIndex);
+    }
+}
+
+void TrackCollection::synchronizeSearchIndex() {
+    DEBUG_ASSERT_QOBJECT_THREAD_AFFINITY(this);
+
+    if (!m_database.isOpen()) {
+        // Disconnected in the meantime
+        return;
+    }
+    if (!m_searchIndexDao.synchronizeIndex(kSearchIndexBatchSize)) {
+        kLogger.warning() << "Failed to synchronize the search index";
+        return;
+    }
+    if (m_searchIndexDao.isSynchronized()) {
+        kLogger.info() << "The search index has been synchronized";
+        return;
+    }
+    // Continue with the next batch after processing pending events
+    QTimer::singleShot(0, this, &TrackCollection::synchronizeSearchIndex);
 }
 
 void TrackCollection::disconnectDatabase() {
@@ -102,6 +135,8 @@ void TrackCollection::connectTrackSource(QSharedPointer<BaseTrackCache> pTrackSo
     }
     kLogger.info() << "Connecting track source";
     m_pTrackSource = pTrackSource;
+    // The ids of the track source are the ids of the library
+    m_pTrackSource->setSearchIndex(&m_searchIndexDao);
     connect(this,
             &TrackCollection::scanTrackAdded,
             m_pTrackSource.data(),
@@ -135,6 +170,7 @@ QWeakPointer<BaseTrackCache> TrackCollection::disconnectTrackSource() {
     if (m_pTrackSource) {
         kLogger.info() << "Disconnecting track source";
         m_trackDao.disconnect(m_pTrackSource.data());
+        m_pTrackSource->setSearchIndex(nullptr);
         m_pTrackSource.reset();
     }
     return pWeakPtr;
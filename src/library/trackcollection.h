@@ -10,6 +10,7 @@
 #include "library/dao/directorydao.h"
 #include "library/dao/libraryhashdao.h"
 #include "library/dao/playlistdao.h"
+#include "library/dao/searchindexdao.h"
 #include "library/dao/trackdao.h"
 #include "library/trackset/crate/cratestorage.h"
 #include "preferences/usersettings.h"
@@ -151,6 +152,8 @@ class TrackCollection : public QObject,
 
     void saveTrack(Track* pTrack);
 
+    void synchronizeSearchIndex();
+
     QSqlDatabase m_database;
 
     PlaylistDAO m_playlistDao;
@@ -159,6 +162,7 @@ class TrackCollection : public QObject,
     DirectoryDAO m_directoryDao;
     AnalysisDao m_analysisDao;
     LibraryHashDAO m_libraryHashDao;
+    SearchIndexDAO m_searchIndexDao;
     TrackDAO m_trackDao;
 
     QSharedPointer<BaseTrackCache> m_pTrackSource;
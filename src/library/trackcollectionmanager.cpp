@@ -2,6 +2,7 @@
 
 #include "library/externaltrackcollection.h"
 #include "library/scanner/libraryscanner.h"
+#include "library/selectqueryexecutor.h"
 #include "library/trackcollection.h"
 
 #include "sources/soundsourceproxy.h"
@@ -37,7 +38,8 @@ TrackCollectionManager::TrackCollectionManager(
         deleteTrackFn_t /*only-needed-for-testing*/ deleteTrackForTestingFn)
     : QObject(parent),
       m_pConfig(pConfig),
-      m_pInternalCollection(createInternalTrackCollection(this, pConfig, deleteTrackForTestingFn)) {
+      m_pInternalCollection(createInternalTrackCollection(this, pConfig, deleteTrackForTestingFn)),
+      m_pSelectQueryExecutor(std::make_unique<SelectQueryExecutor>(pDbConnectionPool)) {
     const QSqlDatabase dbConnection = mixxx::DbConnectionPooled(pDbConnectionPool);
 
     // TODO(XXX): Add a checkbox in the library preferences for checking
@@ -115,6 +117,9 @@ TrackCollectionManager::TrackCollectionManager(
 }
 
 TrackCollectionManager::~TrackCollectionManager() {
+    kLogger.info() << "Stopping select query executor thread";
+    m_pSelectQueryExecutor->stop();
+
     if (m_pScanner) {
         while (m_pScanner->isRunning()) {
             kLogger.info() << "Stopping library scanner thread";
@@ -154,7 +159,9 @@ TrackCollectionManager::~TrackCollectionManager() {
 
 void TrackCollectionManager::startLibraryScan() {
     DEBUG_ASSERT(m_pScanner);
-    m_pScanner->scan();
+    // Started explicitly by the user, who expects that all changes are
+    // detected, e.g. on network shares that don't report them
+    m_pScanner->scan(LibraryScanner::ScanMode::Full);
 }
 
 void TrackCollectionManager::stopLibraryScan() {
@@ -13,6 +13,7 @@
 #include "util/thread_affinity.h"
 
 class LibraryScanner;
+class SelectQueryExecutor;
 class TrackCollection;
 class ExternalTrackCollection;
 
@@ -41,6 +42,12 @@ class TrackCollectionManager: public QObject,
         return m_pInternalCollection;
     }
 
+    // Executes the queries of table models asynchronously
+    SelectQueryExecutor* selectQueryExecutor() {
+        DEBUG_ASSERT_QOBJECT_THREAD_AFFINITY(this);
+        return m_pSelectQueryExecutor.get();
+    }
+
     const QList<ExternalTrackCollection*>& externalCollections() const {
         DEBUG_ASSERT_QOBJECT_THREAD_AFFINITY(this);
         return m_externalCollections;
@@ -104,4 +111,6 @@ class TrackCollectionManager: public QObject,
 
     // TODO: Extract and decouple LibraryScanner from TrackCollectionManager
     std::unique_ptr<LibraryScanner> m_pScanner;
+
+    const std::unique_ptr<SelectQueryExecutor> m_pSelectQueryExecutor;
 };
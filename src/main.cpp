@@ -30,6 +30,7 @@
 #include "util/cmdlineargs.h"
 #include "util/console.h"
 #include "util/logging.h"
+#include "util/realtimecheck.h"
 #include "util/version.h"
 
 #ifdef Q_OS_LINUX
@@ -134,6 +135,11 @@ int main(int argc, char * argv[]) {
 
     qDebug() << "Mixxx shutdown complete with code" << result;
 
+    if (mixxx::RealtimeAudit::isEnabled()) {
+        // Only if built with the RT_AUDIT option
+        qWarning().noquote() << mixxx::RealtimeAudit::report();
+    }
+
     mixxx::Logging::shutdown();
 
     return result;
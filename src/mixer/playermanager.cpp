@@ -124,7 +124,11 @@ void PlayerManager::bindToLibrary(Library* pLibrary) {
             pLibrary,
             kNumberOfAnalyzerThreads,
             m_pConfig,
-            AnalyzerModeFlags::WithWaveform);
+            // Tracks that have been loaded into a deck are needed as soon
+            // as possible and are analyzed by all analyzers concurrently
+            static_cast<AnalyzerModeFlags>(
+                    AnalyzerModeFlags::WithWaveform |
+                    AnalyzerModeFlags::Pipelined));
 
     connect(m_pTrackAnalysisScheduler.get(), &TrackAnalysisScheduler::trackProgress,
             this, &PlayerManager::onTrackAnalysisProgress);
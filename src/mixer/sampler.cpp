@@ -1,6 +1,19 @@
 #include "mixer/sampler.h"
 
 #include "control/controlobject.h"
+#include "engine/channels/enginedeck.h"
+#include "engine/enginebuffer.h"
+
+namespace {
+
+// Samples up to this duration are decoded once and kept in memory as
+// a whole, i.e. retriggering them never needs to read or decode the
+// file again. Disabled (0) by default.
+const ConfigKey kWholeTrackCacheMaxSecondsConfigKey(
+        "[Sampler]", "WholeTrackCacheMaxSeconds");
+const double kDefaultWholeTrackCacheMaxSeconds = 0.0;
+
+} // anonymous namespace
 
 Sampler::Sampler(QObject* pParent,
         UserSettingsPointer pConfig,
@@ -19,4 +32,11 @@ Sampler::Sampler(QObject* pParent,
                   /*defaultMaster*/ true,
                   /*defaultHeadphones*/ false,
                   /*primaryDeck*/ false) {
+    const double wholeTrackCacheMaxSeconds = pConfig->getValue(
+            kWholeTrackCacheMaxSecondsConfigKey,
+            kDefaultWholeTrackCacheMaxSeconds);
+    if (wholeTrackCacheMaxSeconds > 0) {
+        getEngineDeck()->getEngineBuffer()->setWholeTrackCacheMaxDuration(
+                mixxx::Duration::fromSeconds(wholeTrackCacheMaxSeconds));
+    }
 }
@@ -38,6 +38,7 @@
 #include "util/timer.h"
 #include "util/trace.h"
 #include "util/math.h"
+#include "util/realtimecheck.h"
 #include "vinylcontrol/defs_vinylcontrol.h"
 #include "waveform/visualplayposition.h"
 
@@ -59,6 +60,7 @@ int paV19Callback(const void *inputBuffer, void *outputBuffer,
                   const PaStreamCallbackTimeInfo *timeInfo,
                   PaStreamCallbackFlags statusFlags,
                   void *soundDevice) {
+    mixxx::ScopedRealtimeSection realtimeSection;
     return ((SoundDevicePortAudio*) soundDevice)->callbackProcess(
             (SINT) framesPerBuffer, (CSAMPLE*) outputBuffer,
             (const CSAMPLE*) inputBuffer, timeInfo, statusFlags);
@@ -69,6 +71,7 @@ int paV19CallbackDrift(const void *inputBuffer, void *outputBuffer,
                        const PaStreamCallbackTimeInfo *timeInfo,
                        PaStreamCallbackFlags statusFlags,
                        void *soundDevice) {
+    mixxx::ScopedRealtimeSection realtimeSection;
     return ((SoundDevicePortAudio*) soundDevice)->callbackProcessDrift(
             (SINT) framesPerBuffer, (CSAMPLE*) outputBuffer,
             (const CSAMPLE*) inputBuffer, timeInfo, statusFlags);
@@ -79,6 +82,7 @@ int paV19CallbackClkRef(const void *inputBuffer, void *outputBuffer,
                         const PaStreamCallbackTimeInfo *timeInfo,
                         PaStreamCallbackFlags statusFlags,
                         void *soundDevice) {
+    mixxx::ScopedRealtimeSection realtimeSection;
     return ((SoundDevicePortAudio*) soundDevice)->callbackProcessClkRef(
             (SINT) framesPerBuffer, (CSAMPLE*) outputBuffer,
             (const CSAMPLE*) inputBuffer, timeInfo, statusFlags);
@@ -0,0 +1,442 @@
+#include "sources/audiosourcepcmcache.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QMutexLocker>
+
+#include <cstring>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "util/counter.h"
+#include "util/logger.h"
+#include "util/math.h"
+#include "util/sample.h"
+
+namespace mixxx {
+
+namespace {
+
+const Logger kLogger("AudioSourcePcmCache");
+
+const ConfigKey kEnabledConfigKey("[PcmCache]", "Enabled");
+const ConfigKey kMaxSizeConfigKey("[PcmCache]", "MaxSizeMB");
+
+const int kDefaultMaxSizeMB = 4096;
+
+const QString kCacheDirName = QStringLiteral("pcmcache");
+const QString kCacheFileSuffix = QStringLiteral(".pcm");
+
+// "MXPC" in little endian byte order
+constexpr quint32 kCacheFileMagic = 0x4350584d;
+// Must be incremented whenever the layout of the cache file changes
+constexpr quint32 kCacheFileVersion = 2;
+
+// The sample data starts at a page boundary after the header
+constexpr quint64 kSampleDataOffset = 4096;
+
+// The cache files are only valid on the host that created them.
+// Sample data is stored in native byte order.
+struct CacheFileHeader {
+    quint32 magic;
+    quint32 version;
+    quint32 channelCount;
+    quint32 sampleRate;
+    qint64 blockFrames;
+    qint64 frameIndexMin;
+    qint64 frameIndexMax;
+    // Written last after all sample data has been synced to disk
+    quint32 completed;
+    quint32 reserved;
+};
+static_assert(sizeof(CacheFileHeader) <= kSampleDataOffset,
+        "Cache file header overlaps sample data");
+
+CacheFileHeader cacheFileHeader(const AudioSource& audioSource, bool completed) {
+    CacheFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic = kCacheFileMagic;
+    header.version = kCacheFileVersion;
+    header.channelCount = audioSource.getSignalInfo().getChannelCount();
+    header.sampleRate = audioSource.getSignalInfo().getSampleRate();
+    header.blockFrames = AudioSourcePcmCacheProxy::kBlockFrames;
+    header.frameIndexMin = audioSource.frameIndexMin();
+    header.frameIndexMax = audioSource.frameIndexMax();
+    header.completed = completed ? 1 : 0;
+    return header;
+}
+
+SINT blockCountForFrames(SINT frameCount) {
+    return (frameCount + AudioSourcePcmCacheProxy::kBlockFrames - 1) /
+            AudioSourcePcmCacheProxy::kBlockFrames;
+}
+
+// Marks a file as recently used for LRU eviction
+void touchCacheFile(const QString& filePath) {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+    QFile file(filePath);
+    if (file.open(QIODevice::ReadWrite)) {
+        file.setFileTime(
+                QDateTime::currentDateTimeUtc(),
+                QFileDevice::FileModificationTime);
+    }
+#else
+    Q_UNUSED(filePath);
+#endif
+}
+
+bool syncToDisk(QFileDevice* pFile) {
+    if (!pFile->flush()) {
+        return false;
+    }
+#ifdef Q_OS_WIN
+    return _commit(pFile->handle()) == 0;
+#else
+    return fsync(pFile->handle()) == 0;
+#endif
+}
+
+std::shared_ptr<AudioSourcePcmCache> s_pInstance;
+
+} // anonymous namespace
+
+// static
+void AudioSourcePcmCache::initialize(const UserSettingsPointer& pConfig) {
+    std::shared_ptr<AudioSourcePcmCache> pInstance;
+    if (pConfig && pConfig->getValue(kEnabledConfigKey, false)) {
+        const int maxSizeMB = math_max(0,
+                pConfig->getValue(kMaxSizeConfigKey, kDefaultMaxSizeMB));
+        QDir cacheDir(pConfig->getSettingsPath());
+        if (cacheDir.mkpath(kCacheDirName) && cacheDir.cd(kCacheDirName)) {
+            kLogger.info()
+                    << "Enabled with"
+                    << maxSizeMB
+                    << "MiB in"
+                    << cacheDir.absolutePath();
+            pInstance = std::make_shared<AudioSourcePcmCache>(
+                    std::move(cacheDir),
+                    quint64(maxSizeMB) << 20);
+        } else {
+            kLogger.warning()
+                    << "Failed to create cache directory in"
+                    << cacheDir.absolutePath();
+        }
+    }
+    std::atomic_store(&s_pInstance, std::move(pInstance));
+}
+
+// static
+std::shared_ptr<AudioSourcePcmCache> AudioSourcePcmCache::instance() {
+    return std::atomic_load(&s_pInstance);
+}
+
+AudioSourcePcmCache::AudioSourcePcmCache(
+        QDir cacheDir,
+        quint64 maxBytes)
+        : m_cacheDir(std::move(cacheDir)),
+          m_maxBytes(maxBytes) {
+}
+
+// static
+bool AudioSourcePcmCache::isCacheableType(const QString& soundSourceType) {
+    const QString type = soundSourceType.toLower();
+    return type != QStringLiteral("wav") &&
+            type != QStringLiteral("aif") &&
+            type != QStringLiteral("aiff");
+}
+
+// static
+cache_key_t AudioSourcePcmCache::cacheKey(const TrackFile& trackFile) {
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    QString location = trackFile.canonicalLocation();
+    if (location.isEmpty()) {
+        location = trackFile.location();
+    }
+    hash.addData(location.toUtf8());
+    hash.addData(QByteArray::number(trackFile.fileSize()));
+    hash.addData(QByteArray::number(
+            trackFile.fileLastModified().toMSecsSinceEpoch()));
+    return cacheKeyFromMessageDigest(hash.result());
+}
+
+AudioSourcePointer AudioSourcePcmCache::decorate(
+        const TrackFile& trackFile,
+        AudioSourcePointer pAudioSource) {
+    DEBUG_ASSERT(pAudioSource);
+    const quint64 fileSize =
+            AudioSourcePcmCacheProxy::cacheFileSize(*pAudioSource);
+    if (fileSize > m_maxBytes) {
+        return pAudioSource;
+    }
+    const QString filePath = m_cacheDir.filePath(
+            QString::number(cacheKey(trackFile), 16) + kCacheFileSuffix);
+    QMutexLocker locked(&m_mutex);
+    if (!QFile::exists(filePath)) {
+        evictFiles(fileSize);
+    }
+    auto pProxy = AudioSourcePcmCacheProxy::create(pAudioSource, filePath);
+    if (!pProxy) {
+        kLogger.warning()
+                << "Failed to cache decoded sample data of"
+                << trackFile.location()
+                << "in"
+                << filePath;
+        return pAudioSource;
+    }
+    return pProxy;
+}
+
+void AudioSourcePcmCache::evictFiles(quint64 reservedBytes) {
+    // Sorted from the least to the most recently used file
+    const QFileInfoList fileInfos = m_cacheDir.entryInfoList(
+            QStringList{QStringLiteral("*") + kCacheFileSuffix},
+            QDir::Files,
+            QDir::Time | QDir::Reversed);
+    quint64 totalBytes = 0;
+    for (const auto& fileInfo : fileInfos) {
+        totalBytes += fileInfo.size();
+    }
+    for (const auto& fileInfo : fileInfos) {
+        if (totalBytes + reservedBytes <= m_maxBytes) {
+            break;
+        }
+        // Might fail on Windows if the file is still mapped
+        if (QFile::remove(fileInfo.filePath())) {
+            totalBytes -= fileInfo.size();
+            Counter("AudioSourcePcmCache eviction")++;
+            if (kLogger.debugEnabled()) {
+                kLogger.debug()
+                        << "Evicted"
+                        << fileInfo.filePath();
+            }
+        }
+    }
+}
+
+// static
+quint64 AudioSourcePcmCacheProxy::cacheFileSize(const AudioSource& audioSource) {
+    return kSampleDataOffset +
+            audioSource.getSignalInfo().frames2samples(audioSource.frameLength()) *
+            sizeof(CSAMPLE);
+}
+
+// static
+std::shared_ptr<AudioSourcePcmCacheProxy> AudioSourcePcmCacheProxy::create(
+        AudioSourcePointer pAudioSource,
+        const QString& cacheFilePath) {
+    DEBUG_ASSERT(pAudioSource);
+    if (pAudioSource->frameIndexRange().empty()) {
+        return nullptr;
+    }
+    auto pProxy = std::make_shared<AudioSourcePcmCacheProxy>(
+            std::move(pAudioSource),
+            cacheFilePath);
+    if (pProxy->mapCompletedFile()) {
+        touchCacheFile(cacheFilePath);
+        Counter("AudioSourcePcmCache file reused")++;
+        return pProxy;
+    }
+    if (pProxy->beginWriting()) {
+        return pProxy;
+    }
+    return nullptr;
+}
+
+AudioSourcePcmCacheProxy::AudioSourcePcmCacheProxy(
+        AudioSourcePointer pAudioSource,
+        const QString& cacheFilePath)
+        : AudioSourceProxy(std::move(pAudioSource)),
+          m_cachedFrameIndexRange(m_pAudioSource->frameIndexRange()),
+          m_cacheFilePath(cacheFilePath),
+          m_cacheFile(cacheFilePath),
+          m_pMappedData(nullptr),
+          m_pSampleData(nullptr),
+          m_hitCount(0),
+          m_completedBlockCount(0) {
+}
+
+AudioSourcePcmCacheProxy::~AudioSourcePcmCacheProxy() {
+    if (m_pMappedData) {
+        m_cacheFile.unmap(m_pMappedData);
+    }
+    // An incomplete temporary file is discarded
+}
+
+bool AudioSourcePcmCacheProxy::mapCompletedFile() {
+    DEBUG_ASSERT(!m_pMappedData);
+    if (!m_cacheFile.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const quint64 fileSize = cacheFileSize(*this);
+    const CacheFileHeader header = cacheFileHeader(*this, true);
+    CacheFileHeader existingHeader;
+    const bool valid = quint64(m_cacheFile.size()) == fileSize &&
+            m_cacheFile.read(reinterpret_cast<char*>(&existingHeader),
+                    sizeof(existingHeader)) == sizeof(existingHeader) &&
+            std::memcmp(&existingHeader, &header, sizeof(header)) == 0;
+    if (valid) {
+        // The file is never modified after it has been completed.
+        // Replacing or deleting it doesn't affect the mapping.
+        m_pMappedData = m_cacheFile.map(0, fileSize);
+    }
+    if (!m_pMappedData) {
+        m_cacheFile.close();
+        return false;
+    }
+    m_pSampleData = reinterpret_cast<const CSAMPLE*>(
+            m_pMappedData + kSampleDataOffset);
+    return true;
+}
+
+bool AudioSourcePcmCacheProxy::beginWriting() {
+    DEBUG_ASSERT(!m_pWriteFile);
+    // Written into a temporary file in the same directory that
+    // replaces the cache file atomically when committed
+    auto pWriteFile = std::make_unique<QSaveFile>(m_cacheFilePath);
+    pWriteFile->setDirectWriteFallback(false);
+    const CacheFileHeader header = cacheFileHeader(*this, false);
+    if (!pWriteFile->open(QIODevice::WriteOnly) ||
+            pWriteFile->write(reinterpret_cast<const char*>(&header),
+                    sizeof(header)) != sizeof(header)) {
+        return false;
+    }
+    m_pWriteFile = std::move(pWriteFile);
+    m_writtenFrameRanges.assign(
+            blockCountForFrames(m_cachedFrameIndexRange.length()),
+            IndexRange());
+    m_completedBlockCount = 0;
+    return true;
+}
+
+bool AudioSourcePcmCacheProxy::commitWriting() {
+    DEBUG_ASSERT(m_pWriteFile);
+    // The completed flag must not reach the disk before the data
+    const CacheFileHeader header = cacheFileHeader(*this, true);
+    if (!syncToDisk(m_pWriteFile.get()) ||
+            !m_pWriteFile->seek(0) ||
+            m_pWriteFile->write(reinterpret_cast<const char*>(&header),
+                    sizeof(header)) != sizeof(header) ||
+            !syncToDisk(m_pWriteFile.get()) ||
+            !m_pWriteFile->commit()) {
+        return false;
+    }
+    m_pWriteFile.reset();
+    m_writtenFrameRanges = std::vector<IndexRange>();
+    Counter("AudioSourcePcmCache file created")++;
+    return true;
+}
+
+void AudioSourcePcmCacheProxy::abortWriting() {
+    DEBUG_ASSERT(m_pWriteFile);
+    kLogger.warning()
+            << "Failed to write cache file"
+            << m_cacheFilePath
+            << m_pWriteFile->errorString();
+    // Discards the temporary file
+    m_pWriteFile.reset();
+    m_writtenFrameRanges = std::vector<IndexRange>();
+}
+
+IndexRange AudioSourcePcmCacheProxy::blockFrameIndexRange(SINT blockIndex) const {
+    const SINT start = m_cachedFrameIndexRange.start() + blockIndex * kBlockFrames;
+    return IndexRange::between(
+            start,
+            math_min(start + kBlockFrames, m_cachedFrameIndexRange.end()));
+}
+
+void AudioSourcePcmCacheProxy::storeCached(
+        const ReadableSampleFrames& sampleFrames) {
+    if (!m_pWriteFile) {
+        return;
+    }
+    const IndexRange frameIndexRange = sampleFrames.frameIndexRange();
+    if (frameIndexRange.empty() || sampleFrames.readableLength() == 0) {
+        return;
+    }
+    DEBUG_ASSERT(frameIndexRange.start() < frameIndexRange.end());
+    DEBUG_ASSERT(frameIndexRange <= m_cachedFrameIndexRange);
+    const SINT firstBlock = blockIndexForFrame(frameIndexRange.start());
+    const SINT lastBlock = blockIndexForFrame(frameIndexRange.end() - 1);
+    for (SINT blockIndex = firstBlock; blockIndex <= lastBlock; ++blockIndex) {
+        const IndexRange blockRange = blockFrameIndexRange(blockIndex);
+        IndexRange& writtenRange = m_writtenFrameRanges[blockIndex];
+        if (writtenRange == blockRange) {
+            continue;
+        }
+        const IndexRange newRange = intersect(blockRange, frameIndexRange);
+        if (newRange.empty()) {
+            continue;
+        }
+        if (!writtenRange.empty() &&
+                (newRange.end() < writtenRange.start() ||
+                        newRange.start() > writtenRange.end())) {
+            // Gaps within a block are not tracked
+            continue;
+        }
+        const qint64 offset = static_cast<qint64>(kSampleDataOffset) +
+                getSignalInfo().frames2samples(
+                        newRange.start() - m_cachedFrameIndexRange.start()) *
+                        sizeof(CSAMPLE);
+        const qint64 size =
+                getSignalInfo().frames2samples(newRange.length()) * sizeof(CSAMPLE);
+        const CSAMPLE* pData = sampleFrames.readableData(getSignalInfo().frames2samples(
+                newRange.start() - frameIndexRange.start()));
+        // Writing fails instead of raising a signal if the disk is full
+        if (!m_pWriteFile->seek(offset) ||
+                m_pWriteFile->write(reinterpret_cast<const char*>(pData), size) != size) {
+            abortWriting();
+            return;
+        }
+        writtenRange = writtenRange.empty() ? newRange : span(writtenRange, newRange);
+        if (writtenRange == blockRange) {
+            ++m_completedBlockCount;
+        }
+    }
+    if (m_completedBlockCount == static_cast<SINT>(m_writtenFrameRanges.size())) {
+        if (!commitWriting()) {
+            abortWriting();
+            return;
+        }
+        // Subsequent reads are served from the completed file
+        mapCompletedFile();
+    }
+}
+
+ReadableSampleFrames AudioSourcePcmCacheProxy::readSampleFramesClamped(
+        WritableSampleFrames sampleFrames) {
+    const IndexRange frameIndexRange = sampleFrames.frameIndexRange();
+    if (m_pSampleData &&
+            !frameIndexRange.empty() &&
+            sampleFrames.writableLength() > 0 &&
+            frameIndexRange.start() < frameIndexRange.end()) {
+        DEBUG_ASSERT(frameIndexRange <= m_cachedFrameIndexRange);
+        const SINT sampleCount =
+                getSignalInfo().frames2samples(frameIndexRange.length());
+        DEBUG_ASSERT(sampleCount <= sampleFrames.writableLength());
+        SampleUtil::copy(
+                sampleFrames.writableData(),
+                m_pSampleData +
+                        getSignalInfo().frames2samples(
+                                frameIndexRange.start() -
+                                m_cachedFrameIndexRange.start()),
+                sampleCount);
+        ++m_hitCount;
+        Counter("AudioSourcePcmCache hit")++;
+        return ReadableSampleFrames(
+                frameIndexRange,
+                SampleBuffer::ReadableSlice(
+                        sampleFrames.writableData(),
+                        sampleCount));
+    }
+    const auto readableSampleFrames =
+            AudioSourceProxy::readSampleFramesClamped(sampleFrames);
+    storeCached(readableSampleFrames);
+    Counter("AudioSourcePcmCache miss")++;
+    return readableSampleFrames;
+}
+
+} // namespace mixxx
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <QDir>
+#include <QFile>
+#include <QMutex>
+#include <QSaveFile>
+
+#include <memory>
+#include <vector>
+
+#include "preferences/usersettings.h"
+#include "sources/audiosourceproxy.h"
+#include "track/trackfile.h"
+#include "util/cache.h"
+
+namespace mixxx {
+
+/// Persistent cache of decoded sample data on disk.
+///
+/// Each track file is decoded into a separate cache file that is
+/// memory-mapped while the audio source is open. Cache files are only
+/// used after all sample frames have been decoded successfully. The
+/// total size of all cache files is bounded and the least recently
+/// used files are deleted when needed.
+///
+/// The cache is disabled by default and enabled explicitly with
+/// [PcmCache],Enabled. The maximum size is configured with
+/// [PcmCache],MaxSizeMB. Hit and miss statistics are published as
+/// counters (Developer Tools > Stats).
+class AudioSourcePcmCache final {
+  public:
+    /// Reads the configuration and enables or disables the cache for
+    /// all audio sources that are opened afterwards.
+    static void initialize(const UserSettingsPointer& pConfig);
+
+    /// Returns nullptr if the cache is disabled.
+    static std::shared_ptr<AudioSourcePcmCache> instance();
+
+    AudioSourcePcmCache(
+            QDir cacheDir,
+            quint64 maxBytes);
+
+    /// Decoding of uncompressed formats is cheap enough and
+    /// they don't benefit from caching.
+    static bool isCacheableType(const QString& soundSourceType);
+
+    /// Wraps the audio source that has been opened for the given file
+    /// into a decorator that reads from and writes into the cache.
+    /// Returns the undecorated audio source if caching fails.
+    AudioSourcePointer decorate(
+            const TrackFile& trackFile,
+            AudioSourcePointer pAudioSource);
+
+    /// The key depends on the location, size, and last modification
+    /// time of the file. Modified files will not hit stale entries.
+    static cache_key_t cacheKey(const TrackFile& trackFile);
+
+  private:
+    // Deletes the least recently used cache files until the total size
+    // of all remaining files plus the reserved size fits into the budget.
+    void evictFiles(quint64 reservedBytes);
+
+    const QDir m_cacheDir;
+    const quint64 m_maxBytes;
+
+    // Serializes creation and eviction of cache files
+    QMutex m_mutex;
+};
+
+/// Decorator that serves sample frames from a memory-mapped cache
+/// file and stores all sample frames that are decoded by the wrapped
+/// audio source in this file.
+///
+/// Only completed cache files are mapped into memory. Until then the
+/// decoded sample frames are written into a temporary file that is
+/// renamed into place after all blocks have been stored. Running out
+/// of disk space or concurrently recreating the same cache file in
+/// other instances only affects the temporary files.
+class AudioSourcePcmCacheProxy : public AudioSourceProxy {
+  public:
+    AudioSourcePcmCacheProxy(
+            AudioSourcePointer pAudioSource,
+            const QString& cacheFilePath);
+    ~AudioSourcePcmCacheProxy() override;
+
+    /// Number of sample frames per block. Blocks are the unit of
+    /// caching.
+    static constexpr SINT kBlockFrames = 4096;
+
+    /// Maps the completed cache file into memory or starts writing
+    /// a new one. Returns nullptr on failure.
+    static std::shared_ptr<AudioSourcePcmCacheProxy> create(
+            AudioSourcePointer pAudioSource,
+            const QString& cacheFilePath);
+
+    /// The size of a cache file for the given audio source in bytes
+    static quint64 cacheFileSize(const AudioSource& audioSource);
+
+    /// All sample frames are read from a completed cache file.
+    bool isCompleted() const {
+        return m_pSampleData != nullptr;
+    }
+
+    /// The number of reads that have been served from the cache file
+    int hitCount() const {
+        return m_hitCount;
+    }
+
+  protected:
+    ReadableSampleFrames readSampleFramesClamped(
+            WritableSampleFrames sampleFrames) override;
+
+  private:
+    SINT blockIndexForFrame(SINT frameIndex) const {
+        return (frameIndex - m_cachedFrameIndexRange.start()) / kBlockFrames;
+    }
+    IndexRange blockFrameIndexRange(SINT blockIndex) const;
+
+    // Validates the header of an existing cache file and maps it into
+    // memory.
+    bool mapCompletedFile();
+
+    bool beginWriting();
+    void storeCached(const ReadableSampleFrames& sampleFrames);
+    // Syncs the temporary file to disk, marks it as completed and
+    // renames it into place
+    bool commitWriting();
+    void abortWriting();
+
+    // The frame index range of the audio source when opened. It might
+    // be adjusted (= shortened) while reading, but the layout of the
+    // cache file is fixed.
+    const IndexRange m_cachedFrameIndexRange;
+    const QString m_cacheFilePath;
+
+    // The completed cache file, mapped read-only
+    QFile m_cacheFile;
+    uchar* m_pMappedData;
+    const CSAMPLE* m_pSampleData;
+    int m_hitCount;
+
+    // The temporary file while writing
+    std::unique_ptr<QSaveFile> m_pWriteFile;
+    // The contiguous range of sample frames per block that have been
+    // written, i.e. sequential reads of any size complete all blocks
+    std::vector<IndexRange> m_writtenFrameRanges;
+    SINT m_completedBlockCount;
+};
+
+} // namespace mixxx
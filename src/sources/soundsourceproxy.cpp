@@ -3,6 +3,7 @@
 
 #include "sources/soundsourceproxy.h"
 
+#include "sources/audiosourcepcmcache.h"
 #include "sources/audiosourcetrackproxy.h"
 
 #ifdef __MAD__
@@ -51,6 +52,39 @@ namespace {
 
 const mixxx::Logger kLogger("SoundSourceProxy");
 
+void parseMissingArtistTitleFromFileName(
+        mixxx::TrackMetadata* pTrackMetadata,
+        QDateTime* pMetadataSynchronized,
+        const TrackFile& trackFile) {
+    // Only parse artist and title if both fields are empty to avoid
+    // inconsistencies. Otherwise the file name (without extension)
+    // is used as the title and the artist is unmodified.
+    //
+    // TODO(XXX): Disable splitting of artist/title in settings, i.e.
+    // optionally don't split even if both title and artist are empty?
+    // Some users might want to import the whole file name of untagged
+    // files as the title without splitting the artist:
+    //     https://www.mixxx.org/forums/viewtopic.php?f=3&t=12838
+    // NOTE(uklotzde, 2019-09-26): Whoever needs this should simply set
+    // splitArtistTitle = false here and compile their custom version!
+    // It is not worth extending the settings and injecting them into
+    // SoundSourceProxy for just a few people.
+    const bool splitArtistTitle =
+            pTrackMetadata->getTrackInfo().getArtist().trimmed().isEmpty();
+    kLogger.info()
+            << "Parsing missing"
+            << (splitArtistTitle ? "artist/title" : "title")
+            << "from file name:"
+            << trackFile;
+    if (pTrackMetadata->refTrackInfo().parseArtistTitleFromFileName(
+                trackFile.fileName(), splitArtistTitle) &&
+            pMetadataSynchronized->isNull()) {
+        // Since this is also some kind of metadata import, we mark the
+        // track's metadata as synchronized with the time stamp of the file.
+        *pMetadataSynchronized = trackFile.fileLastModified();
+    }
+}
+
 } // anonymous namespace
 
 // static
@@ -379,33 +413,10 @@ void SoundSourceProxy::updateTrackFromSource(
             // Nothing to do if no metadata imported
             return;
         } else if (trackMetadata.getTrackInfo().getTitle().trimmed().isEmpty()) {
-            // Only parse artist and title if both fields are empty to avoid
-            // inconsistencies. Otherwise the file name (without extension)
-            // is used as the title and the artist is unmodified.
-            //
-            // TODO(XXX): Disable splitting of artist/title in settings, i.e.
-            // optionally don't split even if both title and artist are empty?
-            // Some users might want to import the whole file name of untagged
-            // files as the title without splitting the artist:
-            //     https://www.mixxx.org/forums/viewtopic.php?f=3&t=12838
-            // NOTE(uklotzde, 2019-09-26): Whoever needs this should simply set
-            // splitArtistTitle = false here and compile their custom version!
-            // It is not worth extending the settings and injecting them into
-            // SoundSourceProxy for just a few people.
-            const bool splitArtistTitle =
-                    trackMetadata.getTrackInfo().getArtist().trimmed().isEmpty();
-            const auto trackFile = m_pTrack->getFileInfo();
-            kLogger.info()
-                    << "Parsing missing"
-                    << (splitArtistTitle ? "artist/title" : "title")
-                    << "from file name:"
-                    << trackFile;
-            if (trackMetadata.refTrackInfo().parseArtistTitleFromFileName(trackFile.fileName(), splitArtistTitle) &&
-                    metadataImported.second.isNull()) {
-                // Since this is also some kind of metadata import, we mark the
-                // track's metadata as synchronized with the time stamp of the file.
-                metadataImported.second = trackFile.fileLastModified();
-            }
+            parseMissingArtistTitleFromFileName(
+                    &trackMetadata,
+                    &metadataImported.second,
+                    m_pTrack->getFileInfo());
         }
     }
 
@@ -463,6 +474,76 @@ void SoundSourceProxy::updateTrackFromSource(
     }
 }
 
+//static
+ParsedTrackMetadata SoundSourceProxy::parseNewTrackMetadata(
+        const TrackFile& trackFile,
+        CoverInfoGuesser* pCoverInfoGuesser) {
+    DEBUG_ASSERT(pCoverInfoGuesser);
+    ParsedTrackMetadata parsedMetadata;
+    const SoundSourceProxy proxy(trackFile.toUrl());
+    if (!proxy.m_pSoundSource) {
+        // The file type remains empty
+        return parsedMetadata;
+    }
+    parsedMetadata.fileType = proxy.m_pSoundSource->getType();
+
+    // Same as updateTrackFromSource() for a new track object
+    QImage coverImg;
+    auto metadataImported =
+            proxy.m_pSoundSource->importTrackMetadataAndCoverImage(
+                    &parsedMetadata.trackMetadata, &coverImg);
+    if (metadataImported.first == mixxx::MetadataSource::ImportResult::Failed) {
+        kLogger.warning()
+                << "Failed to import track metadata and embedded cover art"
+                << "from file"
+                << proxy.getUrl().toString();
+    }
+    if (metadataImported.first != mixxx::MetadataSource::ImportResult::Succeeded &&
+            parsedMetadata.trackMetadata.getTrackInfo().getTitle().trimmed().isEmpty()) {
+        parseMissingArtistTitleFromFileName(
+                &parsedMetadata.trackMetadata,
+                &metadataImported.second,
+                trackFile);
+    }
+    parsedMetadata.metadataSynchronized = metadataImported.second;
+    parsedMetadata.coverInfo = pCoverInfoGuesser->guessCoverInfo(
+            trackFile,
+            parsedMetadata.trackMetadata.getAlbumInfo().getTitle(),
+            coverImg);
+    return parsedMetadata;
+}
+
+void SoundSourceProxy::updateTrackFromParsedMetadata(
+        const ParsedTrackMetadata& parsedMetadata) {
+    DEBUG_ASSERT(m_pTrack);
+    if (parsedMetadata.fileType.isEmpty() ||
+            m_pTrack->isMetadataSynchronized()) {
+        // Unsupported file or the track object has already been
+        // imported before and must not be overwritten
+        updateTrackFromSource();
+        return;
+    }
+    if (kLogger.debugEnabled()) {
+        kLogger.debug()
+                << "Initializing track metadata and embedded cover art from parsed file"
+                << getUrl().toString();
+    }
+    m_pTrack->setType(parsedMetadata.fileType);
+    m_pTrack->importMetadata(
+            parsedMetadata.trackMetadata,
+            parsedMetadata.metadataSynchronized);
+    if (m_pTrack->getCueImportStatus() == Track::CueImportStatus::Pending) {
+        kLogger.debug()
+                << "Opening audio source to finish import of cue points";
+        const auto pAudioSource = openAudioSource();
+        Q_UNUSED(pAudioSource); // only used in debug assertion
+        DEBUG_ASSERT(!pAudioSource ||
+                m_pTrack->getCueImportStatus() == Track::CueImportStatus::Complete);
+    }
+    DEBUG_ASSERT(parsedMetadata.coverInfo.source == CoverInfo::GUESSED);
+    m_pTrack->setCoverInfo(parsedMetadata.coverInfo);
+}
+
 mixxx::MetadataSource::ImportResult SoundSourceProxy::importTrackMetadata(mixxx::TrackMetadata* pTrackMetadata) const {
     if (m_pSoundSource) {
         return m_pSoundSource->importTrackMetadataAndCoverImage(pTrackMetadata, nullptr).first;
@@ -495,6 +576,16 @@ mixxx::AudioSourcePointer SoundSourceProxy::openAudioSource(const mixxx::AudioSo
             if (m_pSoundSource->verifyReadable()) {
                 m_pAudioSource = mixxx::AudioSourceTrackProxy::create(m_pTrack, m_pSoundSource);
                 DEBUG_ASSERT(m_pAudioSource);
+                // Decoded sample data of compressed files is cached on disk
+                // for subsequent loads, seeks, and analysis (opt-in)
+                const auto pPcmCache = mixxx::AudioSourcePcmCache::instance();
+                if (pPcmCache &&
+                        mixxx::AudioSourcePcmCache::isCacheableType(
+                                m_pSoundSource->getType())) {
+                    m_pAudioSource = pPcmCache->decorate(
+                            m_pTrack->getFileInfo(),
+                            m_pAudioSource);
+                }
                 // Overwrite metadata with actual audio properties
                 if (m_pTrack) {
                     m_pTrack->updateAudioPropertiesFromStream(
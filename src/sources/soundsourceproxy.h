@@ -4,6 +4,18 @@
 
 #include "sources/soundsourceproviderregistry.h"
 
+class CoverInfoGuesser;
+
+// File type, metadata, and guessed cover art of a file that have
+// been parsed in advance without a track object.
+struct ParsedTrackMetadata {
+    // Empty if the file type is not supported
+    QString fileType;
+    mixxx::TrackMetadata trackMetadata;
+    QDateTime metadataSynchronized;
+    CoverInfoRelative coverInfo;
+};
+
 // Creates sound sources for tracks. Only intended to be used
 // in a narrow scope and not shareable between multiple threads!
 class SoundSourceProxy {
@@ -90,6 +102,21 @@ class SoundSourceProxy {
     void updateTrackFromSource(
             ImportTrackMetadataMode importTrackMetadataMode = ImportTrackMetadataMode::Default);
 
+    // Parses a file that is not referenced by any track object yet, e.g.
+    // a new file discovered by the library scanner. The file is not
+    // protected from concurrent modifications through the GlobalTrackCache
+    // like in importTemporaryTrack(). This allows to parse multiple files
+    // concurrently on worker threads.
+    static ParsedTrackMetadata parseNewTrackMetadata(
+            const TrackFile& trackFile,
+            CoverInfoGuesser* pCoverInfoGuesser);
+
+    // Initializes a new track object from metadata that has been parsed
+    // in advance. Same as updateTrackFromSource() with the default mode,
+    // but without accessing the file again.
+    void updateTrackFromParsedMetadata(
+            const ParsedTrackMetadata& parsedMetadata);
+
     // Parse only the metadata from the file without modifying
     // the referenced track.
     mixxx::MetadataSource::ImportResult importTrackMetadata(
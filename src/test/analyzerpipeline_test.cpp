@@ -0,0 +1,275 @@
+#include <benchmark/benchmark.h>
+#include <gtest/gtest.h>
+
+#include <QDir>
+#include <cmath>
+
+#include "analyzer/analyzerpipeline.h"
+#include "analyzer/constants.h"
+#include "sources/audiosourcestereoproxy.h"
+#include "sources/soundsourceproxy.h"
+#include "test/mixxxtest.h"
+#include "util/math.h"
+
+namespace {
+
+constexpr SINT kSamplesPerChunk = 4096;
+constexpr int kTotalChunks = 257;
+
+// Records all samples it receives. Optionally burns some CPU cycles
+// per sample to simulate an expensive analysis.
+class RecordingAnalyzer : public Analyzer {
+  public:
+    explicit RecordingAnalyzer(int workPerSample = 0)
+            : m_workPerSample(workPerSample),
+              m_result(0.0) {
+    }
+
+    bool initialize(TrackPointer tio, int sampleRate, int totalSamples) override {
+        Q_UNUSED(tio);
+        Q_UNUSED(sampleRate);
+        m_samples.reserve(totalSamples);
+        return true;
+    }
+
+    bool processSamples(const CSAMPLE* pIn, const int iLen) override {
+        m_samples.insert(m_samples.end(), pIn, pIn + iLen);
+        for (int i = 0; i < iLen; ++i) {
+            double value = pIn[i];
+            for (int j = 0; j < m_workPerSample; ++j) {
+                value = std::sin(value + j);
+            }
+            m_result += value;
+        }
+        return true;
+    }
+
+    void storeResults(TrackPointer tio) override {
+        Q_UNUSED(tio);
+    }
+
+    void cleanup() override {
+    }
+
+    const std::vector<CSAMPLE>& samples() const {
+        return m_samples;
+    }
+
+    double result() const {
+        return m_result;
+    }
+
+  private:
+    const int m_workPerSample;
+    std::vector<CSAMPLE> m_samples;
+    double m_result;
+};
+
+std::vector<AnalyzerWithState> createAnalyzers(
+        int analyzerCount,
+        int workPerSample,
+        int totalSamples,
+        std::vector<const RecordingAnalyzer*>* pRecorders = nullptr) {
+    std::vector<AnalyzerWithState> analyzers;
+    for (int i = 0; i < analyzerCount; ++i) {
+        auto pAnalyzer = std::make_unique<RecordingAnalyzer>(workPerSample);
+        if (pRecorders) {
+            pRecorders->push_back(pAnalyzer.get());
+        }
+        analyzers.emplace_back(std::move(pAnalyzer));
+        analyzers.back().initialize(TrackPointer(), 44100, totalSamples);
+    }
+    return analyzers;
+}
+
+// Fills the chunk with consecutive sample values and returns the
+// readable part, which is shifted and truncated for odd chunks
+// to verify that the slice and not the whole buffer is passed on.
+mixxx::SampleBuffer::ReadableSlice fillChunk(
+        mixxx::SampleBuffer* pChunk, int chunkIndex, CSAMPLE* pNextValue) {
+    const SINT offset = (chunkIndex % 2) * 2;
+    const SINT length = pChunk->size() - offset - (chunkIndex % 2) * 16;
+    for (SINT i = 0; i < length; ++i) {
+        *pChunk->data(offset + i) = (*pNextValue)++;
+    }
+    return mixxx::SampleBuffer::ReadableSlice(pChunk->data(offset), length);
+}
+
+void publishChunks(AnalyzerPipeline* pPipeline, int chunkCount, CSAMPLE* pNextValue) {
+    for (int chunkIndex = 0; chunkIndex < chunkCount; ++chunkIndex) {
+        auto& chunk = pPipeline->acquireChunk();
+        pPipeline->publishChunk(fillChunk(&chunk, chunkIndex, pNextValue));
+    }
+}
+
+void expectAllSamples(
+        const std::vector<const RecordingAnalyzer*>& recorders,
+        CSAMPLE sampleCount) {
+    for (const auto* pRecorder : recorders) {
+        const auto& samples = pRecorder->samples();
+        ASSERT_EQ(static_cast<std::size_t>(sampleCount), samples.size());
+        for (std::size_t i = 0; i < samples.size(); ++i) {
+            ASSERT_EQ(static_cast<CSAMPLE>(i), samples[i]);
+        }
+    }
+}
+
+void finishAnalyzers(std::vector<AnalyzerWithState>* pAnalyzers) {
+    for (auto&& analyzer : *pAnalyzers) {
+        analyzer.finish(TrackPointer());
+    }
+}
+
+class AnalyzerPipelineTest : public MixxxTest {
+};
+
+TEST_F(AnalyzerPipelineTest, AllChunksInOrder) {
+    std::vector<const RecordingAnalyzer*> recorders;
+    auto analyzers = createAnalyzers(
+            4, 0, kSamplesPerChunk * kTotalChunks, &recorders);
+    CSAMPLE nextValue = 0;
+    {
+        // Use a small ring to exercise the backpressure
+        AnalyzerPipeline pipeline(kSamplesPerChunk, 3);
+        ASSERT_EQ(4, pipeline.start(&analyzers));
+        publishChunks(&pipeline, kTotalChunks, &nextValue);
+        pipeline.drain();
+    }
+    expectAllSamples(recorders, nextValue);
+    finishAnalyzers(&analyzers);
+}
+
+TEST_F(AnalyzerPipelineTest, SkipsInactiveAnalyzers) {
+    auto analyzers = createAnalyzers(2, 0, kSamplesPerChunk);
+    analyzers.emplace_back(std::make_unique<RecordingAnalyzer>());
+    AnalyzerPipeline pipeline(kSamplesPerChunk);
+    EXPECT_EQ(2, pipeline.start(&analyzers));
+    EXPECT_EQ(2, pipeline.workerCount());
+    pipeline.drain();
+    finishAnalyzers(&analyzers);
+}
+
+TEST_F(AnalyzerPipelineTest, ReusesWorkersForNextTrack) {
+    AnalyzerPipeline pipeline(kSamplesPerChunk, 3);
+    for (int analyzerCount = 3; analyzerCount > 0; --analyzerCount) {
+        std::vector<const RecordingAnalyzer*> recorders;
+        auto analyzers = createAnalyzers(
+                analyzerCount, 0, kSamplesPerChunk * kTotalChunks, &recorders);
+        CSAMPLE nextValue = 0;
+        ASSERT_EQ(analyzerCount, pipeline.start(&analyzers));
+        publishChunks(&pipeline, kTotalChunks, &nextValue);
+        pipeline.drain();
+        // No additional threads for subsequent tracks
+        EXPECT_EQ(3, pipeline.workerCount());
+        expectAllSamples(recorders, nextValue);
+        finishAnalyzers(&analyzers);
+    }
+}
+
+TEST_F(AnalyzerPipelineTest, AbortWhileDecoding) {
+    AnalyzerPipeline pipeline(kSamplesPerChunk, 2);
+    {
+        std::vector<const RecordingAnalyzer*> recorders;
+        auto analyzers = createAnalyzers(
+                3, 16, kSamplesPerChunk * kTotalChunks, &recorders);
+        CSAMPLE nextValue = 0;
+        pipeline.start(&analyzers);
+        publishChunks(&pipeline, kTotalChunks / 2, &nextValue);
+        // Returns without processing the pending chunks
+        pipeline.abort();
+        for (const auto* pRecorder : recorders) {
+            const auto& samples = pRecorder->samples();
+            EXPECT_LE(samples.size(), static_cast<std::size_t>(nextValue));
+        }
+        // The analyzers are no longer accessed by the workers
+        finishAnalyzers(&analyzers);
+    }
+    // The pipeline is still usable for the next track
+    std::vector<const RecordingAnalyzer*> recorders;
+    auto analyzers = createAnalyzers(
+            3, 0, kSamplesPerChunk * kTotalChunks, &recorders);
+    CSAMPLE nextValue = 0;
+    ASSERT_EQ(3, pipeline.start(&analyzers));
+    publishChunks(&pipeline, kTotalChunks, &nextValue);
+    pipeline.drain();
+    expectAllSamples(recorders, nextValue);
+    finishAnalyzers(&analyzers);
+}
+
+// Compares the serial processing of all analyzers with the pipelined
+// processing while decoding a track like AnalyzerThread. The analyzers
+// have different costs like the waveform, beats, key and ReplayGain
+// analyzers.
+static void BM_AnalyzeTrack(benchmark::State& state) {
+    const bool pipelined = state.range(0) != 0;
+    const int analyzerCount = 4;
+    // The longest audio file among the test data
+    const TrackPointer pTrack = Track::newTemporary(
+            TrackFile(QDir::current().absoluteFilePath("src/test/sine-30.wav")));
+    mixxx::AudioSource::OpenParams openParams;
+    openParams.setChannelCount(mixxx::kAnalysisChannels);
+    if (!SoundSourceProxy(pTrack).openAudioSource(openParams)) {
+        state.SkipWithError("Failed to open test file");
+        return;
+    }
+    // Like in AnalyzerThread the worker threads are reused for all tracks
+    AnalyzerPipeline pipeline(mixxx::kAnalysisSamplesPerChunk);
+    mixxx::SampleBuffer sampleBuffer(mixxx::kAnalysisSamplesPerChunk);
+    SINT totalFrames = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        const auto pAudioSource =
+                SoundSourceProxy(pTrack).openAudioSource(openParams);
+        DEBUG_ASSERT(pAudioSource);
+        mixxx::AudioSourceStereoProxy audioSourceProxy(
+                pAudioSource,
+                mixxx::kAnalysisFramesPerChunk);
+        std::vector<AnalyzerWithState> analyzers;
+        for (int i = 0; i < analyzerCount; ++i) {
+            analyzers.emplace_back(
+                    std::make_unique<RecordingAnalyzer>(1 << i));
+            analyzers.back().initialize(
+                    pTrack,
+                    pAudioSource->getSignalInfo().getSampleRate(),
+                    pAudioSource->frameLength() * mixxx::kAnalysisChannels);
+        }
+        state.ResumeTiming();
+        if (pipelined) {
+            pipeline.start(&analyzers);
+        }
+        mixxx::IndexRange remainingFrameRange = audioSourceProxy.frameIndexRange();
+        while (!remainingFrameRange.empty()) {
+            const auto chunkFrameRange =
+                    remainingFrameRange.splitAndShrinkFront(
+                            math_min(mixxx::kAnalysisFramesPerChunk,
+                                    remainingFrameRange.length()));
+            mixxx::SampleBuffer& chunk =
+                    pipelined ? pipeline.acquireChunk() : sampleBuffer;
+            const auto readableSampleFrames =
+                    audioSourceProxy.readSampleFrames(
+                            mixxx::WritableSampleFrames(
+                                    chunkFrameRange,
+                                    mixxx::SampleBuffer::WritableSlice(chunk)));
+            totalFrames += readableSampleFrames.frameLength();
+            if (pipelined) {
+                pipeline.publishChunk(readableSampleFrames.readableSlice());
+            } else {
+                for (auto&& analyzer : analyzers) {
+                    analyzer.processSamples(
+                            readableSampleFrames.readableData(),
+                            readableSampleFrames.readableLength());
+                }
+            }
+        }
+        if (pipelined) {
+            pipeline.drain();
+        }
+        state.PauseTiming();
+        finishAnalyzers(&analyzers);
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(totalFrames);
+}
+BENCHMARK(BM_AnalyzeTrack)->Arg(0)->Arg(1)->UseRealTime();
+
+} // namespace
@@ -0,0 +1,320 @@
+#include <benchmark/benchmark.h>
+#include <gtest/gtest.h>
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QThread>
+
+#include "library/basetrackcache.h"
+#include "library/dao/trackschema.h"
+#include "library/librarytablemodel.h"
+#include "library/queryutil.h"
+#include "test/librarytest.h"
+#include "util/db/dbconnection.h"
+
+namespace {
+
+const QString kTrackSourceTable = QStringLiteral("library_cache_view");
+
+const QStringList kTrackSourceColumns = {
+        LIBRARYTABLE_ID,
+        LIBRARYTABLE_ARTIST,
+        LIBRARYTABLE_TITLE,
+        LIBRARYTABLE_ALBUM,
+        LIBRARYTABLE_GENRE,
+        LIBRARYTABLE_COMMENT,
+        LIBRARYTABLE_BPM,
+        LIBRARYTABLE_DURATION,
+        TRACKLOCATIONSTABLE_LOCATION,
+        TRACKLOCATIONSTABLE_FSDELETED,
+};
+
+constexpr int kArtistCount = 10;
+
+class BaseSqlTableModelTest : public LibraryTest {
+  protected:
+    BaseSqlTableModelTest() {
+        // Like MixxxLibraryFeature with fewer columns
+        QSqlQuery query(dbConnection());
+        query.prepare(QString(
+                "CREATE TEMPORARY VIEW IF NOT EXISTS %1 AS "
+                "SELECT library.id,library.artist,library.title,library.album,"
+                "library.genre,library.comment,library.bpm,library.duration,"
+                "track_locations.location,track_locations.fs_deleted "
+                "FROM library INNER JOIN track_locations "
+                "ON library.location = track_locations.id")
+                              .arg(kTrackSourceTable));
+        if (!query.exec()) {
+            LOG_FAILED_QUERY(query);
+        }
+        m_pTrackSource = QSharedPointer<BaseTrackCache>(new BaseTrackCache(
+                internalCollection(),
+                kTrackSourceTable,
+                LIBRARYTABLE_ID,
+                kTrackSourceColumns,
+                true));
+        internalCollection()->connectTrackSource(m_pTrackSource);
+    }
+
+    ~BaseSqlTableModelTest() override {
+        internalCollection()->disconnectTrackSource();
+    }
+
+  public:
+    // Also used by the benchmarks
+    void addTracks(int count) {
+        ScopedTransaction transaction(dbConnection());
+        QSqlQuery locationQuery(dbConnection());
+        locationQuery.prepare(
+                "INSERT INTO track_locations "
+                "(id,location,directory,filename,filesize,fs_deleted,needs_verification) "
+                "VALUES (:id,:location,'/music',:filename,1000000,0,0)");
+        QSqlQuery libraryQuery(dbConnection());
+        libraryQuery.prepare(
+                "INSERT INTO library "
+                "(id,location,artist,title,album,genre,bpm,duration,mixxx_deleted) "
+                "VALUES (:id,:id,:artist,:title,:album,'Genre',:bpm,180,0)");
+        for (int i = 1; i <= count; ++i) {
+            const QString filename = QString("track%1.mp3").arg(i);
+            locationQuery.bindValue(":id", i);
+            locationQuery.bindValue(":location", "/music/" + filename);
+            locationQuery.bindValue(":filename", filename);
+            if (!locationQuery.exec()) {
+                LOG_FAILED_QUERY(locationQuery);
+            }
+            libraryQuery.bindValue(":id", i);
+            // Artist names are single search tokens
+            libraryQuery.bindValue(":artist",
+                    QString("artist") + QChar('a' + i % kArtistCount));
+            // Titles are unique and sorted in reverse order of the ids
+            libraryQuery.bindValue(":title", QString("Title %1").arg(count - i, 8, 10, QChar('0')));
+            libraryQuery.bindValue(":album", QString("Album %1").arg(i % 997));
+            libraryQuery.bindValue(":bpm", 80 + i % 100);
+            if (!libraryQuery.exec()) {
+                LOG_FAILED_QUERY(libraryQuery);
+            }
+        }
+        transaction.commit();
+    }
+
+    std::unique_ptr<LibraryTableModel> newModel() {
+        return std::make_unique<LibraryTableModel>(
+                nullptr, trackCollections(), "mixxx.db.model.library");
+    }
+
+    static QList<TrackId> trackIds(const BaseSqlTableModel& model) {
+        QList<TrackId> trackIds;
+        for (int row = 0; row < model.rowCount(); ++row) {
+            trackIds.append(model.getTrackId(model.index(row, 0)));
+        }
+        return trackIds;
+    }
+
+    QVariantList trackSourceValues(
+            const QList<TrackId>& trackIds, int column) const {
+        QVariantList values;
+        for (const auto& trackId : trackIds) {
+            values.append(m_pTrackSource->data(trackId, column));
+        }
+        return values;
+    }
+
+    static bool awaitSelect(BaseSqlTableModel* pModel) {
+        QElapsedTimer timer;
+        timer.start();
+        while (pModel->hasPendingSelect()) {
+            if (timer.elapsed() > 10000) {
+                return false;
+            }
+            QCoreApplication::processEvents();
+            QThread::yieldCurrentThread();
+        }
+        return true;
+    }
+
+  protected:
+    QSharedPointer<BaseTrackCache> m_pTrackSource;
+};
+
+TEST_F(BaseSqlTableModelTest, AsyncSearchMatchesSyncSearch) {
+    // Multiple batches
+    addTracks(4 * SelectQueryExecutor::kFirstBatchSize);
+
+    auto pSyncModel = newModel();
+    pSyncModel->setSort(pSyncModel->fieldIndex(LIBRARYTABLE_TITLE), Qt::AscendingOrder);
+    pSyncModel->setSearch("artistd");
+    pSyncModel->select();
+    const auto expectedTrackIds = trackIds(*pSyncModel);
+    ASSERT_EQ(4 * SelectQueryExecutor::kFirstBatchSize / kArtistCount,
+            expectedTrackIds.size());
+
+    auto pAsyncModel = newModel();
+    pAsyncModel->setSort(pAsyncModel->fieldIndex(LIBRARYTABLE_TITLE), Qt::AscendingOrder);
+    pAsyncModel->search("artistd");
+    ASSERT_TRUE(awaitSelect(pAsyncModel.get()));
+    EXPECT_EQ(expectedTrackIds, trackIds(*pAsyncModel));
+}
+
+TEST_F(BaseSqlTableModelTest, IndexSearchMatchesSqlSearch) {
+    addTracks(1000);
+
+    const QStringList searches = {
+            "artistd",
+            "-artistd",
+            "artistd | artiste",
+            "bpm:>150",
+            "bpm:90-100",
+            "-bpm:90-100 title",
+            "album:\"Album 1\"",
+    };
+    for (const auto& search : searches) {
+        for (const auto& sortColumn : QStringList{LIBRARYTABLE_BPM, LIBRARYTABLE_ALBUM}) {
+            const int column = m_pTrackSource->fieldIndex(sortColumn);
+            // The database filters and sorts the tracks like the
+            // track source did before the index has been introduced
+            const QString sqlQueryString = m_pTrackSource->filterAndSortQuery(
+                    QString("SELECT %1 FROM %2").arg(LIBRARYTABLE_ID, LIBRARY_TABLE),
+                    search,
+                    QString(),
+                    QString("ORDER BY %1 DESC")
+                            .arg(mixxx::DbConnection::collateLexicographically(
+                                    m_pTrackSource->columnSortForFieldIndex(column))));
+            QSqlQuery sqlQuery(dbConnection());
+            ASSERT_TRUE(sqlQuery.exec(sqlQueryString)) << sqlQueryString.toStdString();
+            QList<TrackId> expectedTrackIds;
+            while (sqlQuery.next()) {
+                expectedTrackIds.append(TrackId(sqlQuery.value(0)));
+            }
+
+            // Both synchronous and asynchronous selects filter and sort
+            // the index of the track source in memory
+            auto pSyncModel = newModel();
+            pSyncModel->setSort(pSyncModel->fieldIndex(sortColumn), Qt::DescendingOrder);
+            pSyncModel->setSearch(search);
+            pSyncModel->select();
+            auto pAsyncModel = newModel();
+            pAsyncModel->setSort(pAsyncModel->fieldIndex(sortColumn), Qt::DescendingOrder);
+            pAsyncModel->search(search);
+            ASSERT_TRUE(awaitSelect(pAsyncModel.get()));
+
+            for (const auto* pModel : {pSyncModel.get(), pAsyncModel.get()}) {
+                // The order of tracks with equal values is not defined
+                // for the database
+                auto actualTrackIds = trackIds(*pModel);
+                EXPECT_EQ(trackSourceValues(expectedTrackIds, column),
+                        trackSourceValues(actualTrackIds, column))
+                        << search.toStdString() << " sorted by "
+                        << sortColumn.toStdString();
+                auto sortedExpectedTrackIds = expectedTrackIds;
+                std::sort(sortedExpectedTrackIds.begin(), sortedExpectedTrackIds.end());
+                std::sort(actualTrackIds.begin(), actualTrackIds.end());
+                EXPECT_EQ(sortedExpectedTrackIds, actualTrackIds)
+                        << search.toStdString();
+            }
+        }
+    }
+}
+
+TEST_F(BaseSqlTableModelTest, PreviousRowsRemainUntilFirstResult) {
+    addTracks(100);
+
+    auto pModel = newModel();
+    pModel->select();
+    ASSERT_EQ(100, pModel->rowCount());
+
+    pModel->search("artistd");
+    EXPECT_TRUE(pModel->hasPendingSelect());
+    EXPECT_EQ(100, pModel->rowCount());
+
+    ASSERT_TRUE(awaitSelect(pModel.get()));
+    EXPECT_EQ(100 / kArtistCount, pModel->rowCount());
+}
+
+TEST_F(BaseSqlTableModelTest, SupersededSearchIsCancelled) {
+    addTracks(1000);
+
+    auto pModel = newModel();
+    pModel->search("artistb");
+    pModel->search("artistc");
+    // Matches only a single title of the fixture
+    pModel->search("Title 00000999");
+    ASSERT_TRUE(awaitSelect(pModel.get()));
+
+    ASSERT_EQ(1, pModel->rowCount());
+    // Titles are sorted in reverse order of the ids
+    EXPECT_EQ(1, pModel->getTrackId(pModel->index(0, 0)).toVariant().toInt());
+}
+
+TEST_F(BaseSqlTableModelTest, AsyncSortMovesSelectedRows) {
+    addTracks(100);
+
+    auto pModel = newModel();
+    pModel->setSort(pModel->fieldIndex(LIBRARYTABLE_TITLE), Qt::AscendingOrder);
+    pModel->select();
+    // Titles are sorted in reverse order of the ids
+    const QPersistentModelIndex firstRow = pModel->index(0, 0);
+    const TrackId firstTrackId = pModel->getTrackId(firstRow);
+    ASSERT_EQ(100, firstTrackId.toVariant().toInt());
+
+    pModel->sort(pModel->fieldIndex(LIBRARYTABLE_TITLE), Qt::DescendingOrder);
+    ASSERT_TRUE(awaitSelect(pModel.get()));
+
+    ASSERT_EQ(100, pModel->rowCount());
+    EXPECT_EQ(99, firstRow.row());
+    EXPECT_EQ(firstTrackId, pModel->getTrackId(firstRow));
+    EXPECT_EQ(1, pModel->getTrackId(pModel->index(0, 0)).toVariant().toInt());
+}
+
+// Searches a synthetic library with 200k tracks like typing into the
+// search box. Measures the time until the first rows are visible and
+// the time until all rows have been selected.
+static void BM_BaseSqlTableModelSearch(benchmark::State& state) {
+    const bool async = state.range(0) != 0;
+    MixxxTestFixture<BaseSqlTableModelTest> library;
+    library.addTracks(200000);
+    auto pModel = library.newModel();
+    pModel->setSort(pModel->fieldIndex(LIBRARYTABLE_ARTIST), Qt::AscendingOrder);
+    // Build the index of the track source
+    pModel->select();
+
+    QElapsedTimer timer;
+    qint64 firstRowsNanos = -1;
+    QObject::connect(pModel.get(),
+            &QAbstractItemModel::rowsInserted,
+            [&timer, &firstRowsNanos] {
+                if (firstRowsNanos < 0) {
+                    firstRowsNanos = timer.nsecsElapsed();
+                }
+            });
+
+    double firstRowsMillis = 0.0;
+    double totalMillis = 0.0;
+    const QStringList searches = {"artist", "Album 1", "artistd"};
+    int iteration = 0;
+    for (auto _ : state) {
+        const QString search = searches[iteration++ % searches.size()];
+        firstRowsNanos = -1;
+        timer.start();
+        if (async) {
+            pModel->search(search);
+            library.awaitSelect(pModel.get());
+        } else {
+            pModel->setSearch(search);
+            pModel->select();
+        }
+        const qint64 totalNanos = timer.nsecsElapsed();
+        totalMillis += totalNanos / 1e6;
+        firstRowsMillis += (firstRowsNanos < 0 ? totalNanos : firstRowsNanos) / 1e6;
+    }
+    state.counters["first_rows_ms"] = benchmark::Counter(
+            firstRowsMillis, benchmark::Counter::kAvgIterations);
+    state.counters["total_ms"] = benchmark::Counter(
+            totalMillis, benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_BaseSqlTableModelSearch)
+        ->Arg(0)
+        ->Arg(1)
+        ->Unit(benchmark::kMillisecond)
+        ->UseRealTime();
+
+} // anonymous namespace
@@ -1,6 +1,11 @@
+#include <benchmark/benchmark.h>
 #include <gtest/gtest.h>
+
+#include <QThread>
 #include <QtDebug>
 
+#include <atomic>
+
 #include "track/beatmap.h"
 #include "util/memory.h"
 
@@ -8,6 +13,52 @@ using namespace mixxx;
 
 namespace {
 
+// Mimics the lookups of BpmControl and QuantizeControl on the engine thread
+class BeatLookupThread : public QThread {
+  public:
+    BeatLookupThread(const Beats& beats, double maxSample)
+            : m_beats(beats),
+              m_maxSample(maxSample),
+              m_stop(false),
+              m_lookupCount(0) {
+    }
+
+    void stop() {
+        m_stop.store(true);
+    }
+
+    int lookupCount() const {
+        return m_lookupCount.load();
+    }
+
+    void run() override {
+        double position = 0;
+        while (!m_stop.load()) {
+            position += 1001;
+            if (position > m_maxSample) {
+                position = 0;
+            }
+            const double nextBeat = m_beats.findNthBeat(position, 1);
+            if (nextBeat != -1) {
+                // Beats are always located at the start of a frame
+                ASSERT_EQ(0, static_cast<qint64>(nextBeat) % 2);
+            }
+            double prevBeat;
+            double nextBeat2;
+            if (m_beats.findPrevNextBeats(position, &prevBeat, &nextBeat2)) {
+                ASSERT_LT(prevBeat, nextBeat2);
+            }
+            ++m_lookupCount;
+        }
+    }
+
+  private:
+    const Beats& m_beats;
+    const double m_maxSample;
+    std::atomic<bool> m_stop;
+    std::atomic<int> m_lookupCount;
+};
+
 class BeatMapTest : public testing::Test {
   protected:
 
@@ -293,4 +344,91 @@ TEST_F(BeatMapTest, TestBpmAround) {
     EXPECT_DOUBLE_EQ(filebpm, pMap->getBpmAroundPosition(1 * approx_beat_length, 4));
 }
 
+TEST_F(BeatMapTest, ConcurrentEditAndLookup) {
+    const double bpm = 120.0;
+    const double beatLengthFrames = getBeatLengthFrames(bpm);
+    const double beatLengthSamples = getBeatLengthSamples(bpm);
+    const int numBeats = 1000;
+    QVector<double> beats = createBeatVector(0, numBeats, beatLengthFrames);
+    auto pMap = std::make_unique<BeatMap>(*m_pTrack, 0, beats);
+
+    BeatLookupThread lookupThread(*pMap, numBeats * beatLengthSamples);
+    lookupThread.start();
+
+    // Edit the beats like the GUI and the analyzer would do while the
+    // engine thread keeps looking up beats.
+    for (int i = 0; i < 1000; ++i) {
+        pMap->translate(beatLengthSamples / 2);
+        pMap->addBeat(beatLengthSamples * (i % numBeats) + beatLengthSamples / 4);
+        pMap->scale(Beats::DOUBLE);
+        pMap->scale(Beats::HALVE);
+        pMap->removeBeat(beatLengthSamples * (i % numBeats) + beatLengthSamples / 4);
+        pMap->translate(-beatLengthSamples / 2);
+    }
+
+    lookupThread.stop();
+    lookupThread.wait();
+    EXPECT_LT(0, lookupThread.lookupCount());
+    EXPECT_DOUBLE_EQ(bpm, pMap->getBpm());
+}
+
+static void BM_BeatMapFindNthBeat(benchmark::State& state) {
+    const int sampleRate = 44100;
+    TrackPointer pTrack(Track::newTemporary());
+    pTrack->setAudioProperties(
+            mixxx::audio::ChannelCount(2),
+            mixxx::audio::SampleRate(sampleRate),
+            mixxx::audio::Bitrate(),
+            mixxx::Duration::fromSeconds(3600));
+    const double beatLengthFrames = 60.0 * sampleRate / 128.0;
+    const int numBeats = state.range(0);
+    QVector<double> beats;
+    for (int i = 0; i < numBeats; ++i) {
+        beats.append(i * beatLengthFrames);
+    }
+    BeatMap beatMap(*pTrack, 0, beats);
+
+    const double maxSample = numBeats * beatLengthFrames * 2;
+    double position = 0;
+    while (state.KeepRunning()) {
+        position += 4099;
+        if (position > maxSample) {
+            position = 0;
+        }
+        benchmark::DoNotOptimize(beatMap.findNthBeat(position, 4));
+    }
+}
+BENCHMARK(BM_BeatMapFindNthBeat)->Range(64, 16384);
+
+static void BM_BeatMapFindPrevNextBeats(benchmark::State& state) {
+    const int sampleRate = 44100;
+    TrackPointer pTrack(Track::newTemporary());
+    pTrack->setAudioProperties(
+            mixxx::audio::ChannelCount(2),
+            mixxx::audio::SampleRate(sampleRate),
+            mixxx::audio::Bitrate(),
+            mixxx::Duration::fromSeconds(3600));
+    const double beatLengthFrames = 60.0 * sampleRate / 128.0;
+    const int numBeats = state.range(0);
+    QVector<double> beats;
+    for (int i = 0; i < numBeats; ++i) {
+        beats.append(i * beatLengthFrames);
+    }
+    BeatMap beatMap(*pTrack, 0, beats);
+
+    const double maxSample = numBeats * beatLengthFrames * 2;
+    double position = 0;
+    double prevBeat;
+    double nextBeat;
+    while (state.KeepRunning()) {
+        position += 4099;
+        if (position > maxSample) {
+            position = 0;
+        }
+        benchmark::DoNotOptimize(
+                beatMap.findPrevNextBeats(position, &prevBeat, &nextBeat));
+    }
+}
+BENCHMARK(BM_BeatMapFindPrevNextBeats)->Range(64, 16384);
+
 }  // namespace
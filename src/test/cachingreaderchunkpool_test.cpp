@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "engine/cachingreader/cachingreaderchunkpool.h"
+
+namespace {
+
+typedef CachingReaderChunkPool::Activity Activity;
+
+class CachingReaderChunkPoolTest : public testing::Test {
+};
+
+TEST_F(CachingReaderChunkPoolTest, AcquireAndRelease) {
+    CachingReaderChunkPool pool(8);
+    std::vector<CachingReaderChunkForOwner*> chunks;
+    for (int i = 0; i < pool.chunkCount(); ++i) {
+        auto pChunk = pool.tryAcquireChunk();
+        ASSERT_NE(nullptr, pChunk);
+        EXPECT_EQ(chunks.end(), std::find(chunks.begin(), chunks.end(), pChunk));
+        chunks.push_back(pChunk);
+    }
+    // Exhausted
+    EXPECT_EQ(nullptr, pool.tryAcquireChunk());
+
+    pool.releaseChunk(chunks[3]);
+    EXPECT_EQ(chunks[3], pool.tryAcquireChunk());
+    EXPECT_EQ(nullptr, pool.tryAcquireChunk());
+
+    for (auto pChunk : chunks) {
+        pool.releaseChunk(pChunk);
+    }
+}
+
+TEST_F(CachingReaderChunkPoolTest, QuotaByActivity) {
+    CachingReaderChunkPool pool(1024);
+    // 4 decks and 64 samplers
+    for (int i = 0; i < 68; ++i) {
+        pool.addReader();
+    }
+    const SINT idleQuota = pool.quota(Activity::Idle);
+    EXPECT_LE(idleQuota * 68, pool.chunkCount());
+
+    for (int i = 0; i < 4; ++i) {
+        pool.changeActivity(Activity::Idle, Activity::Playing);
+    }
+    const SINT playingQuota = pool.quota(Activity::Playing);
+    EXPECT_GT(playingQuota, idleQuota);
+    // Idle readers give up memory in favor of the playing decks
+    EXPECT_LT(pool.quota(Activity::Idle), idleQuota);
+    EXPECT_LE(playingQuota * 4 + pool.quota(Activity::Idle) * 64, pool.chunkCount());
+
+    pool.changeActivity(Activity::Playing, Activity::Scratching);
+    EXPECT_GT(pool.quota(Activity::Scratching), pool.quota(Activity::Playing));
+
+    pool.removeReader(Activity::Scratching);
+    for (int i = 0; i < 3; ++i) {
+        pool.removeReader(Activity::Playing);
+    }
+    for (int i = 0; i < 64; ++i) {
+        pool.removeReader(Activity::Idle);
+    }
+}
+
+} // namespace
@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+
+#include <QDir>
+#include <QtDebug>
+
+#include "engine/cachingreader/cachingreaderchunk.h"
+#include "engine/cachingreader/cachingreaderdecodedtrack.h"
+#include "sources/soundsourceproxy.h"
+#include "test/mixxxtest.h"
+#include "util/samplebuffer.h"
+
+namespace {
+
+const QDir kTestDir(QDir::current().absoluteFilePath("src/test/id3-test-data"));
+
+// Lossless formats are decoded bit-exact, regardless of seeking
+const QStringList kFileNames = {
+        QStringLiteral("cover-test.aiff"),
+        QStringLiteral("cover-test.flac"),
+        QStringLiteral("cover-test.wav"),
+};
+
+class CachingReaderDecodedTrackTest : public MixxxTest {
+  protected:
+    // Opens the audio source like CachingReaderWorker
+    static mixxx::AudioSourcePointer openAudioSource(const TrackPointer& pTrack) {
+        mixxx::AudioSource::OpenParams config;
+        config.setChannelCount(CachingReaderChunk::kChannels);
+        return SoundSourceProxy(pTrack).openAudioSource(config);
+    }
+};
+
+TEST_F(CachingReaderDecodedTrackTest, ReadLikeChunks) {
+    for (const auto& fileName : kFileNames) {
+        if (!SoundSourceProxy::isFileNameSupported(fileName)) {
+            qInfo() << "Ignoring unsupported file type" << fileName;
+            continue;
+        }
+        qDebug() << "Decoding" << fileName;
+        const TrackPointer pTrack = Track::newTemporary(TrackFile(kTestDir, fileName));
+        mixxx::SampleBuffer tempReadBuffer(CachingReaderChunk::kSamples);
+
+        const auto pDecodeSource = openAudioSource(pTrack);
+        ASSERT_TRUE(pDecodeSource != nullptr);
+        const auto pDecodedTrack = CachingReaderDecodedTrack::lookupOrDecode(
+                pTrack,
+                pDecodeSource,
+                mixxx::SampleBuffer::WritableSlice(tempReadBuffer));
+        ASSERT_TRUE(pDecodedTrack != nullptr);
+        EXPECT_EQ(pDecodeSource->frameIndexRange(), pDecodedTrack->frameIndexRange());
+
+        // A separate audio source that is read chunk by chunk like
+        // the worker does on demand
+        const auto pChunkSource = openAudioSource(pTrack);
+        ASSERT_TRUE(pChunkSource != nullptr);
+        mixxx::SampleBuffer chunkBuffer(CachingReaderChunk::kSamples);
+        CachingReaderChunkForOwner chunk(
+                mixxx::SampleBuffer::WritableSlice(chunkBuffer));
+        mixxx::SampleBuffer chunkSamples(CachingReaderChunk::kSamples);
+        mixxx::SampleBuffer decodedSamples(CachingReaderChunk::kSamples);
+        const SINT firstChunkIndex =
+                CachingReaderChunk::indexForFrame(pChunkSource->frameIndexMin());
+        const SINT lastChunkIndex =
+                CachingReaderChunk::indexForFrame(pChunkSource->frameIndexMax() - 1);
+        for (SINT chunkIndex = firstChunkIndex; chunkIndex <= lastChunkIndex; ++chunkIndex) {
+            chunk.init(chunkIndex);
+            const auto frameIndexRange = chunk.bufferSampleFrames(
+                    pChunkSource,
+                    mixxx::SampleBuffer::WritableSlice(tempReadBuffer));
+            ASSERT_FALSE(frameIndexRange.empty());
+            const SINT sampleCount =
+                    CachingReaderChunk::frames2samples(frameIndexRange.length());
+
+            EXPECT_EQ(frameIndexRange,
+                    chunk.readBufferedSampleFrames(
+                            chunkSamples.data(), frameIndexRange));
+            EXPECT_EQ(frameIndexRange,
+                    pDecodedTrack->readBufferedSampleFrames(
+                            decodedSamples.data(), frameIndexRange));
+            for (SINT i = 0; i < sampleCount; ++i) {
+                ASSERT_EQ(chunkSamples[i], decodedSamples[i])
+                        << fileName.toStdString() << " chunk " << chunkIndex
+                        << " sample " << i;
+            }
+
+            EXPECT_EQ(frameIndexRange,
+                    chunk.readBufferedSampleFramesReverse(
+                            chunkSamples.data() + sampleCount, frameIndexRange));
+            EXPECT_EQ(frameIndexRange,
+                    pDecodedTrack->readBufferedSampleFramesReverse(
+                            decodedSamples.data() + sampleCount, frameIndexRange));
+            for (SINT i = 0; i < sampleCount; ++i) {
+                ASSERT_EQ(chunkSamples[i], decodedSamples[i])
+                        << fileName.toStdString() << " reverse chunk " << chunkIndex
+                        << " sample " << i;
+            }
+
+            chunk.free();
+        }
+    }
+}
+
+} // anonymous namespace
@@ -0,0 +1,276 @@
+#include <benchmark/benchmark.h>
+#include <gtest/gtest.h>
+
+#include <QSqlDatabase>
+
+#include "library/columnartrackindex.h"
+#include "library/searchquery.h"
+
+namespace {
+
+const QStringList kColumns = {"id", "artist", "title", "bpm", "tracknumber"};
+
+constexpr int kIdColumn = 0;
+constexpr int kArtistColumn = 1;
+constexpr int kTitleColumn = 2;
+constexpr int kBpmColumn = 3;
+constexpr int kTrackNumberColumn = 4;
+
+class ColumnarTrackIndexTest : public testing::Test {
+  protected:
+    ColumnarTrackIndexTest()
+            : m_index(kColumns) {
+    }
+
+    int addTrack(int id,
+            const QVariant& artist,
+            const QVariant& title,
+            const QVariant& bpm,
+            const QVariant& trackNumber = QVariant()) {
+        const int row = m_index.insertRow(TrackId(id));
+        m_index.setValue(row, kIdColumn, id);
+        m_index.setValue(row, kArtistColumn, artist);
+        m_index.setValue(row, kTitleColumn, title);
+        m_index.setValue(row, kBpmColumn, bpm);
+        m_index.setValue(row, kTrackNumberColumn, trackNumber);
+        return row;
+    }
+
+    QList<int> sortedTrackIds(const QVector<ColumnarTrackIndex::SortKey>& sortKeys) {
+        QList<int> trackIds;
+        for (int row : m_index.sortedRows(sortKeys, KeyUtils::KeyNotation::Custom)) {
+            trackIds.append(m_index.trackId(row).toVariant().toInt());
+        }
+        return trackIds;
+    }
+
+    QList<int> matchingTrackIds(QueryNode* pNode) {
+        QList<int> trackIds;
+        EXPECT_TRUE(pNode->bindIndex(m_index));
+        for (int row = 0; row < m_index.rowCount(); ++row) {
+            if (pNode->matchIndex(row)) {
+                trackIds.append(m_index.trackId(row).toVariant().toInt());
+            }
+        }
+        std::sort(trackIds.begin(), trackIds.end());
+        return trackIds;
+    }
+
+    ColumnarTrackIndex m_index;
+};
+
+TEST_F(ColumnarTrackIndexTest, Values) {
+    const int row1 = addTrack(1, "Artist", "Title", 120.5, qlonglong(3));
+    const int row2 = addTrack(2, QVariant(QVariant::String), "", 128.0);
+
+    EXPECT_EQ(QVariant("Artist"), m_index.value(row1, kArtistColumn));
+    EXPECT_EQ(QVariant("Title"), m_index.value(row1, kTitleColumn));
+    EXPECT_EQ(QVariant(120.5), m_index.value(row1, kBpmColumn));
+    EXPECT_EQ(QVariant(qlonglong(3)), m_index.value(row1, kTrackNumberColumn));
+
+    // Null values keep their type
+    EXPECT_TRUE(m_index.value(row2, kArtistColumn).isNull());
+    EXPECT_EQ(QVariant::String, m_index.value(row2, kArtistColumn).type());
+    // Empty strings are not null
+    EXPECT_FALSE(m_index.value(row2, kTitleColumn).isNull());
+    EXPECT_EQ(QVariant(""), m_index.value(row2, kTitleColumn));
+    EXPECT_FALSE(m_index.value(row2, kTrackNumberColumn).isValid());
+}
+
+TEST_F(ColumnarTrackIndexTest, MixedTypes) {
+    const int row1 = addTrack(1, "Artist", "Title", 120);
+    const int row2 = addTrack(2, "Artist", 42, 120.5);
+
+    // Integers are converted into real numbers
+    EXPECT_EQ(QVariant(120.0), m_index.value(row1, kBpmColumn));
+    EXPECT_EQ(QVariant(120.5), m_index.value(row2, kBpmColumn));
+
+    // Values of other types are stored as is
+    EXPECT_EQ(QVariant("Title"), m_index.value(row1, kTitleColumn));
+    EXPECT_EQ(QVariant(42), m_index.value(row2, kTitleColumn));
+}
+
+TEST_F(ColumnarTrackIndexTest, UpdateAndRemoveRows) {
+    addTrack(1, "Artist 1", "Title 1", 120.0);
+    addTrack(2, "Artist 2", "Title 2", 121.0);
+    addTrack(3, "Artist 3", "Title 3", 122.0);
+    ASSERT_EQ(3, m_index.rowCount());
+
+    // The row of an indexed track is reused
+    EXPECT_EQ(1, addTrack(2, "Artist 2", "Title 2 (Remix)", 124.0));
+    EXPECT_EQ(3, m_index.rowCount());
+
+    m_index.removeRow(TrackId(1));
+    EXPECT_EQ(2, m_index.rowCount());
+    EXPECT_FALSE(m_index.contains(TrackId(1)));
+
+    // The last row has been moved
+    const int row3 = m_index.row(TrackId(3));
+    EXPECT_EQ(0, row3);
+    EXPECT_EQ(QVariant("Title 3"), m_index.value(row3, kTitleColumn));
+    const int row2 = m_index.row(TrackId(2));
+    EXPECT_EQ(QVariant("Title 2 (Remix)"), m_index.value(row2, kTitleColumn));
+    EXPECT_EQ(QVariant(124.0), m_index.value(row2, kBpmColumn));
+}
+
+TEST_F(ColumnarTrackIndexTest, SortedRows) {
+    addTrack(1, "b", "Title", 120.0, "10");
+    addTrack(2, "A", "Title", 128.0, "9/12");
+    addTrack(3, QVariant(QVariant::String), "Title", 110.0, "1");
+    addTrack(4, "a", "Title", QVariant(QVariant::Double), "2");
+
+    // Nulls first, case-insensitive, equal values by id
+    EXPECT_EQ(QList<int>({3, 2, 4, 1}),
+            sortedTrackIds({{kArtistColumn,
+                    ColumnarTrackIndex::SortMode::Collation,
+                    Qt::AscendingOrder}}));
+    EXPECT_EQ(QList<int>({1, 2, 4, 3}),
+            sortedTrackIds({{kArtistColumn,
+                    ColumnarTrackIndex::SortMode::Collation,
+                    Qt::DescendingOrder}}));
+    EXPECT_EQ(QList<int>({4, 3, 1, 2}),
+            sortedTrackIds({{kBpmColumn,
+                    ColumnarTrackIndex::SortMode::Collation,
+                    Qt::AscendingOrder}}));
+    EXPECT_EQ(QList<int>({3, 4, 2, 1}),
+            sortedTrackIds({{kTrackNumberColumn,
+                    ColumnarTrackIndex::SortMode::Numeric,
+                    Qt::AscendingOrder}}));
+    EXPECT_EQ(QList<int>({3, 2, 4, 1}),
+            sortedTrackIds({{kArtistColumn,
+                                   ColumnarTrackIndex::SortMode::Collation,
+                                   Qt::AscendingOrder},
+                    {kBpmColumn,
+                            ColumnarTrackIndex::SortMode::Collation,
+                            Qt::DescendingOrder}}));
+
+    // The cached order is invalidated by modifications
+    addTrack(5, "0", "Title", 100.0);
+    EXPECT_EQ(QList<int>({5, 4, 3, 1, 2}),
+            sortedTrackIds({{kBpmColumn,
+                    ColumnarTrackIndex::SortMode::Collation,
+                    Qt::AscendingOrder}}));
+}
+
+TEST_F(ColumnarTrackIndexTest, TextFilter) {
+    addTrack(1, "Björk", "Jóga", 110.0);
+    addTrack(2, "Bjorn", "Title", 120.0);
+    addTrack(3, QVariant(QVariant::String), "JOGA", 130.0);
+
+    TextFilterNode artistNode(QSqlDatabase(), {"artist"}, "bjö");
+    EXPECT_EQ(QList<int>({1, 2}), matchingTrackIds(&artistNode));
+
+    TextFilterNode titleNode(QSqlDatabase(), {"artist", "title"}, "joga");
+    EXPECT_EQ(QList<int>({1, 3}), matchingTrackIds(&titleNode));
+
+    NullOrEmptyTextFilterNode nullNode(QSqlDatabase(), {"artist"});
+    EXPECT_EQ(QList<int>({3}), matchingTrackIds(&nullNode));
+
+    // Unknown columns cannot be matched in memory
+    TextFilterNode unknownNode(QSqlDatabase(), {"composer"}, "bjork");
+    EXPECT_FALSE(unknownNode.bindIndex(m_index));
+}
+
+TEST_F(ColumnarTrackIndexTest, NumericFilter) {
+    addTrack(1, "Artist", "Title", 110.0);
+    addTrack(2, "Artist", "Title", 120.0);
+    addTrack(3, "Artist", "Title", QVariant(QVariant::Double));
+
+    NumericFilterNode greaterNode({"bpm"}, ">115");
+    EXPECT_EQ(QList<int>({2}), matchingTrackIds(&greaterNode));
+
+    NumericFilterNode rangeNode({"bpm"}, "100-120");
+    EXPECT_EQ(QList<int>({1, 2}), matchingTrackIds(&rangeNode));
+
+    NullNumericFilterNode nullNode({"bpm"});
+    EXPECT_EQ(QList<int>({3}), matchingTrackIds(&nullNode));
+}
+
+TEST_F(ColumnarTrackIndexTest, CompositeFilter) {
+    addTrack(1, "Artist", "Title", 110.0);
+    addTrack(2, "Artist", "Other", 120.0);
+    addTrack(3, "Other", "Title", 130.0);
+
+    AndNode andNode;
+    andNode.addNode(std::make_unique<TextFilterNode>(
+            QSqlDatabase(), QStringList{"artist"}, "artist"));
+    andNode.addNode(std::make_unique<NotNode>(std::make_unique<TextFilterNode>(
+            QSqlDatabase(), QStringList{"title"}, "other")));
+    // Without a condition like in the SQL query
+    andNode.addNode(std::make_unique<NotNode>(
+            std::make_unique<NumericFilterNode>(QStringList{"bpm"}, ">")));
+    EXPECT_EQ(QList<int>({1}), matchingTrackIds(&andNode));
+
+    OrNode orNode;
+    orNode.addNode(std::make_unique<TextFilterNode>(
+            QSqlDatabase(), QStringList{"title"}, "other"));
+    orNode.addNode(std::make_unique<NumericFilterNode>(QStringList{"bpm"}, "<115"));
+    EXPECT_EQ(QList<int>({1, 2}), matchingTrackIds(&orNode));
+
+    // Arbitrary SQL expressions cannot be matched in memory
+    AndNode sqlNode;
+    sqlNode.addNode(std::make_unique<SqlNode>("bpm > 100"));
+    EXPECT_FALSE(sqlNode.bindIndex(m_index));
+}
+
+void populateIndex(ColumnarTrackIndex* pIndex, int count) {
+    for (int i = 1; i <= count; ++i) {
+        const int row = pIndex->insertRow(TrackId(i));
+        pIndex->setValue(row, kIdColumn, i);
+        pIndex->setValue(row, kArtistColumn, QString("Artist %1").arg(i % 5000));
+        pIndex->setValue(row, kTitleColumn, QString("Title %1").arg(count - i));
+        pIndex->setValue(row, kBpmColumn, 80.0 + i % 100);
+        pIndex->setValue(row, kTrackNumberColumn, QString::number(i % 20));
+    }
+}
+
+// Filters 200k tracks like typing into the search box
+static void BM_ColumnarTrackIndexFilter(benchmark::State& state) {
+    ColumnarTrackIndex index(kColumns);
+    populateIndex(&index, 200000);
+    const QVector<ColumnarTrackIndex::SortKey> sortKeys = {
+            {kArtistColumn, ColumnarTrackIndex::SortMode::Collation, Qt::AscendingOrder}};
+    // Warm up the caches
+    index.sortedRows(sortKeys, KeyUtils::KeyNotation::Custom);
+
+    const QStringList searches = {"a", "artist 1", "title 12", "bpm:>150"};
+    int iteration = 0;
+    for (auto _ : state) {
+        const QString& search = searches[iteration++ % searches.size()];
+        AndNode query;
+        if (search.startsWith("bpm:")) {
+            query.addNode(std::make_unique<NumericFilterNode>(
+                    QStringList{"bpm"}, search.mid(4)));
+        } else {
+            query.addNode(std::make_unique<TextFilterNode>(
+                    QSqlDatabase(), QStringList{"artist", "title"}, search));
+        }
+        query.bindIndex(index);
+        const auto rows = index.selectRows(
+                index.sortedRows(sortKeys, KeyUtils::KeyNotation::Custom),
+                [&query](int row) {
+                    return query.matchIndex(row);
+                });
+        benchmark::DoNotOptimize(rows.data());
+    }
+    state.SetItemsProcessed(state.iterations() * index.rowCount());
+}
+BENCHMARK(BM_ColumnarTrackIndexFilter)->Unit(benchmark::kMillisecond);
+
+// Sorts 200k tracks after each modification
+static void BM_ColumnarTrackIndexSort(benchmark::State& state) {
+    ColumnarTrackIndex index(kColumns);
+    populateIndex(&index, 200000);
+    const QVector<ColumnarTrackIndex::SortKey> sortKeys = {
+            {kTitleColumn, ColumnarTrackIndex::SortMode::Collation, Qt::AscendingOrder}};
+    int row = 0;
+    for (auto _ : state) {
+        index.setValue(row++ % index.rowCount(), kBpmColumn, 120.0);
+        benchmark::DoNotOptimize(
+                index.sortedRows(sortKeys, KeyUtils::KeyNotation::Custom).data());
+    }
+    state.SetItemsProcessed(state.iterations() * index.rowCount());
+}
+BENCHMARK(BM_ColumnarTrackIndexSort)->Unit(benchmark::kMillisecond);
+
+} // anonymous namespace
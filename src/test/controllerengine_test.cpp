@@ -1,3 +1,5 @@
+#include <benchmark/benchmark.h>
+
 #include <QThread>
 #include <QtDebug>
 
@@ -32,10 +34,13 @@ class ControllerEngineTest : public MixxxTest {
         return cEngine->evaluateScriptFile(scriptFile);
     }
 
+  public:
+    // Also used by the benchmarks
     QJSValue evaluate(const QString& code) {
         return cEngine->evaluateCodeString(code);
     }
 
+  protected:
     bool evaluateAndAssert(const QString& code) {
         return !cEngine->evaluateCodeString(code).isError();
     }
@@ -76,6 +81,26 @@ TEST_F(ControllerEngineTest, getSetValue) {
     EXPECT_DOUBLE_EQ(1.0, co->get());
 }
 
+TEST_F(ControllerEngineTest, getValue_CallSites) {
+    auto co1 = std::make_unique<ControlObject>(ConfigKey("[Test]", "co1"));
+    auto co2 = std::make_unique<ControlObject>(ConfigKey("[Test]", "co2"));
+    co1->set(1.0);
+    co2->set(2.0);
+    // Resolved controls are cached per call site. Both literal and
+    // computed arguments must resolve to the right control on every call.
+    QJSValue result = evaluate(
+            "var values = [];"
+            "for (var i = 1; i <= 2; ++i) {"
+            "  for (var j = 0; j < 3; ++j) {"
+            "    values.push(engine.getValue('[Test]', 'co' + i));"
+            "    values.push(engine.getValue('[Test]', 'co1'));"
+            "    values.push(engine.getValue('[Test]', 'co2'));"
+            "  }"
+            "}"
+            "values.join(',');");
+    EXPECT_EQ("1,1,2,1,1,2,1,1,2,2,1,2,2,1,2,2,1,2", result.toString());
+}
+
 TEST_F(ControllerEngineTest, setParameter) {
     auto co = std::make_unique<ControlPotmeter>(ConfigKey("[Test]", "co"),
                                                 -10.0, 10.0);
@@ -581,3 +606,25 @@ TEST_F(ControllerEngineTest, connectionExecutesWithCorrectThisObject) {
     // The counter should have been incremented exactly once.
     EXPECT_DOUBLE_EQ(1.0, pass->get());
 }
+
+// The throughput of a script that reads controls in a tight loop, e.g.
+// when updating the LEDs of a controller
+static void BM_ControllerEngineGetValue(benchmark::State& state) {
+    constexpr int kCallsPerEvaluation = 10000;
+    MixxxTestFixture<ControllerEngineTest> engine;
+    auto co = std::make_unique<ControlObject>(ConfigKey("[Test]", "co"));
+    engine.evaluate(
+            "var getValues = function (count) {"
+            "  var sum = 0;"
+            "  for (var i = 0; i < count; ++i) {"
+            "    sum += engine.getValue('[Test]', 'co');"
+            "  }"
+            "  return sum;"
+            "};");
+    const QString program = QString("getValues(%1);").arg(kCallsPerEvaluation);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(engine.evaluate(program));
+    }
+    state.SetItemsProcessed(state.iterations() * kCallsPerEvaluation);
+}
+BENCHMARK(BM_ControllerEngineGetValue)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,144 @@
+#include <benchmark/benchmark.h>
+#include <gtest/gtest.h>
+
+#include <QtDebug>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "control/controlobject.h"
+#include "control/controlproxy.h"
+#include "test/mixxxtest.h"
+
+namespace {
+
+const QString kGroup = QStringLiteral("[Test]");
+
+ConfigKey testKey(int index) {
+    return ConfigKey(kGroup, QString("control%1").arg(index));
+}
+
+// The controls of a skin, i.e. several decks with hundreds of controls each
+class SkinControls {
+  public:
+    explicit SkinControls(int count) {
+        for (int i = 0; i < count; ++i) {
+            m_controls.push_back(std::make_unique<ControlObject>(testKey(i)));
+        }
+    }
+
+    int size() const {
+        return static_cast<int>(m_controls.size());
+    }
+
+    ConfigKey getKey(int index) const {
+        return m_controls[index]->getKey();
+    }
+
+  private:
+    std::vector<std::unique_ptr<ControlObject>> m_controls;
+};
+
+class ControlRegistryTest : public MixxxTest {
+};
+
+TEST_F(ControlRegistryTest, RecreateControl) {
+    const ConfigKey key = testKey(0);
+    auto pControl = std::make_unique<ControlObject>(key);
+    EXPECT_EQ(pControl.get(), ControlObject::getControl(key));
+
+    pControl.reset();
+    EXPECT_EQ(ControlObject::getControl(key, ControlFlag::NoAssertIfMissing),
+            (ControlObject*)nullptr);
+
+    pControl = std::make_unique<ControlObject>(key, false, false, false, 2.0);
+    EXPECT_EQ(pControl.get(), ControlObject::getControl(key));
+    EXPECT_DOUBLE_EQ(2.0, ControlObject::get(key));
+}
+
+TEST_F(ControlRegistryTest, GrowTable) {
+    SkinControls controls(20000);
+    for (int i = 0; i < controls.size(); ++i) {
+        ControlProxy proxy(controls.getKey(i));
+        EXPECT_TRUE(proxy.valid());
+    }
+}
+
+TEST_F(ControlRegistryTest, ConcurrentLookups) {
+    SkinControls existingControls(1000);
+
+    std::atomic<bool> done(false);
+    std::atomic<int> missingControls(0);
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < 4; ++thread) {
+        threads.emplace_back([&] {
+            while (!done.load()) {
+                for (int i = 0; i < existingControls.size(); ++i) {
+                    if (!ControlDoublePrivate::getControl(
+                                existingControls.getKey(i))) {
+                        missingControls.fetch_add(1);
+                    }
+                }
+            }
+        });
+    }
+
+    // Inserting controls grows and replaces the table while the other
+    // threads are looking up controls
+    std::vector<std::unique_ptr<ControlObject>> newControls;
+    for (int i = existingControls.size(); i < 20000; ++i) {
+        newControls.push_back(std::make_unique<ControlObject>(testKey(i)));
+    }
+    newControls.clear();
+
+    done.store(true);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(0, missingControls.load());
+}
+
+// The lookups of a skin that creates a ControlProxy for each of its
+// controls while loading
+static void BM_SkinLoadControlProxies(benchmark::State& state) {
+    SkinControls controls(static_cast<int>(state.range(0)));
+    for (auto _ : state) {
+        std::vector<std::unique_ptr<ControlProxy>> proxies;
+        proxies.reserve(controls.size());
+        for (int i = 0; i < controls.size(); ++i) {
+            proxies.push_back(std::make_unique<ControlProxy>(controls.getKey(i)));
+        }
+        benchmark::DoNotOptimize(proxies.data());
+    }
+}
+BENCHMARK(BM_SkinLoadControlProxies)->Arg(5000)->Unit(benchmark::kMillisecond);
+
+SkinControls* s_pControls = nullptr;
+
+// Lookups from multiple threads, e.g. the GUI, controller scripts, and
+// engine workers, do not serialize on a mutex
+static void BM_ControlLookup(benchmark::State& state) {
+    constexpr int kControlCount = 1000;
+    if (state.thread_index == 0) {
+        s_pControls = new SkinControls(kControlCount);
+    }
+    // Separate strings for each thread like in a real session
+    std::vector<ConfigKey> keys;
+    for (int i = 0; i < kControlCount; ++i) {
+        keys.push_back(testKey(i));
+    }
+    for (auto _ : state) {
+        for (const auto& key : keys) {
+            benchmark::DoNotOptimize(ControlDoublePrivate::getControl(key));
+        }
+    }
+    if (state.thread_index == 0) {
+        delete s_pControls;
+        s_pControls = nullptr;
+    }
+}
+BENCHMARK(BM_ControlLookup)->ThreadRange(1, 4)->UseRealTime();
+
+}  // namespace
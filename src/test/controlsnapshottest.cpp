@@ -0,0 +1,135 @@
+#include <benchmark/benchmark.h>
+#include <gtest/gtest.h>
+
+#include <QtDebug>
+
+#include <memory>
+#include <vector>
+
+#include "control/controlobject.h"
+#include "control/controlproxy.h"
+#include "control/controlsnapshot.h"
+#include "test/mixxxtest.h"
+
+namespace {
+
+const QString kGroup = QStringLiteral("[Test]");
+
+class ControlSnapshotTest : public MixxxTest {
+  protected:
+    ControlSnapshotTest()
+            : m_co1(ConfigKey(kGroup, "co1")),
+              m_co2(ConfigKey(kGroup, "co2")),
+              m_co3(ConfigKey(kGroup, "co3")) {
+    }
+
+    ControlObject m_co1;
+    ControlObject m_co2;
+    ControlObject m_co3;
+};
+
+TEST_F(ControlSnapshotTest, InitialValues) {
+    m_co1.set(1.0);
+    m_co2.set(2.0);
+
+    ControlSnapshot snapshot;
+    const ControlSnapshot::Index index1 = snapshot.addControl(m_co1.getKey());
+    const ControlSnapshot::Index index2 = snapshot.addControl(m_co2.getKey());
+    EXPECT_EQ(2, snapshot.size());
+    EXPECT_DOUBLE_EQ(1.0, snapshot.get(index1));
+    EXPECT_DOUBLE_EQ(2.0, snapshot.get(index2));
+    EXPECT_TRUE(snapshot.toBool(index1));
+}
+
+TEST_F(ControlSnapshotTest, ChangesTakeEffectOnRefresh) {
+    ControlSnapshot snapshot;
+    const ControlSnapshot::Index index1 = snapshot.addControl(m_co1.getKey());
+    const ControlSnapshot::Index index2 = snapshot.addControl(m_co2.getKey());
+
+    m_co1.set(3.0);
+    ControlObject::set(m_co2.getKey(), 4.0);
+    // Values are consistent until the next refresh
+    EXPECT_DOUBLE_EQ(0.0, snapshot.get(index1));
+    EXPECT_DOUBLE_EQ(0.0, snapshot.get(index2));
+
+    snapshot.refresh();
+    EXPECT_DOUBLE_EQ(3.0, snapshot.get(index1));
+    EXPECT_DOUBLE_EQ(4.0, snapshot.get(index2));
+}
+
+TEST_F(ControlSnapshotTest, SharedControls) {
+    ControlSnapshot snapshot1;
+    ControlSnapshot snapshot2;
+    const ControlSnapshot::Index index1 = snapshot1.addControl(m_co3.getKey());
+    const ControlSnapshot::Index index2 = snapshot2.addControl(m_co3.getKey());
+
+    m_co3.set(5.0);
+    snapshot1.refresh();
+    snapshot2.refresh();
+    EXPECT_DOUBLE_EQ(5.0, snapshot1.get(index1));
+    EXPECT_DOUBLE_EQ(5.0, snapshot2.get(index2));
+}
+
+// Creates controls in between other allocations like in a real session
+// where the controls are scattered across the heap
+class ScatteredControls {
+  public:
+    explicit ScatteredControls(int count) {
+        for (int i = 0; i < count; ++i) {
+            m_controls.push_back(std::make_unique<ControlObject>(
+                    ConfigKey(kGroup, QString("scattered%1").arg(i))));
+            m_padding.push_back(std::vector<char>(4096));
+        }
+    }
+
+    int size() const {
+        return static_cast<int>(m_controls.size());
+    }
+
+    ConfigKey getKey(int index) const {
+        return m_controls[index]->getKey();
+    }
+
+  private:
+    std::vector<std::unique_ptr<ControlObject>> m_controls;
+    std::vector<std::vector<char>> m_padding;
+};
+
+// The cost of reading controls through ControlProxy like the engine does
+// without a snapshot
+static void BM_ControlProxyRead(benchmark::State& state) {
+    ScatteredControls controls(static_cast<int>(state.range(0)));
+    std::vector<std::unique_ptr<ControlProxy>> proxies;
+    for (int i = 0; i < controls.size(); ++i) {
+        proxies.push_back(std::make_unique<ControlProxy>(controls.getKey(i)));
+    }
+    for (auto _ : state) {
+        double sum = 0;
+        for (const auto& pProxy : proxies) {
+            sum += pProxy->get();
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+}
+BENCHMARK(BM_ControlProxyRead)->Arg(8)->Arg(32);
+
+// The cost of refreshing the snapshot once per callback and reading all
+// controls from it
+static void BM_ControlSnapshotRead(benchmark::State& state) {
+    ScatteredControls controls(static_cast<int>(state.range(0)));
+    ControlSnapshot snapshot;
+    for (int i = 0; i < controls.size(); ++i) {
+        snapshot.addControl(controls.getKey(i));
+    }
+    for (auto _ : state) {
+        snapshot.refresh();
+        double sum = 0;
+        for (int index = 0; index < snapshot.size(); ++index) {
+            sum += snapshot.get(index);
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+}
+BENCHMARK(BM_ControlSnapshotRead)->Arg(8)->Arg(32);
+
+}  // namespace
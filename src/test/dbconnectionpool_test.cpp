@@ -1,10 +1,17 @@
+#include <benchmark/benchmark.h>
 #include <gtest/gtest.h>
 
+#include <QSqlQuery>
+#include <atomic>
+#include <thread>
+
 #include "test/mixxxtest.h"
 
 #include "database/mixxxdb.h"
 #include "util/db/dbconnectionpooler.h"
 #include "util/db/dbconnectionpooled.h"
+#include "util/db/sqlquerycache.h"
+#include "util/db/sqltransaction.h"
 
 #include "library/dao/settingsdao.h"
 
@@ -35,3 +42,120 @@ TEST_F(DbConnectionPoolTest, MoveSemantics) {
     EXPECT_TRUE(p1.isPooling());
     EXPECT_FALSE(p2.isPooling());
 }
+
+TEST_F(DbConnectionPoolTest, SqliteProfile) {
+    const mixxx::DbConnectionPooler pooler(m_mixxxDb.connectionPool());
+    const QSqlDatabase database = mixxx::DbConnectionPooled(m_mixxxDb.connectionPool());
+    QSqlQuery query(database);
+
+    ASSERT_TRUE(query.exec("PRAGMA journal_mode"));
+    ASSERT_TRUE(query.next());
+    EXPECT_EQ(QStringLiteral("wal"), query.value(0).toString().toLower());
+
+    // NORMAL
+    ASSERT_TRUE(query.exec("PRAGMA synchronous"));
+    ASSERT_TRUE(query.next());
+    EXPECT_EQ(1, query.value(0).toInt());
+
+    // MEMORY
+    ASSERT_TRUE(query.exec("PRAGMA temp_store"));
+    ASSERT_TRUE(query.next());
+    EXPECT_EQ(2, query.value(0).toInt());
+}
+
+TEST_F(DbConnectionPoolTest, SqlQueryCache) {
+    const mixxx::DbConnectionPooler pooler(m_mixxxDb.connectionPool());
+    const QSqlDatabase database = mixxx::DbConnectionPooled(m_mixxxDb.connectionPool());
+    const QString statement = QStringLiteral("SELECT :value");
+
+    QSqlQuery query1 = SqlQueryCache::prepare(database, statement);
+    query1.bindValue(":value", 1);
+    ASSERT_TRUE(query1.exec());
+    ASSERT_TRUE(query1.next());
+
+    // The cached query is still active
+    QSqlQuery query2 = SqlQueryCache::prepare(database, statement);
+    EXPECT_FALSE(query2.boundValue(":value").isValid());
+    query2.bindValue(":value", 2);
+    ASSERT_TRUE(query2.exec());
+    ASSERT_TRUE(query2.next());
+    EXPECT_EQ(2, query2.value(0).toInt());
+    EXPECT_EQ(1, query1.value(0).toInt());
+
+    // The cached query is reused after it has been finished
+    query1.finish();
+    QSqlQuery query3 = SqlQueryCache::prepare(database, statement);
+    EXPECT_EQ(1, query3.boundValue(":value").toInt());
+}
+
+namespace {
+
+// Measures the latency of reads while another thread continuously
+// writes into the database. Readers are blocked by writers with a
+// rollback journal, but not with a write-ahead log.
+static void BM_DbConnectionPoolReadWhileWriting(benchmark::State& state) {
+    // The database file is created next to the settings file
+    const QTemporaryDir settingsDir;
+    const UserSettingsPointer pConfig(new UserSettings(
+            QDir(settingsDir.path()).filePath("test.cfg")));
+    pConfig->setValue(
+            ConfigKey("[Library]", "SqliteJournalMode"),
+            QString(state.range(0) ? "WAL" : "DELETE"));
+    const MixxxDb mixxxDb(pConfig);
+    const auto pDbConnectionPool = mixxxDb.connectionPool();
+    const mixxx::DbConnectionPooler pooler(pDbConnectionPool);
+    const QSqlDatabase database = mixxx::DbConnectionPooled(pDbConnectionPool);
+    if (!MixxxDb::initDatabaseSchema(database)) {
+        state.SkipWithError("Failed to initialize the database schema");
+        return;
+    }
+
+    std::atomic<bool> stopWriting(false);
+    std::atomic<int> writeCount(0);
+    std::thread writer([&pDbConnectionPool, &stopWriting, &writeCount] {
+        const mixxx::DbConnectionPooler writerPooler(pDbConnectionPool);
+        const QSqlDatabase writerDatabase =
+                mixxx::DbConnectionPooled(pDbConnectionPool);
+        int row = 0;
+        while (!stopWriting.load()) {
+            SqlTransaction transaction(writerDatabase);
+            QSqlQuery query = SqlQueryCache::prepare(writerDatabase,
+                    "INSERT INTO track_locations "
+                    "(location,directory,filename,filesize,fs_deleted,needs_verification) "
+                    "VALUES (:location,:directory,:filename,1000000,0,0)");
+            for (int i = 0; i < 10; ++i, ++row) {
+                const QString filename = QString("track%1.mp3").arg(row);
+                const QString directory = QString("/music/dir%1").arg(row % 100);
+                query.bindValue(":location", directory + "/" + filename);
+                query.bindValue(":directory", directory);
+                query.bindValue(":filename", filename);
+                query.exec();
+            }
+            query.finish();
+            transaction.commit();
+            ++writeCount;
+        }
+    });
+
+    QSqlQuery query = SqlQueryCache::prepare(database,
+            "SELECT COUNT(*) FROM track_locations WHERE directory=:directory");
+    int iteration = 0;
+    for (auto _ : state) {
+        query.bindValue(":directory", QString("/music/dir%1").arg(iteration++ % 100));
+        if (query.exec() && query.next()) {
+            benchmark::DoNotOptimize(query.value(0).toInt());
+        }
+        query.finish();
+    }
+
+    stopWriting.store(true);
+    writer.join();
+    state.counters["write_tx_per_s"] = benchmark::Counter(
+            writeCount.load(), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_DbConnectionPoolReadWhileWriting)
+        ->Arg(0)
+        ->Arg(1)
+        ->UseRealTime();
+
+} // anonymous namespace
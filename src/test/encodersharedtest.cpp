@@ -0,0 +1,216 @@
+#include <gtest/gtest.h>
+
+#include <QtEndian>
+
+#include <vector>
+
+#include "encoder/encodercallback.h"
+#include "encoder/encodershared.h"
+#include "engine/sidechain/enginenetworkstream.h"
+#include "recording/defs_recording.h"
+
+namespace {
+
+constexpr int kSampleRate = 44100;
+constexpr int kBufferSize = 2048; // stereo samples
+
+class TestEncoderSettings : public EncoderSettings {
+  public:
+    explicit TestEncoderSettings(int quality)
+            : m_quality(quality) {
+    }
+    int getQuality() const override {
+        return m_quality;
+    }
+    ChannelMode getChannelMode() const override {
+        return ChannelMode::STEREO;
+    }
+    QString getFormat() const override {
+        return ENCODING_OGG;
+    }
+
+  private:
+    const int m_quality;
+};
+
+class RecordingCallback : public EncoderCallback {
+  public:
+    void write(const unsigned char* header, const unsigned char* body,
+            int headerLen, int bodyLen) override {
+        QByteArray packet;
+        packet.append(reinterpret_cast<const char*>(header), headerLen);
+        packet.append(reinterpret_cast<const char*>(body), bodyLen);
+        m_packets.push_back(packet);
+    }
+    int tell() override {
+        return -1;
+    }
+    void seek(int pos) override {
+        Q_UNUSED(pos);
+    }
+    int filelen() override {
+        return 0;
+    }
+
+    std::vector<QByteArray> m_packets;
+};
+
+qint64 oggGranulePos(const QByteArray& page) {
+    return qFromLittleEndian<qint64>(page.constData() + 6);
+}
+
+// The pages of Ogg streams only differ by their random serial number
+// if the same samples have been encoded
+std::vector<qint64> oggGranulePositions(const std::vector<QByteArray>& pages) {
+    std::vector<qint64> granulePositions;
+    for (const auto& page : pages) {
+        granulePositions.push_back(oggGranulePos(page));
+    }
+    return granulePositions;
+}
+
+class EncoderSharedTest : public testing::Test {
+  protected:
+    EncoderSharedTest()
+            : m_pNetworkStream(new EngineNetworkStream(2, 0)),
+              m_samples(kBufferSize) {
+        for (int i = 0; i < kBufferSize; ++i) {
+            m_samples[i] = static_cast<CSAMPLE>((i % 100) / 100.0 - 0.5);
+        }
+    }
+
+    EncoderPointer createEncoder(EncoderCallback* pCallback, int quality = 128) {
+        auto pEncoder = EncoderShared::create(
+                std::make_shared<TestEncoderSettings>(quality),
+                pCallback,
+                m_pNetworkStream);
+        EXPECT_EQ(0, pEncoder->initEncoder(kSampleRate, QString()));
+        return pEncoder;
+    }
+
+    // Passes the next buffer of the master mix to the taps of all
+    // encoding streams like SoundDeviceNetwork
+    void feedTaps() {
+        for (const auto& pWorker : m_pNetworkStream->outputWorkers()) {
+            if (!pWorker) {
+                continue;
+            }
+            auto pFifo = pWorker->getOutputFifo();
+            ASSERT_TRUE(pFifo);
+            EXPECT_EQ(kBufferSize, pFifo->write(m_samples.data(), kBufferSize));
+        }
+    }
+
+    int tapCount() {
+        int count = 0;
+        for (const auto& pWorker : m_pNetworkStream->outputWorkers()) {
+            if (pWorker) {
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    QSharedPointer<EngineNetworkStream> m_pNetworkStream;
+    std::vector<CSAMPLE> m_samples;
+};
+
+TEST_F(EncoderSharedTest, IdenticalSettingsShareStream) {
+    RecordingCallback callback1;
+    RecordingCallback callback2;
+    RecordingCallback callback3;
+    auto pEncoder1 = createEncoder(&callback1);
+    auto pEncoder2 = createEncoder(&callback2);
+    EXPECT_EQ(1, EncoderShared::streamCount());
+    auto pEncoder3 = createEncoder(&callback3, 64);
+    EXPECT_EQ(2, EncoderShared::streamCount());
+    EXPECT_EQ(2, tapCount());
+
+    for (int i = 0; i < 100; ++i) {
+        feedTaps();
+        pEncoder1->encodeBuffer(m_samples.data(), kBufferSize);
+        pEncoder2->encodeBuffer(m_samples.data(), kBufferSize);
+        pEncoder3->encodeBuffer(m_samples.data(), kBufferSize);
+    }
+    ASSERT_FALSE(callback1.m_packets.empty());
+    EXPECT_EQ(callback1.m_packets, callback2.m_packets);
+    EXPECT_NE(callback1.m_packets, callback3.m_packets);
+
+    pEncoder1.reset();
+    pEncoder2.reset();
+    pEncoder3.reset();
+    EXPECT_EQ(0, EncoderShared::streamCount());
+    EXPECT_EQ(0, tapCount());
+}
+
+TEST_F(EncoderSharedTest, EncodeEachSampleOnce) {
+    // The connections are woken up independently. The 2nd connection
+    // lags behind and the samples it passes differ from those of the
+    // 1st connection, e.g. due to its own drift compensation.
+    RecordingCallback callback1;
+    RecordingCallback callback2;
+    auto pEncoder1 = createEncoder(&callback1);
+    auto pEncoder2 = createEncoder(&callback2);
+    const std::vector<CSAMPLE> silence(kBufferSize);
+    for (int i = 0; i < 100; ++i) {
+        feedTaps();
+        pEncoder1->encodeBuffer(m_samples.data(), kBufferSize);
+        if (i % 7 == 0) {
+            pEncoder2->encodeBuffer(silence.data(), kBufferSize / 2);
+        }
+    }
+    pEncoder2->encodeBuffer(silence.data(), kBufferSize / 2);
+    ASSERT_FALSE(callback1.m_packets.empty());
+    EXPECT_EQ(callback1.m_packets, callback2.m_packets);
+    pEncoder1.reset();
+    pEncoder2.reset();
+
+    // A single connection that is woken up less often encodes the
+    // same samples
+    RecordingCallback callback3;
+    auto pEncoder3 = createEncoder(&callback3);
+    for (int i = 0; i < 100; ++i) {
+        feedTaps();
+        if (i % 10 == 9) {
+            pEncoder3->encodeBuffer(silence.data(), kBufferSize);
+        }
+    }
+    EXPECT_EQ(oggGranulePositions(callback1.m_packets),
+            oggGranulePositions(callback3.m_packets));
+}
+
+TEST_F(EncoderSharedTest, ReplayOggHeadersWhenJoining) {
+    RecordingCallback callback1;
+    auto pEncoder1 = createEncoder(&callback1);
+    for (int i = 0; i < 100; ++i) {
+        feedTaps();
+        pEncoder1->encodeBuffer(m_samples.data(), kBufferSize);
+    }
+    int headerPageCount = 0;
+    while (oggGranulePos(callback1.m_packets[headerPageCount]) == 0) {
+        ++headerPageCount;
+    }
+    ASSERT_GT(headerPageCount, 0);
+    const auto packetCount = callback1.m_packets.size();
+
+    RecordingCallback callback2;
+    auto pEncoder2 = createEncoder(&callback2);
+    for (int i = 0; i < 100; ++i) {
+        feedTaps();
+        pEncoder1->encodeBuffer(m_samples.data(), kBufferSize);
+        pEncoder2->encodeBuffer(m_samples.data(), kBufferSize);
+    }
+    ASSERT_GT(callback1.m_packets.size(), packetCount);
+    ASSERT_EQ(headerPageCount + callback1.m_packets.size() - packetCount,
+            callback2.m_packets.size());
+    // Header pages first, followed by the pages of the current position
+    for (int i = 0; i < headerPageCount; ++i) {
+        EXPECT_EQ(callback1.m_packets[i], callback2.m_packets[i]);
+    }
+    for (std::size_t i = packetCount; i < callback1.m_packets.size(); ++i) {
+        EXPECT_EQ(callback1.m_packets[i],
+                callback2.m_packets[headerPageCount + i - packetCount]);
+    }
+}
+
+} // anonymous namespace
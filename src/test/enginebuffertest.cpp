@@ -1,5 +1,6 @@
 // Tests for enginebuffer.cpp
 
+#include <benchmark/benchmark.h>
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 #include <QtDebug>
@@ -12,6 +13,7 @@
 #include "test/mixxxtest.h"
 #include "test/signalpathtest.h"
 #include "engine/controls/ratecontrol.h"
+#include "util/realtimecheck.h"
 
 // In case any of the test in this file fail. You can use the audioplot.py tool
 // in the tools folder to visually compare the results of the enginebuffer
@@ -236,6 +238,25 @@ TEST_F(EngineBufferE2ETest, BasicProcessingTest) {
                                  kProcessBufferSize, "BasicProcessingTestPause");
 }
 
+TEST_F(EngineBufferE2ETest, PlaybackIsRealtimeSafe) {
+    if (!mixxx::RealtimeAudit::isEnabled()) {
+        GTEST_SKIP() << "Real-time violations are only detected on Linux with glibc";
+    }
+    ControlObject::set(ConfigKey(m_sGroup1, "rate"), 0.05);
+    ControlObject::set(ConfigKey(m_sGroup1, "play"), 1.0);
+    ControlObject::set(ConfigKey(m_sGroup2, "play"), 1.0);
+    // Starting playback is allowed to allocate once
+    ProcessBuffer();
+    ProcessBuffer();
+
+    mixxx::RealtimeAudit::reset();
+    for (int i = 0; i < 50; ++i) {
+        ProcessBuffer();
+    }
+    EXPECT_EQ(0, mixxx::RealtimeAudit::count())
+            << mixxx::RealtimeAudit::report().toStdString();
+}
+
 TEST_F(EngineBufferE2ETest, ScratchTest) {
     // Confirm that vinyl scratching smoothly transitions from one direction
     // to the other.
@@ -526,3 +547,21 @@ TEST_F(EngineBufferTest, RatePermTest) {
     ControlObject::set(ConfigKey(m_sGroup1, "rate_perm_up_small"), 0);
     EXPECT_EQ(1.06, m_pChannel1->getEngineBuffer()->m_speed_old);
 }
+
+// Measures the callback time of a single playing deck, which includes
+// reading the controls of EngineBuffer and all of its EngineControls
+static void BM_EngineBufferProcess(benchmark::State& state) {
+    // 128 stereo frames
+    constexpr int kBufferSize = 256;
+    MixxxTestFixture<SignalPathTest> engine;
+    EngineBuffer* pEngineBuffer = engine.m_pChannel1->getEngineBuffer();
+    // Don't stop at the end of the track
+    ControlObject::set(ConfigKey(engine.m_sGroup1, "repeat"), 1.0);
+    ControlObject::set(ConfigKey(engine.m_sGroup1, "play"), 1.0);
+    std::vector<CSAMPLE> buffer(kBufferSize);
+    for (auto _ : state) {
+        pEngineBuffer->process(buffer.data(), kBufferSize);
+        pEngineBuffer->postProcess(kBufferSize);
+    }
+}
+BENCHMARK(BM_EngineBufferProcess)->Unit(benchmark::kMicrosecond);
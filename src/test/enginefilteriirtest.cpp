@@ -0,0 +1,142 @@
+#include <benchmark/benchmark.h>
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "engine/filters/enginefilterbessel4.h"
+#include "engine/filters/enginefilterbutterworth8.h"
+#include "engine/filters/enginefilterlinkwitzriley8.h"
+#include "util/sample.h"
+
+namespace {
+
+constexpr int kSampleRate = 44100;
+constexpr int kBufferSize = 1024; // stereo samples
+
+// Processes both channels separately with scalar doubles like the
+// filters did before the channels have been batched into SIMD lanes.
+template<typename Filter, unsigned int SIZE>
+class ScalarReferenceFilter : public Filter {
+  public:
+    template<typename... Args>
+    explicit ScalarReferenceFilter(Args... args)
+            : Filter(args...) {
+        this->assumeSettled();
+        std::fill(m_bufLeft, m_bufLeft + SIZE, 0.0);
+        std::fill(m_bufRight, m_bufRight + SIZE, 0.0);
+    }
+
+    void processScalar(const CSAMPLE* pIn, CSAMPLE* pOutput, int iBufferSize) {
+        for (int i = 0; i < iBufferSize; i += 2) {
+            pOutput[i] = static_cast<CSAMPLE>(
+                    Filter::processSample(this->m_coef, m_bufLeft, double(pIn[i])));
+            pOutput[i + 1] = static_cast<CSAMPLE>(
+                    Filter::processSample(this->m_coef, m_bufRight, double(pIn[i + 1])));
+        }
+    }
+
+  private:
+    double m_bufLeft[SIZE];
+    double m_bufRight[SIZE];
+};
+
+std::vector<CSAMPLE> noise(int size) {
+    std::vector<CSAMPLE> samples(size);
+    unsigned int seed = 1;
+    for (auto& sample : samples) {
+        // Deterministic LCG, independent of the platform
+        seed = seed * 1103515245 + 12345;
+        sample = static_cast<CSAMPLE>((seed >> 16) & 0x7fff) / 16384.0f - 1.0f;
+    }
+    return samples;
+}
+
+class EngineFilterIIRTest : public testing::Test {
+  protected:
+    template<typename Filter, unsigned int SIZE, typename... Args>
+    void expectStereoMatchesScalar(Args... args) {
+        Filter stereoFilter(args...);
+        stereoFilter.assumeSettled();
+        ScalarReferenceFilter<Filter, SIZE> scalarFilter(args...);
+
+        const std::vector<CSAMPLE> input = noise(kBufferSize);
+        std::vector<CSAMPLE> expected(kBufferSize);
+        std::vector<CSAMPLE> actual(kBufferSize);
+        // Multiple buffers to verify that the state is carried over
+        for (int n = 0; n < 4; ++n) {
+            scalarFilter.processScalar(input.data(), expected.data(), kBufferSize);
+            stereoFilter.process(input.data(), actual.data(), kBufferSize);
+            for (int i = 0; i < kBufferSize; ++i) {
+                // The operations are identical and results should be
+                // bit-exact. A small tolerance permits the compiler to
+                // contract multiplications and additions differently.
+                EXPECT_NEAR(expected[i], actual[i], 1e-6f) << "buffer " << n << ", sample " << i;
+            }
+        }
+    }
+};
+
+TEST_F(EngineFilterIIRTest, Butterworth8MatchesScalar) {
+    expectStereoMatchesScalar<EngineFilterButterworth8Low, 8>(kSampleRate, 246.0);
+    expectStereoMatchesScalar<EngineFilterButterworth8Band, 16>(kSampleRate, 246.0, 2484.0);
+    expectStereoMatchesScalar<EngineFilterButterworth8High, 8>(kSampleRate, 2484.0);
+}
+
+TEST_F(EngineFilterIIRTest, LinkwitzRiley8MatchesScalar) {
+    expectStereoMatchesScalar<EngineFilterLinkwitzRiley8Low, 8>(kSampleRate, 246.0);
+    expectStereoMatchesScalar<EngineFilterLinkwitzRiley8High, 8>(kSampleRate, 2484.0);
+}
+
+TEST_F(EngineFilterIIRTest, Bessel4MatchesScalar) {
+    expectStereoMatchesScalar<EngineFilterBessel4Low, 4>(kSampleRate, 600.0);
+    expectStereoMatchesScalar<EngineFilterBessel4Band, 8>(kSampleRate, 600.0, 4000.0);
+    expectStereoMatchesScalar<EngineFilterBessel4High, 4>(kSampleRate, 4000.0);
+}
+
+TEST_F(EngineFilterIIRTest, IndependentChannels) {
+    EngineFilterButterworth8Band filter(kSampleRate, 246.0, 2484.0);
+    filter.assumeSettled();
+    std::vector<CSAMPLE> input = noise(kBufferSize);
+    // Silence the right channel
+    for (int i = 1; i < kBufferSize; i += 2) {
+        input[i] = 0;
+    }
+    std::vector<CSAMPLE> output(kBufferSize);
+    filter.process(input.data(), output.data(), kBufferSize);
+    for (int i = 1; i < kBufferSize; i += 2) {
+        EXPECT_EQ(0, output[i]);
+    }
+}
+
+template<typename Filter, unsigned int SIZE>
+static void BM_EngineFilterIIRScalar(benchmark::State& state) {
+    const int size = state.range(0);
+    ScalarReferenceFilter<Filter, SIZE> filter(kSampleRate, 246.0, 2484.0);
+    const std::vector<CSAMPLE> input = noise(size);
+    std::vector<CSAMPLE> output(size);
+    for (auto _ : state) {
+        filter.processScalar(input.data(), output.data(), size);
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.SetItemsProcessed(state.iterations() * size);
+}
+BENCHMARK_TEMPLATE(BM_EngineFilterIIRScalar, EngineFilterButterworth8Band, 16)
+        ->Range(64, 4096);
+
+template<typename Filter>
+static void BM_EngineFilterIIRStereo(benchmark::State& state) {
+    const int size = state.range(0);
+    Filter filter(kSampleRate, 246.0, 2484.0);
+    filter.assumeSettled();
+    const std::vector<CSAMPLE> input = noise(size);
+    std::vector<CSAMPLE> output(size);
+    for (auto _ : state) {
+        filter.process(input.data(), output.data(), size);
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.SetItemsProcessed(state.iterations() * size);
+}
+BENCHMARK_TEMPLATE(BM_EngineFilterIIRStereo, EngineFilterButterworth8Band)
+        ->Range(64, 4096);
+
+} // anonymous namespace
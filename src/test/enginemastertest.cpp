@@ -1,14 +1,18 @@
+#include <benchmark/benchmark.h>
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
 #include <QtDebug>
 
+#include <cmath>
+
 #include "control/controlproxy.h"
 #include "engine/channels/enginechannel.h"
 #include "engine/enginemaster.h"
 #include "test/mixxxtest.h"
 #include "test/signalpathtest.h"
 #include "util/defs.h"
+#include "util/realtimecheck.h"
 #include "util/sample.h"
 #include "util/types.h"
 
@@ -391,4 +395,87 @@ TEST_F(EngineMasterTest, ThreeChannelPFLOutputWorks) {
     assertHeadphoneBufferMatchesGolden(testName);
 }
 
+// Burns a fixed amount of CPU time per callback, roughly like a deck
+// with keylock enabled.
+class BusyChannel : public EngineChannel {
+  public:
+    BusyChannel(const QString& group, EngineMaster* pMaster)
+            : EngineChannel(pMaster->registerChannelGroup(group), EngineChannel::CENTER, nullptr, /*isTalkoverChannel*/ false, /*isPrimarydeck*/ true) {
+    }
+
+    bool isActive() override {
+        return true;
+    }
+    bool isMasterEnabled() const override {
+        return true;
+    }
+    bool isPflEnabled() const override {
+        return false;
+    }
+
+    void process(CSAMPLE* pOut, const int iBufferSize) override {
+        constexpr int kPasses = 16;
+        for (int pass = 0; pass < kPasses; ++pass) {
+            CSAMPLE state = 0;
+            for (int i = 0; i < iBufferSize; ++i) {
+                state = 0.99f * state + 0.01f * std::sin(static_cast<CSAMPLE>(i + pass));
+                pOut[i] = state;
+            }
+        }
+    }
+
+    void collectFeatures(GroupFeatureState* pGroupFeatures) const override {
+        Q_UNUSED(pGroupFeatures);
+    }
+
+    void postProcess(const int iBufferSize) override {
+        Q_UNUSED(iBufferSize);
+    }
+};
+
+TEST_F(EngineMasterTest, ProcessIsRealtimeSafe) {
+    if (!mixxx::RealtimeAudit::isEnabled()) {
+        GTEST_SKIP() << "Real-time violations are only detected on Linux with glibc";
+    }
+    constexpr int kBufferSize = 256;
+    for (int i = 0; i < 4; ++i) {
+        m_pEngineMaster->addChannel(new BusyChannel(
+                QString("[Busy%1]").arg(i + 1), m_pEngineMaster));
+    }
+    // The first callbacks may allocate, e.g. to name the thread
+    m_pEngineMaster->process(kBufferSize);
+    m_pEngineMaster->process(kBufferSize);
+
+    mixxx::RealtimeAudit::reset();
+    for (int i = 0; i < 100; ++i) {
+        m_pEngineMaster->process(kBufferSize);
+    }
+    EXPECT_EQ(0, mixxx::RealtimeAudit::count())
+            << mixxx::RealtimeAudit::report().toStdString();
+}
+
+// Measures the callback wall time depending on the number of decks,
+// with serial (0) or parallel (1) channel processing
+static void BM_EngineMasterProcessChannels(benchmark::State& state) {
+    // 128 stereo frames
+    constexpr int kBufferSize = 256;
+    const int deckCount = static_cast<int>(state.range(0));
+    MixxxTestFixture<EngineMasterTest> engine;
+    for (int i = 0; i < deckCount; ++i) {
+        engine.m_pEngineMaster->addChannel(new BusyChannel(
+                QString("[Busy%1]").arg(i + 1), engine.m_pEngineMaster));
+    }
+    ControlObject::set(ConfigKey("[Master]", "parallel_channels"),
+            static_cast<double>(state.range(1)));
+    for (auto _ : state) {
+        engine.m_pEngineMaster->process(kBufferSize);
+    }
+}
+BENCHMARK(BM_EngineMasterProcessChannels)
+        ->RangeMultiplier(2)
+        ->Ranges({{1, 8}, {0, 1}})
+        ->ArgNames({"decks", "parallel"})
+        ->Unit(benchmark::kMicrosecond)
+        ->UseRealTime();
+
 }  // namespace
@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+
+#include <QMutex>
+#include <QSet>
+
+#include <atomic>
+#include <vector>
+
+#include "engine/engineparallelexecutor.h"
+
+namespace {
+
+class CountingTask : public EngineParallelExecutor::Task {
+  public:
+    explicit CountingTask(int count)
+            : m_runs(count) {
+        for (auto& runs : m_runs) {
+            runs.store(0);
+        }
+    }
+
+    void run(int index) override {
+        m_runs[index].fetch_add(1);
+        QMutexLocker locker(&m_threadsMutex);
+        m_threads.insert(QThread::currentThread());
+    }
+
+    int runs(int index) const {
+        return m_runs[index].load();
+    }
+
+    QSet<QThread*> threads() {
+        QMutexLocker locker(&m_threadsMutex);
+        return m_threads;
+    }
+
+  private:
+    std::vector<std::atomic<int>> m_runs;
+    QMutex m_threadsMutex;
+    QSet<QThread*> m_threads;
+};
+
+TEST(EngineParallelExecutorTest, RunsEachIndexOnce) {
+    constexpr int kCount = 8;
+    constexpr int kExecutions = 1000;
+    EngineParallelExecutor executor(3);
+    executor.start();
+
+    CountingTask task(kCount);
+    for (int i = 0; i < kExecutions; ++i) {
+        executor.execute(&task, kCount);
+    }
+    for (int index = 0; index < kCount; ++index) {
+        EXPECT_EQ(kExecutions, task.runs(index));
+    }
+    EXPECT_TRUE(task.threads().contains(QThread::currentThread()));
+}
+
+TEST(EngineParallelExecutorTest, AlternatingCounts) {
+    // Late helper threads must not run units of the previous task
+    EngineParallelExecutor executor(2);
+    executor.start();
+
+    CountingTask smallTask(2);
+    CountingTask largeTask(5);
+    for (int i = 0; i < 500; ++i) {
+        executor.execute(&smallTask, 2);
+        executor.execute(&largeTask, 5);
+    }
+    for (int index = 0; index < 2; ++index) {
+        EXPECT_EQ(500, smallTask.runs(index));
+    }
+    for (int index = 0; index < 5; ++index) {
+        EXPECT_EQ(500, largeTask.runs(index));
+    }
+}
+
+TEST(EngineParallelExecutorTest, WithoutHelperThreads) {
+    EngineParallelExecutor executor(0);
+    executor.start();
+
+    CountingTask task(4);
+    executor.execute(&task, 4);
+    for (int index = 0; index < 4; ++index) {
+        EXPECT_EQ(1, task.runs(index));
+    }
+    EXPECT_EQ(QSet<QThread*>{QThread::currentThread()}, task.threads());
+}
+
+} // anonymous namespace
@@ -0,0 +1,152 @@
+#include <gtest/gtest.h>
+
+#include <QElapsedTimer>
+#include <QThread>
+
+#include <atomic>
+#include <vector>
+
+#include "engine/sidechain/enginesidechain.h"
+#include "engine/sidechain/sidechainringbuffer.h"
+#include "util/sample.h"
+
+namespace {
+
+constexpr int kFramesPerBuffer = 512;
+constexpr int kSamplesPerBuffer = kFramesPerBuffer * 2;
+constexpr int kTimeoutMillis = 5000;
+
+// Verifies that all samples are received in order
+class RecordingWorker : public SideChainWorker {
+  public:
+    RecordingWorker()
+            : m_processedSamples(0),
+              m_mismatchedSamples(0) {
+    }
+
+    void process(const CSAMPLE* pBuffer, const int iBufferSize) override {
+        int processedSamples = m_processedSamples.load();
+        for (int i = 0; i < iBufferSize; ++i) {
+            if (pBuffer[i] != static_cast<CSAMPLE>(processedSamples + i)) {
+                m_mismatchedSamples.fetch_add(1);
+            }
+        }
+        m_processedSamples.store(processedSamples + iBufferSize);
+    }
+
+    void shutdown() override {
+    }
+
+    int processedSamples() const {
+        return m_processedSamples.load();
+    }
+
+    int mismatchedSamples() const {
+        return m_mismatchedSamples.load();
+    }
+
+  private:
+    std::atomic<int> m_processedSamples;
+    std::atomic<int> m_mismatchedSamples;
+};
+
+// Takes much more time than available for processing the samples,
+// e.g. like an encoder that is blocked by a slow network write
+class SlowWorker : public SideChainWorker {
+  public:
+    void process(const CSAMPLE* pBuffer, const int iBufferSize) override {
+        Q_UNUSED(pBuffer);
+        Q_UNUSED(iBufferSize);
+        QThread::msleep(500);
+    }
+
+    void shutdown() override {
+    }
+};
+
+class EngineSideChainTest : public testing::Test {
+  protected:
+    EngineSideChainTest()
+            : m_pSidechainMix(SampleUtil::alloc(kSamplesPerBuffer)) {
+    }
+    ~EngineSideChainTest() override {
+        SampleUtil::free(m_pSidechainMix);
+    }
+
+    // Simulates the engine callback that writes ascending sample values
+    void writeBuffers(EngineSideChain* pSideChain, int bufferCount) {
+        std::vector<CSAMPLE> buffer(kSamplesPerBuffer);
+        for (int n = 0; n < bufferCount; ++n) {
+            for (int i = 0; i < kSamplesPerBuffer; ++i) {
+                buffer[i] = static_cast<CSAMPLE>(n * kSamplesPerBuffer + i);
+            }
+            pSideChain->writeSamples(buffer.data(), kFramesPerBuffer);
+            QThread::msleep(1);
+        }
+    }
+
+    CSAMPLE* m_pSidechainMix;
+};
+
+TEST_F(EngineSideChainTest, RingBufferReadersAreIndependent) {
+    SideChainRingBuffer ringBuffer(16);
+    SideChainRingBuffer::Reader fastReader(&ringBuffer);
+    SideChainRingBuffer::Reader slowReader(&ringBuffer);
+    std::vector<CSAMPLE> samples(12);
+    for (int i = 0; i < 12; ++i) {
+        samples[i] = static_cast<CSAMPLE>(i);
+    }
+    std::vector<CSAMPLE> buffer(16);
+
+    ringBuffer.write(samples.data(), 12);
+    EXPECT_EQ(12, fastReader.read(buffer.data(), 16));
+    EXPECT_EQ(0, fastReader.read(buffer.data(), 16));
+
+    // Overwrites the first 8 samples that have not been read by the
+    // slow reader
+    ringBuffer.write(samples.data(), 12);
+    EXPECT_EQ(12, fastReader.lag());
+    EXPECT_EQ(24, slowReader.lag());
+    EXPECT_EQ(12, fastReader.read(buffer.data(), 16));
+    EXPECT_EQ(0, fastReader.overflowCount());
+    EXPECT_EQ(16, slowReader.read(buffer.data(), 16));
+    EXPECT_EQ(8, slowReader.overflowCount());
+    EXPECT_EQ(8, buffer[0]);
+    EXPECT_EQ(11, buffer[3]);
+    EXPECT_EQ(0, buffer[4]);
+    EXPECT_EQ(11, buffer[15]);
+}
+
+TEST_F(EngineSideChainTest, SlowWorkerDoesNotStallRecording) {
+    EngineSideChain sideChain(UserSettingsPointer(), m_pSidechainMix);
+    // Owned by the sidechain
+    auto* pSlowWorker = new SlowWorker();
+    sideChain.addSideChainWorker(pSlowWorker);
+    auto* pRecordingWorker = new RecordingWorker();
+    sideChain.addSideChainWorker(pRecordingWorker);
+
+    // Much more samples than the capacity of the buffer
+    constexpr int kBufferCount =
+            4 * EngineSideChain::SIDECHAIN_BUFFER_SIZE / kSamplesPerBuffer;
+    writeBuffers(&sideChain, kBufferCount);
+
+    QElapsedTimer timer;
+    timer.start();
+    while (pRecordingWorker->processedSamples() < kBufferCount * kSamplesPerBuffer &&
+            timer.elapsed() < kTimeoutMillis) {
+        QThread::msleep(10);
+    }
+
+    EXPECT_EQ(kBufferCount * kSamplesPerBuffer, pRecordingWorker->processedSamples());
+    EXPECT_EQ(0, pRecordingWorker->mismatchedSamples());
+    const auto recordingStats = sideChain.getWorkerStats(pRecordingWorker);
+    EXPECT_EQ(0, recordingStats.lagSamples);
+    EXPECT_EQ(0, recordingStats.overflowSamples);
+
+    // The slow worker has missed samples
+    const auto slowStats = sideChain.getWorkerStats(pSlowWorker);
+    EXPECT_GT(slowStats.overflowSamples + slowStats.lagSamples,
+            EngineSideChain::SIDECHAIN_BUFFER_SIZE);
+}
+
+} // anonymous namespace
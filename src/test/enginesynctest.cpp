@@ -2306,3 +2306,28 @@ TEST_F(EngineSyncTest, BpmAdjustFactor) {
     ASSERT_TRUE(isFollower(m_sGroup2));
     ASSERT_TRUE(isSoftMaster(m_sInternalClockGroup));
 }
+
+TEST_F(EngineSyncTest, SyncRequestsOfConcurrentlyProcessedDecksAreDeferred) {
+    EngineBuffer* pBuffer1 = m_pChannel1->getEngineBuffer();
+    EngineBuffer* pBuffer2 = m_pChannel2->getEngineBuffer();
+    EXPECT_FALSE(pBuffer1->isSyncInvolved());
+    EXPECT_FALSE(pBuffer2->isSyncInvolved());
+
+    // The request is queued while the deck is playing
+    ControlObject::set(ConfigKey(m_sGroup1, "play"), 1.0);
+    ProcessBuffer();
+    pBuffer1->requestEnableSync(true);
+    EXPECT_TRUE(pBuffer1->isSyncInvolved());
+    EXPECT_FALSE(pBuffer2->isSyncInvolved());
+
+    // A deck that is processed concurrently keeps the request
+    pBuffer1->setSyncRequestsDeferred(true);
+    ProcessBuffer();
+    assertSyncOff(m_sGroup1);
+    EXPECT_TRUE(pBuffer1->isSyncInvolved());
+
+    pBuffer1->setSyncRequestsDeferred(false);
+    ProcessBuffer();
+    EXPECT_NE(SYNC_NONE, ControlObject::get(ConfigKey(m_sGroup1, "sync_mode")));
+    EXPECT_TRUE(pBuffer1->isSyncInvolved());
+}
@@ -0,0 +1,280 @@
+#include <gtest/gtest.h>
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QSet>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "engine/engineworker.h"
+#include "engine/engineworkerscheduler.h"
+
+namespace {
+
+constexpr int kTimeoutMillis = 5000;
+
+class CountingWorker : public EngineWorker {
+  public:
+    explicit CountingWorker(int unitsOfWork = 1)
+            : m_unitsOfWork(unitsOfWork),
+              m_pendingUnits(0),
+              m_processedUnits(0),
+              m_concurrentRuns(0),
+              m_overlappingRuns(0) {
+    }
+
+    void addWork() {
+        m_pendingUnits.fetch_add(m_unitsOfWork);
+        workReady();
+    }
+
+    bool processWork() override {
+        if (m_concurrentRuns.fetch_add(1) > 0) {
+            m_overlappingRuns.fetch_add(1);
+        }
+        {
+            QMutexLocker locker(&m_threadsMutex);
+            m_threads.insert(QThread::currentThread());
+        }
+        bool workDone = false;
+        int pendingUnits = m_pendingUnits.load();
+        while (pendingUnits > 0) {
+            if (m_pendingUnits.compare_exchange_weak(pendingUnits, pendingUnits - 1)) {
+                m_processedUnits.fetch_add(1);
+                workDone = true;
+                break;
+            }
+        }
+        m_concurrentRuns.fetch_sub(1);
+        return workDone;
+    }
+
+    int processedUnits() const {
+        return m_processedUnits.load();
+    }
+
+    int overlappingRuns() const {
+        return m_overlappingRuns.load();
+    }
+
+    QSet<QThread*> threads() {
+        QMutexLocker locker(&m_threadsMutex);
+        return m_threads;
+    }
+
+  private:
+    const int m_unitsOfWork;
+    std::atomic<int> m_pendingUnits;
+    std::atomic<int> m_processedUnits;
+    std::atomic<int> m_concurrentRuns;
+    std::atomic<int> m_overlappingRuns;
+    QMutex m_threadsMutex;
+    QSet<QThread*> m_threads;
+};
+
+// Simulates loading a track that blocks its thread until released
+class LoadingWorker : public EngineWorker {
+  public:
+    LoadingWorker()
+            : m_loadPending(false),
+              m_loading(false),
+              m_released(false) {
+    }
+
+    void load() {
+        m_loadPending.store(true);
+        workReady();
+    }
+
+    void release() {
+        m_released.store(true);
+    }
+
+    bool hasBackgroundWork() const override {
+        return m_loadPending.load();
+    }
+
+    bool processWork() override {
+        if (!m_loadPending.load()) {
+            return false;
+        }
+        if (!isBackgroundWorkAllowed()) {
+            // Stays pending for a background thread
+            return true;
+        }
+        m_loading.store(true);
+        while (!m_released.load()) {
+            QThread::msleep(1);
+        }
+        m_loadPending.store(false);
+        m_loading.store(false);
+        return false;
+    }
+
+    bool isLoading() const {
+        return m_loading.load();
+    }
+
+  private:
+    std::atomic<bool> m_loadPending;
+    std::atomic<bool> m_loading;
+    std::atomic<bool> m_released;
+};
+
+class EngineWorkerSchedulerTest : public testing::Test {
+  protected:
+    // Simulates subsequent engine callbacks until the predicate holds
+    template<typename Predicate>
+    bool runWorkersUntil(EngineWorkerScheduler* pScheduler, Predicate predicate) {
+        QElapsedTimer timer;
+        timer.start();
+        while (!predicate()) {
+            if (timer.elapsed() > kTimeoutMillis) {
+                return false;
+            }
+            pScheduler->runWorkers();
+            QThread::msleep(1);
+        }
+        return true;
+    }
+};
+
+TEST_F(EngineWorkerSchedulerTest, WorkersShareThreads) {
+    constexpr int kThreadCount = 2;
+    constexpr int kWorkerCount = 64;
+    constexpr int kUnitsOfWork = 10;
+    EngineWorkerScheduler scheduler(kThreadCount);
+    scheduler.start();
+
+    std::vector<std::unique_ptr<CountingWorker>> workers;
+    for (int i = 0; i < kWorkerCount; ++i) {
+        workers.push_back(std::make_unique<CountingWorker>(kUnitsOfWork));
+        workers.back()->setScheduler(&scheduler);
+    }
+    for (const auto& pWorker : workers) {
+        pWorker->addWork();
+    }
+
+    EXPECT_TRUE(runWorkersUntil(&scheduler, [&workers] {
+        for (const auto& pWorker : workers) {
+            if (pWorker->processedUnits() < kUnitsOfWork) {
+                return false;
+            }
+        }
+        return true;
+    }));
+
+    QSet<QThread*> threads;
+    for (const auto& pWorker : workers) {
+        EXPECT_EQ(kUnitsOfWork, pWorker->processedUnits());
+        // A worker must never run on multiple threads at once
+        EXPECT_EQ(0, pWorker->overlappingRuns());
+        threads.unite(pWorker->threads());
+    }
+    EXPECT_LE(threads.size(), scheduler.threadCount());
+    EXPECT_FALSE(threads.contains(QThread::currentThread()));
+
+    for (const auto& pWorker : workers) {
+        pWorker->stop();
+    }
+}
+
+TEST_F(EngineWorkerSchedulerTest, WorkReadyWhileRunning) {
+    EngineWorkerScheduler scheduler(1);
+    scheduler.start();
+    CountingWorker worker;
+    worker.setScheduler(&scheduler);
+
+    // Repeatedly make the worker ready while it might be running
+    constexpr int kRepetitions = 1000;
+    for (int i = 0; i < kRepetitions; ++i) {
+        worker.addWork();
+        scheduler.runWorkers();
+    }
+    EXPECT_TRUE(runWorkersUntil(&scheduler, [&worker] {
+        return worker.processedUnits() == kRepetitions;
+    }));
+
+    worker.stop();
+}
+
+TEST_F(EngineWorkerSchedulerTest, StoppedWorkerIsNotRun) {
+    EngineWorkerScheduler scheduler(2);
+    scheduler.start();
+    CountingWorker stoppedWorker;
+    stoppedWorker.setScheduler(&scheduler);
+    CountingWorker worker;
+    worker.setScheduler(&scheduler);
+
+    stoppedWorker.stop();
+    stoppedWorker.addWork();
+    worker.addWork();
+    EXPECT_TRUE(runWorkersUntil(&scheduler, [&worker] {
+        return worker.processedUnits() == 1;
+    }));
+    EXPECT_EQ(0, stoppedWorker.processedUnits());
+
+    // The slot of the stopped worker is reused
+    CountingWorker newWorker;
+    newWorker.setScheduler(&scheduler);
+    newWorker.addWork();
+    EXPECT_TRUE(runWorkersUntil(&scheduler, [&newWorker] {
+        return newWorker.processedUnits() == 1;
+    }));
+
+    worker.stop();
+    newWorker.stop();
+}
+
+TEST_F(EngineWorkerSchedulerTest, LoadingDoesNotStarveReads) {
+    constexpr int kThreadCount = 1;
+    constexpr int kBackgroundThreadCount = 2;
+    EngineWorkerScheduler scheduler(kThreadCount, kBackgroundThreadCount);
+    scheduler.start();
+
+    // Loading more samplers than there are threads
+    std::vector<std::unique_ptr<LoadingWorker>> loadingWorkers;
+    for (int i = 0; i < kThreadCount + kBackgroundThreadCount; ++i) {
+        loadingWorkers.push_back(std::make_unique<LoadingWorker>());
+        loadingWorkers.back()->setScheduler(&scheduler);
+        loadingWorkers.back()->load();
+    }
+    EXPECT_TRUE(runWorkersUntil(&scheduler, [&loadingWorkers] {
+        int loading = 0;
+        for (const auto& pWorker : loadingWorkers) {
+            if (pWorker->isLoading()) {
+                ++loading;
+            }
+        }
+        return loading == kBackgroundThreadCount;
+    }));
+
+    // The reads of a playing deck are run while all background
+    // threads are busy
+    CountingWorker readingWorker(10);
+    readingWorker.setScheduler(&scheduler);
+    readingWorker.addWork();
+    EXPECT_TRUE(runWorkersUntil(&scheduler, [&readingWorker] {
+        return readingWorker.processedUnits() == 10;
+    }));
+
+    for (const auto& pWorker : loadingWorkers) {
+        pWorker->release();
+    }
+    EXPECT_TRUE(runWorkersUntil(&scheduler, [&loadingWorkers] {
+        for (const auto& pWorker : loadingWorkers) {
+            if (pWorker->hasBackgroundWork()) {
+                return false;
+            }
+        }
+        return true;
+    }));
+    for (const auto& pWorker : loadingWorkers) {
+        pWorker->stop();
+    }
+    readingWorker.stop();
+}
+
+} // anonymous namespace
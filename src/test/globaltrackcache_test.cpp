@@ -1,7 +1,9 @@
+#include <benchmark/benchmark.h>
+
 #include <QThread>
 #include <QtDebug>
-
 #include <atomic>
+#include <thread>
 
 #include "test/mixxxtest.h"
 
@@ -33,7 +35,10 @@ class TrackTitleThread: public QThread {
             m_recentTrackPtr.reset();
             // Try to resolve the next track by guessing the id
             const TrackId trackId(loopCount % 2);
-            auto track = GlobalTrackCacheLocker().lookupTrackById(trackId);
+            // Alternate between the exclusive and the sharded lookup
+            auto track = (loopCount / 2) % 2
+                    ? GlobalTrackCache::lookupCachedTrackById(trackId)
+                    : GlobalTrackCacheLocker().lookupTrackById(trackId);
             if (track) {
                 ASSERT_EQ(trackId, track->getId());
                 // lp1744550: Accessing the track from multiple threads is
@@ -141,6 +146,61 @@ TEST_F(GlobalTrackCacheTest, resolveByFileInfo) {
     }
 }
 
+TEST_F(GlobalTrackCacheTest, lookupCachedTrack) {
+    ASSERT_TRUE(GlobalTrackCacheLocker().isEmpty());
+
+    const TrackId trackId(1);
+
+    TrackPointer track;
+    {
+        GlobalTrackCacheResolver resolver(kTestFile);
+        track = resolver.getTrack();
+        ASSERT_TRUE(static_cast<bool>(track));
+        resolver.initTrackIdAndUnlockCache(trackId);
+    }
+
+    EXPECT_EQ(track, GlobalTrackCache::lookupCachedTrackById(trackId));
+    EXPECT_EQ(track, GlobalTrackCache::lookupCachedTrackByRef(TrackRef::fromFileInfo(kTestFile)));
+    EXPECT_EQ(track, GlobalTrackCache::lookupCachedTrackByRef(TrackRef::fromFileInfo(kTestFile, trackId)));
+    EXPECT_EQ(1, track.use_count());
+
+    EXPECT_EQ(TrackPointer(), GlobalTrackCache::lookupCachedTrackById(TrackId(2)));
+    EXPECT_EQ(TrackPointer(), GlobalTrackCache::lookupCachedTrackByRef(TrackRef::fromFileInfo(kTestFile2)));
+
+    track.reset();
+    EXPECT_EQ(TrackPointer(), GlobalTrackCache::lookupCachedTrackById(trackId));
+    EXPECT_TRUE(GlobalTrackCacheLocker().isEmpty());
+}
+
+TEST_F(GlobalTrackCacheTest, lookupCachedTrackWaitsForResolver) {
+    ASSERT_TRUE(GlobalTrackCacheLocker().isEmpty());
+
+    const TrackId trackId(1);
+
+    TrackPointer track;
+    TrackPointer trackByRef;
+    std::atomic<bool> lookupFinished(false);
+    std::thread lookupThread;
+    {
+        GlobalTrackCacheResolver resolver(kTestFile);
+        track = resolver.getTrack();
+        ASSERT_TRUE(static_cast<bool>(track));
+        // The new track has no id yet and must not be found before
+        // the resolver has initialized it and unlocked the cache
+        lookupThread = std::thread([&] {
+            trackByRef = GlobalTrackCache::lookupCachedTrackByRef(
+                    TrackRef::fromFileInfo(kTestFile));
+            lookupFinished.store(true);
+        });
+        QThread::msleep(100);
+        EXPECT_FALSE(lookupFinished.load());
+        resolver.initTrackIdAndUnlockCache(trackId);
+    }
+    lookupThread.join();
+    ASSERT_EQ(track, trackByRef);
+    EXPECT_EQ(trackId, trackByRef->getId());
+}
+
 TEST_F(GlobalTrackCacheTest, concurrentDelete) {
     ASSERT_TRUE(GlobalTrackCacheLocker().isEmpty());
 
@@ -216,3 +276,63 @@ TEST_F(GlobalTrackCacheTest, evictWhileMoving) {
 
     EXPECT_TRUE(GlobalTrackCacheLocker().isEmpty());
 }
+
+namespace {
+
+class BenchmarkSaver : public GlobalTrackCacheSaver {
+  public:
+    void saveEvictedTrack(Track* pTrack) noexcept override {
+        Q_UNUSED(pTrack);
+    }
+};
+
+constexpr int kBenchmarkTrackCount = 1000;
+
+// Looks up cached tracks concurrently like the library views, the
+// analysis, and the track loader do. Compares the exclusive lock of
+// GlobalTrackCacheLocker (0) with the sharded lookup (1) and reports
+// how long all threads have been blocked while waiting for a lock.
+void BM_GlobalTrackCacheLookup(benchmark::State& state) {
+    const bool sharded = state.range(0) != 0;
+    static BenchmarkSaver s_saver;
+    static QList<TrackPointer> s_tracks;
+    if (state.thread_index == 0) {
+        GlobalTrackCache::createInstance(&s_saver, deleteTrack);
+        for (int i = 1; i <= kBenchmarkTrackCount; ++i) {
+            s_tracks.append(GlobalTrackCacheResolver(
+                    TrackFile(QString("/music/track%1.mp3").arg(i)),
+                    TrackId(i))
+                                    .getTrack());
+        }
+        GlobalTrackCache::resetLockWaitStats();
+    }
+
+    int i = state.thread_index;
+    for (auto _ : state) {
+        i = (i + 7) % kBenchmarkTrackCount;
+        const TrackId trackId(1 + i);
+        auto track = sharded
+                ? GlobalTrackCache::lookupCachedTrackById(trackId)
+                : GlobalTrackCacheLocker().lookupTrackById(trackId);
+        benchmark::DoNotOptimize(track);
+    }
+
+    if (state.thread_index == 0) {
+        const auto cacheLockWaits = GlobalTrackCache::cacheLockWaitStats();
+        const auto shardLockWaits = GlobalTrackCache::shardLockWaitStats();
+        state.counters["contended"] = benchmark::Counter(
+                static_cast<double>(cacheLockWaits.contendedCount +
+                        shardLockWaits.contendedCount));
+        state.counters["lock_wait_ms"] = benchmark::Counter(
+                (cacheLockWaits.waitTime + shardLockWaits.waitTime).toDoubleMillis());
+        s_tracks.clear();
+        GlobalTrackCache::destroyInstance();
+    }
+}
+BENCHMARK(BM_GlobalTrackCacheLookup)
+        ->Arg(0)
+        ->Arg(1)
+        ->ThreadRange(1, 8)
+        ->UseRealTime();
+
+} // anonymous namespace
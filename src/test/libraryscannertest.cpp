@@ -1,15 +1,113 @@
+#include <benchmark/benchmark.h>
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
+#include <QAtomicInt>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMutex>
+#include <QSet>
+#include <QSqlQuery>
+#include <QTemporaryDir>
+
 #include "test/librarytest.h"
 
+#include "library/queryutil.h"
 #include "library/scanner/libraryscanner.h"
+#include "sources/metadatasourcetaglib.h"
+
+namespace {
+
+const QDir kTestDir(QDir::current().absoluteFilePath("src/test/id3-test-data"));
+
+constexpr int kFilesPerDirectory = 10;
+
+} // anonymous namespace
 
 class LibraryScannerTest : public LibraryTest {
   protected:
     LibraryScannerTest()
         : m_libraryScanner(dbConnectionPool(), config()) {
     }
+
+  public:
+    // Also used by the benchmarks
+    bool addDirectory(const QString& dirPath) {
+        return internalCollection()->addDirectory(dirPath);
+    }
+
+    static bool generateTrack(const QString& fileName, int index) {
+        if (!QFile::copy(kTestDir.absoluteFilePath("empty.mp3"), fileName)) {
+            return false;
+        }
+        mixxx::TrackMetadata trackMetadata;
+        trackMetadata.refTrackInfo().setArtist(QString("Artist %1").arg(index % 3));
+        trackMetadata.refTrackInfo().setTitle(QString("Title %1").arg(index));
+        const auto exported =
+                mixxx::MetadataSourceTagLib(
+                        fileName, mixxx::taglib::FileType::MP3)
+                        .exportTrackMetadata(trackMetadata);
+        return exported.first == mixxx::MetadataSource::ExportResult::Succeeded;
+    }
+
+    // Populates a directory tree with distinctly tagged copies
+    // of a test file
+    static bool generateTracks(const QDir& rootDir, int count) {
+        for (int i = 0; i < count; ++i) {
+            const QString dirPath = QString("dir%1").arg(i / kFilesPerDirectory);
+            if (!rootDir.mkpath(dirPath)) {
+                return false;
+            }
+            const QString fileName = QDir(rootDir.absoluteFilePath(dirPath))
+                                             .absoluteFilePath(QString("track%1.mp3").arg(i));
+            if (!generateTrack(fileName, i)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Scans all library directories and blocks until the scan has finished
+    static bool scanAndWait(
+            LibraryScanner* pScanner,
+            LibraryScanner::ScanMode mode = LibraryScanner::ScanMode::Incremental) {
+        QAtomicInt finished(0);
+        const auto connection = QObject::connect(
+                pScanner,
+                &LibraryScanner::scanFinished,
+                [&finished] {
+                    finished.storeRelease(1);
+                },
+                Qt::DirectConnection);
+        pScanner->scan(mode);
+        QElapsedTimer timer;
+        timer.start();
+        while (!finished.loadAcquire() && timer.elapsed() < 60000) {
+            QCoreApplication::processEvents();
+            QThread::msleep(1);
+        }
+        QObject::disconnect(connection);
+        return finished.loadAcquire() != 0;
+    }
+
+    QStringList queryTitles() const {
+        QStringList titles;
+        QSqlQuery query(dbConnection());
+        query.prepare(
+                "SELECT library.title FROM library "
+                "INNER JOIN track_locations ON library.location=track_locations.id "
+                "WHERE track_locations.fs_deleted=0 ORDER BY library.title");
+        if (!query.exec()) {
+            LOG_FAILED_QUERY(query);
+        }
+        while (query.next()) {
+            titles.append(query.value(0).toString());
+        }
+        return titles;
+    }
+
     LibraryScanner m_libraryScanner;
 };
 
@@ -52,3 +150,133 @@ TEST_F(LibraryScannerTest, ScannerRoundtrip) {
     m_libraryScanner.changeScannerState(LibraryScanner::IDLE);
     EXPECT_EQ(m_libraryScanner.m_state, LibraryScanner::IDLE);
 }
+
+TEST_F(LibraryScannerTest, ScanAddsNewTracks) {
+    // More files than fit into a single batch
+    const int trackCount = 3 * ScannerGlobal::kNewTrackBatchSize + 5;
+    QTemporaryDir rootDir;
+    ASSERT_TRUE(rootDir.isValid());
+    ASSERT_TRUE(generateTracks(QDir(rootDir.path()), trackCount));
+    ASSERT_TRUE(internalCollection()->addDirectory(rootDir.path()));
+
+    m_libraryScanner.start();
+    ASSERT_TRUE(scanAndWait(&m_libraryScanner));
+
+    QStringList expectedTitles;
+    for (int i = 0; i < trackCount; ++i) {
+        expectedTitles.append(QString("Title %1").arg(i));
+    }
+    expectedTitles.sort();
+    // The metadata has been parsed from the file tags
+    EXPECT_EQ(expectedTitles, queryTitles());
+
+    // Rescanning doesn't add any tracks
+    ASSERT_TRUE(scanAndWait(&m_libraryScanner));
+    EXPECT_EQ(expectedTitles, queryTitles());
+}
+
+TEST_F(LibraryScannerTest, RescanChangedDirectories) {
+    const int trackCount = 3 * kFilesPerDirectory;
+    QTemporaryDir tempDir;
+    ASSERT_TRUE(tempDir.isValid());
+    const QDir rootDir(tempDir.path());
+    ASSERT_TRUE(generateTracks(rootDir, trackCount));
+    ASSERT_TRUE(internalCollection()->addDirectory(rootDir.path()));
+
+    m_libraryScanner.start();
+    ASSERT_TRUE(scanAndWait(&m_libraryScanner));
+    if (DirectoryWatcher::isSupported()) {
+        // Subsequent rescans only visit the changed directories
+        EXPECT_FALSE(config()->getValueString(
+                                     ConfigKey("[Library]", "ScanJournalCursor"))
+                             .isEmpty());
+    }
+
+    // Add a file, add a directory, delete a file, and delete a directory
+    QStringList expectedTitles;
+    for (int i = 0; i < 2 * kFilesPerDirectory; ++i) {
+        expectedTitles.append(QString("Title %1").arg(i));
+    }
+    expectedTitles.removeAll(QStringLiteral("Title 1"));
+    expectedTitles.append(QStringLiteral("Title 100"));
+    expectedTitles.append(QStringLiteral("Title 101"));
+    expectedTitles.sort();
+    ASSERT_TRUE(generateTrack(rootDir.absoluteFilePath("dir0/track100.mp3"), 100));
+    ASSERT_TRUE(rootDir.mkpath("dir0/new"));
+    ASSERT_TRUE(generateTrack(rootDir.absoluteFilePath("dir0/new/track101.mp3"), 101));
+    ASSERT_TRUE(QFile::remove(rootDir.absoluteFilePath("dir0/track1.mp3")));
+    ASSERT_TRUE(QDir(rootDir.absoluteFilePath("dir2")).removeRecursively());
+
+    const bool watchable = DirectoryWatcher::isSupported() &&
+            DirectoryWatcher::isWatchable(rootDir.path());
+    QMutex scannedDirPathsMutex;
+    QSet<QString> scannedDirPaths;
+    const auto connection = QObject::connect(
+            &m_libraryScanner,
+            &LibraryScanner::progressHashing,
+            [&scannedDirPathsMutex, &scannedDirPaths](const QString& dirPath) {
+                QMutexLocker locker(&scannedDirPathsMutex);
+                scannedDirPaths.insert(dirPath);
+            },
+            Qt::DirectConnection);
+    ASSERT_TRUE(scanAndWait(&m_libraryScanner));
+    EXPECT_EQ(expectedTitles, queryTitles());
+    // The new file in the changed directory has been imported
+    EXPECT_TRUE(queryTitles().contains(QStringLiteral("Title 100")));
+    EXPECT_TRUE(scannedDirPaths.contains(rootDir.absoluteFilePath("dir0")));
+    EXPECT_TRUE(scannedDirPaths.contains(rootDir.absoluteFilePath("dir0/new")));
+    if (watchable) {
+        // Only the changed directories have been rescanned
+        EXPECT_FALSE(scannedDirPaths.contains(rootDir.absoluteFilePath("dir1")));
+    }
+
+    // Unchanged
+    ASSERT_TRUE(scanAndWait(&m_libraryScanner));
+    EXPECT_EQ(expectedTitles, queryTitles());
+
+    // Requested by the user
+    {
+        QMutexLocker locker(&scannedDirPathsMutex);
+        scannedDirPaths.clear();
+    }
+    ASSERT_TRUE(scanAndWait(&m_libraryScanner, LibraryScanner::ScanMode::Full));
+    QObject::disconnect(connection);
+    EXPECT_EQ(expectedTitles, queryTitles());
+    EXPECT_TRUE(scannedDirPaths.contains(rootDir.absoluteFilePath("dir1")));
+}
+
+namespace {
+
+// Imports a synthetic directory tree into an empty library
+static void BM_LibraryScannerImport(benchmark::State& state) {
+    const int trackCount = static_cast<int>(state.range(0));
+    QTemporaryDir rootDir;
+    if (!rootDir.isValid() ||
+            !LibraryScannerTest::generateTracks(QDir(rootDir.path()), trackCount)) {
+        state.SkipWithError("Failed to generate tracks");
+        return;
+    }
+    double totalSeconds = 0.0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto pLibrary = std::make_unique<MixxxTestFixture<LibraryScannerTest>>();
+        pLibrary->addDirectory(rootDir.path());
+        pLibrary->m_libraryScanner.start();
+        state.ResumeTiming();
+        QElapsedTimer timer;
+        timer.start();
+        pLibrary->scanAndWait(&pLibrary->m_libraryScanner);
+        totalSeconds += timer.nsecsElapsed() / 1e9;
+        state.PauseTiming();
+        pLibrary.reset();
+        state.ResumeTiming();
+    }
+    state.counters["files_per_s"] = benchmark::Counter(
+            static_cast<double>(trackCount) * state.iterations() / totalSeconds);
+}
+BENCHMARK(BM_LibraryScannerImport)
+        ->Arg(1000)
+        ->Unit(benchmark::kMillisecond)
+        ->UseRealTime();
+
+} // anonymous namespace
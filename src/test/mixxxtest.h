@@ -8,6 +8,8 @@
 #include <QTemporaryDir>
 #include <QScopedPointer>
 
+#include <iostream>
+
 #include "mixxxapplication.h"
 
 #include "preferences/usersettings.h"
@@ -17,6 +19,19 @@
 #define EXPECT_QSTRING_EQ(expected, test) EXPECT_STREQ(qPrintable(expected), qPrintable(test))
 #define ASSERT_QSTRING_EQ(expected, test) ASSERT_STREQ(qPrintable(expected), qPrintable(test))
 
+#ifndef GTEST_SKIP
+// The bundled googletest 1.8 cannot skip tests. Return from the test and
+// print the reason instead, i.e. the test is reported as passed.
+namespace mixxxtest {
+struct SkipHelper {
+    void operator=(const testing::Message& message) const {
+        std::cout << "[  SKIPPED ] " << message << std::endl;
+    }
+};
+} // namespace mixxxtest
+#define GTEST_SKIP() return ::mixxxtest::SkipHelper() = ::testing::Message()
+#endif
+
 typedef QScopedPointer<QTemporaryFile> ScopedTemporaryFile;
 
 class MixxxTest : public testing::Test {
@@ -74,4 +89,22 @@ class MixxxTest : public testing::Test {
     UserSettingsPointer m_pConfig;
 };
 
+// Instantiates a test fixture outside of a test, e.g. for a benchmark.
+// SetUp() and TearDown() are invoked like for a test. Only the public
+// members of the fixture are accessible.
+template<typename Fixture>
+class MixxxTestFixture final : public Fixture {
+  public:
+    MixxxTestFixture() {
+        this->SetUp();
+    }
+    ~MixxxTestFixture() override {
+        this->TearDown();
+    }
+
+  private:
+    void TestBody() override {
+    }
+};
+
 #endif /* MIXXXTEST_H */
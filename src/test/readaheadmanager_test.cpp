@@ -10,6 +10,7 @@
 #include "test/mixxxtest.h"
 #include "util/assert.h"
 #include "util/defs.h"
+#include "util/realtimecheck.h"
 #include "util/sample.h"
 
 namespace {
@@ -149,3 +150,44 @@ TEST_F(ReadAheadManagerTest, FractionalFrameLoop) {
     // The rounding error must not exceed a half frame (one samples in stereo)
     EXPECT_NEAR(16, m_pReadAheadManager->getPlaypos(), 1);
 }
+
+TEST_F(ReadAheadManagerTest, ReadLogDoesNotAllocate) {
+    m_pReadAheadManager->notifySeek(0);
+    // Loop between 4 and 10 on every read to create a new log entry each time
+    for (int i = 0; i < 1000; ++i) {
+        m_pLoopControl->pushTriggerReturnValue(10);
+        m_pLoopControl->pushTargetReturnValue(4);
+    }
+
+    mixxx::RealtimeAudit::reset();
+    double filePlayposition = 0;
+    {
+        mixxx::ScopedRealtimeSection realtimeSection;
+        for (int i = 0; i < 1000; ++i) {
+            const SINT samplesRead =
+                    m_pReadAheadManager->getNextSamples(1.0, m_pBuffer, 6);
+            filePlayposition = m_pReadAheadManager->getFilePlaypositionFromLog(
+                    filePlayposition, samplesRead);
+        }
+    }
+    EXPECT_EQ(0, mixxx::RealtimeAudit::count())
+            << mixxx::RealtimeAudit::report().toStdString();
+    // The last read ended at the loop trigger
+    EXPECT_DOUBLE_EQ(10, filePlayposition);
+}
+
+TEST_F(ReadAheadManagerTest, ReadLogOverflowDropsOldestEntries) {
+    m_pReadAheadManager->notifySeek(0);
+    // Far more loops than log entries without consuming any of them
+    for (int i = 0; i < 5000; ++i) {
+        m_pLoopControl->pushTriggerReturnValue(10);
+        m_pLoopControl->pushTargetReturnValue(4);
+        m_pReadAheadManager->getNextSamples(1.0, m_pBuffer, 6);
+    }
+    // The first entries from 0 to 6 and from 6 to 10 have been dropped
+    EXPECT_DOUBLE_EQ(7, m_pReadAheadManager->getFilePlaypositionFromLog(0, 3));
+    // The most recent entry is still available
+    EXPECT_DOUBLE_EQ(10, m_pReadAheadManager->getFilePlaypositionFromLog(0, 1e9));
+    // The log is empty now
+    EXPECT_DOUBLE_EQ(42, m_pReadAheadManager->getFilePlaypositionFromLog(42, 6));
+}
@@ -4,15 +4,26 @@
 #include <QtDebug>
 #include <QList>
 #include <QPair>
+#include <QVector>
+
+#include <algorithm>
+#include <array>
+#include <string>
+#include <utility>
 
 #include "util/sample.h"
 #include "util/timer.h"
 
 namespace {
 
-class SampleUtilTest : public testing::Test {
+// All tests are executed for each instruction set that is supported
+// by both the build and the CPU
+class SampleUtilTest : public testing::TestWithParam<SampleUtil::InstructionSet> {
   protected:
     void SetUp() override {
+        m_defaultInstructionSet = SampleUtil::instructionSet();
+        ASSERT_TRUE(SampleUtil::setInstructionSet(GetParam()));
+
         sizes.append(1024);
         sizes.append(1025);
         sizes.append(1026);
@@ -35,6 +46,8 @@ class SampleUtilTest : public testing::Test {
         buffers.clear();
         evenBuffers.clear();
         sizes.clear();
+
+        SampleUtil::setInstructionSet(m_defaultInstructionSet);
     }
 
     void ClearBuffer(CSAMPLE* pBuffer, int length) {
@@ -54,15 +67,31 @@ class SampleUtilTest : public testing::Test {
     QList<int> sizes;
     QList<CSAMPLE*> buffers;
     QList<int> evenBuffers;
+
+  private:
+    SampleUtil::InstructionSet m_defaultInstructionSet;
 };
 
-TEST_F(SampleUtilTest, allocIs16ByteAligned) {
+std::string instructionSetTestName(
+        const testing::TestParamInfo<SampleUtil::InstructionSet>& info) {
+    std::string name = SampleUtil::instructionSetName(info.param);
+    // Only alphanumeric characters are allowed
+    name.erase(std::remove(name.begin(), name.end(), '-'), name.end());
+    return name;
+}
+
+INSTANTIATE_TEST_CASE_P(InstructionSets,
+        SampleUtilTest,
+        testing::ValuesIn(SampleUtil::supportedInstructionSets()),
+        instructionSetTestName);
+
+TEST_P(SampleUtilTest, allocIs16ByteAligned) {
     foreach (CSAMPLE* buffer, buffers) {
         ASSERT_EQ(0U, reinterpret_cast<quintptr>(buffer) % 16);
     }
 }
 
-TEST_F(SampleUtilTest, applyGain1DoesNothing) {
+TEST_P(SampleUtilTest, applyGain1DoesNothing) {
     for (int i = 0; i < buffers.size(); ++i) {
         CSAMPLE* buffer = buffers[i];
         int size = sizes[i];
@@ -72,7 +101,7 @@ TEST_F(SampleUtilTest, applyGain1DoesNothing) {
     }
 }
 
-TEST_F(SampleUtilTest, applyGain0ClearsBuffer) {
+TEST_P(SampleUtilTest, applyGain0ClearsBuffer) {
     for (int i = 0; i < buffers.size(); ++i) {
         CSAMPLE* buffer = buffers[i];
         int size = sizes[i];
@@ -82,7 +111,7 @@ TEST_F(SampleUtilTest, applyGain0ClearsBuffer) {
     }
 }
 
-TEST_F(SampleUtilTest, applyGain) {
+TEST_P(SampleUtilTest, applyGain) {
     for (int i = 0; i < buffers.size(); ++i) {
         CSAMPLE* buffer = buffers[i];
         int size = sizes[i];
@@ -92,7 +121,7 @@ TEST_F(SampleUtilTest, applyGain) {
     }
 }
 
-TEST_F(SampleUtilTest, applyAlternatingGain) {
+TEST_P(SampleUtilTest, applyAlternatingGain) {
     for (int i = 0; i < evenBuffers.size(); ++i) {
         int j = evenBuffers[i];
         CSAMPLE* buffer = buffers[j];
@@ -106,7 +135,7 @@ TEST_F(SampleUtilTest, applyAlternatingGain) {
     }
 }
 
-TEST_F(SampleUtilTest, addWithGain) {
+TEST_P(SampleUtilTest, addWithGain) {
     for (int i = 0; i < buffers.size(); ++i) {
         CSAMPLE* buffer = buffers[i];
         int size = sizes[i];
@@ -122,7 +151,7 @@ TEST_F(SampleUtilTest, addWithGain) {
 }
 
 
-TEST_F(SampleUtilTest, add2WithGain) {
+TEST_P(SampleUtilTest, add2WithGain) {
     for (int i = 0; i < buffers.size(); ++i) {
         CSAMPLE* buffer = buffers[i];
         int size = sizes[i];
@@ -146,7 +175,7 @@ TEST_F(SampleUtilTest, add2WithGain) {
     }
 }
 
-TEST_F(SampleUtilTest, add3WithGain) {
+TEST_P(SampleUtilTest, add3WithGain) {
     for (int i = 0; i < buffers.size(); ++i) {
         CSAMPLE* buffer = buffers[i];
         int size = sizes[i];
@@ -175,7 +204,7 @@ TEST_F(SampleUtilTest, add3WithGain) {
     }
 }
 
-TEST_F(SampleUtilTest, copyWithGain) {
+TEST_P(SampleUtilTest, copyWithGain) {
     for (int i = 0; i < buffers.size(); ++i) {
         CSAMPLE* buffer = buffers[i];
         int size = sizes[i];
@@ -190,7 +219,7 @@ TEST_F(SampleUtilTest, copyWithGain) {
     }
 }
 
-TEST_F(SampleUtilTest, copyWithGainAliased) {
+TEST_P(SampleUtilTest, copyWithGainAliased) {
     for (int i = 0; i < buffers.size(); ++i) {
         CSAMPLE* buffer = buffers[i];
         int size = sizes[i];
@@ -200,7 +229,7 @@ TEST_F(SampleUtilTest, copyWithGainAliased) {
     }
 }
 
-TEST_F(SampleUtilTest, copy2WithGain) {
+TEST_P(SampleUtilTest, copy2WithGain) {
     for (int i = 0; i < buffers.size(); ++i) {
         CSAMPLE* buffer = buffers[i];
         int size = sizes[i];
@@ -224,7 +253,7 @@ TEST_F(SampleUtilTest, copy2WithGain) {
     }
 }
 
-TEST_F(SampleUtilTest, copy3WithGain) {
+TEST_P(SampleUtilTest, copy3WithGain) {
     for (int i = 0; i < buffers.size(); ++i) {
         CSAMPLE* buffer = buffers[i];
         int size = sizes[i];
@@ -253,7 +282,33 @@ TEST_F(SampleUtilTest, copy3WithGain) {
     }
 }
 
-TEST_F(SampleUtilTest, convertS16ToFloat32) {
+TEST_P(SampleUtilTest, mixBuffers) {
+    // More sources than the former auto-generated ChannelMixer supported
+    const int kMaxSources = 40;
+    for (int i = 0; i < buffers.size(); ++i) {
+        CSAMPLE* buffer = buffers[i];
+        int size = sizes[i];
+        QVector<CSAMPLE*> sources;
+        for (int j = 0; j < kMaxSources; ++j) {
+            CSAMPLE* source = SampleUtil::alloc(size);
+            FillBuffer(source, 0.25f * (j + 1), size);
+            sources.append(source);
+        }
+        for (int numSources = 0; numSources <= kMaxSources; ++numSources) {
+            FillBuffer(buffer, 1.0f, size);
+            SampleUtil::mixBuffers(buffer, sources.constData(), numSources, size);
+            // 0.25 * (1 + 2 + ... + numSources)
+            AssertWholeBufferEquals(buffer,
+                    0.125f * numSources * (numSources + 1),
+                    size);
+        }
+        for (CSAMPLE* source : sources) {
+            SampleUtil::free(source);
+        }
+    }
+}
+
+TEST_P(SampleUtilTest, convertS16ToFloat32) {
     // Shorts are asymmetric, so SAMPLE_MAX is less than -SAMPLE_MIN.
     const float expectedMax = static_cast<float>(SAMPLE_MAX) /
                               static_cast<float>(-SAMPLE_MIN);
@@ -289,7 +344,7 @@ TEST_F(SampleUtilTest, convertS16ToFloat32) {
     }
 }
 
-TEST_F(SampleUtilTest, sumAbsPerChannel) {
+TEST_P(SampleUtilTest, sumAbsPerChannel) {
     for (int i = 0; i < evenBuffers.size(); ++i) {
         int j = evenBuffers[i];
         CSAMPLE* buffer = buffers[j];
@@ -303,7 +358,7 @@ TEST_F(SampleUtilTest, sumAbsPerChannel) {
     }
 }
 
-TEST_F(SampleUtilTest, interleaveBuffer) {
+TEST_P(SampleUtilTest, interleaveBuffer) {
     for (int i = 0; i < buffers.size(); ++i) {
         CSAMPLE* buffer = buffers[i];
         int size = sizes[i];
@@ -325,7 +380,7 @@ TEST_F(SampleUtilTest, interleaveBuffer) {
     }
 }
 
-TEST_F(SampleUtilTest, deinterleaveBuffer) {
+TEST_P(SampleUtilTest, deinterleaveBuffer) {
     for (int i = 0; i < buffers.size(); ++i) {
         CSAMPLE* buffer = buffers[i];
         int size = sizes[i];
@@ -350,7 +405,7 @@ TEST_F(SampleUtilTest, deinterleaveBuffer) {
     }
 }
 
-TEST_F(SampleUtilTest, reverse) {
+TEST_P(SampleUtilTest, reverse) {
     if (buffers.size() > 0 && sizes[0] > 10) {
         CSAMPLE* buffer = buffers[1];
         for (int i = 0; i < 10; ++i) {
@@ -373,7 +428,7 @@ TEST_F(SampleUtilTest, reverse) {
     }
 }
 
-TEST_F(SampleUtilTest, copyReverse) {
+TEST_P(SampleUtilTest, copyReverse) {
     if (buffers.size() > 1 && sizes[0] > 10 && sizes[1] > 10)  {
         CSAMPLE* source = buffers[0];
         CSAMPLE* destination = buffers[1];
@@ -397,6 +452,170 @@ TEST_F(SampleUtilTest, copyReverse) {
     }
 }
 
+TEST_P(SampleUtilTest, add) {
+    for (int i = 0; i < buffers.size(); ++i) {
+        CSAMPLE* buffer = buffers[i];
+        int size = sizes[i];
+        FillBuffer(buffer, 1.0f, size);
+        CSAMPLE* buffer2 = SampleUtil::alloc(size);
+        FillBuffer(buffer2, 0.5f, size);
+        SampleUtil::add(buffer, buffer2, size);
+        AssertWholeBufferEquals(buffer, 1.5f, size);
+        SampleUtil::free(buffer2);
+    }
+}
+
+TEST_P(SampleUtilTest, applyRampingGain) {
+    for (int i = 0; i < evenBuffers.size(); ++i) {
+        int j = evenBuffers[i];
+        CSAMPLE* buffer = buffers[j];
+        int size = sizes[j];
+        FillBuffer(buffer, 1.0f, size);
+        SampleUtil::applyRampingGain(buffer, 0.0f, 1.0f, size);
+        const CSAMPLE_GAIN gainDelta = 1.0f / (size / 2);
+        for (int s = 0; s < size / 2; ++s) {
+            EXPECT_NEAR(gainDelta * (s + 1), buffer[s * 2], 1e-6f);
+            EXPECT_NEAR(gainDelta * (s + 1), buffer[s * 2 + 1], 1e-6f);
+        }
+    }
+}
+
+TEST_P(SampleUtilTest, copyWithRampingGain) {
+    for (int i = 0; i < evenBuffers.size(); ++i) {
+        int j = evenBuffers[i];
+        CSAMPLE* buffer = buffers[j];
+        int size = sizes[j];
+        CSAMPLE* buffer2 = SampleUtil::alloc(size);
+        FillBuffer(buffer2, 0.5f, size);
+        SampleUtil::copyWithRampingGain(buffer, buffer2, 1.0f, 0.0f, size);
+        const CSAMPLE_GAIN gainDelta = -1.0f / (size / 2);
+        for (int s = 0; s < size / 2; ++s) {
+            const CSAMPLE_GAIN gain = 1.0f + gainDelta * (s + 1);
+            EXPECT_NEAR(0.5f * gain, buffer[s * 2], 1e-6f);
+            EXPECT_NEAR(0.5f * gain, buffer[s * 2 + 1], 1e-6f);
+        }
+        SampleUtil::free(buffer2);
+    }
+}
+
+TEST_P(SampleUtilTest, addWithRampingGain) {
+    for (int i = 0; i < evenBuffers.size(); ++i) {
+        int j = evenBuffers[i];
+        CSAMPLE* buffer = buffers[j];
+        int size = sizes[j];
+        FillBuffer(buffer, 1.0f, size);
+        CSAMPLE* buffer2 = SampleUtil::alloc(size);
+        FillBuffer(buffer2, 0.5f, size);
+        SampleUtil::addWithRampingGain(buffer, buffer2, 0.0f, 1.0f, size);
+        const CSAMPLE_GAIN gainDelta = 1.0f / (size / 2);
+        for (int s = 0; s < size / 2; ++s) {
+            const CSAMPLE_GAIN gain = gainDelta * (s + 1);
+            EXPECT_NEAR(1.0f + 0.5f * gain, buffer[s * 2], 1e-6f);
+            EXPECT_NEAR(1.0f + 0.5f * gain, buffer[s * 2 + 1], 1e-6f);
+        }
+        SampleUtil::free(buffer2);
+    }
+}
+
+TEST_P(SampleUtilTest, convertFloat32ToS16) {
+    for (int i = 0; i < buffers.size(); ++i) {
+        CSAMPLE* buffer = buffers[i];
+        int size = sizes[i];
+        SAMPLE* s16 = new SAMPLE[size];
+        for (int j = 0; j < size; ++j) {
+            buffer[j] = (j % 3) * 0.5f - 0.5f;
+        }
+        SampleUtil::convertFloat32ToS16(s16, buffer, size);
+        for (int j = 0; j < size; ++j) {
+            EXPECT_EQ(SAMPLE(buffer[j] * -SAMPLE_MIN), s16[j]);
+        }
+        delete [] s16;
+    }
+}
+
+TEST_P(SampleUtilTest, copyClampBuffer) {
+    for (int i = 0; i < buffers.size(); ++i) {
+        CSAMPLE* buffer = buffers[i];
+        int size = sizes[i];
+        CSAMPLE* buffer2 = SampleUtil::alloc(size);
+        for (int j = 0; j < size; ++j) {
+            buffer2[j] = (j % 5) * 0.75f - 1.5f;
+        }
+        SampleUtil::copyClampBuffer(buffer, buffer2, size);
+        for (int j = 0; j < size; ++j) {
+            EXPECT_FLOAT_EQ(SampleUtil::clampSample(buffer2[j]), buffer[j]);
+        }
+        SampleUtil::free(buffer2);
+    }
+}
+
+TEST_P(SampleUtilTest, linearCrossfadeBuffers) {
+    for (int i = 0; i < evenBuffers.size(); ++i) {
+        int j = evenBuffers[i];
+        CSAMPLE* buffer = buffers[j];
+        int size = sizes[j];
+        CSAMPLE* buffer2 = SampleUtil::alloc(size);
+        FillBuffer(buffer2, 0.5f, size);
+        const CSAMPLE_GAIN crossInc = 1.0f / (size / 2);
+
+        FillBuffer(buffer, 1.0f, size);
+        SampleUtil::linearCrossfadeBuffersOut(buffer, buffer2, size);
+        for (int s = 0; s < size / 2; ++s) {
+            const CSAMPLE_GAIN crossMix = crossInc * s;
+            EXPECT_NEAR(1.0f - 0.5f * crossMix, buffer[s * 2], 1e-6f);
+            EXPECT_NEAR(1.0f - 0.5f * crossMix, buffer[s * 2 + 1], 1e-6f);
+        }
+
+        FillBuffer(buffer, 1.0f, size);
+        SampleUtil::linearCrossfadeBuffersIn(buffer, buffer2, size);
+        for (int s = 0; s < size / 2; ++s) {
+            const CSAMPLE_GAIN crossMix = crossInc * s;
+            EXPECT_NEAR(0.5f + 0.5f * crossMix, buffer[s * 2], 1e-6f);
+            EXPECT_NEAR(0.5f + 0.5f * crossMix, buffer[s * 2 + 1], 1e-6f);
+        }
+        SampleUtil::free(buffer2);
+    }
+}
+
+TEST_P(SampleUtilTest, mixStereoToMono) {
+    for (int i = 0; i < evenBuffers.size(); ++i) {
+        int j = evenBuffers[i];
+        CSAMPLE* buffer = buffers[j];
+        int size = sizes[j];
+        CSAMPLE* buffer2 = SampleUtil::alloc(size);
+        for (int s = 0; s < size; ++s) {
+            buffer2[s] = (s % 2) ? 0.25f : 0.75f;
+        }
+        SampleUtil::mixStereoToMono(buffer, buffer2, size);
+        AssertWholeBufferEquals(buffer, 0.5f, size);
+        SampleUtil::free(buffer2);
+    }
+}
+
+TEST_P(SampleUtilTest, copyMonoToDualMonoAndAddMonoToStereo) {
+    for (int i = 0; i < evenBuffers.size(); ++i) {
+        int j = evenBuffers[i];
+        CSAMPLE* buffer = buffers[j];
+        int size = sizes[j];
+        const int numFrames = size / 2;
+        CSAMPLE* mono = SampleUtil::alloc(numFrames);
+        for (int s = 0; s < numFrames; ++s) {
+            mono[s] = s * 0.001f;
+        }
+        SampleUtil::copyMonoToDualMono(buffer, mono, numFrames);
+        for (int s = 0; s < numFrames; ++s) {
+            EXPECT_FLOAT_EQ(mono[s], buffer[s * 2]);
+            EXPECT_FLOAT_EQ(mono[s], buffer[s * 2 + 1]);
+        }
+        SampleUtil::addMonoToStereo(buffer, mono, numFrames);
+        for (int s = 0; s < numFrames; ++s) {
+            EXPECT_FLOAT_EQ(2 * mono[s], buffer[s * 2]);
+            EXPECT_FLOAT_EQ(2 * mono[s], buffer[s * 2 + 1]);
+        }
+        SampleUtil::free(mono);
+    }
+}
+
 static void BM_MemCpy(benchmark::State& state) {
     size_t size = state.range(0);
     CSAMPLE* buffer = SampleUtil::alloc(size);
@@ -447,7 +666,7 @@ BENCHMARK(BM_SampleUtilCopy)->Range(64, 4096);
 
 
 /*
-TEST_F(SampleUtilTest, copy3WithGainSpeed) {
+TEST_P(SampleUtilTest, copy3WithGainSpeed) {
     CSAMPLE* buffer = buffers[0];
 
     int size = sizes[0] - (rand() % 2) * 8; // prevent predicting loop size
@@ -583,4 +802,211 @@ static void BM_Copy2WithRampingGain(benchmark::State& state) {
 }
 BENCHMARK(BM_Copy2WithRampingGain)->Range(64, 4096);
 
+// Mixes all sources within a single loop like the branches of the former
+// auto-generated ChannelMixer (channelmixer_autogen.cpp). Used as the
+// reference for BM_MixBuffers.
+template<std::size_t... I>
+void mixBuffersUnrolled(CSAMPLE* M_RESTRICT pDest,
+        const CSAMPLE* const* pSrcs,
+        SINT numSamples,
+        std::index_sequence<I...>) {
+    const CSAMPLE* const pBuffers[] = {pSrcs[I]...};
+    for (SINT i = 0; i < numSamples; ++i) {
+        pDest[i] = (pBuffers[I][i] + ...);
+    }
+}
+
+template<std::size_t N>
+void mixBuffersUnrolled(CSAMPLE* pDest, const CSAMPLE* const* pSrcs, SINT numSamples) {
+    mixBuffersUnrolled(pDest, pSrcs, numSamples, std::make_index_sequence<N>());
+}
+
+typedef void (*MixBuffersFunc)(CSAMPLE*, const CSAMPLE* const*, SINT);
+
+template<std::size_t... N>
+constexpr std::array<MixBuffersFunc, sizeof...(N)> makeMixBuffersUnrolledTable(
+        std::index_sequence<N...>) {
+    return {{&mixBuffersUnrolled<N + 1>...}};
+}
+
+constexpr int kMaxUnrolledSources = 32;
+constexpr auto kMixBuffersUnrolled = makeMixBuffersUnrolledTable(
+        std::make_index_sequence<kMaxUnrolledSources>());
+
+// Mixes range(0) channels with range(1) samples each
+static void BM_MixBuffers(benchmark::State& state) {
+    const int numSources = state.range(0);
+    const SINT size = state.range(1);
+    CSAMPLE* buffer = SampleUtil::alloc(size);
+    QVector<CSAMPLE*> sources;
+    for (int i = 0; i < numSources; ++i) {
+        CSAMPLE* source = SampleUtil::alloc(size);
+        SampleUtil::fill(source, 0.1f, size);
+        sources.append(source);
+    }
+
+    while (state.KeepRunning()) {
+        SampleUtil::mixBuffers(buffer, sources.constData(), numSources, size);
+    }
+
+    for (CSAMPLE* source : sources) {
+        SampleUtil::free(source);
+    }
+    SampleUtil::free(buffer);
+}
+
+static void BM_MixBuffersUnrolled(benchmark::State& state) {
+    const int numSources = state.range(0);
+    const SINT size = state.range(1);
+    CSAMPLE* buffer = SampleUtil::alloc(size);
+    QVector<CSAMPLE*> sources;
+    for (int i = 0; i < numSources; ++i) {
+        CSAMPLE* source = SampleUtil::alloc(size);
+        SampleUtil::fill(source, 0.1f, size);
+        sources.append(source);
+    }
+
+    const MixBuffersFunc mixBuffers = kMixBuffersUnrolled[numSources - 1];
+    while (state.KeepRunning()) {
+        mixBuffers(buffer, sources.constData(), size);
+    }
+
+    for (CSAMPLE* source : sources) {
+        SampleUtil::free(source);
+    }
+    SampleUtil::free(buffer);
+}
+
+static void MixBuffersArguments(benchmark::internal::Benchmark* b) {
+    for (int numSources = 1; numSources <= kMaxUnrolledSources; numSources *= 2) {
+        for (int size = 128; size <= 2048; size *= 4) {
+            b->Args({numSources, size});
+        }
+    }
+    // 4 decks + 8 samplers + aux + mic
+    b->Args({14, 512});
+}
+BENCHMARK(BM_MixBuffers)->Apply(MixBuffersArguments);
+BENCHMARK(BM_MixBuffersUnrolled)->Apply(MixBuffersArguments);
+
+
+// Executes each kernel benchmark for all supported instruction
+// sets and typical buffer sizes
+static void KernelArguments(benchmark::internal::Benchmark* b) {
+    for (auto instructionSet : SampleUtil::supportedInstructionSets()) {
+        for (int size = 64; size <= 4096; size *= 4) {
+            b->Args({static_cast<int>(instructionSet), size});
+        }
+    }
+}
+
+// Selects the instruction set for the lifetime of a benchmark
+class ScopedInstructionSet {
+  public:
+    explicit ScopedInstructionSet(benchmark::State& state)
+            : m_defaultInstructionSet(SampleUtil::instructionSet()) {
+        const auto instructionSet =
+                static_cast<SampleUtil::InstructionSet>(state.range(0));
+        SampleUtil::setInstructionSet(instructionSet);
+        state.SetLabel(SampleUtil::instructionSetName(instructionSet));
+    }
+    ~ScopedInstructionSet() {
+        SampleUtil::setInstructionSet(m_defaultInstructionSet);
+    }
+
+  private:
+    const SampleUtil::InstructionSet m_defaultInstructionSet;
+};
+
+// Sample buffers for the kernel benchmarks
+class KernelBuffers {
+  public:
+    explicit KernelBuffers(benchmark::State& state)
+            : m_size(state.range(1)) {
+        for (auto& buffer : m_buffers) {
+            buffer = SampleUtil::alloc(m_size);
+            SampleUtil::fill(buffer, 0.1f, m_size);
+        }
+        m_s16 = new SAMPLE[m_size]();
+    }
+    ~KernelBuffers() {
+        for (auto* buffer : m_buffers) {
+            SampleUtil::free(buffer);
+        }
+        delete[] m_s16;
+    }
+
+    SINT size() const {
+        return m_size;
+    }
+    CSAMPLE* operator[](int index) const {
+        return m_buffers[index];
+    }
+    SAMPLE* s16() const {
+        return m_s16;
+    }
+
+  private:
+    const SINT m_size;
+    std::array<CSAMPLE*, 4> m_buffers;
+    SAMPLE* m_s16;
+};
+
+#define SAMPLEUTIL_KERNEL_BENCHMARK(name, statement)       \
+    static void BM_Kernel_##name(benchmark::State& state) { \
+        ScopedInstructionSet instructionSet(state);         \
+        KernelBuffers buffers(state);                       \
+        const SINT size = buffers.size();                   \
+        for (auto _ : state) {                              \
+            statement;                                      \
+            benchmark::ClobberMemory();                     \
+        }                                                   \
+        state.SetItemsProcessed(state.iterations() * size); \
+    }                                                       \
+    BENCHMARK(BM_Kernel_##name)->Apply(KernelArguments);
+
+SAMPLEUTIL_KERNEL_BENCHMARK(applyGain,
+        SampleUtil::applyGain(buffers[0], 0.99f, size))
+SAMPLEUTIL_KERNEL_BENCHMARK(applyRampingGain,
+        SampleUtil::applyRampingGain(buffers[0], 0.99f, 0.98f, size))
+SAMPLEUTIL_KERNEL_BENCHMARK(applyAlternatingGain,
+        SampleUtil::applyAlternatingGain(buffers[0], 0.99f, 0.98f, size))
+SAMPLEUTIL_KERNEL_BENCHMARK(copyWithGain,
+        SampleUtil::copyWithGain(buffers[0], buffers[1], 0.99f, size))
+SAMPLEUTIL_KERNEL_BENCHMARK(copyWithRampingGain,
+        SampleUtil::copyWithRampingGain(buffers[0], buffers[1], 0.99f, 0.98f, size))
+SAMPLEUTIL_KERNEL_BENCHMARK(add,
+        SampleUtil::add(buffers[0], buffers[1], size))
+SAMPLEUTIL_KERNEL_BENCHMARK(addWithGain,
+        SampleUtil::addWithGain(buffers[0], buffers[1], 0.99f, size))
+SAMPLEUTIL_KERNEL_BENCHMARK(addWithRampingGain,
+        SampleUtil::addWithRampingGain(buffers[0], buffers[1], 0.99f, 0.98f, size))
+SAMPLEUTIL_KERNEL_BENCHMARK(add2WithGain,
+        SampleUtil::add2WithGain(buffers[0], buffers[1], 0.99f, buffers[2], 0.98f, size))
+SAMPLEUTIL_KERNEL_BENCHMARK(add3WithGain,
+        SampleUtil::add3WithGain(buffers[0], buffers[1], 0.99f, buffers[2], 0.98f, buffers[3], 0.97f, size))
+SAMPLEUTIL_KERNEL_BENCHMARK(convertS16ToFloat32,
+        SampleUtil::convertS16ToFloat32(buffers[0], buffers.s16(), size))
+SAMPLEUTIL_KERNEL_BENCHMARK(convertFloat32ToS16,
+        SampleUtil::convertFloat32ToS16(buffers.s16(), buffers[0], size))
+SAMPLEUTIL_KERNEL_BENCHMARK(sumAbsPerChannel,
+        CSAMPLE absL; CSAMPLE absR;
+        benchmark::DoNotOptimize(SampleUtil::sumAbsPerChannel(&absL, &absR, buffers[0], size)))
+SAMPLEUTIL_KERNEL_BENCHMARK(copyClampBuffer,
+        SampleUtil::copyClampBuffer(buffers[0], buffers[1], size))
+SAMPLEUTIL_KERNEL_BENCHMARK(interleaveBuffer,
+        SampleUtil::interleaveBuffer(buffers[0], buffers[1], buffers[2], size / 2))
+SAMPLEUTIL_KERNEL_BENCHMARK(deinterleaveBuffer,
+        SampleUtil::deinterleaveBuffer(buffers[1], buffers[2], buffers[0], size / 2))
+SAMPLEUTIL_KERNEL_BENCHMARK(linearCrossfadeBuffersOut,
+        SampleUtil::linearCrossfadeBuffersOut(buffers[0], buffers[1], size))
+SAMPLEUTIL_KERNEL_BENCHMARK(linearCrossfadeBuffersIn,
+        SampleUtil::linearCrossfadeBuffersIn(buffers[0], buffers[1], size))
+SAMPLEUTIL_KERNEL_BENCHMARK(mixStereoToMono,
+        SampleUtil::mixStereoToMono(buffers[0], buffers[1], size))
+SAMPLEUTIL_KERNEL_BENCHMARK(copyMonoToDualMono,
+        SampleUtil::copyMonoToDualMono(buffers[0], buffers[1], size / 2))
+SAMPLEUTIL_KERNEL_BENCHMARK(addMonoToStereo,
+        SampleUtil::addMonoToStereo(buffers[0], buffers[1], size / 2))
+
 }  // namespace
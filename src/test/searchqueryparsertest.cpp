@@ -4,6 +4,7 @@
 
 #include "test/librarytest.h"
 
+#include "library/dao/searchindexdao.h"
 #include "library/searchqueryparser.h"
 #include "util/assert.h"
 
@@ -32,6 +33,25 @@ class SearchQueryParserTest : public LibraryTest {
         return pTrack ? pTrack->getId() : TrackId();
     }
 
+    // Selects the matching tracks from the library with the SQL query
+    QSet<TrackId> selectTrackIds(const QueryNode& query) {
+        QSqlQuery sqlQuery(dbConnection());
+        sqlQuery.prepare(
+                "SELECT id FROM (SELECT library.id,library.artist,library.title,"
+                "track_locations.location FROM library INNER JOIN track_locations "
+                "ON library.location=track_locations.id) WHERE " +
+                query.toSql());
+        QSet<TrackId> trackIds;
+        if (!sqlQuery.exec()) {
+            LOG_FAILED_QUERY(sqlQuery);
+            return trackIds;
+        }
+        while (sqlQuery.next()) {
+            trackIds.insert(TrackId(sqlQuery.value(0)));
+        }
+        return trackIds;
+    }
+
     SearchQueryParser m_parser;
 
     // The expected query to be returned by CrateFilterNode
@@ -989,3 +1009,98 @@ TEST_F(SearchQueryParserTest, CrateFilterWithCrateFilterAndNegation){
                             ") AND (NOT (" + m_crateFilterQuery.arg(searchTermB) + "))"),
                  qPrintable(pQueryB->toSql()));
 }
+
+TEST_F(SearchQueryParserTest, FullTextSearch) {
+    SearchIndexDAO searchIndex;
+    searchIndex.initialize(dbConnection());
+    if (!searchIndex.isAvailable()) {
+        GTEST_SKIP() << "Full-text search is not supported by SQLite";
+    }
+    m_parser.setSearchIndex(&searchIndex);
+
+    TrackPointer pTrackA = Track::newTemporary(
+            TrackFile(QDir(QDir::tempPath() + "/fulltext"), "track-a.mp3"));
+    pTrackA->setArtist(QString::fromUtf8("Bj\xC3\xB6rk"));
+    pTrackA->setTitle(QString::fromUtf8("J\xC3\xB3ga"));
+    TrackPointer pTrackB = Track::newTemporary(
+            TrackFile(QDir(QDir::tempPath() + "/fulltext"), "track-b.mp3"));
+    pTrackB->setArtist("Bjorn");
+    pTrackB->setTitle("Hyperballad");
+    const TrackId trackAId = internalCollection()->addTrack(pTrackA, false);
+    const TrackId trackBId = internalCollection()->addTrack(pTrackB, false);
+    ASSERT_TRUE(trackAId.isValid());
+    ASSERT_TRUE(trackBId.isValid());
+
+    const QStringList searchColumns = {"artist", "title", "location"};
+
+    // Accent- and case-insensitive like the LIKE operator
+    auto pQuery = m_parser.parseQuery(QString::fromUtf8("bj\xC3\xB6"), searchColumns, "");
+    EXPECT_TRUE(pQuery->toSql().startsWith("id IN (SELECT rowid FROM library_search"));
+    EXPECT_EQ(QSet<TrackId>({trackAId, trackBId}), selectTrackIds(*pQuery));
+
+    pQuery = m_parser.parseQuery("JOGA", searchColumns, "");
+    EXPECT_EQ(QSet<TrackId>({trackAId}), selectTrackIds(*pQuery));
+
+    pQuery = m_parser.parseQuery("-bjork", searchColumns, "");
+    EXPECT_EQ(QSet<TrackId>({trackBId}), selectTrackIds(*pQuery));
+
+    pQuery = m_parser.parseQuery("title:ball", searchColumns, "");
+    EXPECT_EQ(QSet<TrackId>({trackBId}), selectTrackIds(*pQuery));
+
+    pQuery = m_parser.parseQuery("bjo \"k-a\"", searchColumns, "");
+    EXPECT_EQ(QSet<TrackId>({trackAId}), selectTrackIds(*pQuery));
+
+    // Too short for the index
+    pQuery = m_parser.parseQuery("bj", searchColumns, "");
+    EXPECT_EQ(QString("(artist LIKE '%bj%') OR (title LIKE '%bj%') OR (location LIKE '%bj%')"),
+            pQuery->toSql());
+    EXPECT_EQ(QSet<TrackId>({trackAId, trackBId}), selectTrackIds(*pQuery));
+
+    // Purged tracks are removed from the index
+    trackCollections()->purgeTracks(
+            {TrackRef::fromFileInfo(pTrackA->getFileInfo(), trackAId)});
+    pQuery = m_parser.parseQuery("bjo", searchColumns, "");
+    EXPECT_EQ(QSet<TrackId>({trackBId}), selectTrackIds(*pQuery));
+}
+
+TEST_F(SearchQueryParserTest, FullTextSearchIndexIsSynchronized) {
+    SearchIndexDAO searchIndex;
+    searchIndex.initialize(dbConnection());
+    if (!searchIndex.isAvailable()) {
+        GTEST_SKIP() << "Full-text search is not supported by SQLite";
+    }
+
+    TrackPointer pTrack = Track::newTemporary(
+            TrackFile(QDir(QDir::tempPath() + "/fulltext"), "track-c.mp3"));
+    pTrack->setTitle("Unravel");
+    const TrackId trackId = internalCollection()->addTrack(pTrack, false);
+    ASSERT_TRUE(trackId.isValid());
+    EXPECT_TRUE(searchIndex.isSynchronized());
+
+    // Modified by a version that doesn't maintain the index
+    QSqlQuery query(dbConnection());
+    ASSERT_TRUE(query.exec(
+            QString("UPDATE library SET title='Hunter' WHERE id=%1")
+                    .arg(trackId.toString())));
+
+    // Restart
+    SearchIndexDAO restartedSearchIndex;
+    restartedSearchIndex.initialize(dbConnection());
+    ASSERT_TRUE(restartedSearchIndex.createIndex());
+    EXPECT_FALSE(restartedSearchIndex.isSynchronized());
+    m_parser.setSearchIndex(&restartedSearchIndex);
+
+    // The outdated index is not used
+    const QStringList searchColumns = {"artist", "title", "location"};
+    auto pQuery = m_parser.parseQuery("hunter", searchColumns, "");
+    EXPECT_FALSE(pQuery->toSql().startsWith("id IN (SELECT rowid FROM library_search"));
+    EXPECT_EQ(QSet<TrackId>({trackId}), selectTrackIds(*pQuery));
+
+    ASSERT_TRUE(restartedSearchIndex.synchronizeIndex(1));
+    EXPECT_TRUE(restartedSearchIndex.isSynchronized());
+    pQuery = m_parser.parseQuery("hunter", searchColumns, "");
+    EXPECT_TRUE(pQuery->toSql().startsWith("id IN (SELECT rowid FROM library_search"));
+    EXPECT_EQ(QSet<TrackId>({trackId}), selectTrackIds(*pQuery));
+    pQuery = m_parser.parseQuery("unravel", searchColumns, "");
+    EXPECT_TRUE(selectTrackIds(*pQuery).isEmpty());
+}
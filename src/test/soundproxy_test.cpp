@@ -1,9 +1,11 @@
+#include <QTemporaryDir>
 #include <QTemporaryFile>
 #include <QtDebug>
 
 #include "test/mixxxtest.h"
 
 #include "sources/soundsourceproxy.h"
+#include "sources/audiosourcepcmcache.h"
 #include "sources/audiosourcestereoproxy.h"
 #include "track/trackmetadata.h"
 #include "util/samplebuffer.h"
@@ -590,3 +592,73 @@ TEST_F(SoundSourceProxyTest, regressionTestCachingReaderChunkJumpForward) {
         }
     }
 }
+
+TEST_F(SoundSourceProxyTest, pcmCache) {
+    QTemporaryDir cacheDir;
+    ASSERT_TRUE(cacheDir.isValid());
+    mixxx::AudioSourcePcmCache pcmCache(QDir(cacheDir.path()), quint64(1) << 30);
+
+    const SINT kReadFrameCount = 3 * mixxx::AudioSourcePcmCacheProxy::kBlockFrames / 2;
+    for (const auto& filePath : getFilePaths()) {
+        ASSERT_TRUE(SoundSourceProxy::isFileNameSupported(filePath));
+
+        mixxx::AudioSourcePointer pUncachedSource(openAudioSource(filePath));
+        if (!pUncachedSource) {
+            // skip test file
+            continue;
+        }
+        const TrackFile trackFile(filePath);
+        // The 1st instance populates the cache file and the 2nd
+        // instance reads from it
+        for (int pass = 0; pass < 2; ++pass) {
+            mixxx::AudioSourcePointer pCachedSource = pcmCache.decorate(
+                    trackFile, openAudioSource(filePath));
+            ASSERT_TRUE(pCachedSource);
+            const auto pCacheProxy =
+                    std::dynamic_pointer_cast<mixxx::AudioSourcePcmCacheProxy>(
+                            pCachedSource);
+            ASSERT_TRUE(pCacheProxy);
+            // Only the 2nd instance finds a completed cache file
+            EXPECT_EQ(pass > 0, pCacheProxy->isCompleted());
+            int readCount = 0;
+            ASSERT_EQ(pUncachedSource->frameIndexRange(),
+                    pCachedSource->frameIndexRange());
+            mixxx::SampleBuffer expectedBuffer(
+                    pUncachedSource->getSignalInfo().frames2samples(kReadFrameCount));
+            mixxx::SampleBuffer actualBuffer(
+                    pCachedSource->getSignalInfo().frames2samples(kReadFrameCount));
+            SINT frameIndex = pUncachedSource->frameIndexMin();
+            while (frameIndex < pUncachedSource->frameIndexMax()) {
+                const auto readRange = mixxx::IndexRange::forward(
+                        frameIndex, kReadFrameCount);
+                const auto expected = pUncachedSource->readSampleFrames(
+                        mixxx::WritableSampleFrames(
+                                readRange,
+                                mixxx::SampleBuffer::WritableSlice(expectedBuffer)));
+                const auto actual = pCachedSource->readSampleFrames(
+                        mixxx::WritableSampleFrames(
+                                readRange,
+                                mixxx::SampleBuffer::WritableSlice(actualBuffer)));
+                ++readCount;
+                ASSERT_EQ(expected.frameIndexRange(), actual.frameIndexRange());
+                ASSERT_EQ(expected.readableLength(), actual.readableLength());
+                expectDecodedSamplesEqual(
+                        expected.readableLength(),
+                        expected.readableData(),
+                        actual.readableData(),
+                        "Decoded samples differ from cached samples");
+                if (expected.frameIndexRange().empty()) {
+                    break;
+                }
+                frameIndex = expected.frameIndexRange().end();
+            }
+            if (pass == 0) {
+                // Completed after all sample frames have been read
+                EXPECT_TRUE(pCacheProxy->isCompleted());
+                EXPECT_EQ(0, pCacheProxy->hitCount());
+            } else {
+                EXPECT_EQ(readCount, pCacheProxy->hitCount());
+            }
+        }
+    }
+}
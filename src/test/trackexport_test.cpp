@@ -297,3 +297,72 @@ TEST_F(TrackExporterTest, MungeFilename) {
     // Remove the track we created.
     tempPath.remove("cover-test.ogg");
 }
+
+TEST_F(TrackExporterTest, ConcurrentExport) {
+    // Export more files than copy threads, all of them must arrive intact.
+    QTemporaryDir sourceTempDir;
+    ASSERT_TRUE(sourceTempDir.isValid());
+    const QDir sourceDir(sourceTempDir.path());
+    QList<TrackPointer> tracks;
+    qint64 bytesTotal = 0;
+    for (int i = 0; i < 10; ++i) {
+        const QString sourcePath =
+                sourceDir.filePath(QString("track-%1.flac").arg(i));
+        ASSERT_TRUE(QFile::copy(m_testDataDir.filePath("cover-test.flac"), sourcePath));
+        // Make each file unique
+        QFile sourceFile(sourcePath);
+        ASSERT_TRUE(sourceFile.open(QIODevice::Append));
+        sourceFile.write(QByteArray(i, 'x'));
+        sourceFile.close();
+        bytesTotal += QFileInfo(sourcePath).size();
+        tracks.append(Track::newTemporary(TrackFile(sourcePath)));
+    }
+
+    TrackExportWorker worker(m_exportDir.canonicalPath(), tracks, 3);
+    m_answerer.reset(new FakeOverwriteAnswerer(&worker));
+    qint64 bytesCopied = 0;
+    QObject::connect(&worker,
+            &TrackExportWorker::transferProgress,
+            [&bytesCopied](qint64 copied, qint64 total, qint64) {
+                EXPECT_LE(copied, total);
+                bytesCopied = copied;
+            });
+
+    worker.run();
+    EXPECT_TRUE(worker.wait(10000));
+
+    EXPECT_EQ(10, m_answerer->currentProgress());
+    EXPECT_EQ(10, m_answerer->currentProgressCount());
+    EXPECT_EQ(bytesTotal, bytesCopied);
+    EXPECT_TRUE(worker.errorMessage().isEmpty());
+
+    for (int i = 0; i < 10; ++i) {
+        const QString fileName = QString("track-%1.flac").arg(i);
+        QFile sourceFile(sourceDir.filePath(fileName));
+        QFile exportedFile(m_exportDir.filePath(fileName));
+        ASSERT_TRUE(sourceFile.open(QIODevice::ReadOnly));
+        ASSERT_TRUE(exportedFile.open(QIODevice::ReadOnly));
+        EXPECT_EQ(sourceFile.readAll(), exportedFile.readAll());
+    }
+}
+
+TEST_F(TrackExporterTest, PreservePermissions) {
+    QTemporaryDir sourceTempDir;
+    ASSERT_TRUE(sourceTempDir.isValid());
+    const QString sourcePath = QDir(sourceTempDir.path()).filePath("cover-test.flac");
+    ASSERT_TRUE(QFile::copy(m_testDataDir.filePath("cover-test.flac"), sourcePath));
+    const QFile::Permissions permissions =
+            QFile::ReadOwner | QFile::ReadUser | QFile::ReadGroup;
+    ASSERT_TRUE(QFile::setPermissions(sourcePath, permissions));
+
+    QList<TrackPointer> tracks;
+    tracks.append(Track::newTemporary(TrackFile(sourcePath)));
+    TrackExportWorker worker(m_exportDir.canonicalPath(), tracks);
+    m_answerer.reset(new FakeOverwriteAnswerer(&worker));
+
+    worker.run();
+    EXPECT_TRUE(worker.wait(10000));
+    EXPECT_TRUE(worker.errorMessage().isEmpty());
+
+    EXPECT_EQ(permissions, QFile::permissions(m_exportDir.filePath("cover-test.flac")));
+}
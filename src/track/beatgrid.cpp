@@ -41,8 +41,7 @@ BeatGrid::BeatGrid(
         const Track& track,
         SINT iSampleRate)
         : m_mutex(QMutex::Recursive),
-          m_iSampleRate(iSampleRate > 0 ? iSampleRate : track.getSampleRate()),
-          m_dBeatLength(0.0) {
+          m_iSampleRate(iSampleRate > 0 ? iSampleRate : track.getSampleRate()) {
     // BeatGrid should live in the same thread as the track it is associated
     // with.
     moveToThread(track.thread());
@@ -60,9 +59,9 @@ BeatGrid::BeatGrid(const BeatGrid& other)
         : m_mutex(QMutex::Recursive),
           m_subVersion(other.m_subVersion),
           m_iSampleRate(other.m_iSampleRate),
-          m_grid(other.m_grid),
-          m_dBeatLength(other.m_dBeatLength) {
+          m_grid(other.m_grid) {
     moveToThread(other.thread());
+    m_snapshot.setValue(other.m_snapshot.getValue());
 }
 
 void BeatGrid::setGrid(double dBpm, double dFirstBeatSample) {
@@ -73,8 +72,16 @@ void BeatGrid::setGrid(double dBpm, double dFirstBeatSample) {
     QMutexLocker lock(&m_mutex);
     m_grid.mutable_bpm()->set_bpm(dBpm);
     m_grid.mutable_first_beat()->set_frame_position(dFirstBeatSample / kFrameSize);
+    updateSnapshot();
+}
+
+void BeatGrid::updateSnapshot() {
+    GridSnapshot snapshot;
+    snapshot.bpm = bpm();
+    snapshot.firstBeatSample = firstBeatSample();
     // Calculate beat length as sample offsets
-    m_dBeatLength = (60.0 * m_iSampleRate / dBpm) * kFrameSize;
+    snapshot.beatLength = (60.0 * m_iSampleRate / snapshot.bpm) * kFrameSize;
+    m_snapshot.setValue(snapshot);
 }
 
 QByteArray BeatGrid::toByteArray() const {
@@ -94,7 +101,7 @@ void BeatGrid::readByteArray(const QByteArray& byteArray) {
     mixxx::track::io::BeatGrid grid;
     if (grid.ParseFromArray(byteArray.constData(), byteArray.length())) {
         m_grid = grid;
-        m_dBeatLength = (60.0 * m_iSampleRate / bpm()) * kFrameSize;
+        updateSnapshot();
         return;
     }
 
@@ -117,7 +124,6 @@ double BeatGrid::bpm() const {
 }
 
 QString BeatGrid::getVersion() const {
-    QMutexLocker locker(&m_mutex);
     return BEAT_GRID_2_VERSION;
 }
 
@@ -149,8 +155,7 @@ double BeatGrid::findPrevBeat(double dSamples) const {
 
 // This is an internal call. This could be implemented in the Beats Class itself.
 double BeatGrid::findClosestBeat(double dSamples) const {
-    QMutexLocker locker(&m_mutex);
-    if (!isValid()) {
+    if (!isValid(m_snapshot.getValue())) {
         return -1;
     }
     double prevBeat;
@@ -166,12 +171,15 @@ double BeatGrid::findClosestBeat(double dSamples) const {
 }
 
 double BeatGrid::findNthBeat(double dSamples, int n) const {
-    QMutexLocker locker(&m_mutex);
-    if (!isValid() || n == 0) {
+    return findNthBeat(m_snapshot.getValue(), dSamples, n);
+}
+
+double BeatGrid::findNthBeat(const GridSnapshot& snapshot, double dSamples, int n) const {
+    if (!isValid(snapshot) || n == 0) {
         return -1;
     }
 
-    double beatFraction = (dSamples - firstBeatSample()) / m_dBeatLength;
+    double beatFraction = (dSamples - snapshot.firstBeatSample) / snapshot.beatLength;
     double prevBeat = floor(beatFraction);
     double nextBeat = ceil(beatFraction);
 
@@ -196,35 +204,31 @@ double BeatGrid::findNthBeat(double dSamples, int n) const {
     double dClosestBeat;
     if (n > 0) {
         // We're going forward, so use ceil to round up to the next multiple of
-        // m_dBeatLength
-        dClosestBeat = nextBeat * m_dBeatLength + firstBeatSample();
+        // the beat length
+        dClosestBeat = nextBeat * snapshot.beatLength + snapshot.firstBeatSample;
         n = n - 1;
     } else {
         // We're going backward, so use floor to round down to the next multiple
-        // of m_dBeatLength
-        dClosestBeat = prevBeat * m_dBeatLength + firstBeatSample();
+        // of the beat length
+        dClosestBeat = prevBeat * snapshot.beatLength + snapshot.firstBeatSample;
         n = n + 1;
     }
 
-    double dResult = dClosestBeat + n * m_dBeatLength;
+    double dResult = dClosestBeat + n * snapshot.beatLength;
     return dResult;
 }
 
 bool BeatGrid::findPrevNextBeats(double dSamples,
                                  double* dpPrevBeatSamples,
                                  double* dpNextBeatSamples) const {
-    double dFirstBeatSample;
-    double dBeatLength;
-    {
-        QMutexLocker locker(&m_mutex);
-        if (!isValid()) {
-            *dpPrevBeatSamples = -1.0;
-            *dpNextBeatSamples = -1.0;
-            return false;
-        }
-        dFirstBeatSample = firstBeatSample();
-        dBeatLength = m_dBeatLength;
+    const GridSnapshot snapshot = m_snapshot.getValue();
+    if (!isValid(snapshot)) {
+        *dpPrevBeatSamples = -1.0;
+        *dpNextBeatSamples = -1.0;
+        return false;
     }
+    const double dFirstBeatSample = snapshot.firstBeatSample;
+    const double dBeatLength = snapshot.beatLength;
 
     double beatFraction = (dSamples - dFirstBeatSample) / dBeatLength;
     double prevBeat = floor(beatFraction);
@@ -250,25 +254,25 @@ bool BeatGrid::findPrevNextBeats(double dSamples,
 
 
 std::unique_ptr<BeatIterator> BeatGrid::findBeats(double startSample, double stopSample) const {
-    QMutexLocker locker(&m_mutex);
-    if (!isValid() || startSample > stopSample) {
+    const GridSnapshot snapshot = m_snapshot.getValue();
+    if (!isValid(snapshot) || startSample > stopSample) {
         return std::unique_ptr<BeatIterator>();
     }
     //qDebug() << "BeatGrid::findBeats startSample" << startSample << "stopSample"
-    //         << stopSample << "beatlength" << m_dBeatLength << "BPM" << bpm();
-    double curBeat = findNextBeat(startSample);
+    //         << stopSample << "beatlength" << snapshot.beatLength << "BPM" << snapshot.bpm;
+    double curBeat = findNthBeat(snapshot, startSample, 1);
     if (curBeat == -1.0) {
         return std::unique_ptr<BeatIterator>();
     }
-    return std::make_unique<BeatGridIterator>(m_dBeatLength, curBeat, stopSample);
+    return std::make_unique<BeatGridIterator>(snapshot.beatLength, curBeat, stopSample);
 }
 
 bool BeatGrid::hasBeatInRange(double startSample, double stopSample) const {
-    QMutexLocker locker(&m_mutex);
-    if (!isValid() || startSample > stopSample) {
+    const GridSnapshot snapshot = m_snapshot.getValue();
+    if (!isValid(snapshot) || startSample > stopSample) {
         return false;
     }
-    double curBeat = findNextBeat(startSample);
+    double curBeat = findNthBeat(snapshot, startSample, 1);
     if (curBeat != -1.0 && curBeat <= stopSample) {
         return true;
     }
@@ -276,30 +280,30 @@ bool BeatGrid::hasBeatInRange(double startSample, double stopSample) const {
 }
 
 double BeatGrid::getBpm() const {
-    QMutexLocker locker(&m_mutex);
-    if (!isValid()) {
+    const GridSnapshot snapshot = m_snapshot.getValue();
+    if (!isValid(snapshot)) {
         return 0;
     }
-    return bpm();
+    return snapshot.bpm;
 }
 
 double BeatGrid::getBpmRange(double startSample, double stopSample) const {
-    QMutexLocker locker(&m_mutex);
-    if (!isValid() || startSample > stopSample) {
+    const GridSnapshot snapshot = m_snapshot.getValue();
+    if (!isValid(snapshot) || startSample > stopSample) {
         return -1;
     }
-    return bpm();
+    return snapshot.bpm;
 }
 
 double BeatGrid::getBpmAroundPosition(double curSample, int n) const {
     Q_UNUSED(curSample);
     Q_UNUSED(n);
 
-    QMutexLocker locker(&m_mutex);
-    if (!isValid()) {
+    const GridSnapshot snapshot = m_snapshot.getValue();
+    if (!isValid(snapshot)) {
         return -1;
     }
-    return bpm();
+    return snapshot.bpm;
 }
 
 void BeatGrid::addBeat(double dBeatSample) {
@@ -321,6 +325,7 @@ void BeatGrid::translate(double dNumSamples) {
     }
     double newFirstBeatFrames = (firstBeatSample() + dNumSamples) / kFrameSize;
     m_grid.mutable_first_beat()->set_frame_position(newFirstBeatFrames);
+    updateSnapshot();
     locker.unlock();
     emit updated();
 }
@@ -360,7 +365,7 @@ void BeatGrid::setBpm(double dBpm) {
         dBpm = getMaxBpm();
     }
     m_grid.mutable_bpm()->set_bpm(dBpm);
-    m_dBeatLength = (60.0 * m_iSampleRate / dBpm) * kFrameSize;
+    updateSnapshot();
     locker.unlock();
     emit updated();
 }
@@ -3,6 +3,7 @@
 
 #include <QMutex>
 
+#include "control/controlvalue.h"
 #include "track/track.h"
 #include "track/beats.h"
 #include "proto/beats.pb.h"
@@ -77,14 +78,32 @@ class BeatGrid final : public Beats {
     }
 
   private:
+    // Copy of the grid parameters that is published for lock-free lookups
+    // from the engine thread. m_grid is only accessed while holding m_mutex.
+    struct GridSnapshot {
+        double bpm = 0.0;
+        double firstBeatSample = 0.0;
+        // The length of a beat in samples
+        double beatLength = 0.0;
+    };
+
     BeatGrid(const BeatGrid& other);
     double firstBeatSample() const;
     double bpm() const;
 
     void readByteArray(const QByteArray& byteArray);
+    // Publishes the current state of m_grid to m_snapshot
+    void updateSnapshot();
     // For internal use only.
     bool isValid() const;
+    bool isValid(const GridSnapshot& snapshot) const {
+        return m_iSampleRate > 0 && snapshot.bpm > 0;
+    }
+
+    double findNthBeat(const GridSnapshot& snapshot, double dSamples, int n) const;
 
+    // Guards the modification and serialization of m_grid. Lookups don't
+    // need to lock this mutex.
     mutable QMutex m_mutex;
     // The sub-version of this beatgrid.
     QString m_subVersion;
@@ -92,8 +111,7 @@ class BeatGrid final : public Beats {
     SINT m_iSampleRate;
     // Data storage for BeatGrid
     mixxx::track::io::BeatGrid m_grid;
-    // The length of a beat in samples
-    double m_dBeatLength;
+    ControlValueAtomic<GridSnapshot> m_snapshot;
 };
 
 } // namespace mixxx
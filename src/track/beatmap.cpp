@@ -26,7 +26,7 @@ inline double framesToSamples(const int frames) {
     return frames * kFrameSize;
 }
 
-bool BeatLessThan(const Beat& beat1, const Beat& beat2) {
+inline bool BeatLessThan(const Beat& beat1, const Beat& beat2) {
     return beat1.frame_position() < beat2.frame_position();
 }
 
@@ -34,13 +34,13 @@ namespace mixxx {
 
 class BeatMapIterator : public BeatIterator {
   public:
-    BeatMapIterator(BeatList::const_iterator start, BeatList::const_iterator end)
-            : m_currentBeat(start),
+    // The iterator keeps the snapshot alive while iterating over it
+    BeatMapIterator(BeatMap::SnapshotPointer pSnapshot,
+            std::vector<double>::const_iterator start,
+            std::vector<double>::const_iterator end)
+            : m_pSnapshot(std::move(pSnapshot)),
+              m_currentBeat(start),
               m_endBeat(end) {
-        // Advance to the first enabled beat.
-        while (m_currentBeat != m_endBeat && !m_currentBeat->enabled()) {
-            ++m_currentBeat;
-        }
     }
 
     virtual bool hasNext() const {
@@ -48,24 +48,23 @@ class BeatMapIterator : public BeatIterator {
     }
 
     virtual double next() {
-        double beat = framesToSamples(m_currentBeat->frame_position());
+        double beat = framesToSamples(*m_currentBeat);
         ++m_currentBeat;
-        while (m_currentBeat != m_endBeat && !m_currentBeat->enabled()) {
-            ++m_currentBeat;
-        }
         return beat;
     }
 
   private:
-    BeatList::const_iterator m_currentBeat;
-    BeatList::const_iterator m_endBeat;
+    BeatMap::SnapshotPointer m_pSnapshot;
+    std::vector<double>::const_iterator m_currentBeat;
+    std::vector<double>::const_iterator m_endBeat;
 };
 
 BeatMap::BeatMap(const Track& track, SINT iSampleRate)
         : m_mutex(QMutex::Recursive),
           m_iSampleRate(iSampleRate > 0 ? iSampleRate : track.getSampleRate()),
-          m_dCachedBpm(0),
-          m_dLastFrame(0) {
+          m_pSnapshot(new Snapshot),
+          m_pPublishedSnapshot(m_pSnapshot.data()),
+          m_activeReaders(0) {
     // BeatMap should live in the same thread as the track it is associated
     // with.
     moveToThread(track.thread());
@@ -89,9 +88,11 @@ BeatMap::BeatMap (const BeatMap& other)
         : m_mutex(QMutex::Recursive),
           m_subVersion(other.m_subVersion),
           m_iSampleRate(other.m_iSampleRate),
-          m_dCachedBpm(other.m_dCachedBpm),
-          m_dLastFrame(other.m_dLastFrame),
-          m_beats(other.m_beats) {
+          m_beats(other.m_beats),
+          // Snapshots are immutable and can be shared
+          m_pSnapshot(other.m_pSnapshot),
+          m_pPublishedSnapshot(m_pSnapshot.data()),
+          m_activeReaders(0) {
     moveToThread(other.thread());
 }
 
@@ -154,7 +155,6 @@ void BeatMap::createFromBeatVector(const QVector<double>& beats) {
 }
 
 QString BeatMap::getVersion() const {
-    QMutexLocker locker(&m_mutex);
     return BEAT_MAP_VERSION;
 }
 
@@ -180,13 +180,13 @@ double BeatMap::findPrevBeat(double dSamples) const {
 }
 
 double BeatMap::findClosestBeat(double dSamples) const {
-    QMutexLocker locker(&m_mutex);
-    if (!isValid()) {
+    const SnapshotReader pSnapshot(*this);
+    if (!isValid(*pSnapshot)) {
         return -1;
     }
     double prevBeat;
     double nextBeat;
-    findPrevNextBeats(dSamples, &prevBeat, &nextBeat);
+    findPrevNextBeats(*pSnapshot, dSamples, &prevBeat, &nextBeat);
     if (prevBeat == -1) {
         // If both values are -1, we correctly return -1.
         return nextBeat;
@@ -197,38 +197,39 @@ double BeatMap::findClosestBeat(double dSamples) const {
 }
 
 double BeatMap::findNthBeat(double dSamples, int n) const {
-    QMutexLocker locker(&m_mutex);
+    return findNthBeat(*SnapshotReader(*this), dSamples, n);
+}
 
-    if (!isValid() || n == 0) {
+double BeatMap::findNthBeat(const Snapshot& snapshot, double dSamples, int n) const {
+    if (!isValid(snapshot) || n == 0) {
         return -1;
     }
 
-    Beat beat;
+    const std::vector<double>& frames = snapshot.frames;
     // Reduce sample offset to a frame offset.
-    beat.set_frame_position(samplesToFrames(dSamples));
+    const double frame = samplesToFrames(dSamples);
 
     // it points at the first occurrence of beat or the next largest beat
-    BeatList::const_iterator it =
-            std::lower_bound(m_beats.constBegin(), m_beats.constEnd(), beat, BeatLessThan);
+    auto it = std::lower_bound(frames.cbegin(), frames.cend(), frame);
 
     // If the position is within 1/10th of a second of the next or previous
     // beat, pretend we are on that beat.
     const double kFrameEpsilon = 0.1 * m_iSampleRate;
 
     // Back-up by one.
-    if (it != m_beats.begin()) {
+    if (it != frames.cbegin()) {
         --it;
     }
 
     // Scan forward to find whether we are on a beat.
-    BeatList::const_iterator on_beat = m_beats.constEnd();
-    BeatList::const_iterator previous_beat = m_beats.constEnd();
-    BeatList::const_iterator next_beat = m_beats.constEnd();
-    for (; it != m_beats.end(); ++it) {
-        qint32 delta = it->frame_position() - beat.frame_position();
+    auto on_beat = frames.cend();
+    auto previous_beat = frames.cend();
+    auto next_beat = frames.cend();
+    for (; it != frames.cend(); ++it) {
+        const double delta = *it - frame;
 
         // We are "on" this beat.
-        if (abs(delta) < kFrameEpsilon) {
+        if (fabs(delta) < kFrameEpsilon) {
             on_beat = it;
             break;
         }
@@ -248,36 +249,22 @@ double BeatMap::findNthBeat(double dSamples, int n) const {
 
     // If we are within epsilon samples of a beat then the immediately next and
     // previous beats are the beat we are on.
-    if (on_beat != m_beats.end()) {
+    if (on_beat != frames.cend()) {
         next_beat = on_beat;
         previous_beat = on_beat;
     }
 
-    if (n > 0) {
-        for (; next_beat != m_beats.end(); ++next_beat) {
-            if (!next_beat->enabled()) {
-                continue;
-            }
-            if (n == 1) {
-                // Return a sample offset
-                return framesToSamples(next_beat->frame_position());
-            }
-            --n;
+    // All beats in the snapshot are enabled, so the Nth beat can be
+    // looked up directly.
+    if (n > 0 && next_beat != frames.cend()) {
+        if (frames.cend() - next_beat >= n) {
+            // Return a sample offset
+            return framesToSamples(next_beat[n - 1]);
         }
-    } else if (n < 0 && previous_beat != m_beats.end()) {
-        for (; true; --previous_beat) {
-            if (previous_beat->enabled()) {
-                if (n == -1) {
-                    // Return a sample offset
-                    return framesToSamples(previous_beat->frame_position());
-                }
-                ++n;
-            }
-
-            // Don't step before the start of the list.
-            if (previous_beat == m_beats.begin()) {
-                break;
-            }
+    } else if (n < 0 && previous_beat != frames.cend()) {
+        if (previous_beat - frames.cbegin() >= -n - 1) {
+            // Return a sample offset
+            return framesToSamples(previous_beat[n + 1]);
         }
     }
     return -1;
@@ -286,40 +273,45 @@ double BeatMap::findNthBeat(double dSamples, int n) const {
 bool BeatMap::findPrevNextBeats(double dSamples,
                                 double* dpPrevBeatSamples,
                                 double* dpNextBeatSamples) const {
-    QMutexLocker locker(&m_mutex);
+    return findPrevNextBeats(*SnapshotReader(*this), dSamples,
+            dpPrevBeatSamples, dpNextBeatSamples);
+}
 
-    if (!isValid()) {
+bool BeatMap::findPrevNextBeats(const Snapshot& snapshot,
+                                double dSamples,
+                                double* dpPrevBeatSamples,
+                                double* dpNextBeatSamples) const {
+    if (!isValid(snapshot)) {
         *dpPrevBeatSamples = -1;
         *dpNextBeatSamples = -1;
         return false;
     }
 
-    Beat beat;
+    const std::vector<double>& frames = snapshot.frames;
     // Reduce sample offset to a frame offset.
-    beat.set_frame_position(samplesToFrames(dSamples));
+    const double frame = samplesToFrames(dSamples);
 
     // it points at the first occurrence of beat or the next largest beat
-    BeatList::const_iterator it =
-            std::lower_bound(m_beats.constBegin(), m_beats.constEnd(), beat, BeatLessThan);
+    auto it = std::lower_bound(frames.cbegin(), frames.cend(), frame);
 
     // If the position is within 1/10th of a second of the next or previous
     // beat, pretend we are on that beat.
     const double kFrameEpsilon = 0.1 * m_iSampleRate;
 
     // Back-up by one.
-    if (it != m_beats.begin()) {
+    if (it != frames.cbegin()) {
         --it;
     }
 
     // Scan forward to find whether we are on a beat.
-    BeatList::const_iterator on_beat = m_beats.constEnd();
-    BeatList::const_iterator previous_beat = m_beats.constEnd();
-    BeatList::const_iterator next_beat = m_beats.constEnd();
-    for (; it != m_beats.end(); ++it) {
-        qint32 delta = it->frame_position() - beat.frame_position();
+    auto on_beat = frames.cend();
+    auto previous_beat = frames.cend();
+    auto next_beat = frames.cend();
+    for (; it != frames.cend(); ++it) {
+        const double delta = *it - frame;
 
         // We are "on" this beat.
-        if (abs(delta) < kFrameEpsilon) {
+        if (fabs(delta) < kFrameEpsilon) {
             on_beat = it;
             break;
         }
@@ -339,121 +331,104 @@ bool BeatMap::findPrevNextBeats(double dSamples,
 
     // If we are within epsilon samples of a beat then the immediately next and
     // previous beats are the beat we are on.
-    if (on_beat != m_beats.end()) {
+    if (on_beat != frames.cend()) {
         previous_beat = on_beat;
         next_beat = on_beat + 1;
     }
 
-    *dpPrevBeatSamples = -1;
-    *dpNextBeatSamples = -1;
-
-    for (; next_beat != m_beats.end(); ++next_beat) {
-        if (!next_beat->enabled()) {
-            continue;
-        }
-        *dpNextBeatSamples = framesToSamples(next_beat->frame_position());
-        break;
-    }
-    if (previous_beat != m_beats.end()) {
-        for (; true; --previous_beat) {
-            if (previous_beat->enabled()) {
-                *dpPrevBeatSamples = framesToSamples(previous_beat->frame_position());
-                break;
-            }
-
-            // Don't step before the start of the list.
-            if (previous_beat == m_beats.begin()) {
-                break;
-            }
-        }
-    }
+    *dpPrevBeatSamples = previous_beat != frames.cend() ?
+            framesToSamples(*previous_beat) : -1;
+    *dpNextBeatSamples = next_beat != frames.cend() ?
+            framesToSamples(*next_beat) : -1;
     return *dpPrevBeatSamples != -1 && *dpNextBeatSamples != -1;
 }
 
 std::unique_ptr<BeatIterator> BeatMap::findBeats(double startSample, double stopSample) const {
+    // The iterator is used outside of the engine thread and holds
+    // a reference
     QMutexLocker locker(&m_mutex);
+    const SnapshotPointer pSnapshot = m_pSnapshot;
+    locker.unlock();
     //startSample and stopSample are sample offsets, converting them to
     //frames
-    if (!isValid() || startSample > stopSample) {
+    if (!isValid(*pSnapshot) || startSample > stopSample) {
         return std::unique_ptr<BeatIterator>();
     }
 
-    Beat startBeat, stopBeat;
-    startBeat.set_frame_position(samplesToFrames(startSample));
-    stopBeat.set_frame_position(samplesToFrames(stopSample));
-
-    BeatList::const_iterator curBeat =
-            std::lower_bound(m_beats.constBegin(), m_beats.constEnd(),
-                        startBeat, BeatLessThan);
-
-    BeatList::const_iterator lastBeat =
-            std::upper_bound(m_beats.constBegin(), m_beats.constEnd(),
-                        stopBeat, BeatLessThan);
+    const std::vector<double>& frames = pSnapshot->frames;
+    auto curBeat = std::lower_bound(frames.cbegin(), frames.cend(),
+            samplesToFrames(startSample));
+    auto lastBeat = std::upper_bound(frames.cbegin(), frames.cend(),
+            samplesToFrames(stopSample));
 
     if (curBeat >= lastBeat) {
         return std::unique_ptr<BeatIterator>();
     }
-    return std::make_unique<BeatMapIterator>(curBeat, lastBeat);
+    return std::make_unique<BeatMapIterator>(
+            pSnapshot,
+            curBeat,
+            lastBeat);
 }
 
 bool BeatMap::hasBeatInRange(double startSample, double stopSample) const {
-    QMutexLocker locker(&m_mutex);
-    if (!isValid() || startSample > stopSample) {
+    const SnapshotReader pSnapshot(*this);
+    if (!isValid(*pSnapshot) || startSample > stopSample) {
         return false;
     }
-    double curBeat = findNextBeat(startSample);
-    if (curBeat <= stopSample) {
+    double curBeat = findNthBeat(*pSnapshot, startSample, 1);
+    if (curBeat != -1 && curBeat <= stopSample) {
         return true;
     }
     return false;
 }
 
 double BeatMap::getBpm() const {
-    QMutexLocker locker(&m_mutex);
-    if (!isValid())
+    const SnapshotReader pSnapshot(*this);
+    if (!isValid(*pSnapshot))
         return -1;
-    return m_dCachedBpm;
+    return pSnapshot->bpm;
 }
 
 double BeatMap::getBpmRange(double startSample, double stopSample) const {
-    QMutexLocker locker(&m_mutex);
-    if (!isValid())
+    const SnapshotReader pSnapshot(*this);
+    if (!isValid(*pSnapshot))
         return -1;
-    Beat startBeat, stopBeat;
-    startBeat.set_frame_position(samplesToFrames(startSample));
-    stopBeat.set_frame_position(samplesToFrames(stopSample));
-    return calculateBpm(startBeat, stopBeat);
+    return calculateBpm(*pSnapshot,
+            samplesToFrames(startSample),
+            samplesToFrames(stopSample));
 }
 
 double BeatMap::getBpmAroundPosition(double curSample, int n) const {
-    QMutexLocker locker(&m_mutex);
-    if (!isValid())
+    const SnapshotReader pSnapshot(*this);
+    if (!isValid(*pSnapshot))
         return -1;
 
+    const double firstBeat = framesToSamples(pSnapshot->frames.front());
+    const double lastBeat = framesToSamples(pSnapshot->frames.back());
+
     // To make sure we are always counting n beats, iterate backward to the
     // lower bound, then iterate forward from there to the upper bound.
     // a value of -1 indicates we went off the map -- count from the beginning.
-    double lower_bound = findNthBeat(curSample, -n);
+    double lower_bound = findNthBeat(*pSnapshot, curSample, -n);
     if (lower_bound == -1) {
-        lower_bound = framesToSamples(m_beats.first().frame_position());
+        lower_bound = firstBeat;
     }
 
     // If we hit the end of the beat map, recalculate the lower bound.
-    double upper_bound = findNthBeat(lower_bound, n * 2);
+    double upper_bound = findNthBeat(*pSnapshot, lower_bound, n * 2);
     if (upper_bound == -1) {
-        upper_bound = framesToSamples(m_beats.last().frame_position());
-        lower_bound = findNthBeat(upper_bound, n * -2);
+        upper_bound = lastBeat;
+        lower_bound = findNthBeat(*pSnapshot, upper_bound, n * -2);
         // Super edge-case -- the track doesn't have n beats!  Do the best
         // we can.
         if (lower_bound == -1) {
-            lower_bound = framesToSamples(m_beats.first().frame_position());
+            lower_bound = firstBeat;
         }
     }
 
-    Beat startBeat, stopBeat;
-    startBeat.set_frame_position(samplesToFrames(lower_bound));
-    stopBeat.set_frame_position(samplesToFrames(upper_bound));
-    return calculateBpm(startBeat, stopBeat);
+    return calculateBpm(*pSnapshot,
+            samplesToFrames(lower_bound),
+            samplesToFrames(upper_bound));
 }
 
 void BeatMap::addBeat(double dBeatSample) {
@@ -689,38 +664,50 @@ void BeatMap::setBpm(double dBpm) {
 }
 
 void BeatMap::onBeatlistChanged() {
-    if (!isValid()) {
-        m_dLastFrame = 0;
-        m_dCachedBpm = 0;
-        return;
+    // Publish a new snapshot of the enabled beats. Readers that still hold
+    // the previous snapshot continue to use it until they are done.
+    auto pSnapshot = QSharedPointer<Snapshot>::create();
+    pSnapshot->frames.reserve(m_beats.size());
+    for (const Beat& beat : qAsConst(m_beats)) {
+        if (beat.enabled()) {
+            pSnapshot->frames.push_back(beat.frame_position());
+        }
+    }
+    if (isValid(*pSnapshot)) {
+        pSnapshot->bpm = calculateBpm(*pSnapshot,
+                pSnapshot->frames.front(),
+                pSnapshot->frames.back());
     }
-    m_dLastFrame = m_beats.last().frame_position();
-    Beat startBeat = m_beats.first();
-    Beat stopBeat =  m_beats.last();
-    m_dCachedBpm = calculateBpm(startBeat, stopBeat);
+    publishSnapshot(pSnapshot);
 }
 
-double BeatMap::calculateBpm(const Beat& startBeat, const Beat& stopBeat) const {
-    if (startBeat.frame_position() > stopBeat.frame_position()) {
-        return -1;
+void BeatMap::publishSnapshot(SnapshotPointer pSnapshot) {
+    m_replacedSnapshots.append(std::move(m_pSnapshot));
+    m_pSnapshot = std::move(pSnapshot);
+    m_pPublishedSnapshot.store(m_pSnapshot.data());
+    // Readers that arrive from now on only access the new snapshot
+    if (m_activeReaders.load() == 0) {
+        m_replacedSnapshots.clear();
     }
+}
 
-    BeatList::const_iterator curBeat =
-            std::lower_bound(m_beats.constBegin(), m_beats.constEnd(), startBeat, BeatLessThan);
+double BeatMap::calculateBpm(const Snapshot& snapshot,
+        double startFrame, double stopFrame) const {
+    if (startFrame > stopFrame) {
+        return -1;
+    }
 
-    BeatList::const_iterator lastBeat =
-            std::upper_bound(m_beats.constBegin(), m_beats.constEnd(), stopBeat, BeatLessThan);
+    const std::vector<double>& frames = snapshot.frames;
+    auto curBeat = std::lower_bound(frames.cbegin(), frames.cend(), startFrame);
+    auto lastBeat = std::upper_bound(frames.cbegin(), frames.cend(), stopFrame);
+    if (curBeat >= lastBeat) {
+        return -1;
+    }
 
     QVector<double> beatvect;
+    beatvect.reserve(static_cast<int>(lastBeat - curBeat));
     for (; curBeat != lastBeat; ++curBeat) {
-        const Beat& beat = *curBeat;
-        if (beat.enabled()) {
-            beatvect.append(beat.frame_position());
-        }
-    }
-
-    if (beatvect.isEmpty()) {
-        return -1;
+        beatvect.append(*curBeat);
     }
 
     return BeatUtils::calculateBpm(beatvect, m_iSampleRate, 0, 9999);
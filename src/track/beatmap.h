@@ -9,6 +9,10 @@
 #define BEATMAP_H_
 
 #include <QMutex>
+#include <QSharedPointer>
+
+#include <atomic>
+#include <vector>
 
 #include "track/track.h"
 #include "track/beats.h"
@@ -86,15 +90,68 @@ class BeatMap final : public Beats {
     }
 
   private:
+    friend class BeatMapIterator;
+
+    // Immutable copy of the positions of all enabled beats in frames, sorted
+    // in ascending order. All lookups operate on a snapshot that is replaced
+    // as a whole when the beats are modified. This allows lock-free lookups
+    // from the engine thread while the beats are edited from the GUI or by
+    // the analyzer.
+    struct Snapshot {
+        std::vector<double> frames;
+        double bpm = 0.0;
+    };
+    typedef QSharedPointer<const Snapshot> SnapshotPointer;
+
+    // Accesses the published snapshot during a lookup. Readers don't hold
+    // a reference, i.e. they never free a snapshot. They only announce
+    // themselves so that writers keep replaced snapshots alive until all
+    // readers are done.
+    class SnapshotReader {
+      public:
+        explicit SnapshotReader(const BeatMap& beatMap)
+                : m_activeReaders(beatMap.m_activeReaders) {
+            m_activeReaders.fetch_add(1);
+            m_pSnapshot = beatMap.m_pPublishedSnapshot.load();
+        }
+        ~SnapshotReader() {
+            m_activeReaders.fetch_sub(1);
+        }
+
+        const Snapshot& operator*() const {
+            return *m_pSnapshot;
+        }
+        const Snapshot* operator->() const {
+            return m_pSnapshot;
+        }
+
+      private:
+        std::atomic<int>& m_activeReaders;
+        const Snapshot* m_pSnapshot;
+    };
+
     BeatMap(const BeatMap& other);
     bool readByteArray(const QByteArray& byteArray);
     void createFromBeatVector(const QVector<double>& beats);
     void onBeatlistChanged();
 
-    double calculateBpm(const mixxx::track::io::Beat& startBeat,
-                        const mixxx::track::io::Beat& stopBeat) const;
+    // Replaces the published snapshot and frees all replaced snapshots
+    // that are no longer read
+    void publishSnapshot(SnapshotPointer pSnapshot);
     // For internal use only.
     bool isValid() const;
+    bool isValid(const Snapshot& snapshot) const {
+        return m_iSampleRate > 0 && !snapshot.frames.empty();
+    }
+
+    double findNthBeat(const Snapshot& snapshot, double dSamples, int n) const;
+    bool findPrevNextBeats(const Snapshot& snapshot,
+                           double dSamples,
+                           double* dpPrevBeatSamples,
+                           double* dpNextBeatSamples) const;
+    double calculateBpm(const Snapshot& snapshot,
+                        double startFrame,
+                        double stopFrame) const;
 
     void scaleDouble();
     void scaleTriple();
@@ -103,12 +160,19 @@ class BeatMap final : public Beats {
     void scaleThird();
     void scaleFourth();
 
+    // Guards the modification and serialization of m_beats. Lookups don't
+    // need to lock this mutex.
     mutable QMutex m_mutex;
     QString m_subVersion;
     SINT m_iSampleRate;
-    double m_dCachedBpm;
-    double m_dLastFrame;
+    // The complete beat list including disabled beats that is serialized
     BeatList m_beats;
+    // The published snapshot and the replaced snapshots that might still
+    // be read. Only modified while holding m_mutex.
+    SnapshotPointer m_pSnapshot;
+    QList<SnapshotPointer> m_replacedSnapshots;
+    std::atomic<const Snapshot*> m_pPublishedSnapshot;
+    mutable std::atomic<int> m_activeReaders;
 };
 
 } // namespace mixxx
@@ -1,9 +1,11 @@
 #include "track/globaltrackcache.h"
 
 #include <QCoreApplication>
+#include <atomic>
 
 #include "util/assert.h"
 #include "util/logger.h"
+#include "util/performancetimer.h"
 #include "util/thread_affinity.h"
 
 namespace {
@@ -61,6 +63,59 @@ class EvictAndSaveFunctor {
     GlobalTrackCacheEntryPointer m_cacheEntryPtr;
 };
 
+// Only the time spent in contended locks is measured. The
+// common case of an uncontended lock neither starts a timer
+// nor writes into the shared counters.
+class LockWaitCounter {
+  public:
+    void lock(QMutex* pMutex) {
+        if (pMutex->tryLock()) {
+            return;
+        }
+        PerformanceTimer timer;
+        timer.start();
+        pMutex->lock();
+        m_contendedCount.fetch_add(1, std::memory_order_relaxed);
+        m_waitNanos.fetch_add(
+                timer.elapsed().toIntegerNanos(),
+                std::memory_order_relaxed);
+    }
+
+    GlobalTrackCacheLockWaitStats stats() const {
+        GlobalTrackCacheLockWaitStats stats;
+        stats.contendedCount = m_contendedCount.load(std::memory_order_relaxed);
+        stats.waitTime = mixxx::Duration::fromNanos(
+                m_waitNanos.load(std::memory_order_relaxed));
+        return stats;
+    }
+
+    void reset() {
+        m_contendedCount.store(0, std::memory_order_relaxed);
+        m_waitNanos.store(0, std::memory_order_relaxed);
+    }
+
+  private:
+    std::atomic<quint64> m_contendedCount{0};
+    std::atomic<qint64> m_waitNanos{0};
+};
+
+LockWaitCounter s_cacheLockWaits;
+LockWaitCounter s_shardLockWaits;
+
+class ScopedShardLock {
+  public:
+    explicit ScopedShardLock(QMutex* pMutex)
+            : m_pMutex(pMutex) {
+        s_shardLockWaits.lock(m_pMutex);
+    }
+    ~ScopedShardLock() {
+        m_pMutex->unlock();
+    }
+
+  private:
+    QMutex* const m_pMutex;
+};
+
 } // anonymous namespace
 
 GlobalTrackCacheLocker::GlobalTrackCacheLocker()
@@ -84,11 +139,12 @@ void GlobalTrackCacheLocker::lockCache() {
     if (traceLogEnabled()) {
         kLogger.trace() << "Locking cache";
     }
-    s_pInstance->m_mutex.lock();
+    s_cacheLockWaits.lock(&s_pInstance->m_mutex);
     if (traceLogEnabled()) {
         kLogger.trace() << "Cache is locked";
     }
     m_pInstance = s_pInstance;
+    ++m_pInstance->m_cacheLockDepth;
 }
 
 void GlobalTrackCacheLocker::unlockCache() {
@@ -97,11 +153,24 @@ void GlobalTrackCacheLocker::unlockCache() {
             kLogger.trace() << "Unlocking cache";
         }
         if (kLogStats && debugLogEnabled()) {
+            std::size_t tracksById = 0;
+            std::size_t tracksByCanonicalLocation = 0;
+            for (const auto& shard : m_pInstance->m_shards) {
+                tracksById += shard.tracksById.size();
+                tracksByCanonicalLocation += shard.tracksByCanonicalLocation.size();
+            }
             kLogger.debug()
                     << "#tracksById ="
-                    << m_pInstance->m_tracksById.size()
+                    << tracksById
                     << "/ #tracksByCanonicalLocation ="
-                    << m_pInstance->m_tracksByCanonicalLocation.size();
+                    << tracksByCanonicalLocation;
+        }
+        // Tracks that have been created while the cache was locked
+        // become visible for lookups without the lock. The mutex is
+        // recursive, only the outermost locker publishes them.
+        std::vector<GlobalTrackCacheEntryPointer> publishedEntries;
+        if (--m_pInstance->m_cacheLockDepth == 0) {
+            publishedEntries = m_pInstance->publishNewEntries();
         }
         m_pInstance->m_mutex.unlock();
         if (traceLogEnabled()) {
@@ -287,13 +356,74 @@ void GlobalTrackCache::evictAndSaveCachedTrack(GlobalTrackCacheEntryPointer cach
     }
 }
 
+//static
+TrackPointer GlobalTrackCache::lookupCachedTrackById(
+        const TrackId& trackId) {
+    GlobalTrackCache* pInstance = s_pInstance;
+    VERIFY_OR_DEBUG_ASSERT(pInstance) {
+        return TrackPointer();
+    }
+    bool lockRequired = false;
+    auto strongPtr = pInstance->lookupAliveById(trackId, &lockRequired);
+    if (lockRequired) {
+        // The track is about to be evicted and needs to be revived or
+        // it is still being initialized by its resolver
+        return GlobalTrackCacheLocker().lookupTrackById(trackId);
+    }
+    return strongPtr;
+}
+
+//static
+TrackPointer GlobalTrackCache::lookupCachedTrackByRef(
+        const TrackRef& trackRef) {
+    if (trackRef.hasId()) {
+        return lookupCachedTrackById(trackRef.getId());
+    }
+    GlobalTrackCache* pInstance = s_pInstance;
+    VERIFY_OR_DEBUG_ASSERT(pInstance) {
+        return TrackPointer();
+    }
+    if (!trackRef.hasCanonicalLocation()) {
+        return TrackPointer();
+    }
+    bool lockRequired = false;
+    auto strongPtr = pInstance->lookupAliveByCanonicalLocation(
+            trackRef.getCanonicalLocation(), &lockRequired);
+    if (lockRequired) {
+        // The track is about to be evicted and needs to be revived or
+        // it is still being initialized by its resolver
+        return GlobalTrackCacheLocker().lookupTrackByRef(trackRef);
+    }
+    return strongPtr;
+}
+
+//static
+GlobalTrackCacheLockWaitStats GlobalTrackCache::cacheLockWaitStats() {
+    return s_cacheLockWaits.stats();
+}
+
+//static
+GlobalTrackCacheLockWaitStats GlobalTrackCache::shardLockWaitStats() {
+    return s_shardLockWaits.stats();
+}
+
+//static
+void GlobalTrackCache::resetLockWaitStats() {
+    s_cacheLockWaits.reset();
+    s_shardLockWaits.reset();
+}
+
+GlobalTrackCache::Shard::Shard()
+        : tracksById(kUnorderedCollectionMinCapacity / kShardCount, DbId::hash_fun) {
+}
+
 GlobalTrackCache::GlobalTrackCache(
         GlobalTrackCacheSaver* pSaver,
         deleteTrackFn_t deleteTrackFn)
     : m_mutex(QMutex::Recursive),
+      m_cacheLockDepth(0),
       m_pSaver(pSaver),
-      m_deleteTrackFn(deleteTrackFn),
-      m_tracksById(kUnorderedCollectionMinCapacity, DbId::hash_fun) {
+      m_deleteTrackFn(deleteTrackFn) {
     DEBUG_ASSERT(m_pSaver);
     qRegisterMetaType<GlobalTrackCacheEntryPointer>("GlobalTrackCacheEntryPointer");
 }
@@ -302,59 +432,185 @@ GlobalTrackCache::~GlobalTrackCache() {
     deactivate();
 }
 
+GlobalTrackCache::Shard& GlobalTrackCache::shardById(
+        const TrackId& trackId) {
+    return m_shards[DbId::hash_fun(trackId) % kShardCount];
+}
+
+const GlobalTrackCache::Shard& GlobalTrackCache::shardById(
+        const TrackId& trackId) const {
+    return m_shards[DbId::hash_fun(trackId) % kShardCount];
+}
+
+//static
+std::size_t GlobalTrackCache::shardIndexByCanonicalLocation(
+        const QString& canonicalLocation) {
+    return qHash(canonicalLocation) % kShardCount;
+}
+
+TrackPointer GlobalTrackCache::lookupAliveById(
+        const TrackId& trackId,
+        bool* /*out*/ pLockRequired) const {
+    DEBUG_ASSERT(pLockRequired);
+    const Shard& shard = shardById(trackId);
+    ScopedShardLock lock(&shard.mutex);
+    const auto trackById = shard.tracksById.find(trackId);
+    if (shard.tracksById.end() == trackById) {
+        *pLockRequired = false;
+        return TrackPointer();
+    }
+    if (!trackById->second->isPublished()) {
+        *pLockRequired = true;
+        return TrackPointer();
+    }
+    auto strongPtr = trackById->second->lock();
+    *pLockRequired = !strongPtr;
+    return strongPtr;
+}
+
+TrackPointer GlobalTrackCache::lookupAliveByCanonicalLocation(
+        const QString& canonicalLocation,
+        bool* /*out*/ pLockRequired) const {
+    DEBUG_ASSERT(pLockRequired);
+    const Shard& shard = m_shards[shardIndexByCanonicalLocation(canonicalLocation)];
+    ScopedShardLock lock(&shard.mutex);
+    const auto trackByCanonicalLocation =
+            shard.tracksByCanonicalLocation.find(canonicalLocation);
+    if (shard.tracksByCanonicalLocation.end() == trackByCanonicalLocation) {
+        *pLockRequired = false;
+        return TrackPointer();
+    }
+    if (!trackByCanonicalLocation->second->isPublished()) {
+        *pLockRequired = true;
+        return TrackPointer();
+    }
+    auto strongPtr = trackByCanonicalLocation->second->lock();
+    *pLockRequired = !strongPtr;
+    return strongPtr;
+}
+
+std::vector<GlobalTrackCacheEntryPointer> GlobalTrackCache::publishNewEntries() {
+    std::vector<GlobalTrackCacheEntryPointer> publishedEntries;
+    if (m_newEntries.empty()) {
+        return publishedEntries;
+    }
+    publishedEntries.reserve(m_newEntries.size());
+    // The entry might be accessed concurrently through the shards
+    // of both its id and its canonical location
+    lockAllShards();
+    for (const auto& newEntry : m_newEntries) {
+        auto entryPtr = newEntry.lock();
+        if (entryPtr) {
+            entryPtr->publish();
+            publishedEntries.push_back(std::move(entryPtr));
+        }
+    }
+    unlockAllShards();
+    m_newEntries.clear();
+    return publishedEntries;
+}
+
+void GlobalTrackCache::eraseById(const TrackId& trackId) {
+    // The erased entry must outlive the lock, because deleting
+    // the track object might access the cache again
+    GlobalTrackCacheEntryPointer entryPtr;
+    Shard& shard = shardById(trackId);
+    ScopedShardLock lock(&shard.mutex);
+    const auto trackById = shard.tracksById.find(trackId);
+    if (shard.tracksById.end() != trackById) {
+        entryPtr = std::move(trackById->second);
+        shard.tracksById.erase(trackById);
+    }
+}
+
+void GlobalTrackCache::eraseByCanonicalLocation(const QString& canonicalLocation) {
+    // The erased entry must outlive the lock, because deleting
+    // the track object might access the cache again
+    GlobalTrackCacheEntryPointer entryPtr;
+    Shard& shard = m_shards[shardIndexByCanonicalLocation(canonicalLocation)];
+    ScopedShardLock lock(&shard.mutex);
+    const auto trackByCanonicalLocation =
+            shard.tracksByCanonicalLocation.find(canonicalLocation);
+    if (shard.tracksByCanonicalLocation.end() != trackByCanonicalLocation) {
+        entryPtr = std::move(trackByCanonicalLocation->second);
+        shard.tracksByCanonicalLocation.erase(trackByCanonicalLocation);
+    }
+}
+
+void GlobalTrackCache::lockAllShards() const {
+    // Only the owner of m_mutex may lock multiple shards
+    for (const auto& shard : m_shards) {
+        s_shardLockWaits.lock(&shard.mutex);
+    }
+}
+
+void GlobalTrackCache::unlockAllShards() const {
+    for (auto i = m_shards.rbegin(); i != m_shards.rend(); ++i) {
+        i->mutex.unlock();
+    }
+}
+
 void GlobalTrackCache::relocateTracks(
         GlobalTrackCacheRelocator* pRelocator) {
     if (debugLogEnabled()) {
         kLogger.debug()
                 << "Relocating tracks";
     }
-    TracksByCanonicalLocation relocatedTracksByCanonicalLocation;
-    for (auto&&
-            i = m_tracksByCanonicalLocation.begin();
-            i != m_tracksByCanonicalLocation.end();
-            ++i) {
-        const QString oldCanonicalLocation = i->first;
-        Track* plainPtr = i->second->getPlainPtr();
-        auto fileInfo = plainPtr->getFileInfo();
-        TrackRef trackRef = TrackRef::fromFileInfo(
-                fileInfo,
-                plainPtr->getId());
-        if (!trackRef.hasCanonicalLocation() && trackRef.hasId() && pRelocator) {
-            auto relocatedFileInfo = pRelocator->relocateCachedTrack(
+    std::array<TracksByCanonicalLocation, kShardCount> relocatedTracksByCanonicalLocation;
+    for (const auto& shard : m_shards) {
+        for (const auto& entry : shard.tracksByCanonicalLocation) {
+            const QString oldCanonicalLocation = entry.first;
+            Track* plainPtr = entry.second->getPlainPtr();
+            auto fileInfo = plainPtr->getFileInfo();
+            TrackRef trackRef = TrackRef::fromFileInfo(
+                    fileInfo,
+                    plainPtr->getId());
+            if (!trackRef.hasCanonicalLocation() && trackRef.hasId() && pRelocator) {
+                auto relocatedFileInfo = pRelocator->relocateCachedTrack(
                         trackRef.getId(),
                         fileInfo);
-            if (fileInfo != relocatedFileInfo) {
-                plainPtr->relocate(relocatedFileInfo);
-                trackRef = TrackRef::fromFileInfo(
-                        relocatedFileInfo,
-                        trackRef.getId());
-                fileInfo = std::move(relocatedFileInfo);
+                if (fileInfo != relocatedFileInfo) {
+                    plainPtr->relocate(relocatedFileInfo);
+                    trackRef = TrackRef::fromFileInfo(
+                            relocatedFileInfo,
+                            trackRef.getId());
+                    fileInfo = std::move(relocatedFileInfo);
+                }
             }
+            if (!trackRef.hasCanonicalLocation()) {
+                kLogger.warning()
+                        << "Failed to relocate track"
+                        << oldCanonicalLocation
+                        << trackRef;
+                continue;
+            }
+            QString newCanonicalLocation = trackRef.getCanonicalLocation();
+            const auto shardIndex = shardIndexByCanonicalLocation(newCanonicalLocation);
+            if (oldCanonicalLocation == newCanonicalLocation) {
+                // Copy the entry unmodified into the new map
+                relocatedTracksByCanonicalLocation[shardIndex].insert(entry);
+                continue;
+            }
+            if (debugLogEnabled()) {
+                kLogger.debug()
+                        << "Relocating track"
+                        << "from" << oldCanonicalLocation
+                        << "to" << newCanonicalLocation;
+            }
+            relocatedTracksByCanonicalLocation[shardIndex].insert(std::make_pair(
+                    std::move(newCanonicalLocation),
+                    entry.second));
         }
-        if (!trackRef.hasCanonicalLocation()) {
-            kLogger.warning()
-                    << "Failed to relocate track"
-                    << oldCanonicalLocation
-                    << trackRef;
-            continue;
-        }
-        QString newCanonicalLocation = trackRef.getCanonicalLocation();
-        if (oldCanonicalLocation == newCanonicalLocation) {
-            // Copy the entry unmodified into the new map
-            relocatedTracksByCanonicalLocation.insert(*i);
-            continue;
-        }
-        if (debugLogEnabled()) {
-            kLogger.debug()
-                    << "Relocating track"
-                    << "from" << oldCanonicalLocation
-                    << "to" << newCanonicalLocation;
-        }
-        relocatedTracksByCanonicalLocation.insert(std::make_pair(
-                std::move(newCanonicalLocation),
-                i->second));
     }
-    m_tracksByCanonicalLocation = std::move(relocatedTracksByCanonicalLocation);
+    // Entries that failed to relocate are released after
+    // unlocking the shards
+    std::array<TracksByCanonicalLocation, kShardCount> replacedTracksByCanonicalLocation;
+    for (std::size_t i = 0; i < kShardCount; ++i) {
+        Shard& shard = m_shards[i];
+        ScopedShardLock lock(&shard.mutex);
+        replacedTracksByCanonicalLocation[i].swap(shard.tracksByCanonicalLocation);
+        shard.tracksByCanonicalLocation.swap(relocatedTracksByCanonicalLocation[i]);
+    }
 }
 
 void GlobalTrackCache::saveEvictedTrack(Track* pEvictedTrack) const {
@@ -385,29 +641,33 @@ void GlobalTrackCache::deactivate() {
     // exiting the application.
     kLogger.warning()
             << "Evicting all remaining"
-            << m_tracksById.size()
-            << '/'
-            << m_tracksByCanonicalLocation.size()
+            << getCachedTrackIds().size()
             << "tracks from cache";
 
-    while (!m_tracksById.empty()) {
-        auto i = m_tracksById.begin();
-        Track* plainPtr= i->second->getPlainPtr();
-        saveEvictedTrack(plainPtr);
-        m_tracksByCanonicalLocation.erase(plainPtr->getCanonicalLocation());
-        m_tracksById.erase(i);
+    // The tracks are evicted before saving them to prevent that
+    // they are looked up concurrently without locking the cache
+    for (auto& shard : m_shards) {
+        while (!shard.tracksById.empty()) {
+            const auto trackId = shard.tracksById.begin()->first;
+            const auto entryPtr = shard.tracksById.begin()->second;
+            Track* plainPtr = entryPtr->getPlainPtr();
+            eraseByCanonicalLocation(plainPtr->getCanonicalLocation());
+            eraseById(trackId);
+            saveEvictedTrack(plainPtr);
+        }
     }
 
-    while (!m_tracksByCanonicalLocation.empty()) {
-        auto i = m_tracksByCanonicalLocation.begin();
-        Track* plainPtr= i->second->getPlainPtr();
-        saveEvictedTrack(plainPtr);
-        m_tracksByCanonicalLocation.erase(i);
+    for (auto& shard : m_shards) {
+        while (!shard.tracksByCanonicalLocation.empty()) {
+            const auto canonicalLocation = shard.tracksByCanonicalLocation.begin()->first;
+            const auto entryPtr = shard.tracksByCanonicalLocation.begin()->second;
+            eraseByCanonicalLocation(canonicalLocation);
+            saveEvictedTrack(entryPtr->getPlainPtr());
+        }
     }
 
     // Verify that all cached tracks have been evicted
-    DEBUG_ASSERT(m_tracksById.empty());
-    DEBUG_ASSERT(m_tracksByCanonicalLocation.empty());
+    DEBUG_ASSERT(isEmpty());
 
     // The singular cache instance is already unavailable and
     // all allocated tracks will simply be deleted when their
@@ -417,13 +677,19 @@ void GlobalTrackCache::deactivate() {
 }
 
 bool GlobalTrackCache::isEmpty() const {
-    return m_tracksById.empty() && m_tracksByCanonicalLocation.empty();
+    for (const auto& shard : m_shards) {
+        if (!shard.tracksById.empty() || !shard.tracksByCanonicalLocation.empty()) {
+            return false;
+        }
+    }
+    return true;
 }
 
 TrackPointer GlobalTrackCache::lookupById(
         const TrackId& trackId) {
-    const auto trackById(m_tracksById.find(trackId));
-    if (m_tracksById.end() != trackById) {
+    const auto& tracksById = shardById(trackId).tracksById;
+    const auto trackById(tracksById.find(trackId));
+    if (tracksById.end() != trackById) {
         // Cache hit
         if (traceLogEnabled()) {
             kLogger.trace()
@@ -449,9 +715,12 @@ TrackPointer GlobalTrackCache::lookupByRef(
         return lookupById(trackRef.getId());
     } else {
         const auto canonicalLocation = trackRef.getCanonicalLocation();
+        const auto& tracksByCanonicalLocation =
+                m_shards[shardIndexByCanonicalLocation(canonicalLocation)]
+                        .tracksByCanonicalLocation;
         const auto trackByCanonicalLocation(
-                m_tracksByCanonicalLocation.find(canonicalLocation));
-        if (m_tracksByCanonicalLocation.end() != trackByCanonicalLocation) {
+                tracksByCanonicalLocation.find(canonicalLocation));
+        if (tracksByCanonicalLocation.end() != trackByCanonicalLocation) {
             // Cache hit
             if (traceLogEnabled()) {
                 kLogger.trace()
@@ -474,8 +743,10 @@ TrackPointer GlobalTrackCache::lookupByRef(
 
 QSet<TrackId> GlobalTrackCache::getCachedTrackIds() const {
     QSet<TrackId> trackIds;
-    for (const auto& entry : m_tracksById) {
-        trackIds << entry.first;
+    for (const auto& shard : m_shards) {
+        for (const auto& entry : shard.tracksById) {
+            trackIds << entry.first;
+        }
     }
     return trackIds;
 }
@@ -508,7 +779,11 @@ TrackPointer GlobalTrackCache::revive(
 
     savingPtr = TrackPointer(entryPtr->getPlainPtr(),
             EvictAndSaveFunctor(entryPtr));
+    // The entry might be accessed concurrently through the shards
+    // of both its id and its canonical location
+    lockAllShards();
     entryPtr->init(savingPtr);
+    unlockAllShards();
     DEBUG_ASSERT(!savingPtr->signalsBlocked());
     return savingPtr;
 }
@@ -603,30 +878,38 @@ void GlobalTrackCache::resolve(
                 << deletingPtr.get();
     }
 
+    // Track objects live together with the cache on the main thread
+    // and will be deleted later within the event loop. But this
+    // function might be called from any thread, even from worker
+    // threads without an event loop. We need to move the newly
+    // created object to the main thread.
+    savingPtr->moveToThread(QCoreApplication::instance()->thread());
+
+    // Lookups that don't lock the cache will only find the track after
+    // the resolver has initialized it and unlocked the cache
+    m_newEntries.push_back(cacheEntryPtr);
     if (trackRef.hasId()) {
         // Insert item by id
-        DEBUG_ASSERT(m_tracksById.find(
-                trackRef.getId()) == m_tracksById.end());
-        m_tracksById.insert(std::make_pair(
+        Shard& shard = shardById(trackRef.getId());
+        ScopedShardLock lock(&shard.mutex);
+        DEBUG_ASSERT(shard.tracksById.find(
+                trackRef.getId()) == shard.tracksById.end());
+        shard.tracksById.insert(std::make_pair(
                 trackRef.getId(),
                 cacheEntryPtr));
     }
     if (trackRef.hasCanonicalLocation()) {
         // Insert item by track location
-        DEBUG_ASSERT(m_tracksByCanonicalLocation.find(
-                trackRef.getCanonicalLocation()) == m_tracksByCanonicalLocation.end());
-        m_tracksByCanonicalLocation.insert(std::make_pair(
+        Shard& shard = m_shards[shardIndexByCanonicalLocation(
+                trackRef.getCanonicalLocation())];
+        ScopedShardLock lock(&shard.mutex);
+        DEBUG_ASSERT(shard.tracksByCanonicalLocation.find(
+                trackRef.getCanonicalLocation()) == shard.tracksByCanonicalLocation.end());
+        shard.tracksByCanonicalLocation.insert(std::make_pair(
                 trackRef.getCanonicalLocation(),
                 cacheEntryPtr));
     }
 
-    // Track objects live together with the cache on the main thread
-    // and will be deleted later within the event loop. But this
-    // function might be called from any thread, even from worker
-    // threads without an event loop. We need to move the newly
-    // created object to the main thread.
-    savingPtr->moveToThread(QCoreApplication::instance()->thread());
-
     pCacheResolver->initLookupResult(
             GlobalTrackCacheLookupResult::MISS,
             std::move(savingPtr),
@@ -647,14 +930,18 @@ TrackRef GlobalTrackCache::initTrackId(
     DEBUG_ASSERT(pDel);
 
     // Insert item by id
-    DEBUG_ASSERT(m_tracksById.find(trackId) == m_tracksById.end());
-    m_tracksById.insert(std::make_pair(
-            trackId,
-            pDel->getCacheEntryPointer()));
+    Shard& shard = shardById(trackId);
+    {
+        ScopedShardLock lock(&shard.mutex);
+        DEBUG_ASSERT(shard.tracksById.find(trackId) == shard.tracksById.end());
+        shard.tracksById.insert(std::make_pair(
+                trackId,
+                pDel->getCacheEntryPointer()));
+    }
 
     strongPtr->initId(trackId);
     DEBUG_ASSERT(createTrackRef(*strongPtr) == trackRefWithId);
-    DEBUG_ASSERT(m_tracksById.find(trackId) != m_tracksById.end());
+    DEBUG_ASSERT(shard.tracksById.find(trackId) != shard.tracksById.end());
 
     return trackRefWithId;
 }
@@ -662,11 +949,12 @@ TrackRef GlobalTrackCache::initTrackId(
 void GlobalTrackCache::purgeTrackId(TrackId trackId) {
     DEBUG_ASSERT(trackId.isValid());
 
-    const auto trackById(m_tracksById.find(trackId));
-    if (m_tracksById.end() != trackById) {
+    const auto& tracksById = shardById(trackId).tracksById;
+    const auto trackById(tracksById.find(trackId));
+    if (tracksById.end() != trackById) {
         Track* track = trackById->second->getPlainPtr();
         track->resetId();
-        m_tracksById.erase(trackById);
+        eraseById(trackId);
     }
 }
 
@@ -733,10 +1021,11 @@ bool GlobalTrackCache::tryEvict(Track* plainPtr) {
                 << plainPtr;
     }
     if (trackRef.hasId()) {
-        const auto trackById = m_tracksById.find(trackRef.getId());
-        if (trackById != m_tracksById.end()) {
+        const auto& tracksById = shardById(trackRef.getId()).tracksById;
+        const auto trackById = tracksById.find(trackRef.getId());
+        if (trackById != tracksById.end()) {
             if (trackById->second->getPlainPtr() == plainPtr) {
-                m_tracksById.erase(trackById);
+                eraseById(trackRef.getId());
                 evicted = true;
             } else {
                 notEvicted = true;
@@ -744,12 +1033,14 @@ bool GlobalTrackCache::tryEvict(Track* plainPtr) {
         }
     }
     if (trackRef.hasCanonicalLocation()) {
+        const auto& tracksByCanonicalLocation =
+                m_shards[shardIndexByCanonicalLocation(trackRef.getCanonicalLocation())]
+                        .tracksByCanonicalLocation;
         const auto trackByCanonicalLocation(
-                m_tracksByCanonicalLocation.find(trackRef.getCanonicalLocation()));
-        if (m_tracksByCanonicalLocation.end() != trackByCanonicalLocation) {
+                tracksByCanonicalLocation.find(trackRef.getCanonicalLocation()));
+        if (tracksByCanonicalLocation.end() != trackByCanonicalLocation) {
             if (trackByCanonicalLocation->second->getPlainPtr() == plainPtr) {
-                m_tracksByCanonicalLocation.erase(
-                        trackByCanonicalLocation);
+                eraseByCanonicalLocation(trackRef.getCanonicalLocation());
                 evicted = true;
             } else {
                 notEvicted = true;
@@ -763,14 +1054,16 @@ bool GlobalTrackCache::tryEvict(Track* plainPtr) {
 }
 
 bool GlobalTrackCache::isCached(Track* plainPtr) const {
-    for (auto&& entry: m_tracksById) {
-        if (entry.second->getPlainPtr() == plainPtr) {
-            return true;
+    for (const auto& shard : m_shards) {
+        for (auto&& entry : shard.tracksById) {
+            if (entry.second->getPlainPtr() == plainPtr) {
+                return true;
+            }
         }
-    }
-    for (auto&& entry: m_tracksByCanonicalLocation) {
-        if (entry.second->getPlainPtr() == plainPtr) {
-              return true;
+        for (auto&& entry : shard.tracksByCanonicalLocation) {
+            if (entry.second->getPlainPtr() == plainPtr) {
+                return true;
+            }
         }
     }
     return false;
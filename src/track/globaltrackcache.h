@@ -1,11 +1,15 @@
 #pragma once
 
 
+#include <QMutex>
+#include <array>
 #include <map>
 #include <unordered_map>
+#include <vector>
 
 #include "track/track.h"
 #include "track/trackref.h"
+#include "util/duration.h"
 
 
 // forward declaration(s)
@@ -55,7 +59,8 @@ class GlobalTrackCacheEntry final {
 
     explicit GlobalTrackCacheEntry(
             std::unique_ptr<Track, TrackDeleter> deletingPtr)
-        : m_deletingPtr(std::move(deletingPtr)) {
+        : m_deletingPtr(std::move(deletingPtr)),
+          m_published(false) {
     }
     GlobalTrackCacheEntry(const GlobalTrackCacheEntry& other) = delete;
     GlobalTrackCacheEntry(GlobalTrackCacheEntry&&) = default;
@@ -77,9 +82,19 @@ class GlobalTrackCacheEntry final {
         return m_savingWeakPtr.expired();
     }
 
+    // New tracks are published when the resolver that has created
+    // them unlocks the cache, i.e. after they have been initialized.
+    bool isPublished() const {
+        return m_published;
+    }
+    void publish() {
+        m_published = true;
+    }
+
   private:
     std::unique_ptr<Track, TrackDeleter> m_deletingPtr;
     TrackWeakPointer m_savingWeakPtr;
+    bool m_published;
 };
 
 typedef std::shared_ptr<GlobalTrackCacheEntry> GlobalTrackCacheEntryPointer;
@@ -174,6 +189,14 @@ private:
     TrackRef m_trackRef;
 };
 
+/// Accumulated time that threads have been blocked while waiting
+/// for a lock of the GlobalTrackCache. Uncontended locks are not
+/// counted.
+struct GlobalTrackCacheLockWaitStats {
+    quint64 contendedCount = 0;
+    mixxx::Duration waitTime;
+};
+
 /// Callback interface for pre-delete actions
 class /*interface*/ GlobalTrackCacheSaver {
 private:
@@ -223,6 +246,28 @@ class GlobalTrackCache : public QObject {
     // Deleter callbacks for the smart-pointer
     static void evictAndSaveCachedTrack(GlobalTrackCacheEntryPointer cacheEntryPtr);
 
+    /// Lookup an existing Track object in the cache without locking
+    /// the whole cache.
+    ///
+    /// Only the shard that contains the id or canonical location is
+    /// locked briefly, i.e. the lookup is not lock-free. Tracks that are
+    /// about to be evicted need to be revived and tracks that are still
+    /// being initialized by a GlobalTrackCacheResolver need to be waited
+    /// for. Both require the exclusive lock of a GlobalTrackCacheLocker.
+    /// Prefer these functions over the corresponding functions of
+    /// GlobalTrackCacheLocker if the cache doesn't need to stay locked
+    /// after the lookup.
+    static TrackPointer lookupCachedTrackById(
+            const TrackId& trackId);
+    static TrackPointer lookupCachedTrackByRef(
+            const TrackRef& trackRef);
+
+    /// Contention of the exclusive lock of GlobalTrackCacheLocker
+    static GlobalTrackCacheLockWaitStats cacheLockWaitStats();
+    /// Contention of the locks of the individual shards
+    static GlobalTrackCacheLockWaitStats shardLockWaitStats();
+    static void resetLockWaitStats();
+
   private slots:
     void slotEvictAndSave(GlobalTrackCacheEntryPointer cacheEntryPtr);
 
@@ -268,18 +313,65 @@ class GlobalTrackCache : public QObject {
 
     void saveEvictedTrack(Track* pEvictedTrack) const;
 
+    // This caches the unsaved Tracks by ID
+    typedef std::unordered_map<TrackId, GlobalTrackCacheEntryPointer, TrackId::hash_fun_t> TracksById;
+
+    // This caches the unsaved Tracks by location
+    typedef std::map<QString, GlobalTrackCacheEntryPointer> TracksByCanonicalLocation;
+
+    // The entries are distributed among the shards by the hash of
+    // their id and canonical location respectively, i.e. the id and
+    // the location of a track are usually stored in different shards.
+    //
+    // All modifications of the shards and the entries require the
+    // exclusive lock m_mutex. Additionally the mutex of the affected
+    // shard needs to be locked while modifying it. Readers that don't
+    // hold m_mutex only lock a single shard at a time. Only the owner
+    // of m_mutex may lock multiple shards.
+    struct Shard {
+        Shard();
+
+        mutable QMutex mutex;
+        TracksById tracksById;
+        TracksByCanonicalLocation tracksByCanonicalLocation;
+    };
+    static constexpr std::size_t kShardCount = 16;
+
+    Shard& shardById(const TrackId& trackId);
+    const Shard& shardById(const TrackId& trackId) const;
+    static std::size_t shardIndexByCanonicalLocation(
+            const QString& canonicalLocation);
+
+    // Sets *pLockRequired if the track has been found but is either
+    // expired or not published yet
+    TrackPointer lookupAliveById(
+            const TrackId& trackId,
+            bool* /*out*/ pLockRequired) const;
+    TrackPointer lookupAliveByCanonicalLocation(
+            const QString& canonicalLocation,
+            bool* /*out*/ pLockRequired) const;
+
+    // Publishes all new entries. Returns them to keep them alive until
+    // the cache has been unlocked.
+    std::vector<GlobalTrackCacheEntryPointer> publishNewEntries();
+
+    void eraseById(const TrackId& trackId);
+    void eraseByCanonicalLocation(const QString& canonicalLocation);
+
+    void lockAllShards() const;
+    void unlockAllShards() const;
+
     // Managed by GlobalTrackCacheLocker
     mutable QMutex m_mutex;
+    // The number of nested locks of m_mutex
+    int m_cacheLockDepth;
 
     GlobalTrackCacheSaver* m_pSaver;
 
     deleteTrackFn_t m_deleteTrackFn;
 
-    // This caches the unsaved Tracks by ID
-    typedef std::unordered_map<TrackId, GlobalTrackCacheEntryPointer, TrackId::hash_fun_t> TracksById;
-    TracksById m_tracksById;
+    std::array<Shard, kShardCount> m_shards;
 
-    // This caches the unsaved Tracks by location
-    typedef std::map<QString, GlobalTrackCacheEntryPointer> TracksByCanonicalLocation;
-    TracksByCanonicalLocation m_tracksByCanonicalLocation;
+    // Created by the resolver that currently holds m_mutex
+    std::vector<std::weak_ptr<GlobalTrackCacheEntry>> m_newEntries;
 };
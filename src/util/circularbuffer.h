@@ -76,6 +76,16 @@ class CircularBuffer {
         return itemsRead;
     }
 
+    // Returns the oldest item. The buffer must not be empty.
+    inline T& front() {
+        return m_pBuffer[m_iReadPos];
+    }
+
+    // Returns the most recently written item. The buffer must not be empty.
+    inline T& back() {
+        return m_pBuffer[(m_iWritePos + m_iLength - 1) % m_iLength];
+    }
+
     unsigned int skip(const unsigned int itemsToRead) {
         if (m_pBuffer == NULL)
             return 0;
@@ -1,5 +1,6 @@
 #include <QSqlDriver>
 #include <QSqlError>
+#include <QSqlQuery>
 
 #ifdef __SQLITE3__
 #include <sqlite3.h>
@@ -8,6 +9,7 @@
 #include "util/db/dbconnection.h"
 
 #include "util/db/sqllikewildcards.h"
+#include "util/db/sqlquerycache.h"
 #include "util/memory.h"
 #include "util/logger.h"
 #include "util/assert.h"
@@ -310,18 +312,96 @@ bool initDatabase(QSqlDatabase database, StringCollator* pCollator) {
     return true;
 }
 
+#ifdef __SQLITE3__
+
+bool execPragma(
+        const QSqlDatabase& database,
+        const QString& name,
+        const QString& value) {
+    QSqlQuery query(database);
+    if (!query.exec(QString("PRAGMA %1=%2").arg(name, value))) {
+        kLogger.warning()
+                << "Failed to set" << name << "to" << value
+                << query.lastError();
+        return false;
+    }
+    if (kLogger.debugEnabled() && query.next()) {
+        // Some pragmas report the actual value, e.g. in-memory
+        // databases don't support WAL mode
+        kLogger.debug()
+                << name << "=" << query.value(0).toString();
+    }
+    return true;
+}
+
+bool execPragma(
+        const QSqlDatabase& database,
+        const QString& name,
+        const QString& value,
+        const QStringList& validValues) {
+    if (!validValues.contains(value, Qt::CaseInsensitive)) {
+        kLogger.warning()
+                << "Invalid value for" << name << ":" << value;
+        return false;
+    }
+    return execPragma(database, name, value);
+}
+
+#endif // __SQLITE3__
+
+void applySqliteProfile(
+        const QSqlDatabase& database,
+        const DbConnection::SqliteProfile& profile) {
+    DEBUG_ASSERT(database.isOpen());
+#ifdef __SQLITE3__
+    if (!profile.journalMode.isEmpty()) {
+        execPragma(database,
+                QStringLiteral("journal_mode"),
+                profile.journalMode,
+                {"DELETE", "TRUNCATE", "PERSIST", "MEMORY", "WAL", "OFF"});
+    }
+    if (!profile.synchronous.isEmpty()) {
+        execPragma(database,
+                QStringLiteral("synchronous"),
+                profile.synchronous,
+                {"OFF", "NORMAL", "FULL", "EXTRA"});
+    }
+    if (!profile.tempStore.isEmpty()) {
+        execPragma(database,
+                QStringLiteral("temp_store"),
+                profile.tempStore,
+                {"DEFAULT", "FILE", "MEMORY"});
+    }
+    if (profile.mmapSize > 0) {
+        execPragma(database,
+                QStringLiteral("mmap_size"),
+                QString::number(profile.mmapSize));
+    }
+    if (profile.cacheSize != 0) {
+        execPragma(database,
+                QStringLiteral("cache_size"),
+                QString::number(profile.cacheSize));
+    }
+#else
+    Q_UNUSED(database);
+    Q_UNUSED(profile);
+#endif // __SQLITE3__
+}
+
 } // anonymous namespace
 
 DbConnection::DbConnection(
         const Params& params,
         const QString& connectionName)
-    : m_sqlDatabase(createDatabase(params, connectionName)) {
+    : m_sqlDatabase(createDatabase(params, connectionName)),
+      m_sqliteProfile(params.sqliteProfile) {
 }
 
 DbConnection::DbConnection(
         const DbConnection& prototype,
         const QString& connectionName)
-    : m_sqlDatabase(cloneDatabase(prototype.m_sqlDatabase, connectionName)) {
+    : m_sqlDatabase(cloneDatabase(prototype.m_sqlDatabase, connectionName)),
+      m_sqliteProfile(prototype.m_sqliteProfile) {
 }
 
 DbConnection::~DbConnection() {
@@ -349,6 +429,9 @@ bool DbConnection::open() {
         m_sqlDatabase.close();
         return false; // abort
     }
+    // Failures are not fatal, the connection still works
+    // with the default settings
+    applySqliteProfile(m_sqlDatabase, m_sqliteProfile);
     return true;
 }
 
@@ -367,6 +450,7 @@ void DbConnection::close() {
                     << "Closing database connection:"
                     << *this;
         }
+        SqlQueryCache::clear(name());
         m_sqlDatabase.close();
     }
 }
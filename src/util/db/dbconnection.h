@@ -24,6 +24,23 @@ class DbConnection final {
 
     static void makeStringLatinLow(QString* string);
 
+    // Tuning of SQLite that is applied to each connection after
+    // opening it. Empty strings and zero values keep the defaults.
+    struct SqliteProfile {
+        // DELETE, TRUNCATE, PERSIST, MEMORY, WAL, or OFF. In WAL mode
+        // readers don't block writers and vice versa.
+        QString journalMode;
+        // OFF, NORMAL, FULL, or EXTRA
+        QString synchronous;
+        // DEFAULT, FILE, or MEMORY
+        QString tempStore;
+        // Maximum number of bytes for memory-mapped I/O
+        qint64 mmapSize = 0;
+        // Size of the page cache. Negative values are in KiB,
+        // positive values are the number of pages.
+        int cacheSize = 0;
+    };
+
     struct Params {
         QString type;
         QString connectOptions;
@@ -31,6 +48,7 @@ class DbConnection final {
         QString filePath;
         QString userName;
         QString password;
+        SqliteProfile sqliteProfile;
     };
 
     // All constructors are reserved for DbConnectionPool!!
@@ -64,6 +82,7 @@ class DbConnection final {
     DbConnection(const DbConnection&&) = delete;
 
     QSqlDatabase m_sqlDatabase;
+    SqliteProfile m_sqliteProfile;
     StringCollator m_collator;
 };
 
@@ -0,0 +1,48 @@
+#include "util/db/sqlquerycache.h"
+
+#include <QHash>
+#include <QThreadStorage>
+
+namespace {
+
+// Statements that are formatted dynamically, e.g. with lists
+// of ids, would grow the cache without bounds
+constexpr int kMaxCachedQueriesPerConnection = 128;
+
+typedef QHash<QString, QSqlQuery> CachedQueries;
+
+QThreadStorage<QHash<QString, CachedQueries>> s_cachedQueriesByConnection;
+
+} // anonymous namespace
+
+//static
+QSqlQuery SqlQueryCache::prepare(
+        const QSqlDatabase& database,
+        const QString& statement) {
+    auto& cachedQueries =
+            s_cachedQueriesByConnection.localData()[database.connectionName()];
+    const auto i = cachedQueries.constFind(statement);
+    if (i != cachedQueries.constEnd() && !i.value().isActive()) {
+        // Implicitly shared
+        return i.value();
+    }
+    QSqlQuery query(database);
+    if (!query.prepare(statement)) {
+        // Executing the query will fail and log the error
+        return query;
+    }
+    if (i == cachedQueries.constEnd()) {
+        if (cachedQueries.size() >= kMaxCachedQueriesPerConnection) {
+            cachedQueries.clear();
+        }
+        cachedQueries.insert(statement, query);
+    }
+    return query;
+}
+
+//static
+void SqlQueryCache::clear(const QString& connectionName) {
+    if (s_cachedQueriesByConnection.hasLocalData()) {
+        s_cachedQueriesByConnection.localData().remove(connectionName);
+    }
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QString>
+
+/// Caches prepared statements per database connection.
+///
+/// Preparing a query parses and compiles the SQL statement. Frequently
+/// executed statements only need to be prepared once per connection and
+/// are then shared by all DAOs that use this connection.
+///
+/// Database connections are bound to a single thread and so is the
+/// cache. DbConnection discards all cached queries before closing the
+/// connection.
+class SqlQueryCache final {
+  public:
+    /// Returns a prepared query for the statement. The query must be
+    /// finished after use, e.g. by SqlQueryFinisher, before it could be
+    /// reused. While the cached query is still active a new query is
+    /// prepared, e.g. when executing the same statement recursively.
+    static QSqlQuery prepare(
+            const QSqlDatabase& database,
+            const QString& statement);
+
+    static void clear(const QString& connectionName);
+
+  private:
+    SqlQueryCache() = delete;
+};
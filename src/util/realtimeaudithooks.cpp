@@ -0,0 +1,155 @@
+// Replaces functions of the C library to detect operations within
+// real-time sections that are not real-time safe, see util/realtimecheck.h.
+//
+// The replacements affect the whole process. This file is not part of
+// mixxx-lib. It is only linked into mixxx-test and, if built with the
+// RT_AUDIT option, into mixxx.
+
+#include "util/realtimecheck.h"
+
+// Defines __GLIBC__
+#include <stdlib.h>
+
+#if defined(__has_feature)
+#if __has_feature(address_sanitizer) || __has_feature(thread_sanitizer) || \
+        __has_feature(memory_sanitizer)
+#define MIXXX_SANITIZER_ALLOCATOR
+#endif
+#endif
+#if defined(__SANITIZE_ADDRESS__) || defined(__SANITIZE_THREAD__)
+#define MIXXX_SANITIZER_ALLOCATOR
+#endif
+
+// The sanitizers replace the allocation functions themselves
+#if defined(__linux__) && defined(__GLIBC__) && !defined(MIXXX_SANITIZER_ALLOCATOR)
+
+#include <dlfcn.h>
+#include <errno.h>
+#include <linux/futex.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <sys/syscall.h>
+
+#include <atomic>
+
+using mixxx::RealtimeAudit;
+
+namespace {
+
+typedef long (*SyscallFunction)(long number, ...);
+
+SyscallFunction realSyscall() {
+    static std::atomic<SyscallFunction> s_function(nullptr);
+    SyscallFunction function = s_function.load(std::memory_order_relaxed);
+    if (!function) {
+        // Might already be needed before the static initialization of this
+        // file, i.e. it is resolved on first use.
+        function = reinterpret_cast<SyscallFunction>(dlsym(RTLD_NEXT, "syscall"));
+        s_function.store(function, std::memory_order_relaxed);
+    }
+    return function;
+}
+
+typedef int (*MutexLockFunction)(pthread_mutex_t* mutex);
+
+// Set while dlsym() resolves pthread_mutex_lock(), which might lock a
+// mutex itself
+thread_local bool t_resolvingMutexLock = false;
+
+// glibc 2.34 and later only export __pthread_mutex_lock as a compat symbol
+// that new binaries cannot link against. Returns null while resolving.
+MutexLockFunction realMutexLock() {
+    static std::atomic<MutexLockFunction> s_function(nullptr);
+    MutexLockFunction function = s_function.load(std::memory_order_relaxed);
+    if (!function && !t_resolvingMutexLock) {
+        t_resolvingMutexLock = true;
+        function = reinterpret_cast<MutexLockFunction>(
+                dlsym(RTLD_NEXT, "pthread_mutex_lock"));
+        t_resolvingMutexLock = false;
+        s_function.store(function, std::memory_order_relaxed);
+    }
+    return function;
+}
+
+const bool kHooksInstalled = [] {
+    RealtimeAudit::setEnabled(true);
+    return true;
+}();
+
+} // anonymous namespace
+
+extern "C" {
+
+// The actual implementation of glibc. The C++ allocation functions of
+// libstdc++ are based on malloc() and free() and are covered, too. The
+// replacements are declared noexcept like in the headers of glibc.
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void __libc_free(void* ptr);
+
+void* malloc(size_t size) noexcept {
+    RealtimeAudit::onOperation(RealtimeAudit::Operation::Allocation);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) noexcept {
+    RealtimeAudit::onOperation(RealtimeAudit::Operation::Allocation);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) noexcept {
+    RealtimeAudit::onOperation(RealtimeAudit::Operation::Allocation);
+    return __libc_realloc(ptr, size);
+}
+
+void free(void* ptr) noexcept {
+    if (ptr) {
+        RealtimeAudit::onOperation(RealtimeAudit::Operation::Deallocation);
+    }
+    __libc_free(ptr);
+}
+
+// std::mutex and all other users of pthread mutexes. pthread_mutex_trylock()
+// never blocks and is not considered as an issue.
+int pthread_mutex_lock(pthread_mutex_t* mutex) noexcept {
+    RealtimeAudit::onOperation(RealtimeAudit::Operation::MutexLock);
+    const MutexLockFunction function = realMutexLock();
+    if (!function) {
+        // Locked by dlsym() on the first invocation of this function
+        int result;
+        while ((result = pthread_mutex_trylock(mutex)) == EBUSY) {
+            sched_yield();
+        }
+        return result;
+    }
+    return function(mutex);
+}
+
+// Qt implements QMutex, QSemaphore, and QWaitCondition with futexes. A
+// QMutex is locked without any system call unless it is contended, i.e.
+// only the cases that actually block the callback are detected.
+long syscall(long number, ...) noexcept {
+    // Like glibc pass on the maximum number of arguments, regardless
+    // of how many the caller has actually passed.
+    va_list args;
+    va_start(args, number);
+    long arg[6];
+    for (auto& value : arg) {
+        value = va_arg(args, long);
+    }
+    va_end(args);
+    if (number == SYS_futex) {
+        const int op = static_cast<int>(arg[1]) & FUTEX_CMD_MASK;
+        if (op == FUTEX_WAIT || op == FUTEX_WAIT_BITSET || op == FUTEX_LOCK_PI) {
+            RealtimeAudit::onOperation(RealtimeAudit::Operation::Wait);
+        }
+    }
+    return realSyscall()(number, arg[0], arg[1], arg[2], arg[3], arg[4], arg[5]);
+}
+
+} // extern "C"
+
+#endif
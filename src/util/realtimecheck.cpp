@@ -0,0 +1,207 @@
+#include "util/realtimecheck.h"
+
+#include <QStringList>
+#include <QVector>
+
+#include <algorithm>
+#include <atomic>
+
+#ifdef __GLIBC__
+#include <execinfo.h>
+#include <stdlib.h>
+#define MIXXX_HAVE_BACKTRACE
+#endif
+
+namespace mixxx {
+
+namespace {
+
+constexpr int kOperationCount = 4;
+
+// RealtimeAudit::record() and the replaced function of the C library
+constexpr int kSkippedFrames = 2;
+constexpr int kMaxFrames = 32;
+
+// Operations at further call sites are only counted
+constexpr int kMaxCallSites = 1024;
+
+struct CallSite {
+    // 0 if unused
+    std::atomic<quint64> hash;
+    std::atomic<int> count;
+    // Set after the operation and the frames have been written
+    std::atomic<bool> ready;
+    RealtimeAudit::Operation operation;
+    int frameCount;
+    void* frames[kMaxFrames];
+};
+
+std::atomic<bool> s_enabled(false);
+std::atomic<int> s_counts[kOperationCount];
+std::atomic<int> s_unrecordedCount(0);
+CallSite s_callSites[kMaxCallSites];
+
+// Prevents recursion if unwinding the stack allocates or locks itself
+thread_local bool t_recording = false;
+
+const char* operationName(RealtimeAudit::Operation operation) {
+    switch (operation) {
+    case RealtimeAudit::Operation::Allocation:
+        return "allocation";
+    case RealtimeAudit::Operation::Deallocation:
+        return "deallocation";
+    case RealtimeAudit::Operation::MutexLock:
+        return "mutex lock";
+    case RealtimeAudit::Operation::Wait:
+        return "wait";
+    }
+    return "unknown";
+}
+
+// FNV-1a
+quint64 hashCallStack(RealtimeAudit::Operation operation,
+        void* const* frames,
+        int frameCount) {
+    quint64 hash = 14695981039346656037ull;
+    const auto mix = [&hash](quint64 value) {
+        hash ^= value;
+        hash *= 1099511628211ull;
+    };
+    mix(static_cast<quint64>(operation));
+    for (int i = 0; i < frameCount; ++i) {
+        mix(reinterpret_cast<quintptr>(frames[i]));
+    }
+    return hash != 0 ? hash : 1;
+}
+
+} // anonymous namespace
+
+// static
+thread_local int ScopedRealtimeSection::s_depth = 0;
+
+// static
+bool RealtimeAudit::isEnabled() {
+    return s_enabled.load(std::memory_order_relaxed);
+}
+
+// static
+void RealtimeAudit::setEnabled(bool enabled) {
+#ifdef MIXXX_HAVE_BACKTRACE
+    if (enabled) {
+        // The unwinder is loaded on first use, which must not happen
+        // within the audio callback.
+        void* frame;
+        backtrace(&frame, 1);
+    }
+#endif
+    s_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+// static
+int RealtimeAudit::count() {
+    int total = 0;
+    for (const auto& count : s_counts) {
+        total += count.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+// static
+int RealtimeAudit::count(Operation operation) {
+    return s_counts[static_cast<int>(operation)].load(std::memory_order_relaxed);
+}
+
+// static
+void RealtimeAudit::reset() {
+    for (auto& count : s_counts) {
+        count.store(0, std::memory_order_relaxed);
+    }
+    s_unrecordedCount.store(0, std::memory_order_relaxed);
+    for (auto& callSite : s_callSites) {
+        callSite.ready.store(false, std::memory_order_relaxed);
+        callSite.count.store(0, std::memory_order_relaxed);
+        callSite.hash.store(0, std::memory_order_release);
+    }
+}
+
+// static
+void RealtimeAudit::record(Operation operation) {
+    if (t_recording) {
+        return;
+    }
+    t_recording = true;
+    s_counts[static_cast<int>(operation)].fetch_add(1, std::memory_order_relaxed);
+
+    void* frames[kSkippedFrames + kMaxFrames];
+    int frameCount = 0;
+#ifdef MIXXX_HAVE_BACKTRACE
+    frameCount = backtrace(frames, kSkippedFrames + kMaxFrames);
+#endif
+    void* const* callStack = frames + kSkippedFrames;
+    frameCount = std::max(frameCount - kSkippedFrames, 0);
+    const quint64 hash = hashCallStack(operation, callStack, frameCount);
+
+    bool recorded = false;
+    for (int probe = 0; probe < kMaxCallSites && !recorded; ++probe) {
+        CallSite& callSite = s_callSites[(hash + probe) % kMaxCallSites];
+        quint64 expected = 0;
+        if (callSite.hash.compare_exchange_strong(expected, hash, std::memory_order_acq_rel)) {
+            callSite.operation = operation;
+            callSite.frameCount = frameCount;
+            std::copy(callStack, callStack + frameCount, callSite.frames);
+            callSite.ready.store(true, std::memory_order_release);
+            recorded = true;
+        } else {
+            recorded = expected == hash;
+        }
+        if (recorded) {
+            callSite.count.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    if (!recorded) {
+        s_unrecordedCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    t_recording = false;
+}
+
+// static
+QString RealtimeAudit::report() {
+    QVector<const CallSite*> callSites;
+    for (const auto& callSite : s_callSites) {
+        if (callSite.ready.load(std::memory_order_acquire)) {
+            callSites.append(&callSite);
+        }
+    }
+    std::sort(callSites.begin(),
+            callSites.end(),
+            [](const CallSite* pLhs, const CallSite* pRhs) {
+                return pLhs->count.load() > pRhs->count.load();
+            });
+
+    QStringList lines;
+    lines.append(QStringLiteral(
+            "Real-time audit: %1 operations within real-time sections at %2 call sites")
+                         .arg(count())
+                         .arg(callSites.size()));
+    for (const CallSite* pCallSite : qAsConst(callSites)) {
+        lines.append(QStringLiteral("%1 x %2")
+                             .arg(pCallSite->count.load())
+                             .arg(operationName(pCallSite->operation)));
+#ifdef MIXXX_HAVE_BACKTRACE
+        char** symbols = backtrace_symbols(pCallSite->frames, pCallSite->frameCount);
+        if (symbols) {
+            for (int i = 0; i < pCallSite->frameCount; ++i) {
+                lines.append(QStringLiteral("    ") + QString::fromLocal8Bit(symbols[i]));
+            }
+            free(symbols);
+        }
+#endif
+    }
+    const int unrecordedCount = s_unrecordedCount.load();
+    if (unrecordedCount > 0) {
+        lines.append(QStringLiteral("%1 operations at further call sites").arg(unrecordedCount));
+    }
+    return lines.join(QChar('\n'));
+}
+
+} // namespace mixxx
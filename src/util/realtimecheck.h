@@ -0,0 +1,78 @@
+#pragma once
+
+#include <QString>
+
+namespace mixxx {
+
+/// Marks the code that runs on the current thread within the scope of this
+/// object as real-time code, i.e. code that must neither allocate or free
+/// memory nor lock mutexes. Sections may be nested.
+///
+/// Entering and leaving a section only modifies a thread-local counter.
+class ScopedRealtimeSection {
+  public:
+    ScopedRealtimeSection() {
+        ++s_depth;
+    }
+    ~ScopedRealtimeSection() {
+        --s_depth;
+    }
+    ScopedRealtimeSection(const ScopedRealtimeSection&) = delete;
+    ScopedRealtimeSection& operator=(const ScopedRealtimeSection&) = delete;
+
+    /// Returns true if the current thread is within a real-time section.
+    static bool isActive() {
+        return s_depth > 0;
+    }
+
+  private:
+    static thread_local int s_depth;
+};
+
+/// Records operations within real-time sections that are not real-time
+/// safe, i.e. allocations, deallocations, mutex locks, and blocking waits,
+/// together with a hash of their call stack.
+///
+/// The operations are only detected if the executable replaces the
+/// corresponding functions of the C library, see util/realtimeaudithooks.cpp.
+/// This is done by mixxx-test on Linux and by mixxx if it has been built
+/// with the RT_AUDIT option. mixxx dumps the report at shutdown.
+class RealtimeAudit {
+  public:
+    enum class Operation {
+        Allocation,
+        Deallocation,
+        MutexLock,
+        Wait,
+    };
+
+    /// Returns true if operations are detected at all.
+    static bool isEnabled();
+    /// Invoked once by the replaced functions.
+    static void setEnabled(bool enabled);
+
+    /// Invoked by the replaced functions. Must neither allocate nor lock.
+    static void onOperation(Operation operation) {
+        if (ScopedRealtimeSection::isActive()) {
+            record(operation);
+        }
+    }
+
+    /// The number of operations within real-time sections since the
+    /// last reset, summed up over all threads.
+    static int count();
+    static int count(Operation operation);
+
+    /// Discards all recorded operations. Must not be invoked while
+    /// any thread is within a real-time section.
+    static void reset();
+
+    /// Lists the call stacks of all recorded operations, the most
+    /// frequent first.
+    static QString report();
+
+  private:
+    static void record(Operation operation);
+};
+
+} // namespace mixxx
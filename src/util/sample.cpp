@@ -3,6 +3,7 @@
 
 #include "util/sample.h"
 #include "util/math.h"
+#include "util/sample_kernels.h"
 
 #ifdef __WINDOWS__
 #include <QtGlobal>
@@ -34,8 +35,99 @@ constexpr bool useAlignedAlloc() {
             sizeof(CSAMPLE*) == sizeof(size_t);
 }
 
+const SampleUtilKernels* kernelsForInstructionSet(
+        SampleUtil::InstructionSet instructionSet) {
+    switch (instructionSet) {
+    case SampleUtil::InstructionSet::Baseline:
+        return &kSampleUtilKernels;
+    case SampleUtil::InstructionSet::Avx2:
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            return sampleUtilKernelsAvx2();
+        }
+#endif
+        return nullptr;
+    case SampleUtil::InstructionSet::Avx512:
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) {
+            return sampleUtilKernelsAvx512();
+        }
+#endif
+        return nullptr;
+    }
+    return nullptr;
+}
+
+// Ordered from the least to the most preferred instruction set
+constexpr SampleUtil::InstructionSet kInstructionSets[] = {
+        SampleUtil::InstructionSet::Baseline,
+        SampleUtil::InstructionSet::Avx2,
+        SampleUtil::InstructionSet::Avx512,
+};
+
+SampleUtil::InstructionSet bestInstructionSet() {
+    auto bestInstructionSet = SampleUtil::InstructionSet::Baseline;
+    for (auto instructionSet : kInstructionSets) {
+        if (kernelsForInstructionSet(instructionSet)) {
+            bestInstructionSet = instructionSet;
+        }
+    }
+    return bestInstructionSet;
+}
+
+// Both variables are initialized statically with the baseline kernels,
+// i.e. before any dynamic initialization that might already use them.
+SampleUtil::InstructionSet s_instructionSet = SampleUtil::InstructionSet::Baseline;
+const SampleUtilKernels* s_pKernels = &kSampleUtilKernels;
+
+// Switches to the best kernels during dynamic initialization
+[[maybe_unused]] const bool s_kernelsSelected =
+        SampleUtil::setInstructionSet(bestInstructionSet());
+
 } // anonymous namespace
 
+// static
+SampleUtil::InstructionSet SampleUtil::instructionSet() {
+    return s_instructionSet;
+}
+
+// static
+const char* SampleUtil::instructionSetName(InstructionSet instructionSet) {
+    switch (instructionSet) {
+    case InstructionSet::Baseline:
+        return "Baseline";
+    case InstructionSet::Avx2:
+        return "AVX2";
+    case InstructionSet::Avx512:
+        return "AVX-512";
+    }
+    return "Unknown";
+}
+
+// static
+std::vector<SampleUtil::InstructionSet> SampleUtil::supportedInstructionSets() {
+    std::vector<InstructionSet> instructionSets;
+    for (auto instructionSet : kInstructionSets) {
+        if (kernelsForInstructionSet(instructionSet)) {
+            instructionSets.push_back(instructionSet);
+        }
+    }
+    return instructionSets;
+}
+
+// static
+bool SampleUtil::setInstructionSet(InstructionSet instructionSet) {
+    const SampleUtilKernels* pKernels = kernelsForInstructionSet(instructionSet);
+    if (!pKernels) {
+        return false;
+    }
+    s_instructionSet = instructionSet;
+    s_pKernels = pKernels;
+    return true;
+}
+
 // static
 CSAMPLE* SampleUtil::alloc(SINT size) {
     // To speed up vectorization we align our sample buffers to 16-byte (128
@@ -116,10 +208,7 @@ void SampleUtil::applyGain(CSAMPLE* pBuffer, CSAMPLE_GAIN gain,
         return;
     }
 
-    // note: LOOP VECTORIZED.
-    for (SINT i = 0; i < numSamples; ++i) {
-        pBuffer[i] *= gain;
-    }
+    s_pKernels->applyGain(pBuffer, gain, numSamples);
 }
 
 // static
@@ -137,18 +226,9 @@ void SampleUtil::applyRampingGain(CSAMPLE* pBuffer, CSAMPLE_GAIN old_gain,
             / CSAMPLE_GAIN(numSamples / 2);
     if (gain_delta) {
         const CSAMPLE_GAIN start_gain = old_gain + gain_delta;
-        // note: LOOP VECTORIZED.
-        for (int i = 0; i < numSamples / 2; ++i) {
-            const CSAMPLE_GAIN gain = start_gain + gain_delta * i;
-            // a loop counter i += 2 prevents vectorizing.
-            pBuffer[i * 2] *= gain;
-            pBuffer[i * 2 + 1] *= gain;
-        }
+        s_pKernels->applyRampingGain(pBuffer, start_gain, gain_delta, numSamples);
     } else {
-        // note: LOOP VECTORIZED.
-        for (int i = 0; i < numSamples; ++i) {
-            pBuffer[i] *= old_gain;
-        }
+        s_pKernels->applyGain(pBuffer, old_gain, numSamples);
     }
 }
 
@@ -160,11 +240,7 @@ void SampleUtil::applyAlternatingGain(CSAMPLE* pBuffer, CSAMPLE gain1,
         return applyGain(pBuffer, gain1, numSamples);
     }
 
-    // note: LOOP VECTORIZED.
-    for (SINT i = 0; i < numSamples / 2; ++i) {
-        pBuffer[i * 2] *= gain1;
-        pBuffer[i * 2 + 1] *= gain2;
-    }
+    s_pKernels->applyAlternatingGain(pBuffer, gain1, gain2, numSamples);
 }
 
 
@@ -213,10 +289,7 @@ void SampleUtil::applyRampingAlternatingGain(CSAMPLE* pBuffer,
 void SampleUtil::add(CSAMPLE* M_RESTRICT pDest,
         const CSAMPLE* M_RESTRICT pSrc,
         SINT numSamples) {
-    // note: LOOP VECTORIZED.
-    for (SINT i = 0; i < numSamples; ++i) {
-        pDest[i] += pSrc[i];
-    }
+    s_pKernels->add(pDest, pSrc, numSamples);
 }
 
 // static
@@ -227,10 +300,7 @@ void SampleUtil::addWithGain(CSAMPLE* M_RESTRICT pDest,
         return;
     }
 
-    // note: LOOP VECTORIZED.
-    for (SINT i = 0; i < numSamples; ++i) {
-        pDest[i] += pSrc[i] * gain;
-    }
+    s_pKernels->addWithGain(pDest, pSrc, gain, numSamples);
 }
 
 void SampleUtil::addWithRampingGain(CSAMPLE* M_RESTRICT pDest,
@@ -245,17 +315,9 @@ void SampleUtil::addWithRampingGain(CSAMPLE* M_RESTRICT pDest,
             / CSAMPLE_GAIN(numSamples / 2);
     if (gain_delta) {
         const CSAMPLE_GAIN start_gain = old_gain + gain_delta;
-        // note: LOOP VECTORIZED.
-        for (int i = 0; i < numSamples / 2; ++i) {
-            const CSAMPLE_GAIN gain = start_gain + gain_delta * i;
-            pDest[i * 2] += pSrc[i * 2] * gain;
-            pDest[i * 2 + 1] += pSrc[i * 2 + 1] * gain;
-        }
+        s_pKernels->addWithRampingGain(pDest, pSrc, start_gain, gain_delta, numSamples);
     } else {
-        // note: LOOP VECTORIZED.
-        for (int i = 0; i < numSamples; ++i) {
-            pDest[i] += pSrc[i] * old_gain;
-        }
+        s_pKernels->addWithGain(pDest, pSrc, old_gain, numSamples);
     }
 }
 
@@ -270,10 +332,7 @@ void SampleUtil::add2WithGain(CSAMPLE* M_RESTRICT pDest,
         return addWithGain(pDest, pSrc1, gain1, numSamples);
     }
 
-    // note: LOOP VECTORIZED.
-    for (int i = 0; i < numSamples; ++i) {
-        pDest[i] += pSrc1[i] * gain1 + pSrc2[i] * gain2;
-    }
+    s_pKernels->add2WithGain(pDest, pSrc1, gain1, pSrc2, gain2, numSamples);
 }
 
 // static
@@ -290,10 +349,23 @@ void SampleUtil::add3WithGain(CSAMPLE* pDest,
         return add2WithGain(pDest, pSrc1, gain1, pSrc2, gain2, numSamples);
     }
 
-    // note: LOOP VECTORIZED.
-    for (SINT i = 0; i < numSamples; ++i) {
-        pDest[i] += pSrc1[i] * gain1 + pSrc2[i] * gain2 + pSrc3[i] * gain3;
+    s_pKernels->add3WithGain(pDest, pSrc1, gain1, pSrc2, gain2,
+            pSrc3, gain3, numSamples);
+}
+
+// static
+void SampleUtil::mixBuffers(CSAMPLE* M_RESTRICT pDest,
+        const CSAMPLE* const* pSrcs,
+        int numSrcs, SINT numSamples) {
+    if (numSrcs <= 0) {
+        clear(pDest, numSamples);
+        return;
+    } else if (numSrcs == 1) {
+        copy(pDest, pSrcs[0], numSamples);
+        return;
     }
+
+    s_pKernels->mixBuffers(pDest, pSrcs, numSrcs, numSamples);
 }
 
 // static
@@ -309,14 +381,7 @@ void SampleUtil::copyWithGain(CSAMPLE* M_RESTRICT pDest,
         return;
     }
 
-    // note: LOOP VECTORIZED.
-    for (SINT i = 0; i < numSamples; ++i) {
-        pDest[i] = pSrc[i] * gain;
-    }
-
-    // OR! need to test which fares better
-    // copy(pDest, pSrc, iNumSamples);
-    // applyGain(pDest, gain);
+    s_pKernels->copyWithGain(pDest, pSrc, gain, numSamples);
 }
 
 // static
@@ -338,22 +403,10 @@ void SampleUtil::copyWithRampingGain(CSAMPLE* M_RESTRICT pDest,
             / CSAMPLE_GAIN(numSamples / 2);
     if (gain_delta) {
         const CSAMPLE_GAIN start_gain = old_gain + gain_delta;
-        // note: LOOP VECTORIZED only with "int i"
-        for (int i = 0; i < numSamples / 2; ++i) {
-            const CSAMPLE_GAIN gain = start_gain + gain_delta * i;
-            pDest[i * 2] = pSrc[i * 2] * gain;
-            pDest[i * 2 + 1] = pSrc[i * 2 + 1] * gain;
-        }
+        s_pKernels->copyWithRampingGain(pDest, pSrc, start_gain, gain_delta, numSamples);
     } else {
-        // note: LOOP VECTORIZED.
-        for (SINT i = 0; i < numSamples; ++i) {
-            pDest[i] = pSrc[i] * old_gain;
-        }
+        s_pKernels->copyWithGain(pDest, pSrc, old_gain, numSamples);
     }
-
-    // OR! need to test which fares better
-    // copy(pDest, pSrc, iNumSamples);
-    // applyRampingGain(pDest, gain);
 }
 
 // static
@@ -363,45 +416,24 @@ void SampleUtil::convertS16ToFloat32(CSAMPLE* M_RESTRICT pDest,
     // is the highest valid sample. Note that this means that although some
     // sample values convert to -1.0, none will convert to +1.0.
     DEBUG_ASSERT(-SAMPLE_MIN >= SAMPLE_MAX);
-    const CSAMPLE kConversionFactor = -SAMPLE_MIN;
-    // note: LOOP VECTORIZED.
-    for (SINT i = 0; i < numSamples; ++i) {
-        pDest[i] = CSAMPLE(pSrc[i]) / kConversionFactor;
-    }
+    s_pKernels->convertS16ToFloat32(pDest, pSrc, numSamples);
 }
 
 //static
 void SampleUtil::convertFloat32ToS16(SAMPLE* pDest, const CSAMPLE* pSrc,
         SINT numSamples) {
     DEBUG_ASSERT(-SAMPLE_MIN >= SAMPLE_MAX);
-    const CSAMPLE kConversionFactor = -SAMPLE_MIN;
-    // note: LOOP VECTORIZED only with "int i"
-    for (int i = 0; i < numSamples; ++i) {
-        pDest[i] = SAMPLE(pSrc[i] * kConversionFactor);
-    }
+    s_pKernels->convertFloat32ToS16(pDest, pSrc, numSamples);
 }
 
 // static
 SampleUtil::CLIP_STATUS SampleUtil::sumAbsPerChannel(CSAMPLE* pfAbsL,
         CSAMPLE* pfAbsR, const CSAMPLE* pBuffer, SINT numSamples) {
-    CSAMPLE fAbsL = CSAMPLE_ZERO;
-    CSAMPLE fAbsR = CSAMPLE_ZERO;
-    CSAMPLE clippedL = 0;
-    CSAMPLE clippedR = 0;
-
-    // note: LOOP VECTORIZED.
-    for (SINT i = 0; i < numSamples / 2; ++i) {
-        CSAMPLE absl = fabs(pBuffer[i * 2]);
-        fAbsL += absl;
-        clippedL += absl > CSAMPLE_PEAK ? 1 : 0;
-        CSAMPLE absr = fabs(pBuffer[i * 2 + 1]);
-        fAbsR += absr;
-        // Replacing the code with a bool clipped will prevent vetorizing
-        clippedR += absr > CSAMPLE_PEAK ? 1 : 0;
-    }
-
-    *pfAbsL = fAbsL;
-    *pfAbsR = fAbsR;
+    CSAMPLE clippedL;
+    CSAMPLE clippedR;
+    s_pKernels->sumAbsPerChannel(pfAbsL, pfAbsR, &clippedL, &clippedR,
+            pBuffer, numSamples);
+
     SampleUtil::CLIP_STATUS clipping = SampleUtil::NO_CLIPPING;
     if (clippedL > 0) {
         clipping |= SampleUtil::CLIPPING_LEFT;
@@ -415,10 +447,7 @@ SampleUtil::CLIP_STATUS SampleUtil::sumAbsPerChannel(CSAMPLE* pfAbsL,
 // static
 void SampleUtil::copyClampBuffer(CSAMPLE* M_RESTRICT pDest,
         const CSAMPLE* M_RESTRICT pSrc, SINT iNumSamples) {
-    // note: LOOP VECTORIZED.
-    for (SINT i = 0; i < iNumSamples; ++i) {
-        pDest[i] = clampSample(pSrc[i]);
-    }
+    s_pKernels->copyClampBuffer(pDest, pSrc, iNumSamples);
 }
 
 // static
@@ -426,11 +455,7 @@ void SampleUtil::interleaveBuffer(CSAMPLE* M_RESTRICT pDest,
         const CSAMPLE* M_RESTRICT pSrc1,
         const CSAMPLE* M_RESTRICT pSrc2,
         SINT numFrames) {
-    // note: LOOP VECTORIZED.
-    for (SINT i = 0; i < numFrames; ++i) {
-        pDest[2 * i] = pSrc1[i];
-        pDest[2 * i + 1] = pSrc2[i];
-    }
+    s_pKernels->interleaveBuffer(pDest, pSrc1, pSrc2, numFrames);
 }
 
 // static
@@ -438,11 +463,7 @@ void SampleUtil::deinterleaveBuffer(CSAMPLE* M_RESTRICT pDest1,
         CSAMPLE* M_RESTRICT pDest2,
         const CSAMPLE* M_RESTRICT pSrc,
         SINT numFrames) {
-    // note: LOOP VECTORIZED.
-    for (SINT i = 0; i < numFrames; ++i) {
-        pDest1[i] = pSrc[i * 2];
-        pDest2[i] = pSrc[i * 2 + 1];
-    }
+    s_pKernels->deinterleaveBuffer(pDest1, pDest2, pSrc, numFrames);
 }
 
 // static
@@ -450,17 +471,7 @@ void SampleUtil::linearCrossfadeBuffersOut(
         CSAMPLE* pDestSrcFadeOut,
         const CSAMPLE* pSrcFadeIn,
         SINT numSamples) {
-    // M_RESTRICT unoptimizes the function for some reason.
-    const CSAMPLE_GAIN cross_inc = CSAMPLE_GAIN_ONE
-            / CSAMPLE_GAIN(numSamples / 2);
-    // note: LOOP VECTORIZED. only with "int i"
-    for (int i = 0; i < numSamples / 2; ++i) {
-        const CSAMPLE_GAIN cross_mix = cross_inc * i;
-        pDestSrcFadeOut[i * 2] *= (CSAMPLE_GAIN_ONE - cross_mix);
-        pDestSrcFadeOut[i * 2] += pSrcFadeIn[i * 2] * cross_mix;
-        pDestSrcFadeOut[i * 2 + 1] *= (CSAMPLE_GAIN_ONE - cross_mix);
-        pDestSrcFadeOut[i * 2 + 1] += pSrcFadeIn[i * 2 + 1] * cross_mix;
-    }
+    s_pKernels->linearCrossfadeBuffersOut(pDestSrcFadeOut, pSrcFadeIn, numSamples);
 }
 
 // static
@@ -468,28 +479,13 @@ void SampleUtil::linearCrossfadeBuffersIn(
         CSAMPLE* pDestSrcFadeIn,
         const CSAMPLE* pSrcFadeOut,
         SINT numSamples) {
-    // M_RESTRICT unoptimizes the function for some reason.
-    const CSAMPLE_GAIN cross_inc = CSAMPLE_GAIN_ONE / CSAMPLE_GAIN(numSamples / 2);
-    // note: LOOP VECTORIZED. only with "int i"
-    for (int i = 0; i < numSamples / 2; ++i) {
-        const CSAMPLE_GAIN cross_mix = cross_inc * i;
-        pDestSrcFadeIn[i * 2] *= cross_mix;
-        pDestSrcFadeIn[i * 2] += pSrcFadeOut[i * 2] * (CSAMPLE_GAIN_ONE - cross_mix);
-        pDestSrcFadeIn[i * 2 + 1] *= cross_mix;
-        pDestSrcFadeIn[i * 2 + 1] += pSrcFadeOut[i * 2 + 1] * (CSAMPLE_GAIN_ONE - cross_mix);
-    }
+    s_pKernels->linearCrossfadeBuffersIn(pDestSrcFadeIn, pSrcFadeOut, numSamples);
 }
 
 // static
 void SampleUtil::mixStereoToMono(CSAMPLE* pDest, const CSAMPLE* pSrc,
         SINT numSamples) {
-    const CSAMPLE_GAIN mixScale = CSAMPLE_GAIN_ONE
-            / (CSAMPLE_GAIN_ONE + CSAMPLE_GAIN_ONE);
-    // note: LOOP VECTORIZED
-    for (SINT i = 0; i < numSamples / 2; ++i) {
-        pDest[i * 2] = (pSrc[i * 2] + pSrc[i * 2 + 1]) * mixScale;
-        pDest[i * 2 + 1] = pDest[i * 2];
-    }
+    s_pKernels->mixStereoToMono(pDest, pSrc, numSamples);
 }
 
 // static
@@ -507,25 +503,13 @@ void SampleUtil::doubleMonoToDualMono(CSAMPLE* pBuffer, SINT numFrames) {
 // static
 void SampleUtil::copyMonoToDualMono(CSAMPLE* M_RESTRICT pDest,
         const CSAMPLE* M_RESTRICT pSrc, SINT numFrames) {
-    // forward loop
-    // note: LOOP VECTORIZED
-    for (SINT i = 0; i < numFrames; ++i) {
-        const CSAMPLE s = pSrc[i];
-        pDest[i * 2] = s;
-        pDest[i * 2 + 1] = s;
-    }
+    s_pKernels->copyMonoToDualMono(pDest, pSrc, numFrames);
 }
 
 // static
 void SampleUtil::addMonoToStereo(CSAMPLE* M_RESTRICT pDest,
         const CSAMPLE* M_RESTRICT pSrc, SINT numFrames) {
-    // forward loop
-    // note: LOOP VECTORIZED
-    for (SINT i = 0; i < numFrames; ++i) {
-        const CSAMPLE s = pSrc[i];
-        pDest[i * 2] += s;
-        pDest[i * 2 + 1] += s;
-    }
+    s_pKernels->addMonoToStereo(pDest, pSrc, numFrames);
 }
 
 // static
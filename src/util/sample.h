@@ -3,6 +3,7 @@
 
 #include <algorithm>
 #include <cstring> // memset
+#include <vector>
 
 #include <QFlags>
 
@@ -26,6 +27,26 @@ class SampleUtil {
     // This is some legacy, we cannot easily revert.
     static constexpr double kPlayPositionChannels = 2.0;
 
+    // The vectorized kernels are compiled for multiple instruction sets.
+    // The best one that is supported by the CPU is selected at startup.
+    // Baseline is the instruction set of the build, i.e. SSE2 on x86
+    // or NEON on ARM.
+    enum class InstructionSet {
+        Baseline,
+        Avx2,
+        Avx512,
+    };
+
+    static InstructionSet instructionSet();
+    static const char* instructionSetName(InstructionSet instructionSet);
+
+    // All instruction sets that are supported by both the build and the CPU
+    static std::vector<InstructionSet> supportedInstructionSets();
+
+    // Only intended for tests and benchmarks, NOT thread-safe! Returns false
+    // if the instruction set is not supported.
+    static bool setInstructionSet(InstructionSet instructionSet);
+
     // Allocated a buffer of CSAMPLE's with length size. Ensures that the buffer
     // is 16-byte aligned for SSE enhancement.
     static CSAMPLE* alloc(SINT size);
@@ -185,6 +206,13 @@ class SampleUtil {
             CSAMPLE_GAIN gain1, const CSAMPLE* pSrc2, CSAMPLE_GAIN gain2,
             const CSAMPLE* pSrc3, CSAMPLE_GAIN gain3, SINT numSamples);
 
+    // Overwrite pDest with the sum of the numSrcs buffers in pSrcs. Works for
+    // any number of sources by accumulating a small block of samples in
+    // registers over all sources before writing it back. If numSrcs is 0
+    // pDest is cleared. pDest must not be an alias of any source buffer.
+    static void mixBuffers(CSAMPLE* pDest, const CSAMPLE* const* pSrcs,
+            int numSrcs, SINT numSamples);
+
     // Convert and normalize a buffer of SAMPLEs in the range [-SAMPLE_MAX, SAMPLE_MAX]
     // to a buffer of CSAMPLEs in the range [-1.0, 1.0].
     static void convertS16ToFloat32(CSAMPLE* pDest, const SAMPLE* pSrc,
@@ -0,0 +1,11 @@
+// This file is compiled with AVX2 enabled if supported by the compiler.
+// The kernels are only used if the CPU supports AVX2, see SampleUtil.
+#include "util/sample_kernels.h"
+
+const SampleUtilKernels* sampleUtilKernelsAvx2() {
+#ifdef __AVX2__
+    return &kSampleUtilKernels;
+#else
+    return nullptr;
+#endif
+}
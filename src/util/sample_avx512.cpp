@@ -0,0 +1,11 @@
+// This file is compiled with AVX-512 enabled if supported by the compiler.
+// The kernels are only used if the CPU supports AVX-512, see SampleUtil.
+#include "util/sample_kernels.h"
+
+const SampleUtilKernels* sampleUtilKernelsAvx512() {
+#ifdef __AVX512F__
+    return &kSampleUtilKernels;
+#else
+    return nullptr;
+#endif
+}
@@ -0,0 +1,395 @@
+#pragma once
+
+#include "util/types.h"
+#include "util/platform.h"
+
+// The vectorizable inner loops of SampleUtil. This header is compiled
+// multiple times for different instruction sets, once in sample.cpp for
+// the baseline of the build (SSE2 on x86, NEON on ARM) and once in each
+// sample_<isa>.cpp file. SampleUtil dispatches to the best set of kernels
+// that is supported by the CPU at runtime.
+//
+// NOTE: All kernels must have internal linkage and must not call any
+// inline functions with external linkage, e.g. math_clamp() or std::fabs().
+// Otherwise the linker might pick a copy of these functions that has been
+// compiled for an instruction set that is not supported by the CPU!
+
+// Function table with one entry per kernel
+struct SampleUtilKernels {
+    void (*applyGain)(CSAMPLE* pBuffer, CSAMPLE_GAIN gain,
+            SINT numSamples);
+    void (*applyRampingGain)(CSAMPLE* pBuffer, CSAMPLE_GAIN start_gain,
+            CSAMPLE_GAIN gain_delta, SINT numSamples);
+    void (*applyAlternatingGain)(CSAMPLE* pBuffer, CSAMPLE_GAIN gain1,
+            CSAMPLE_GAIN gain2, SINT numSamples);
+    void (*copyWithGain)(CSAMPLE* pDest, const CSAMPLE* pSrc,
+            CSAMPLE_GAIN gain, SINT numSamples);
+    void (*copyWithRampingGain)(CSAMPLE* pDest, const CSAMPLE* pSrc,
+            CSAMPLE_GAIN start_gain, CSAMPLE_GAIN gain_delta, SINT numSamples);
+    void (*add)(CSAMPLE* pDest, const CSAMPLE* pSrc, SINT numSamples);
+    void (*addWithGain)(CSAMPLE* pDest, const CSAMPLE* pSrc,
+            CSAMPLE_GAIN gain, SINT numSamples);
+    void (*addWithRampingGain)(CSAMPLE* pDest, const CSAMPLE* pSrc,
+            CSAMPLE_GAIN start_gain, CSAMPLE_GAIN gain_delta, SINT numSamples);
+    void (*add2WithGain)(CSAMPLE* pDest,
+            const CSAMPLE* pSrc1, CSAMPLE_GAIN gain1,
+            const CSAMPLE* pSrc2, CSAMPLE_GAIN gain2,
+            SINT numSamples);
+    void (*add3WithGain)(CSAMPLE* pDest,
+            const CSAMPLE* pSrc1, CSAMPLE_GAIN gain1,
+            const CSAMPLE* pSrc2, CSAMPLE_GAIN gain2,
+            const CSAMPLE* pSrc3, CSAMPLE_GAIN gain3,
+            SINT numSamples);
+    void (*mixBuffers)(CSAMPLE* pDest, const CSAMPLE* const* pSrcs,
+            int numSrcs, SINT numSamples);
+    void (*convertS16ToFloat32)(CSAMPLE* pDest, const SAMPLE* pSrc,
+            SINT numSamples);
+    void (*convertFloat32ToS16)(SAMPLE* pDest, const CSAMPLE* pSrc,
+            SINT numSamples);
+    void (*sumAbsPerChannel)(CSAMPLE* pfAbsL, CSAMPLE* pfAbsR,
+            CSAMPLE* pClippedL, CSAMPLE* pClippedR,
+            const CSAMPLE* pBuffer, SINT numSamples);
+    void (*copyClampBuffer)(CSAMPLE* pDest, const CSAMPLE* pSrc,
+            SINT numSamples);
+    void (*interleaveBuffer)(CSAMPLE* pDest, const CSAMPLE* pSrc1,
+            const CSAMPLE* pSrc2, SINT numFrames);
+    void (*deinterleaveBuffer)(CSAMPLE* pDest1, CSAMPLE* pDest2,
+            const CSAMPLE* pSrc, SINT numFrames);
+    void (*linearCrossfadeBuffersOut)(CSAMPLE* pDestSrcFadeOut,
+            const CSAMPLE* pSrcFadeIn, SINT numSamples);
+    void (*linearCrossfadeBuffersIn)(CSAMPLE* pDestSrcFadeIn,
+            const CSAMPLE* pSrcFadeOut, SINT numSamples);
+    void (*mixStereoToMono)(CSAMPLE* pDest, const CSAMPLE* pSrc,
+            SINT numSamples);
+    void (*copyMonoToDualMono)(CSAMPLE* pDest, const CSAMPLE* pSrc,
+            SINT numFrames);
+    void (*addMonoToStereo)(CSAMPLE* pDest, const CSAMPLE* pSrc,
+            SINT numFrames);
+};
+
+// Return nullptr if the corresponding source file has not been
+// compiled for this instruction set, e.g. on other architectures
+const SampleUtilKernels* sampleUtilKernelsAvx2();
+const SampleUtilKernels* sampleUtilKernelsAvx512();
+
+namespace {
+
+namespace kernels {
+
+void applyGain(CSAMPLE* pBuffer, CSAMPLE_GAIN gain,
+        SINT numSamples) {
+    // note: LOOP VECTORIZED.
+    for (SINT i = 0; i < numSamples; ++i) {
+        pBuffer[i] *= gain;
+    }
+}
+
+void applyRampingGain(CSAMPLE* pBuffer, CSAMPLE_GAIN start_gain,
+        CSAMPLE_GAIN gain_delta, SINT numSamples) {
+    // note: LOOP VECTORIZED.
+    for (int i = 0; i < numSamples / 2; ++i) {
+        const CSAMPLE_GAIN gain = start_gain + gain_delta * i;
+        // a loop counter i += 2 prevents vectorizing.
+        pBuffer[i * 2] *= gain;
+        pBuffer[i * 2 + 1] *= gain;
+    }
+}
+
+void applyAlternatingGain(CSAMPLE* pBuffer, CSAMPLE_GAIN gain1,
+        CSAMPLE_GAIN gain2, SINT numSamples) {
+    // note: LOOP VECTORIZED.
+    for (SINT i = 0; i < numSamples / 2; ++i) {
+        pBuffer[i * 2] *= gain1;
+        pBuffer[i * 2 + 1] *= gain2;
+    }
+}
+
+void copyWithGain(CSAMPLE* M_RESTRICT pDest,
+        const CSAMPLE* M_RESTRICT pSrc,
+        CSAMPLE_GAIN gain, SINT numSamples) {
+    // note: LOOP VECTORIZED.
+    for (SINT i = 0; i < numSamples; ++i) {
+        pDest[i] = pSrc[i] * gain;
+    }
+}
+
+void copyWithRampingGain(CSAMPLE* M_RESTRICT pDest,
+        const CSAMPLE* M_RESTRICT pSrc,
+        CSAMPLE_GAIN start_gain, CSAMPLE_GAIN gain_delta,
+        SINT numSamples) {
+    // note: LOOP VECTORIZED only with "int i"
+    for (int i = 0; i < numSamples / 2; ++i) {
+        const CSAMPLE_GAIN gain = start_gain + gain_delta * i;
+        pDest[i * 2] = pSrc[i * 2] * gain;
+        pDest[i * 2 + 1] = pSrc[i * 2 + 1] * gain;
+    }
+}
+
+void add(CSAMPLE* M_RESTRICT pDest,
+        const CSAMPLE* M_RESTRICT pSrc,
+        SINT numSamples) {
+    // note: LOOP VECTORIZED.
+    for (SINT i = 0; i < numSamples; ++i) {
+        pDest[i] += pSrc[i];
+    }
+}
+
+void addWithGain(CSAMPLE* M_RESTRICT pDest,
+        const CSAMPLE* M_RESTRICT pSrc,
+        CSAMPLE_GAIN gain, SINT numSamples) {
+    // note: LOOP VECTORIZED.
+    for (SINT i = 0; i < numSamples; ++i) {
+        pDest[i] += pSrc[i] * gain;
+    }
+}
+
+void addWithRampingGain(CSAMPLE* M_RESTRICT pDest,
+        const CSAMPLE* M_RESTRICT pSrc,
+        CSAMPLE_GAIN start_gain, CSAMPLE_GAIN gain_delta,
+        SINT numSamples) {
+    // note: LOOP VECTORIZED.
+    for (int i = 0; i < numSamples / 2; ++i) {
+        const CSAMPLE_GAIN gain = start_gain + gain_delta * i;
+        pDest[i * 2] += pSrc[i * 2] * gain;
+        pDest[i * 2 + 1] += pSrc[i * 2 + 1] * gain;
+    }
+}
+
+void add2WithGain(CSAMPLE* M_RESTRICT pDest,
+        const CSAMPLE* M_RESTRICT pSrc1, CSAMPLE_GAIN gain1,
+        const CSAMPLE* M_RESTRICT pSrc2, CSAMPLE_GAIN gain2,
+        SINT numSamples) {
+    // note: LOOP VECTORIZED.
+    for (SINT i = 0; i < numSamples; ++i) {
+        pDest[i] += pSrc1[i] * gain1 + pSrc2[i] * gain2;
+    }
+}
+
+void add3WithGain(CSAMPLE* pDest,
+        const CSAMPLE* M_RESTRICT pSrc1, CSAMPLE_GAIN gain1,
+        const CSAMPLE* M_RESTRICT pSrc2, CSAMPLE_GAIN gain2,
+        const CSAMPLE* M_RESTRICT pSrc3, CSAMPLE_GAIN gain3,
+        SINT numSamples) {
+    // note: LOOP VECTORIZED.
+    for (SINT i = 0; i < numSamples; ++i) {
+        pDest[i] += pSrc1[i] * gain1 + pSrc2[i] * gain2 + pSrc3[i] * gain3;
+    }
+}
+
+void mixBuffers(CSAMPLE* M_RESTRICT pDest,
+        const CSAMPLE* const* pSrcs,
+        int numSrcs, SINT numSamples) {
+    // The block is small enough to stay in the vector registers (or at least
+    // in L1 cache) while all sources are added up. This way pDest is written
+    // only once, independent of the number of sources.
+    constexpr SINT kBlockSize = 64;
+    alignas(64) CSAMPLE block[kBlockSize];
+
+    SINT offset = 0;
+    for (; offset + kBlockSize <= numSamples; offset += kBlockSize) {
+        const CSAMPLE* M_RESTRICT pSrc0 = pSrcs[0] + offset;
+        // note: LOOP VECTORIZED.
+        for (SINT i = 0; i < kBlockSize; ++i) {
+            block[i] = pSrc0[i];
+        }
+        for (int j = 1; j < numSrcs; ++j) {
+            const CSAMPLE* M_RESTRICT pSrc = pSrcs[j] + offset;
+            // note: LOOP VECTORIZED.
+            for (SINT i = 0; i < kBlockSize; ++i) {
+                block[i] += pSrc[i];
+            }
+        }
+        CSAMPLE* M_RESTRICT pOut = pDest + offset;
+        // note: LOOP VECTORIZED.
+        for (SINT i = 0; i < kBlockSize; ++i) {
+            pOut[i] = block[i];
+        }
+    }
+
+    // Remaining samples of an incomplete block
+    CSAMPLE* M_RESTRICT pOut = pDest + offset;
+    const SINT remaining = numSamples - offset;
+    const CSAMPLE* M_RESTRICT pSrc0 = pSrcs[0] + offset;
+    for (SINT i = 0; i < remaining; ++i) {
+        pOut[i] = pSrc0[i];
+    }
+    for (int j = 1; j < numSrcs; ++j) {
+        const CSAMPLE* M_RESTRICT pSrc = pSrcs[j] + offset;
+        for (SINT i = 0; i < remaining; ++i) {
+            pOut[i] += pSrc[i];
+        }
+    }
+}
+
+void convertS16ToFloat32(CSAMPLE* M_RESTRICT pDest,
+        const SAMPLE* M_RESTRICT pSrc, SINT numSamples) {
+    const CSAMPLE kConversionFactor = -SAMPLE_MIN;
+    // note: LOOP VECTORIZED.
+    for (SINT i = 0; i < numSamples; ++i) {
+        pDest[i] = CSAMPLE(pSrc[i]) / kConversionFactor;
+    }
+}
+
+void convertFloat32ToS16(SAMPLE* pDest, const CSAMPLE* pSrc,
+        SINT numSamples) {
+    const CSAMPLE kConversionFactor = -SAMPLE_MIN;
+    // note: LOOP VECTORIZED only with "int i"
+    for (int i = 0; i < numSamples; ++i) {
+        pDest[i] = SAMPLE(pSrc[i] * kConversionFactor);
+    }
+}
+
+void sumAbsPerChannel(CSAMPLE* pfAbsL, CSAMPLE* pfAbsR,
+        CSAMPLE* pClippedL, CSAMPLE* pClippedR,
+        const CSAMPLE* pBuffer, SINT numSamples) {
+    CSAMPLE fAbsL = CSAMPLE_ZERO;
+    CSAMPLE fAbsR = CSAMPLE_ZERO;
+    CSAMPLE clippedL = 0;
+    CSAMPLE clippedR = 0;
+
+    // note: LOOP VECTORIZED.
+    for (SINT i = 0; i < numSamples / 2; ++i) {
+        const CSAMPLE l = pBuffer[i * 2];
+        CSAMPLE absl = l < 0 ? -l : l;
+        fAbsL += absl;
+        clippedL += absl > CSAMPLE_PEAK ? 1 : 0;
+        const CSAMPLE r = pBuffer[i * 2 + 1];
+        CSAMPLE absr = r < 0 ? -r : r;
+        fAbsR += absr;
+        // Replacing the code with a bool clipped will prevent vetorizing
+        clippedR += absr > CSAMPLE_PEAK ? 1 : 0;
+    }
+
+    *pfAbsL = fAbsL;
+    *pfAbsR = fAbsR;
+    *pClippedL = clippedL;
+    *pClippedR = clippedR;
+}
+
+void copyClampBuffer(CSAMPLE* M_RESTRICT pDest,
+        const CSAMPLE* M_RESTRICT pSrc, SINT iNumSamples) {
+    // note: LOOP VECTORIZED.
+    for (SINT i = 0; i < iNumSamples; ++i) {
+        const CSAMPLE s = pSrc[i];
+        pDest[i] = s > CSAMPLE_PEAK ? CSAMPLE_PEAK :
+                (s < -CSAMPLE_PEAK ? -CSAMPLE_PEAK : s);
+    }
+}
+
+void interleaveBuffer(CSAMPLE* M_RESTRICT pDest,
+        const CSAMPLE* M_RESTRICT pSrc1,
+        const CSAMPLE* M_RESTRICT pSrc2,
+        SINT numFrames) {
+    // note: LOOP VECTORIZED.
+    for (SINT i = 0; i < numFrames; ++i) {
+        pDest[2 * i] = pSrc1[i];
+        pDest[2 * i + 1] = pSrc2[i];
+    }
+}
+
+void deinterleaveBuffer(CSAMPLE* M_RESTRICT pDest1,
+        CSAMPLE* M_RESTRICT pDest2,
+        const CSAMPLE* M_RESTRICT pSrc,
+        SINT numFrames) {
+    // note: LOOP VECTORIZED.
+    for (SINT i = 0; i < numFrames; ++i) {
+        pDest1[i] = pSrc[i * 2];
+        pDest2[i] = pSrc[i * 2 + 1];
+    }
+}
+
+void linearCrossfadeBuffersOut(
+        CSAMPLE* pDestSrcFadeOut,
+        const CSAMPLE* pSrcFadeIn,
+        SINT numSamples) {
+    // M_RESTRICT unoptimizes the function for some reason.
+    const CSAMPLE_GAIN cross_inc = CSAMPLE_GAIN_ONE
+            / CSAMPLE_GAIN(numSamples / 2);
+    // note: LOOP VECTORIZED. only with "int i"
+    for (int i = 0; i < numSamples / 2; ++i) {
+        const CSAMPLE_GAIN cross_mix = cross_inc * i;
+        pDestSrcFadeOut[i * 2] *= (CSAMPLE_GAIN_ONE - cross_mix);
+        pDestSrcFadeOut[i * 2] += pSrcFadeIn[i * 2] * cross_mix;
+        pDestSrcFadeOut[i * 2 + 1] *= (CSAMPLE_GAIN_ONE - cross_mix);
+        pDestSrcFadeOut[i * 2 + 1] += pSrcFadeIn[i * 2 + 1] * cross_mix;
+    }
+}
+
+void linearCrossfadeBuffersIn(
+        CSAMPLE* pDestSrcFadeIn,
+        const CSAMPLE* pSrcFadeOut,
+        SINT numSamples) {
+    // M_RESTRICT unoptimizes the function for some reason.
+    const CSAMPLE_GAIN cross_inc = CSAMPLE_GAIN_ONE / CSAMPLE_GAIN(numSamples / 2);
+    // note: LOOP VECTORIZED. only with "int i"
+    for (int i = 0; i < numSamples / 2; ++i) {
+        const CSAMPLE_GAIN cross_mix = cross_inc * i;
+        pDestSrcFadeIn[i * 2] *= cross_mix;
+        pDestSrcFadeIn[i * 2] += pSrcFadeOut[i * 2] * (CSAMPLE_GAIN_ONE - cross_mix);
+        pDestSrcFadeIn[i * 2 + 1] *= cross_mix;
+        pDestSrcFadeIn[i * 2 + 1] += pSrcFadeOut[i * 2 + 1] * (CSAMPLE_GAIN_ONE - cross_mix);
+    }
+}
+
+void mixStereoToMono(CSAMPLE* pDest, const CSAMPLE* pSrc,
+        SINT numSamples) {
+    const CSAMPLE_GAIN mixScale = CSAMPLE_GAIN_ONE
+            / (CSAMPLE_GAIN_ONE + CSAMPLE_GAIN_ONE);
+    // note: LOOP VECTORIZED
+    for (SINT i = 0; i < numSamples / 2; ++i) {
+        pDest[i * 2] = (pSrc[i * 2] + pSrc[i * 2 + 1]) * mixScale;
+        pDest[i * 2 + 1] = pDest[i * 2];
+    }
+}
+
+void copyMonoToDualMono(CSAMPLE* M_RESTRICT pDest,
+        const CSAMPLE* M_RESTRICT pSrc, SINT numFrames) {
+    // forward loop
+    // note: LOOP VECTORIZED
+    for (SINT i = 0; i < numFrames; ++i) {
+        const CSAMPLE s = pSrc[i];
+        pDest[i * 2] = s;
+        pDest[i * 2 + 1] = s;
+    }
+}
+
+void addMonoToStereo(CSAMPLE* M_RESTRICT pDest,
+        const CSAMPLE* M_RESTRICT pSrc, SINT numFrames) {
+    // forward loop
+    // note: LOOP VECTORIZED
+    for (SINT i = 0; i < numFrames; ++i) {
+        const CSAMPLE s = pSrc[i];
+        pDest[i * 2] += s;
+        pDest[i * 2 + 1] += s;
+    }
+}
+
+} // namespace kernels
+
+// Unused if the compiler doesn't support the instruction set
+[[maybe_unused]] const SampleUtilKernels kSampleUtilKernels = {
+        kernels::applyGain,
+        kernels::applyRampingGain,
+        kernels::applyAlternatingGain,
+        kernels::copyWithGain,
+        kernels::copyWithRampingGain,
+        kernels::add,
+        kernels::addWithGain,
+        kernels::addWithRampingGain,
+        kernels::add2WithGain,
+        kernels::add3WithGain,
+        kernels::mixBuffers,
+        kernels::convertS16ToFloat32,
+        kernels::convertFloat32ToS16,
+        kernels::sumAbsPerChannel,
+        kernels::copyClampBuffer,
+        kernels::interleaveBuffer,
+        kernels::deinterleaveBuffer,
+        kernels::linearCrossfadeBuffersOut,
+        kernels::linearCrossfadeBuffersIn,
+        kernels::mixStereoToMono,
+        kernels::copyMonoToDualMono,
+        kernels::addMonoToStereo,
+};
+
+} // anonymous namespace
@@ -22,6 +22,12 @@ class StringCollator {
         return m_collator.compare(s1, s2);
     }
 
+    // Sort keys are compared faster than strings when sorting many
+    // strings or when comparing the same strings repeatedly.
+    QCollatorSortKey sortKey(const QString& string) const {
+        return m_collator.sortKey(string);
+    }
+
   private:
     QCollator m_collator;
 };
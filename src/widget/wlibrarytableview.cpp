@@ -17,7 +17,8 @@ WLibraryTableView::WLibraryTableView(QWidget* parent,
                                      ConfigKey vScrollBarPosKey)
         : QTableView(parent),
           m_pConfig(pConfig),
-          m_vScrollBarPosKey(vScrollBarPosKey) {
+          m_vScrollBarPosKey(vScrollBarPosKey),
+          m_noSearchVScrollBarPosPending(false) {
 
     loadVScrollBarPosState();
 
@@ -68,6 +69,9 @@ void WLibraryTableView::restoreNoSearchVScrollBarPos() {
     //qDebug() << "restoreNoSearchVScrollBarPos()" << m_noSearchVScrollBarPos;
     updateGeometries();
     verticalScrollBar()->setValue(m_noSearchVScrollBarPos);
+    // The model might still be inserting the rows asynchronously
+    m_noSearchVScrollBarPosPending =
+            verticalScrollBar()->value() != m_noSearchVScrollBarPos;
 }
 
 void WLibraryTableView::saveNoSearchVScrollBarPos() {
@@ -75,6 +79,14 @@ void WLibraryTableView::saveNoSearchVScrollBarPos() {
     // a search is cleared.
     //qDebug() << "saveNoSearchVScrollBarPos()" << m_noSearchVScrollBarPos;
     m_noSearchVScrollBarPos = verticalScrollBar()->value();
+    m_noSearchVScrollBarPosPending = false;
+}
+
+void WLibraryTableView::rowsInserted(const QModelIndex& parent, int start, int end) {
+    QTableView::rowsInserted(parent, start, end);
+    if (m_noSearchVScrollBarPosPending) {
+        restoreNoSearchVScrollBarPos();
+    }
 }
 
 
@@ -51,6 +51,9 @@ class WLibraryTableView : public QTableView, public virtual LibraryView {
     void setTrackTableRowHeight(int rowHeight);
     void setSelectedClick(bool enable);
 
+  protected slots:
+    void rowsInserted(const QModelIndex& parent, int start, int end) override;
+
   protected:
     void saveNoSearchVScrollBarPos();
     void restoreNoSearchVScrollBarPos();
@@ -67,6 +70,9 @@ class WLibraryTableView : public QTableView, public virtual LibraryView {
     // The position of the vertical scrollbar slider, eg. before a search is
     // executed
     int m_noSearchVScrollBarPos;
+    // Set until the position could be restored after the rows
+    // have been inserted
+    bool m_noSearchVScrollBarPosPending;
 };
 
 